@@ -0,0 +1,472 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    boottime.c
+
+Abstract:
+
+    This module implements the boottime application, which prints the boot
+    timeline recorded by the loader and kernel as a Gantt chart.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/lib/minocaos.h>
+#include <minoca/lib/mlibc.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define BOOTTIME_VERSION_MAJOR 1
+#define BOOTTIME_VERSION_MINOR 0
+
+#define BOOTTIME_USAGE                                                         \
+    "usage: boottime [-w width]\n\n"                                           \
+    "The boottime utility prints how long each step of boot took, from the \n" \
+    "loader up to the first user mode process. Options are:\n"                 \
+    "  -w, --width=columns -- Set the width of the chart bars. The default \n" \
+    "      is 40.\n"                                                           \
+    "  --help -- Display this help text.\n"                                    \
+    "  --version -- Display the application version and exit.\n\n"
+
+#define BOOTTIME_OPTIONS_STRING "w:hV"
+
+#define BOOTTIME_DEFAULT_WIDTH 40
+#define BOOTTIME_MAX_WIDTH 200
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+INT
+BoottimePrintTimeline (
+    ULONG Width
+    );
+
+ULONGLONG
+BoottimeConvertToMicroseconds (
+    ULONGLONG Ticks,
+    ULONGLONG Frequency
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+struct option BoottimeLongOptions[] = {
+    {"width", required_argument, 0, 'w'},
+    {"help", no_argument, 0, 'h'},
+    {"version", no_argument, 0, 'V'},
+    {NULL, 0, 0, 0}
+};
+
+PSTR BoottimeEventTypeNames[] = {
+    "invalid",
+    "loader",
+    "image",
+    "kernel",
+    "driver",
+    "device",
+    "user"
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INT
+main (
+    INT ArgumentCount,
+    CHAR **Arguments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the boottime user mode program.
+
+Arguments:
+
+    ArgumentCount - Supplies the number of elements in the arguments array.
+
+    Arguments - Supplies an array of strings. The array count is bounded by the
+        previous parameter, and the strings are null-terminated.
+
+Return Value:
+
+    0 on success.
+
+    Non-zero on failure.
+
+--*/
+
+{
+
+    PSTR AfterScan;
+    ULONG ArgumentIndex;
+    INT Option;
+    INT ReturnValue;
+    LONG Width;
+
+    ReturnValue = 0;
+    Width = BOOTTIME_DEFAULT_WIDTH;
+
+    //
+    // Process the control arguments.
+    //
+
+    while (TRUE) {
+        Option = getopt_long(ArgumentCount,
+                             Arguments,
+                             BOOTTIME_OPTIONS_STRING,
+                             BoottimeLongOptions,
+                             NULL);
+
+        if (Option == -1) {
+            break;
+        }
+
+        if ((Option == '?') || (Option == ':')) {
+            ReturnValue = 1;
+            goto mainEnd;
+        }
+
+        switch (Option) {
+        case 'w':
+            Width = strtol(optarg, &AfterScan, 10);
+            if ((AfterScan == optarg) || (*AfterScan != '\0') ||
+                (Width <= 0) || (Width > BOOTTIME_MAX_WIDTH)) {
+
+                fprintf(stderr, "boottime: Invalid width %s.\n", optarg);
+                ReturnValue = EINVAL;
+                goto mainEnd;
+            }
+
+            break;
+
+        case 'V':
+            printf("boottime version %d.%02d\n",
+                   BOOTTIME_VERSION_MAJOR,
+                   BOOTTIME_VERSION_MINOR);
+
+            ReturnValue = 1;
+            goto mainEnd;
+
+        case 'h':
+            printf(BOOTTIME_USAGE);
+            return 1;
+
+        default:
+
+            assert(FALSE);
+
+            ReturnValue = 1;
+            goto mainEnd;
+        }
+    }
+
+    ArgumentIndex = optind;
+    if (ArgumentIndex > ArgumentCount) {
+        ArgumentIndex = ArgumentCount;
+    }
+
+    if (ArgumentIndex < ArgumentCount) {
+        fprintf(stderr,
+                "boottime: Unexpected argument %s\n",
+                Arguments[ArgumentIndex]);
+
+        ReturnValue = 1;
+        goto mainEnd;
+    }
+
+    ReturnValue = BoottimePrintTimeline(Width);
+
+mainEnd:
+    return ReturnValue;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+INT
+BoottimePrintTimeline (
+    ULONG Width
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the boot timeline as a Gantt chart.
+
+Arguments:
+
+    Width - Supplies the number of columns to scale the chart bars to.
+
+Return Value:
+
+    0 on success.
+
+    Non-zero on failure.
+
+--*/
+
+{
+
+    CHAR Bar[BOOTTIME_MAX_WIDTH + 1];
+    ULONG BarEnd;
+    ULONG BarStart;
+    ULONG Column;
+    ULONGLONG Duration;
+    PBOOT_TIMELINE_EVENT Event;
+    ULONG EventIndex;
+    ULONGLONG Finish;
+    PBOOT_TIMELINE_INFORMATION Information;
+    ULONGLONG Offset;
+    ULONGLONG Origin;
+    INT ReturnValue;
+    UINTN Size;
+    ULONGLONG Span;
+    KSTATUS Status;
+    PSTR TypeName;
+
+    Information = NULL;
+    ReturnValue = 0;
+
+    //
+    // Ask for the timeline, growing the buffer until it fits.
+    //
+
+    Size = sizeof(BOOT_TIMELINE_INFORMATION);
+    while (TRUE) {
+        Information = malloc(Size);
+        if (Information == NULL) {
+            ReturnValue = ENOMEM;
+            goto PrintTimelineEnd;
+        }
+
+        Status = OsGetSetSystemInformation(SystemInformationKe,
+                                           KeInformationBootTimeline,
+                                           Information,
+                                           &Size,
+                                           FALSE);
+
+        if (Status != STATUS_BUFFER_TOO_SMALL) {
+            break;
+        }
+
+        free(Information);
+        Information = NULL;
+    }
+
+    if (!KSUCCESS(Status)) {
+        ReturnValue = ClConvertKstatusToErrorNumber(Status);
+        fprintf(stderr,
+                "Error: failed to get boot timeline: status %d: %s.\n",
+                Status,
+                strerror(ReturnValue));
+
+        goto PrintTimelineEnd;
+    }
+
+    if (Information->Frequency == 0) {
+        fprintf(stderr, "Error: the boot timeline was not timed.\n");
+        ReturnValue = ENOTSUP;
+        goto PrintTimelineEnd;
+    }
+
+    //
+    // Find the extent of the timed events to scale the chart against.
+    //
+
+    Origin = MAX_ULONGLONG;
+    Finish = 0;
+    for (EventIndex = 0;
+         EventIndex < Information->EventCount;
+         EventIndex += 1) {
+
+        Event = &(Information->Events[EventIndex]);
+        if ((Event->Type == BootTimelineEventInvalid) || (Event->Start == 0)) {
+            continue;
+        }
+
+        if (Event->Start < Origin) {
+            Origin = Event->Start;
+        }
+
+        if (Event->End > Finish) {
+            Finish = Event->End;
+        }
+    }
+
+    if (Origin == MAX_ULONGLONG) {
+        Origin = 0;
+    }
+
+    Span = 1;
+    if (Finish > Origin) {
+        Span = Finish - Origin;
+    }
+
+    printf("%-7s %-31s %10s %10s\n", "TYPE", "NAME", "START ms", "LENGTH ms");
+    for (EventIndex = 0;
+         EventIndex < Information->EventCount;
+         EventIndex += 1) {
+
+        Event = &(Information->Events[EventIndex]);
+        if ((Event->Type <= BootTimelineEventInvalid) ||
+            (Event->Type > BootTimelineEventUserMode)) {
+
+            continue;
+        }
+
+        Event->Name[BOOT_TIMELINE_NAME_SIZE - 1] = '\0';
+        TypeName = BoottimeEventTypeNames[Event->Type];
+        if ((Event->Start == 0) || (Event->End < Event->Start)) {
+            printf("%-7s %-31s %10s %10s\n",
+                   TypeName,
+                   Event->Name,
+                   "-",
+                   "-");
+
+            continue;
+        }
+
+        Offset = BoottimeConvertToMicroseconds(Event->Start - Origin,
+                                               Information->Frequency);
+
+        Duration = BoottimeConvertToMicroseconds(Event->End - Event->Start,
+                                                 Information->Frequency);
+
+        //
+        // Scale the event onto the chart, giving every event at least one
+        // column so short ones still show up.
+        //
+
+        BarStart = ((Event->Start - Origin) * Width) / Span;
+        BarEnd = ((Event->End - Origin) * Width) / Span;
+        if (BarStart >= Width) {
+            BarStart = Width - 1;
+        }
+
+        if (BarEnd <= BarStart) {
+            BarEnd = BarStart + 1;
+        }
+
+        if (BarEnd > Width) {
+            BarEnd = Width;
+        }
+
+        for (Column = 0; Column < Width; Column += 1) {
+            if ((Column >= BarStart) && (Column < BarEnd)) {
+                Bar[Column] = '#';
+
+            } else {
+                Bar[Column] = ' ';
+            }
+        }
+
+        Bar[Width] = '\0';
+        printf("%-7s %-31s %6I64d.%03I64d %6I64d.%03I64d |%s|\n",
+               TypeName,
+               Event->Name,
+               Offset / 1000ULL,
+               Offset % 1000ULL,
+               Duration / 1000ULL,
+               Duration % 1000ULL,
+               Bar);
+    }
+
+    Duration = BoottimeConvertToMicroseconds(Finish - Origin,
+                                             Information->Frequency);
+
+    printf("\nTotal: %I64d.%03I64d ms, %d events",
+           Duration / 1000ULL,
+           Duration % 1000ULL,
+           Information->EventCount);
+
+    if (Information->DroppedCount != 0) {
+        printf(", %d dropped", Information->DroppedCount);
+    }
+
+    printf("\n");
+
+PrintTimelineEnd:
+    if (Information != NULL) {
+        free(Information);
+    }
+
+    return ReturnValue;
+}
+
+ULONGLONG
+BoottimeConvertToMicroseconds (
+    ULONGLONG Ticks,
+    ULONGLONG Frequency
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a number of processor counter ticks to microseconds.
+
+Arguments:
+
+    Ticks - Supplies the tick count to convert.
+
+    Frequency - Supplies the frequency of the counter in Hertz.
+
+Return Value:
+
+    Returns the number of microseconds.
+
+--*/
+
+{
+
+    ULONGLONG Seconds;
+
+    //
+    // Split off the whole seconds first to avoid overflowing the multiply.
+    //
+
+    Seconds = Ticks / Frequency;
+    Ticks -= Seconds * Frequency;
+    return (Seconds * 1000000ULL) + ((Ticks * 1000000ULL) / Frequency);
+}
+
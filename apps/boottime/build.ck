@@ -0,0 +1,52 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    boottime
+
+Abstract:
+
+    This executable implements the boottime application, which prints the
+    boot timeline recorded by the loader and kernel.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+function build() {
+    sources = [
+        "boottime.c"
+    ];
+
+    dynlibs = [
+        "//apps/osbase:libminocaos"
+    ];
+
+    includes = [
+        "$//apps/libc/include"
+    ];
+
+    app = {
+        "label": "boottime",
+        "inputs": sources + dynlibs,
+        "includes": includes
+    };
+
+    entries = application(app);
+    return entries;
+}
+
+return build();
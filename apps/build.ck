@@ -42,6 +42,7 @@ function build() {
     ];
 
     apps = [
+        "//apps/boottime:boottime",
         "//apps/debug:debug",
         "//apps/efiboot:efiboot",
         "//apps/mingen:mingen",
@@ -0,0 +1,1043 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    aio.c
+
+Abstract:
+
+    This module implements POSIX asynchronous I/O on top of the kernel's
+    asynchronous I/O contexts. Each process lazily creates a single context
+    that all control blocks are submitted to.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <aio.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+HANDLE
+ClpGetAsyncIoContext (
+    VOID
+    );
+
+INT
+ClpFillOutAsyncIoRequest (
+    struct aiocb *ControlBlock,
+    ASYNC_IO_OPERATION Operation,
+    PASYNC_IO_REQUEST Request
+    );
+
+INT
+ClpSubmitAsyncIo (
+    struct aiocb *ControlBlock,
+    ASYNC_IO_OPERATION Operation
+    );
+
+INT
+ClpWaitForAsyncIo (
+    const struct aiocb *const List[],
+    INT Count,
+    BOOL WaitAll,
+    ULONG TimeoutInMilliseconds
+    );
+
+BOOL
+ClpIsAsyncIoPending (
+    const struct aiocb *ControlBlock
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the handle to the process' asynchronous I/O context.
+//
+
+HANDLE ClAsyncIoContext = INVALID_HANDLE;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+int
+aio_read (
+    struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues an asynchronous read. The read is performed at the
+    offset in the control block regardless of the file position.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block describing the
+        read. This control block and its buffer must remain valid until the
+        operation completes.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    return ClpSubmitAsyncIo(ControlBlock, AsyncIoOperationRead);
+}
+
+LIBC_API
+int
+aio_write (
+    struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues an asynchronous write. The data is written at the
+    offset in the control block regardless of the file position.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block describing the
+        write. This control block and its buffer must remain valid until the
+        operation completes.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    return ClpSubmitAsyncIo(ControlBlock, AsyncIoOperationWrite);
+}
+
+LIBC_API
+int
+aio_fsync (
+    int Operation,
+    struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues an asynchronous flush of the file descriptor in the
+    given control block.
+
+Arguments:
+
+    Operation - Supplies either O_SYNC or O_DSYNC.
+
+    ControlBlock - Supplies a pointer to the control block. Only the file
+        descriptor and signal event members are used.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    if ((Operation != O_SYNC) && (Operation != O_DSYNC)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return ClpSubmitAsyncIo(ControlBlock, AsyncIoOperationFlush);
+}
+
+LIBC_API
+int
+aio_error (
+    const struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the error status of an asynchronous operation.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block of the operation.
+
+Return Value:
+
+    0 if the operation completed successfully.
+
+    EINPROGRESS if the operation has not yet completed.
+
+    Returns the error number the operation failed with otherwise.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    Status = ControlBlock->__aio_status;
+    if (Status == ASYNC_IO_STATUS_PENDING) {
+        return EINPROGRESS;
+    }
+
+    if (KSUCCESS(Status)) {
+        return 0;
+    }
+
+    return ClConvertKstatusToErrorNumber(Status);
+}
+
+LIBC_API
+ssize_t
+aio_return (
+    struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the final result of a completed asynchronous
+    operation.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block of the operation.
+
+Return Value:
+
+    Returns the number of bytes transferred by a completed read or write, or
+    0 for a completed flush.
+
+    -1 if the operation failed or is still in progress, and errno will be set
+    to contain more information.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    Status = ControlBlock->__aio_status;
+    if (Status == ASYNC_IO_STATUS_PENDING) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    //
+    // The kernel writes the byte count before the status, so make sure the
+    // count is not read ahead of the status.
+    //
+
+    RtlMemoryBarrier();
+    return (ssize_t)(ControlBlock->__aio_bytes_completed);
+}
+
+LIBC_API
+int
+aio_suspend (
+    const struct aiocb *const List[],
+    int Count,
+    const struct timespec *Timeout
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits until at least one of the given asynchronous
+    operations has completed.
+
+Arguments:
+
+    List - Supplies an array of pointers to control blocks. NULL entries are
+        ignored.
+
+    Count - Supplies the number of elements in the array.
+
+    Timeout - Supplies an optional pointer to the relative amount of time to
+        wait. If NULL, the wait is indefinite.
+
+Return Value:
+
+    0 if at least one of the operations has completed.
+
+    -1 on failure, and errno will be set to contain more information. EAGAIN
+    is returned if the timeout expired.
+
+--*/
+
+{
+
+    INT Result;
+    ULONG TimeoutInMilliseconds;
+
+    if (Count < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Result = ClpConvertSpecificTimeoutToSystemTimeout(Timeout,
+                                                      &TimeoutInMilliseconds);
+
+    if (Result != 0) {
+        errno = Result;
+        return -1;
+    }
+
+    return ClpWaitForAsyncIo(List, Count, FALSE, TimeoutInMilliseconds);
+}
+
+LIBC_API
+int
+aio_cancel (
+    int FileDescriptor,
+    struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts to cancel outstanding asynchronous operations.
+    Operations are handed to the system as soon as they are queued, so
+    operations that have not completed cannot be canceled.
+
+Arguments:
+
+    FileDescriptor - Supplies the file descriptor whose operations should be
+        canceled.
+
+    ControlBlock - Supplies an optional pointer to a specific operation to
+        cancel. If NULL, all operations on the descriptor are considered.
+
+Return Value:
+
+    AIO_NOTCANCELED if the operation is still in progress, or if no control
+    block was supplied and any operation on the descriptor is still in
+    progress.
+
+    AIO_ALLDONE if the operation has already completed, or if no control block
+    was supplied and no operation on the descriptor is in progress.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    FILE_CONTROL_PARAMETERS_UNION Parameters;
+    KSTATUS Status;
+
+    if (FileDescriptor < 0) {
+        errno = EBADF;
+        return -1;
+    }
+
+    //
+    // The kernel counts the requests still in flight against each handle.
+    //
+
+    if (ControlBlock == NULL) {
+        Parameters.AsyncIoCount = 0;
+        Status = OsFileControl((HANDLE)(UINTN)FileDescriptor,
+                               FileControlCommandGetAsyncIoCount,
+                               &Parameters);
+
+        if (!KSUCCESS(Status)) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+            return -1;
+        }
+
+        if (Parameters.AsyncIoCount != 0) {
+            return AIO_NOTCANCELED;
+        }
+
+        return AIO_ALLDONE;
+    }
+
+    if (ControlBlock->aio_fildes != FileDescriptor) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (ClpIsAsyncIoPending(ControlBlock) != FALSE) {
+        return AIO_NOTCANCELED;
+    }
+
+    return AIO_ALLDONE;
+}
+
+LIBC_API
+int
+lio_listio (
+    int Mode,
+    struct aiocb *const List[],
+    int Count,
+    struct sigevent *Event
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues a list of asynchronous operations with a single call.
+
+Arguments:
+
+    Mode - Supplies LIO_WAIT to wait for every operation to complete before
+        returning, or LIO_NOWAIT to return once they are queued.
+
+    List - Supplies an array of pointers to control blocks. NULL entries and
+        entries whose opcode is LIO_NOP are ignored.
+
+    Count - Supplies the number of elements in the array.
+
+    Event - Supplies an optional pointer to the notification to deliver once
+        every operation in the list has completed. This is only used with
+        LIO_NOWAIT.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information. If
+    LIO_WAIT was supplied and any of the operations failed, errno is set to
+    EIO and aio_error should be used on each control block.
+
+--*/
+
+{
+
+    HANDLE Context;
+    struct aiocb *ControlBlock;
+    INT Index;
+    ASYNC_IO_OPERATION Operation;
+    INT Result;
+    PASYNC_IO_REQUEST Requests;
+    ULONG RequestCount;
+    ULONG SignalNumber;
+    UINTN SignalValue;
+    KSTATUS Status;
+    ULONG Submitted;
+
+    Requests = NULL;
+    if (((Mode != LIO_WAIT) && (Mode != LIO_NOWAIT)) ||
+        (Count < 0) ||
+        (Count > ASYNC_IO_MAX_SUBMIT)) {
+
+        errno = EINVAL;
+        return -1;
+    }
+
+    SignalNumber = 0;
+    SignalValue = 0;
+    if ((Mode == LIO_NOWAIT) && (Event != NULL)) {
+        if (Event->sigev_notify == SIGEV_SIGNAL) {
+            if ((Event->sigev_signo <= 0) || (Event->sigev_signo >= NSIG)) {
+                errno = EINVAL;
+                return -1;
+            }
+
+            SignalNumber = Event->sigev_signo;
+            SignalValue = (UINTN)(Event->sigev_value.sival_ptr);
+
+        } else if (Event->sigev_notify != SIGEV_NONE) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    Context = ClpGetAsyncIoContext();
+    if (Context == INVALID_HANDLE) {
+        return -1;
+    }
+
+    Requests = malloc(sizeof(ASYNC_IO_REQUEST) * Count);
+    if ((Requests == NULL) && (Count != 0)) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    //
+    // Validate the whole list before submitting any of it.
+    //
+
+    RequestCount = 0;
+    for (Index = 0; Index < Count; Index += 1) {
+        ControlBlock = List[Index];
+        if ((ControlBlock == NULL) ||
+            (ControlBlock->aio_lio_opcode == LIO_NOP)) {
+
+            continue;
+        }
+
+        if (ControlBlock->aio_lio_opcode == LIO_READ) {
+            Operation = AsyncIoOperationRead;
+
+        } else if (ControlBlock->aio_lio_opcode == LIO_WRITE) {
+            Operation = AsyncIoOperationWrite;
+
+        } else {
+            errno = EINVAL;
+            Result = -1;
+            goto ListIoEnd;
+        }
+
+        Result = ClpFillOutAsyncIoRequest(ControlBlock,
+                                          Operation,
+                                          &(Requests[RequestCount]));
+
+        if (Result != 0) {
+            errno = Result;
+            Result = -1;
+            goto ListIoEnd;
+        }
+
+        RequestCount += 1;
+    }
+
+    if (RequestCount == 0) {
+        Result = 0;
+        goto ListIoEnd;
+    }
+
+    //
+    // Mark every control block in flight before any of them can complete.
+    //
+
+    for (Index = 0; Index < Count; Index += 1) {
+        ControlBlock = List[Index];
+        if ((ControlBlock != NULL) &&
+            (ControlBlock->aio_lio_opcode != LIO_NOP)) {
+
+            ControlBlock->__aio_status = ASYNC_IO_STATUS_PENDING;
+            ControlBlock->__aio_bytes_completed = 0;
+        }
+    }
+
+    Status = OsSubmitAsyncIo(Context,
+                             Requests,
+                             RequestCount,
+                             SignalNumber,
+                             SignalValue,
+                             &Submitted);
+
+    //
+    // Any control blocks that did not make it into the kernel are failed
+    // with the status describing why.
+    //
+
+    if (Submitted != RequestCount) {
+        if (KSUCCESS(Status)) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        RequestCount = 0;
+        for (Index = 0; Index < Count; Index += 1) {
+            ControlBlock = List[Index];
+            if ((ControlBlock == NULL) ||
+                (ControlBlock->aio_lio_opcode == LIO_NOP)) {
+
+                continue;
+            }
+
+            if (RequestCount >= Submitted) {
+                ControlBlock->__aio_status = Status;
+            }
+
+            RequestCount += 1;
+        }
+
+        errno = EAGAIN;
+        if (Status != STATUS_INSUFFICIENT_RESOURCES) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        if (Mode == LIO_NOWAIT) {
+            Result = -1;
+            goto ListIoEnd;
+        }
+
+        //
+        // In wait mode, still wait for the submitted requests so that no
+        // buffers are in use when the caller sees the failure.
+        //
+
+        ClpWaitForAsyncIo((const struct aiocb *const *)List,
+                          Count,
+                          TRUE,
+                          SYS_WAIT_TIME_INDEFINITE);
+
+        errno = EIO;
+        Result = -1;
+        goto ListIoEnd;
+    }
+
+    Result = 0;
+    if (Mode == LIO_WAIT) {
+        Result = ClpWaitForAsyncIo((const struct aiocb *const *)List,
+                                   Count,
+                                   TRUE,
+                                   SYS_WAIT_TIME_INDEFINITE);
+
+        if (Result == 0) {
+            for (Index = 0; Index < Count; Index += 1) {
+                ControlBlock = List[Index];
+                if ((ControlBlock != NULL) &&
+                    (ControlBlock->aio_lio_opcode != LIO_NOP) &&
+                    (!KSUCCESS(ControlBlock->__aio_status))) {
+
+                    errno = EIO;
+                    Result = -1;
+                    break;
+                }
+            }
+        }
+    }
+
+ListIoEnd:
+    if (Requests != NULL) {
+        free(Requests);
+    }
+
+    return Result;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+HANDLE
+ClpGetAsyncIoContext (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the process' asynchronous I/O context, creating it
+    if this is the first use.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the context handle on success.
+
+    INVALID_HANDLE on failure, and errno will be set to contain more
+    information.
+
+--*/
+
+{
+
+    HANDLE Context;
+    HANDLE Original;
+    KSTATUS Status;
+
+    Context = ClAsyncIoContext;
+    if (Context != INVALID_HANDLE) {
+        return Context;
+    }
+
+    Status = OsCreateAsyncIoContext(SYS_OPEN_FLAG_CLOSE_ON_EXECUTE, &Context);
+    if (!KSUCCESS(Status)) {
+        errno = EAGAIN;
+        if (Status != STATUS_INSUFFICIENT_RESOURCES) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return INVALID_HANDLE;
+    }
+
+    //
+    // If another thread raced to create the context, use theirs.
+    //
+
+    Original = (HANDLE)RtlAtomicCompareExchange(
+                                            (volatile UINTN *)&ClAsyncIoContext,
+                                            (UINTN)Context,
+                                            (UINTN)INVALID_HANDLE);
+
+    if (Original != INVALID_HANDLE) {
+        OsClose(Context);
+        Context = Original;
+    }
+
+    return Context;
+}
+
+INT
+ClpFillOutAsyncIoRequest (
+    struct aiocb *ControlBlock,
+    ASYNC_IO_OPERATION Operation,
+    PASYNC_IO_REQUEST Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a control block into a kernel asynchronous I/O
+    request.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block.
+
+    Operation - Supplies the operation to perform.
+
+    Request - Supplies a pointer where the request will be returned.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    struct sigevent *Event;
+
+    //
+    // The kernel writes its result straight into the tail of the control
+    // block, so the layouts must match.
+    //
+
+    assert((offsetof(struct aiocb, __aio_bytes_completed) -
+            offsetof(struct aiocb, __aio_status)) ==
+           FIELD_OFFSET(ASYNC_IO_RESULT, BytesCompleted));
+
+    if (ControlBlock->aio_fildes < 0) {
+        return EBADF;
+    }
+
+    RtlZeroMemory(Request, sizeof(ASYNC_IO_REQUEST));
+    Request->Handle = (HANDLE)(UINTN)(ControlBlock->aio_fildes);
+    Request->Operation = Operation;
+    Request->Result = (PASYNC_IO_RESULT)&(ControlBlock->__aio_status);
+    if (Operation != AsyncIoOperationFlush) {
+        if ((ControlBlock->aio_offset < 0) ||
+            (ControlBlock->aio_nbytes > (size_t)SSIZE_MAX)) {
+
+            return EINVAL;
+        }
+
+        Request->Offset = ControlBlock->aio_offset;
+        Request->Buffer = (PVOID)(ControlBlock->aio_buf);
+        Request->Size = ControlBlock->aio_nbytes;
+    }
+
+    Event = &(ControlBlock->aio_sigevent);
+    if (Event->sigev_notify == SIGEV_SIGNAL) {
+        if ((Event->sigev_signo <= 0) || (Event->sigev_signo >= NSIG)) {
+            return EINVAL;
+        }
+
+        Request->SignalNumber = Event->sigev_signo;
+        Request->SignalValue = (UINTN)(Event->sigev_value.sival_ptr);
+
+    } else if (Event->sigev_notify != SIGEV_NONE) {
+
+        //
+        // Creating a thread to notify isn't supported.
+        //
+
+        return EINVAL;
+    }
+
+    return 0;
+}
+
+INT
+ClpSubmitAsyncIo (
+    struct aiocb *ControlBlock,
+    ASYNC_IO_OPERATION Operation
+    )
+
+/*++
+
+Routine Description:
+
+    This routine submits a single control block to the kernel.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block.
+
+    Operation - Supplies the operation to perform.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    HANDLE Context;
+    ASYNC_IO_REQUEST Request;
+    INT Result;
+    KSTATUS Status;
+    ULONG Submitted;
+
+    Result = ClpFillOutAsyncIoRequest(ControlBlock, Operation, &Request);
+    if (Result != 0) {
+        errno = Result;
+        return -1;
+    }
+
+    Context = ClpGetAsyncIoContext();
+    if (Context == INVALID_HANDLE) {
+        return -1;
+    }
+
+    ControlBlock->__aio_bytes_completed = 0;
+    ControlBlock->__aio_status = ASYNC_IO_STATUS_PENDING;
+    Status = OsSubmitAsyncIo(Context, &Request, 1, 0, 0, &Submitted);
+    if (!KSUCCESS(Status)) {
+        ControlBlock->__aio_status = Status;
+        errno = EAGAIN;
+        if (Status != STATUS_INSUFFICIENT_RESOURCES) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    assert(Submitted == 1);
+
+    return 0;
+}
+
+INT
+ClpWaitForAsyncIo (
+    const struct aiocb *const List[],
+    INT Count,
+    BOOL WaitAll,
+    ULONG TimeoutInMilliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for asynchronous operations to complete.
+
+Arguments:
+
+    List - Supplies an array of pointers to control blocks. NULL entries are
+        ignored.
+
+    Count - Supplies the number of elements in the array.
+
+    WaitAll - Supplies a boolean indicating whether to wait for all of the
+        operations (TRUE) or any one of them (FALSE).
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    HANDLE Context;
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    ULONGLONG Frequency;
+    ULONGLONG Generation;
+    INT Index;
+    BOOL Pending;
+    BOOL Satisfied;
+    KSTATUS Status;
+    ULONG WaitTime;
+
+    Context = ClpGetAsyncIoContext();
+    if (Context == INVALID_HANDLE) {
+        return -1;
+    }
+
+    EndTime = 0;
+    Frequency = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != SYS_WAIT_TIME_INDEFINITE)) {
+
+        Frequency = OsGetTimeCounterFrequency();
+        EndTime = OsGetRecentTimeCounter() +
+                  ((TimeoutInMilliseconds * Frequency) /
+                   MILLISECONDS_PER_SECOND);
+    }
+
+    WaitTime = TimeoutInMilliseconds;
+    while (TRUE) {
+
+        //
+        // Snap the generation before checking the control blocks, so that a
+        // completion after the check is guaranteed to end the wait.
+        //
+
+        Generation = 0;
+        Status = OsWaitForAsyncIo(Context, &Generation, 0);
+        if (!KSUCCESS(Status)) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+            return -1;
+        }
+
+        Satisfied = WaitAll;
+        for (Index = 0; Index < Count; Index += 1) {
+            if (List[Index] == NULL) {
+                continue;
+            }
+
+            Pending = ClpIsAsyncIoPending(List[Index]);
+            if (WaitAll != FALSE) {
+                if (Pending != FALSE) {
+                    Satisfied = FALSE;
+                    break;
+                }
+
+            } else if (Pending == FALSE) {
+                Satisfied = TRUE;
+                break;
+            }
+        }
+
+        if (Satisfied != FALSE) {
+            return 0;
+        }
+
+        if (EndTime != 0) {
+            CurrentTime = OsGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                errno = EAGAIN;
+                return -1;
+            }
+
+            WaitTime = ((EndTime - CurrentTime) * MILLISECONDS_PER_SECOND) /
+                       Frequency;
+        }
+
+        Status = OsWaitForAsyncIo(Context, &Generation, WaitTime);
+        if (Status == STATUS_TIMEOUT) {
+            errno = EAGAIN;
+            return -1;
+
+        } else if (Status == STATUS_INTERRUPTED) {
+            errno = EINTR;
+            return -1;
+
+        } else if (!KSUCCESS(Status)) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+BOOL
+ClpIsAsyncIoPending (
+    const struct aiocb *ControlBlock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether an asynchronous operation is still in
+    flight.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block.
+
+Return Value:
+
+    TRUE if the operation has not completed.
+
+    FALSE if the operation has completed.
+
+--*/
+
+{
+
+    if (ControlBlock->__aio_status == ASYNC_IO_STATUS_PENDING) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
@@ -55,6 +55,7 @@ function build() {
     ];
 
     sources = [
+        "aio.c",
         "assert.c",
         "brk.c",
         "bsearch.c",
@@ -63,8 +64,10 @@ function build() {
         "dirio.c",
         "dynlib.c",
         "env.c",
+        "epoll.c",
         "err.c",
         "errno.c",
+        "eventfd.c",
         "exec.c",
         "exit.c",
         "fileio.c",
@@ -76,6 +79,7 @@ function build() {
         "if.c",
         "inet.c",
         "init.c",
+        "inotify.c",
         "kerror.c",
         "langinfo.c",
         "line.c",
@@ -109,11 +113,13 @@ function build() {
         "scan.c",
         "scandir.c",
         "sched.c",
+        "sendfile.c",
         "setjmp.c",
         "shadow.c",
         "signals.c",
         "socket.c",
         "spawn.c",
+        "splice.c",
         "stat.c",
         "statvfs.c",
         "stream.c",
@@ -124,6 +130,7 @@ function build() {
         "system.c",
         "termios.c",
         "time.c",
+        "timerfd.c",
         "times.c",
         "tmpfile.c",
         "ucontext.c",
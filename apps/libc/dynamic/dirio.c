@@ -42,7 +42,13 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
-#define DIRECTORY_BUFFER_SIZE 4096
+//
+// Define the size of the buffer directory entries are read into. This is big
+// enough to get a good batch of entries even when each one carries its file
+// properties.
+//
+
+#define DIRECTORY_BUFFER_SIZE 16384
 
 //
 // Define the initial guess for the current working directory buffer length.
@@ -104,6 +110,19 @@ ClpDestroyDirectoryStructure (
     PDIR Directory
     );
 
+KSTATUS
+ClpReadDirectoryEntry (
+    PDIR Directory,
+    ULONG Flags,
+    PDIRECTORY_ENTRY *Entry
+    );
+
+VOID
+ClpConvertDirectoryEntry (
+    PDIRECTORY_ENTRY Entry,
+    struct dirent *Buffer
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -120,7 +139,13 @@ CHAR ClDirectoryEntryTypeConversions[IoObjectTypeCount] = {
     DT_CHR,
     DT_CHR,
     DT_REG,
-    DT_LNK
+    DT_LNK,
+    DT_UNKNOWN,
+    DT_UNKNOWN,
+    DT_UNKNOWN,
+    DT_UNKNOWN,
+    DT_UNKNOWN,
+    DT_UNKNOWN
 };
 
 //
@@ -332,10 +357,8 @@ Return Value:
 
 {
 
-    UINTN BytesRead;
     PDIRECTORY_ENTRY Entry;
     INT Error;
-    UINTN NextEntryOffset;
     KSTATUS Status;
 
     *Result = NULL;
@@ -344,92 +367,12 @@ Return Value:
         goto readdir_rEnd;
     }
 
-    //
-    // If more data needs to be read, perform the underlying read.
-    //
-
-    if (Directory->CurrentPosition + sizeof(DIRECTORY_ENTRY) >
-        Directory->ValidBufferSize) {
-
-        //
-        // If this is the end, return a null entry and success.
-        //
-
-        if (Directory->AtEnd != FALSE) {
-            Status = STATUS_SUCCESS;
-            goto readdir_rEnd;
-        }
-
-        Status = OsPerformIo((HANDLE)(UINTN)(Directory->Descriptor),
-                             IO_OFFSET_NONE,
-                             DIRECTORY_BUFFER_SIZE,
-                             0,
-                             SYS_WAIT_TIME_INDEFINITE,
-                             Directory->Buffer,
-                             &BytesRead);
-
-        if (!KSUCCESS(Status)) {
-            goto readdir_rEnd;
-        }
-
-        if (BytesRead == 0) {
-            Directory->AtEnd = TRUE;
-            goto readdir_rEnd;
-        }
-
-        Directory->ValidBufferSize = (ULONG)BytesRead;
-        Directory->CurrentPosition = 0;
-
-        //
-        // Make sure there is enough space for a new directory entry.
-        //
-
-        if (Directory->CurrentPosition + sizeof(DIRECTORY_ENTRY) >
-            Directory->ValidBufferSize) {
-
-            Status = STATUS_BUFFER_OVERRUN;
-            goto readdir_rEnd;
-        }
-    }
-
-    //
-    // Grab the next directory entry.
-    //
-
-    Entry = (PDIRECTORY_ENTRY)(Directory->Buffer + Directory->CurrentPosition);
-    NextEntryOffset = Directory->CurrentPosition + Entry->Size;
-    if (NextEntryOffset > Directory->ValidBufferSize) {
-        Status = STATUS_BUFFER_OVERRUN;
-        goto readdir_rEnd;
-    }
-
-    if (Entry->Size - sizeof(DIRECTORY_ENTRY) > NAME_MAX) {
-        Status = STATUS_BUFFER_OVERRUN;
+    Status = ClpReadDirectoryEntry(Directory, 0, &Entry);
+    if ((!KSUCCESS(Status)) || (Entry == NULL)) {
         goto readdir_rEnd;
     }
 
-    Buffer->d_ino = Entry->FileId;
-    Buffer->d_off = Entry->NextOffset;
-    Buffer->d_reclen = Entry->Size;
-
-    //
-    // Please update the array (and this assert) if a new I/O object type is
-    // added.
-    //
-
-    assert(IoObjectSymbolicLink + 1 == IoObjectTypeCount);
-
-    Buffer->d_type = ClDirectoryEntryTypeConversions[Entry->Type];
-    RtlStringCopy((PSTR)&(Buffer->d_name), (PSTR)(Entry + 1), NAME_MAX);
-
-    assert(strchr(Buffer->d_name, '/') == NULL);
-
-    //
-    // Move on to the next entry.
-    //
-
-    Directory->CurrentPosition = NextEntryOffset;
-    Status = STATUS_SUCCESS;
+    ClpConvertDirectoryEntry(Entry, Buffer);
     *Result = Buffer;
 
 readdir_rEnd:
@@ -484,6 +427,96 @@ Return Value:
     return NextEntry;
 }
 
+LIBC_API
+struct dirent *
+readdirplus (
+    DIR *Directory,
+    struct stat *Stat
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the next directory entry from the open directory
+    stream, along with the status information of the file it names. This is
+    equivalent to calling readdir followed by fstatat with the
+    AT_SYMLINK_NOFOLLOW flag, except that the information is fetched from the
+    kernel along with the names, a batch at a time. Entries that are removed
+    before their information can be gathered are skipped. This routine is not
+    part of POSIX.
+
+Arguments:
+
+    Directory - Supplies a pointer to the structure returned by the open
+        directory function.
+
+    Stat - Supplies a pointer where the status information of the entry will
+        be returned.
+
+Return Value:
+
+    Returns a pointer to the next directory entry on success.
+
+    NULL on failure or when the end of the directory is reached. On failure,
+        errno is set. If the end of the directory is reached, errno is not
+        changed.
+
+--*/
+
+{
+
+    PDIRECTORY_ENTRY Entry;
+    KSTATUS Status;
+
+    if (Directory == NULL) {
+        errno = EBADF;
+        return NULL;
+    }
+
+    while (TRUE) {
+        Status = ClpReadDirectoryEntry(Directory,
+                                       SYS_IO_FLAG_DIRECTORY_PROPERTIES,
+                                       &Entry);
+
+        if (!KSUCCESS(Status)) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+            return NULL;
+        }
+
+        if (Entry == NULL) {
+            return NULL;
+        }
+
+        ClpConvertDirectoryEntry(Entry, &(Directory->Entry));
+        if ((Entry->Type & DIRECTORY_ENTRY_TYPE_PROPERTIES) != 0) {
+            ClpConvertFilePropertiesToStat(DIRECTORY_ENTRY_PROPERTIES(Entry),
+                                           Stat);
+
+            break;
+        }
+
+        //
+        // Entries read before properties were asked for (by a previous call
+        // to readdir) come without them, so go get them the slow way.
+        //
+
+        if (fstatat(Directory->Descriptor,
+                    Directory->Entry.d_name,
+                    Stat,
+                    AT_SYMLINK_NOFOLLOW) == 0) {
+
+            break;
+        }
+
+        if (errno != ENOENT) {
+            return NULL;
+        }
+    }
+
+    return &(Directory->Entry);
+}
+
 LIBC_API
 void
 seekdir (
@@ -1056,3 +1089,179 @@ Return Value:
     return Status;
 }
 
+KSTATUS
+ClpReadDirectoryEntry (
+    PDIR Directory,
+    ULONG Flags,
+    PDIRECTORY_ENTRY *Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the next raw directory entry from the given directory
+    stream, refilling the stream's buffer from the kernel if needed.
+
+Arguments:
+
+    Directory - Supplies a pointer to the open directory stream.
+
+    Flags - Supplies the I/O flags to read with if the buffer needs refilling.
+        See SYS_IO_FLAG_* definitions.
+
+    Entry - Supplies a pointer where a pointer to the next entry will be
+        returned on success. The entry points into the directory buffer and is
+        only valid until the next read. NULL is returned at the end of the
+        directory.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN BytesRead;
+    UINTN NameSpace;
+    PDIRECTORY_ENTRY NextEntry;
+    UINTN NextEntryOffset;
+    KSTATUS Status;
+
+    *Entry = NULL;
+
+    //
+    // If more data needs to be read, perform the underlying read.
+    //
+
+    if (Directory->CurrentPosition + sizeof(DIRECTORY_ENTRY) >
+        Directory->ValidBufferSize) {
+
+        //
+        // If this is the end, return a null entry and success.
+        //
+
+        if (Directory->AtEnd != FALSE) {
+            return STATUS_SUCCESS;
+        }
+
+        Status = OsPerformIo((HANDLE)(UINTN)(Directory->Descriptor),
+                             IO_OFFSET_NONE,
+                             DIRECTORY_BUFFER_SIZE,
+                             Flags,
+                             SYS_WAIT_TIME_INDEFINITE,
+                             Directory->Buffer,
+                             &BytesRead);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        if (BytesRead == 0) {
+            Directory->AtEnd = TRUE;
+            return STATUS_SUCCESS;
+        }
+
+        Directory->ValidBufferSize = (ULONG)BytesRead;
+        Directory->CurrentPosition = 0;
+
+        //
+        // Make sure there is enough space for a new directory entry.
+        //
+
+        if (Directory->CurrentPosition + sizeof(DIRECTORY_ENTRY) >
+            Directory->ValidBufferSize) {
+
+            return STATUS_BUFFER_OVERRUN;
+        }
+    }
+
+    //
+    // Grab the next directory entry.
+    //
+
+    NextEntry = (PDIRECTORY_ENTRY)(Directory->Buffer +
+                                   Directory->CurrentPosition);
+
+    NextEntryOffset = Directory->CurrentPosition + NextEntry->Size;
+    if (NextEntryOffset > Directory->ValidBufferSize) {
+        return STATUS_BUFFER_OVERRUN;
+    }
+
+    NameSpace = NextEntry->Size - sizeof(DIRECTORY_ENTRY);
+    if ((NextEntry->Type & DIRECTORY_ENTRY_TYPE_PROPERTIES) != 0) {
+        if (NextEntry->Size <
+            sizeof(DIRECTORY_ENTRY) + DIRECTORY_ENTRY_PROPERTIES_SIZE) {
+
+            return STATUS_BUFFER_OVERRUN;
+        }
+
+        NameSpace -= DIRECTORY_ENTRY_PROPERTIES_SIZE;
+    }
+
+    if (NameSpace > NAME_MAX) {
+        return STATUS_BUFFER_OVERRUN;
+    }
+
+    //
+    // Move on to the next entry.
+    //
+
+    Directory->CurrentPosition = NextEntryOffset;
+    *Entry = NextEntry;
+    return STATUS_SUCCESS;
+}
+
+VOID
+ClpConvertDirectoryEntry (
+    PDIRECTORY_ENTRY Entry,
+    struct dirent *Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a kernel directory entry into a dirent structure.
+
+Arguments:
+
+    Entry - Supplies a pointer to the directory entry to convert.
+
+    Buffer - Supplies a pointer where the dirent will be returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Type;
+
+    Buffer->d_ino = Entry->FileId;
+    Buffer->d_off = Entry->NextOffset;
+    Buffer->d_reclen = Entry->Size;
+
+    //
+    // Please update the array (and this assert) if a new I/O object type is
+    // added.
+    //
+
+    assert(IoObjectFileWatch + 1 == IoObjectTypeCount);
+
+    Type = Entry->Type & DIRECTORY_ENTRY_TYPE_MASK;
+    Buffer->d_type = DT_UNKNOWN;
+    if (Type < IoObjectTypeCount) {
+        Buffer->d_type = ClDirectoryEntryTypeConversions[Type];
+    }
+
+    RtlStringCopy((PSTR)&(Buffer->d_name), (PSTR)(Entry + 1), NAME_MAX);
+
+    assert(strchr(Buffer->d_name, '/') == NULL);
+
+    return;
+}
+
@@ -0,0 +1,373 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    epoll.c
+
+Abstract:
+
+    This module implements the epoll event notification interface.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <sys/epoll.h>
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+#define ASSERT_EPOLL_FLAGS_EQUIVALENT() \
+    assert((EPOLLIN == POLL_EVENT_IN) && \
+           (EPOLLPRI == POLL_EVENT_IN_HIGH_PRIORITY) && \
+           (EPOLLOUT == POLL_EVENT_OUT) && \
+           (EPOLLWRBAND == POLL_EVENT_OUT_HIGH_PRIORITY) && \
+           (EPOLLERR == POLL_EVENT_ERROR) && \
+           (EPOLLHUP == POLL_EVENT_DISCONNECTED) && \
+           (EPOLLONESHOT == EVENT_POLL_FLAG_ONE_SHOT) && \
+           (EPOLLET == EVENT_POLL_FLAG_EDGE_TRIGGERED))
+
+#define ASSERT_EPOLL_STRUCTURE_EQUIVALENT() \
+    assert((sizeof(struct epoll_event) == sizeof(EVENT_POLL_EVENT)) && \
+           (offsetof(struct epoll_event, events) == \
+            offsetof(EVENT_POLL_EVENT, Events)) && \
+           (offsetof(struct epoll_event, data) == \
+            offsetof(EVENT_POLL_EVENT, Data)))
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+int
+epoll_create (
+    int Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new epoll descriptor.
+
+Arguments:
+
+    Size - Supplies a hint as to the number of descriptors that will be
+        watched. This is ignored, but must be greater than zero.
+
+Return Value:
+
+    Returns the new epoll descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    if (Size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return epoll_create1(0);
+}
+
+LIBC_API
+int
+epoll_create1 (
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new epoll descriptor.
+
+Arguments:
+
+    Flags - Supplies a bitfield of flags. The only valid flag is
+        EPOLL_CLOEXEC.
+
+Return Value:
+
+    Returns the new epoll descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    HANDLE Handle;
+    ULONG OpenFlags;
+    KSTATUS Status;
+
+    if ((Flags & ~EPOLL_CLOEXEC) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    OpenFlags = 0;
+    if ((Flags & EPOLL_CLOEXEC) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_CLOSE_ON_EXECUTE;
+    }
+
+    Status = OsCreateEventPoll(OpenFlags, &Handle);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (int)(UINTN)Handle;
+}
+
+LIBC_API
+int
+epoll_ctl (
+    int EpollDescriptor,
+    int Operation,
+    int FileDescriptor,
+    struct epoll_event *Event
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds, modifies, or removes a descriptor from the interest set
+    of an epoll descriptor.
+
+Arguments:
+
+    EpollDescriptor - Supplies the epoll descriptor.
+
+    Operation - Supplies the operation to perform. See EPOLL_CTL_*
+        definitions.
+
+    FileDescriptor - Supplies the descriptor to add, modify, or remove.
+
+    Event - Supplies a pointer to the events and data to register. This is
+        ignored for EPOLL_CTL_DEL.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    EVENT_POLL_OPERATION EventPollOperation;
+    KSTATUS Status;
+
+    ASSERT_EPOLL_FLAGS_EQUIVALENT();
+    ASSERT_EPOLL_STRUCTURE_EQUIVALENT();
+
+    switch (Operation) {
+    case EPOLL_CTL_ADD:
+        EventPollOperation = EventPollOperationAdd;
+        break;
+
+    case EPOLL_CTL_DEL:
+        EventPollOperation = EventPollOperationDelete;
+        Event = NULL;
+        break;
+
+    case EPOLL_CTL_MOD:
+        EventPollOperation = EventPollOperationModify;
+        break;
+
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((EventPollOperation != EventPollOperationDelete) && (Event == NULL)) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    Status = OsEventPollControl((HANDLE)(UINTN)EpollDescriptor,
+                                EventPollOperation,
+                                (HANDLE)(UINTN)FileDescriptor,
+                                (PEVENT_POLL_EVENT)Event);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return 0;
+}
+
+LIBC_API
+int
+epoll_wait (
+    int EpollDescriptor,
+    struct epoll_event *Events,
+    int MaxEvents,
+    int Timeout
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for descriptors in the interest set of an epoll
+    descriptor to become ready.
+
+Arguments:
+
+    EpollDescriptor - Supplies the epoll descriptor.
+
+    Events - Supplies a pointer to an array where the ready events are
+        returned.
+
+    MaxEvents - Supplies the number of elements in the events array. This must
+        be greater than zero.
+
+    Timeout - Supplies the amount of time in milliseconds to block before
+        giving up. Supply 0 to not block at all, and supply -1 to wait for an
+        indefinite amount of time.
+
+Return Value:
+
+    Returns the number of events returned on success.
+
+    Returns 0 to indicate a timeout.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    return epoll_pwait(EpollDescriptor, Events, MaxEvents, Timeout, NULL);
+}
+
+LIBC_API
+int
+epoll_pwait (
+    int EpollDescriptor,
+    struct epoll_event *Events,
+    int MaxEvents,
+    int Timeout,
+    const sigset_t *SignalMask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for descriptors in the interest set of an epoll
+    descriptor to become ready, with the given signal mask in effect for the
+    duration of the wait.
+
+Arguments:
+
+    EpollDescriptor - Supplies the epoll descriptor.
+
+    Events - Supplies a pointer to an array where the ready events are
+        returned.
+
+    MaxEvents - Supplies the number of elements in the events array. This must
+        be greater than zero.
+
+    Timeout - Supplies the amount of time in milliseconds to block before
+        giving up. Supply 0 to not block at all, and supply -1 to wait for an
+        indefinite amount of time.
+
+    SignalMask - Supplies an optional pointer to the signal mask to set for
+        the duration of the wait.
+
+Return Value:
+
+    Returns the number of events returned on success.
+
+    Returns 0 to indicate a timeout.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    ULONG EventsReturned;
+    KSTATUS Status;
+    ULONG TimeoutMilliseconds;
+
+    if (MaxEvents <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    TimeoutMilliseconds = SYS_WAIT_TIME_INDEFINITE;
+    if (Timeout >= 0) {
+        TimeoutMilliseconds = Timeout;
+    }
+
+    Status = OsEventPollWait((HANDLE)(UINTN)EpollDescriptor,
+                             (PSIGNAL_SET)SignalMask,
+                             (PEVENT_POLL_EVENT)Events,
+                             MaxEvents,
+                             TimeoutMilliseconds,
+                             &EventsReturned);
+
+    if (!KSUCCESS(Status)) {
+        if (Status == STATUS_TIMEOUT) {
+            return 0;
+        }
+
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (int)EventsReturned;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -0,0 +1,206 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    eventfd.c
+
+Abstract:
+
+    This module implements event file descriptors.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+int
+eventfd (
+    unsigned int InitialValue,
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event file descriptor. Writes of 8-byte values
+    add to the descriptor's counter, and 8-byte reads return and consume it.
+    The descriptor is readable whenever the counter is non-zero.
+
+Arguments:
+
+    InitialValue - Supplies the initial value of the counter.
+
+    Flags - Supplies a bitfield of flags. See EFD_* definitions.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    ULONG CounterFlags;
+    HANDLE Handle;
+    ULONG OpenFlags;
+    KSTATUS Status;
+
+    if ((Flags & ~(EFD_SEMAPHORE | EFD_CLOEXEC | EFD_NONBLOCK)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    CounterFlags = 0;
+    if ((Flags & EFD_SEMAPHORE) != 0) {
+        CounterFlags |= EVENT_COUNTER_FLAG_SEMAPHORE;
+    }
+
+    OpenFlags = 0;
+    if ((Flags & EFD_CLOEXEC) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_CLOSE_ON_EXECUTE;
+    }
+
+    if ((Flags & EFD_NONBLOCK) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = OsCreateEventCounter(OpenFlags,
+                                  CounterFlags,
+                                  InitialValue,
+                                  &Handle);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (int)(UINTN)Handle;
+}
+
+LIBC_API
+int
+eventfd_read (
+    int FileDescriptor,
+    eventfd_t *Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the counter from an event file descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the event file descriptor.
+
+    Value - Supplies a pointer where the counter value will be returned.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    ssize_t BytesRead;
+
+    BytesRead = read(FileDescriptor, Value, sizeof(eventfd_t));
+    if (BytesRead != sizeof(eventfd_t)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+LIBC_API
+int
+eventfd_write (
+    int FileDescriptor,
+    eventfd_t Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a value to the counter of an event file descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the event file descriptor.
+
+    Value - Supplies the value to add.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    ssize_t BytesWritten;
+
+    BytesWritten = write(FileDescriptor, &Value, sizeof(eventfd_t));
+    if (BytesWritten != sizeof(eventfd_t)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
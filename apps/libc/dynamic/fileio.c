@@ -282,6 +282,7 @@ Return Value:
     ULONG Flags;
     off_t Length;
     FILE_CONTROL_PARAMETERS_UNION Parameters;
+    int PipeSize;
     int ReturnValue;
     int SetFlags;
     struct stat Stat;
@@ -349,6 +350,10 @@ Return Value:
             Parameters.Flags |= SYS_OPEN_FLAG_ASYNCHRONOUS;
         }
 
+        if ((SetFlags & O_DIRECT) != 0) {
+            Parameters.Flags |= SYS_OPEN_FLAG_DIRECT;
+        }
+
         break;
 
     case F_GETOWN:
@@ -451,6 +456,22 @@ Return Value:
         FileControlCommand = FileControlCommandCloseFrom;
         break;
 
+    case F_GETPIPE_SZ:
+        FileControlCommand = FileControlCommandGetPipeSize;
+        Parameters.PipeSize = 0;
+        break;
+
+    case F_SETPIPE_SZ:
+        FileControlCommand = FileControlCommandSetPipeSize;
+        PipeSize = va_arg(ArgumentList, int);
+        if (PipeSize < 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto fcntlEnd;
+        }
+
+        Parameters.PipeSize = PipeSize;
+        break;
+
     default:
         Status = STATUS_INVALID_PARAMETER;
         goto fcntlEnd;
@@ -502,6 +523,11 @@ Return Value:
         ReturnValue = 0;
         break;
 
+    case F_GETPIPE_SZ:
+    case F_SETPIPE_SZ:
+        ReturnValue = (int)(Parameters.PipeSize);
+        break;
+
     case F_GETFL:
         ReturnValue = 0;
         Flags = Parameters.Flags;
@@ -561,6 +587,10 @@ Return Value:
             ReturnValue |= O_ASYNC;
         }
 
+        if ((Flags & SYS_OPEN_FLAG_DIRECT) != 0) {
+            ReturnValue |= O_DIRECT;
+        }
+
         break;
 
     case F_GETLK:
@@ -3492,6 +3522,10 @@ Return Value:
         OsOpenFlags |= SYS_OPEN_FLAG_ASYNCHRONOUS;
     }
 
+    if ((OpenFlags & O_DIRECT) != 0) {
+        OsOpenFlags |= SYS_OPEN_FLAG_DIRECT;
+    }
+
     //
     // Set other flags.
     //
@@ -0,0 +1,288 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    inotify.c
+
+Abstract:
+
+    This module implements inotify descriptors on top of kernel file watches.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define INOTIFY_FLAGS_MASK \
+    (IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK | IN_MASK_ADD | IN_ONESHOT)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+int
+inotify_init (
+    void
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new inotify descriptor.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    return inotify_init1(0);
+}
+
+LIBC_API
+int
+inotify_init1 (
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new inotify descriptor.
+
+Arguments:
+
+    Flags - Supplies a bitfield of flags. See IN_CLOEXEC and IN_NONBLOCK.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    HANDLE Handle;
+    ULONG OpenFlags;
+    KSTATUS Status;
+
+    if ((Flags & ~(IN_CLOEXEC | IN_NONBLOCK)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    OpenFlags = 0;
+    if ((Flags & IN_CLOEXEC) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_CLOSE_ON_EXECUTE;
+    }
+
+    if ((Flags & IN_NONBLOCK) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = OsCreateFileWatch(OpenFlags, &Handle);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (int)(UINTN)Handle;
+}
+
+LIBC_API
+int
+inotify_add_watch (
+    int FileDescriptor,
+    const char *Path,
+    uint32_t Mask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts watching a file or directory, or changes the events
+    reported for one already being watched by the given descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the inotify descriptor.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    Mask - Supplies the events to watch for and flags. See IN_* definitions.
+
+Return Value:
+
+    Returns the watch descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    LONG Descriptor;
+    ULONG Events;
+    ULONG Flags;
+    KSTATUS Status;
+
+    //
+    // Kernel file watch records are handed straight back to the caller, so
+    // the two layouts had better agree.
+    //
+
+    assert(sizeof(struct inotify_event) ==
+           FIELD_OFFSET(FILE_WATCH_EVENT, Name));
+
+    assert((IN_MODIFY == FILE_WATCH_EVENT_MODIFY) &&
+           (IN_DELETE_SELF == FILE_WATCH_EVENT_DELETE_SELF) &&
+           (IN_ISDIR == FILE_WATCH_EVENT_DIRECTORY));
+
+    if ((Path == NULL) ||
+        ((Mask & ~(IN_ALL_EVENTS | INOTIFY_FLAGS_MASK)) != 0)) {
+
+        errno = EINVAL;
+        return -1;
+    }
+
+    //
+    // Events the kernel never reports are quietly dropped, but there has to
+    // be something left to watch for.
+    //
+
+    Events = Mask & FILE_WATCH_EVENT_MASK;
+    if (Events == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Flags = 0;
+    if ((Mask & IN_ONLYDIR) != 0) {
+        Flags |= FILE_WATCH_FLAG_DIRECTORY_ONLY;
+    }
+
+    if ((Mask & IN_DONT_FOLLOW) != 0) {
+        Flags |= FILE_WATCH_FLAG_NO_FOLLOW;
+    }
+
+    if ((Mask & IN_MASK_ADD) != 0) {
+        Flags |= FILE_WATCH_FLAG_ADD;
+    }
+
+    if ((Mask & IN_ONESHOT) != 0) {
+        Flags |= FILE_WATCH_FLAG_ONE_SHOT;
+    }
+
+    Status = OsAddFileWatch((HANDLE)(UINTN)FileDescriptor,
+                            INVALID_HANDLE,
+                            Path,
+                            strlen(Path) + 1,
+                            Events,
+                            Flags,
+                            &Descriptor);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return Descriptor;
+}
+
+LIBC_API
+int
+inotify_rm_watch (
+    int FileDescriptor,
+    int WatchDescriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops watching a file or directory.
+
+Arguments:
+
+    FileDescriptor - Supplies the inotify descriptor.
+
+    WatchDescriptor - Supplies the watch descriptor returned when the file
+        was added.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    Status = OsRemoveFileWatch((HANDLE)(UINTN)FileDescriptor, WatchDescriptor);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
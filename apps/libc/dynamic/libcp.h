@@ -32,6 +32,7 @@ Module Name:
 #include <minoca/lib/mlibc.h>
 #include <pthread.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <wchar.h>
 
@@ -702,6 +703,31 @@ Return Value:
 
 --*/
 
+VOID
+ClpConvertFilePropertiesToStat (
+    PFILE_PROPERTIES Properties,
+    struct stat *Stat
+    );
+
+/*++
+
+Routine Description:
+
+    This routine converts file properties into a stat structure.
+
+Arguments:
+
+    Properties - Supplies a pointer to the file properties to convert.
+
+    Stat - Supplies a pointer where the stat structure information will be
+        returned.
+
+Return Value:
+
+    None.
+
+--*/
+
 VOID
 ClpSetThreadIdentityOnAllThreads (
     ULONG Fields,
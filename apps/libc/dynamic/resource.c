@@ -55,6 +55,13 @@ Module Name:
            (sizeof(RESOURCE_LIMIT) == sizeof(struct rlimit)) && \
            (sizeof(rlim_t) == sizeof(UINTN)))
 
+#define ASSERT_IO_PRIORITIES_EQUIVALENT() \
+    assert((IOPRIO_CLASS_SHIFT == IO_PRIORITY_CLASS_SHIFT) && \
+           (IOPRIO_CLASS_NONE == IO_PRIORITY_CLASS_NONE) && \
+           (IOPRIO_CLASS_RT == IO_PRIORITY_CLASS_REAL_TIME) && \
+           (IOPRIO_CLASS_BE == IO_PRIORITY_CLASS_BEST_EFFORT) && \
+           (IOPRIO_CLASS_IDLE == IO_PRIORITY_CLASS_IDLE))
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -67,6 +74,11 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+IO_PRIORITY_REQUEST
+ClpGetIoPriorityRequest (
+    int Which
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -322,6 +334,135 @@ Return Value:
     return 0;
 }
 
+LIBC_API
+int
+ioprio_get (
+    int Which,
+    int Who
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the I/O priority of a process or thread.
+
+Arguments:
+
+    Which - Supplies which kind of entity to get the I/O priority of. Valid
+        values are IOPRIO_WHO_PROCESS and the non-portable IOPRIO_WHO_THREAD.
+
+    Who - Supplies the process or thread ID to query. Supply zero to query
+        the current process or thread.
+
+Return Value:
+
+    Returns the I/O priority on success. See IOPRIO_PRIO_CLASS and
+    IOPRIO_PRIO_DATA for taking it apart. A class of IOPRIO_CLASS_NONE means
+    the entity has no I/O priority of its own.
+
+    -1 on failure, and the errno variable will be set to contain more
+    information.
+
+--*/
+
+{
+
+    PROCESS_ID Id;
+    ULONG Priority;
+    IO_PRIORITY_REQUEST Request;
+    KSTATUS Status;
+
+    ASSERT_IO_PRIORITIES_EQUIVALENT();
+
+    Request = ClpGetIoPriorityRequest(Which);
+    if (Request == IoPriorityRequestInvalid) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Id = -1;
+    if (Who != 0) {
+        Id = Who;
+    }
+
+    Status = OsSetIoPriority(Request, Id, NULL, &Priority);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return Priority;
+}
+
+LIBC_API
+int
+ioprio_set (
+    int Which,
+    int Who,
+    int Priority
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets the I/O priority of a process or thread. The I/O
+    priority decides the order in which the block devices service the
+    entity's reads and writes, including the writeback of data it dirtied.
+
+Arguments:
+
+    Which - Supplies which kind of entity to set the I/O priority of. Valid
+        values are IOPRIO_WHO_PROCESS and the non-portable IOPRIO_WHO_THREAD.
+
+    Who - Supplies the process or thread ID to set. Supply zero to set the
+        current process or thread. Threads must belong to the current process.
+
+    Priority - Supplies the new I/O priority. Use IOPRIO_PRIO_VALUE to build
+        it from a class and a level between 0 (most urgent) and 7. Setting the
+        real time class, or another process' priority, requires appropriate
+        privileges.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and the errno variable will be set to contain more
+    information.
+
+--*/
+
+{
+
+    PROCESS_ID Id;
+    ULONG NewPriority;
+    IO_PRIORITY_REQUEST Request;
+    KSTATUS Status;
+
+    ASSERT_IO_PRIORITIES_EQUIVALENT();
+
+    Request = ClpGetIoPriorityRequest(Which);
+    if (Request == IoPriorityRequestInvalid) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Id = -1;
+    if (Who != 0) {
+        Id = Who;
+    }
+
+    NewPriority = Priority;
+    Status = OsSetIoPriority(Request, Id, &NewPriority, NULL);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return 0;
+}
+
 VOID
 ClpConvertResourceUsage (
     PRESOURCE_USAGE KernelUsage,
@@ -459,3 +600,38 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+IO_PRIORITY_REQUEST
+ClpGetIoPriorityRequest (
+    int Which
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts an I/O priority "which" value into a request type.
+
+Arguments:
+
+    Which - Supplies the IOPRIO_WHO_* value to convert.
+
+Return Value:
+
+    Returns the I/O priority request type.
+
+    IoPriorityRequestInvalid if the value is not supported.
+
+--*/
+
+{
+
+    if (Which == IOPRIO_WHO_PROCESS) {
+        return IoPriorityRequestProcess;
+
+    } else if (Which == IOPRIO_WHO_THREAD) {
+        return IoPriorityRequestThread;
+    }
+
+    return IoPriorityRequestInvalid;
+}
+
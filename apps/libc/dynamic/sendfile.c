@@ -0,0 +1,260 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    sendfile.c
+
+Abstract:
+
+    This module implements support for transferring and copying data between
+    file descriptors within the kernel.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <errno.h>
+#include <limits.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+ssize_t
+sendfile (
+    int OutputDescriptor,
+    int InputDescriptor,
+    off_t *Offset,
+    size_t ByteCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one file descriptor to another within the
+    kernel, avoiding the round trip through a user mode buffer that a read and
+    write loop requires. The input descriptor must refer to a seekable file.
+
+Arguments:
+
+    OutputDescriptor - Supplies the file descriptor to write to. This is
+        commonly a socket.
+
+    InputDescriptor - Supplies the file descriptor to read from.
+
+    Offset - Supplies an optional pointer to the offset within the input file
+        to start reading from. On return, this is updated to the offset just
+        past the last byte transferred, and the input descriptor's file
+        position is left unchanged. If this is NULL, the input descriptor's
+        file position is used and updated.
+
+    ByteCount - Supplies the number of bytes to transfer.
+
+Return Value:
+
+    Returns the number of bytes transferred on success. This may be less than
+    requested, and is zero at the end of the input file.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    UINTN BytesCompleted;
+    IO_OFFSET IoOffset;
+    PIO_OFFSET IoOffsetPointer;
+    KSTATUS Status;
+
+    if (ByteCount > (size_t)SSIZE_MAX) {
+        ByteCount = (size_t)SSIZE_MAX;
+    }
+
+    IoOffsetPointer = NULL;
+    if (Offset != NULL) {
+        if (*Offset < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        IoOffset = *Offset;
+        IoOffsetPointer = &IoOffset;
+    }
+
+    Status = OsSendFile((HANDLE)(UINTN)OutputDescriptor,
+                        (HANDLE)(UINTN)InputDescriptor,
+                        IoOffsetPointer,
+                        ByteCount,
+                        SYS_WAIT_TIME_INDEFINITE,
+                        &BytesCompleted);
+
+    if (!KSUCCESS(Status)) {
+        if (Status == STATUS_TIMEOUT) {
+            errno = EAGAIN;
+
+        } else {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    if (Offset != NULL) {
+        *Offset = IoOffset;
+    }
+
+    return (ssize_t)BytesCompleted;
+}
+
+LIBC_API
+ssize_t
+copy_file_range (
+    int InputDescriptor,
+    off_t *InputOffset,
+    int OutputDescriptor,
+    off_t *OutputOffset,
+    size_t Size,
+    unsigned int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies a range of one file into another within the kernel,
+    avoiding the round trip through a user mode buffer that a read and write
+    loop requires. Both descriptors must refer to regular files. This routine
+    is not part of POSIX.
+
+Arguments:
+
+    InputDescriptor - Supplies the file descriptor to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        file to read from. On return, this is advanced past the bytes copied
+        and the descriptor's file position is left unchanged. If this is NULL,
+        the input descriptor's file position is used and updated.
+
+    OutputDescriptor - Supplies the file descriptor to write to. This must not
+        have been opened with O_APPEND.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output file to write to. On return, this is advanced past the bytes
+        copied and the descriptor's file position is left unchanged. If this
+        is NULL, the output descriptor's file position is used and updated.
+
+    Size - Supplies the number of bytes to copy.
+
+    Flags - Supplies a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+Return Value:
+
+    Returns the number of bytes copied on success. This may be less than
+    requested, and is zero at the end of the input file.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    UINTN BytesCopied;
+    IO_OFFSET InputIoOffset;
+    PIO_OFFSET InputIoOffsetPointer;
+    IO_OFFSET OutputIoOffset;
+    PIO_OFFSET OutputIoOffsetPointer;
+    KSTATUS Status;
+
+    if (Size > (size_t)SSIZE_MAX) {
+        Size = (size_t)SSIZE_MAX;
+    }
+
+    InputIoOffsetPointer = NULL;
+    if (InputOffset != NULL) {
+        if (*InputOffset < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        InputIoOffset = *InputOffset;
+        InputIoOffsetPointer = &InputIoOffset;
+    }
+
+    OutputIoOffsetPointer = NULL;
+    if (OutputOffset != NULL) {
+        if (*OutputOffset < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        OutputIoOffset = *OutputOffset;
+        OutputIoOffsetPointer = &OutputIoOffset;
+    }
+
+    Status = OsCopyFileRange((HANDLE)(UINTN)OutputDescriptor,
+                             OutputIoOffsetPointer,
+                             (HANDLE)(UINTN)InputDescriptor,
+                             InputIoOffsetPointer,
+                             Size,
+                             Flags,
+                             &BytesCopied);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    if (InputOffset != NULL) {
+        *InputOffset = InputIoOffset;
+    }
+
+    if (OutputOffset != NULL) {
+        *OutputOffset = OutputIoOffset;
+    }
+
+    return (ssize_t)BytesCopied;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
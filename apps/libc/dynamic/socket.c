@@ -129,6 +129,13 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the number of messages handed to the kernel at once by sendmmsg and
+// recvmmsg.
+//
+
+#define SOCKET_BATCH_SIZE 16
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -153,6 +160,16 @@ ClpGetPathFromSocketAddress (
     PUINTN PathSize
     );
 
+int
+ClpSocketPerformBatchIo (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags,
+    BOOL Write,
+    ULONG TimeoutInMilliseconds
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -1196,6 +1213,117 @@ Return Value:
     return (ssize_t)(Parameters.BytesCompleted);
 }
 
+LIBC_API
+int
+sendmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends several messages out of a socket with as few system
+    calls as possible.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to send data out of.
+
+    Messages - Supplies an array of messages to send. On return, the msg_len
+        member of each message sent is set to the number of bytes sent.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the transmission of the data.
+        See MSG_* definitions.
+
+Return Value:
+
+    Returns the number of messages sent on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+    An error is only returned if no messages could be sent.
+
+--*/
+
+{
+
+    return ClpSocketPerformBatchIo(Socket,
+                                   Messages,
+                                   MessageCount,
+                                   Flags,
+                                   TRUE,
+                                   SYS_WAIT_TIME_INDEFINITE);
+}
+
+LIBC_API
+int
+recvmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags,
+    struct timespec *Timeout
+    )
+
+/*++
+
+Routine Description:
+
+    This routine receives several messages from a socket with as few system
+    calls as possible.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to receive data from.
+
+    Messages - Supplies an array of initialized message structures where the
+        received messages will be returned. On return, the msg_len member of
+        each message received is set to the number of bytes received.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the reception of the data.
+        See MSG_* definitions. MSG_WAITFORONE stops waiting once the first
+        message has been received.
+
+    Timeout - Supplies an optional pointer to the maximum amount of time to
+        wait for each message. Supply NULL to wait indefinitely.
+
+Return Value:
+
+    Returns the number of messages received on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+    An error is only returned if no messages could be received.
+
+--*/
+
+{
+
+    int Result;
+    ULONG TimeoutInMilliseconds;
+
+    Result = ClpConvertSpecificTimeoutToSystemTimeout(Timeout,
+                                                      &TimeoutInMilliseconds);
+
+    if (Result != 0) {
+        errno = Result;
+        return -1;
+    }
+
+    return ClpSocketPerformBatchIo(Socket,
+                                   Messages,
+                                   MessageCount,
+                                   Flags,
+                                   FALSE,
+                                   TimeoutInMilliseconds);
+}
+
 LIBC_API
 int
 shutdown (
@@ -1992,3 +2120,222 @@ Return Value:
     return;
 }
 
+int
+ClpSocketPerformBatchIo (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags,
+    BOOL Write,
+    ULONG TimeoutInMilliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives an array of socket messages, handing them
+    to the kernel in chunks.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket.
+
+    Messages - Supplies the array of messages.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of MSG_* flags governing the I/O.
+
+    Write - Supplies a boolean indicating whether to send (TRUE) or receive
+        (FALSE) the messages.
+
+    TimeoutInMilliseconds - Supplies the amount of time to wait for each
+        message.
+
+Return Value:
+
+    Returns the number of messages completed on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+
+--*/
+
+{
+
+    NETWORK_ADDRESS Addresses[SOCKET_BATCH_SIZE];
+    ULONG BatchFlags;
+    UINTN ChunkCount;
+    UINTN Completed;
+    UINTN Index;
+    SOCKET_IO_MESSAGE IoMessages[SOCKET_BATCH_SIZE];
+    struct msghdr *Message;
+    PSOCKET_IO_PARAMETERS Parameters;
+    KSTATUS Status;
+    UINTN Total;
+    UINTN VectorIndex;
+
+    ASSERT_SOCKET_IO_FLAGS_ARE_EQUIVALENT();
+
+    if ((Messages == NULL) && (MessageCount != 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (MessageCount > INT_MAX) {
+        MessageCount = INT_MAX;
+    }
+
+    BatchFlags = 0;
+    if ((Write == FALSE) && ((Flags & MSG_WAITFORONE) != 0)) {
+        BatchFlags |= SYS_SOCKET_BATCH_FLAG_WAIT_FOR_ONE;
+    }
+
+    Flags &= ~MSG_WAITFORONE;
+    Status = STATUS_SUCCESS;
+    Total = 0;
+    while (Total < MessageCount) {
+        ChunkCount = MessageCount - Total;
+        if (ChunkCount > SOCKET_BATCH_SIZE) {
+            ChunkCount = SOCKET_BATCH_SIZE;
+        }
+
+        for (Index = 0; Index < ChunkCount; Index += 1) {
+            Message = &(Messages[Total + Index].msg_hdr);
+            Parameters = &(IoMessages[Index].Parameters);
+            Parameters->Size = 0;
+            for (VectorIndex = 0;
+                 VectorIndex < Message->msg_iovlen;
+                 VectorIndex += 1) {
+
+                Parameters->Size += Message->msg_iov[VectorIndex].iov_len;
+            }
+
+            //
+            // The byte count returned for each message is an unsigned int, so
+            // truncate the size to fit.
+            //
+
+            if (Parameters->Size > (UINTN)UINT_MAX) {
+                Parameters->Size = (UINTN)UINT_MAX;
+            }
+
+            Parameters->BytesCompleted = 0;
+            Parameters->IoFlags = 0;
+            if (Write != FALSE) {
+                Parameters->IoFlags = SYS_IO_FLAG_WRITE;
+            }
+
+            Parameters->SocketIoFlags = Flags;
+            Parameters->TimeoutInMilliseconds = TimeoutInMilliseconds;
+            Parameters->NetworkAddress = NULL;
+            Parameters->RemotePath = NULL;
+            Parameters->RemotePathSize = 0;
+            if ((Message->msg_name != NULL) && (Message->msg_namelen != 0)) {
+                if (Write != FALSE) {
+                    Status = ClConvertToNetworkAddress(
+                                               Message->msg_name,
+                                               Message->msg_namelen,
+                                               &(Addresses[Index]),
+                                               &(Parameters->RemotePath),
+                                               &(Parameters->RemotePathSize));
+
+                    if (!KSUCCESS(Status)) {
+                        Status = STATUS_INVALID_PARAMETER;
+                        break;
+                    }
+
+                } else {
+                    Addresses[Index].Domain = NetDomainInvalid;
+                    ClpGetPathFromSocketAddress(
+                                               Message->msg_name,
+                                               &(Message->msg_namelen),
+                                               &(Parameters->RemotePath),
+                                               &(Parameters->RemotePathSize));
+                }
+
+                Parameters->NetworkAddress = &(Addresses[Index]);
+            }
+
+            Parameters->ControlData = Message->msg_control;
+            Parameters->ControlDataSize = Message->msg_controllen;
+            IoMessages[Index].VectorArray = (PIO_VECTOR)(Message->msg_iov);
+            IoMessages[Index].VectorCount = Message->msg_iovlen;
+        }
+
+        //
+        // A bad address ends the chunk at the message before it.
+        //
+
+        ChunkCount = Index;
+        Completed = 0;
+        if (ChunkCount != 0) {
+            Status = OsSocketPerformBatchIo((HANDLE)(UINTN)Socket,
+                                            IoMessages,
+                                            ChunkCount,
+                                            BatchFlags,
+                                            &Completed);
+        }
+
+        for (Index = 0; Index < Completed; Index += 1) {
+            Message = &(Messages[Total + Index].msg_hdr);
+            Parameters = &(IoMessages[Index].Parameters);
+            Messages[Total + Index].msg_len =
+                                       (unsigned int)Parameters->BytesCompleted;
+
+            if (Write != FALSE) {
+                continue;
+            }
+
+            Message->msg_flags = Parameters->SocketIoFlags;
+            Message->msg_controllen = Parameters->ControlDataSize;
+            if ((Message->msg_name != NULL) && (Message->msg_namelen != 0)) {
+                Status = ClConvertFromNetworkAddress(
+                                               &(Addresses[Index]),
+                                               Message->msg_name,
+                                               &(Message->msg_namelen),
+                                               Parameters->RemotePath,
+                                               Parameters->RemotePathSize);
+
+                if (!KSUCCESS(Status)) {
+                    Message->msg_namelen = 0;
+                    Status = STATUS_SUCCESS;
+                }
+            }
+        }
+
+        Total += Completed;
+        if ((!KSUCCESS(Status)) ||
+            (Completed < ChunkCount) ||
+            (ChunkCount < SOCKET_BATCH_SIZE)) {
+
+            break;
+        }
+
+        //
+        // Once a message has arrived, waiting for one is satisfied and the
+        // remaining chunks only pick up what is already there.
+        //
+
+        if ((BatchFlags & SYS_SOCKET_BATCH_FLAG_WAIT_FOR_ONE) != 0) {
+            Flags |= MSG_DONTWAIT;
+        }
+    }
+
+    if (Total != 0) {
+        return (int)Total;
+    }
+
+    if (!KSUCCESS(Status)) {
+        if (Status == STATUS_NOT_SUPPORTED) {
+            errno = EOPNOTSUPP;
+
+        } else {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,280 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    splice.c
+
+Abstract:
+
+    This module implements support for moving data into and out of pipes
+    without copying it through user mode buffers.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+ULONG
+ClpConvertSpliceFlags (
+    unsigned int Flags
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+ssize_t
+splice (
+    int InputDescriptor,
+    off_t *InputOffset,
+    int OutputDescriptor,
+    off_t *OutputOffset,
+    size_t Size,
+    unsigned int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves data between two file descriptors, at least one of
+    which must refer to a pipe, without copying it through user mode. Pages
+    are handed between pipes and referenced from the file cache rather than
+    copied wherever possible.
+
+Arguments:
+
+    InputDescriptor - Supplies the file descriptor to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        to read from. On return, this is advanced past the bytes moved and the
+        descriptor's file position is left unchanged. This must be NULL if the
+        input is a pipe.
+
+    OutputDescriptor - Supplies the file descriptor to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output to write to. On return, this is advanced past the bytes moved
+        and the descriptor's file position is left unchanged. This must be
+        NULL if the output is a pipe.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SPLICE_F_* definitions.
+
+Return Value:
+
+    Returns the number of bytes moved on success. This may be less than
+    requested, and is zero at the end of the input.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    UINTN BytesSpliced;
+    IO_OFFSET InputIoOffset;
+    PIO_OFFSET InputIoOffsetPointer;
+    IO_OFFSET OutputIoOffset;
+    PIO_OFFSET OutputIoOffsetPointer;
+    KSTATUS Status;
+
+    if (Size > (size_t)SSIZE_MAX) {
+        Size = (size_t)SSIZE_MAX;
+    }
+
+    InputIoOffsetPointer = NULL;
+    if (InputOffset != NULL) {
+        if (*InputOffset < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        InputIoOffset = *InputOffset;
+        InputIoOffsetPointer = &InputIoOffset;
+    }
+
+    OutputIoOffsetPointer = NULL;
+    if (OutputOffset != NULL) {
+        if (*OutputOffset < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        OutputIoOffset = *OutputOffset;
+        OutputIoOffsetPointer = &OutputIoOffset;
+    }
+
+    Status = OsSplice((HANDLE)(UINTN)InputDescriptor,
+                      InputIoOffsetPointer,
+                      (HANDLE)(UINTN)OutputDescriptor,
+                      OutputIoOffsetPointer,
+                      Size,
+                      ClpConvertSpliceFlags(Flags),
+                      &BytesSpliced);
+
+    if (!KSUCCESS(Status)) {
+        if (Status == STATUS_TIMEOUT) {
+            errno = EAGAIN;
+
+        } else {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    if (InputOffset != NULL) {
+        *InputOffset = InputIoOffset;
+    }
+
+    if (OutputOffset != NULL) {
+        *OutputOffset = OutputIoOffset;
+    }
+
+    return (ssize_t)BytesSpliced;
+}
+
+LIBC_API
+ssize_t
+vmsplice (
+    int PipeDescriptor,
+    const struct iovec *Vector,
+    size_t VectorCount,
+    unsigned int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine places the pages of the given user buffers into a pipe
+    without copying them. The memory must not be modified until the data has
+    been read out of the pipe.
+
+Arguments:
+
+    PipeDescriptor - Supplies the file descriptor of the write end of a pipe.
+
+    Vector - Supplies an array of buffers to place into the pipe.
+
+    VectorCount - Supplies the number of elements in the vector array.
+
+    Flags - Supplies a bitfield of flags. See SPLICE_F_* definitions.
+
+Return Value:
+
+    Returns the number of bytes placed in the pipe on success. This may be
+    less than requested.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    UINTN BytesSpliced;
+    KSTATUS Status;
+
+    Status = OsSpliceMemory((HANDLE)(UINTN)PipeDescriptor,
+                            (PIO_VECTOR)Vector,
+                            VectorCount,
+                            ClpConvertSpliceFlags(Flags),
+                            &BytesSpliced);
+
+    if (!KSUCCESS(Status)) {
+        if (Status == STATUS_TIMEOUT) {
+            errno = EAGAIN;
+
+        } else {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    return (ssize_t)BytesSpliced;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+ULONG
+ClpConvertSpliceFlags (
+    unsigned int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts C library splice flags into their kernel
+    equivalents. Flags that are only hints are dropped.
+
+Arguments:
+
+    Flags - Supplies the SPLICE_F_* flags to convert.
+
+Return Value:
+
+    Returns the SYS_SPLICE_FLAG_* flags to hand to the kernel.
+
+--*/
+
+{
+
+    ULONG SystemFlags;
+
+    SystemFlags = 0;
+    if ((Flags & SPLICE_F_NONBLOCK) != 0) {
+        SystemFlags |= SYS_SPLICE_FLAG_NON_BLOCKING;
+    }
+
+    if ((Flags & SPLICE_F_GIFT) != 0) {
+        SystemFlags |= SYS_SPLICE_FLAG_GIFT;
+    }
+
+    return SystemFlags;
+}
+
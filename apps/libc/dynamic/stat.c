@@ -71,12 +71,6 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
-VOID
-ClpConvertFilePropertiesToStat (
-    PFILE_PROPERTIES Properties,
-    struct stat *Stat
-    );
-
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -93,7 +87,13 @@ mode_t ClStatFileTypeConversions[IoObjectTypeCount] = {
     S_IFCHR,
     S_IFCHR,
     S_IFREG,
-    S_IFLNK
+    S_IFLNK,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0
 };
 
 //
@@ -1563,7 +1563,7 @@ Return Value:
     // added.
     //
 
-    assert(IoObjectSymbolicLink + 1 == IoObjectTypeCount);
+    assert(IoObjectFileWatch + 1 == IoObjectTypeCount);
 
     Stat->st_mode |= ClStatFileTypeConversions[Properties->Type];
 
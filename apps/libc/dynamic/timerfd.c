@@ -0,0 +1,382 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    timerfd.c
+
+Abstract:
+
+    This module implements timer file descriptors.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <errno.h>
+#include <sys/timerfd.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+ClpConvertIoTimerInformation (
+    PTIMER_INFORMATION Information,
+    struct itimerspec *Value
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+int
+timerfd_create (
+    clockid_t ClockId,
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new timer file descriptor. The timer starts out
+    disarmed. Once armed, the descriptor becomes readable when the timer
+    expires, and an 8-byte read returns the number of expirations since the
+    last read.
+
+Arguments:
+
+    ClockId - Supplies the clock the timer measures against. Valid values are
+        CLOCK_REALTIME and CLOCK_MONOTONIC.
+
+    Flags - Supplies a bitfield of flags. See TFD_CLOEXEC and TFD_NONBLOCK.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    HANDLE Handle;
+    ULONG OpenFlags;
+    KSTATUS Status;
+    ULONG TimerFlags;
+
+    if ((Flags & ~(TFD_CLOEXEC | TFD_NONBLOCK)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    TimerFlags = 0;
+    if (ClockId == CLOCK_REALTIME) {
+        TimerFlags |= IO_TIMER_FLAG_REAL_TIME;
+
+    } else if (ClockId != CLOCK_MONOTONIC) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    OpenFlags = 0;
+    if ((Flags & TFD_CLOEXEC) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_CLOSE_ON_EXECUTE;
+    }
+
+    if ((Flags & TFD_NONBLOCK) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = OsCreateIoTimer(OpenFlags, TimerFlags, &Handle);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (int)(UINTN)Handle;
+}
+
+LIBC_API
+int
+timerfd_settime (
+    int FileDescriptor,
+    int Flags,
+    const struct itimerspec *Value,
+    struct itimerspec *OldValue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine arms or disarms a timer file descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the timer file descriptor.
+
+    Flags - Supplies a bitfield of flags. See TFD_TIMER_ABSTIME.
+
+    Value - Supplies a pointer to the new initial expiration and interval. A
+        zero initial expiration disarms the timer.
+
+    OldValue - Supplies an optional pointer where the time remaining and
+        interval of the previous setting will be returned.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    SYSTEM_TIME CurrentSystemTime;
+    ULONG Frequency;
+    TIMER_INFORMATION Information;
+    KSTATUS Status;
+    SYSTEM_TIME SystemTime;
+    ULONG TimerFlags;
+
+    if ((Flags & ~TFD_TIMER_ABSTIME) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((Value->it_value.tv_nsec < 0) ||
+        (Value->it_value.tv_nsec >= NANOSECONDS_PER_SECOND) ||
+        (Value->it_interval.tv_nsec < 0) ||
+        (Value->it_interval.tv_nsec >= NANOSECONDS_PER_SECOND)) {
+
+        errno = EINVAL;
+        return -1;
+    }
+
+    RtlZeroMemory(&Information, sizeof(TIMER_INFORMATION));
+    Frequency = OsGetTimeCounterFrequency();
+
+    //
+    // Absolute times depend on which clock the timer was created against, so
+    // ask the kernel.
+    //
+
+    TimerFlags = 0;
+    if ((Flags & TFD_TIMER_ABSTIME) != 0) {
+        Status = OsIoTimerControl((HANDLE)(UINTN)FileDescriptor,
+                                  TimerOperationGetTimer,
+                                  &Information,
+                                  &TimerFlags);
+
+        if (!KSUCCESS(Status)) {
+            errno = ClConvertKstatusToErrorNumber(Status);
+            return -1;
+        }
+    }
+
+    //
+    // A zero initial expiration disarms the timer. Otherwise, convert the
+    // value into an absolute due time in time counter ticks.
+    //
+
+    if ((Value->it_value.tv_sec == 0) && (Value->it_value.tv_nsec == 0)) {
+        Information.DueTime = 0;
+
+    } else if (((TimerFlags & IO_TIMER_FLAG_REAL_TIME) != 0) &&
+               ((Flags & TFD_TIMER_ABSTIME) != 0)) {
+
+        ClpConvertSpecificTimeToSystemTime(&SystemTime, &(Value->it_value));
+        OsGetSystemTime(&CurrentSystemTime);
+
+        //
+        // A due time in the past fires right away. Avoid converting it, as it
+        // may predate the time counter.
+        //
+
+        if ((SystemTime.Seconds < CurrentSystemTime.Seconds) ||
+            ((SystemTime.Seconds == CurrentSystemTime.Seconds) &&
+             (SystemTime.Nanoseconds <= CurrentSystemTime.Nanoseconds))) {
+
+            Information.DueTime = OsQueryTimeCounter();
+
+        } else {
+            OsConvertSystemTimeToTimeCounter(&SystemTime,
+                                             &(Information.DueTime));
+        }
+
+    } else {
+        ClpConvertSpecificTimeToCounter(&(Information.DueTime),
+                                        Frequency,
+                                        &(Value->it_value));
+
+        if ((Flags & TFD_TIMER_ABSTIME) == 0) {
+            Information.DueTime += OsQueryTimeCounter();
+        }
+    }
+
+    ClpConvertSpecificTimeToCounter(&(Information.Period),
+                                    Frequency,
+                                    &(Value->it_interval));
+
+    Status = OsIoTimerControl((HANDLE)(UINTN)FileDescriptor,
+                              TimerOperationSetTimer,
+                              &Information,
+                              NULL);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    if (OldValue != NULL) {
+        ClpConvertIoTimerInformation(&Information, OldValue);
+    }
+
+    return 0;
+}
+
+LIBC_API
+int
+timerfd_gettime (
+    int FileDescriptor,
+    struct itimerspec *CurrentValue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the time remaining until the next expiration of a
+    timer file descriptor, and its interval.
+
+Arguments:
+
+    FileDescriptor - Supplies the timer file descriptor.
+
+    CurrentValue - Supplies a pointer where the time remaining and interval
+        will be returned. Zero is returned for the time remaining if the timer
+        is disarmed.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    TIMER_INFORMATION Information;
+    KSTATUS Status;
+
+    RtlZeroMemory(&Information, sizeof(TIMER_INFORMATION));
+    Status = OsIoTimerControl((HANDLE)(UINTN)FileDescriptor,
+                              TimerOperationGetTimer,
+                              &Information,
+                              NULL);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    ClpConvertIoTimerInformation(&Information, CurrentValue);
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+ClpConvertIoTimerInformation (
+    PTIMER_INFORMATION Information,
+    struct itimerspec *Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts an absolute due time and period in time counter
+    ticks into a relative timer specification.
+
+Arguments:
+
+    Information - Supplies a pointer to the timer information to convert.
+
+    Value - Supplies a pointer where the time remaining and interval will be
+        returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONGLONG CurrentTime;
+    ULONG Frequency;
+    ULONGLONG Remaining;
+
+    Frequency = OsGetTimeCounterFrequency();
+    Remaining = 0;
+    if (Information->DueTime != 0) {
+        CurrentTime = OsQueryTimeCounter();
+
+        //
+        // A timer that is due but whose expiration has not been processed
+        // yet reports the smallest non-zero time remaining, as zero means
+        // disarmed.
+        //
+
+        Remaining = 1;
+        if (Information->DueTime > CurrentTime) {
+            Remaining = Information->DueTime - CurrentTime;
+        }
+    }
+
+    ClpConvertCounterToSpecificTime(Remaining, Frequency, &(Value->it_value));
+    ClpConvertCounterToSpecificTime(Information->Period,
+                                    Frequency,
+                                    &(Value->it_interval));
+
+    return;
+}
+
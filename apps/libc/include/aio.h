@@ -0,0 +1,401 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    aio.h
+
+Abstract:
+
+    This header contains definitions for POSIX asynchronous I/O.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _AIO_H
+#define _AIO_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <libcbase.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <time.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define the values returned by aio_cancel.
+//
+
+//
+// This value is returned if all the requested operations were canceled.
+//
+
+#define AIO_CANCELED 0
+
+//
+// This value is returned if at least one of the requested operations could not
+// be canceled because it was in progress.
+//
+
+#define AIO_NOTCANCELED 1
+
+//
+// This value is returned if all the requested operations had already
+// completed.
+//
+
+#define AIO_ALLDONE 2
+
+//
+// Define the modes for lio_listio.
+//
+
+//
+// This mode causes lio_listio to return only once every operation in the list
+// has completed.
+//
+
+#define LIO_WAIT 0
+
+//
+// This mode causes lio_listio to return as soon as the operations are queued.
+//
+
+#define LIO_NOWAIT 1
+
+//
+// Define the operations for entries in a lio_listio list.
+//
+
+#define LIO_READ 0
+#define LIO_WRITE 1
+#define LIO_NOP 2
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an asynchronous I/O control block.
+
+Members:
+
+    aio_fildes - Stores the file descriptor to perform I/O on.
+
+    aio_offset - Stores the file offset to perform the I/O at.
+
+    aio_buf - Stores a pointer to the data buffer.
+
+    aio_nbytes - Stores the number of bytes to transfer.
+
+    aio_reqprio - Stores the request priority offset. This is currently
+        ignored.
+
+    aio_sigevent - Stores the notification to deliver when the operation
+        completes. Only SIGEV_NONE and SIGEV_SIGNAL are supported.
+
+    aio_lio_opcode - Stores the operation to perform when the control block is
+        part of a lio_listio list. See LIO_* definitions.
+
+    __aio_status - Stores the status of the operation, written by the system.
+        This member and the next must not be accessed by applications.
+
+    __aio_bytes_completed - Stores the number of bytes transferred, written
+        by the system.
+
+--*/
+
+struct aiocb {
+    int aio_fildes;
+    off_t aio_offset;
+    volatile void *aio_buf;
+    size_t aio_nbytes;
+    int aio_reqprio;
+    struct sigevent aio_sigevent;
+    int aio_lio_opcode;
+    volatile int __aio_status;
+    size_t __aio_bytes_completed;
+};
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+int
+aio_read (
+    struct aiocb *ControlBlock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues an asynchronous read. The read is performed at the
+    offset in the control block regardless of the file position.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block describing the
+        read. This control block and its buffer must remain valid until the
+        operation completes.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+aio_write (
+    struct aiocb *ControlBlock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues an asynchronous write. The data is written at the
+    offset in the control block regardless of the file position.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block describing the
+        write. This control block and its buffer must remain valid until the
+        operation completes.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+aio_fsync (
+    int Operation,
+    struct aiocb *ControlBlock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues an asynchronous flush of the file descriptor in the
+    given control block.
+
+Arguments:
+
+    Operation - Supplies either O_SYNC or O_DSYNC.
+
+    ControlBlock - Supplies a pointer to the control block. Only the file
+        descriptor and signal event members are used.
+
+Return Value:
+
+    0 if the request was queued.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+aio_error (
+    const struct aiocb *ControlBlock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the error status of an asynchronous operation.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block of the operation.
+
+Return Value:
+
+    0 if the operation completed successfully.
+
+    EINPROGRESS if the operation has not yet completed.
+
+    Returns the error number the operation failed with otherwise.
+
+--*/
+
+LIBC_API
+ssize_t
+aio_return (
+    struct aiocb *ControlBlock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the final result of a completed asynchronous
+    operation.
+
+Arguments:
+
+    ControlBlock - Supplies a pointer to the control block of the operation.
+
+Return Value:
+
+    Returns the number of bytes transferred by a completed read or write, or
+    0 for a completed flush.
+
+    -1 if the operation failed or is still in progress, and errno will be set
+    to contain more information.
+
+--*/
+
+LIBC_API
+int
+aio_suspend (
+    const struct aiocb *const List[],
+    int Count,
+    const struct timespec *Timeout
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits until at least one of the given asynchronous
+    operations has completed.
+
+Arguments:
+
+    List - Supplies an array of pointers to control blocks. NULL entries are
+        ignored.
+
+    Count - Supplies the number of elements in the array.
+
+    Timeout - Supplies an optional pointer to the relative amount of time to
+        wait. If NULL, the wait is indefinite.
+
+Return Value:
+
+    0 if at least one of the operations has completed.
+
+    -1 on failure, and errno will be set to contain more information. EAGAIN
+    is returned if the timeout expired.
+
+--*/
+
+LIBC_API
+int
+aio_cancel (
+    int FileDescriptor,
+    struct aiocb *ControlBlock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine attempts to cancel outstanding asynchronous operations.
+    Operations are handed to the system as soon as they are queued, so
+    operations that have not completed cannot be canceled.
+
+Arguments:
+
+    FileDescriptor - Supplies the file descriptor whose operations should be
+        canceled.
+
+    ControlBlock - Supplies an optional pointer to a specific operation to
+        cancel. If NULL, all operations on the descriptor are considered.
+
+Return Value:
+
+    AIO_NOTCANCELED if the operation is still in progress.
+
+    AIO_ALLDONE if the operation has already completed, or if no control block
+    was supplied.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+lio_listio (
+    int Mode,
+    struct aiocb *const List[],
+    int Count,
+    struct sigevent *Event
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues a list of asynchronous operations with a single call.
+
+Arguments:
+
+    Mode - Supplies LIO_WAIT to wait for every operation to complete before
+        returning, or LIO_NOWAIT to return once they are queued.
+
+    List - Supplies an array of pointers to control blocks. NULL entries and
+        entries whose opcode is LIO_NOP are ignored.
+
+    Count - Supplies the number of elements in the array.
+
+    Event - Supplies an optional pointer to the notification to deliver once
+        every operation in the list has completed. This is only used with
+        LIO_NOWAIT.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information. If
+    LIO_WAIT was supplied and any of the operations failed, errno is set to
+    EIO and aio_error should be used on each control block.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
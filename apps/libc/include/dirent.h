@@ -111,6 +111,12 @@ extern "C" {
 
 typedef struct _DIR DIR;
 
+//
+// Declare the stat structure, which is filled in by readdirplus.
+//
+
+struct stat;
+
 /*++
 
 Structure Description:
@@ -287,6 +293,43 @@ Return Value:
 
 --*/
 
+LIBC_API
+struct dirent *
+readdirplus (
+    DIR *Directory,
+    struct stat *Stat
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads the next directory entry from the open directory
+    stream, along with the status information of the file it names. This is
+    equivalent to calling readdir followed by fstatat with the
+    AT_SYMLINK_NOFOLLOW flag, except that the information is fetched from the
+    kernel along with the names, a batch at a time. Entries that are removed
+    before their information can be gathered are skipped. This routine is not
+    part of POSIX.
+
+Arguments:
+
+    Directory - Supplies a pointer to the structure returned by the open
+        directory function.
+
+    Stat - Supplies a pointer where the status information of the entry will
+        be returned.
+
+Return Value:
+
+    Returns a pointer to the next directory entry on success.
+
+    NULL on failure or when the end of the directory is reached. On failure,
+        errno is set. If the end of the directory is reached, errno is not
+        changed.
+
+--*/
+
 LIBC_API
 void
 seekdir (
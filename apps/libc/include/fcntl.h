@@ -111,6 +111,19 @@ extern "C" {
 
 #define F_CLOSEM 11
 
+//
+// Get the size of a pipe's buffer, in bytes.
+//
+
+#define F_GETPIPE_SZ 12
+
+//
+// Set the size of a pipe's buffer. The size is rounded up, and the size
+// actually used is returned.
+//
+
+#define F_SETPIPE_SZ 13
+
 //
 // There's no need for 64-bit versions, since off_t is always 64 bits.
 //
@@ -258,6 +271,16 @@ extern "C" {
 #define O_ASYNC 0x00010000
 #define FASYNC O_ASYNC
 
+//
+// Set this flag to transfer data directly between the user's buffer and the
+// underlying device, bypassing the system's file cache. This only takes
+// effect for I/O whose buffer, offset, and size are all aligned to the block
+// size of the file (the page size for regular files). Other I/O on the
+// descriptor goes through the cache as usual.
+//
+
+#define O_DIRECT 0x00020000
+
 //
 // Set this flag to enable opening files whose offsets cannot be described in
 // off_t types but can be described in off64_t. Since off_t is always 64-bits,
@@ -333,6 +356,36 @@ extern "C" {
 
 #define AT_REMOVEDIR 0x00000008
 
+//
+// Define flags for the splice and vmsplice functions. Pages are always moved
+// rather than copied where possible, so the move flag is accepted but does
+// nothing extra.
+//
+
+#define SPLICE_F_MOVE 0x00000001
+
+//
+// Set this flag to return immediately rather than block if the pipe is full
+// or empty.
+//
+
+#define SPLICE_F_NONBLOCK 0x00000002
+
+//
+// Set this flag to hint that more data will be spliced soon.
+//
+
+#define SPLICE_F_MORE 0x00000004
+
+//
+// Set this flag in vmsplice to indicate that the caller will not modify the
+// memory again. The pages are referenced rather than copied either way, so
+// memory given to vmsplice must not be changed until it has been read out of
+// the pipe.
+//
+
+#define SPLICE_F_GIFT 0x00000008
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -369,6 +422,8 @@ struct flock {
     short l_whence;
 };
 
+struct iovec;
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -479,6 +534,91 @@ Return Value:
 
 --*/
 
+LIBC_API
+ssize_t
+splice (
+    int InputDescriptor,
+    off_t *InputOffset,
+    int OutputDescriptor,
+    off_t *OutputOffset,
+    size_t Size,
+    unsigned int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine moves data between two file descriptors, at least one of
+    which must refer to a pipe, without copying it through user mode. Pages
+    are handed between pipes and referenced from the file cache rather than
+    copied wherever possible.
+
+Arguments:
+
+    InputDescriptor - Supplies the file descriptor to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        to read from. On return, this is advanced past the bytes moved and the
+        descriptor's file position is left unchanged. This must be NULL if the
+        input is a pipe.
+
+    OutputDescriptor - Supplies the file descriptor to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output to write to. On return, this is advanced past the bytes moved
+        and the descriptor's file position is left unchanged. This must be
+        NULL if the output is a pipe.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SPLICE_F_* definitions.
+
+Return Value:
+
+    Returns the number of bytes moved on success. This may be less than
+    requested, and is zero at the end of the input.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+ssize_t
+vmsplice (
+    int PipeDescriptor,
+    const struct iovec *Vector,
+    size_t VectorCount,
+    unsigned int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine places the pages of the given user buffers into a pipe
+    without copying them. The memory must not be modified until the data has
+    been read out of the pipe.
+
+Arguments:
+
+    PipeDescriptor - Supplies the file descriptor of the write end of a pipe.
+
+    Vector - Supplies an array of buffers to place into the pipe.
+
+    VectorCount - Supplies the number of elements in the vector array.
+
+    Flags - Supplies a bitfield of flags. See SPLICE_F_* definitions.
+
+Return Value:
+
+    Returns the number of bytes placed in the pipe on success. This may be
+    less than requested.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
 #ifdef __cplusplus
 
 }
@@ -0,0 +1,342 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    epoll.h
+
+Abstract:
+
+    This header contains definitions for the epoll event notification
+    interface, which waits on a persistent set of file descriptors.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_EPOLL_H
+#define _SYS_EPOLL_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <libcbase.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define the flags that can be passed to epoll_create1.
+//
+
+//
+// Set this flag to close the epoll descriptor on exec.
+//
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+//
+// Define the operations that can be passed to epoll_ctl.
+//
+
+//
+// This operation adds a new descriptor to the interest set.
+//
+
+#define EPOLL_CTL_ADD 1
+
+//
+// This operation removes a descriptor from the interest set.
+//
+
+#define EPOLL_CTL_DEL 2
+
+//
+// This operation changes the events and data for a descriptor already in the
+// interest set.
+//
+
+#define EPOLL_CTL_MOD 3
+
+//
+// Define the epoll events. These match the poll events.
+//
+
+#define EPOLLIN POLLIN
+#define EPOLLPRI POLLPRI
+#define EPOLLOUT POLLOUT
+#define EPOLLRDNORM POLLRDNORM
+#define EPOLLRDBAND POLLRDBAND
+#define EPOLLWRNORM POLLWRNORM
+#define EPOLLWRBAND POLLWRBAND
+#define EPOLLERR POLLERR
+#define EPOLLHUP POLLHUP
+
+//
+// Set this flag to disable the descriptor after it is reported once. It can
+// be re-armed with EPOLL_CTL_MOD.
+//
+
+#define EPOLLONESHOT (1U << 30)
+
+//
+// Set this flag to only report the descriptor when new events arrive, rather
+// than every time it is found to be ready.
+//
+
+#define EPOLLET (1U << 31)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Union Description:
+
+    This union defines the user data associated with an epoll registration.
+
+Members:
+
+    ptr - Stores a pointer value.
+
+    fd - Stores a file descriptor.
+
+    u32 - Stores a 32-bit value.
+
+    u64 - Stores a 64-bit value.
+
+--*/
+
+typedef union epoll_data {
+    void *ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+} epoll_data_t;
+
+/*++
+
+Structure Description:
+
+    This structure defines an epoll event.
+
+Members:
+
+    events - Stores the mask of EPOLL* events.
+
+    data - Stores the user data registered with the descriptor.
+
+--*/
+
+struct epoll_event {
+    uint32_t events;
+    epoll_data_t data;
+};
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+int
+epoll_create (
+    int Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new epoll descriptor.
+
+Arguments:
+
+    Size - Supplies a hint as to the number of descriptors that will be
+        watched. This is ignored, but must be greater than zero.
+
+Return Value:
+
+    Returns the new epoll descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+epoll_create1 (
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new epoll descriptor.
+
+Arguments:
+
+    Flags - Supplies a bitfield of flags. The only valid flag is
+        EPOLL_CLOEXEC.
+
+Return Value:
+
+    Returns the new epoll descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+epoll_ctl (
+    int EpollDescriptor,
+    int Operation,
+    int FileDescriptor,
+    struct epoll_event *Event
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds, modifies, or removes a descriptor from the interest set
+    of an epoll descriptor.
+
+Arguments:
+
+    EpollDescriptor - Supplies the epoll descriptor.
+
+    Operation - Supplies the operation to perform. See EPOLL_CTL_*
+        definitions.
+
+    FileDescriptor - Supplies the descriptor to add, modify, or remove.
+
+    Event - Supplies a pointer to the events and data to register. This is
+        ignored for EPOLL_CTL_DEL.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+epoll_wait (
+    int EpollDescriptor,
+    struct epoll_event *Events,
+    int MaxEvents,
+    int Timeout
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits for descriptors in the interest set of an epoll
+    descriptor to become ready.
+
+Arguments:
+
+    EpollDescriptor - Supplies the epoll descriptor.
+
+    Events - Supplies a pointer to an array where the ready events are
+        returned.
+
+    MaxEvents - Supplies the number of elements in the events array. This must
+        be greater than zero.
+
+    Timeout - Supplies the amount of time in milliseconds to block before
+        giving up. Supply 0 to not block at all, and supply -1 to wait for an
+        indefinite amount of time.
+
+Return Value:
+
+    Returns the number of events returned on success.
+
+    Returns 0 to indicate a timeout.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+epoll_pwait (
+    int EpollDescriptor,
+    struct epoll_event *Events,
+    int MaxEvents,
+    int Timeout,
+    const sigset_t *SignalMask
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits for descriptors in the interest set of an epoll
+    descriptor to become ready, with the given signal mask in effect for the
+    duration of the wait.
+
+Arguments:
+
+    EpollDescriptor - Supplies the epoll descriptor.
+
+    Events - Supplies a pointer to an array where the ready events are
+        returned.
+
+    MaxEvents - Supplies the number of elements in the events array. This must
+        be greater than zero.
+
+    Timeout - Supplies the amount of time in milliseconds to block before
+        giving up. Supply 0 to not block at all, and supply -1 to wait for an
+        indefinite amount of time.
+
+    SignalMask - Supplies an optional pointer to the signal mask to set for
+        the duration of the wait.
+
+Return Value:
+
+    Returns the number of events returned on success.
+
+    Returns 0 to indicate a timeout.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
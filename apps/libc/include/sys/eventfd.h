@@ -0,0 +1,176 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    eventfd.h
+
+Abstract:
+
+    This header contains definitions for event file descriptors, which are
+    64-bit counters that can be waited on with poll.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_EVENTFD_H
+#define _SYS_EVENTFD_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <libcbase.h>
+#include <fcntl.h>
+#include <stdint.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define the flags that can be passed to eventfd.
+//
+
+//
+// Set this flag to have each read decrement the counter by one rather than
+// returning the whole value and resetting it to zero.
+//
+
+#define EFD_SEMAPHORE 0x00000001
+
+//
+// Set this flag to close the descriptor on exec.
+//
+
+#define EFD_CLOEXEC O_CLOEXEC
+
+//
+// Set this flag to make reads and writes on the descriptor non-blocking.
+//
+
+#define EFD_NONBLOCK O_NONBLOCK
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// Define the type of the counter value.
+//
+
+typedef uint64_t eventfd_t;
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+int
+eventfd (
+    unsigned int InitialValue,
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event file descriptor. Writes of 8-byte values
+    add to the descriptor's counter, and 8-byte reads return and consume it.
+    The descriptor is readable whenever the counter is non-zero.
+
+Arguments:
+
+    InitialValue - Supplies the initial value of the counter.
+
+    Flags - Supplies a bitfield of flags. See EFD_* definitions.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+eventfd_read (
+    int FileDescriptor,
+    eventfd_t *Value
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads the counter from an event file descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the event file descriptor.
+
+    Value - Supplies a pointer where the counter value will be returned.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+eventfd_write (
+    int FileDescriptor,
+    eventfd_t Value
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a value to the counter of an event file descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the event file descriptor.
+
+    Value - Supplies the value to add.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
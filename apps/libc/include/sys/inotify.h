@@ -0,0 +1,307 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    inotify.h
+
+Abstract:
+
+    This header contains definitions for inotify descriptors, which report
+    changes to watched files and directories.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_INOTIFY_H
+#define _SYS_INOTIFY_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <libcbase.h>
+#include <fcntl.h>
+#include <stdint.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define the flags that can be passed to inotify_init1.
+//
+
+//
+// Set this flag to close the descriptor on exec.
+//
+
+#define IN_CLOEXEC O_CLOEXEC
+
+//
+// Set this flag to make reads on the descriptor non-blocking.
+//
+
+#define IN_NONBLOCK O_NONBLOCK
+
+//
+// Define the events that can be watched for. Access, open, and close events
+// are accepted for compatibility but are never reported.
+//
+
+#define IN_ACCESS        0x00000001
+#define IN_MODIFY        0x00000002
+#define IN_ATTRIB        0x00000004
+#define IN_CLOSE_WRITE   0x00000008
+#define IN_CLOSE_NOWRITE 0x00000010
+#define IN_OPEN          0x00000020
+#define IN_MOVED_FROM    0x00000040
+#define IN_MOVED_TO      0x00000080
+#define IN_CREATE        0x00000100
+#define IN_DELETE        0x00000200
+#define IN_DELETE_SELF   0x00000400
+#define IN_MOVE_SELF     0x00000800
+
+#define IN_CLOSE (IN_CLOSE_WRITE | IN_CLOSE_NOWRITE)
+#define IN_MOVE (IN_MOVED_FROM | IN_MOVED_TO)
+#define IN_ALL_EVENTS 0x00000FFF
+
+//
+// Define the bits that are only ever set in returned events.
+//
+
+//
+// This bit is set if the file system containing the watched object was
+// unmounted. It is never set, as unmounts are not reported.
+//
+
+#define IN_UNMOUNT 0x00002000
+
+//
+// This bit is set if events were dropped because the queue was full.
+//
+
+#define IN_Q_OVERFLOW 0x00004000
+
+//
+// This bit is set when a watch is removed, either explicitly or because the
+// watched object was deleted.
+//
+
+#define IN_IGNORED 0x00008000
+
+//
+// This bit is set if the subject of the event is a directory.
+//
+
+#define IN_ISDIR 0x40000000
+
+//
+// Define the flags that can be combined with the events passed to
+// inotify_add_watch.
+//
+
+//
+// Set this flag to fail unless the path refers to a directory.
+//
+
+#define IN_ONLYDIR 0x01000000
+
+//
+// Set this flag to watch a symbolic link itself rather than its target.
+//
+
+#define IN_DONT_FOLLOW 0x02000000
+
+//
+// This flag is accepted for compatibility but has no effect, as events are
+// never reported for names that have been unlinked.
+//
+
+#define IN_EXCL_UNLINK 0x04000000
+
+//
+// Set this flag to add the given events to an existing watch rather than
+// replacing them.
+//
+
+#define IN_MASK_ADD 0x20000000
+
+//
+// Set this flag to remove the watch after its first event.
+//
+
+#define IN_ONESHOT 0x80000000
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines a single event read from an inotify descriptor.
+
+Members:
+
+    wd - Stores the watch descriptor the event occurred on, or -1 for an
+        overflow event.
+
+    mask - Stores the events that occurred. See IN_* definitions.
+
+    cookie - Stores a value shared by the two halves of a rename, or zero.
+
+    len - Stores the size of the name in bytes, including the null terminator
+        and any padding. This is zero if the event is about the watched object
+        itself.
+
+    name - Stores the name of the directory entry the event is about.
+
+--*/
+
+struct inotify_event {
+    int wd;
+    uint32_t mask;
+    uint32_t cookie;
+    uint32_t len;
+    char name[];
+};
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+int
+inotify_init (
+    void
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new inotify descriptor.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+inotify_init1 (
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new inotify descriptor.
+
+Arguments:
+
+    Flags - Supplies a bitfield of flags. See IN_CLOEXEC and IN_NONBLOCK.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+inotify_add_watch (
+    int FileDescriptor,
+    const char *Path,
+    uint32_t Mask
+    );
+
+/*++
+
+Routine Description:
+
+    This routine starts watching a file or directory, or changes the events
+    reported for one already being watched by the given descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the inotify descriptor.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    Mask - Supplies the events to watch for and flags. See IN_* definitions.
+
+Return Value:
+
+    Returns the watch descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+inotify_rm_watch (
+    int FileDescriptor,
+    int WatchDescriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine stops watching a file or directory.
+
+Arguments:
+
+    FileDescriptor - Supplies the inotify descriptor.
+
+    WatchDescriptor - Supplies the watch descriptor returned when the file
+        was added.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
@@ -99,6 +99,38 @@ extern "C" {
 
 #define RUSAGE_THREAD 3
 
+//
+// Define the I/O priority classes. An I/O priority combines a class with a
+// level within the class, where level 0 is the most urgent. Real time I/O is
+// serviced ahead of everything else, best effort I/O is the default, and idle
+// I/O is only serviced when the disk has nothing else to do.
+//
+
+#define IOPRIO_CLASS_NONE 0
+#define IOPRIO_CLASS_RT 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_IDLE 3
+
+//
+// Define the macros for building and taking apart I/O priority values.
+//
+
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_PRIO_MASK ((1 << IOPRIO_CLASS_SHIFT) - 1)
+#define IOPRIO_PRIO_CLASS(_Priority) ((_Priority) >> IOPRIO_CLASS_SHIFT)
+#define IOPRIO_PRIO_DATA(_Priority) ((_Priority) & IOPRIO_PRIO_MASK)
+#define IOPRIO_PRIO_VALUE(_Class, _Data) \
+    (((_Class) << IOPRIO_CLASS_SHIFT) | (_Data))
+
+//
+// Define the "which" values for getting and setting I/O priorities. Setting
+// the I/O priority of a process applies to all its threads that do not have
+// one of their own. Thread I/O priorities are non-portable.
+//
+
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_WHO_THREAD 4
+
 //
 // Define the different kinds of resource limits.
 //
@@ -460,6 +492,76 @@ Return Value:
 
 --*/
 
+LIBC_API
+int
+ioprio_get (
+    int Which,
+    int Who
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the I/O priority of a process or thread.
+
+Arguments:
+
+    Which - Supplies which kind of entity to get the I/O priority of. Valid
+        values are IOPRIO_WHO_PROCESS and the non-portable IOPRIO_WHO_THREAD.
+
+    Who - Supplies the process or thread ID to query. Supply zero to query
+        the current process or thread.
+
+Return Value:
+
+    Returns the I/O priority on success. See IOPRIO_PRIO_CLASS and
+    IOPRIO_PRIO_DATA for taking it apart. A class of IOPRIO_CLASS_NONE means
+    the entity has no I/O priority of its own.
+
+    -1 on failure, and the errno variable will be set to contain more
+    information.
+
+--*/
+
+LIBC_API
+int
+ioprio_set (
+    int Which,
+    int Who,
+    int Priority
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets the I/O priority of a process or thread. The I/O
+    priority decides the order in which the block devices service the
+    entity's reads and writes, including the writeback of data it dirtied.
+
+Arguments:
+
+    Which - Supplies which kind of entity to set the I/O priority of. Valid
+        values are IOPRIO_WHO_PROCESS and the non-portable IOPRIO_WHO_THREAD.
+
+    Who - Supplies the process or thread ID to set. Supply zero to set the
+        current process or thread. Threads must belong to the current process.
+
+    Priority - Supplies the new I/O priority. Use IOPRIO_PRIO_VALUE to build
+        it from a class and a level between 0 (most urgent) and 7. Setting the
+        real time class, or another process' priority, requires appropriate
+        privileges.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and the errno variable will be set to contain more
+    information.
+
+--*/
+
 #ifdef __cplusplus
 
 }
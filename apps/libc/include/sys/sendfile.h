@@ -0,0 +1,104 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    sendfile.h
+
+Abstract:
+
+    This header contains definitions for transferring data between file
+    descriptors without copying it through user mode.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_SENDFILE_H
+#define _SYS_SENDFILE_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <libcbase.h>
+#include <sys/types.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+ssize_t
+sendfile (
+    int OutputDescriptor,
+    int InputDescriptor,
+    off_t *Offset,
+    size_t ByteCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one file descriptor to another within the
+    kernel, avoiding the round trip through a user mode buffer that a read and
+    write loop requires. The input descriptor must refer to a seekable file.
+
+Arguments:
+
+    OutputDescriptor - Supplies the file descriptor to write to. This is
+        commonly a socket.
+
+    InputDescriptor - Supplies the file descriptor to read from.
+
+    Offset - Supplies an optional pointer to the offset within the input file
+        to start reading from. On return, this is updated to the offset just
+        past the last byte transferred, and the input descriptor's file
+        position is left unchanged. If this is NULL, the input descriptor's
+        file position is used and updated.
+
+    ByteCount - Supplies the number of bytes to transfer.
+
+Return Value:
+
+    Returns the number of bytes transferred on success. This may be less than
+    requested, and is zero at the end of the input file.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
@@ -238,6 +238,14 @@ extern "C" {
 
 #define MSG_DONTROUTE 0x00000100
 
+//
+// This flag is used with recvmmsg to stop waiting once the first message has
+// been received. Any further messages are only returned if they are already
+// available.
+//
+
+#define MSG_WAITFORONE 0x00010000
+
 //
 // Define the shutdown types. Read closes the socket for further reading, write
 // closes the socket for further writing, and rdwr closes the socket for both
@@ -574,6 +582,28 @@ struct msghdr {
 
 /*++
 
+Structure Description:
+
+    This structure defines one entry in an array of socket messages sent or
+    received with a single call to sendmmsg or recvmmsg.
+
+Members:
+
+    msg_hdr - Stores the message itself.
+
+    msg_len - Stores the number of bytes sent or received for this message.
+
+--*/
+
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+struct timespec;
+
+/*++
+
 Structure Description:
 
     This structure defines a socket control message, the header for the socket
@@ -1107,6 +1137,86 @@ Return Value:
 
 --*/
 
+LIBC_API
+int
+sendmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends several messages out of a socket with as few system
+    calls as possible.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to send data out of.
+
+    Messages - Supplies an array of messages to send. On return, the msg_len
+        member of each message sent is set to the number of bytes sent.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the transmission of the data.
+        See MSG_* definitions.
+
+Return Value:
+
+    Returns the number of messages sent on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+    An error is only returned if no messages could be sent.
+
+--*/
+
+LIBC_API
+int
+recvmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags,
+    struct timespec *Timeout
+    );
+
+/*++
+
+Routine Description:
+
+    This routine receives several messages from a socket with as few system
+    calls as possible.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to receive data from.
+
+    Messages - Supplies an array of initialized message structures where the
+        received messages will be returned. On return, the msg_len member of
+        each message received is set to the number of bytes received.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the reception of the data.
+        See MSG_* definitions. MSG_WAITFORONE stops waiting once the first
+        message has been received.
+
+    Timeout - Supplies an optional pointer to the maximum amount of time to
+        wait for each message. Supply NULL to wait indefinitely.
+
+Return Value:
+
+    Returns the number of messages received on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+    An error is only returned if no messages could be received.
+
+--*/
+
 LIBC_API
 int
 shutdown (
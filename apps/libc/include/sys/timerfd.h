@@ -0,0 +1,186 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    timerfd.h
+
+Abstract:
+
+    This header contains definitions for timer file descriptors, which deliver
+    timer expirations through a descriptor that can be waited on with poll.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_TIMERFD_H
+#define _SYS_TIMERFD_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <libcbase.h>
+#include <fcntl.h>
+#include <time.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define the flags that can be passed to timerfd_create.
+//
+
+//
+// Set this flag to close the descriptor on exec.
+//
+
+#define TFD_CLOEXEC O_CLOEXEC
+
+//
+// Set this flag to make reads on the descriptor non-blocking.
+//
+
+#define TFD_NONBLOCK O_NONBLOCK
+
+//
+// Define the flags that can be passed to timerfd_settime.
+//
+
+//
+// Set this flag to indicate that the supplied value is an absolute time.
+//
+
+#define TFD_TIMER_ABSTIME TIMER_ABSTIME
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+int
+timerfd_create (
+    clockid_t ClockId,
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new timer file descriptor. The timer starts out
+    disarmed. Once armed, the descriptor becomes readable when the timer
+    expires, and an 8-byte read returns the number of expirations since the
+    last read.
+
+Arguments:
+
+    ClockId - Supplies the clock the timer measures against. Valid values are
+        CLOCK_REALTIME and CLOCK_MONOTONIC.
+
+    Flags - Supplies a bitfield of flags. See TFD_CLOEXEC and TFD_NONBLOCK.
+
+Return Value:
+
+    Returns the new file descriptor on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+timerfd_settime (
+    int FileDescriptor,
+    int Flags,
+    const struct itimerspec *Value,
+    struct itimerspec *OldValue
+    );
+
+/*++
+
+Routine Description:
+
+    This routine arms or disarms a timer file descriptor.
+
+Arguments:
+
+    FileDescriptor - Supplies the timer file descriptor.
+
+    Flags - Supplies a bitfield of flags. See TFD_TIMER_ABSTIME.
+
+    Value - Supplies a pointer to the new initial expiration and interval. A
+        zero initial expiration disarms the timer.
+
+    OldValue - Supplies an optional pointer where the time remaining and
+        interval of the previous setting will be returned.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+LIBC_API
+int
+timerfd_gettime (
+    int FileDescriptor,
+    struct itimerspec *CurrentValue
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the time remaining until the next expiration of a
+    timer file descriptor, and its interval.
+
+Arguments:
+
+    FileDescriptor - Supplies the timer file descriptor.
+
+    CurrentValue - Supplies a pointer where the time remaining and interval
+        will be returned. Zero is returned for the time remaining if the timer
+        is disarmed.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
@@ -1558,6 +1558,56 @@ Return Value:
 
 --*/
 
+LIBC_API
+ssize_t
+copy_file_range (
+    int InputDescriptor,
+    off_t *InputOffset,
+    int OutputDescriptor,
+    off_t *OutputOffset,
+    size_t Size,
+    unsigned int Flags    );
+
+/*++
+
+Routine Description:
+
+    This routine copies a range of one file into another within the kernel,
+    avoiding the round trip through a user mode buffer that a read and write
+    loop requires. Both descriptors must refer to regular files. This routine
+    is not part of POSIX.
+
+Arguments:
+
+    InputDescriptor - Supplies the file descriptor to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        file to read from. On return, this is advanced past the bytes copied
+        and the descriptor's file position is left unchanged. If this is NULL,
+        the input descriptor's file position is used and updated.
+
+    OutputDescriptor - Supplies the file descriptor to write to. This must not
+        have been opened with O_APPEND.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output file to write to. On return, this is advanced past the bytes
+        copied and the descriptor's file position is left unchanged. If this
+        is NULL, the output descriptor's file position is used and updated.
+
+    Size - Supplies the number of bytes to copy.
+
+    Flags - Supplies a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+Return Value:
+
+    Returns the number of bytes copied on success. This may be less than
+    requested, and is zero at the end of the input file.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
 LIBC_API
 int
 fsync (
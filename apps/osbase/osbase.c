@@ -1154,6 +1154,1351 @@ Return Value:
     return STATUS_SUCCESS;
 }
 
+OS_API
+KSTATUS
+OsCreateEventPoll (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event poll object, which waits on a persistent
+    set of I/O handles.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_CLOSE_ON_EXECUTE is permitted.
+
+    Handle - Supplies a pointer where the handle to the new event poll object
+        will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_CREATE_EVENT_POLL Parameters;
+    KSTATUS Status;
+
+    Parameters.OpenFlags = OpenFlags;
+    Status = OsSystemCall(SystemCallCreateEventPoll, &Parameters);
+    *Handle = Parameters.Handle;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsEventPollControl (
+    HANDLE EventPoll,
+    EVENT_POLL_OPERATION Operation,
+    HANDLE Handle,
+    PEVENT_POLL_EVENT Event
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds, modifies, or removes a handle from the set of handles
+    watched by an event poll object.
+
+Arguments:
+
+    EventPoll - Supplies the handle to the event poll object.
+
+    Operation - Supplies the operation to perform.
+
+    Handle - Supplies the handle to add, modify, or remove.
+
+    Event - Supplies an optional pointer to the events and data to register.
+        This is required for add and modify operations.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_FILE_EXISTS if the handle is already being watched on add.
+
+    STATUS_NOT_FOUND if the handle is not being watched on modify or delete.
+
+    STATUS_PERMISSION_DENIED if the handle does not support polling.
+
+    Other error codes on failure.
+
+--*/
+
+{
+
+    SYSTEM_CALL_EVENT_POLL_CONTROL Parameters;
+
+    Parameters.EventPoll = EventPoll;
+    Parameters.Operation = Operation;
+    Parameters.Handle = Handle;
+    if (Event != NULL) {
+        Parameters.Event = *Event;
+
+    } else {
+        RtlZeroMemory(&(Parameters.Event), sizeof(EVENT_POLL_EVENT));
+    }
+
+    return OsSystemCall(SystemCallEventPollControl, &Parameters);
+}
+
+OS_API
+KSTATUS
+OsEventPollWait (
+    HANDLE EventPoll,
+    PSIGNAL_SET SignalMask,
+    PEVENT_POLL_EVENT Events,
+    ULONG EventCount,
+    ULONG TimeoutInMilliseconds,
+    PULONG EventsReturned
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for handles watched by an event poll object to become
+    ready.
+
+Arguments:
+
+    EventPoll - Supplies the handle to the event poll object.
+
+    SignalMask - Supplies an optional pointer to a mask to set for the
+        duration of the wait.
+
+    Events - Supplies a pointer to an array where the ready events will be
+        returned.
+
+    EventCount - Supplies the number of elements in the events array.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait before
+        giving up.
+
+    EventsReturned - Supplies a pointer where the number of events returned
+        will be stored on success.
+
+Return Value:
+
+    STATUS_SUCCESS if one or more handles is ready.
+
+    STATUS_INTERRUPTED if a signal was caught during the wait.
+
+    STATUS_TIMEOUT if no handles were ready in the given amount of time.
+
+    STATUS_INVALID_PARAMETER if more than MAX_LONG events are supplied.
+
+--*/
+
+{
+
+    SYSTEM_CALL_EVENT_POLL_WAIT Parameters;
+    INTN Result;
+
+    if (EventCount > (ULONG)MAX_LONG) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Parameters.EventPoll = EventPoll;
+    Parameters.SignalMask = SignalMask;
+    Parameters.Events = Events;
+    Parameters.EventCount = (LONG)EventCount;
+    Parameters.TimeoutInMilliseconds = TimeoutInMilliseconds;
+    Result = OsSystemCall(SystemCallEventPollWait, &Parameters);
+    if (Result < 0) {
+        *EventsReturned = 0;
+        return Result;
+    }
+
+    *EventsReturned = (ULONG)Result;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+KSTATUS
+OsCreateEventCounter (
+    ULONG OpenFlags,
+    ULONG Flags,
+    ULONG InitialValue,
+    PHANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event counter object, a 64-bit counter that
+    can be read, written, and waited on through a handle.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Supplies a bitfield of flags governing the behavior of the
+        counter. See EVENT_COUNTER_FLAG_* definitions.
+
+    InitialValue - Supplies the initial value of the counter.
+
+    Handle - Supplies a pointer where the handle to the new event counter
+        will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_CREATE_EVENT_COUNTER Parameters;
+    KSTATUS Status;
+
+    Parameters.OpenFlags = OpenFlags;
+    Parameters.Flags = Flags;
+    Parameters.InitialValue = InitialValue;
+    Status = OsSystemCall(SystemCallCreateEventCounter, &Parameters);
+    *Handle = Parameters.Handle;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsCreateIoTimer (
+    ULONG OpenFlags,
+    ULONG Flags,
+    PHANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O timer object, a timer whose expirations
+    are read from a handle rather than delivered as signals.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Supplies a bitfield of flags for the timer. See IO_TIMER_FLAG_*
+        definitions.
+
+    Handle - Supplies a pointer where the handle to the new I/O timer will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_CREATE_IO_TIMER Parameters;
+    KSTATUS Status;
+
+    Parameters.OpenFlags = OpenFlags;
+    Parameters.Flags = Flags;
+    Status = OsSystemCall(SystemCallCreateIoTimer, &Parameters);
+    *Handle = Parameters.Handle;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsIoTimerControl (
+    HANDLE Handle,
+    TIMER_OPERATION Operation,
+    PTIMER_INFORMATION Information,
+    PULONG Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the due time and period of an I/O timer.
+
+Arguments:
+
+    Handle - Supplies the handle to the I/O timer.
+
+    Operation - Supplies the operation to perform. Only TimerOperationGetTimer
+        and TimerOperationSetTimer are valid.
+
+    Information - Supplies a pointer to the timer information. For set
+        operations, this supplies the new absolute due time and period in time
+        counter ticks. A due time of zero disarms the timer. On success, this
+        returns the previous due time and period.
+
+    Flags - Supplies an optional pointer where the IO_TIMER_FLAG_* flags the
+        timer was created with will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_IO_TIMER_CONTROL Parameters;
+    KSTATUS Status;
+
+    Parameters.Handle = Handle;
+    Parameters.Operation = Operation;
+    Parameters.TimerInformation = *Information;
+    Status = OsSystemCall(SystemCallIoTimerControl, &Parameters);
+    if (KSUCCESS(Status)) {
+        *Information = Parameters.TimerInformation;
+        if (Flags != NULL) {
+            *Flags = Parameters.Flags;
+        }
+    }
+
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsSendFile (
+    HANDLE Destination,
+    HANDLE Source,
+    PIO_OFFSET Offset,
+    UINTN Size,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesCompleted
+    )
+
+/*++
+
+Routine Description:
+
+    This routine transfers data from a file directly to another handle, such
+    as a socket, without copying it through a user mode buffer.
+
+Arguments:
+
+    Destination - Supplies the handle to write the data to.
+
+    Source - Supplies the handle to the file to read the data from.
+
+    Offset - Supplies an optional pointer to the offset within the source file
+        to start reading from. On return, this will be updated to the offset
+        just past the last byte transferred. If this is NULL, the source's
+        current file position is used and updated.
+
+    Size - Supplies the number of bytes to transfer.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that writes to
+        the destination should be waited on before timing out. Use
+        SYS_WAIT_TIME_INDEFINITE to wait forever.
+
+    BytesCompleted - Supplies a pointer where the number of bytes transferred
+        will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SEND_FILE Parameters;
+    INTN Result;
+
+    if (Size > (UINTN)MAX_INTN) {
+        Size = (UINTN)MAX_INTN;
+    }
+
+    Parameters.Destination = Destination;
+    Parameters.Source = Source;
+    Parameters.Offset = IO_OFFSET_NONE;
+    if (Offset != NULL) {
+        Parameters.Offset = *Offset;
+    }
+
+    Parameters.Size = (INTN)Size;
+    Parameters.TimeoutInMilliseconds = TimeoutInMilliseconds;
+    Result = OsSystemCall(SystemCallSendFile, &Parameters);
+    if (Result < 0) {
+        *BytesCompleted = 0;
+        return Result;
+    }
+
+    if (Offset != NULL) {
+        *Offset = Parameters.Offset;
+    }
+
+    *BytesCompleted = (UINTN)Result;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+KSTATUS
+OsCopyFileRange (
+    HANDLE Destination,
+    PIO_OFFSET DestinationOffset,
+    HANDLE Source,
+    PIO_OFFSET SourceOffset,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesCopied
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies a range of one file into another within the kernel,
+    without copying it through a user mode buffer. Both handles must refer to
+    regular files.
+
+Arguments:
+
+    Destination - Supplies the handle to the file to write to.
+
+    DestinationOffset - Supplies an optional pointer to the offset within the
+        destination to write to. On return, this will be advanced past the
+        bytes copied. If this is NULL, the destination's current file position
+        is used and updated.
+
+    Source - Supplies the handle to the file to read from.
+
+    SourceOffset - Supplies an optional pointer to the offset within the
+        source to read from. On return, this will be advanced past the bytes
+        copied. If this is NULL, the source's current file position is used and
+        updated.
+
+    Size - Supplies the number of bytes to copy.
+
+    Flags - Supplies a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+    BytesCopied - Supplies a pointer where the number of bytes copied will be
+        returned. This is zero at the end of the source file.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_COPY_FILE_RANGE Parameters;
+    INTN Result;
+
+    if (Size > (UINTN)MAX_INTN) {
+        Size = (UINTN)MAX_INTN;
+    }
+
+    Parameters.Destination = Destination;
+    Parameters.DestinationOffset = IO_OFFSET_NONE;
+    if (DestinationOffset != NULL) {
+        Parameters.DestinationOffset = *DestinationOffset;
+    }
+
+    Parameters.Source = Source;
+    Parameters.SourceOffset = IO_OFFSET_NONE;
+    if (SourceOffset != NULL) {
+        Parameters.SourceOffset = *SourceOffset;
+    }
+
+    Parameters.Size = (INTN)Size;
+    Parameters.Flags = Flags;
+    Result = OsSystemCall(SystemCallCopyFileRange, &Parameters);
+    if (Result < 0) {
+        *BytesCopied = 0;
+        return Result;
+    }
+
+    if (DestinationOffset != NULL) {
+        *DestinationOffset = Parameters.DestinationOffset;
+    }
+
+    if (SourceOffset != NULL) {
+        *SourceOffset = Parameters.SourceOffset;
+    }
+
+    *BytesCopied = (UINTN)Result;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+KSTATUS
+OsCreateFileWatch (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch, which reports changes to the files
+    and directories added to it. Reading the watch's handle returns
+    FILE_WATCH_EVENT records.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Handle - Supplies a pointer where the handle to the new file watch will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_CREATE_FILE_WATCH Parameters;
+    KSTATUS Status;
+
+    Parameters.OpenFlags = OpenFlags;
+    Status = OsSystemCall(SystemCallCreateFileWatch, &Parameters);
+    *Handle = Parameters.Handle;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsAddFileWatch (
+    HANDLE Handle,
+    HANDLE Directory,
+    PCSTR Path,
+    ULONG PathSize,
+    ULONG Events,
+    ULONG Flags,
+    PLONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a file or directory to a file watch. If the watch is
+    already watching the given file, the events reported for it are updated
+    instead.
+
+Arguments:
+
+    Handle - Supplies the handle to the file watch.
+
+    Directory - Supplies an optional handle to a directory to start the path
+        search from if the supplied path is relative. Supply INVALID_HANDLE
+        here to use the current directory for relative paths.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    PathSize - Supplies the size of the path buffer in bytes, including the
+        null terminator.
+
+    Events - Supplies the mask of events to report. See FILE_WATCH_EVENT_*
+        definitions.
+
+    Flags - Supplies a bitfield of flags. See FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Supplies a pointer where the descriptor identifying the file
+        in event records will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_ADD_FILE_WATCH Parameters;
+    KSTATUS Status;
+
+    Parameters.Handle = Handle;
+    Parameters.Directory = Directory;
+    Parameters.Path = Path;
+    Parameters.PathSize = PathSize;
+    Parameters.Events = Events;
+    Parameters.Flags = Flags;
+    Status = OsSystemCall(SystemCallAddFileWatch, &Parameters);
+    *Descriptor = Parameters.Descriptor;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsRemoveFileWatch (
+    HANDLE Handle,
+    LONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a file or directory from a file watch. A final
+    record with the FILE_WATCH_EVENT_IGNORED bit set is queued for the
+    descriptor.
+
+Arguments:
+
+    Handle - Supplies the handle to the file watch.
+
+    Descriptor - Supplies the descriptor returned when the file was added.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_REMOVE_FILE_WATCH Parameters;
+
+    Parameters.Handle = Handle;
+    Parameters.Descriptor = Descriptor;
+    return OsSystemCall(SystemCallRemoveFileWatch, &Parameters);
+}
+
+OS_API
+KSTATUS
+OsSplice (
+    HANDLE Input,
+    PIO_OFFSET InputOffset,
+    HANDLE Output,
+    PIO_OFFSET OutputOffset,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves data between two handles, at least one of which must
+    be a pipe, without copying it through a user mode buffer.
+
+Arguments:
+
+    Input - Supplies the handle to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        to read from. On return, this will be advanced past the bytes moved.
+        If this is NULL, the input's current file position is used. This must
+        be NULL if the input is a pipe.
+
+    Output - Supplies the handle to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output to write to. On return, this will be advanced past the bytes
+        moved. If this is NULL, the output's current file position is used.
+        This must be NULL if the output is a pipe.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned. This is zero at the end of the input.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SPLICE Parameters;
+    INTN Result;
+
+    if (Size > (UINTN)MAX_INTN) {
+        Size = (UINTN)MAX_INTN;
+    }
+
+    Parameters.Input = Input;
+    Parameters.InputOffset = IO_OFFSET_NONE;
+    if (InputOffset != NULL) {
+        Parameters.InputOffset = *InputOffset;
+    }
+
+    Parameters.Output = Output;
+    Parameters.OutputOffset = IO_OFFSET_NONE;
+    if (OutputOffset != NULL) {
+        Parameters.OutputOffset = *OutputOffset;
+    }
+
+    Parameters.Size = (INTN)Size;
+    Parameters.Flags = Flags;
+    Result = OsSystemCall(SystemCallSplice, &Parameters);
+    if (Result < 0) {
+        *BytesSpliced = 0;
+        return Result;
+    }
+
+    if (InputOffset != NULL) {
+        *InputOffset = Parameters.InputOffset;
+    }
+
+    if (OutputOffset != NULL) {
+        *OutputOffset = Parameters.OutputOffset;
+    }
+
+    *BytesSpliced = (UINTN)Result;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+KSTATUS
+OsSpliceMemory (
+    HANDLE Handle,
+    PIO_VECTOR VectorArray,
+    UINTN VectorCount,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    )
+
+/*++
+
+Routine Description:
+
+    This routine places the pages of the given user buffers into a pipe
+    without copying them. The memory must not be modified until the data has
+    been read out of the pipe.
+
+Arguments:
+
+    Handle - Supplies the handle to the write end of a pipe.
+
+    VectorArray - Supplies an array of buffers to place into the pipe.
+
+    VectorCount - Supplies the number of elements in the vector array.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes placed in the
+        pipe will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SPLICE_MEMORY Parameters;
+    INTN Result;
+
+    Parameters.Handle = Handle;
+    Parameters.VectorArray = VectorArray;
+    Parameters.VectorCount = VectorCount;
+    Parameters.Flags = Flags;
+    Result = OsSystemCall(SystemCallSpliceMemory, &Parameters);
+    if (Result < 0) {
+        *BytesSpliced = 0;
+        return Result;
+    }
+
+    *BytesSpliced = (UINTN)Result;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+KSTATUS
+OsCreateAsyncIoContext (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new asynchronous I/O context, which asynchronous
+    I/O requests are submitted to. Reading the context returns the number of
+    requests completed since it was last read.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Handle - Supplies a pointer where the handle to the new context will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT Parameters;
+    KSTATUS Status;
+
+    Parameters.OpenFlags = OpenFlags;
+    Status = OsSystemCall(SystemCallCreateAsyncIoContext, &Parameters);
+    *Handle = Parameters.Handle;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsSubmitAsyncIo (
+    HANDLE Context,
+    PASYNC_IO_REQUEST Requests,
+    ULONG RequestCount,
+    ULONG SignalNumber,
+    UINTN SignalValue,
+    PULONG SubmittedCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine submits a batch of asynchronous I/O requests. Each request's
+    result structure is filled in when it completes, with the byte count
+    written before the status.
+
+Arguments:
+
+    Context - Supplies the handle to the asynchronous I/O context.
+
+    Requests - Supplies an array of requests to submit.
+
+    RequestCount - Supplies the number of elements in the array. This can be
+        at most ASYNC_IO_MAX_SUBMIT.
+
+    SignalNumber - Supplies an optional signal number to send to the process
+        once every request in the batch has completed. Supply zero to send no
+        signal for the batch.
+
+    SignalValue - Supplies the value to send with the batch signal.
+
+    SubmittedCount - Supplies a pointer where the number of requests
+        submitted will be returned. Requests are submitted in order, so if
+        this is less than the request count, the request at this index and
+        all those after it were not submitted.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SUBMIT_ASYNC_IO Parameters;
+    INTN Result;
+
+    Parameters.Context = Context;
+    Parameters.Requests = Requests;
+    Parameters.RequestCount = RequestCount;
+    Parameters.SignalNumber = SignalNumber;
+    Parameters.SignalValue = SignalValue;
+    Result = OsSystemCall(SystemCallSubmitAsyncIo, &Parameters);
+    if (Result < 0) {
+        *SubmittedCount = 0;
+        return Result;
+    }
+
+    *SubmittedCount = (ULONG)Result;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+KSTATUS
+OsWaitForAsyncIo (
+    HANDLE Context,
+    PULONGLONG Generation,
+    ULONG TimeoutInMilliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for any request submitted to an asynchronous I/O
+    context to complete. The context keeps a generation number that advances
+    every time a request completes. Callers snap the generation, check their
+    results, and then wait for the generation to move past the snapped value.
+
+Arguments:
+
+    Context - Supplies the handle to the asynchronous I/O context.
+
+    Generation - Supplies a pointer that on input contains the generation
+        number last seen by the caller. Supply zero to simply query the
+        current generation. On output, returns the current generation.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait for
+        the generation to change. Use SYS_WAIT_TIME_INDEFINITE to wait
+        forever.
+
+Return Value:
+
+    STATUS_SUCCESS if the generation differs from the one supplied.
+
+    STATUS_TIMEOUT if the generation did not change before the timeout
+    expired.
+
+    STATUS_INTERRUPTED if a signal arrived during the wait.
+
+    Other error codes on failure.
+
+--*/
+
+{
+
+    SYSTEM_CALL_WAIT_FOR_ASYNC_IO Parameters;
+    KSTATUS Status;
+
+    Parameters.Context = Context;
+    Parameters.Generation = *Generation;
+    Parameters.TimeoutInMilliseconds = TimeoutInMilliseconds;
+    Status = OsSystemCall(SystemCallWaitForAsyncIo, &Parameters);
+    *Generation = Parameters.Generation;
+    return Status;
+}
+
+OS_API
+KSTATUS
+OsCreateIoRing (
+    ULONG OpenFlags,
+    ULONG Flags,
+    ULONG SubmissionCount,
+    ULONG CompletionCount,
+    PVOID BufferRegion,
+    UINTN BufferRegionSize,
+    PHANDLE Handles,
+    ULONG HandleCount,
+    POS_IO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates an I/O ring: a submission queue and a completion
+    queue in memory shared with the kernel, so that many I/O operations can
+    be issued and reaped with a single system call.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Supplies a bitmask of IO_RING_FLAG_* flags.
+
+    SubmissionCount - Supplies the number of submission entries. This must be
+        a power of two no larger than IO_RING_MAX_ENTRIES.
+
+    CompletionCount - Supplies the number of completion entries. Supply zero
+        to use twice the submission count.
+
+    BufferRegion - Supplies an optional pointer to a region of memory to
+        register with the ring, which submissions can refer to by offset.
+
+    BufferRegionSize - Supplies the size of the buffer region in bytes.
+
+    Handles - Supplies an optional array of handles to register with the
+        ring, which submissions can refer to by index.
+
+    HandleCount - Supplies the number of elements in the handle array.
+
+    Ring - Supplies a pointer where the ring will be described on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN MapSize;
+    PVOID Memory;
+    SYSTEM_CALL_CREATE_IO_RING Parameters;
+    KSTATUS Status;
+
+    RtlZeroMemory(Ring, sizeof(OS_IO_RING));
+    Ring->Handle = INVALID_HANDLE;
+    if (CompletionCount == 0) {
+        CompletionCount = SubmissionCount * 2;
+    }
+
+    if ((SubmissionCount == 0) ||
+        (SubmissionCount > IO_RING_MAX_ENTRIES) ||
+        (CompletionCount > (IO_RING_MAX_ENTRIES * 2))) {
+
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // The ring memory is mapped shared so that the pages the kernel locks
+    // stay the ones this process sees, even across a fork.
+    //
+
+    MapSize = ALIGN_RANGE_UP(IO_RING_SIZE(SubmissionCount, CompletionCount),
+                             OsPageSize);
+
+    Memory = NULL;
+    Status = OsMemoryMap(INVALID_HANDLE,
+                         0,
+                         MapSize,
+                         SYS_MAP_FLAG_READ | SYS_MAP_FLAG_WRITE |
+                         SYS_MAP_FLAG_SHARED | SYS_MAP_FLAG_ANONYMOUS,
+                         &Memory);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    Parameters.OpenFlags = OpenFlags;
+    Parameters.Flags = Flags;
+    Parameters.SubmissionCount = SubmissionCount;
+    Parameters.CompletionCount = CompletionCount;
+    Parameters.Ring = Memory;
+    Parameters.RingSize = MapSize;
+    Parameters.BufferRegion = BufferRegion;
+    Parameters.BufferRegionSize = BufferRegionSize;
+    Parameters.Handles = Handles;
+    Parameters.HandleCount = HandleCount;
+    Status = OsSystemCall(SystemCallCreateIoRing, &Parameters);
+    if (!KSUCCESS(Status)) {
+        OsMemoryUnmap(Memory, MapSize);
+        return Status;
+    }
+
+    Ring->Handle = Parameters.Handle;
+    Ring->Header = Memory;
+    Ring->Submissions = Memory + IO_RING_SUBMISSION_OFFSET;
+    Ring->Completions = Memory + IO_RING_COMPLETION_OFFSET(SubmissionCount);
+    Ring->Size = MapSize;
+    Ring->Flags = Flags;
+    Ring->SubmissionTail = Ring->Header->SubmissionTail;
+    return STATUS_SUCCESS;
+}
+
+OS_API
+VOID
+OsDestroyIoRing (
+    POS_IO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine closes an I/O ring and unmaps its shared memory. Operations
+    still in flight are canceled.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Ring->Handle != INVALID_HANDLE) {
+        OsClose(Ring->Handle);
+        Ring->Handle = INVALID_HANDLE;
+    }
+
+    if (Ring->Header != NULL) {
+        OsMemoryUnmap(Ring->Header, Ring->Size);
+        Ring->Header = NULL;
+    }
+
+    return;
+}
+
+OS_API
+PIO_RING_SUBMISSION
+OsGetIoRingSubmission (
+    POS_IO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the next free submission entry in an I/O ring. The
+    caller fills it in, and it is handed to the kernel by the next call to
+    submit.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    Returns a pointer to the submission entry.
+
+    NULL if the submission queue is full.
+
+--*/
+
+{
+
+    PIO_RING_HEADER Header;
+    PIO_RING_SUBMISSION Submission;
+
+    Header = Ring->Header;
+    if ((Ring->SubmissionTail - Header->SubmissionHead) >
+        Header->SubmissionMask) {
+
+        return NULL;
+    }
+
+    Submission = &(Ring->Submissions[Ring->SubmissionTail &
+                                     Header->SubmissionMask]);
+
+    Ring->SubmissionTail += 1;
+    RtlZeroMemory(Submission, sizeof(IO_RING_SUBMISSION));
+    return Submission;
+}
+
+OS_API
+KSTATUS
+OsSubmitIoRing (
+    POS_IO_RING Ring,
+    ULONG WaitCount,
+    ULONG TimeoutInMilliseconds,
+    PULONG SubmittedCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hands the submission entries filled in since the last call
+    to the kernel, and optionally waits for completions. For rings with a
+    kernel polling thread, the kernel is only entered if the thread needs
+    waking or the caller wants to wait.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+    WaitCount - Supplies the number of entries that must be in the completion
+        queue before this routine returns. Supply zero to not wait.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait for
+        completions. Use SYS_WAIT_TIME_INDEFINITE to wait forever.
+
+    SubmittedCount - Supplies an optional pointer where the number of entries
+        the kernel consumed during the call will be returned. This is always
+        zero for polled rings.
+
+Return Value:
+
+    Status code. STATUS_TIMEOUT is returned if fewer than the requested
+    number of completions arrived in time.
+
+--*/
+
+{
+
+    ULONG Flags;
+    PIO_RING_HEADER Header;
+    SYSTEM_CALL_ENTER_IO_RING Parameters;
+    INTN Result;
+
+    Header = Ring->Header;
+    Flags = 0;
+
+    //
+    // Make the entries visible before the tail that covers them.
+    //
+
+    RtlMemoryBarrier();
+    Header->SubmissionTail = Ring->SubmissionTail;
+    if (SubmittedCount != NULL) {
+        *SubmittedCount = 0;
+    }
+
+    if ((Ring->Flags & IO_RING_FLAG_KERNEL_POLL) != 0) {
+        RtlMemoryBarrier();
+        if ((Header->Flags & IO_RING_STATE_NEED_WAKE) != 0) {
+            Flags |= IO_RING_ENTER_FLAG_WAKE;
+
+        } else if (WaitCount == 0) {
+            return STATUS_SUCCESS;
+        }
+    }
+
+    Parameters.Ring = Ring->Handle;
+    Parameters.SubmitCount = Ring->SubmissionTail - Header->SubmissionHead;
+    Parameters.WaitCount = WaitCount;
+    Parameters.Flags = Flags;
+    Parameters.TimeoutInMilliseconds = TimeoutInMilliseconds;
+    Result = OsSystemCall(SystemCallEnterIoRing, &Parameters);
+    if (Result < 0) {
+        return Result;
+    }
+
+    if (SubmittedCount != NULL) {
+        *SubmittedCount = (ULONG)Result;
+    }
+
+    //
+    // If submissions were consumed, the wait outcome is not reported, so
+    // check it here.
+    //
+
+    if ((Result != 0) && (OsGetIoRingCompletionCount(Ring) < WaitCount)) {
+        return STATUS_TIMEOUT;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+OS_API
+ULONG
+OsGetIoRingCompletionCount (
+    POS_IO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the number of entries waiting in an I/O ring's
+    completion queue.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    Returns the number of completions that can be reaped.
+
+--*/
+
+{
+
+    ULONG Count;
+    PIO_RING_HEADER Header;
+
+    Header = Ring->Header;
+    Count = Header->CompletionTail - Header->CompletionHead;
+
+    //
+    // Read the entries only after seeing the tail that covers them.
+    //
+
+    RtlMemoryBarrier();
+    return Count;
+}
+
+OS_API
+PIO_RING_COMPLETION
+OsGetIoRingCompletion (
+    POS_IO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the oldest entry in an I/O ring's completion queue
+    without removing it.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    Returns a pointer to the completion entry. It remains valid until the
+    completion queue is advanced past it.
+
+    NULL if the completion queue is empty.
+
+--*/
+
+{
+
+    PIO_RING_HEADER Header;
+
+    if (OsGetIoRingCompletionCount(Ring) == 0) {
+        return NULL;
+    }
+
+    Header = Ring->Header;
+    return &(Ring->Completions[Header->CompletionHead &
+                               Header->CompletionMask]);
+}
+
+OS_API
+VOID
+OsAdvanceIoRingCompletions (
+    POS_IO_RING Ring,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes entries from an I/O ring's completion queue once
+    the caller is done with them, freeing the slots for the kernel.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+    Count - Supplies the number of completions to remove.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // Finish reading the entries before handing their slots back.
+    //
+
+    RtlMemoryBarrier();
+    Ring->Header->CompletionHead += Count;
+    return;
+}
+
 OS_API
 PSIGNAL_HANDLER_ROUTINE
 OsSetSignalHandler (
@@ -3144,6 +4489,72 @@ Return Value:
     return Status;
 }
 
+OS_API
+KSTATUS
+OsSetIoPriority (
+    IO_PRIORITY_REQUEST Request,
+    PROCESS_ID Id,
+    PULONG NewValue,
+    PULONG OldValue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the I/O priority of a process or thread.
+
+Arguments:
+
+    Request - Supplies whether to get or set the I/O priority of a process or
+        a thread.
+
+    Id - Supplies the process or thread ID. Supply -1 to use the current
+        process or thread. Threads must belong to the current process.
+
+    NewValue - Supplies an optional pointer to the new I/O priority to set. If
+        this is NULL, then a new value is not set. See IO_PRIORITY_*
+        definitions.
+
+    OldValue - Supplies an optional pointer where the previous I/O priority
+        will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the request type or priority is not valid.
+
+    STATUS_NO_SUCH_PROCESS or STATUS_NO_SUCH_THREAD if the ID was not found.
+
+    STATUS_PERMISSION_DENIED if the caller is trying to set the real time
+    class or another process' priority and does not have the scheduling
+    permission.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SET_IO_PRIORITY Parameters;
+    KSTATUS Status;
+
+    Parameters.Request = Request;
+    Parameters.Id = Id;
+    Parameters.Set = FALSE;
+    Parameters.Priority = 0;
+    if (NewValue != NULL) {
+        Parameters.Set = TRUE;
+        Parameters.Priority = *NewValue;
+    }
+
+    Status = OsSystemCall(SystemCallSetIoPriority, &Parameters);
+    if ((KSUCCESS(Status)) && (OldValue != NULL)) {
+        *OldValue = Parameters.Priority;
+    }
+
+    return Status;
+}
+
 OS_API
 KSTATUS
 OsCreateTerminal (
@@ -435,6 +435,66 @@ Return Value:
     return OsSystemCall(SystemCallSocketPerformVectoredIo, &Request);
 }
 
+OS_API
+KSTATUS
+OsSocketPerformBatchIo (
+    HANDLE Socket,
+    PSOCKET_IO_MESSAGE Messages,
+    UINTN MessageCount,
+    ULONG Flags,
+    PUINTN MessagesCompleted
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives several socket messages with a single
+    system call.
+
+Arguments:
+
+    Socket - Supplies the socket handle.
+
+    Messages - Supplies an array of messages. Each message's parameters say
+        whether it is sent or received, and are updated on return for the
+        messages that completed.
+
+    MessageCount - Supplies the number of messages in the array.
+
+    Flags - Supplies a bitfield of flags. See SYS_SOCKET_BATCH_FLAG_*
+        definitions.
+
+    MessagesCompleted - Supplies a pointer where the number of messages that
+        completed will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one message completed.
+
+    Otherwise, the error status of the first message.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO Request;
+    INTN Result;
+
+    Request.Socket = Socket;
+    Request.Messages = Messages;
+    Request.MessageCount = MessageCount;
+    Request.Flags = Flags;
+    Result = OsSystemCall(SystemCallSocketPerformBatchIo, &Request);
+    if (Result < 0) {
+        *MessagesCompleted = 0;
+        return Result;
+    }
+
+    *MessagesCompleted = (UINTN)Result;
+    return STATUS_SUCCESS;
+}
+
 OS_API
 KSTATUS
 OsSocketGetSetInformation (
@@ -543,6 +543,65 @@ Return Value:
     return TotalBytesWritten;
 }
 
+ssize_t
+SetupCopy (
+    PVOID Destination,
+    PVOID Source,
+    size_t ByteCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one open handle directly to another,
+    starting at each one's current position, without staging it in a buffer.
+    This is only possible if the operating system supports it for the two
+    handles.
+
+Arguments:
+
+    Destination - Supplies the handle to write to.
+
+    Source - Supplies the handle to read from.
+
+    ByteCount - Supplies the maximum number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which is zero at the end of the source.
+
+    -1 on failure, and errno will contain more information. ENOSYS, EXDEV,
+    and EINVAL indicate that a direct copy is not possible and the caller
+    should read and write the data itself.
+
+--*/
+
+{
+
+    PSETUP_HANDLE DestinationHandle;
+    PSETUP_HANDLE SourceHandle;
+
+    DestinationHandle = Destination;
+    SourceHandle = Source;
+
+    //
+    // Cached handles track their own file positions, so the data has to go
+    // through the cache.
+    //
+
+    if ((DestinationHandle->Cached != FALSE) ||
+        (SourceHandle->Cached != FALSE)) {
+
+        errno = ENOSYS;
+        return -1;
+    }
+
+    return SetupOsCopy(DestinationHandle->Handle,
+                       SourceHandle->Handle,
+                       ByteCount);
+}
+
 LONGLONG
 SetupSeek (
     PVOID Handle,
@@ -916,6 +916,63 @@ Return Value:
     return (ssize_t)BytesComplete;
 }
 
+ssize_t
+SetupFileCopy (
+    PVOID Destination,
+    PVOID Source,
+    size_t ByteCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one open file directly to another, starting at
+    each one's current position, without staging it in a buffer. This is only
+    possible if the operating system supports it for the two handles.
+
+Arguments:
+
+    Destination - Supplies the handle to write to.
+
+    Source - Supplies the handle to read from.
+
+    ByteCount - Supplies the maximum number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which is zero at the end of the source.
+
+    -1 on failure, and errno will contain more information. ENOSYS, EXDEV,
+    and EINVAL indicate that a direct copy is not possible and the caller
+    should read and write the data itself.
+
+--*/
+
+{
+
+    PSETUP_FILE DestinationFile;
+    PSETUP_FILE SourceFile;
+
+    DestinationFile = Destination;
+    SourceFile = Source;
+
+    //
+    // Only native files can be copied directly. Files inside an image go
+    // through the FAT library.
+    //
+
+    if ((DestinationFile->Volume->DestinationType !=
+         SetupDestinationDirectory) ||
+        (SourceFile->Volume->DestinationType != SetupDestinationDirectory)) {
+
+        errno = ENOSYS;
+        return -1;
+    }
+
+    return SetupCopy(DestinationFile->Handle, SourceFile->Handle, ByteCount);
+}
+
 LONGLONG
 SetupFileSeek (
     PVOID Handle,
@@ -1230,6 +1287,7 @@ Return Value:
                                        SETUP_DIRECTORY_ENTRY_SIZE,
                                        TRUE,
                                        FALSE,
+                                       0,
                                        NULL,
                                        &BytesRead,
                                        &ElementsRead);
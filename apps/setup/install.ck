@@ -108,6 +108,7 @@ var DriverFiles = [
     "sd.drv",
     "smsc95xx.drv",
     "special.drv",
+    "tmpfs.drv",
     "usbcomp.drv",
     "usbcore.drv",
     "usbhub.drv",
@@ -498,6 +499,7 @@ if (plat == "install-armv6") {
         "smsc95xx.drv",
         "spb.drv",
         "special.drv",
+        "tmpfs.drv",
         "tps65217.drv",
         "tzdata",
         "tzdflt",
@@ -624,6 +626,7 @@ if (plat == "install-armv7") {
         "smsc95xx.drv",
         "spb.drv",
         "special.drv",
+        "tmpfs.drv",
         "tps65217.drv",
         "tzdata",
         "tzdflt",
@@ -733,6 +736,7 @@ if (plat == "install-x86") {
         "ser16550.drv",
         "smsc95xx.drv",
         "special.drv",
+        "tmpfs.drv",
         "tzdata",
         "tzdflt",
         "uhci.drv",
@@ -1002,6 +1006,7 @@ if (plat == "pc-tiny") {
         "part.drv",
         "pci.drv",
         "special.drv",
+        "tmpfs.drv",
         "usrinput.drv",
         "videocon.drv",
         "ata.drv",
@@ -373,6 +373,65 @@ Return Value:
     return (ssize_t)BytesCompleted;
 }
 
+ssize_t
+SetupOsCopy (
+    PVOID Destination,
+    PVOID Source,
+    size_t ByteCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one open handle directly to another,
+    starting at each one's current position, without staging it in a buffer.
+    This is only possible if the operating system supports it for the two
+    handles.
+
+Arguments:
+
+    Destination - Supplies the handle to write to.
+
+    Source - Supplies the handle to read from.
+
+    ByteCount - Supplies the maximum number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which is zero at the end of the source.
+
+    -1 on failure, and errno will contain more information. ENOSYS, EXDEV,
+    and EINVAL indicate that a direct copy is not possible and the caller
+    should read and write the data itself.
+
+--*/
+
+{
+
+    UINTN BytesCompleted;
+    PSETUP_OS_HANDLE DestinationHandle;
+    PSETUP_OS_HANDLE SourceHandle;
+    KSTATUS Status;
+
+    DestinationHandle = Destination;
+    SourceHandle = Source;
+    Status = OsCopyFileRange(DestinationHandle->Handle,
+                             NULL,
+                             SourceHandle->Handle,
+                             NULL,
+                             ByteCount,
+                             0,
+                             &BytesCompleted);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (ssize_t)BytesCompleted;
+}
+
 LONGLONG
 SetupOsSeek (
     PVOID Handle,
@@ -308,6 +308,46 @@ Return Value:
     return BytesWritten;
 }
 
+ssize_t
+SetupOsCopy (
+    PVOID Destination,
+    PVOID Source,
+    size_t ByteCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one open handle directly to another,
+    starting at each one's current position, without staging it in a buffer.
+    This is only possible if the operating system supports it for the two
+    handles.
+
+Arguments:
+
+    Destination - Supplies the handle to write to.
+
+    Source - Supplies the handle to read from.
+
+    ByteCount - Supplies the maximum number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which is zero at the end of the source.
+
+    -1 on failure, and errno will contain more information. ENOSYS, EXDEV,
+    and EINVAL indicate that a direct copy is not possible and the caller
+    should read and write the data itself.
+
+--*/
+
+{
+
+    errno = ENOSYS;
+    return -1;
+}
+
 LONGLONG
 SetupOsSeek (
     PVOID Handle,
@@ -47,6 +47,13 @@ Module Name:
 
 #define SETUP_FILE_BUFFER_SIZE (1024 * 512)
 
+//
+// Define the number of bytes to ask the OS to copy at a time when it can copy
+// directly between files.
+//
+
+#define SETUP_FILE_COPY_SIZE (1024 * 1024 * 8)
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -1001,7 +1008,37 @@ Return Value:
         }
 
         //
-        // Loop copying chunks.
+        // Let the OS copy the data directly between the files if it can.
+        //
+
+        while (FileSize != 0) {
+            Size = SETUP_FILE_COPY_SIZE;
+            if (Size > FileSize) {
+                Size = FileSize;
+            }
+
+            Size = SetupFileCopy(DestinationFile, SourceFile, Size);
+            if (Size <= 0) {
+                if ((Size < 0) &&
+                    (errno != ENOSYS) && (errno != EXDEV) &&
+                    (errno != EINVAL)) {
+
+                    Result = errno;
+                    fprintf(stderr,
+                            "Failed to copy to file %s.\n",
+                            DestinationPath);
+
+                    goto CopyFileEnd;
+                }
+
+                break;
+            }
+
+            FileSize -= Size;
+        }
+
+        //
+        // Loop copying whatever chunks remain.
         //
 
         while (FileSize != 0) {
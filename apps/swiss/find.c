@@ -494,7 +494,8 @@ INT
 FindExecuteSearch (
     PFIND_CONTEXT Context,
     PSTR Path,
-    BOOL FromCommandLine
+    BOOL FromCommandLine,
+    struct stat *KnownStat
     );
 
 INT
@@ -651,7 +652,7 @@ Return Value:
 
     if (Context.InputCount == 0) {
         Context.RootDevice = -1;
-        Result = FindExecuteSearch(&Context, ".", TRUE);
+        Result = FindExecuteSearch(&Context, ".", TRUE, NULL);
         if (Result != 0) {
             goto FindMainEnd;
         }
@@ -671,7 +672,7 @@ Return Value:
 
             assert(Context.SearchedDirectoryCount == 0);
 
-            Result = FindExecuteSearch(&Context, Argument, TRUE);
+            Result = FindExecuteSearch(&Context, Argument, TRUE, NULL);
             if (Result != 0) {
                 goto FindMainEnd;
             }
@@ -712,7 +713,8 @@ INT
 FindExecuteSearch (
     PFIND_CONTEXT Context,
     PSTR Path,
-    BOOL FromCommandLine
+    BOOL FromCommandLine,
+    struct stat *KnownStat
     )
 
 /*++
@@ -731,6 +733,9 @@ Routine Description:
         coming directly from the command line (TRUE) or from a recursion
         (FALSE).
 
+    KnownStat - Supplies an optional pointer to the lstat information for the
+        path, if the caller already has it from reading the directory.
+
 Return Value:
 
     Returns an integer exit code. 0 for success, nonzero otherwise.
@@ -745,6 +750,8 @@ Return Value:
     DIR *Directory;
     struct dirent Entry;
     struct dirent *EntryPointer;
+    struct stat EntryStat;
+    int EntryStatValid;
     BOOL FollowLinks;
     BOOL Prune;
     INT Result;
@@ -766,7 +773,21 @@ Return Value:
         }
     }
 
-    Result = SwStat(Path, FollowLinks, &Stat);
+    //
+    // Use the information that came with the directory entry unless it is a
+    // link that needs following.
+    //
+
+    if ((KnownStat != NULL) &&
+        ((FollowLinks == FALSE) || (!S_ISLNK(KnownStat->st_mode)))) {
+
+        memcpy(&Stat, KnownStat, sizeof(struct stat));
+        Result = 0;
+
+    } else {
+        Result = SwStat(Path, FollowLinks, &Stat);
+    }
+
     if (Result != 0) {
         SwPrintError(Result, Path, "Unable to stat");
         goto FindExecuteSearchEnd;
@@ -848,7 +869,12 @@ Return Value:
     //
 
     while (TRUE) {
-        Result = SwReadDirectory(Directory, &Entry, &EntryPointer);
+        Result = SwReadDirectoryPlus(Directory,
+                                     &Entry,
+                                     &EntryPointer,
+                                     &EntryStat,
+                                     &EntryStatValid);
+
         if (Result != 0) {
             SwPrintError(Result, Path, "Unable to read directory");
             goto FindExecuteSearchEnd;
@@ -876,7 +902,16 @@ Return Value:
             goto FindExecuteSearchEnd;
         }
 
-        Result = FindExecuteSearch(Context, AppendedPath, FALSE);
+        if (EntryStatValid != 0) {
+            Result = FindExecuteSearch(Context,
+                                       AppendedPath,
+                                       FALSE,
+                                       &EntryStat);
+
+        } else {
+            Result = FindExecuteSearch(Context, AppendedPath, FALSE, NULL);
+        }
+
         free(AppendedPath);
         if (Result != 0) {
             goto FindExecuteSearchEnd;
@@ -799,6 +799,7 @@ Return Value:
     struct dirent *ReturnedPointer;
     struct stat Stat;
     struct stat *StatPointer;
+    int StatValid;
 
     FileArray = NULL;
     FileArrayCapacity = 0;
@@ -848,7 +849,12 @@ Return Value:
     //
 
     while (TRUE) {
-        Result = SwReadDirectory(Directory, &Entry, &ReturnedPointer);
+        Result = SwReadDirectoryPlus(Directory,
+                                     &Entry,
+                                     &ReturnedPointer,
+                                     &Stat,
+                                     &StatValid);
+
         if (Result != 0) {
             SwPrintError(Result, DirectoryPath, "Unable to read directory");
             goto ListDirectoryEnd;
@@ -885,8 +891,20 @@ Return Value:
             goto ListDirectoryEnd;
         }
 
+        //
+        // The directory read usually comes back with the lstat information
+        // already. Only go stat the file if it did not, or if it is a link
+        // that needs to be followed.
+        //
+
         LinkBroken = FALSE;
-        Result = SwStat(FullPath, FollowLinks, &Stat);
+        Result = 0;
+        if ((StatValid == 0) ||
+            ((FollowLinks != FALSE) && (S_ISLNK(Stat.st_mode)))) {
+
+            Result = SwStat(FullPath, FollowLinks, &Stat);
+        }
+
         if (Result == 0) {
             StatPointer = &Stat;
 
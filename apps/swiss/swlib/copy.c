@@ -51,6 +51,13 @@ Module Name:
 
 #define COPY_BLOCK_SIZE (1024 * 512)
 
+//
+// Define the number of bytes to ask the operating system to copy at a time
+// when it can copy directly between files.
+//
+
+#define COPY_RANGE_SIZE (1024 * 1024 * 8)
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -64,7 +71,8 @@ SwpCopy (
     BOOL IsOperand,
     ULONG Options,
     PSTR Source,
-    PSTR Destination
+    PSTR Destination,
+    struct stat *KnownSourceStat
     );
 
 INT
@@ -149,7 +157,7 @@ Return Value:
         OriginalMask = umask(0);
     }
 
-    Result = SwpCopy(TRUE, Options, Source, Destination);
+    Result = SwpCopy(TRUE, Options, Source, Destination, NULL);
     if ((Options & COPY_OPTION_PRESERVE_PERMISSIONS) != 0) {
         umask(OriginalMask);
     }
@@ -166,7 +174,8 @@ SwpCopy (
     BOOL IsOperand,
     ULONG Options,
     PSTR Source,
-    PSTR Destination
+    PSTR Destination,
+    struct stat *KnownSourceStat
     )
 
 /*++
@@ -190,6 +199,10 @@ Routine Description:
     Destination - Supplies a pointer to the string describing the destination of
         the copy.
 
+    KnownSourceStat - Supplies an optional pointer to the lstat information
+        for the source, if the caller already has it from reading the
+        directory.
+
 Return Value:
 
     0 on success.
@@ -209,6 +222,8 @@ Return Value:
     DIR *Directory;
     struct dirent DirectoryEntry;
     struct dirent *DirectoryEntryPointer;
+    struct stat EntryStat;
+    int EntryStatValid;
     BOOL FollowLinks;
     PSTR QuotedDestination;
     PSTR QuotedSource;
@@ -263,10 +278,17 @@ Return Value:
         goto CopyEnd;
     }
 
-    Status = SwStat(Source, FollowLinks, &SourceStat);
-    if (Status != 0) {
-        SwPrintError(Status, Source, "Cannot stat");
-        goto CopyEnd;
+    if ((KnownSourceStat != NULL) &&
+        ((FollowLinks == FALSE) || (!S_ISLNK(KnownSourceStat->st_mode)))) {
+
+        memcpy(&SourceStat, KnownSourceStat, sizeof(struct stat));
+
+    } else {
+        Status = SwStat(Source, FollowLinks, &SourceStat);
+        if (Status != 0) {
+            SwPrintError(Status, Source, "Cannot stat");
+            goto CopyEnd;
+        }
     }
 
     //
@@ -397,9 +419,11 @@ Return Value:
         }
 
         while (TRUE) {
-            Status = SwReadDirectory(Directory,
-                                     &DirectoryEntry,
-                                     &DirectoryEntryPointer);
+            Status = SwReadDirectoryPlus(Directory,
+                                         &DirectoryEntry,
+                                         &DirectoryEntryPointer,
+                                         &EntryStat,
+                                         &EntryStatValid);
 
             if (Status != 0) {
                 SwPrintError(Status, Source, "Failed to read directory");
@@ -451,10 +475,20 @@ Return Value:
                 goto CopyEnd;
             }
 
-            Status = SwpCopy(FALSE,
-                             Options,
-                             AppendedSource,
-                             AppendedDestination);
+            if (EntryStatValid != 0) {
+                Status = SwpCopy(FALSE,
+                                 Options,
+                                 AppendedSource,
+                                 AppendedDestination,
+                                 &EntryStat);
+
+            } else {
+                Status = SwpCopy(FALSE,
+                                 Options,
+                                 AppendedSource,
+                                 AppendedDestination,
+                                 NULL);
+            }
 
             if (Status != 0) {
                 SwPrintError(Status, Source, "Bailing out of");
@@ -613,6 +647,7 @@ Return Value:
 
     BOOL Answer;
     PVOID Buffer;
+    ssize_t BytesCopied;
     ssize_t BytesRead;
     ssize_t BytesWritten;
     int CloseStatus;
@@ -623,19 +658,11 @@ Return Value:
     int SourceFile;
     ssize_t TotalBytesWritten;
 
+    Buffer = NULL;
     DestinationFile = -1;
     Result = 0;
     SourceFile = -1;
 
-    //
-    // Allocate a buffer to store the file information.
-    //
-
-    Buffer = malloc(COPY_BLOCK_SIZE);
-    if (Buffer == NULL) {
-        goto CopyRegularFileEnd;
-    }
-
     //
     // If the destination file exists and the interactive option is on,
     // prompt.
@@ -714,56 +741,84 @@ Return Value:
     }
 
     //
-    // Repeatedly copy blocks from the source file to the destination file.
+    // Have the operating system copy the data directly between the files if
+    // it can.
     //
 
-    while (TRUE) {
-        do {
-            BytesRead = read(SourceFile, Buffer, COPY_BLOCK_SIZE);
+    do {
+        BytesCopied = SwCopyFileRange(SourceFile,
+                                      DestinationFile,
+                                      COPY_RANGE_SIZE);
 
-        } while ((BytesRead < 0) && (errno == EINTR));
-
-        //
-        // Stop if the read failed.
-        //
+    } while ((BytesCopied > 0) || ((BytesCopied < 0) && (errno == EINTR)));
 
-        if (BytesRead < 0) {
+    if (BytesCopied < 0) {
+        if ((errno != ENOSYS) && (errno != EXDEV) && (errno != EINVAL)) {
             Result = errno;
-            break;
+            SwPrintError(Result, Destination, "Failed to write to");
+            goto CopyRegularFileEnd;
         }
 
         //
-        // Stop at the end of the file.
+        // Otherwise, repeatedly copy blocks from the source file to the
+        // destination file, picking up wherever the direct copy left off.
         //
 
-        if (BytesRead == 0) {
-            break;
+        Buffer = malloc(COPY_BLOCK_SIZE);
+        if (Buffer == NULL) {
+            Result = ENOMEM;
+            SwPrintError(Result, NULL, "Failed to allocate buffer");
+            goto CopyRegularFileEnd;
         }
 
-        //
-        // Write this bunch in.
-        //
-
-        TotalBytesWritten = 0;
-        while (TotalBytesWritten < BytesRead) {
+        while (TRUE) {
             do {
-                BytesWritten = write(DestinationFile,
-                                     Buffer + TotalBytesWritten,
-                                     BytesRead - TotalBytesWritten);
+                BytesRead = read(SourceFile, Buffer, COPY_BLOCK_SIZE);
 
-            } while ((BytesWritten <= 0) && (errno == EINTR));
+            } while ((BytesRead < 0) && (errno == EINTR));
 
             //
-            // Stop if the write failed.
+            // Stop if the read failed.
             //
 
-            if (BytesWritten <= 0) {
+            if (BytesRead < 0) {
                 Result = errno;
-                SwPrintError(Result, Destination, "Failed to write to");
-                goto CopyRegularFileEnd;
+                break;
             }
 
-            TotalBytesWritten += BytesWritten;
+            //
+            // Stop at the end of the file.
+            //
+
+            if (BytesRead == 0) {
+                break;
+            }
+
+            //
+            // Write this bunch in.
+            //
+
+            TotalBytesWritten = 0;
+            while (TotalBytesWritten < BytesRead) {
+                do {
+                    BytesWritten = write(DestinationFile,
+                                         Buffer + TotalBytesWritten,
+                                         BytesRead - TotalBytesWritten);
+
+                } while ((BytesWritten <= 0) && (errno == EINTR));
+
+                //
+                // Stop if the write failed.
+                //
+
+                if (BytesWritten <= 0) {
+                    Result = errno;
+                    SwPrintError(Result, Destination, "Failed to write to");
+                    goto CopyRegularFileEnd;
+                }
+
+                TotalBytesWritten += BytesWritten;
+            }
         }
     }
 
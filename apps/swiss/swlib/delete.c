@@ -57,6 +57,13 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+INT
+SwpDelete (
+    INT Options,
+    PSTR Argument,
+    struct stat *KnownStat
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -90,6 +97,44 @@ Return Value:
 
 --*/
 
+{
+
+    return SwpDelete(Options, Argument, NULL);
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+INT
+SwpDelete (
+    INT Options,
+    PSTR Argument,
+    struct stat *KnownStat
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes one file or directory, recursing into directories if
+    requested.
+
+Arguments:
+
+    Options - Supplies the application options.
+
+    Argument - Supplies the object to remove.
+
+    KnownStat - Supplies an optional pointer to the lstat information for the
+        object, if the caller already has it from reading the directory.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
 {
 
     BOOL Answer;
@@ -99,6 +144,8 @@ Return Value:
     DIR *Directory;
     BOOL DirectoryEmpty;
     struct dirent DirectoryEntry;
+    struct stat EntryStat;
+    int EntryStatValid;
     BOOL InvalidArgument;
     PSTR QuotedArgument;
     INT Result;
@@ -147,7 +194,14 @@ Return Value:
     // Get some information about this file.
     //
 
-    Result = SwStat(Argument, FALSE, &Stat);
+    Result = 0;
+    if (KnownStat != NULL) {
+        memcpy(&Stat, KnownStat, sizeof(struct stat));
+
+    } else {
+        Result = SwStat(Argument, FALSE, &Stat);
+    }
+
     if (Result != 0) {
         Result = errno;
         if (((Options & DELETE_OPTION_FORCE) == 0) || (Result != ENOENT)) {
@@ -229,9 +283,11 @@ Return Value:
 
         DirectoryEmpty = TRUE;
         while (TRUE) {
-            Result = SwReadDirectory(Directory,
-                                     &DirectoryEntry,
-                                     &ReturnedPointer);
+            Result = SwReadDirectoryPlus(Directory,
+                                         &DirectoryEntry,
+                                         &ReturnedPointer,
+                                         &EntryStat,
+                                         &EntryStatValid);
 
             if (Result != 0) {
                 SwPrintError(Result, Argument, "Cannot read directory");
@@ -297,7 +353,13 @@ Return Value:
                     goto RemoveEnd;
                 }
 
-                Result = SwDelete(Options, AppendedPath);
+                if (EntryStatValid != 0) {
+                    Result = SwpDelete(Options, AppendedPath, &EntryStat);
+
+                } else {
+                    Result = SwpDelete(Options, AppendedPath, NULL);
+                }
+
                 free(AppendedPath);
                 AppendedPath = NULL;
                 if (Result != 0) {
@@ -309,9 +371,11 @@ Return Value:
             // Move on to the next directory entry.
             //
 
-            Result = SwReadDirectory(Directory,
-                                     &DirectoryEntry,
-                                     &ReturnedPointer);
+            Result = SwReadDirectoryPlus(Directory,
+                                         &DirectoryEntry,
+                                         &ReturnedPointer,
+                                         &EntryStat,
+                                         &EntryStatValid);
 
             if (Result != 0) {
                 SwPrintError(Result, Argument, "Cannot read directory");
@@ -443,7 +507,3 @@ Return Value:
     return Result;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
-
@@ -31,7 +31,10 @@ Module Name:
 //
 
 #include <assert.h>
+#include <dirent.h>
 #include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <minoca/lib/minocaos.h>
@@ -284,6 +287,109 @@ Return Value:
     return closefrom(Descriptor);
 }
 
+int
+SwReadDirectoryPlus (
+    DIR *Directory,
+    struct dirent *Buffer,
+    struct dirent **Result,
+    struct stat *Stat,
+    int *StatValid
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the next entry from a directory along with the status
+    information of the file it names, as lstat would return it. Where the
+    operating system can do so, the information comes back in the same batch
+    as the names, saving a stat call per entry.
+
+Arguments:
+
+    Directory - Supplies a pointer to the structure returned by the open
+        directory function.
+
+    Buffer - Supplies the buffer where the next directory entry will be
+        returned.
+
+    Result - Supplies a pointer that will either be set to the Buffer pointer
+        if there are more entries, or NULL if there are no more entries in the
+        directory.
+
+    Stat - Supplies a pointer where the status information of the entry will
+        be returned if available.
+
+    StatValid - Supplies a pointer where a boolean will be returned indicating
+        whether the stat buffer was filled in. If not, the caller must stat
+        the entry itself.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    struct dirent *Entry;
+
+    *Result = NULL;
+    *StatValid = 0;
+    errno = 0;
+    Entry = readdirplus(Directory, Stat);
+    if (Entry == NULL) {
+        return errno;
+    }
+
+    memcpy(Buffer, Entry, sizeof(struct dirent));
+    *Result = Buffer;
+    *StatValid = 1;
+    return 0;
+}
+
+ssize_t
+SwCopyFileRange (
+    int SourceFile,
+    int DestinationFile,
+    size_t Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine asks the operating system to copy data from one open file to
+    another directly, without staging it in a user mode buffer. The copy
+    starts at each file's current position and advances both.
+
+Arguments:
+
+    SourceFile - Supplies the file descriptor to read from.
+
+    DestinationFile - Supplies the file descriptor to write to.
+
+    Size - Supplies the maximum number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which may be less than requested.
+
+    0 at the end of the source file.
+
+    -1 on failure, and errno will be set to contain more information. ENOSYS,
+    EXDEV, and EINVAL indicate that the caller should fall back to reading and
+    writing the data itself.
+
+--*/
+
+{
+
+    return copy_file_range(SourceFile, NULL, DestinationFile, NULL, Size, 0);
+}
+
 int
 SwResetSystem (
     SWISS_REBOOT_TYPE RebootType
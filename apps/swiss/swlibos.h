@@ -1126,6 +1126,85 @@ Return Value:
 
 --*/
 
+int
+SwReadDirectoryPlus (
+    DIR *Directory,
+    struct dirent *Buffer,
+    struct dirent **Result,
+    struct stat *Stat,
+    int *StatValid
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads the next entry from a directory along with the status
+    information of the file it names, as lstat would return it. Where the
+    operating system can do so, the information comes back in the same batch
+    as the names, saving a stat call per entry.
+
+Arguments:
+
+    Directory - Supplies a pointer to the structure returned by the open
+        directory function.
+
+    Buffer - Supplies the buffer where the next directory entry will be
+        returned.
+
+    Result - Supplies a pointer that will either be set to the Buffer pointer
+        if there are more entries, or NULL if there are no more entries in the
+        directory.
+
+    Stat - Supplies a pointer where the status information of the entry will
+        be returned if available.
+
+    StatValid - Supplies a pointer where a boolean will be returned indicating
+        whether the stat buffer was filled in. If not, the caller must stat
+        the entry itself.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+ssize_t
+SwCopyFileRange (
+    int SourceFile,
+    int DestinationFile,
+    size_t Size    );
+
+/*++
+
+Routine Description:
+
+    This routine asks the operating system to copy data from one open file to
+    another directly, without staging it in a user mode buffer. The copy
+    starts at each file's current position and advances both.
+
+Arguments:
+
+    SourceFile - Supplies the file descriptor to read from.
+
+    DestinationFile - Supplies the file descriptor to write to.
+
+    Size - Supplies the maximum number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which may be less than requested.
+
+    0 at the end of the source file.
+
+    -1 on failure, and errno will be set to contain more information. ENOSYS,
+    EXDEV, and EINVAL indicate that the caller should fall back to reading and
+    writing the data itself.
+
+--*/
+
 int
 SwMakeDirectory (
     const char *Path,
@@ -31,9 +31,13 @@ function build() {
         "create.c",
         "dlopen.c",
         "dup.c",
+        "epoll.c",
         "getppid.c",
         "exec.c",
+        "flock.c",
         "fork.c",
+        "ioprio.c",
+        "ioring.c",
         "malloc.c",
         "mmap.c",
         "mutex.c",
@@ -44,7 +48,9 @@ function build() {
         "pthread.c",
         "read.c",
         "rename.c",
+        "sendfile.c",
         "stat.c",
+        "unixsock.c",
         "write.c"
     ];
 
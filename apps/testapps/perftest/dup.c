@@ -30,7 +30,10 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+#include <assert.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #include "perftest.h"
@@ -39,18 +42,52 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+#define PT_DUP_TEST_THREAD_COUNT 8
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure defines the state of a thread in the contended dup test.
+
+Members:
+
+    Iterations - Stores the number of iterations the thread completed.
+
+    Status - Stores the error number the thread failed with, if any.
+
+--*/
+
+typedef struct _PT_DUP_THREAD {
+    unsigned long long Iterations;
+    int Status;
+} PT_DUP_THREAD, *PPT_DUP_THREAD;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+void *
+DupStartRoutine (
+    void *Parameter
+    );
+
+int
+DupLoop (
+    unsigned long long *Iterations
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
+volatile int DupReadyThreadCount;
+pthread_mutex_t DupReadyLock = PTHREAD_MUTEX_INITIALIZER;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -65,7 +102,9 @@ DupMain (
 
 Routine Description:
 
-    This routine performs the dup performance benchmark test.
+    This routine performs the dup performance benchmark tests. The contended
+    variant runs the same loop on several threads at once, all sharing the
+    process' descriptor table, and reports the total number of iterations.
 
 Arguments:
 
@@ -82,13 +121,69 @@ Return Value:
 
 {
 
-    int FileDescriptor;
     unsigned long long Iterations;
     int Status;
+    int ThreadCount;
+    int ThreadIndex;
+    pthread_t *Threads;
+    PPT_DUP_THREAD ThreadStates;
 
     Iterations = 0;
     Result->Type = PtResultIterations;
     Result->Status = 0;
+    ThreadIndex = 0;
+    Threads = NULL;
+    ThreadStates = NULL;
+    DupReadyThreadCount = 0;
+
+    //
+    // Initialize the given test state.
+    //
+
+    switch (Test->TestType) {
+    case PtTestDup:
+        break;
+
+    case PtTestDupContended:
+        Threads = malloc(sizeof(pthread_t) * PT_DUP_TEST_THREAD_COUNT);
+        ThreadStates = calloc(PT_DUP_TEST_THREAD_COUNT, sizeof(PT_DUP_THREAD));
+        if ((Threads == NULL) || (ThreadStates == NULL)) {
+            Result->Status = ENOMEM;
+            goto MainEnd;
+        }
+
+        for (ThreadIndex = 0;
+             ThreadIndex < PT_DUP_TEST_THREAD_COUNT;
+             ThreadIndex += 1) {
+
+            Status = pthread_create(&(Threads[ThreadIndex]),
+                                    NULL,
+                                    DupStartRoutine,
+                                    &(ThreadStates[ThreadIndex]));
+
+            if (Status != 0) {
+                Result->Status = Status;
+                goto MainEnd;
+            }
+        }
+
+        //
+        // Wait until all threads are spun up.
+        //
+
+        while (DupReadyThreadCount != PT_DUP_TEST_THREAD_COUNT) {
+            sleep(1);
+        }
+
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
 
     //
     // Start the test. This snaps resource usage and starts the clock ticking.
@@ -100,33 +195,36 @@ Return Value:
         goto MainEnd;
     }
 
+    Result->Status = DupLoop(&Iterations);
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+
     //
-    // Measure the performance of the dup() C library routine by counting the
-    // number of times standard out can be duplicated and closed.
+    // Tear down the test state, collecting the other threads' iterations.
     //
 
-    while (PtIsTimedTestRunning() != 0) {
-        FileDescriptor = dup(STDOUT_FILENO);
-        if (FileDescriptor < 0) {
-            Result->Status = errno;
-            break;
+    if (Threads != NULL) {
+        ThreadCount = ThreadIndex;
+        for (ThreadIndex = 0; ThreadIndex < ThreadCount; ThreadIndex += 1) {
+            pthread_cancel(Threads[ThreadIndex]);
+            pthread_join(Threads[ThreadIndex], NULL);
+            Iterations += ThreadStates[ThreadIndex].Iterations;
+            if (Result->Status == 0) {
+                Result->Status = ThreadStates[ThreadIndex].Status;
+            }
         }
 
-        Status = close(FileDescriptor);
-        if (Status != 0) {
-            Result->Status = errno;
-            break;
-        }
-
-        Iterations += 1;
+        free(Threads);
     }
 
-    Status = PtFinishTimedTest(Result);
-    if ((Status != 0) && (Result->Status == 0)) {
-        Result->Status = errno;
+    if (ThreadStates != NULL) {
+        free(ThreadStates);
     }
 
-MainEnd:
     Result->Data.Iterations = Iterations;
     return;
 }
@@ -135,3 +233,97 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+void *
+DupStartRoutine (
+    void *Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the start routine for a contended dup test thread.
+    It waits for the test to start and then runs the dup loop.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the thread's state.
+
+Return Value:
+
+    Returns the NULL pointer.
+
+--*/
+
+{
+
+    PPT_DUP_THREAD State;
+
+    State = (PPT_DUP_THREAD)Parameter;
+
+    //
+    // Announce that the thread is ready.
+    //
+
+    pthread_mutex_lock(&DupReadyLock);
+    DupReadyThreadCount += 1;
+    pthread_mutex_unlock(&DupReadyLock);
+
+    //
+    // Busy spin waiting for the test to start.
+    //
+
+    while (PtIsTimedTestRunning() == 0) {
+        pthread_testcancel();
+    }
+
+    State->Status = DupLoop(&(State->Iterations));
+    return NULL;
+}
+
+int
+DupLoop (
+    unsigned long long *Iterations
+    )
+
+/*++
+
+Routine Description:
+
+    This routine measures the performance of the dup() C library routine by
+    counting the number of times standard out can be duplicated and closed
+    while the test is running.
+
+Arguments:
+
+    Iterations - Supplies a pointer that is incremented for each iteration.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    int FileDescriptor;
+    int Status;
+
+    while (PtIsTimedTestRunning() != 0) {
+        FileDescriptor = dup(STDOUT_FILENO);
+        if (FileDescriptor < 0) {
+            return errno;
+        }
+
+        Status = close(FileDescriptor);
+        if (Status != 0) {
+            return errno;
+        }
+
+        *Iterations += 1;
+    }
+
+    return 0;
+}
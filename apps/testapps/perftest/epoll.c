@@ -0,0 +1,308 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    epoll.c
+
+Abstract:
+
+    This module implements the performance benchmark tests that compare how
+    poll and epoll scale with the number of idle descriptors being watched.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the number of idle pipes watched by the small and large tests.
+//
+
+#define PT_EPOLL_SMALL_IDLE_COUNT 10
+#define PT_EPOLL_LARGE_IDLE_COUNT 1000
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+EpollMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the poll and epoll scaling benchmark tests. Each
+    iteration makes one pipe readable, waits for it among a set of idle pipes,
+    and drains it.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int ActiveRead;
+    int ActiveWrite;
+    ssize_t BytesCompleted;
+    char Character;
+    int EpollDescriptor;
+    struct epoll_event Event;
+    int IdleCount;
+    int Index;
+    unsigned long long Iterations;
+    int *Pipes;
+    int PipeCount;
+    struct pollfd *PollDescriptors;
+    int Status;
+    int UseEpoll;
+
+    Character = 0;
+    EpollDescriptor = -1;
+    Iterations = 0;
+    Pipes = NULL;
+    PipeCount = 0;
+    PollDescriptors = NULL;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+    switch (Test->TestType) {
+    case PtTestPollSmall:
+        IdleCount = PT_EPOLL_SMALL_IDLE_COUNT;
+        UseEpoll = 0;
+        break;
+
+    case PtTestPollLarge:
+        IdleCount = PT_EPOLL_LARGE_IDLE_COUNT;
+        UseEpoll = 0;
+        break;
+
+    case PtTestEpollSmall:
+        IdleCount = PT_EPOLL_SMALL_IDLE_COUNT;
+        UseEpoll = 1;
+        break;
+
+    case PtTestEpollLarge:
+        IdleCount = PT_EPOLL_LARGE_IDLE_COUNT;
+        UseEpoll = 1;
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
+
+    //
+    // Create the idle pipes plus one active pipe, which goes last so that poll
+    // has to scan past every idle descriptor to find it.
+    //
+
+    Pipes = malloc(sizeof(int) * 2 * (IdleCount + 1));
+    if (Pipes == NULL) {
+        Result->Status = ENOMEM;
+        goto MainEnd;
+    }
+
+    for (PipeCount = 0; PipeCount < IdleCount + 1; PipeCount += 1) {
+        Status = pipe(&(Pipes[PipeCount * 2]));
+        if (Status != 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+    }
+
+    ActiveRead = Pipes[IdleCount * 2];
+    ActiveWrite = Pipes[(IdleCount * 2) + 1];
+    if (UseEpoll != 0) {
+        EpollDescriptor = epoll_create1(0);
+        if (EpollDescriptor < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        for (Index = 0; Index < PipeCount; Index += 1) {
+            Event.events = EPOLLIN;
+            Event.data.fd = Pipes[Index * 2];
+            Status = epoll_ctl(EpollDescriptor,
+                               EPOLL_CTL_ADD,
+                               Pipes[Index * 2],
+                               &Event);
+
+            if (Status != 0) {
+                Result->Status = errno;
+                goto MainEnd;
+            }
+        }
+
+    } else {
+        PollDescriptors = malloc(sizeof(struct pollfd) * PipeCount);
+        if (PollDescriptors == NULL) {
+            Result->Status = ENOMEM;
+            goto MainEnd;
+        }
+
+        for (Index = 0; Index < PipeCount; Index += 1) {
+            PollDescriptors[Index].fd = Pipes[Index * 2];
+            PollDescriptors[Index].events = POLLIN;
+            PollDescriptors[Index].revents = 0;
+        }
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure how quickly a single ready descriptor can be found among the
+    // idle ones.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        do {
+            BytesCompleted = write(ActiveWrite, &Character, 1);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted != 1) {
+            Result->Status = errno;
+            break;
+        }
+
+        if (UseEpoll != 0) {
+            do {
+                Status = epoll_wait(EpollDescriptor, &Event, 1, -1);
+
+            } while ((Status < 0) && (errno == EINTR));
+
+            if ((Status != 1) || (Event.data.fd != ActiveRead)) {
+                Result->Status = errno;
+                if (Result->Status == 0) {
+                    Result->Status = EIO;
+                }
+
+                break;
+            }
+
+        } else {
+            do {
+                Status = poll(PollDescriptors, PipeCount, -1);
+
+            } while ((Status < 0) && (errno == EINTR));
+
+            if ((Status != 1) ||
+                ((PollDescriptors[IdleCount].revents & POLLIN) == 0)) {
+
+                Result->Status = errno;
+                if (Result->Status == 0) {
+                    Result->Status = EIO;
+                }
+
+                break;
+            }
+        }
+
+        do {
+            BytesCompleted = read(ActiveRead, &Character, 1);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted != 1) {
+            Result->Status = errno;
+            break;
+        }
+
+        Iterations += 1;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (EpollDescriptor >= 0) {
+        close(EpollDescriptor);
+    }
+
+    if (PollDescriptors != NULL) {
+        free(PollDescriptors);
+    }
+
+    if (Pipes != NULL) {
+        for (Index = 0; Index < PipeCount; Index += 1) {
+            close(Pipes[Index * 2]);
+            close(Pipes[(Index * 2) + 1]);
+        }
+
+        free(Pipes);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
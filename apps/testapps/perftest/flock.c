@@ -0,0 +1,319 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    flock.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for byte-range file
+    locks. A child process holds thousands of record locks on a file while the
+    foreground repeatedly releases and retakes its own records in between.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_FILE_LOCK_FILE_NAME_LENGTH 48
+#define PT_FILE_LOCK_RECORD_COUNT 4096
+#define PT_FILE_LOCK_RECORD_SIZE 64
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+int
+PtpFileLockRecord (
+    int FileDescriptor,
+    short Type,
+    int Record,
+    int Odd
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+FileLockMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the file lock benchmark test. The file's records are
+    interleaved between a child process, which holds read locks on the odd
+    records, and the foreground, which holds write locks on the even records.
+    The result is the number of unlock and relock pairs the foreground
+    completed on randomly chosen even records.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ssize_t BytesRead;
+    pid_t Child;
+    char FileName[PT_FILE_LOCK_FILE_NAME_LENGTH];
+    int FileCreated;
+    int FileDescriptor;
+    unsigned long long Iterations;
+    int Pipe[2];
+    char Ready;
+    int Record;
+    unsigned int Seed;
+    int Status;
+
+    Child = -1;
+    FileCreated = 0;
+    FileDescriptor = -1;
+    Iterations = 0;
+    Pipe[0] = -1;
+    Pipe[1] = -1;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+    snprintf(FileName,
+             PT_FILE_LOCK_FILE_NAME_LENGTH,
+             "flock_%d.txt",
+             getpid());
+
+    FileDescriptor = open(FileName,
+                          O_RDWR | O_CREAT | O_TRUNC,
+                          S_IRUSR | S_IWUSR);
+
+    if (FileDescriptor < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileCreated = 1;
+    if (pipe(Pipe) != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Fire up the child that holds the odd records. It reports in once all
+    // its locks are held, and then sits on them until it is killed.
+    //
+
+    Child = fork();
+    if (Child < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    if (Child == 0) {
+        close(Pipe[0]);
+        for (Record = 0; Record < PT_FILE_LOCK_RECORD_COUNT; Record += 1) {
+            Status = PtpFileLockRecord(FileDescriptor, F_RDLCK, Record, 1);
+            if (Status != 0) {
+                exit(Status);
+            }
+        }
+
+        Ready = 1;
+        write(Pipe[1], &Ready, sizeof(Ready));
+        while (1) {
+            pause();
+        }
+    }
+
+    close(Pipe[1]);
+    Pipe[1] = -1;
+    do {
+        BytesRead = read(Pipe[0], &Ready, sizeof(Ready));
+
+    } while ((BytesRead < 0) && (errno == EINTR));
+
+    if (BytesRead != sizeof(Ready)) {
+        Result->Status = errno;
+        if (Result->Status == 0) {
+            Result->Status = ECHILD;
+        }
+
+        goto MainEnd;
+    }
+
+    for (Record = 0; Record < PT_FILE_LOCK_RECORD_COUNT; Record += 1) {
+        Status = PtpFileLockRecord(FileDescriptor, F_WRLCK, Record, 0);
+        if (Status != 0) {
+            Result->Status = Status;
+            goto MainEnd;
+        }
+    }
+
+    //
+    // Get a thread-safe seed for the random number generator.
+    //
+
+    Seed = time(NULL);
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure how quickly a record can be released and retaken. Retaking the
+    // write lock has to check it against the child's neighboring read locks.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        Record = rand_r(&Seed) % PT_FILE_LOCK_RECORD_COUNT;
+        Status = PtpFileLockRecord(FileDescriptor, F_UNLCK, Record, 0);
+        if (Status == 0) {
+            Status = PtpFileLockRecord(FileDescriptor, F_WRLCK, Record, 0);
+        }
+
+        if (Status != 0) {
+            Result->Status = Status;
+            break;
+        }
+
+        Iterations += 1;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Child > 0) {
+        kill(Child, SIGKILL);
+        waitpid(Child, NULL, 0);
+    }
+
+    if (Pipe[0] >= 0) {
+        close(Pipe[0]);
+    }
+
+    if (Pipe[1] >= 0) {
+        close(Pipe[1]);
+    }
+
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+    }
+
+    if (FileCreated != 0) {
+        remove(FileName);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+int
+PtpFileLockRecord (
+    int FileDescriptor,
+    short Type,
+    int Record,
+    int Odd
+    )
+
+/*++
+
+Routine Description:
+
+    This routine locks or unlocks one record of the benchmark file.
+
+Arguments:
+
+    FileDescriptor - Supplies the open file descriptor.
+
+    Type - Supplies the lock type: F_RDLCK, F_WRLCK, or F_UNLCK.
+
+    Record - Supplies the index of the record among the even or odd records.
+
+    Odd - Supplies a boolean indicating whether to operate on the odd records
+        (non-zero) or the even records (zero).
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    struct flock Lock;
+
+    memset(&Lock, 0, sizeof(Lock));
+    Lock.l_type = Type;
+    Lock.l_whence = SEEK_SET;
+    Lock.l_start = ((Record * 2) + (Odd != 0)) * PT_FILE_LOCK_RECORD_SIZE;
+    Lock.l_len = PT_FILE_LOCK_RECORD_SIZE;
+    if (fcntl(FileDescriptor, F_SETLK, &Lock) != 0) {
+        return errno;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,438 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    ioprio.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for I/O priority
+    classes. A background process streams writes to disk while the foreground
+    measures how many small synchronous reads it can complete.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_IO_PRIORITY_FILE_NAME_LENGTH 48
+#define PT_IO_PRIORITY_READ_FILE_SIZE (8 * 1024 * 1024)
+#define PT_IO_PRIORITY_READ_SIZE 4096
+#define PT_IO_PRIORITY_STREAM_FILE_SIZE (32 * 1024 * 1024)
+#define PT_IO_PRIORITY_STREAM_SIZE (256 * 1024)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+int
+PtpIoPriorityCreateFile (
+    char *FileName,
+    char *Buffer,
+    size_t BufferSize,
+    size_t FileSize
+    );
+
+void
+PtpIoPriorityStream (
+    char *FileName,
+    int IdleClass
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+IoPriorityMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the I/O priority benchmark tests. The result is the
+    number of small direct reads the foreground completed while a background
+    process streamed writes to the same disk.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char *Buffer;
+    ssize_t BytesRead;
+    pid_t Child;
+    int FileDescriptor;
+    int IdleClass;
+    unsigned long long Iterations;
+    off_t Offset;
+    pid_t ProcessId;
+    char ReadFileName[PT_IO_PRIORITY_FILE_NAME_LENGTH];
+    int ReadFileCreated;
+    int Status;
+    char StreamFileName[PT_IO_PRIORITY_FILE_NAME_LENGTH];
+
+    Buffer = NULL;
+    Child = -1;
+    FileDescriptor = -1;
+    IdleClass = 0;
+    if (Test->TestType == PtTestIoPriorityIdle) {
+        IdleClass = 1;
+    }
+
+    Iterations = 0;
+    ReadFileCreated = 0;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+
+    //
+    // Direct I/O requires a sector aligned buffer.
+    //
+
+    Status = posix_memalign((void **)&Buffer,
+                            PT_IO_PRIORITY_READ_SIZE,
+                            PT_IO_PRIORITY_STREAM_SIZE);
+
+    if (Status != 0) {
+        Buffer = NULL;
+        Result->Status = Status;
+        goto MainEnd;
+    }
+
+    memset(Buffer, 'a', PT_IO_PRIORITY_STREAM_SIZE);
+    ProcessId = getpid();
+    snprintf(ReadFileName,
+             PT_IO_PRIORITY_FILE_NAME_LENGTH,
+             "ioprio_read_%d.txt",
+             ProcessId);
+
+    snprintf(StreamFileName,
+             PT_IO_PRIORITY_FILE_NAME_LENGTH,
+             "ioprio_stream_%d.txt",
+             ProcessId);
+
+    //
+    // Create the file the foreground reads from and get it onto the disk.
+    //
+
+    Status = PtpIoPriorityCreateFile(ReadFileName,
+                                     Buffer,
+                                     PT_IO_PRIORITY_STREAM_SIZE,
+                                     PT_IO_PRIORITY_READ_FILE_SIZE);
+
+    if (Status != 0) {
+        Result->Status = Status;
+        goto MainEnd;
+    }
+
+    ReadFileCreated = 1;
+    FileDescriptor = open(ReadFileName, O_RDONLY | O_DIRECT);
+    if (FileDescriptor < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Fire up the background streamer.
+    //
+
+    Child = fork();
+    if (Child < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    if (Child == 0) {
+        close(FileDescriptor);
+        PtpIoPriorityStream(StreamFileName, IdleClass);
+        exit(0);
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure foreground latency by counting the number of small reads that
+    // make it through to the disk while the streamer runs. The offsets stride
+    // through the file so the reads do not get serviced sequentially.
+    //
+
+    Offset = 0;
+    while (PtIsTimedTestRunning() != 0) {
+        BytesRead = pread(FileDescriptor,
+                          Buffer,
+                          PT_IO_PRIORITY_READ_SIZE,
+                          Offset);
+
+        if (BytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        Offset += PT_IO_PRIORITY_READ_SIZE * 97;
+        Offset %= PT_IO_PRIORITY_READ_FILE_SIZE;
+        Iterations += 1;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Child > 0) {
+        kill(Child, SIGKILL);
+        waitpid(Child, NULL, 0);
+        remove(StreamFileName);
+    }
+
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+    }
+
+    if (ReadFileCreated != 0) {
+        remove(ReadFileName);
+    }
+
+    if (Buffer != NULL) {
+        free(Buffer);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+int
+PtpIoPriorityCreateFile (
+    char *FileName,
+    char *Buffer,
+    size_t BufferSize,
+    size_t FileSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a file of the given size and flushes it to disk.
+
+Arguments:
+
+    FileName - Supplies a pointer to the name of the file to create.
+
+    Buffer - Supplies a pointer to the data to fill the file with.
+
+    BufferSize - Supplies the size of the buffer in bytes.
+
+    FileSize - Supplies the desired size of the file in bytes.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    ssize_t BytesWritten;
+    int FileDescriptor;
+    int Result;
+    size_t TotalBytes;
+
+    FileDescriptor = open(FileName,
+                          O_RDWR | O_CREAT | O_TRUNC,
+                          S_IRUSR | S_IWUSR);
+
+    if (FileDescriptor < 0) {
+        return errno;
+    }
+
+    Result = 0;
+    TotalBytes = 0;
+    while (TotalBytes < FileSize) {
+        do {
+            BytesWritten = write(FileDescriptor, Buffer, BufferSize);
+
+        } while ((BytesWritten < 0) && (errno == EINTR));
+
+        if (BytesWritten <= 0) {
+            Result = errno;
+            if (Result == 0) {
+                Result = EIO;
+            }
+
+            break;
+        }
+
+        TotalBytes += BytesWritten;
+    }
+
+    if ((Result == 0) && (fsync(FileDescriptor) != 0)) {
+        Result = errno;
+    }
+
+    close(FileDescriptor);
+    if (Result != 0) {
+        remove(FileName);
+    }
+
+    return Result;
+}
+
+void
+PtpIoPriorityStream (
+    char *FileName,
+    int IdleClass
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the background streamer. It repeatedly rewrites a
+    large file and flushes it to disk until it is killed.
+
+Arguments:
+
+    FileName - Supplies a pointer to the name of the file to stream to.
+
+    IdleClass - Supplies a boolean indicating whether the streamer should
+        drop itself into the idle I/O priority class.
+
+Return Value:
+
+    None. This routine only returns on failure.
+
+--*/
+
+{
+
+    char *Buffer;
+    ssize_t BytesWritten;
+    int FileDescriptor;
+    int Status;
+    size_t TotalBytes;
+
+    if (IdleClass != 0) {
+        Status = ioprio_set(IOPRIO_WHO_PROCESS,
+                            0,
+                            IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
+
+        if (Status != 0) {
+            return;
+        }
+    }
+
+    Buffer = malloc(PT_IO_PRIORITY_STREAM_SIZE);
+    if (Buffer == NULL) {
+        return;
+    }
+
+    memset(Buffer, 'b', PT_IO_PRIORITY_STREAM_SIZE);
+    FileDescriptor = open(FileName,
+                          O_WRONLY | O_CREAT | O_TRUNC,
+                          S_IRUSR | S_IWUSR);
+
+    if (FileDescriptor < 0) {
+        free(Buffer);
+        return;
+    }
+
+    while (1) {
+        lseek(FileDescriptor, 0, SEEK_SET);
+        TotalBytes = 0;
+        while (TotalBytes < PT_IO_PRIORITY_STREAM_FILE_SIZE) {
+            BytesWritten = write(FileDescriptor,
+                                 Buffer,
+                                 PT_IO_PRIORITY_STREAM_SIZE);
+
+            if (BytesWritten < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                goto StreamEnd;
+            }
+
+            TotalBytes += BytesWritten;
+        }
+
+        fsync(FileDescriptor);
+    }
+
+StreamEnd:
+    close(FileDescriptor);
+    free(Buffer);
+    return;
+}
+
@@ -0,0 +1,318 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    ioring.c
+
+Abstract:
+
+    This module implements the performance benchmark tests that read a cached
+    file through an I/O ring, in batches that cost one system call each, or
+    with a kernel thread polling the ring so that no system calls are made
+    while it is busy. Compare the results with the read test, which makes one
+    system call per block.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/lib/minocaos.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <minoca/lib/mlibc.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_IO_RING_TEST_FILE_NAME_LENGTH 48
+#define PT_IO_RING_TEST_FILE_SIZE (2 * 1024 * 1024)
+#define PT_IO_RING_TEST_BLOCK_SIZE 4096
+#define PT_IO_RING_TEST_BATCH_SIZE 32
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+IoRingMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the I/O ring read benchmark tests. Each iteration
+    submits a batch of block reads from a cached file and reaps their
+    completions.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char *Buffer;
+    UINTN BufferSize;
+    ssize_t BytesWritten;
+    PIO_RING_COMPLETION Completion;
+    int FileCreated;
+    int FileDescriptor;
+    char FileName[PT_IO_RING_TEST_FILE_NAME_LENGTH];
+    HANDLE FileHandle;
+    ULONG Flags;
+    int Index;
+    off_t Offset;
+    pid_t ProcessId;
+    OS_IO_RING Ring;
+    int RingCreated;
+    int Status;
+    PIO_RING_SUBMISSION Submission;
+    unsigned long long TotalBytes;
+
+    FileCreated = 0;
+    FileDescriptor = -1;
+    RingCreated = 0;
+    Result->Type = PtResultBytes;
+    Result->Status = 0;
+    TotalBytes = 0;
+    switch (Test->TestType) {
+    case PtTestIoRingRead:
+        Flags = 0;
+        break;
+
+    case PtTestIoRingReadPolled:
+        Flags = IO_RING_FLAG_KERNEL_POLL;
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
+
+    //
+    // Each read in a batch gets its own block of the buffer. Polled rings can
+    // only refer to registered memory, so the buffer is registered with the
+    // ring in both cases.
+    //
+
+    BufferSize = PT_IO_RING_TEST_BLOCK_SIZE * PT_IO_RING_TEST_BATCH_SIZE;
+    Buffer = malloc(BufferSize);
+    if (Buffer == NULL) {
+        Result->Status = ENOMEM;
+        goto MainEnd;
+    }
+
+    //
+    // Create a process safe file and fill it so that the test measures
+    // reading from the system's cache.
+    //
+
+    ProcessId = getpid();
+    Status = snprintf(FileName,
+                      PT_IO_RING_TEST_FILE_NAME_LENGTH,
+                      "ioring_%d.txt",
+                      ProcessId);
+
+    if (Status < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileDescriptor = open(FileName,
+                          O_RDWR | O_CREAT | O_TRUNC,
+                          S_IRUSR | S_IWUSR);
+
+    if (FileDescriptor < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileCreated = 1;
+    for (Index = 0;
+         Index < (PT_IO_RING_TEST_FILE_SIZE / BufferSize);
+         Index += 1) {
+
+        do {
+            BytesWritten = write(FileDescriptor, Buffer, BufferSize);
+
+        } while ((BytesWritten < 0) && (errno == EINTR));
+
+        if (BytesWritten != BufferSize) {
+            Result->Status = errno;
+            if (Result->Status == 0) {
+                Result->Status = EIO;
+            }
+
+            goto MainEnd;
+        }
+    }
+
+    FileHandle = (HANDLE)(UINTN)FileDescriptor;
+    Status = OsCreateIoRing(SYS_OPEN_FLAG_CLOSE_ON_EXECUTE,
+                            Flags,
+                            PT_IO_RING_TEST_BATCH_SIZE,
+                            0,
+                            Buffer,
+                            BufferSize,
+                            &FileHandle,
+                            1,
+                            &Ring);
+
+    if (!KSUCCESS(Status)) {
+        Result->Status = ClConvertKstatusToErrorNumber(Status);
+        goto MainEnd;
+    }
+
+    RingCreated = 1;
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure how many bytes can be read through the ring, starting over at
+    // the beginning of the file whenever the end is reached.
+    //
+
+    Offset = 0;
+    while (PtIsTimedTestRunning() != 0) {
+        for (Index = 0; Index < PT_IO_RING_TEST_BATCH_SIZE; Index += 1) {
+            Submission = OsGetIoRingSubmission(&Ring);
+
+            assert(Submission != NULL);
+
+            Submission->Operation = IoRingOperationRead;
+            Submission->Flags = IO_RING_SUBMISSION_FLAG_REGISTERED_HANDLE |
+                                IO_RING_SUBMISSION_FLAG_REGISTERED_BUFFER;
+
+            Submission->Handle = (HANDLE)0;
+            Submission->Offset = Offset;
+            Submission->Buffer = (PVOID)(UINTN)(Index *
+                                                PT_IO_RING_TEST_BLOCK_SIZE);
+
+            Submission->Size = PT_IO_RING_TEST_BLOCK_SIZE;
+            Submission->UserData = Index;
+            Offset += PT_IO_RING_TEST_BLOCK_SIZE;
+            if (Offset >= PT_IO_RING_TEST_FILE_SIZE) {
+                Offset = 0;
+            }
+        }
+
+        do {
+            Status = OsSubmitIoRing(&Ring,
+                                    PT_IO_RING_TEST_BATCH_SIZE,
+                                    SYS_WAIT_TIME_INDEFINITE,
+                                    NULL);
+
+        } while (Status == STATUS_INTERRUPTED);
+
+        if (!KSUCCESS(Status)) {
+            Result->Status = ClConvertKstatusToErrorNumber(Status);
+            break;
+        }
+
+        for (Index = 0; Index < PT_IO_RING_TEST_BATCH_SIZE; Index += 1) {
+            Completion = OsGetIoRingCompletion(&Ring);
+
+            assert(Completion != NULL);
+
+            if (!KSUCCESS(Completion->Status)) {
+                Result->Status = ClConvertKstatusToErrorNumber(
+                                                          Completion->Status);
+
+                break;
+            }
+
+            TotalBytes += Completion->Result;
+            OsAdvanceIoRingCompletions(&Ring, 1);
+        }
+
+        if (Result->Status != 0) {
+            break;
+        }
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (RingCreated != 0) {
+        OsDestroyIoRing(&Ring);
+    }
+
+    if (FileCreated != 0) {
+        close(FileDescriptor);
+        remove(FileName);
+    }
+
+    if (Buffer != NULL) {
+        free(Buffer);
+    }
+
+    Result->Data.Bytes = TotalBytes;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -30,10 +30,12 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -44,19 +46,79 @@ Module Name:
 //
 
 #define PT_OPEN_TEST_FILE_NAME_LENGTH 48
+#define PT_OPEN_TEST_THREAD_COUNT 8
+
+//
+// Define the number of extra files the large directory variant fills its
+// shared directory with.
+//
+
+#define PT_OPEN_TEST_DIRECTORY_FILE_COUNT 1024
 
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure defines the state of a thread in the open tests.
+
+Members:
+
+    FileName - Stores the name of the file this thread opens and closes.
+
+    FileCreated - Stores a boolean indicating whether the file was created.
+
+    Iterations - Stores the number of iterations the thread completed.
+
+    Status - Stores the error number the thread failed with, if any.
+
+--*/
+
+typedef struct _PT_OPEN_THREAD {
+    char FileName[PT_OPEN_TEST_FILE_NAME_LENGTH];
+    int FileCreated;
+    unsigned long long Iterations;
+    int Status;
+} PT_OPEN_THREAD, *PPT_OPEN_THREAD;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+void *
+OpenStartRoutine (
+    void *Parameter
+    );
+
+int
+OpenLoop (
+    char *FileName,
+    unsigned long long *Iterations
+    );
+
+int
+OpenPopulateDirectory (
+    char *DirectoryName,
+    int FileCount,
+    int *FilesCreated
+    );
+
+void
+OpenDestroyDirectory (
+    char *DirectoryName,
+    int FileCount
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
+volatile int OpenReadyThreadCount;
+pthread_mutex_t OpenReadyLock = PTHREAD_MUTEX_INITIALIZER;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -71,7 +133,11 @@ OpenMain (
 
 Routine Description:
 
-    This routine performs the open performance benchmark test.
+    This routine performs the open performance benchmark tests. The contended
+    variant runs the same loop on several threads at once, each opening its
+    own file, and reports the total number of iterations. The large directory
+    variant does the same with all of the files in one shared directory that
+    holds many other entries.
 
 Arguments:
 
@@ -88,41 +154,140 @@ Return Value:
 
 {
 
-    int FileCreated;
+    char DirectoryName[PT_OPEN_TEST_FILE_NAME_LENGTH];
     int FileDescriptor;
-    char FileName[PT_OPEN_TEST_FILE_NAME_LENGTH];
+    int FillerCount;
     unsigned long long Iterations;
     pid_t ProcessId;
     int Status;
+    int StateCount;
+    int ThreadCount;
+    int ThreadIndex;
+    pthread_t *Threads;
+    PPT_OPEN_THREAD ThreadStates;
 
-    FileCreated = 0;
     Iterations = 0;
     Result->Type = PtResultIterations;
     Result->Status = 0;
+    ThreadCount = 0;
+    Threads = NULL;
+    OpenReadyThreadCount = 0;
+    DirectoryName[0] = '\0';
+    FillerCount = 0;
+    switch (Test->TestType) {
+    case PtTestOpen:
+        StateCount = 1;
+        break;
+
+    case PtTestOpenContended:
+    case PtTestOpenLargeDirectory:
+        StateCount = PT_OPEN_TEST_THREAD_COUNT;
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
 
     //
-    // Get the process ID and create a process safe file to open and close.
+    // The first state belongs to this thread.
     //
 
-    ProcessId = getpid();
-    Status = snprintf(FileName,
-                      PT_OPEN_TEST_FILE_NAME_LENGTH,
-                      "open_%d.txt",
-                      ProcessId);
+    ThreadStates = calloc(StateCount, sizeof(PT_OPEN_THREAD));
+    if (StateCount > 1) {
+        Threads = malloc(sizeof(pthread_t) * (StateCount - 1));
+    }
 
-    if (Status < 0) {
-        Result->Status = errno;
+    if ((ThreadStates == NULL) || ((StateCount > 1) && (Threads == NULL))) {
+        Result->Status = ENOMEM;
         goto MainEnd;
     }
 
-    FileDescriptor = creat(FileName, S_IRUSR | S_IWUSR);
-    if (FileDescriptor < 0) {
-        Result->Status = errno;
-        goto MainEnd;
+    //
+    // Get the process ID and create a process safe file for each thread to
+    // open and close. Separate files keep the threads from contending on a
+    // single file object, which is what most open-heavy workloads look like.
+    //
+
+    ProcessId = getpid();
+    if (Test->TestType == PtTestOpenLargeDirectory) {
+        Status = snprintf(DirectoryName,
+                          PT_OPEN_TEST_FILE_NAME_LENGTH,
+                          "open_%d",
+                          ProcessId);
+
+        if (Status < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        Result->Status = OpenPopulateDirectory(
+                                             DirectoryName,
+                                             PT_OPEN_TEST_DIRECTORY_FILE_COUNT,
+                                             &FillerCount);
+
+        if (Result->Status != 0) {
+            goto MainEnd;
+        }
+    }
+
+    for (ThreadIndex = 0; ThreadIndex < StateCount; ThreadIndex += 1) {
+        if (DirectoryName[0] != '\0') {
+            Status = snprintf(ThreadStates[ThreadIndex].FileName,
+                              PT_OPEN_TEST_FILE_NAME_LENGTH,
+                              "%s/thread_%d.txt",
+                              DirectoryName,
+                              ThreadIndex);
+
+        } else {
+            Status = snprintf(ThreadStates[ThreadIndex].FileName,
+                              PT_OPEN_TEST_FILE_NAME_LENGTH,
+                              "open_%d_%d.txt",
+                              ProcessId,
+                              ThreadIndex);
+        }
+
+        if (Status < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        FileDescriptor = creat(ThreadStates[ThreadIndex].FileName,
+                               S_IRUSR | S_IWUSR);
+
+        if (FileDescriptor < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        close(FileDescriptor);
+        ThreadStates[ThreadIndex].FileCreated = 1;
+    }
+
+    //
+    // Spin up the other threads and wait until they are all ready.
+    //
+
+    for (ThreadIndex = 1; ThreadIndex < StateCount; ThreadIndex += 1) {
+        Status = pthread_create(&(Threads[ThreadIndex - 1]),
+                                NULL,
+                                OpenStartRoutine,
+                                &(ThreadStates[ThreadIndex]));
+
+        if (Status != 0) {
+            Result->Status = Status;
+            goto MainEnd;
+        }
+
+        ThreadCount += 1;
     }
 
-    close(FileDescriptor);
-    FileCreated = 1;
+    while (OpenReadyThreadCount != ThreadCount) {
+        sleep(1);
+    }
 
     //
     // Start the test. This snaps resource usage and starts the clock ticking.
@@ -134,42 +299,260 @@ Return Value:
         goto MainEnd;
     }
 
+    Result->Status = OpenLoop(ThreadStates[0].FileName, &Iterations);
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+
     //
-    // Measure the performance of the open() and close() C library routines by
-    // counting the number of times a file can be opened and closed.
+    // Tear down the test state, collecting the other threads' iterations.
     //
 
+    for (ThreadIndex = 0; ThreadIndex < ThreadCount; ThreadIndex += 1) {
+        pthread_cancel(Threads[ThreadIndex]);
+        pthread_join(Threads[ThreadIndex], NULL);
+        Iterations += ThreadStates[ThreadIndex + 1].Iterations;
+        if (Result->Status == 0) {
+            Result->Status = ThreadStates[ThreadIndex + 1].Status;
+        }
+    }
+
+    if (Threads != NULL) {
+        free(Threads);
+    }
+
+    if (ThreadStates != NULL) {
+        for (ThreadIndex = 0; ThreadIndex < StateCount; ThreadIndex += 1) {
+            if (ThreadStates[ThreadIndex].FileCreated != 0) {
+                remove(ThreadStates[ThreadIndex].FileName);
+            }
+        }
+
+        free(ThreadStates);
+    }
+
+    if (DirectoryName[0] != '\0') {
+        OpenDestroyDirectory(DirectoryName, FillerCount);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+void *
+OpenStartRoutine (
+    void *Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the start routine for a contended open test
+    thread. It waits for the test to start and then runs the open loop.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the thread's state.
+
+Return Value:
+
+    Returns the NULL pointer.
+
+--*/
+
+{
+
+    PPT_OPEN_THREAD State;
+
+    State = (PPT_OPEN_THREAD)Parameter;
+
+    //
+    // Announce that the thread is ready.
+    //
+
+    pthread_mutex_lock(&OpenReadyLock);
+    OpenReadyThreadCount += 1;
+    pthread_mutex_unlock(&OpenReadyLock);
+
+    //
+    // Busy spin waiting for the test to start.
+    //
+
+    while (PtIsTimedTestRunning() == 0) {
+        pthread_testcancel();
+    }
+
+    State->Status = OpenLoop(State->FileName, &(State->Iterations));
+    return NULL;
+}
+
+int
+OpenLoop (
+    char *FileName,
+    unsigned long long *Iterations
+    )
+
+/*++
+
+Routine Description:
+
+    This routine measures the performance of the open() and close() C library
+    routines by counting the number of times a file can be opened and closed
+    while the test is running.
+
+Arguments:
+
+    FileName - Supplies a pointer to the name of the file to open.
+
+    Iterations - Supplies a pointer that is incremented for each iteration.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    int FileDescriptor;
+    int Status;
+
     while (PtIsTimedTestRunning() != 0) {
         FileDescriptor = open(FileName, O_RDWR);
         if (FileDescriptor < 0) {
-            Result->Status = errno;
-            break;
+            return errno;
         }
 
         Status = close(FileDescriptor);
         if (Status != 0) {
-            Result->Status = errno;
-            break;
+            return errno;
         }
 
-        Iterations += 1;
+        *Iterations += 1;
     }
 
-    Status = PtFinishTimedTest(Result);
-    if ((Status != 0) && (Result->Status == 0)) {
-        Result->Status = errno;
+    return 0;
+}
+
+int
+OpenPopulateDirectory (
+    char *DirectoryName,
+    int FileCount,
+    int *FilesCreated
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a directory and fills it with empty files so that
+    the open tests can measure lookups in a directory with many entries.
+
+Arguments:
+
+    DirectoryName - Supplies the name of the directory to create.
+
+    FileCount - Supplies the number of files to create in the directory.
+
+    FilesCreated - Supplies a pointer where the number of files actually
+        created is returned, which should be handed to the destroy routine
+        even on failure.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    int FileDescriptor;
+    char FileName[PT_OPEN_TEST_FILE_NAME_LENGTH];
+    int FileIndex;
+    int Status;
+
+    *FilesCreated = 0;
+    Status = mkdir(DirectoryName, S_IRWXU);
+    if (Status != 0) {
+        return errno;
     }
 
-MainEnd:
-    if (FileCreated != 0) {
+    for (FileIndex = 0; FileIndex < FileCount; FileIndex += 1) {
+        Status = snprintf(FileName,
+                          PT_OPEN_TEST_FILE_NAME_LENGTH,
+                          "%s/file_%d.txt",
+                          DirectoryName,
+                          FileIndex);
+
+        if (Status < 0) {
+            return errno;
+        }
+
+        FileDescriptor = creat(FileName, S_IRUSR | S_IWUSR);
+        if (FileDescriptor < 0) {
+            return errno;
+        }
+
+        close(FileDescriptor);
+        *FilesCreated += 1;
+    }
+
+    return 0;
+}
+
+void
+OpenDestroyDirectory (
+    char *DirectoryName,
+    int FileCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a directory created by the populate routine, along
+    with the filler files in it. Any other files must already be removed.
+
+Arguments:
+
+    DirectoryName - Supplies the name of the directory to destroy.
+
+    FileCount - Supplies the number of filler files that were created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char FileName[PT_OPEN_TEST_FILE_NAME_LENGTH];
+    int FileIndex;
+
+    for (FileIndex = 0; FileIndex < FileCount; FileIndex += 1) {
+        snprintf(FileName,
+                 PT_OPEN_TEST_FILE_NAME_LENGTH,
+                 "%s/file_%d.txt",
+                 DirectoryName,
+                 FileIndex);
+
         remove(FileName);
     }
 
-    Result->Data.Iterations = Iterations;
+    rmdir(DirectoryName);
     return;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
-
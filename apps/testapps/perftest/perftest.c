@@ -218,6 +218,20 @@ PT_TEST_INFORMATION PerformanceTests[PtTestTypeCount] = {
      PtResultIterations,
      OPEN_TEST_DEFAULT_DURATION},
 
+    {OPEN_CONTENDED_TEST_NAME,
+     OPEN_CONTENDED_TEST_DESCRIPTION,
+     OpenMain,
+     PtTestOpenContended,
+     PtResultIterations,
+     OPEN_CONTENDED_TEST_DEFAULT_DURATION},
+
+    {OPEN_LARGE_DIRECTORY_TEST_NAME,
+     OPEN_LARGE_DIRECTORY_TEST_DESCRIPTION,
+     OpenMain,
+     PtTestOpenLargeDirectory,
+     PtResultIterations,
+     OPEN_LARGE_DIRECTORY_TEST_DEFAULT_DURATION},
+
     {CREATE_TEST_NAME,
      CREATE_TEST_DESCRIPTION,
      CreateMain,
@@ -232,6 +246,13 @@ PT_TEST_INFORMATION PerformanceTests[PtTestTypeCount] = {
      PtResultIterations,
      DUP_TEST_DEFAULT_DURATION},
 
+    {DUP_CONTENDED_TEST_NAME,
+     DUP_CONTENDED_TEST_DESCRIPTION,
+     DupMain,
+     PtTestDupContended,
+     PtResultIterations,
+     DUP_CONTENDED_TEST_DEFAULT_DURATION},
+
     {RENAME_TEST_NAME,
      RENAME_TEST_DESCRIPTION,
      RenameMain,
@@ -386,12 +407,124 @@ PT_TEST_INFORMATION PerformanceTests[PtTestTypeCount] = {
      PtResultIterations,
      STAT_TEST_DEFAULT_DURATION},
 
+    {STAT_LARGE_DIRECTORY_TEST_NAME,
+     STAT_LARGE_DIRECTORY_TEST_DESCRIPTION,
+     StatMain,
+     PtTestStatLargeDirectory,
+     PtResultIterations,
+     STAT_LARGE_DIRECTORY_TEST_DEFAULT_DURATION},
+
     {FSTAT_TEST_NAME,
      FSTAT_TEST_DESCRIPTION,
      FstatMain,
      PtTestFstat,
      PtResultIterations,
      FSTAT_TEST_DEFAULT_DURATION},
+
+    {POLL_SMALL_TEST_NAME,
+     POLL_SMALL_TEST_DESCRIPTION,
+     EpollMain,
+     PtTestPollSmall,
+     PtResultIterations,
+     POLL_SMALL_TEST_DEFAULT_DURATION},
+
+    {POLL_LARGE_TEST_NAME,
+     POLL_LARGE_TEST_DESCRIPTION,
+     EpollMain,
+     PtTestPollLarge,
+     PtResultIterations,
+     POLL_LARGE_TEST_DEFAULT_DURATION},
+
+    {EPOLL_SMALL_TEST_NAME,
+     EPOLL_SMALL_TEST_DESCRIPTION,
+     EpollMain,
+     PtTestEpollSmall,
+     PtResultIterations,
+     EPOLL_SMALL_TEST_DEFAULT_DURATION},
+
+    {EPOLL_LARGE_TEST_NAME,
+     EPOLL_LARGE_TEST_DESCRIPTION,
+     EpollMain,
+     PtTestEpollLarge,
+     PtResultIterations,
+     EPOLL_LARGE_TEST_DEFAULT_DURATION},
+
+    {SEND_FILE_TEST_NAME,
+     SEND_FILE_TEST_DESCRIPTION,
+     SendFileMain,
+     PtTestSendFile,
+     PtResultBytes,
+     SEND_FILE_TEST_DEFAULT_DURATION},
+
+    {READ_WRITE_SEND_TEST_NAME,
+     READ_WRITE_SEND_TEST_DESCRIPTION,
+     SendFileMain,
+     PtTestReadWriteSend,
+     PtResultBytes,
+     READ_WRITE_SEND_TEST_DEFAULT_DURATION},
+
+    {IO_RING_READ_TEST_NAME,
+     IO_RING_READ_TEST_DESCRIPTION,
+     IoRingMain,
+     PtTestIoRingRead,
+     PtResultBytes,
+     IO_RING_READ_TEST_DEFAULT_DURATION},
+
+    {IO_RING_READ_POLLED_TEST_NAME,
+     IO_RING_READ_POLLED_TEST_DESCRIPTION,
+     IoRingMain,
+     PtTestIoRingReadPolled,
+     PtResultBytes,
+     IO_RING_READ_POLLED_TEST_DEFAULT_DURATION},
+
+    {PIPE_IO_SPLICE_TEST_NAME,
+     PIPE_IO_SPLICE_TEST_DESCRIPTION,
+     PipeIoMain,
+     PtTestPipeIoSplice,
+     PtResultBytes,
+     PIPE_IO_SPLICE_TEST_DEFAULT_DURATION},
+
+    {UNIX_PING_PONG_TEST_NAME,
+     UNIX_PING_PONG_TEST_DESCRIPTION,
+     UnixSocketMain,
+     PtTestUnixPingPong,
+     PtResultIterations,
+     UNIX_PING_PONG_TEST_DEFAULT_DURATION},
+
+    {UNIX_STREAM_TEST_NAME,
+     UNIX_STREAM_TEST_DESCRIPTION,
+     UnixSocketMain,
+     PtTestUnixStream,
+     PtResultBytes,
+     UNIX_STREAM_TEST_DEFAULT_DURATION},
+
+    {UNIX_BATCH_TEST_NAME,
+     UNIX_BATCH_TEST_DESCRIPTION,
+     UnixSocketMain,
+     PtTestUnixBatch,
+     PtResultIterations,
+     UNIX_BATCH_TEST_DEFAULT_DURATION},
+
+    {IO_PRIORITY_TEST_NAME,
+     IO_PRIORITY_TEST_DESCRIPTION,
+     IoPriorityMain,
+     PtTestIoPriority,
+     PtResultIterations,
+     IO_PRIORITY_TEST_DEFAULT_DURATION},
+
+    {IO_PRIORITY_IDLE_TEST_NAME,
+     IO_PRIORITY_IDLE_TEST_DESCRIPTION,
+     IoPriorityMain,
+     PtTestIoPriorityIdle,
+     PtResultIterations,
+     IO_PRIORITY_IDLE_TEST_DEFAULT_DURATION},
+
+    {FILE_LOCK_TEST_NAME,
+     FILE_LOCK_TEST_DESCRIPTION,
+     FileLockMain,
+     PtTestFileLock,
+     PtResultIterations,
+     FILE_LOCK_TEST_DEFAULT_DURATION},
 };
 
 //
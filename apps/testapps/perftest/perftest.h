@@ -45,12 +45,24 @@ Module Name:
 #define OPEN_TEST_DESCRIPTION \
     "Benchmarks the open() and close() C library routines."
 
+#define OPEN_CONTENDED_TEST_NAME "open_contended"
+#define OPEN_CONTENDED_TEST_DESCRIPTION \
+    "Benchmarks open() and close() from many threads at once."
+
+#define OPEN_LARGE_DIRECTORY_TEST_NAME "open_large_dir"
+#define OPEN_LARGE_DIRECTORY_TEST_DESCRIPTION \
+    "Benchmarks open() and close() from many threads in one large directory."
+
 #define CREATE_TEST_NAME "create"
 #define CREATE_TEST_DESCRIPTION \
     "Benchmarks the create() and remove() C library routines."
 
 #define DUP_TEST_NAME "dup"
 #define DUP_TEST_DESCRIPTION "Benchmarks the dup() C library routine."
+#define DUP_CONTENDED_TEST_NAME "dup_contended"
+#define DUP_CONTENDED_TEST_DESCRIPTION \
+    "Benchmarks the dup() C library routine from many threads at once."
+
 #define RENAME_TEST_NAME "rename"
 #define RENAME_TEST_DESCRIPTION "Benchmakrs the rename() C library routine."
 #define GETPPID_TEST_NAME "getppid"
@@ -129,10 +141,74 @@ Module Name:
 #define STAT_TEST_DESCRIPTION \
     "Benchmarks the stat() C library routine."
 
+#define STAT_LARGE_DIRECTORY_TEST_NAME "stat_large_dir"
+#define STAT_LARGE_DIRECTORY_TEST_DESCRIPTION \
+    "Benchmarks stat() across the files of a large directory."
+
 #define FSTAT_TEST_NAME "fstat"
 #define FSTAT_TEST_DESCRIPTION \
     "Benchmarks the fstat() C library routine."
 
+#define POLL_SMALL_TEST_NAME "poll_small"
+#define POLL_SMALL_TEST_DESCRIPTION \
+    "Benchmarks poll() finding one ready pipe among 10 idle pipes."
+
+#define POLL_LARGE_TEST_NAME "poll_large"
+#define POLL_LARGE_TEST_DESCRIPTION \
+    "Benchmarks poll() finding one ready pipe among 1000 idle pipes."
+
+#define EPOLL_SMALL_TEST_NAME "epoll_small"
+#define EPOLL_SMALL_TEST_DESCRIPTION \
+    "Benchmarks epoll_wait() finding one ready pipe among 10 idle pipes."
+
+#define EPOLL_LARGE_TEST_NAME "epoll_large"
+#define EPOLL_LARGE_TEST_DESCRIPTION \
+    "Benchmarks epoll_wait() finding one ready pipe among 1000 idle pipes."
+
+#define SEND_FILE_TEST_NAME "sendfile"
+#define SEND_FILE_TEST_DESCRIPTION \
+    "Benchmarks sendfile() from a cached file to a socket."
+
+#define READ_WRITE_SEND_TEST_NAME "read_write_send"
+#define READ_WRITE_SEND_TEST_DESCRIPTION \
+    "Benchmarks a pread() and write() loop from a cached file to a socket."
+
+#define IO_RING_READ_TEST_NAME "ioring_read"
+#define IO_RING_READ_TEST_DESCRIPTION \
+    "Benchmarks batched reads from a cached file through an I/O ring."
+
+#define IO_RING_READ_POLLED_TEST_NAME "ioring_read_polled"
+#define IO_RING_READ_POLLED_TEST_DESCRIPTION \
+    "Benchmarks reads through an I/O ring polled by a kernel thread."
+
+#define PIPE_IO_SPLICE_TEST_NAME "pipe_io_splice"
+#define PIPE_IO_SPLICE_TEST_DESCRIPTION \
+    "Benchmarks vmsplice() and read() throughput through a large pipe."
+
+#define UNIX_PING_PONG_TEST_NAME "unix_ping_pong"
+#define UNIX_PING_PONG_TEST_DESCRIPTION \
+    "Benchmarks small message round trips over a Unix domain socket pair."
+
+#define UNIX_STREAM_TEST_NAME "unix_stream"
+#define UNIX_STREAM_TEST_DESCRIPTION \
+    "Benchmarks large send() throughput over a Unix domain socket pair."
+
+#define UNIX_BATCH_TEST_NAME "unix_batch"
+#define UNIX_BATCH_TEST_DESCRIPTION \
+    "Benchmarks sendmmsg() and recvmmsg() round trips of Unix datagrams."
+
+#define IO_PRIORITY_TEST_NAME "io_priority"
+#define IO_PRIORITY_TEST_DESCRIPTION \
+    "Benchmarks small direct reads while a default priority writer streams."
+
+#define IO_PRIORITY_IDLE_TEST_NAME "io_priority_idle"
+#define IO_PRIORITY_IDLE_TEST_DESCRIPTION \
+    "Benchmarks small direct reads while an idle priority writer streams."
+
+#define FILE_LOCK_TEST_NAME "file_lock"
+#define FILE_LOCK_TEST_DESCRIPTION \
+    "Benchmarks fcntl() record locks among thousands of held locks."
+
 //
 // Default test durations, in seconds.
 //
@@ -140,8 +216,11 @@ Module Name:
 #define FORK_TEST_DEFAULT_DURATION 60
 #define EXEC_TEST_DEFAULT_DURATION 60
 #define OPEN_TEST_DEFAULT_DURATION 30
+#define OPEN_CONTENDED_TEST_DEFAULT_DURATION 30
+#define OPEN_LARGE_DIRECTORY_TEST_DEFAULT_DURATION 30
 #define CREATE_TEST_DEFAULT_DURATION 30
 #define DUP_TEST_DEFAULT_DURATION 30
+#define DUP_CONTENDED_TEST_DEFAULT_DURATION 30
 #define RENAME_TEST_DEFAULT_DURATION 30
 #define GETPPID_TEST_DEFAULT_DURATION 10
 #define PIPE_IO_TEST_DEFAULT_DURATION 30
@@ -164,7 +243,23 @@ Module Name:
 #define MUTEX_TEST_DEFAULT_DURATION 30
 #define MUTEX_CONTENDED_TEST_DEFAULT_DURATION 30
 #define STAT_TEST_DEFAULT_DURATION 30
+#define STAT_LARGE_DIRECTORY_TEST_DEFAULT_DURATION 30
 #define FSTAT_TEST_DEFAULT_DURATION 30
+#define POLL_SMALL_TEST_DEFAULT_DURATION 30
+#define POLL_LARGE_TEST_DEFAULT_DURATION 30
+#define EPOLL_SMALL_TEST_DEFAULT_DURATION 30
+#define EPOLL_LARGE_TEST_DEFAULT_DURATION 30
+#define SEND_FILE_TEST_DEFAULT_DURATION 30
+#define READ_WRITE_SEND_TEST_DEFAULT_DURATION 30
+#define IO_RING_READ_TEST_DEFAULT_DURATION 30
+#define IO_RING_READ_POLLED_TEST_DEFAULT_DURATION 30
+#define PIPE_IO_SPLICE_TEST_DEFAULT_DURATION 30
+#define UNIX_PING_PONG_TEST_DEFAULT_DURATION 30
+#define UNIX_STREAM_TEST_DEFAULT_DURATION 30
+#define UNIX_BATCH_TEST_DEFAULT_DURATION 30
+#define IO_PRIORITY_TEST_DEFAULT_DURATION 30
+#define IO_PRIORITY_IDLE_TEST_DEFAULT_DURATION 30
+#define FILE_LOCK_TEST_DEFAULT_DURATION 30
 
 //
 // Define the number of variables supplied to an iteration of the execute test
@@ -182,8 +277,11 @@ typedef enum _PT_TEST_TYPE {
     PtTestFork,
     PtTestExec,
     PtTestOpen,
+    PtTestOpenContended,
+    PtTestOpenLargeDirectory,
     PtTestCreate,
     PtTestDup,
+    PtTestDupContended,
     PtTestRename,
     PtTestGetppid,
     PtTestPipeIo,
@@ -206,7 +304,23 @@ typedef enum _PT_TEST_TYPE {
     PtTestMutex,
     PtTestMutexContended,
     PtTestStat,
+    PtTestStatLargeDirectory,
     PtTestFstat,
+    PtTestPollSmall,
+    PtTestPollLarge,
+    PtTestEpollSmall,
+    PtTestEpollLarge,
+    PtTestSendFile,
+    PtTestReadWriteSend,
+    PtTestIoRingRead,
+    PtTestIoRingReadPolled,
+    PtTestPipeIoSplice,
+    PtTestUnixPingPong,
+    PtTestUnixStream,
+    PtTestUnixBatch,
+    PtTestIoPriority,
+    PtTestIoPriorityIdle,
+    PtTestFileLock,
     PtTestTypeCount
 } PT_TEST_TYPE, *PPT_TEST_TYPE;
 
@@ -638,7 +752,7 @@ DupMain (
 
 Routine Description:
 
-    This routine performs the dup performance benchmark test.
+    This routine performs the dup performance benchmark tests.
 
 Arguments:
 
@@ -978,3 +1092,157 @@ Return Value:
 
 --*/
 
+void
+EpollMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the poll and epoll scaling benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+SendFileMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the sendfile and read/write copy benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+IoRingMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the I/O ring read benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+UnixSocketMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the Unix domain socket benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+IoPriorityMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the I/O priority benchmark tests. The result is the
+    number of small direct reads the foreground completed while a background
+    process streamed writes to the same disk.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+FileLockMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the file lock benchmark test. The result is the
+    number of record unlock and relock pairs completed while another process
+    holds locks on the neighboring records.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
@@ -14,6 +14,8 @@ Module Name:
 Abstract:
 
     This module implements the performance benchmark tests pipe I/O throughput.
+    The splice variant places pages into an enlarged pipe with vmsplice rather
+    than copying them in with write.
 
 Author:
 
@@ -31,7 +33,9 @@ Module Name:
 
 #include <stdlib.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "perftest.h"
@@ -41,6 +45,8 @@ Module Name:
 //
 
 #define PT_PIPE_IO_BUFFER_SIZE 4096
+#define PT_PIPE_IO_SPLICE_PIPE_SIZE (1024 * 1024)
+#define PT_PIPE_IO_SPLICE_BUFFER_SIZE (256 * 1024)
 
 //
 // ------------------------------------------------------ Data Type Definitions
@@ -50,6 +56,12 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+void
+PtPipeIoSplice (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -92,6 +104,11 @@ Return Value:
     int PipeDescriptors[2];
     int Status;
 
+    if (Test->TestType == PtTestPipeIoSplice) {
+        PtPipeIoSplice(Test, Result);
+        return;
+    }
+
     Iterations = 0;
     PipeCreated = 0;
     Result->Type = PtResultIterations;
@@ -193,3 +210,179 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+void
+PtPipeIoSplice (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the pipe splice benchmark test. It grows the pipe
+    buffer, places page aligned buffers into the pipe with vmsplice, and then
+    reads them back out.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ssize_t BytesCompleted;
+    size_t BytesRead;
+    char *ReadBuffer;
+    int PipeCreated;
+    int PipeDescriptors[2];
+    int PipeSize;
+    char *SpliceBuffer;
+    int Status;
+    unsigned long long TotalBytes;
+    struct iovec Vector;
+
+    PipeCreated = 0;
+    ReadBuffer = NULL;
+    SpliceBuffer = NULL;
+    TotalBytes = 0;
+    Result->Type = PtResultBytes;
+    Result->Status = 0;
+
+    //
+    // The spliced buffer is page aligned so that whole pages get handed to
+    // the pipe.
+    //
+
+    Status = posix_memalign((void **)&SpliceBuffer,
+                            PT_PIPE_IO_BUFFER_SIZE,
+                            PT_PIPE_IO_SPLICE_BUFFER_SIZE);
+
+    if (Status != 0) {
+        SpliceBuffer = NULL;
+        Result->Status = Status;
+        goto PipeIoSpliceEnd;
+    }
+
+    ReadBuffer = malloc(PT_PIPE_IO_SPLICE_BUFFER_SIZE);
+    if (ReadBuffer == NULL) {
+        Result->Status = ENOMEM;
+        goto PipeIoSpliceEnd;
+    }
+
+    Status = pipe(PipeDescriptors);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto PipeIoSpliceEnd;
+    }
+
+    PipeCreated = 1;
+    PipeSize = fcntl(PipeDescriptors[1],
+                     F_SETPIPE_SZ,
+                     PT_PIPE_IO_SPLICE_PIPE_SIZE);
+
+    if (PipeSize < 0) {
+        Result->Status = errno;
+        goto PipeIoSpliceEnd;
+    }
+
+    if ((fcntl(PipeDescriptors[0], F_GETPIPE_SZ) != PipeSize) ||
+        (PipeSize < PT_PIPE_IO_SPLICE_BUFFER_SIZE)) {
+
+        Result->Status = EIO;
+        goto PipeIoSpliceEnd;
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto PipeIoSpliceEnd;
+    }
+
+    //
+    // Alternate between splicing the buffer into the pipe and reading it back
+    // out. The buffer is not modified, so it is fine for the pipe to still
+    // refer to it.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        Vector.iov_base = SpliceBuffer;
+        Vector.iov_len = PT_PIPE_IO_SPLICE_BUFFER_SIZE;
+        do {
+            BytesCompleted = vmsplice(PipeDescriptors[1], &Vector, 1, 0);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted != PT_PIPE_IO_SPLICE_BUFFER_SIZE) {
+            if (errno == 0) {
+                errno = EIO;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        BytesRead = 0;
+        while (BytesRead < PT_PIPE_IO_SPLICE_BUFFER_SIZE) {
+            do {
+                BytesCompleted = read(PipeDescriptors[0],
+                                      ReadBuffer + BytesRead,
+                                      PT_PIPE_IO_SPLICE_BUFFER_SIZE -
+                                      BytesRead);
+
+            } while ((BytesCompleted < 0) && (errno == EINTR));
+
+            if (BytesCompleted <= 0) {
+                if (errno == 0) {
+                    errno = EIO;
+                }
+
+                Result->Status = errno;
+                break;
+            }
+
+            BytesRead += BytesCompleted;
+        }
+
+        if (Result->Status != 0) {
+            break;
+        }
+
+        TotalBytes += BytesRead;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+PipeIoSpliceEnd:
+    if (PipeCreated != 0) {
+        close(PipeDescriptors[0]);
+        close(PipeDescriptors[1]);
+    }
+
+    if (ReadBuffer != NULL) {
+        free(ReadBuffer);
+    }
+
+    if (SpliceBuffer != NULL) {
+        free(SpliceBuffer);
+    }
+
+    Result->Data.Bytes = TotalBytes;
+    return;
+}
+
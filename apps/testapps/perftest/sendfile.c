@@ -0,0 +1,386 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    sendfile.c
+
+Abstract:
+
+    This module implements the performance benchmark tests that compare
+    sending a cached file to a socket with sendfile against a read and write
+    loop.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_SEND_FILE_TEST_FILE_NAME_LENGTH 48
+#define PT_SEND_FILE_TEST_FILE_SIZE (2 * 1024 * 1024)
+#define PT_SEND_FILE_TEST_CHUNK_SIZE (64 * 1024)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+void
+PtSendFileDrainSocket (
+    int Socket,
+    char *Buffer
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+SendFileMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the sendfile and read/write copy benchmark tests.
+    Each iteration sends a chunk of a cached file to a socket whose other end
+    is drained by a child process.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char *Buffer;
+    ssize_t BytesRead;
+    ssize_t BytesWritten;
+    pid_t Child;
+    int FileCreated;
+    int FileDescriptor;
+    char FileName[PT_SEND_FILE_TEST_FILE_NAME_LENGTH];
+    int Index;
+    off_t Offset;
+    pid_t ProcessId;
+    int Sockets[2];
+    int Status;
+    unsigned long long TotalBytes;
+    int UseSendFile;
+
+    Child = -1;
+    FileCreated = 0;
+    FileDescriptor = -1;
+    Sockets[0] = -1;
+    Sockets[1] = -1;
+    Result->Type = PtResultBytes;
+    Result->Status = 0;
+    TotalBytes = 0;
+    switch (Test->TestType) {
+    case PtTestSendFile:
+        UseSendFile = 1;
+        break;
+
+    case PtTestReadWriteSend:
+        UseSendFile = 0;
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
+
+    Buffer = malloc(PT_SEND_FILE_TEST_CHUNK_SIZE);
+    if (Buffer == NULL) {
+        Result->Status = ENOMEM;
+        goto MainEnd;
+    }
+
+    //
+    // Create a process safe file and fill it so that the test measures
+    // sending from the system's cache.
+    //
+
+    ProcessId = getpid();
+    Status = snprintf(FileName,
+                      PT_SEND_FILE_TEST_FILE_NAME_LENGTH,
+                      "sendfile_%d.txt",
+                      ProcessId);
+
+    if (Status < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileDescriptor = open(FileName,
+                          O_RDWR | O_CREAT | O_TRUNC,
+                          S_IRUSR | S_IWUSR);
+
+    if (FileDescriptor < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileCreated = 1;
+    for (Index = 0;
+         Index < (PT_SEND_FILE_TEST_FILE_SIZE / PT_SEND_FILE_TEST_CHUNK_SIZE);
+         Index += 1) {
+
+        do {
+            BytesWritten = write(FileDescriptor,
+                                 Buffer,
+                                 PT_SEND_FILE_TEST_CHUNK_SIZE);
+
+        } while ((BytesWritten < 0) && (errno == EINTR));
+
+        if (BytesWritten != PT_SEND_FILE_TEST_CHUNK_SIZE) {
+            Result->Status = errno;
+            if (Result->Status == 0) {
+                Result->Status = EIO;
+            }
+
+            goto MainEnd;
+        }
+    }
+
+    Status = fsync(FileDescriptor);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Create a connected socket pair and a child to drain the receiving end.
+    //
+
+    Status = socketpair(AF_UNIX, SOCK_STREAM, 0, Sockets);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    Child = fork();
+    if (Child < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    if (Child == 0) {
+        close(Sockets[0]);
+        PtSendFileDrainSocket(Sockets[1], Buffer);
+        _exit(0);
+    }
+
+    close(Sockets[1]);
+    Sockets[1] = -1;
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure how many bytes of the file can be sent to the socket, starting
+    // over at the beginning of the file whenever the end is reached.
+    //
+
+    Offset = 0;
+    while (PtIsTimedTestRunning() != 0) {
+        if (UseSendFile != 0) {
+            do {
+                BytesWritten = sendfile(Sockets[0],
+                                        FileDescriptor,
+                                        &Offset,
+                                        PT_SEND_FILE_TEST_CHUNK_SIZE);
+
+            } while ((BytesWritten < 0) && (errno == EINTR));
+
+            if (BytesWritten < 0) {
+                Result->Status = errno;
+                break;
+            }
+
+        } else {
+            do {
+                BytesRead = pread(FileDescriptor,
+                                  Buffer,
+                                  PT_SEND_FILE_TEST_CHUNK_SIZE,
+                                  Offset);
+
+            } while ((BytesRead < 0) && (errno == EINTR));
+
+            if (BytesRead < 0) {
+                Result->Status = errno;
+                break;
+            }
+
+            BytesWritten = 0;
+            while (BytesWritten < BytesRead) {
+                do {
+                    Status = write(Sockets[0],
+                                   Buffer + BytesWritten,
+                                   BytesRead - BytesWritten);
+
+                } while ((Status < 0) && (errno == EINTR));
+
+                if (Status <= 0) {
+                    break;
+                }
+
+                BytesWritten += Status;
+            }
+
+            if (BytesWritten != BytesRead) {
+                Result->Status = errno;
+                if (Result->Status == 0) {
+                    Result->Status = EIO;
+                }
+
+                break;
+            }
+
+            Offset += BytesWritten;
+        }
+
+        if (BytesWritten == 0) {
+            Offset = 0;
+        }
+
+        TotalBytes += (unsigned long long)BytesWritten;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Sockets[0] >= 0) {
+        close(Sockets[0]);
+    }
+
+    if (Sockets[1] >= 0) {
+        close(Sockets[1]);
+    }
+
+    if (Child > 0) {
+        waitpid(Child, NULL, 0);
+    }
+
+    if (FileCreated != 0) {
+        close(FileDescriptor);
+        remove(FileName);
+    }
+
+    if (Buffer != NULL) {
+        free(Buffer);
+    }
+
+    Result->Data.Bytes = TotalBytes;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+void
+PtSendFileDrainSocket (
+    int Socket,
+    char *Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads and discards data from the given socket until the
+    other end is closed.
+
+Arguments:
+
+    Socket - Supplies the socket to drain.
+
+    Buffer - Supplies a pointer to a scratch buffer of the test chunk size.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ssize_t BytesRead;
+
+    while (1) {
+        BytesRead = read(Socket, Buffer, PT_SEND_FILE_TEST_CHUNK_SIZE);
+        if (BytesRead == 0) {
+            break;
+        }
+
+        if ((BytesRead < 0) && (errno != EINTR)) {
+            break;
+        }
+    }
+
+    return;
+}
+
@@ -30,6 +30,7 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+#include <assert.h>
 #include <errno.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -44,6 +45,13 @@ Module Name:
 #define PT_STAT_TEST_FILE_NAME_LENGTH 48
 #define PT_FSTAT_TEST_FILE_NAME_LENGTH 49
 
+//
+// Define the number of files the large directory variant spreads its lookups
+// across, which is enough to push past any small per-directory caches.
+//
+
+#define PT_STAT_DIRECTORY_FILE_COUNT 1024
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -52,6 +60,14 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+int
+StatGetFileName (
+    char *DirectoryName,
+    pid_t ProcessId,
+    int FileIndex,
+    char *FileName
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -70,7 +86,9 @@ StatMain (
 
 Routine Description:
 
-    This routine performs the stat performance benchmark test.
+    This routine performs the stat performance benchmark tests. The large
+    directory variant stats a different file out of a directory with many
+    entries on each iteration rather than the same file over and over.
 
 Arguments:
 
@@ -87,8 +105,11 @@ Return Value:
 
 {
 
+    char DirectoryName[PT_STAT_TEST_FILE_NAME_LENGTH];
+    int FileCount;
     int FileCreated;
     int FileDescriptor;
+    int FileIndex;
     char FileName[PT_STAT_TEST_FILE_NAME_LENGTH];
     unsigned long long Iterations;
     pid_t ProcessId;
@@ -99,30 +120,69 @@ Return Value:
     Iterations = 0;
     Result->Type = PtResultIterations;
     Result->Status = 0;
+    DirectoryName[0] = '\0';
+    switch (Test->TestType) {
+    case PtTestStat:
+        FileCount = 1;
+        break;
+
+    case PtTestStatLargeDirectory:
+        FileCount = PT_STAT_DIRECTORY_FILE_COUNT;
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
 
     //
-    // Get the process ID and create a process safe file to stat.
+    // Get the process ID and create a process safe file to stat. The large
+    // directory variant creates a process safe directory full of them.
     //
 
     ProcessId = getpid();
-    Status = snprintf(FileName,
-                      PT_STAT_TEST_FILE_NAME_LENGTH,
-                      "stat_%d.txt",
-                      ProcessId);
+    if (FileCount > 1) {
+        Status = snprintf(DirectoryName,
+                          PT_STAT_TEST_FILE_NAME_LENGTH,
+                          "stat_%d",
+                          ProcessId);
 
-    if (Status < 0) {
-        Result->Status = errno;
-        goto MainEnd;
-    }
+        if (Status < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
 
-    FileDescriptor = creat(FileName, S_IRUSR | S_IWUSR);
-    if (FileDescriptor < 0) {
-        Result->Status = errno;
-        goto MainEnd;
+        Status = mkdir(DirectoryName, S_IRWXU);
+        if (Status != 0) {
+            DirectoryName[0] = '\0';
+            Result->Status = errno;
+            goto MainEnd;
+        }
     }
 
-    close(FileDescriptor);
-    FileCreated = 1;
+    for (FileIndex = 0; FileIndex < FileCount; FileIndex += 1) {
+        Status = StatGetFileName(DirectoryName,
+                                 ProcessId,
+                                 FileIndex,
+                                 FileName);
+
+        if (Status != 0) {
+            Result->Status = Status;
+            goto MainEnd;
+        }
+
+        FileDescriptor = creat(FileName, S_IRUSR | S_IWUSR);
+        if (FileDescriptor < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        close(FileDescriptor);
+        FileCreated += 1;
+    }
 
     //
     // Start the test. This snaps resource usage and starts the clock ticking.
@@ -136,10 +196,19 @@ Return Value:
 
     //
     // Measure the performance of the stat() C library routine by counting the
-    // number of times the stats for the created file can be queried.
+    // number of times the stats for the created files can be queried.
     //
 
+    FileIndex = 0;
     while (PtIsTimedTestRunning() != 0) {
+        if (FileCount > 1) {
+            StatGetFileName(DirectoryName, ProcessId, FileIndex, FileName);
+            FileIndex += 1;
+            if (FileIndex == FileCount) {
+                FileIndex = 0;
+            }
+        }
+
         Status = stat(FileName, &Stat);
         if (Status != 0) {
             Result->Status = errno;
@@ -155,10 +224,15 @@ Return Value:
     }
 
 MainEnd:
-    if (FileCreated != 0) {
+    for (FileIndex = 0; FileIndex < FileCreated; FileIndex += 1) {
+        StatGetFileName(DirectoryName, ProcessId, FileIndex, FileName);
         remove(FileName);
     }
 
+    if (DirectoryName[0] != '\0') {
+        rmdir(DirectoryName);
+    }
+
     Result->Data.Iterations = Iterations;
     return;
 }
@@ -270,3 +344,64 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+
+int
+StatGetFileName (
+    char *DirectoryName,
+    pid_t ProcessId,
+    int FileIndex,
+    char *FileName
+    )
+
+/*++
+
+Routine Description:
+
+    This routine builds the name of one of the files the stat test queries.
+
+Arguments:
+
+    DirectoryName - Supplies the name of the directory holding the files, or
+        an empty string if the test uses a single file in the current
+        directory.
+
+    ProcessId - Supplies the ID of the process running the test.
+
+    FileIndex - Supplies the index of the file within the directory.
+
+    FileName - Supplies a pointer to a buffer of at least
+        PT_STAT_TEST_FILE_NAME_LENGTH bytes that receives the file name.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    int Status;
+
+    if (DirectoryName[0] == '\0') {
+        Status = snprintf(FileName,
+                          PT_STAT_TEST_FILE_NAME_LENGTH,
+                          "stat_%d.txt",
+                          ProcessId);
+
+    } else {
+        Status = snprintf(FileName,
+                          PT_STAT_TEST_FILE_NAME_LENGTH,
+                          "%s/file_%d.txt",
+                          DirectoryName,
+                          FileIndex);
+    }
+
+    if (Status < 0) {
+        return errno;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,720 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    unixsock.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for local (Unix
+    domain) sockets: a small message ping-pong that measures latency, a
+    streaming test that measures bulk throughput, and a batched datagram
+    ping-pong that uses sendmmsg and recvmmsg.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_UNIX_PING_PONG_MESSAGE_SIZE 64
+#define PT_UNIX_STREAM_CHUNK_SIZE (256 * 1024)
+#define PT_UNIX_BATCH_MESSAGE_COUNT 16
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+void
+PtUnixSocketEcho (
+    int Socket,
+    char *Buffer
+    );
+
+void
+PtUnixSocketEchoBatch (
+    int Socket,
+    char *Buffer
+    );
+
+void
+PtUnixSocketDrain (
+    int Socket,
+    char *Buffer
+    );
+
+int
+PtUnixSocketTransfer (
+    int Socket,
+    char *Buffer,
+    size_t Size,
+    int Send
+    );
+
+int
+PtUnixSocketBatch (
+    int Socket,
+    char *Buffer,
+    unsigned int MessageCount,
+    int Send
+    );
+
+void
+PtUnixSocketInitializeBatch (
+    struct mmsghdr *Messages,
+    struct iovec *Vectors,
+    char *Buffer,
+    unsigned int MessageCount
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+UnixSocketMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the Unix domain socket benchmark tests. A child
+    process services the other end of a connected socket pair.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char *Buffer;
+    size_t BufferSize;
+    pid_t Child;
+    unsigned long long Iterations;
+    int Sockets[2];
+    int Status;
+    unsigned long long TotalBytes;
+    int Type;
+
+    Child = -1;
+    Iterations = 0;
+    Sockets[0] = -1;
+    Sockets[1] = -1;
+    TotalBytes = 0;
+    Result->Status = 0;
+    switch (Test->TestType) {
+    case PtTestUnixPingPong:
+        Result->Type = PtResultIterations;
+        BufferSize = PT_UNIX_PING_PONG_MESSAGE_SIZE;
+        Type = SOCK_STREAM;
+        break;
+
+    case PtTestUnixStream:
+        Result->Type = PtResultBytes;
+        BufferSize = PT_UNIX_STREAM_CHUNK_SIZE;
+        Type = SOCK_STREAM;
+        break;
+
+    case PtTestUnixBatch:
+        Result->Type = PtResultIterations;
+        BufferSize = PT_UNIX_PING_PONG_MESSAGE_SIZE *
+                     PT_UNIX_BATCH_MESSAGE_COUNT;
+
+        Type = SOCK_DGRAM;
+        break;
+
+    default:
+
+        assert(0);
+
+        Result->Status = EINVAL;
+        return;
+    }
+
+    Buffer = malloc(BufferSize);
+    if (Buffer == NULL) {
+        Result->Status = ENOMEM;
+        goto MainEnd;
+    }
+
+    memset(Buffer, 0, BufferSize);
+    Status = socketpair(AF_UNIX, Type, 0, Sockets);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    Child = fork();
+    if (Child < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    if (Child == 0) {
+        close(Sockets[0]);
+        switch (Test->TestType) {
+        case PtTestUnixPingPong:
+            PtUnixSocketEcho(Sockets[1], Buffer);
+            break;
+
+        case PtTestUnixStream:
+            PtUnixSocketDrain(Sockets[1], Buffer);
+            break;
+
+        case PtTestUnixBatch:
+            PtUnixSocketEchoBatch(Sockets[1], Buffer);
+            break;
+
+        default:
+            break;
+        }
+
+        _exit(0);
+    }
+
+    close(Sockets[1]);
+    Sockets[1] = -1;
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    while (PtIsTimedTestRunning() != 0) {
+        switch (Test->TestType) {
+
+        //
+        // Send a small message and wait for the child to send it back.
+        //
+
+        case PtTestUnixPingPong:
+            Status = PtUnixSocketTransfer(Sockets[0],
+                                          Buffer,
+                                          PT_UNIX_PING_PONG_MESSAGE_SIZE,
+                                          1);
+
+            if (Status == 0) {
+                Status = PtUnixSocketTransfer(Sockets[0],
+                                              Buffer,
+                                              PT_UNIX_PING_PONG_MESSAGE_SIZE,
+                                              0);
+            }
+
+            if (Status == 0) {
+                Iterations += 1;
+            }
+
+            break;
+
+        //
+        // Send large chunks as fast as the child can take them. Chunks this
+        // size are handed to a waiting receiver without an intermediate copy.
+        //
+
+        case PtTestUnixStream:
+            Status = PtUnixSocketTransfer(Sockets[0],
+                                          Buffer,
+                                          PT_UNIX_STREAM_CHUNK_SIZE,
+                                          1);
+
+            if (Status == 0) {
+                TotalBytes += PT_UNIX_STREAM_CHUNK_SIZE;
+            }
+
+            break;
+
+        //
+        // Send a batch of datagrams in one call and collect the echoes. Each
+        // datagram counts as an iteration.
+        //
+
+        case PtTestUnixBatch:
+            Status = PtUnixSocketBatch(Sockets[0],
+                                       Buffer,
+                                       PT_UNIX_BATCH_MESSAGE_COUNT,
+                                       1);
+
+            if (Status == 0) {
+                Status = PtUnixSocketBatch(Sockets[0],
+                                           Buffer,
+                                           PT_UNIX_BATCH_MESSAGE_COUNT,
+                                           0);
+            }
+
+            if (Status == 0) {
+                Iterations += PT_UNIX_BATCH_MESSAGE_COUNT;
+            }
+
+            break;
+
+        default:
+            Status = EINVAL;
+            break;
+        }
+
+        if (Status != 0) {
+            Result->Status = Status;
+            break;
+        }
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Sockets[0] >= 0) {
+
+        //
+        // Closing a datagram socket is not seen by its peer, so tell the
+        // batch echo child to exit with an empty datagram.
+        //
+
+        if ((Child > 0) && (Test->TestType == PtTestUnixBatch)) {
+            send(Sockets[0], Buffer, 0, 0);
+        }
+
+        close(Sockets[0]);
+    }
+
+    if (Sockets[1] >= 0) {
+        close(Sockets[1]);
+    }
+
+    if (Child > 0) {
+        waitpid(Child, NULL, 0);
+    }
+
+    if (Buffer != NULL) {
+        free(Buffer);
+    }
+
+    if (Result->Type == PtResultBytes) {
+        Result->Data.Bytes = TotalBytes;
+
+    } else {
+        Result->Data.Iterations = Iterations;
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+void
+PtUnixSocketEcho (
+    int Socket,
+    char *Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends every ping-pong message received on the given socket
+    back to the sender, until the other end is closed.
+
+Arguments:
+
+    Socket - Supplies the socket to echo.
+
+    Buffer - Supplies a pointer to a scratch buffer of the message size.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int Status;
+
+    while (1) {
+        Status = PtUnixSocketTransfer(Socket,
+                                      Buffer,
+                                      PT_UNIX_PING_PONG_MESSAGE_SIZE,
+                                      0);
+
+        if (Status != 0) {
+            break;
+        }
+
+        Status = PtUnixSocketTransfer(Socket,
+                                      Buffer,
+                                      PT_UNIX_PING_PONG_MESSAGE_SIZE,
+                                      1);
+
+        if (Status != 0) {
+            break;
+        }
+    }
+
+    return;
+}
+
+void
+PtUnixSocketEchoBatch (
+    int Socket,
+    char *Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends every datagram received on the given socket back to
+    the sender, a batch at a time, until the other end is closed.
+
+Arguments:
+
+    Socket - Supplies the datagram socket to echo.
+
+    Buffer - Supplies a pointer to a scratch buffer big enough for a batch.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    struct mmsghdr Messages[PT_UNIX_BATCH_MESSAGE_COUNT];
+    int Received;
+    int Sent;
+    struct iovec Vectors[PT_UNIX_BATCH_MESSAGE_COUNT];
+
+    while (1) {
+        PtUnixSocketInitializeBatch(Messages,
+                                    Vectors,
+                                    Buffer,
+                                    PT_UNIX_BATCH_MESSAGE_COUNT);
+
+        Received = recvmmsg(Socket,
+                            Messages,
+                            PT_UNIX_BATCH_MESSAGE_COUNT,
+                            MSG_WAITFORONE,
+                            NULL);
+
+        if (Received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+
+        //
+        // The parent sends an empty datagram when the test is over.
+        //
+
+        if ((Received == 0) || (Messages[0].msg_len == 0)) {
+            break;
+        }
+
+        do {
+            Sent = sendmmsg(Socket, Messages, Received, 0);
+
+        } while ((Sent < 0) && (errno == EINTR));
+
+        if (Sent != Received) {
+            break;
+        }
+    }
+
+    return;
+}
+
+void
+PtUnixSocketDrain (
+    int Socket,
+    char *Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads and discards data from the given socket until the
+    other end is closed.
+
+Arguments:
+
+    Socket - Supplies the socket to drain.
+
+    Buffer - Supplies a pointer to a scratch buffer of the stream chunk size.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ssize_t BytesRead;
+
+    while (1) {
+        BytesRead = recv(Socket, Buffer, PT_UNIX_STREAM_CHUNK_SIZE, 0);
+        if (BytesRead == 0) {
+            break;
+        }
+
+        if ((BytesRead < 0) && (errno != EINTR)) {
+            break;
+        }
+    }
+
+    return;
+}
+
+int
+PtUnixSocketTransfer (
+    int Socket,
+    char *Buffer,
+    size_t Size,
+    int Send
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives exactly the given number of bytes on a
+    stream socket.
+
+Arguments:
+
+    Socket - Supplies the socket to use.
+
+    Buffer - Supplies a pointer to the data buffer.
+
+    Size - Supplies the number of bytes to transfer.
+
+    Send - Supplies a non-zero value to send the data, or zero to receive it.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    ssize_t BytesCompleted;
+    size_t Offset;
+
+    Offset = 0;
+    while (Offset < Size) {
+        if (Send != 0) {
+            BytesCompleted = send(Socket, Buffer + Offset, Size - Offset, 0);
+
+        } else {
+            BytesCompleted = recv(Socket, Buffer + Offset, Size - Offset, 0);
+        }
+
+        if (BytesCompleted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        if (BytesCompleted == 0) {
+            return EPIPE;
+        }
+
+        Offset += BytesCompleted;
+    }
+
+    return 0;
+}
+
+int
+PtUnixSocketBatch (
+    int Socket,
+    char *Buffer,
+    unsigned int MessageCount,
+    int Send
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives the given number of ping-pong sized
+    datagrams, using as few calls as possible.
+
+Arguments:
+
+    Socket - Supplies the datagram socket to use.
+
+    Buffer - Supplies a pointer to a buffer big enough for all the messages.
+
+    MessageCount - Supplies the number of datagrams to transfer. This must not
+        be more than the batch size.
+
+    Send - Supplies a non-zero value to send the datagrams, or zero to receive
+        them.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    int Completed;
+    struct mmsghdr Messages[PT_UNIX_BATCH_MESSAGE_COUNT];
+    unsigned int Total;
+    struct iovec Vectors[PT_UNIX_BATCH_MESSAGE_COUNT];
+
+    assert(MessageCount <= PT_UNIX_BATCH_MESSAGE_COUNT);
+
+    PtUnixSocketInitializeBatch(Messages, Vectors, Buffer, MessageCount);
+    Total = 0;
+    while (Total < MessageCount) {
+        if (Send != 0) {
+            Completed = sendmmsg(Socket,
+                                 Messages + Total,
+                                 MessageCount - Total,
+                                 0);
+
+        } else {
+            Completed = recvmmsg(Socket,
+                                 Messages + Total,
+                                 MessageCount - Total,
+                                 MSG_WAITFORONE,
+                                 NULL);
+        }
+
+        if (Completed < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        if (Completed == 0) {
+            return EPIPE;
+        }
+
+        Total += Completed;
+    }
+
+    return 0;
+}
+
+void
+PtUnixSocketInitializeBatch (
+    struct mmsghdr *Messages,
+    struct iovec *Vectors,
+    char *Buffer,
+    unsigned int MessageCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets up an array of messages that each cover one ping-pong
+    sized slice of the given buffer.
+
+Arguments:
+
+    Messages - Supplies a pointer to the array of messages to initialize.
+
+    Vectors - Supplies a pointer to an array of I/O vectors, one per message.
+
+    Buffer - Supplies a pointer to the buffer to slice up.
+
+    MessageCount - Supplies the number of messages to initialize.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    unsigned int Index;
+
+    memset(Messages, 0, sizeof(struct mmsghdr) * MessageCount);
+    for (Index = 0; Index < MessageCount; Index += 1) {
+        Vectors[Index].iov_base = Buffer +
+                                  (Index * PT_UNIX_PING_PONG_MESSAGE_SIZE);
+
+        Vectors[Index].iov_len = PT_UNIX_PING_PONG_MESSAGE_SIZE;
+        Messages[Index].msg_hdr.msg_iov = &(Vectors[Index]);
+        Messages[Index].msg_hdr.msg_iovlen = 1;
+    }
+
+    return;
+}
+
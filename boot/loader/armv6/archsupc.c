@@ -302,6 +302,39 @@ Return Value:
     return;
 }
 
+ULONGLONG
+BoArchReadCycleCounter (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the processor cycle counter for the boot timeline.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current cycle counter value, or 0 if the cycle counter cannot
+    be used as a timestamp on this architecture.
+
+--*/
+
+{
+
+    //
+    // The cycle counter is only running while it is being measured, and the
+    // kernel reprograms it anyway, so loader events go on the timeline
+    // untimed.
+    //
+
+    return 0;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
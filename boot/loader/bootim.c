@@ -63,6 +63,9 @@ Structure Description:
 
     FileSize - Stores the size of the loaded file, in bytes.
 
+    OpenTime - Stores the cycle counter value when the file was opened, used
+        to put the image load on the boot timeline.
+
 --*/
 
 typedef struct _BOOT_FILE_HANDLE {
@@ -70,6 +73,7 @@ typedef struct _BOOT_FILE_HANDLE {
     ULONG FileNameSize;
     PVOID LoadedFileBuffer;
     UINTN FileSize;
+    ULONGLONG OpenTime;
 } BOOT_FILE_HANDLE, *PBOOT_FILE_HANDLE;
 
 /*++
@@ -421,6 +425,7 @@ Return Value:
     }
 
     RtlZeroMemory(BootFileHandle, sizeof(BOOT_FILE_HANDLE));
+    BootFileHandle->OpenTime = BoArchReadCycleCounter();
     BootFileHandle->FileNameSize = RtlStringLength(BinaryName) + 1;
     BootFileHandle->FileName = BoAllocateMemory(BootFileHandle->FileNameSize);
     if (BootFileHandle->FileName == NULL) {
@@ -903,6 +908,7 @@ Return Value:
 {
 
     ULONG AllocationSize;
+    PBOOT_FILE_HANDLE BootFileHandle;
     PSTR FileName;
     PDEBUG_MODULE LoadedModule;
     ULONG NameSize;
@@ -943,6 +949,14 @@ Return Value:
     LoadedModule->Image = Image;
     Image->DebuggerModule = LoadedModule;
     KdReportModuleChange(LoadedModule, TRUE);
+    BootFileHandle = Image->File.Handle;
+    if ((BootFileHandle != NULL) && (BootFileHandle != INVALID_HANDLE)) {
+        BoRecordTimelineEvent(BootTimelineEventImageLoad,
+                              FileName,
+                              BootFileHandle->OpenTime,
+                              BoArchReadCycleCounter());
+    }
+
     Status = STATUS_SUCCESS;
 
 NotifyImageLoadEnd:
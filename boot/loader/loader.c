@@ -50,6 +50,12 @@ Module Name:
 
 #define LOADER_NAME "Minoca Boot Loader"
 
+//
+// Define the number of boot timeline events the loader can record.
+//
+
+#define LOADER_TIMELINE_EVENT_COUNT 64
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -197,6 +203,14 @@ LIST_ENTRY BoLoadedImageList;
 
 UCHAR BoLoaderModuleBuffer[LOADER_MODULE_BUFFER_SIZE];
 
+//
+// Store the boot timeline events recorded by the loader. These are handed to
+// the kernel, which copies them out before loader memory is released.
+//
+
+BOOT_TIMELINE_EVENT BoTimelineEvents[LOADER_TIMELINE_EVENT_COUNT];
+ULONG BoTimelineEventCount;
+
 //
 // Piggyback off of the image support's system directory file ID.
 //
@@ -249,6 +263,7 @@ Return Value:
     PHYSICAL_ADDRESS KernelStackPhysical;
     PDEBUG_MODULE LoaderModule;
     ULONG LoaderModuleNameLength;
+    ULONGLONG LoaderStart;
     ULONG LoaderStep;
     ULONG LoadFlags;
     PHYSICAL_ADDRESS PageDirectoryPhysical;
@@ -261,6 +276,7 @@ Return Value:
     BOOL StackOutsideImage;
     KSTATUS Status;
 
+    LoaderStart = BoArchReadCycleCounter();
     BootConfiguration = NULL;
     BootDevice = NULL;
     BootEntry = NULL;
@@ -765,6 +781,19 @@ Return Value:
 
     LoaderStep += 1;
 
+    //
+    // Close out the loader's span on the boot timeline and hand the timeline
+    // to the kernel.
+    //
+
+    BoRecordTimelineEvent(BootTimelineEventLoader,
+                          LOADER_NAME,
+                          LoaderStart,
+                          BoArchReadCycleCounter());
+
+    KernelParameters->BootTimeline = BoTimelineEvents;
+    KernelParameters->BootTimelineCount = BoTimelineEventCount;
+
     //
     // Transfer execution to the kernel. This should not return.
     //
@@ -1178,6 +1207,55 @@ Return Value:
     return PhysicalPointer;
 }
 
+VOID
+BoRecordTimelineEvent (
+    BOOT_TIMELINE_EVENT_TYPE Type,
+    PCSTR Name,
+    ULONGLONG Start,
+    ULONGLONG End
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records an event on the boot timeline passed to the kernel.
+    Events past the capacity of the loader's timeline are dropped.
+
+Arguments:
+
+    Type - Supplies the category of the event.
+
+    Name - Supplies a pointer to the name of the event. Long names are
+        truncated.
+
+    Start - Supplies the cycle counter value when the event began.
+
+    End - Supplies the cycle counter value when the event finished.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PBOOT_TIMELINE_EVENT Event;
+
+    if (BoTimelineEventCount >= LOADER_TIMELINE_EVENT_COUNT) {
+        return;
+    }
+
+    Event = &(BoTimelineEvents[BoTimelineEventCount]);
+    Event->Type = Type;
+    Event->Start = Start;
+    Event->End = End;
+    RtlStringCopy(Event->Name, Name, BOOT_TIMELINE_NAME_SIZE);
+    BoTimelineEventCount += 1;
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
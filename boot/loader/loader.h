@@ -196,6 +196,38 @@ Return Value:
 
 --*/
 
+VOID
+BoRecordTimelineEvent (
+    BOOT_TIMELINE_EVENT_TYPE Type,
+    PCSTR Name,
+    ULONGLONG Start,
+    ULONGLONG End
+    );
+
+/*++
+
+Routine Description:
+
+    This routine records an event on the boot timeline passed to the kernel.
+    Events past the capacity of the loader's timeline are dropped.
+
+Arguments:
+
+    Type - Supplies the category of the event.
+
+    Name - Supplies a pointer to the name of the event. Long names are
+        truncated.
+
+    Start - Supplies the cycle counter value when the event began.
+
+    End - Supplies the cycle counter value when the event finished.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 BoFwMapKnownRegions (
     ULONG Phase,
@@ -369,3 +401,26 @@ Return Value:
     the parameter block.
 
 --*/
+
+ULONGLONG
+BoArchReadCycleCounter (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads the processor cycle counter for the boot timeline.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current cycle counter value, or 0 if the cycle counter cannot
+    be used as a timestamp on this architecture.
+
+--*/
+
@@ -227,6 +227,33 @@ Return Value:
     return;
 }
 
+ULONGLONG
+BoArchReadCycleCounter (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the processor cycle counter for the boot timeline.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current cycle counter value, or 0 if the cycle counter cannot
+    be used as a timestamp on this architecture.
+
+--*/
+
+{
+
+    return ArReadTimeStampCounter();
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
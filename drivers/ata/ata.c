@@ -1212,6 +1212,7 @@ Return Value:
 
 {
 
+    IO_BLOCK_SCHEDULER Scheduler;
     KSTATUS Status;
 
     if (Irp->Direction == IrpDown) {
@@ -1246,6 +1247,20 @@ Return Value:
                 }
             }
 
+            //
+            // Rotational disks pay for every seek, so sort their requests.
+            // The controller works on one command at a time.
+            //
+
+            if (KSUCCESS(Status)) {
+                Scheduler = IoBlockSchedulerDeadline;
+                if (Child->NonRotational != FALSE) {
+                    Scheduler = IoBlockSchedulerNone;
+                }
+
+                Status = IoSetBlockDeviceScheduler(Irp->Device, Scheduler, 1);
+            }
+
             IoCompleteIrp(AtaDriver, Irp, Status);
             break;
 
@@ -2215,6 +2230,15 @@ Return Value:
         Device->DmaSupported = TRUE;
     }
 
+    //
+    // Solid state disks report a rotation rate of 1. Their requests don't
+    // benefit from being sorted by offset.
+    //
+
+    if (Identify.NominalRotationRate == ATA_NON_ROTATING_MEDIA) {
+        Device->NonRotational = TRUE;
+    }
+
 IdentifyDeviceEnd:
     return Status;
 }
@@ -227,6 +227,12 @@ Module Name:
 
 #define ATA_SUPPORTED_COMMAND_LBA48 (1 << 26)
 
+//
+// Define the nominal rotation rate value reported by solid state disks.
+//
+
+#define ATA_NON_ROTATING_MEDIA 1
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -385,6 +391,9 @@ Structure Description:
 
     TotalSectors - Stores the total number of sectors in the device.
 
+    NonRotational - Stores a boolean indicating whether or not the device
+        reports solid state media, which has no seek penalty.
+
     DiskInterface - Stores the disk interface.
 
 --*/
@@ -398,6 +407,7 @@ struct _ATA_CHILD {
     BOOL DmaSupported;
     BOOL Lba48Supported;
     ULONGLONG TotalSectors;
+    BOOL NonRotational;
     DISK_INTERFACE DiskInterface;
 };
 
@@ -597,6 +607,10 @@ Structure Description:
 
     MediaSerialNumber - Stores the current media serial number.
 
+    NominalRotationRate - Stores the nominal media rotation rate in rotations
+        per minute. A value of 1 indicates non-rotating (solid state) media,
+        and 0 indicates the rate is not reported.
+
     Checksum - Stores the two's complement of the sum of all bytes in words
         0-254 and the byte in bits 0-7 of word 255, if bits 0-7 of word 255
         contains the value 0xA5. Each byte shall be added with unsigned
@@ -652,7 +666,9 @@ typedef struct _ATA_IDENTIFY_PACKET {
     USHORT PowerMode1;
     USHORT Reserved12[15];
     USHORT MediaSerialNumber[30];
-    USHORT Reserved13[49];
+    USHORT Reserved13[11];
+    USHORT NominalRotationRate;
+    USHORT Reserved14[37];
     USHORT Checksum;
 } PACKED ATA_IDENTIFY_PACKET, *PATA_IDENTIFY_PACKET;
 
@@ -42,6 +42,7 @@ function build() {
         "//drivers/sd:sd_drivers",
         "//drivers/special:special",
         "//drivers/term/ser16550:ser16550",
+        "//drivers/tmpfs:tmpfs",
         "//drivers/usb:usb_drivers",
         "//drivers/videocon:videocon"
     ];
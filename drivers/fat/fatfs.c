@@ -1067,6 +1067,7 @@ Return Value:
                                        Irp->U.ReadWrite.IoSizeInBytes,
                                        FALSE,
                                        FALSE,
+                                       Irp->U.ReadWrite.IoFlags,
                                        DiskIrp,
                                        &(Irp->U.ReadWrite.IoBytesCompleted),
                                        &ElementsRead);
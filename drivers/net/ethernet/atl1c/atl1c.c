@@ -508,6 +508,8 @@ Return Value:
     Properties.Interface.Send = AtlSend;
     Properties.Interface.GetSetInformation = AtlGetSetInformation;
     Properties.Interface.DestroyLink = AtlDestroyLink;
+    Properties.Interface.Poll = AtlPoll;
+    Properties.Interface.CompletePoll = AtlCompletePoll;
     Status = NetAddLink(&Properties, &(Device->NetworkLink));
     if (!KSUCCESS(Status)) {
         goto AddNetworkDeviceEnd;
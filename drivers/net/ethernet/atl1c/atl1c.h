@@ -992,7 +992,12 @@ Structure Description:
     PendingInterrupts - Stores the bitfield of status bits that have yet to be
         dealt with by software.
 
-    EnabledInterrupts - Stores the bitfield of enabled interrupts.
+    EnabledInterrupts - Stores the bitfield of enabled interrupts. The receive
+        packet interrupts are left out of this while the networking core is
+        polling the device.
+
+    InterruptTimers - Stores the value programmed into the interrupt
+        moderator timer register whenever the device is enabled.
 
     Speed - Stores the current speed of the link.
 
@@ -1026,6 +1031,7 @@ typedef struct _ATL1C_DEVICE {
     KSPIN_LOCK InterruptLock;
     volatile ULONG PendingInterrupts;
     ULONG EnabledInterrupts;
+    ULONG InterruptTimers;
     ATL_SPEED Speed;
     ATL_DUPLEX_MODE Duplex;
     BYTE EepromMacAddress[ETHERNET_ADDRESS_SIZE];
@@ -1075,6 +1081,55 @@ Return Value:
 
 --*/
 
+ULONG
+AtlPoll (
+    PVOID DeviceContext,
+    ULONG Budget
+    );
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames while the networking core polls
+    the device.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed.
+
+--*/
+
+VOID
+AtlCompletePoll (
+    PVOID DeviceContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine re-enables the receive packet interrupts once the networking
+    core has drained the receive ring.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 AtlGetSetInformation (
     PVOID DeviceContext,
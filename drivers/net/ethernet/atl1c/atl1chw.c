@@ -64,9 +64,10 @@ AtlpSendPendingPackets (
     PATL1C_DEVICE Device
     );
 
-VOID
+ULONG
 AtlpReapReceivedFrames (
-    PATL1C_DEVICE Device
+    PATL1C_DEVICE Device,
+    ULONG Budget
     );
 
 VOID
@@ -336,9 +337,14 @@ Return Value:
 
 {
 
+    PNET_LINK_INTERRUPT_COALESCING Coalescing;
+    PATL1C_DEVICE Device;
     PULONG Flags;
+    ULONG ReceiveTimer;
     KSTATUS Status;
+    ULONG TransmitTimer;
 
+    Device = (PATL1C_DEVICE)DeviceContext;
     switch (InformationType) {
     case NetLinkInformationChecksumOffload:
         if (*DataSize != sizeof(ULONG)) {
@@ -353,6 +359,55 @@ Return Value:
         *Flags = 0;
         break;
 
+    //
+    // The moderator timers delay interrupts in units of two microseconds.
+    // There is no frame count threshold, so those are always reported as
+    // zero.
+    //
+
+    case NetLinkInformationInterruptCoalescing:
+        if (*DataSize != sizeof(NET_LINK_INTERRUPT_COALESCING)) {
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        Coalescing = (PNET_LINK_INTERRUPT_COALESCING)Data;
+        if (Set != FALSE) {
+            TransmitTimer = ATL_MICROSECONDS(Coalescing->TransmitMicroseconds);
+            if (TransmitTimer > ATL_INTERRUPT_TIMER_TRANSMIT_MASK) {
+                TransmitTimer = ATL_INTERRUPT_TIMER_TRANSMIT_MASK;
+            }
+
+            ReceiveTimer = ATL_MICROSECONDS(Coalescing->ReceiveMicroseconds);
+            if (ReceiveTimer > ATL_INTERRUPT_TIMER_RECEIVE_MASK) {
+                ReceiveTimer = ATL_INTERRUPT_TIMER_RECEIVE_MASK;
+            }
+
+            Device->InterruptTimers =
+                        (TransmitTimer << ATL_INTERRUPT_TIMER_TRANSMIT_SHIFT) |
+                        (ReceiveTimer << ATL_INTERRUPT_TIMER_RECEIVE_SHIFT);
+
+            ATL_WRITE_REGISTER32(Device,
+                                 AtlRegisterInterruptTimers,
+                                 Device->InterruptTimers);
+        }
+
+        TransmitTimer = (Device->InterruptTimers >>
+                         ATL_INTERRUPT_TIMER_TRANSMIT_SHIFT) &
+                        ATL_INTERRUPT_TIMER_TRANSMIT_MASK;
+
+        ReceiveTimer = (Device->InterruptTimers >>
+                        ATL_INTERRUPT_TIMER_RECEIVE_SHIFT) &
+                       ATL_INTERRUPT_TIMER_RECEIVE_MASK;
+
+        Coalescing->TransmitMicroseconds = TransmitTimer *
+                                           ATL_TICK_MICROSECONDS;
+
+        Coalescing->TransmitFrames = 0;
+        Coalescing->ReceiveMicroseconds = ReceiveTimer * ATL_TICK_MICROSECONDS;
+        Coalescing->ReceiveFrames = 0;
+        Status = STATUS_SUCCESS;
+        break;
+
     default:
         Status = STATUS_NOT_SUPPORTED;
         break;
@@ -361,6 +416,76 @@ Return Value:
     return Status;
 }
 
+ULONG
+AtlPoll (
+    PVOID DeviceContext,
+    ULONG Budget
+    )
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames while the networking core polls
+    the device.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed.
+
+--*/
+
+{
+
+    return AtlpReapReceivedFrames((PATL1C_DEVICE)DeviceContext, Budget);
+}
+
+VOID
+AtlCompletePoll (
+    PVOID DeviceContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine re-enables the receive packet interrupts once the networking
+    core has drained the receive ring.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PATL1C_DEVICE Device;
+    RUNLEVEL OldRunLevel;
+
+    Device = (PATL1C_DEVICE)DeviceContext;
+    OldRunLevel = AtlpAcquireInterruptLock(Device);
+    Device->EnabledInterrupts |= ATL_INTERRUPT_RECEIVE_PACKET_MASK;
+    ATL_WRITE_REGISTER32(Device,
+                         AtlRegisterInterruptMask,
+                         Device->EnabledInterrupts);
+
+    AtlpReleaseInterruptLock(Device, OldRunLevel);
+    return;
+}
+
 KSTATUS
 AtlpInitializeDeviceStructures (
     PATL1C_DEVICE Device
@@ -396,6 +521,13 @@ Return Value:
     Device->Speed = AtlSpeedOff;
     Device->Duplex = AtlDuplexInvalid;
     Device->EnabledInterrupts = ATL_INTERRUPT_DEFAULT_MASK;
+    Device->InterruptTimers =
+            ((ATL_MICROSECONDS(ATL_TRANSMIT_INTERRUPT_TIMER_VALUE) &
+              ATL_INTERRUPT_TIMER_TRANSMIT_MASK) <<
+             ATL_INTERRUPT_TIMER_TRANSMIT_SHIFT) |
+            ((ATL_MICROSECONDS(ATL_RECEIVE_INTERRUPT_TIMER_VALUE) &
+              ATL_INTERRUPT_TIMER_RECEIVE_MASK) <<
+             ATL_INTERRUPT_TIMER_RECEIVE_SHIFT);
 
     //
     // Allocate the transmit and receive locks.
@@ -709,14 +841,9 @@ Return Value:
     // Set up the interrupt moderator timer.
     //
 
-    Value = ((ATL_MICROSECONDS(ATL_TRANSMIT_INTERRUPT_TIMER_VALUE) &
-              ATL_INTERRUPT_TIMER_TRANSMIT_MASK) <<
-             ATL_INTERRUPT_TIMER_TRANSMIT_SHIFT) |
-            ((ATL_MICROSECONDS(ATL_RECEIVE_INTERRUPT_TIMER_VALUE) &
-              ATL_INTERRUPT_TIMER_RECEIVE_MASK) <<
-             ATL_INTERRUPT_TIMER_RECEIVE_SHIFT);
-
-    ATL_WRITE_REGISTER32(Device, AtlRegisterInterruptTimers, Value);
+    ATL_WRITE_REGISTER32(Device,
+                         AtlRegisterInterruptTimers,
+                         Device->InterruptTimers);
 
     //
     // Set the timers to be enabled, and disable interrupt status clear on
@@ -918,6 +1045,18 @@ Return Value:
     KeAcquireSpinLock(&(Device->InterruptLock));
     RtlAtomicOr32(&(Device->PendingInterrupts), PendingBits);
 
+    //
+    // Received frames are handed to the networking core to poll, so disable
+    // the receive interrupts until it is done.
+    //
+
+    if ((PendingBits & ATL_INTERRUPT_RECEIVE_PACKET_MASK) != 0) {
+        Device->EnabledInterrupts &= ~ATL_INTERRUPT_RECEIVE_PACKET_MASK;
+        ATL_WRITE_REGISTER32(Device,
+                             AtlRegisterInterruptMask,
+                             Device->EnabledInterrupts);
+    }
+
     //
     // The GPHY bit cannot be masked or cleared by the controller directly.
     // Read the PHY interrupt status register to clear the interrupt.
@@ -988,11 +1127,12 @@ Return Value:
     }
 
     //
-    // If the interrupt indicates new packets are coming in, grab them.
+    // If the interrupt indicates new packets are coming in, have the
+    // networking core poll for them.
     //
 
     if ((PendingBits & ATL_INTERRUPT_RECEIVE_PACKET_MASK) != 0) {
-        AtlpReapReceivedFrames(Device);
+        NetSchedulePoll(Device->NetworkLink);
     }
 
     //
@@ -1195,9 +1335,10 @@ Return Value:
     return;
 }
 
-VOID
+ULONG
 AtlpReapReceivedFrames (
-    PATL1C_DEVICE Device
+    PATL1C_DEVICE Device,
+    ULONG Budget
     )
 
 /*++
@@ -1210,9 +1351,11 @@ Routine Description:
 
     Device - Supplies a pointer to the device.
 
+    Budget - Supplies the maximum number of frames to process.
+
 Return Value:
 
-    None.
+    Returns the number of frames processed.
 
 --*/
 
@@ -1230,14 +1373,14 @@ Return Value:
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
     //
-    // Loop grabbing completed frames.
+    // Loop grabbing completed frames until the budget runs out.
     //
 
     FramesProcessed = 0;
     Packet.Flags = 0;
     KeAcquireQueuedLock(Device->ReceiveLock);
     OriginalNextToClean = Device->ReceiveNextToClean;
-    while (TRUE) {
+    while (FramesProcessed < Budget) {
         CurrentIndex = Device->ReceiveNextToClean;
         ReceivedPacket = &(Device->ReceivedPacket[CurrentIndex]);
 
@@ -1320,7 +1463,7 @@ Return Value:
     }
 
     KeReleaseQueuedLock(Device->ReceiveLock);
-    return;
+    return FramesProcessed;
 }
 
 VOID
@@ -505,6 +505,8 @@ Return Value:
     Properties.Interface.Send = E100Send;
     Properties.Interface.GetSetInformation = E100GetSetInformation;
     Properties.Interface.DestroyLink = E100DestroyLink;
+    Properties.Interface.Poll = E100Poll;
+    Properties.Interface.CompletePoll = E100CompletePoll;
     Status = NetAddLink(&Properties, &(Device->NetworkLink));
     if (!KSUCCESS(Status)) {
         goto AddNetworkDeviceEnd;
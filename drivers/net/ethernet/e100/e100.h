@@ -57,14 +57,15 @@ Module Name:
 
 //
 // Define macros for writing specifically to the SCB command and status
-// registers.
+// registers. Commands only write the low byte of the command register, as the
+// high byte holds the interrupt mask bits.
 //
 
 #define E100_READ_COMMAND_REGISTER(_Controller) \
     E100_READ_REGISTER16(_Controller, E100RegisterCommand)
 
 #define E100_WRITE_COMMAND_REGISTER(_Controller, _Value) \
-    E100_WRITE_REGISTER16(_Controller, E100RegisterCommand, _Value)
+    E100_WRITE_REGISTER8(_Controller, E100RegisterCommand, _Value)
 
 #define E100_READ_STATUS_REGISTER(_Controller) \
     E100_READ_REGISTER16(_Controller, E100RegisterStatus)
@@ -190,6 +191,15 @@ Module Name:
 #define E100_COMMAND_RECEIVE_LOAD_BASE            0x0006
 #define E100_COMMAND_RECEIVE_COMMAND_MASK         0x0007
 
+//
+// Define the value written to the interrupt control byte of the command
+// register to mask the receive interrupts while the device is being polled.
+//
+
+#define E100_INTERRUPT_CONTROL_RECEIVE_MASK         \
+    ((E100_COMMAND_MASK_FRAME_RECEIVED |            \
+      E100_COMMAND_MASK_RECEIVE_NOT_READY) >> BITS_PER_BYTE)
+
 //
 // Define E100 command bits.
 //
@@ -314,6 +324,7 @@ typedef enum _E100_REGISTER {
     E100RegisterStatus              = 0x0,
     E100RegisterAcknowledge         = 0x1,
     E100RegisterCommand             = 0x2,
+    E100RegisterInterruptControl    = 0x3,
     E100RegisterPointer             = 0x4,
     E100RegisterPort                = 0x8,
     E100RegisterEepromControl       = 0xE,
@@ -628,6 +639,55 @@ Return Value:
 
 --*/
 
+ULONG
+E100Poll (
+    PVOID DeviceContext,
+    ULONG Budget
+    );
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames while the networking core polls
+    the device.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed.
+
+--*/
+
+VOID
+E100CompletePoll (
+    PVOID DeviceContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine unmasks the receive interrupts once the networking core has
+    drained the receive ring.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 E100pInitializeDeviceStructures (
     PE100_DEVICE Device
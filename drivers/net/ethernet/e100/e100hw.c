@@ -76,9 +76,10 @@ E100pReapCompletedCommands (
     PE100_DEVICE Device
     );
 
-VOID
+ULONG
 E100pReapReceivedFrames (
-    PE100_DEVICE Device
+    PE100_DEVICE Device,
+    ULONG Budget
     );
 
 VOID
@@ -234,6 +235,75 @@ Return Value:
     return Status;
 }
 
+ULONG
+E100Poll (
+    PVOID DeviceContext,
+    ULONG Budget
+    )
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames while the networking core polls
+    the device.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed.
+
+--*/
+
+{
+
+    return E100pReapReceivedFrames((PE100_DEVICE)DeviceContext, Budget);
+}
+
+VOID
+E100CompletePoll (
+    PVOID DeviceContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine unmasks the receive interrupts once the networking core has
+    drained the receive ring.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PE100_DEVICE Device;
+
+    //
+    // The interrupt control byte only ever holds the receive mask or nothing,
+    // so there is no need to synchronize with the interrupt service routine.
+    // Status bits that were set while masked raise an interrupt right away.
+    //
+
+    Device = (PE100_DEVICE)DeviceContext;
+    E100_WRITE_REGISTER8(Device, E100RegisterInterruptControl, 0);
+    return;
+}
+
 KSTATUS
 E100pInitializeDeviceStructures (
     PE100_DEVICE Device
@@ -724,6 +794,20 @@ Return Value:
         E100_WRITE_REGISTER8(Device,
                              E100RegisterAcknowledge,
                              PendingBits >> BITS_PER_BYTE);
+
+        //
+        // Received frames are handed to the networking core to poll, so mask
+        // the receive interrupts until it is done.
+        //
+
+        if ((PendingBits &
+             (E100_STATUS_RECEIVE_NOT_READY |
+              E100_STATUS_FRAME_RECEIVED)) != 0) {
+
+            E100_WRITE_REGISTER8(Device,
+                                 E100RegisterInterruptControl,
+                                 E100_INTERRUPT_CONTROL_RECEIVE_MASK);
+        }
     }
 
     return InterruptStatus;
@@ -772,14 +856,14 @@ Return Value:
 
     //
     // Handle the receive unit leaving the ready state and new frames
-    // coming in.
+    // coming in by having the networking core poll the device.
     //
 
     ProcessFramesMask = E100_STATUS_RECEIVE_NOT_READY |
                         E100_STATUS_FRAME_RECEIVED;
 
     if ((PendingBits & ProcessFramesMask) != 0) {
-        E100pReapReceivedFrames(Device);
+        NetSchedulePoll(Device->NetworkLink);
     }
 
     //
@@ -1252,9 +1336,10 @@ Return Value:
     return;
 }
 
-VOID
+ULONG
 E100pReapReceivedFrames (
-    PE100_DEVICE Device
+    PE100_DEVICE Device,
+    ULONG Budget
     )
 
 /*++
@@ -1267,15 +1352,18 @@ Routine Description:
 
     Device - Supplies a pointer to the device.
 
+    Budget - Supplies the maximum number of frames to process.
+
 Return Value:
 
-    None.
+    Returns the number of frames processed.
 
 --*/
 
 {
 
     PE100_RECEIVE_FRAME Frame;
+    ULONG FramesProcessed;
     PE100_RECEIVE_FRAME LastFrame;
     ULONG ListBegin;
     ULONG ListEnd;
@@ -1286,15 +1374,16 @@ Return Value:
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
     //
-    // Loop grabbing completed frames.
+    // Loop grabbing completed frames until the budget runs out.
     //
 
+    FramesProcessed = 0;
     Packet.Flags = 0;
     KeAcquireQueuedLock(Device->ReceiveListLock);
     ReceivePhysicalAddress =
             (ULONG)(Device->ReceiveFrameIoBuffer->Fragment[0].PhysicalAddress);
 
-    while (TRUE) {
+    while (FramesProcessed < Budget) {
         ListBegin = Device->ReceiveListBegin;
         Frame = &(Device->ReceiveFrame[ListBegin]);
 
@@ -1352,6 +1441,8 @@ Return Value:
         Device->ReceiveListBegin = E100_INCREMENT_RING_INDEX(
                                                       ListBegin,
                                                       E100_RECEIVE_FRAME_COUNT);
+
+        FramesProcessed += 1;
     }
 
     //
@@ -1369,7 +1460,7 @@ Return Value:
     }
 
     KeReleaseQueuedLock(Device->ReceiveListLock);
-    return;
+    return FramesProcessed;
 }
 
 VOID
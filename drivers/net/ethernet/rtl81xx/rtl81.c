@@ -525,6 +525,8 @@ Return Value:
     Properties.Interface.Send = Rtl81Send;
     Properties.Interface.GetSetInformation = Rtl81GetSetInformation;
     Properties.Interface.DestroyLink = Rtl81DestroyLink;
+    Properties.Interface.Poll = Rtl81Poll;
+    Properties.Interface.CompletePoll = Rtl81CompletePoll;
     Status = NetAddLink(&Properties, &(Device->NetworkLink));
     if (!KSUCCESS(Status)) {
         goto AddNetworkDeviceEnd;
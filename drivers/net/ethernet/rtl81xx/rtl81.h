@@ -57,6 +57,14 @@ Module Name:
     HlWriteRegister8((PUCHAR)(_Controller)->ControllerBase + (_Register), \
                      (_Value))
 
+//
+// Define a macro for converting an interrupt mitigation register field into a
+// coalescing value.
+//
+
+#define RTL81_MITIGATION_DECODE(_Register, _Unit, _Shift) \
+    ((((_Register) >> (_Shift)) & RTL81_MITIGATION_FIELD_MASK) * (_Unit))
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -480,6 +488,21 @@ Module Name:
 
 #define RTL81_EARLY_TRANSMIT_THRESHOLD_DEFAULT 0x3F
 
+//
+// Define the interrupt mitigation register bits, found on all but the legacy
+// RTL8139 devices. Frame counts are in units of four frames. The timer unit
+// varies with the link speed and chip; the value here is the gigabit unit on
+// the RTL8168, which is the common case.
+//
+
+#define RTL81_MITIGATION_TRANSMIT_TIMER_SHIFT  12
+#define RTL81_MITIGATION_TRANSMIT_FRAMES_SHIFT 8
+#define RTL81_MITIGATION_RECEIVE_TIMER_SHIFT   4
+#define RTL81_MITIGATION_RECEIVE_FRAMES_SHIFT  0
+#define RTL81_MITIGATION_FIELD_MASK            0xF
+#define RTL81_MITIGATION_FRAME_UNIT            4
+#define RTL81_MITIGATION_TIMER_UNIT            5
+
 //
 // Define the receive packet header flags.
 //
@@ -768,6 +791,7 @@ typedef enum _RTL81_REGISTER {
     Rtl81RegisterTransmitPriorityPolling2 = 0xD9,
     Rtl81RegisterReceiveMaxPacketSize = 0xDA,
     Rtl81RegisterCommand2 = 0xE0,
+    Rtl81RegisterInterruptMitigation = 0xE2,
     Rtl81RegisterReceiveDescriptorBaseLow = 0xE4,
     Rtl81RegisterReceiveDescriptorBaseHigh = 0xE8,
     Rtl81RegisterEarlyTransmitThreshold = 0xEC
@@ -998,6 +1022,13 @@ Structure Description:
     PendingInterrupts - Stores the bitmask of pending interrupts. See
         RTL81_INTERRUPT_* for definitions.
 
+    InterruptLock - Stores the spin lock, synchronized at the interrupt
+        run level, that synchronizes access to the enabled interrupts mask.
+
+    EnabledInterrupts - Stores the bitmask of interrupts currently enabled.
+        The receive interrupts are left out of this while the networking core
+        is polling the device.
+
     MacAddress - Stores the default MAC address of the device.
 
     TransmitPacketList - Stores the list of network packets waiting to be sent.
@@ -1034,6 +1065,8 @@ typedef struct _RTL81_DEVICE {
     ULONG PciMsiFlags;
     INTERFACE_PCI_MSI PciMsiInterface;
     volatile ULONG PendingInterrupts;
+    KSPIN_LOCK InterruptLock;
+    USHORT EnabledInterrupts;
     BYTE MacAddress[ETHERNET_ADDRESS_SIZE];
     NET_PACKET_LIST TransmitPacketList;
     ULONG MaxTransmitPacketListCount;
@@ -1122,6 +1155,55 @@ Return Value:
 
 --*/
 
+ULONG
+Rtl81Poll (
+    PVOID DeviceContext,
+    ULONG Budget
+    );
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames while the networking core polls
+    the device.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed.
+
+--*/
+
+VOID
+Rtl81CompletePoll (
+    PVOID DeviceContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine re-enables the receive interrupts once the networking core
+    has drained the receive ring.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 Rtl81pInitializeDeviceStructures (
     PRTL81_DEVICE Device
@@ -102,19 +102,22 @@ Rtl81pSendPacketsDefault (
     PRTL81_DEVICE Device
     );
 
-VOID
+ULONG
 Rtl81pReapReceivedFrames (
-    PRTL81_DEVICE Device
+    PRTL81_DEVICE Device,
+    ULONG Budget
     );
 
-VOID
+ULONG
 Rtl81pReapReceivedFramesLegacy (
-    PRTL81_DEVICE Device
+    PRTL81_DEVICE Device,
+    ULONG Budget
     );
 
-VOID
+ULONG
 Rtl81pReapReceivedFramesDefault (
-    PRTL81_DEVICE Device
+    PRTL81_DEVICE Device,
+    ULONG Budget
     );
 
 KSTATUS
@@ -122,6 +125,13 @@ Rtl81pReadMacAddress (
     PRTL81_DEVICE Device
     );
 
+USHORT
+Rtl81pEncodeMitigationField (
+    ULONG Value,
+    ULONG Unit,
+    ULONG Shift
+    );
+
 KSTATUS
 Rtl81pReadMdio (
     PRTL81_DEVICE Device,
@@ -255,6 +265,7 @@ Return Value:
 {
 
     ULONG ChangedFlags;
+    PNET_LINK_INTERRUPT_COALESCING Coalescing;
     PRTL81_DEVICE Device;
     PULONG Flags;
     KSTATUS Status;
@@ -337,6 +348,79 @@ Return Value:
         KeReleaseQueuedLock(Device->ReceiveLock);
         break;
 
+    case NetLinkInformationInterruptCoalescing:
+        if (*DataSize != sizeof(NET_LINK_INTERRUPT_COALESCING)) {
+            Status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        //
+        // The legacy RTL8139 devices have no interrupt mitigation register.
+        //
+
+        if ((Device->Flags & RTL81_FLAG_TRANSMIT_MODE_LEGACY) != 0) {
+            Status = STATUS_NOT_SUPPORTED;
+            break;
+        }
+
+        //
+        // Program the register for a set. Either way, report back the values
+        // the hardware actually ended up with.
+        //
+
+        Status = STATUS_SUCCESS;
+        Coalescing = (PNET_LINK_INTERRUPT_COALESCING)Data;
+        if (Set != FALSE) {
+            Value = Rtl81pEncodeMitigationField(
+                                        Coalescing->TransmitMicroseconds,
+                                        RTL81_MITIGATION_TIMER_UNIT,
+                                        RTL81_MITIGATION_TRANSMIT_TIMER_SHIFT);
+
+            Value |= Rtl81pEncodeMitigationField(
+                                       Coalescing->TransmitFrames,
+                                       RTL81_MITIGATION_FRAME_UNIT,
+                                       RTL81_MITIGATION_TRANSMIT_FRAMES_SHIFT);
+
+            Value |= Rtl81pEncodeMitigationField(
+                                         Coalescing->ReceiveMicroseconds,
+                                         RTL81_MITIGATION_TIMER_UNIT,
+                                         RTL81_MITIGATION_RECEIVE_TIMER_SHIFT);
+
+            Value |= Rtl81pEncodeMitigationField(
+                                        Coalescing->ReceiveFrames,
+                                        RTL81_MITIGATION_FRAME_UNIT,
+                                        RTL81_MITIGATION_RECEIVE_FRAMES_SHIFT);
+
+            RTL81_WRITE_REGISTER16(Device,
+                                   Rtl81RegisterInterruptMitigation,
+                                   Value);
+        }
+
+        Value = RTL81_READ_REGISTER16(Device,
+                                      Rtl81RegisterInterruptMitigation);
+
+        Coalescing->TransmitMicroseconds = RTL81_MITIGATION_DECODE(
+                                        Value,
+                                        RTL81_MITIGATION_TIMER_UNIT,
+                                        RTL81_MITIGATION_TRANSMIT_TIMER_SHIFT);
+
+        Coalescing->TransmitFrames = RTL81_MITIGATION_DECODE(
+                                       Value,
+                                       RTL81_MITIGATION_FRAME_UNIT,
+                                       RTL81_MITIGATION_TRANSMIT_FRAMES_SHIFT);
+
+        Coalescing->ReceiveMicroseconds = RTL81_MITIGATION_DECODE(
+                                         Value,
+                                         RTL81_MITIGATION_TIMER_UNIT,
+                                         RTL81_MITIGATION_RECEIVE_TIMER_SHIFT);
+
+        Coalescing->ReceiveFrames = RTL81_MITIGATION_DECODE(
+                                        Value,
+                                        RTL81_MITIGATION_FRAME_UNIT,
+                                        RTL81_MITIGATION_RECEIVE_FRAMES_SHIFT);
+
+        break;
+
     default:
         Status = STATUS_NOT_SUPPORTED;
         break;
@@ -345,6 +429,84 @@ Return Value:
     return Status;
 }
 
+ULONG
+Rtl81Poll (
+    PVOID DeviceContext,
+    ULONG Budget
+    )
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames while the networking core polls
+    the device.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed.
+
+--*/
+
+{
+
+    return Rtl81pReapReceivedFrames((PRTL81_DEVICE)DeviceContext, Budget);
+}
+
+VOID
+Rtl81CompletePoll (
+    PVOID DeviceContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine re-enables the receive interrupts once the networking core
+    has drained the receive ring.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PRTL81_DEVICE Device;
+    RUNLEVEL OldRunLevel;
+
+    Device = (PRTL81_DEVICE)DeviceContext;
+
+    //
+    // Frames that arrived since the ring was drained left their status bits
+    // set, so the interrupt fires as soon as it is unmasked.
+    //
+
+    OldRunLevel = IoRaiseToInterruptRunLevel(Device->InterruptHandle);
+    KeAcquireSpinLock(&(Device->InterruptLock));
+    Device->EnabledInterrupts |= Device->ReceiveInterruptMask;
+    RTL81_WRITE_REGISTER16(Device,
+                           Rtl81RegisterInterruptMask,
+                           Device->EnabledInterrupts);
+
+    KeReleaseSpinLock(&(Device->InterruptLock));
+    KeLowerRunLevel(OldRunLevel);
+    return;
+}
+
 KSTATUS
 Rtl81pInitializeDeviceStructures (
     PRTL81_DEVICE Device
@@ -398,6 +560,7 @@ Return Value:
     }
 
     NET_INITIALIZE_PACKET_LIST(&(Device->TransmitPacketList));
+    KeInitializeSpinLock(&(Device->InterruptLock));
 
     //
     // The range of different RTL81xx devices use various register sets and
@@ -916,9 +1079,10 @@ Return Value:
                            Rtl81RegisterInterruptStatus,
                            RTL81_DEFAULT_INTERRUPT_MASK);
 
+    Device->EnabledInterrupts = RTL81_DEFAULT_INTERRUPT_MASK;
     RTL81_WRITE_REGISTER16(Device,
                            Rtl81RegisterInterruptMask,
-                           RTL81_DEFAULT_INTERRUPT_MASK);
+                           Device->EnabledInterrupts);
 
     Status = STATUS_SUCCESS;
 
@@ -952,6 +1116,7 @@ Return Value:
 {
 
     PRTL81_DEVICE Device;
+    USHORT EnabledInterrupts;
     USHORT PendingBits;
 
     Device = (PRTL81_DEVICE)Context;
@@ -972,13 +1137,23 @@ Return Value:
     // firing. That said, disable and enable the interrupts even if MSIs are
     // not in use.
     //
+    // Received frames are handed to the networking core to poll, so leave the
+    // receive interrupts disabled until it is done.
+    //
 
+    KeAcquireSpinLock(&(Device->InterruptLock));
+    if ((PendingBits & Device->ReceiveInterruptMask) != 0) {
+        Device->EnabledInterrupts &= ~(Device->ReceiveInterruptMask);
+    }
+
+    EnabledInterrupts = Device->EnabledInterrupts;
     RTL81_WRITE_REGISTER16(Device, Rtl81RegisterInterruptMask, 0);
     RTL81_WRITE_REGISTER16(Device, Rtl81RegisterInterruptStatus, PendingBits);
     RTL81_WRITE_REGISTER16(Device,
                            Rtl81RegisterInterruptMask,
-                           RTL81_DEFAULT_INTERRUPT_MASK);
+                           EnabledInterrupts);
 
+    KeReleaseSpinLock(&(Device->InterruptLock));
     RtlAtomicOr32(&(Device->PendingInterrupts), PendingBits);
     return InterruptStatusClaimed;
 }
@@ -1043,11 +1218,12 @@ Return Value:
     }
 
     //
-    // If a packet was received, process it.
+    // If a packet was received, have the networking core poll for it. The
+    // interrupt service routine already disabled the receive interrupts.
     //
 
     if ((PendingBits & Device->ReceiveInterruptMask) != 0) {
-        Rtl81pReapReceivedFrames(Device);
+        NetSchedulePoll(Device->NetworkLink);
     }
 
     //
@@ -1786,9 +1962,10 @@ Return Value:
     return;
 }
 
-VOID
+ULONG
 Rtl81pReapReceivedFrames (
-    PRTL81_DEVICE Device
+    PRTL81_DEVICE Device,
+    ULONG Budget
     )
 
 /*++
@@ -1802,14 +1979,18 @@ Routine Description:
 
     Device - Supplies a pointer to the RTL81xx device.
 
+    Budget - Supplies the maximum number of frames to reap.
+
 Return Value:
 
-    None.
+    Returns the number of frames reaped.
 
 --*/
 
 {
 
+    ULONG FramesReaped;
+
     KeAcquireQueuedLock(Device->ReceiveLock);
 
     //
@@ -1818,19 +1999,20 @@ Return Value:
     //
 
     if ((Device->Flags & RTL81_FLAG_TRANSMIT_MODE_LEGACY) != 0) {
-        Rtl81pReapReceivedFramesLegacy(Device);
+        FramesReaped = Rtl81pReapReceivedFramesLegacy(Device, Budget);
 
     } else {
-        Rtl81pReapReceivedFramesDefault(Device);
+        FramesReaped = Rtl81pReapReceivedFramesDefault(Device, Budget);
     }
 
     KeReleaseQueuedLock(Device->ReceiveLock);
-    return;
+    return FramesReaped;
 }
 
-VOID
+ULONG
 Rtl81pReapReceivedFramesLegacy (
-    PRTL81_DEVICE Device
+    PRTL81_DEVICE Device,
+    ULONG Budget
     )
 
 /*++
@@ -1844,9 +2026,11 @@ Routine Description:
 
     Device - Supplies a pointer to the RTL81xx device.
 
+    Budget - Supplies the maximum number of frames to reap.
+
 Return Value:
 
-    None.
+    Returns the number of frames reaped.
 
 --*/
 
@@ -1859,6 +2043,7 @@ Return Value:
     BYTE EarlyStatus;
     USHORT EndOffset;
     PIO_BUFFER_FRAGMENT Fragment;
+    ULONG FramesReaped;
     PRTL81_PACKET_HEADER Header;
     PRTL81_LEGACY_DATA LegacyData;
     USHORT MaxBytesToReap;
@@ -1913,13 +2098,16 @@ Return Value:
     PhysicalAddress = Fragment->PhysicalAddress;
 
     //
-    // Loop until the buffer is empty according to the command register or
-    // until the maximum bytes have been reaped.
+    // Loop until the buffer is empty according to the command register, until
+    // the maximum bytes have been reaped, or until the budget runs out.
     //
 
     BytesReaped = 0;
+    FramesReaped = 0;
     CommandRegister = RTL81_READ_REGISTER8(Device, Rtl81RegisterCommand);
-    while ((CommandRegister & RTL81_COMMAND_REGISTER_BUFFER_EMPTY) == 0) {
+    while (((CommandRegister & RTL81_COMMAND_REGISTER_BUFFER_EMPTY) == 0) &&
+           (FramesReaped < Budget)) {
+
         Header = (PRTL81_PACKET_HEADER)(VirtualAddress + CurrentOffset);
 
         //
@@ -2029,6 +2217,7 @@ Return Value:
         Packet.DataOffset = 0;
         Packet.FooterOffset = PacketLength;
         NetProcessReceivedPacket(Device->NetworkLink, &Packet);
+        FramesReaped += 1;
 
         //
         // Move past this packet. The current offset is set to the end of the
@@ -2071,12 +2260,13 @@ Return Value:
         CommandRegister = RTL81_READ_REGISTER8(Device, Rtl81RegisterCommand);
     }
 
-    return;
+    return FramesReaped;
 }
 
-VOID
+ULONG
 Rtl81pReapReceivedFramesDefault (
-    PRTL81_DEVICE Device
+    PRTL81_DEVICE Device,
+    ULONG Budget
     )
 
 /*++
@@ -2091,9 +2281,12 @@ Routine Description:
 
     Device - Supplies a pointer to the RTL81xx device.
 
+    Budget - Supplies the maximum number of frames to reap. Descriptors
+        holding discarded frames count against the budget too.
+
 Return Value:
 
-    None.
+    Returns the number of frames reaped.
 
 --*/
 
@@ -2103,6 +2296,7 @@ Return Value:
     PRTL81_DEFAULT_DATA DefaultData;
     PRTL81_RECEIVE_DESCRIPTOR Descriptor;
     ULONG Flags;
+    ULONG FramesReaped;
     USHORT NextToReap;
     NET_PACKET_BUFFER Packet;
     ULONG Protocol;
@@ -2119,11 +2313,12 @@ Return Value:
     SegmentFlags = RTL81_RECEIVE_DESCRIPTOR_COMMAND_FIRST_SEGMENT |
                    RTL81_RECEIVE_DESCRIPTOR_COMMAND_LAST_SEGMENT;
 
+    FramesReaped = 0;
     while (TRUE) {
 
         //
         // If this isn't the first time around, advance the next to index and
-        // reset the current descriptor.
+        // reset the current descriptor. Stop once the budget is spent.
         //
 
         if (Descriptor != NULL) {
@@ -2137,6 +2332,10 @@ Return Value:
             }
 
             Descriptor->Command = Command;
+            FramesReaped += 1;
+            if (FramesReaped >= Budget) {
+                break;
+            }
         }
 
         //
@@ -2258,7 +2457,7 @@ Return Value:
         NetProcessReceivedPacket(Device->NetworkLink, &Packet);
     }
 
-    return;
+    return FramesReaped;
 }
 
 KSTATUS
@@ -2452,3 +2651,48 @@ Return Value:
     return STATUS_SUCCESS;
 }
 
+
+USHORT
+Rtl81pEncodeMitigationField (
+    ULONG Value,
+    ULONG Unit,
+    ULONG Shift
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a coalescing value into a field of the interrupt
+    mitigation register, rounding up and clipping to what the field can hold.
+
+Arguments:
+
+    Value - Supplies the coalescing value, in microseconds or frames.
+
+    Unit - Supplies the number of microseconds or frames per field unit.
+
+    Shift - Supplies the bit position of the field within the register.
+
+Return Value:
+
+    Returns the register bits for the field.
+
+--*/
+
+{
+
+    ULONG Field;
+
+    Field = Value / Unit;
+    if ((Value % Unit) != 0) {
+        Field += 1;
+    }
+
+    if (Field > RTL81_MITIGATION_FIELD_MASK) {
+        Field = RTL81_MITIGATION_FIELD_MASK;
+    }
+
+    return (USHORT)(Field << Shift);
+}
+
@@ -243,6 +243,7 @@ LIST_ENTRY NetLinkList;
 PSHARED_EXCLUSIVE_LOCK NetLinkListLock;
 
 UUID NetNetworkDeviceInformationUuid = NETWORK_DEVICE_INFORMATION_UUID;
+UUID NetCoalescingInformationUuid = NETWORK_DEVICE_COALESCING_INFORMATION_UUID;
 
 //
 // ------------------------------------------------------------------ Functions
@@ -344,6 +345,16 @@ Return Value:
                               0,
                               NetpCompareAddressTranslationEntries);
 
+    Status = NetpInitializeLinkPolling(Link);
+    if (!KSUCCESS(Status)) {
+        goto AddLinkEnd;
+    }
+
+    Status = NetpCreateLinkBufferPool(Link);
+    if (!KSUCCESS(Status)) {
+        goto AddLinkEnd;
+    }
+
     //
     // Find the appropriate data link layer and initialize it for this link.
     //
@@ -409,6 +420,14 @@ Return Value:
         goto AddLinkEnd;
     }
 
+    Status = IoRegisterDeviceInformation(Link->Properties.Device,
+                                         &NetCoalescingInformationUuid,
+                                         TRUE);
+
+    if (!KSUCCESS(Status)) {
+        goto AddLinkEnd;
+    }
+
     //
     // With success a sure thing, take a reference on the OS device that
     // registered the link with netcore. Its device context and driver need to
@@ -437,6 +456,10 @@ Return Value:
                                         &NetNetworkDeviceInformationUuid,
                                         FALSE);
 
+            IoRegisterDeviceInformation(Link->Properties.Device,
+                                        &NetCoalescingInformationUuid,
+                                        FALSE);
+
             //
             // If some network layer entries have initialized already, call
             // them back to cancel.
@@ -477,6 +500,8 @@ Return Value:
                 KeDestroyEvent(Link->AddressTranslationEvent);
             }
 
+            NetpDestroyLinkPolling(Link);
+            NetpDestroyLinkBufferPool(Link);
             MmFreePagedPool(Link);
             Link = NULL;
         }
@@ -872,6 +897,17 @@ Return Value:
         goto GetSetLinkDeviceInformationEnd;
     }
 
+    if (RtlAreUuidsEqual(Uuid, &NetCoalescingInformationUuid) != FALSE) {
+        if (*DataSize < sizeof(NETWORK_DEVICE_COALESCING_INFORMATION)) {
+            *DataSize = sizeof(NETWORK_DEVICE_COALESCING_INFORMATION);
+            goto GetSetLinkDeviceInformationEnd;
+        }
+
+        *DataSize = sizeof(NETWORK_DEVICE_COALESCING_INFORMATION);
+        Status = NetpGetSetLinkCoalescingInformation(Link, Data, Set);
+        goto GetSetLinkDeviceInformationEnd;
+    }
+
 GetSetLinkDeviceInformationEnd:
     return Status;
 }
@@ -913,6 +949,16 @@ Return Value:
                                 &NetNetworkDeviceInformationUuid,
                                 FALSE);
 
+    IoRegisterDeviceInformation(Link->Properties.Device,
+                                &NetCoalescingInformationUuid,
+                                FALSE);
+
+    //
+    // Make sure the device is not polled once it is gone.
+    //
+
+    NetpStopLinkPolling(Link);
+
     //
     // If the link is still up, then send out the notice that is is actually
     // down.
@@ -3495,6 +3541,8 @@ Return Value:
 
     KeReleaseSharedExclusiveLockShared(NetPluginListLock);
     Link->DataLinkEntry->Interface.DestroyLink(Link);
+    NetpDestroyLinkPolling(Link);
+    NetpDestroyLinkBufferPool(Link);
     Link->Properties.Interface.DestroyLink(Link->Properties.DeviceContext);
     IoDeviceReleaseReference(Link->Properties.Device);
     MmFreePagedPool(Link);
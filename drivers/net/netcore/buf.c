@@ -37,14 +37,170 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the number of free buffers each processor caches for a link.
+//
+
+#define NET_BUFFER_CACHE_SIZE 32
+
+//
+// Define the number of buffers moved between a processor's cache and the
+// pool's shared depot at once. This must be no more than half the cache size.
+//
+
+#define NET_BUFFER_POOL_BATCH_SIZE (NET_BUFFER_CACHE_SIZE / 2)
+
+//
+// Define the most free buffers a pool's depot holds before buffers get
+// released back to the system.
+//
+
+#define NET_BUFFER_POOL_DEPOT_LIMIT 256
+
+//
+// Define the largest buffer size a link pool is created for. Links with
+// bigger packets use the general free list.
+//
+
+#define NET_BUFFER_POOL_MAX_BUFFER_SIZE 0x2000
+
+//
+// Define buffer pool flags.
+//
+
+//
+// This flag is set once the pool's link has been destroyed. Buffers freed
+// after this point are released rather than recycled.
+//
+
+#define NET_BUFFER_POOL_FLAG_DESTROYED 0x00000001
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure defines a processor's private cache of free buffers for a
+    link. It is only touched at dispatch level by its own processor, so it
+    needs no lock.
+
+Members:
+
+    Count - Stores the number of buffers in the cache.
+
+    Buffers - Stores the cached buffers. The most recently freed buffer is at
+        the end, as it is the most likely to still be warm in the processor's
+        data cache.
+
+--*/
+
+typedef struct _NET_BUFFER_CACHE {
+    ULONG Count;
+    PNET_PACKET_BUFFER Buffers[NET_BUFFER_CACHE_SIZE];
+} NET_BUFFER_CACHE, *PNET_BUFFER_CACHE;
+
+/*++
+
+Structure Description:
+
+    This structure defines a pool of recycled packet buffers for a link. Every
+    buffer in the pool is the same size and meets the link's alignment and
+    physical address requirements, so any of them can satisfy an allocation
+    that fits.
+
+Members:
+
+    ReferenceCount - Stores the reference count of the pool. The link holds
+        one reference, and every buffer the pool has created holds another
+        until it is released back to the system.
+
+    Flags - Stores a bitmask of pool flags. See NET_BUFFER_POOL_FLAG_* for
+        definitions.
+
+    BufferSize - Stores the size of each buffer in the pool, in bytes.
+
+    Alignment - Stores the physical alignment of each buffer.
+
+    MaxPhysicalAddress - Stores the maximum physical address the link can
+        reach.
+
+    CacheCount - Stores the number of elements in the caches array.
+
+    Caches - Stores an array of free buffer caches, indexed by processor
+        number.
+
+    Dpc - Stores a pointer to the DPC used to synchronize with each
+        processor's cache when the pool is destroyed.
+
+    DepotLock - Stores a pointer to the lock protecting the depot.
+
+    DepotList - Stores the head of the list of free buffers shared between
+        all processors.
+
+    DepotCount - Stores the number of buffers on the depot list.
+
+--*/
+
+struct _NET_BUFFER_POOL {
+    volatile ULONG ReferenceCount;
+    volatile ULONG Flags;
+    ULONG BufferSize;
+    ULONG Alignment;
+    PHYSICAL_ADDRESS MaxPhysicalAddress;
+    ULONG CacheCount;
+    PNET_BUFFER_CACHE Caches;
+    PDPC Dpc;
+    PQUEUED_LOCK DepotLock;
+    LIST_ENTRY DepotList;
+    ULONG DepotCount;
+};
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+PNET_PACKET_BUFFER
+NetpAllocatePoolBuffer (
+    PNET_BUFFER_POOL Pool
+    );
+
+VOID
+NetpFreePoolBuffer (
+    PNET_BUFFER_POOL Pool,
+    PNET_PACKET_BUFFER Buffer
+    );
+
+VOID
+NetpReturnBuffersToDepot (
+    PNET_BUFFER_POOL Pool,
+    PNET_PACKET_BUFFER *Buffers,
+    ULONG Count
+    );
+
+PNET_PACKET_BUFFER
+NetpCreatePoolBuffer (
+    PNET_BUFFER_POOL Pool
+    );
+
+VOID
+NetpDestroyPoolBuffer (
+    PNET_BUFFER_POOL Pool,
+    PNET_PACKET_BUFFER Buffer
+    );
+
+VOID
+NetpBufferPoolReleaseReference (
+    PNET_BUFFER_POOL Pool
+    );
+
+VOID
+NetpBufferPoolDpcRoutine (
+    PDPC Dpc
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -75,7 +231,8 @@ NetAllocateBuffer (
 
 Routine Description:
 
-    This routine allocates a network buffer.
+    This routine allocates a network buffer. Buffers for a link that fit in
+    the link's maximum packet size are recycled through a per-link pool.
 
 Arguments:
 
@@ -123,6 +280,7 @@ Return Value:
     ULONG MinPacketSize;
     ULONG PacketSizeFlags;
     ULONG Padding;
+    PNET_BUFFER_POOL Pool;
     NET_PACKET_SIZE_INFORMATION SizeInformation;
     KSTATUS Status;
     ULONG TotalSize;
@@ -198,6 +356,25 @@ Return Value:
     TotalSize = DataSize + Padding;
     TotalSize = ALIGN_RANGE_UP(TotalSize, Alignment);
 
+    //
+    // Anything that fits in the link's pool comes from there, which usually
+    // means popping a buffer off of this processor's cache.
+    //
+
+    LockHeld = FALSE;
+    if (Link != NULL) {
+        Pool = Link->BufferPool;
+        if ((Pool != NULL) && (TotalSize <= Pool->BufferSize)) {
+            Buffer = NetpAllocatePoolBuffer(Pool);
+            Status = STATUS_SUCCESS;
+            if (Buffer == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+            }
+
+            goto AllocateBufferEnd;
+        }
+    }
+
     //
     // Loop through the list looking for the first buffer that fits.
     //
@@ -251,6 +428,8 @@ Return Value:
         goto AllocateBufferEnd;
     }
 
+    Buffer->Pool = NULL;
+
     //
     // A buffer will need to be allocated.
     //
@@ -344,6 +523,11 @@ Return Value:
 
 {
 
+    if (Buffer->Pool != NULL) {
+        NetpFreePoolBuffer(Buffer->Pool, Buffer);
+        return;
+    }
+
     KeAcquireQueuedLock(NetBufferListLock);
     INSERT_AFTER(&(Buffer->ListEntry), &NetFreeBufferList);
     KeReleaseQueuedLock(NetBufferListLock);
@@ -452,7 +636,645 @@ Return Value:
     return;
 }
 
+KSTATUS
+NetpCreateLinkBufferPool (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the pool of recycled packet buffers for a new link.
+    Buffers in the pool are sized to hold the link's largest packet.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being added.
+
+Return Value:
+
+    STATUS_SUCCESS on success, including if the link's packets are too large
+    to be pooled.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+--*/
+
+{
+
+    ULONG BufferSize;
+    ULONG CacheCount;
+    ULONG MinPacketSize;
+    PNET_BUFFER_POOL Pool;
+    KSTATUS Status;
+
+    ASSERT(Link->BufferPool == NULL);
+    ASSERT(POWER_OF_2(Link->Properties.TransmitAlignment));
+
+    BufferSize = Link->Properties.PacketSizeInformation.MaxPacketSize;
+    MinPacketSize = Link->Properties.PacketSizeInformation.MinPacketSize;
+    if (BufferSize < MinPacketSize) {
+        BufferSize = MinPacketSize;
+    }
+
+    BufferSize = ALIGN_RANGE_UP(BufferSize, Link->Properties.TransmitAlignment);
+    if ((BufferSize == 0) || (BufferSize > NET_BUFFER_POOL_MAX_BUFFER_SIZE)) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // The pool and its caches are touched at dispatch level, so they must be
+    // non-paged. The buffer headers themselves are only ever touched at low
+    // level.
+    //
+
+    Pool = MmAllocateNonPagedPool(sizeof(NET_BUFFER_POOL),
+                                  NET_CORE_ALLOCATION_TAG);
+
+    if (Pool == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateLinkBufferPoolEnd;
+    }
+
+    RtlZeroMemory(Pool, sizeof(NET_BUFFER_POOL));
+    Pool->ReferenceCount = 1;
+    Pool->BufferSize = BufferSize;
+    Pool->Alignment = Link->Properties.TransmitAlignment;
+    Pool->MaxPhysicalAddress = Link->Properties.MaxPhysicalAddress;
+    INITIALIZE_LIST_HEAD(&(Pool->DepotList));
+    Pool->DepotLock = KeCreateQueuedLock();
+    if (Pool->DepotLock == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateLinkBufferPoolEnd;
+    }
+
+    Pool->Dpc = KeCreateDpc(NetpBufferPoolDpcRoutine, Pool);
+    if (Pool->Dpc == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateLinkBufferPoolEnd;
+    }
+
+    CacheCount = KeGetActiveProcessorCount();
+    Pool->Caches = MmAllocateNonPagedPool(sizeof(NET_BUFFER_CACHE) * CacheCount,
+                                          NET_CORE_ALLOCATION_TAG);
+
+    if (Pool->Caches == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateLinkBufferPoolEnd;
+    }
+
+    RtlZeroMemory(Pool->Caches, sizeof(NET_BUFFER_CACHE) * CacheCount);
+    Pool->CacheCount = CacheCount;
+    Link->BufferPool = Pool;
+    Status = STATUS_SUCCESS;
+
+CreateLinkBufferPoolEnd:
+    if (!KSUCCESS(Status)) {
+        if (Pool != NULL) {
+            NetpBufferPoolReleaseReference(Pool);
+        }
+    }
+
+    return Status;
+}
+
+VOID
+NetpDestroyLinkBufferPool (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys the buffer pool of a link whose last reference has
+    been released. Free buffers are released back to the system, and buffers
+    still in use are released when they are freed.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_PACKET_BUFFER Buffer;
+    PNET_BUFFER_CACHE Cache;
+    PNET_BUFFER_POOL Pool;
+    ULONG Processor;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Pool = Link->BufferPool;
+    if (Pool == NULL) {
+        return;
+    }
+
+    Link->BufferPool = NULL;
+    RtlAtomicOr32(&(Pool->Flags), NET_BUFFER_POOL_FLAG_DESTROYED);
+
+    //
+    // Each processor only checks the destroyed flag and touches its cache
+    // while at dispatch level. Running a DPC on every processor waits out
+    // anyone already in there, and nobody goes near the caches after that.
+    //
+
+    for (Processor = 0; Processor < Pool->CacheCount; Processor += 1) {
+        KeQueueDpcOnProcessor(Pool->Dpc, Processor);
+        KeFlushDpc(Pool->Dpc);
+        Cache = &(Pool->Caches[Processor]);
+        while (Cache->Count != 0) {
+            Cache->Count -= 1;
+            NetpDestroyPoolBuffer(Pool, Cache->Buffers[Cache->Count]);
+        }
+    }
+
+    KeAcquireQueuedLock(Pool->DepotLock);
+    while (LIST_EMPTY(&(Pool->DepotList)) == FALSE) {
+        Buffer = LIST_VALUE(Pool->DepotList.Next,
+                            NET_PACKET_BUFFER,
+                            ListEntry);
+
+        LIST_REMOVE(&(Buffer->ListEntry));
+        NetpDestroyPoolBuffer(Pool, Buffer);
+    }
+
+    Pool->DepotCount = 0;
+    KeReleaseQueuedLock(Pool->DepotLock);
+    NetpBufferPoolReleaseReference(Pool);
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+PNET_PACKET_BUFFER
+NetpAllocatePoolBuffer (
+    PNET_BUFFER_POOL Pool
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates a buffer from a link's pool.
+
+Arguments:
+
+    Pool - Supplies a pointer to the pool to allocate from.
+
+Return Value:
+
+    Returns a pointer to the buffer on success. The caller is responsible for
+    initializing the size and offset fields.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PNET_PACKET_BUFFER Batch[NET_BUFFER_POOL_BATCH_SIZE];
+    PNET_PACKET_BUFFER Buffer;
+    PNET_BUFFER_CACHE Cache;
+    ULONG Count;
+    ULONG Index;
+    RUNLEVEL OldRunLevel;
+    ULONG Processor;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+    ASSERT((Pool->Flags & NET_BUFFER_POOL_FLAG_DESTROYED) == 0);
+
+    //
+    // Raising to dispatch keeps the thread on this processor, which is all
+    // the protection the processor's cache needs.
+    //
+
+    Buffer = NULL;
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Processor = KeGetCurrentProcessorNumber();
+    if (Processor < Pool->CacheCount) {
+        Cache = &(Pool->Caches[Processor]);
+        if (Cache->Count != 0) {
+            Cache->Count -= 1;
+            Buffer = Cache->Buffers[Cache->Count];
+        }
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+    if (Buffer != NULL) {
+        return Buffer;
+    }
+
+    //
+    // The cache is empty. Refill it with a batch from the depot, keeping one
+    // for the caller. If the depot is empty too, the pool has to grow.
+    //
+
+    Count = 0;
+    KeAcquireQueuedLock(Pool->DepotLock);
+    while ((Count < NET_BUFFER_POOL_BATCH_SIZE) &&
+           (LIST_EMPTY(&(Pool->DepotList)) == FALSE)) {
+
+        Batch[Count] = LIST_VALUE(Pool->DepotList.Next,
+                                  NET_PACKET_BUFFER,
+                                  ListEntry);
+
+        LIST_REMOVE(&(Batch[Count]->ListEntry));
+        Count += 1;
+    }
+
+    Pool->DepotCount -= Count;
+    KeReleaseQueuedLock(Pool->DepotLock);
+    if (Count == 0) {
+        return NetpCreatePoolBuffer(Pool);
+    }
+
+    Count -= 1;
+    Buffer = Batch[Count];
+    if (Count == 0) {
+        return Buffer;
+    }
+
+    Index = 0;
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Processor = KeGetCurrentProcessorNumber();
+    if (Processor < Pool->CacheCount) {
+        Cache = &(Pool->Caches[Processor]);
+        while ((Index < Count) && (Cache->Count < NET_BUFFER_CACHE_SIZE)) {
+            Cache->Buffers[Cache->Count] = Batch[Index];
+            Cache->Count += 1;
+            Index += 1;
+        }
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+
+    //
+    // If the thread got moved to a processor whose cache filled up in the
+    // meantime, put the rest back.
+    //
+
+    if (Index != Count) {
+        NetpReturnBuffersToDepot(Pool, &(Batch[Index]), Count - Index);
+    }
+
+    return Buffer;
+}
+
+VOID
+NetpFreePoolBuffer (
+    PNET_BUFFER_POOL Pool,
+    PNET_PACKET_BUFFER Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns a buffer to its link's pool.
+
+Arguments:
+
+    Pool - Supplies a pointer to the pool the buffer came from.
+
+    Buffer - Supplies a pointer to the buffer to free.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_PACKET_BUFFER Batch[NET_BUFFER_POOL_BATCH_SIZE];
+    PNET_BUFFER_CACHE Cache;
+    ULONG Count;
+    ULONG Index;
+    RUNLEVEL OldRunLevel;
+    ULONG Processor;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Count = 0;
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    if ((Pool->Flags & NET_BUFFER_POOL_FLAG_DESTROYED) == 0) {
+        Processor = KeGetCurrentProcessorNumber();
+        if (Processor < Pool->CacheCount) {
+            Cache = &(Pool->Caches[Processor]);
+
+            //
+            // If the cache is full, move its oldest half out to the depot to
+            // make room, keeping the warmer buffers here.
+            //
+
+            if (Cache->Count == NET_BUFFER_CACHE_SIZE) {
+                Count = NET_BUFFER_POOL_BATCH_SIZE;
+                for (Index = 0; Index < Count; Index += 1) {
+                    Batch[Index] = Cache->Buffers[Index];
+                }
+
+                for (Index = Count; Index < Cache->Count; Index += 1) {
+                    Cache->Buffers[Index - Count] = Cache->Buffers[Index];
+                }
+
+                Cache->Count -= Count;
+            }
+
+            Cache->Buffers[Cache->Count] = Buffer;
+            Cache->Count += 1;
+            Buffer = NULL;
+        }
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+
+    //
+    // A buffer that could not be cached goes straight to the depot, which
+    // releases it if the pool is being destroyed.
+    //
+
+    if (Buffer != NULL) {
+
+        ASSERT(Count == 0);
+
+        Batch[0] = Buffer;
+        Count = 1;
+    }
+
+    if (Count != 0) {
+        NetpReturnBuffersToDepot(Pool, Batch, Count);
+    }
+
+    return;
+}
+
+VOID
+NetpReturnBuffersToDepot (
+    PNET_BUFFER_POOL Pool,
+    PNET_PACKET_BUFFER *Buffers,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine puts free buffers on a pool's depot list. Buffers that do not
+    fit, or that arrive while the system is low on memory or the pool is being
+    destroyed, are released back to the system instead.
+
+Arguments:
+
+    Pool - Supplies a pointer to the pool the buffers came from.
+
+    Buffers - Supplies an array of free buffers.
+
+    Count - Supplies the number of elements in the buffers array.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_PACKET_BUFFER Buffer;
+    ULONG Index;
+    BOOL Trim;
+    LIST_ENTRY TrimList;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Trim = FALSE;
+    if (MmGetPhysicalMemoryWarningLevel() != MemoryWarningLevelNone) {
+        Trim = TRUE;
+    }
+
+    Index = 0;
+    INITIALIZE_LIST_HEAD(&TrimList);
+    KeAcquireQueuedLock(Pool->DepotLock);
+    if (((Pool->Flags & NET_BUFFER_POOL_FLAG_DESTROYED) == 0) &&
+        (Trim == FALSE)) {
+
+        while ((Index < Count) &&
+               (Pool->DepotCount < NET_BUFFER_POOL_DEPOT_LIMIT)) {
+
+            INSERT_AFTER(&(Buffers[Index]->ListEntry), &(Pool->DepotList));
+            Pool->DepotCount += 1;
+            Index += 1;
+        }
+
+    //
+    // When memory is tight, give back everything the depot is holding too.
+    // A destroyed pool's depot has already been emptied.
+    //
+
+    } else if (LIST_EMPTY(&(Pool->DepotList)) == FALSE) {
+        MOVE_LIST(&(Pool->DepotList), &TrimList);
+        INITIALIZE_LIST_HEAD(&(Pool->DepotList));
+        Pool->DepotCount = 0;
+    }
+
+    KeReleaseQueuedLock(Pool->DepotLock);
+
+    //
+    // Each released buffer drops a pool reference, so the pool may be gone
+    // once the last one is released.
+    //
+
+    while (LIST_EMPTY(&TrimList) == FALSE) {
+        Buffer = LIST_VALUE(TrimList.Next, NET_PACKET_BUFFER, ListEntry);
+        LIST_REMOVE(&(Buffer->ListEntry));
+        NetpDestroyPoolBuffer(Pool, Buffer);
+    }
+
+    while (Index < Count) {
+        NetpDestroyPoolBuffer(Pool, Buffers[Index]);
+        Index += 1;
+    }
+
+    return;
+}
+
+PNET_PACKET_BUFFER
+NetpCreatePoolBuffer (
+    PNET_BUFFER_POOL Pool
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new buffer for a link's pool.
+
+Arguments:
+
+    Pool - Supplies a pointer to the pool to grow.
+
+Return Value:
+
+    Returns a pointer to the new buffer on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PNET_PACKET_BUFFER Buffer;
+    ULONG IoBufferFlags;
+
+    Buffer = MmAllocatePagedPool(sizeof(NET_PACKET_BUFFER),
+                                 NET_CORE_ALLOCATION_TAG);
+
+    if (Buffer == NULL) {
+        return NULL;
+    }
+
+    IoBufferFlags = IO_BUFFER_FLAG_PHYSICALLY_CONTIGUOUS;
+    Buffer->IoBuffer = MmAllocateNonPagedIoBuffer(0,
+                                                  Pool->MaxPhysicalAddress,
+                                                  Pool->Alignment,
+                                                  Pool->BufferSize,
+                                                  IoBufferFlags);
+
+    if (Buffer->IoBuffer == NULL) {
+        MmFreePagedPool(Buffer);
+        return NULL;
+    }
+
+    ASSERT(Buffer->IoBuffer->FragmentCount == 1);
+
+    Buffer->BufferPhysicalAddress =
+                                 Buffer->IoBuffer->Fragment[0].PhysicalAddress;
+
+    Buffer->Buffer = Buffer->IoBuffer->Fragment[0].VirtualAddress;
+    Buffer->Pool = Pool;
+    RtlAtomicAdd32(&(Pool->ReferenceCount), 1);
+    return Buffer;
+}
+
+VOID
+NetpDestroyPoolBuffer (
+    PNET_BUFFER_POOL Pool,
+    PNET_PACKET_BUFFER Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a pool buffer back to the system.
+
+Arguments:
+
+    Pool - Supplies a pointer to the pool that created the buffer.
+
+    Buffer - Supplies a pointer to the buffer to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(Buffer->Pool == Pool);
+
+    MmFreeIoBuffer(Buffer->IoBuffer);
+    MmFreePagedPool(Buffer);
+    NetpBufferPoolReleaseReference(Pool);
+    return;
+}
+
+VOID
+NetpBufferPoolReleaseReference (
+    PNET_BUFFER_POOL Pool
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a reference on a link buffer pool, freeing it if
+    that was the last reference.
+
+Arguments:
+
+    Pool - Supplies a pointer to the pool.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldReferenceCount;
+
+    OldReferenceCount = RtlAtomicAdd32(&(Pool->ReferenceCount), (ULONG)-1);
+
+    ASSERT((OldReferenceCount != 0) && (OldReferenceCount < 0x20000000));
+
+    if (OldReferenceCount != 1) {
+        return;
+    }
+
+    ASSERT(LIST_EMPTY(&(Pool->DepotList)) != FALSE);
+
+    if (Pool->Caches != NULL) {
+        MmFreeNonPagedPool(Pool->Caches);
+    }
+
+    if (Pool->Dpc != NULL) {
+        KeDestroyDpc(Pool->Dpc);
+    }
+
+    if (Pool->DepotLock != NULL) {
+        KeDestroyQueuedLock(Pool->DepotLock);
+    }
+
+    MmFreeNonPagedPool(Pool);
+    return;
+}
+
+VOID
+NetpBufferPoolDpcRoutine (
+    PDPC Dpc
+    )
+
+/*++
+
+Routine Description:
+
+    This routine runs on each processor while a link's buffer pool is being
+    destroyed. It has nothing to do; the fact that it ran means the processor
+    is no longer touching its cache.
+
+Arguments:
+
+    Dpc - Supplies a pointer to the DPC that is running.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    return;
+}
+
@@ -37,6 +37,7 @@ function build() {
         "ethernet.c",
         "ip4.c",
         "netcore.c",
+        "poll.c",
         "netlink/netlink.c",
         "netlink/genctrl.c",
         "netlink/generic.c",
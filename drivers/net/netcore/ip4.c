@@ -1790,51 +1790,12 @@ Return Value:
 
 {
 
-    PUCHAR BytePointer;
-    PULONG LongPointer;
-    ULONG NextValue;
-    USHORT ShortOne;
-    PUSHORT ShortPointer;
-    USHORT ShortTwo;
     ULONG Sum;
 
     ASSERT((Length & 0x1) == 0);
 
-    Sum = 0;
-    LongPointer = (PULONG)Data;
-    while (Length >= sizeof(ULONG)) {
-        NextValue = *LongPointer;
-        LongPointer += 1;
-        Sum += NextValue;
-        if (Sum < NextValue) {
-            Sum += 1;
-        }
-
-        Length -= sizeof(ULONG);
-    }
-
-    BytePointer = (PUCHAR)LongPointer;
-    if (Length == sizeof(USHORT)) {
-        ShortPointer = (PUSHORT)BytePointer;
-        NextValue = (USHORT)*ShortPointer;
-        Sum += NextValue;
-        if (Sum < NextValue) {
-            Sum += 1;
-        }
-    }
-
-    //
-    // Fold the 32-bit value down to 16-bits.
-    //
-
-    ShortOne = (USHORT)Sum;
-    ShortTwo = (USHORT)(Sum >> 16);
-    ShortTwo += ShortOne;
-    if (ShortTwo < ShortOne) {
-        ShortTwo += 1;
-    }
-
-    return (USHORT)~ShortTwo;
+    Sum = RtlComputeInternetChecksum(0, Data, Length);
+    return RtlFoldInternetChecksum(Sum);
 }
 
 KSTATUS
@@ -351,6 +351,11 @@ Return Value:
         goto DriverEntryEnd;
     }
 
+    Status = NetpInitializePolling();
+    if (!KSUCCESS(Status)) {
+        goto DriverEntryEnd;
+    }
+
     //
     // Set up the built in protocols, networks, data links and miscellaneous
     // components.
@@ -52,6 +52,29 @@ Module Name:
 
 #define NET_PRINT_ADDRESS_STRING_LENGTH 200
 
+//
+// Define the link poll state flags.
+//
+
+//
+// This flag is set while a poll work item is queued or running for the link.
+//
+
+#define NET_LINK_POLL_SCHEDULED 0x00000001
+
+//
+// This flag is set if the device asked to be polled since the current poll
+// round started.
+//
+
+#define NET_LINK_POLL_PENDING 0x00000002
+
+//
+// This flag is set once the link's device has been removed.
+//
+
+#define NET_LINK_POLL_REMOVED 0x00000004
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -151,6 +174,184 @@ Return Value:
 
 --*/
 
+KSTATUS
+NetpCreateLinkBufferPool (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates the pool of recycled packet buffers for a new link.
+    Buffers in the pool are sized to hold the link's largest packet.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being added.
+
+Return Value:
+
+    STATUS_SUCCESS on success, including if the link's packets are too large
+    to be pooled.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+--*/
+
+VOID
+NetpDestroyLinkBufferPool (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys the buffer pool of a link whose last reference has
+    been released. Free buffers are released back to the system, and buffers
+    still in use are released when they are freed.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+NetpInitializePolling (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes support for polling network links.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+NetpInitializeLinkPolling (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets up polling for a new link, if its device supports it.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being added.
+
+Return Value:
+
+    STATUS_SUCCESS on success, including if the device does not support
+    polling.
+
+    STATUS_INVALID_PARAMETER if the device supplied only one of the poll and
+    complete poll routines.
+
+    STATUS_INSUFFICIENT_RESOURCES if the work item could not be allocated.
+
+--*/
+
+VOID
+NetpStopLinkPolling (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine stops polling a link whose device is being removed. On
+    return, the device's poll routine is not running and will not be called
+    again.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being removed.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+NetpDestroyLinkPolling (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys the polling state of a link whose last reference
+    has been released.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+NetpGetSetLinkCoalescingInformation (
+    PNET_LINK Link,
+    PNETWORK_DEVICE_COALESCING_INFORMATION Information,
+    BOOL Set
+    );
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the interrupt coalescing and polling settings of
+    a link.
+
+Arguments:
+
+    Link - Supplies a pointer to the link to work with.
+
+    Information - Supplies a pointer that either receives the coalescing
+        information, or contains the new information to set. For set
+        operations, the information buffer will contain the current settings
+        on return.
+
+    Set - Supplies a boolean indicating if the information should be set or
+        returned.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the version or poll budget is invalid.
+
+    STATUS_NOT_SUPPORTED if non-zero coalescing values were supplied for a
+    device without hardware interrupt coalescing.
+
+--*/
+
 COMPARISON_RESULT
 NetpCompareNetworkAddresses (
     PNETWORK_ADDRESS FirstAddress,
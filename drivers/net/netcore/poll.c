@@ -0,0 +1,501 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    poll.c
+
+Abstract:
+
+    This module implements budgeted polling of network links. Devices that
+    support it mask their receive interrupt and ask to be polled, and the
+    networking core then drains their receive rings a bounded number of
+    frames at a time, unmasking the interrupt again once the ring is empty.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/driver.h>
+#include "netcore.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+NetpPollLinkWorker (
+    PVOID Parameter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the work queue that all polled links are drained on.
+//
+
+PWORK_QUEUE NetPollWorkQueue;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+NET_API
+VOID
+NetSchedulePoll (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine asks the networking core to poll a link for received frames.
+    The device must mask its receive interrupt before calling this routine,
+    and leave it masked until the networking core calls the complete poll
+    routine. Calling this while a poll is already scheduled makes sure the
+    device gets polled once more before polling completes. This routine must
+    be called at low level.
+
+Arguments:
+
+    Link - Supplies a pointer to the link to poll. The link's device must
+        supply the poll and complete poll routines.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldState;
+    KSTATUS Status;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+    ASSERT(Link->PollWorkItem != NULL);
+
+    OldState = RtlAtomicOr32(&(Link->PollState),
+                             NET_LINK_POLL_SCHEDULED | NET_LINK_POLL_PENDING);
+
+    //
+    // If a poll is already underway, the pending flag set above will make it
+    // go around again before finishing.
+    //
+
+    if ((OldState & NET_LINK_POLL_SCHEDULED) != 0) {
+        return;
+    }
+
+    //
+    // Links on their way out do not get polled anymore.
+    //
+
+    if ((OldState & NET_LINK_POLL_REMOVED) != 0) {
+        RtlAtomicAnd32(&(Link->PollState), ~NET_LINK_POLL_SCHEDULED);
+        return;
+    }
+
+    //
+    // The scheduled poll holds a reference on the link, released when the
+    // worker finishes polling.
+    //
+
+    NetLinkAddReference(Link);
+    Status = KeQueueWorkItem(Link->PollWorkItem);
+
+    ASSERT(KSUCCESS(Status));
+
+    return;
+}
+
+KSTATUS
+NetpInitializePolling (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes support for polling network links.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    NetPollWorkQueue = KeCreateWorkQueue(0, "NetPollWorker");
+    if (NetPollWorkQueue == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+NetpInitializeLinkPolling (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets up polling for a new link, if its device supports it.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being added.
+
+Return Value:
+
+    STATUS_SUCCESS on success, including if the device does not support
+    polling.
+
+    STATUS_INVALID_PARAMETER if the device supplied only one of the poll and
+    complete poll routines.
+
+    STATUS_INSUFFICIENT_RESOURCES if the work item could not be allocated.
+
+--*/
+
+{
+
+    PNET_DEVICE_LINK_INTERFACE Interface;
+
+    ASSERT(Link->PollWorkItem == NULL);
+
+    Link->PollBudget = NET_LINK_DEFAULT_POLL_BUDGET;
+    Interface = &(Link->Properties.Interface);
+    if ((Interface->Poll == NULL) && (Interface->CompletePoll == NULL)) {
+        return STATUS_SUCCESS;
+    }
+
+    if ((Interface->Poll == NULL) || (Interface->CompletePoll == NULL)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Link->PollWorkItem = KeCreateWorkItem(NetPollWorkQueue,
+                                          WorkPriorityNormal,
+                                          NetpPollLinkWorker,
+                                          Link,
+                                          NET_CORE_ALLOCATION_TAG);
+
+    if (Link->PollWorkItem == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+NetpStopLinkPolling (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops polling a link whose device is being removed. On
+    return, the device's poll routine is not running and will not be called
+    again.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being removed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    if (Link->PollWorkItem == NULL) {
+        return;
+    }
+
+    //
+    // Any poll round that starts from here on out sees the removed flag and
+    // bails, so waiting out the current round is enough. A round that
+    // re-queued itself still holds its link reference and will drop it when
+    // it next runs.
+    //
+
+    RtlAtomicOr32(&(Link->PollState), NET_LINK_POLL_REMOVED);
+    KeFlushWorkItem(Link->PollWorkItem);
+    return;
+}
+
+VOID
+NetpDestroyLinkPolling (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys the polling state of a link whose last reference
+    has been released.
+
+Arguments:
+
+    Link - Supplies a pointer to the link being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Link->PollWorkItem != NULL) {
+
+        ASSERT((Link->PollState & NET_LINK_POLL_SCHEDULED) == 0);
+
+        KeDestroyWorkItem(Link->PollWorkItem);
+        Link->PollWorkItem = NULL;
+    }
+
+    return;
+}
+
+KSTATUS
+NetpGetSetLinkCoalescingInformation (
+    PNET_LINK Link,
+    PNETWORK_DEVICE_COALESCING_INFORMATION Information,
+    BOOL Set
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the interrupt coalescing and polling settings of
+    a link.
+
+Arguments:
+
+    Link - Supplies a pointer to the link to work with.
+
+    Information - Supplies a pointer that either receives the coalescing
+        information, or contains the new information to set. For set
+        operations, the information buffer will contain the current settings
+        on return.
+
+    Set - Supplies a boolean indicating if the information should be set or
+        returned.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the version or poll budget is invalid.
+
+    STATUS_NOT_SUPPORTED if non-zero coalescing values were supplied for a
+    device without hardware interrupt coalescing.
+
+--*/
+
+{
+
+    NET_LINK_INTERRUPT_COALESCING Coalescing;
+    UINTN DataSize;
+    PNET_DEVICE_LINK_GET_SET_INFORMATION GetSetInformation;
+    KSTATUS Status;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    if (Information->Version < NETWORK_DEVICE_COALESCING_INFORMATION_VERSION) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    GetSetInformation = Link->Properties.Interface.GetSetInformation;
+    DataSize = sizeof(NET_LINK_INTERRUPT_COALESCING);
+    if (Set != FALSE) {
+        if ((Information->PollBudget == 0) ||
+            (Information->PollBudget > NET_LINK_MAX_POLL_BUDGET)) {
+
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        Coalescing.ReceiveMicroseconds = Information->ReceiveMicroseconds;
+        Coalescing.ReceiveFrames = Information->ReceiveFrames;
+        Coalescing.TransmitMicroseconds = Information->TransmitMicroseconds;
+        Coalescing.TransmitFrames = Information->TransmitFrames;
+        Status = GetSetInformation(Link->Properties.DeviceContext,
+                                   NetLinkInformationInterruptCoalescing,
+                                   &Coalescing,
+                                   &DataSize,
+                                   TRUE);
+
+        //
+        // Devices without coalescing hardware already interrupt for every
+        // frame, so asking for exactly that is fine.
+        //
+
+        if (Status == STATUS_NOT_SUPPORTED) {
+            if ((Coalescing.ReceiveMicroseconds != 0) ||
+                (Coalescing.ReceiveFrames != 0) ||
+                (Coalescing.TransmitMicroseconds != 0) ||
+                (Coalescing.TransmitFrames != 0)) {
+
+                return Status;
+            }
+
+        } else if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        Link->PollBudget = Information->PollBudget;
+    }
+
+    Information->Flags = 0;
+    Information->PollBudget = Link->PollBudget;
+    if (Link->PollWorkItem != NULL) {
+        Information->Flags |= NETWORK_DEVICE_COALESCING_FLAG_POLLED;
+    }
+
+    RtlZeroMemory(&Coalescing, sizeof(NET_LINK_INTERRUPT_COALESCING));
+    DataSize = sizeof(NET_LINK_INTERRUPT_COALESCING);
+    Status = GetSetInformation(Link->Properties.DeviceContext,
+                               NetLinkInformationInterruptCoalescing,
+                               &Coalescing,
+                               &DataSize,
+                               FALSE);
+
+    if (KSUCCESS(Status)) {
+        Information->Flags |= NETWORK_DEVICE_COALESCING_FLAG_HARDWARE;
+
+    } else {
+        RtlZeroMemory(&Coalescing, sizeof(NET_LINK_INTERRUPT_COALESCING));
+    }
+
+    Information->ReceiveMicroseconds = Coalescing.ReceiveMicroseconds;
+    Information->ReceiveFrames = Coalescing.ReceiveFrames;
+    Information->TransmitMicroseconds = Coalescing.TransmitMicroseconds;
+    Information->TransmitFrames = Coalescing.TransmitFrames;
+    return STATUS_SUCCESS;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+NetpPollLinkWorker (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the work item that polls a link for received
+    frames.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the link to poll.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Budget;
+    PNET_DEVICE_LINK_INTERFACE Interface;
+    PNET_LINK Link;
+    ULONG OldState;
+    ULONG Processed;
+    KSTATUS Status;
+
+    Link = (PNET_LINK)Parameter;
+    Interface = &(Link->Properties.Interface);
+    while (TRUE) {
+        if ((Link->PollState & NET_LINK_POLL_REMOVED) != 0) {
+            RtlAtomicAnd32(&(Link->PollState), ~NET_LINK_POLL_SCHEDULED);
+            break;
+        }
+
+        RtlAtomicAnd32(&(Link->PollState), ~NET_LINK_POLL_PENDING);
+        Budget = Link->PollBudget;
+        Processed = Interface->Poll(Link->Properties.DeviceContext, Budget);
+
+        //
+        // If the whole budget got used there is likely more waiting. Go to
+        // the back of the line so that other links get a turn, keeping the
+        // reference and the receive interrupt masked.
+        //
+
+        if (Processed >= Budget) {
+            Status = KeQueueWorkItem(Link->PollWorkItem);
+
+            ASSERT(KSUCCESS(Status));
+
+            return;
+        }
+
+        //
+        // The ring is empty. Unmask the interrupt and then try to go idle. If
+        // the device asked for another poll in the meantime, drain it again.
+        //
+
+        Interface->CompletePoll(Link->Properties.DeviceContext);
+        OldState = RtlAtomicCompareExchange32(&(Link->PollState),
+                                              0,
+                                              NET_LINK_POLL_SCHEDULED);
+
+        if (OldState == NET_LINK_POLL_SCHEDULED) {
+            break;
+        }
+    }
+
+    NetLinkReleaseReference(Link);
+    return;
+}
+
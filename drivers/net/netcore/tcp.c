@@ -221,13 +221,16 @@ NetpTcpFillOutHeader (
     USHORT ExtraFlags,
     ULONG OptionsLength,
     USHORT NonUrgentOffset,
-    ULONG DataLength
+    ULONG DataLength,
+    PULONG DataSum
     );
 
 USHORT
 NetpTcpChecksumData (
     PVOID Data,
     ULONG DataLength,
+    ULONG PacketLength,
+    ULONG InitialSum,
     PNETWORK_ADDRESS SourceAddress,
     PNETWORK_ADDRESS DestinationAddress
     );
@@ -2247,6 +2250,8 @@ Return Value:
 
         Checksum = NetpTcpChecksumData(Header,
                                        Length,
+                                       Length,
+                                       0,
                                        SourceAddress,
                                        DestinationAddress);
 
@@ -4810,7 +4815,8 @@ NetpTcpFillOutHeader (
     USHORT ExtraFlags,
     ULONG OptionsLength,
     USHORT NonUrgentOffset,
-    ULONG DataLength
+    ULONG DataLength,
+    PULONG DataSum
     )
 
 /*++
@@ -4842,6 +4848,10 @@ Routine Description:
 
     DataLength - Supplies the length of the data field.
 
+    DataSum - Supplies an optional pointer to the running Internet checksum of
+        the data field, if it was already computed while copying the data into
+        the packet.
+
 Return Value:
 
     None.
@@ -4852,7 +4862,9 @@ Return Value:
 
     PVOID Buffer;
     USHORT Checksum;
+    ULONG ChecksumLength;
     PTCP_HEADER Header;
+    ULONG InitialSum;
     ULONG PacketSize;
     ULONG RelativeAcknowledgeNumber;
     ULONG RelativeSequenceNumber;
@@ -4900,8 +4912,17 @@ Return Value:
     if ((Socket->NetSocket.Link->Properties.ChecksumFlags &
          NET_LINK_CHECKSUM_FLAG_TRANSMIT_TCP_OFFLOAD) == 0) {
 
+        ChecksumLength = PacketSize;
+        InitialSum = 0;
+        if (DataSum != NULL) {
+            ChecksumLength = sizeof(TCP_HEADER) + OptionsLength;
+            InitialSum = *DataSum;
+        }
+
         Checksum = NetpTcpChecksumData(Header,
+                                       ChecksumLength,
                                        PacketSize,
+                                       InitialSum,
                                        &(Socket->NetSocket.LocalAddress),
                                        &(Socket->NetSocket.RemoteAddress));
 
@@ -4967,6 +4988,8 @@ USHORT
 NetpTcpChecksumData (
     PVOID Data,
     ULONG DataLength,
+    ULONG PacketLength,
+    ULONG InitialSum,
     PNETWORK_ADDRESS SourceAddress,
     PNETWORK_ADDRESS DestinationAddress
     )
@@ -4982,7 +5005,15 @@ Routine Description:
 
     Data - Supplies a pointer to the beginning of the TCP header.
 
-    DataLength - Supplies the length of the header, options, and data, in bytes.
+    DataLength - Supplies the number of bytes to checksum starting at the
+        header. This is usually the whole packet.
+
+    PacketLength - Supplies the length of the header, options, and data, in
+        bytes, used to compute the pseudo header.
+
+    InitialSum - Supplies the running Internet checksum of the rest of the
+        packet beyond the given data length, or 0 if the data length covers
+        the whole packet.
 
     SourceAddress - Supplies a pointer to the source address of the packet,
         used to compute the pseudo header.
@@ -4998,82 +5029,30 @@ Return Value:
 
 {
 
-    PUCHAR BytePointer;
     PIP4_ADDRESS Ip4Address;
-    PULONG LongPointer;
-    ULONG NextValue;
-    USHORT ShortOne;
-    PUSHORT ShortPointer;
-    USHORT ShortTwo;
+    USHORT PseudoHeader[2];
     ULONG Sum;
 
-    Sum = 0;
-
     ASSERT(SourceAddress->Domain == NetDomainIp4);
     ASSERT(DestinationAddress->Domain == SourceAddress->Domain);
+    ASSERT(PacketLength < MAX_USHORT);
+    ASSERT(DataLength <= PacketLength);
 
     Ip4Address = (PIP4_ADDRESS)SourceAddress;
-    Sum = Ip4Address->Address;
-    Ip4Address = (PIP4_ADDRESS)DestinationAddress;
-    Sum += Ip4Address->Address;
-    if (Sum < Ip4Address->Address) {
-        Sum += 1;
-    }
-
-    ASSERT(DataLength < MAX_USHORT);
-
-    NextValue = (RtlByteSwapUshort((USHORT)DataLength) << 16) |
-                (SOCKET_INTERNET_PROTOCOL_TCP << 8);
-
-    Sum += NextValue;
-    if (Sum < NextValue) {
-        Sum += 1;
-    }
-
-    LongPointer = (PULONG)Data;
-    while (DataLength >= sizeof(ULONG)) {
-        NextValue = *LongPointer;
-        LongPointer += 1;
-        Sum += NextValue;
-        if (Sum < NextValue) {
-            Sum += 1;
-        }
-
-        DataLength -= sizeof(ULONG);
-    }
-
-    BytePointer = (PUCHAR)LongPointer;
-    if ((DataLength & sizeof(USHORT)) != 0) {
-        ShortPointer = (PUSHORT)BytePointer;
-        NextValue = (USHORT)*ShortPointer;
-        Sum += NextValue;
-        if (Sum < NextValue) {
-            Sum += 1;
-        }
-
-        BytePointer += sizeof(USHORT);
-    }
+    Sum = RtlComputeInternetChecksum(InitialSum,
+                                     &(Ip4Address->Address),
+                                     sizeof(Ip4Address->Address));
 
-    if ((DataLength & sizeof(UCHAR)) != 0) {
-        NextValue = (UCHAR)*BytePointer;
-        Sum += NextValue;
-        if (Sum < NextValue) {
-            Sum += 1;
-        }
-    }
-
-    //
-    // Fold the 32-bit value down to 16-bits.
-    //
-
-    ShortOne = (USHORT)Sum;
-    ShortTwo = (USHORT)(Sum >> 16);
-    ShortTwo += ShortOne;
-    if (ShortTwo < ShortOne) {
-        ShortTwo += 1;
-    }
-
-    return (USHORT)~ShortTwo;
+    Ip4Address = (PIP4_ADDRESS)DestinationAddress;
+    Sum = RtlComputeInternetChecksum(Sum,
+                                     &(Ip4Address->Address),
+                                     sizeof(Ip4Address->Address));
+
+    PseudoHeader[0] = CPU_TO_NETWORK16(SOCKET_INTERNET_PROTOCOL_TCP);
+    PseudoHeader[1] = CPU_TO_NETWORK16((USHORT)PacketLength);
+    Sum = RtlComputeInternetChecksum(Sum, PseudoHeader, sizeof(PseudoHeader));
+    Sum = RtlComputeInternetChecksum(Sum, Data, DataLength);
+    return RtlFoldInternetChecksum(Sum);
 }
 
 BOOL
@@ -5821,7 +5800,14 @@ Return Value:
         Flags &= ~TCP_HEADER_FLAG_KEEP_ALIVE;
     }
 
-    NetpTcpFillOutHeader(Socket, Packet, SequenceNumber, Flags, 0, 0, 0);
+    NetpTcpFillOutHeader(Socket,
+                         Packet,
+                         SequenceNumber,
+                         Flags,
+                         0,
+                         0,
+                         0,
+                         NULL);
 
     //
     // Send this control packet off down the network.
@@ -6938,11 +6924,14 @@ Return Value:
 
 {
 
+    PVOID Data;
+    PULONG DataSum;
     USHORT HeaderFlags;
     PNET_PACKET_BUFFER Packet;
     ULONG SegmentLength;
     PNET_PACKET_SIZE_INFORMATION SizeInformation;
     KSTATUS Status;
+    ULONG Sum;
 
     //
     // Allocate the network buffer.
@@ -6975,12 +6964,29 @@ Return Value:
     HeaderFlags = Segment->Flags & TCP_SEND_SEGMENT_HEADER_FLAG_MASK;
 
     //
-    // Copy the segment data over and fill out the TCP header.
+    // Copy the segment data over and fill out the TCP header. If the checksum
+    // is done in software, sum the data on the way through rather than
+    // reading it all again afterwards.
     //
 
-    RtlCopyMemory(Packet->Buffer + Packet->DataOffset,
-                  (PUCHAR)(Segment + 1) + Segment->Offset,
-                  SegmentLength);
+    Data = (PUCHAR)(Segment + 1) + Segment->Offset;
+    DataSum = NULL;
+    if ((Socket->NetSocket.Link->Properties.ChecksumFlags &
+         NET_LINK_CHECKSUM_FLAG_TRANSMIT_TCP_OFFLOAD) == 0) {
+
+        Sum = RtlCopyAndComputeInternetChecksum(
+                                          0,
+                                          Packet->Buffer + Packet->DataOffset,
+                                          Data,
+                                          SegmentLength);
+
+        DataSum = &Sum;
+
+    } else {
+        RtlCopyMemory(Packet->Buffer + Packet->DataOffset,
+                      Data,
+                      SegmentLength);
+    }
 
     ASSERT(Packet->DataOffset >= sizeof(TCP_HEADER));
 
@@ -6991,7 +6997,8 @@ Return Value:
                          HeaderFlags,
                          0,
                          0,
-                         SegmentLength);
+                         SegmentLength,
+                         DataSum);
 
 TcpCreatePacketEnd:
     return Packet;
@@ -8304,7 +8311,8 @@ Return Value:
                          ControlFlags,
                          DataSize,
                          0,
-                         0);
+                         0,
+                         NULL);
 
     Status = NetSocket->Network->Interface.Send(NetSocket,
                                                 &(NetSocket->RemoteAddress),
@@ -40,6 +40,7 @@ Module Name:
 
 #include <minoca/kernel/driver.h>
 #include <minoca/net/netdrv.h>
+#include <minoca/net/ip4.h>
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -327,6 +328,15 @@ NetpUdpUserControl (
     UINTN ContextBufferSize
     );
 
+USHORT
+NetpUdpChecksumHeader (
+    PUDP_HEADER Header,
+    ULONG PacketLength,
+    ULONG DataSum,
+    PNETWORK_ADDRESS SourceAddress,
+    PNETWORK_ADDRESS DestinationAddress
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -1336,10 +1346,12 @@ Return Value:
 {
 
     ULONG AllocationSize;
+    USHORT Checksum;
     PUDP_HEADER Header;
     USHORT Length;
     USHORT PayloadLength;
     KSTATUS Status;
+    ULONG Sum;
     PUDP_RECEIVED_PACKET UdpPacket;
     PUDP_SOCKET UdpSocket;
 
@@ -1389,10 +1401,42 @@ Return Value:
     UdpPacket->Size = PayloadLength;
 
     //
-    // Copy the packet contents into the receive packet buffer.
+    // Copy the packet contents into the receive packet buffer. Unless the
+    // hardware already vouched for it, verify the checksum on the way
+    // through. A zero checksum means the sender did not supply one.
     //
 
-    RtlCopyMemory(UdpPacket->DataBuffer, Header + 1, PayloadLength);
+    if ((Header->Checksum != 0) &&
+        (SourceAddress->Domain == NetDomainIp4) &&
+        (((Packet->Flags & NET_PACKET_FLAG_UDP_CHECKSUM_OFFLOAD) == 0) ||
+         ((Packet->Flags & NET_PACKET_FLAG_UDP_CHECKSUM_FAILED) != 0))) {
+
+        Sum = RtlCopyAndComputeInternetChecksum(0,
+                                                UdpPacket->DataBuffer,
+                                                Header + 1,
+                                                PayloadLength);
+
+        Checksum = NetpUdpChecksumHeader(Header,
+                                         Length,
+                                         Sum,
+                                         SourceAddress,
+                                         DestinationAddress);
+
+        if (Checksum != 0) {
+            RtlDebugPrint("UDP ignoring packet with bad checksum 0x%04x "
+                          "headed for port %d from port %d.\n",
+                          Checksum,
+                          DestinationAddress->Port,
+                          SourceAddress->Port);
+
+            MmFreePagedPool(UdpPacket);
+            Status = STATUS_CHECKSUM_MISMATCH;
+            goto ProcessReceivedSocketDataEnd;
+        }
+
+    } else {
+        RtlCopyMemory(UdpPacket->DataBuffer, Header + 1, PayloadLength);
+    }
 
     //
     // Work to insert the packet on the list of received packets.
@@ -2068,3 +2112,67 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+USHORT
+NetpUdpChecksumHeader (
+    PUDP_HEADER Header,
+    ULONG PacketLength,
+    ULONG DataSum,
+    PNETWORK_ADDRESS SourceAddress,
+    PNETWORK_ADDRESS DestinationAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finishes computing the checksum of a UDP datagram whose data
+    has already been summed.
+
+Arguments:
+
+    Header - Supplies a pointer to the UDP header.
+
+    PacketLength - Supplies the length of the header and data, in bytes.
+
+    DataSum - Supplies the running Internet checksum of the data following
+        the header.
+
+    SourceAddress - Supplies a pointer to the source address of the datagram,
+        used to compute the pseudo header.
+
+    DestinationAddress - Supplies a pointer to the destination address of the
+        datagram, used to compute the pseudo header.
+
+Return Value:
+
+    Returns the checksum in network byte order. A datagram with a valid
+    checksum comes out as zero.
+
+--*/
+
+{
+
+    PIP4_ADDRESS Ip4Address;
+    USHORT PseudoHeader[2];
+    ULONG Sum;
+
+    ASSERT(SourceAddress->Domain == NetDomainIp4);
+    ASSERT(DestinationAddress->Domain == SourceAddress->Domain);
+
+    Ip4Address = (PIP4_ADDRESS)SourceAddress;
+    Sum = RtlComputeInternetChecksum(DataSum,
+                                     &(Ip4Address->Address),
+                                     sizeof(Ip4Address->Address));
+
+    Ip4Address = (PIP4_ADDRESS)DestinationAddress;
+    Sum = RtlComputeInternetChecksum(Sum,
+                                     &(Ip4Address->Address),
+                                     sizeof(Ip4Address->Address));
+
+    PseudoHeader[0] = CPU_TO_NETWORK16(SOCKET_INTERNET_PROTOCOL_UDP);
+    PseudoHeader[1] = CPU_TO_NETWORK16((USHORT)PacketLength);
+    Sum = RtlComputeInternetChecksum(Sum, PseudoHeader, sizeof(PseudoHeader));
+    Sum = RtlComputeInternetChecksum(Sum, Header, sizeof(UDP_HEADER));
+    return RtlFoldInternetChecksum(Sum);
+}
+
@@ -1305,6 +1305,16 @@ Return Value:
                 }
             }
 
+            //
+            // Flash has no seek penalty, so only merge requests.
+            //
+
+            if (KSUCCESS(Status)) {
+                Status = IoSetBlockDeviceScheduler(Irp->Device,
+                                                   IoBlockSchedulerNone,
+                                                   1);
+            }
+
             break;
 
         case IrpMinorQueryChildren:
@@ -0,0 +1,2733 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    tmpfs.c
+
+Abstract:
+
+    This module implements the temporary file system driver. File data lives
+    only in the page cache, which is told that there is no backing store. The
+    driver keeps the metadata in kernel memory, and only sees file data when
+    the page cache pushes it down under memory pressure, at which point it is
+    stashed in paged pool where it can go out to the page file.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/driver.h>
+#include <minoca/devinfo/tmpfs.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define TMPFS_ALLOCATION_TAG 0x46706D54 // 'FpmT'
+
+//
+// Define the device ID of the root device that temporary volumes sit on.
+//
+
+#define TMPFS_DEVICE_ID "tmpfs"
+
+//
+// Define the file ID of the root directory.
+//
+
+#define TMPFS_ROOT_FILE_ID 1
+
+//
+// By default, let the volume hold up to half of physical memory.
+//
+
+#define TMPFS_DEFAULT_MAX_SIZE_SHIFT 1
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef enum _TMPFS_OBJECT_TYPE {
+    TmpfsObjectInvalid,
+    TmpfsObjectDevice,
+    TmpfsObjectVolume
+} TMPFS_OBJECT_TYPE, *PTMPFS_OBJECT_TYPE;
+
+typedef struct _TMPFS_NODE TMPFS_NODE, *PTMPFS_NODE;
+
+/*++
+
+Structure Description:
+
+    This structure stores the context for the root device that temporary
+    file system volumes are mounted on.
+
+Members:
+
+    Type - Stores the object type, TmpfsObjectDevice.
+
+    CreationTime - Stores the time the device was created.
+
+--*/
+
+typedef struct _TMPFS_DEVICE {
+    TMPFS_OBJECT_TYPE Type;
+    SYSTEM_TIME CreationTime;
+} TMPFS_DEVICE, *PTMPFS_DEVICE;
+
+/*++
+
+Structure Description:
+
+    This structure stores information about a temporary file system volume.
+
+Members:
+
+    Type - Stores the object type, TmpfsObjectVolume.
+
+    ReferenceCount - Stores the reference count of the volume.
+
+    Lock - Stores a pointer to the lock that protects the volume's nodes,
+        directories, and stored pages.
+
+    NodeTree - Stores the tree of nodes, ordered by file ID.
+
+    Root - Stores a pointer to the root directory node.
+
+    NextFileId - Stores the file ID to hand out to the next created file.
+
+    MaxSize - Stores the maximum number of bytes of file data the volume will
+        hold.
+
+    UsedSize - Stores the number of bytes of file data charged to the volume.
+
+    NodeCount - Stores the number of nodes on the volume.
+
+--*/
+
+typedef struct _TMPFS_VOLUME {
+    TMPFS_OBJECT_TYPE Type;
+    volatile ULONG ReferenceCount;
+    PSHARED_EXCLUSIVE_LOCK Lock;
+    RED_BLACK_TREE NodeTree;
+    PTMPFS_NODE Root;
+    FILE_ID NextFileId;
+    ULONGLONG MaxSize;
+    ULONGLONG UsedSize;
+    ULONGLONG NodeCount;
+} TMPFS_VOLUME, *PTMPFS_VOLUME;
+
+/*++
+
+Structure Description:
+
+    This structure stores a directory entry.
+
+Members:
+
+    NameNode - Stores the node in the directory's tree of entries by name.
+
+    CookieNode - Stores the node in the directory's tree of entries by cookie.
+
+    Cookie - Stores the directory offset of this entry. Cookies only increase,
+        so enumeration is stable across inserts and removals.
+
+    Node - Stores a pointer to the file this entry names.
+
+    NameLength - Stores the length of the name, not including the null
+        terminator.
+
+    Name - Stores a pointer to the null terminated name, which is allocated
+        immediately after this structure.
+
+--*/
+
+typedef struct _TMPFS_ENTRY {
+    RED_BLACK_TREE_NODE NameNode;
+    RED_BLACK_TREE_NODE CookieNode;
+    ULONGLONG Cookie;
+    PTMPFS_NODE Node;
+    ULONG NameLength;
+    PSTR Name;
+} TMPFS_ENTRY, *PTMPFS_ENTRY;
+
+/*++
+
+Structure Description:
+
+    This structure stores a page of file data that the page cache pushed down.
+
+Members:
+
+    TreeNode - Stores the node in the file's tree of pages.
+
+    Offset - Stores the page aligned file offset of the data.
+
+    Data - Stores the page of data.
+
+--*/
+
+typedef struct _TMPFS_PAGE {
+    RED_BLACK_TREE_NODE TreeNode;
+    ULONGLONG Offset;
+    UCHAR Data[ANYSIZE_ARRAY];
+} TMPFS_PAGE, *PTMPFS_PAGE;
+
+/*++
+
+Structure Description:
+
+    This structure stores a file, directory, or other object on a temporary
+    file system volume.
+
+Members:
+
+    TreeNode - Stores the node in the volume's tree of nodes.
+
+    Properties - Stores the file properties as last written by the system.
+
+    Parent - Stores a pointer to the directory containing this node, or NULL
+        for the root and for unlinked nodes.
+
+    Entry - Stores a pointer to the directory entry naming this node, or NULL
+        for the root and for unlinked nodes.
+
+    ChargedSize - Stores the number of bytes charged to the volume for this
+        file.
+
+    EntryTree - Stores the tree of entries by name for a directory.
+
+    CookieTree - Stores the tree of entries by cookie for a directory.
+
+    NextCookie - Stores the cookie to assign to the next directory entry.
+
+    EntryCount - Stores the number of entries in a directory.
+
+    PageTree - Stores the tree of pages pushed down for a file.
+
+--*/
+
+struct _TMPFS_NODE {
+    RED_BLACK_TREE_NODE TreeNode;
+    FILE_PROPERTIES Properties;
+    PTMPFS_NODE Parent;
+    PTMPFS_ENTRY Entry;
+    ULONGLONG ChargedSize;
+    RED_BLACK_TREE EntryTree;
+    RED_BLACK_TREE CookieTree;
+    ULONGLONG NextCookie;
+    ULONG EntryCount;
+    RED_BLACK_TREE PageTree;
+};
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+KSTATUS
+TmpfsAddDevice (
+    PVOID Driver,
+    PCSTR DeviceId,
+    PCSTR ClassId,
+    PCSTR CompatibleIds,
+    PVOID DeviceToken
+    );
+
+VOID
+TmpfsDispatchStateChange (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    );
+
+VOID
+TmpfsDispatchOpen (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    );
+
+VOID
+TmpfsDispatchClose (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    );
+
+VOID
+TmpfsDispatchIo (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    );
+
+VOID
+TmpfsDispatchSystemControl (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    );
+
+VOID
+TmpfspDispatchDeviceSystemControl (
+    PIRP Irp,
+    PTMPFS_DEVICE Device
+    );
+
+KSTATUS
+TmpfspCreateVolume (
+    PVOID DeviceToken
+    );
+
+VOID
+TmpfspDestroyVolume (
+    PTMPFS_VOLUME Volume
+    );
+
+VOID
+TmpfspVolumeAddReference (
+    PTMPFS_VOLUME Volume
+    );
+
+VOID
+TmpfspVolumeReleaseReference (
+    PTMPFS_VOLUME Volume
+    );
+
+KSTATUS
+TmpfspLookup (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_LOOKUP Lookup
+    );
+
+KSTATUS
+TmpfspCreate (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_CREATE Create
+    );
+
+KSTATUS
+TmpfspUnlink (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_UNLINK Unlink
+    );
+
+KSTATUS
+TmpfspRename (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_RENAME Rename
+    );
+
+KSTATUS
+TmpfspTruncate (
+    PTMPFS_VOLUME Volume,
+    PFILE_PROPERTIES FileProperties,
+    ULONGLONG NewSize
+    );
+
+KSTATUS
+TmpfspReadDirectory (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Directory,
+    PIRP Irp
+    );
+
+KSTATUS
+TmpfspPerformFileIo (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Node,
+    PIRP Irp
+    );
+
+VOID
+TmpfspHandleDeviceInformationRequest (
+    PIRP Irp,
+    PTMPFS_VOLUME Volume
+    );
+
+KSTATUS
+TmpfspChargeNode (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Node,
+    ULONGLONG Size
+    );
+
+VOID
+TmpfspTrimPages (
+    PTMPFS_NODE Node,
+    ULONGLONG Size
+    );
+
+PTMPFS_NODE
+TmpfspCreateNode (
+    PTMPFS_VOLUME Volume,
+    PFILE_PROPERTIES Properties
+    );
+
+VOID
+TmpfspDestroyNode (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Node
+    );
+
+PTMPFS_NODE
+TmpfspGetNode (
+    PTMPFS_VOLUME Volume,
+    FILE_ID FileId
+    );
+
+PTMPFS_ENTRY
+TmpfspFindEntry (
+    PTMPFS_NODE Directory,
+    PCSTR Name,
+    ULONG NameSize
+    );
+
+KSTATUS
+TmpfspInsertEntry (
+    PTMPFS_NODE Directory,
+    PCSTR Name,
+    ULONG NameSize,
+    PTMPFS_NODE Node
+    );
+
+VOID
+TmpfspRemoveEntry (
+    PTMPFS_NODE Node
+    );
+
+ULONG
+TmpfspGetNameLength (
+    PCSTR Name,
+    ULONG NameSize
+    );
+
+ULONGLONG
+TmpfspGetDirectorySize (
+    PTMPFS_NODE Directory
+    );
+
+COMPARISON_RESULT
+TmpfspCompareNodes (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    );
+
+COMPARISON_RESULT
+TmpfspCompareEntryNames (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    );
+
+COMPARISON_RESULT
+TmpfspCompareEntryCookies (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    );
+
+COMPARISON_RESULT
+TmpfspComparePages (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+PDRIVER TmpfsDriver = NULL;
+UUID TmpfsDeviceInformationUuid = TMPFS_DEVICE_INFORMATION_UUID;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+KSTATUS
+DriverEntry (
+    PDRIVER Driver
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for the temporary file system driver. It
+    registers its other dispatch functions, and performs driver-wide
+    initialization.
+
+Arguments:
+
+    Driver - Supplies a pointer to the driver object.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    Failure code on error.
+
+--*/
+
+{
+
+    DRIVER_FUNCTION_TABLE FunctionTable;
+    KSTATUS Status;
+
+    TmpfsDriver = Driver;
+    RtlZeroMemory(&FunctionTable, sizeof(DRIVER_FUNCTION_TABLE));
+    FunctionTable.Version = DRIVER_FUNCTION_TABLE_VERSION;
+    FunctionTable.AddDevice = TmpfsAddDevice;
+    FunctionTable.DispatchStateChange = TmpfsDispatchStateChange;
+    FunctionTable.DispatchOpen = TmpfsDispatchOpen;
+    FunctionTable.DispatchClose = TmpfsDispatchClose;
+    FunctionTable.DispatchIo = TmpfsDispatchIo;
+    FunctionTable.DispatchSystemControl = TmpfsDispatchSystemControl;
+    Status = IoRegisterDriverFunctions(Driver, &FunctionTable);
+    if (!KSUCCESS(Status)) {
+        goto DriverEntryEnd;
+    }
+
+    Status = IoRegisterFileSystem(Driver);
+    if (!KSUCCESS(Status)) {
+        goto DriverEntryEnd;
+    }
+
+DriverEntryEnd:
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+KSTATUS
+TmpfsAddDevice (
+    PVOID Driver,
+    PCSTR DeviceId,
+    PCSTR ClassId,
+    PCSTR CompatibleIds,
+    PVOID DeviceToken
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called both when the tmpfs root device is enumerated, in
+    which case the driver acts as its function driver, and when a volume is
+    detected, in which case the driver attaches as the file system if the
+    volume sits on the tmpfs device.
+
+Arguments:
+
+    Driver - Supplies a pointer to the driver being called.
+
+    DeviceId - Supplies a pointer to a string with the device ID.
+
+    ClassId - Supplies a pointer to a string containing the device's class ID.
+
+    CompatibleIds - Supplies a pointer to a string containing device IDs
+        that would be compatible with this device.
+
+    DeviceToken - Supplies an opaque token that the driver can use to identify
+        the device in the system. This token should be used when attaching to
+        the stack.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    Failure code if the driver was unsuccessful in attaching itself.
+
+--*/
+
+{
+
+    PTMPFS_DEVICE Device;
+    KSTATUS Status;
+    PDEVICE TargetDevice;
+
+    //
+    // Act as the function driver for the root device.
+    //
+
+    if (IoAreDeviceIdsEqual(DeviceId, TMPFS_DEVICE_ID) != FALSE) {
+        Device = MmAllocatePagedPool(sizeof(TMPFS_DEVICE),
+                                     TMPFS_ALLOCATION_TAG);
+
+        if (Device == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        RtlZeroMemory(Device, sizeof(TMPFS_DEVICE));
+        Device->Type = TmpfsObjectDevice;
+        KeGetSystemTime(&(Device->CreationTime));
+        Status = IoAttachDriverToDevice(Driver, DeviceToken, Device);
+        if (!KSUCCESS(Status)) {
+            MmFreePagedPool(Device);
+        }
+
+        return Status;
+    }
+
+    //
+    // Otherwise this is a volume looking for a file system. Only claim the
+    // ones that sit on the tmpfs device.
+    //
+
+    TargetDevice = IoGetTargetDevice(DeviceToken);
+    if ((TargetDevice == NULL) ||
+        (IoAreDeviceIdsEqual(IoGetDeviceId(TargetDevice), TMPFS_DEVICE_ID) ==
+         FALSE)) {
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    return TmpfspCreateVolume(DeviceToken);
+}
+
+VOID
+TmpfsDispatchStateChange (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles State Change IRPs.
+
+Arguments:
+
+    Irp - Supplies a pointer to the I/O request packet.
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack. Presumably this pointer contains
+        driver-specific device context.
+
+    IrpContext - Supplies the context pointer supplied by the driver when
+        the IRP was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_DEVICE Device;
+    KSTATUS Status;
+    PTMPFS_VOLUME Volume;
+
+    ASSERT(Irp->MajorCode == IrpMajorStateChange);
+
+    //
+    // The root device is a function driver on an unenumerable device, so
+    // complete IRPs on the way up. Once started, mark it mountable so the
+    // system creates a volume for it.
+    //
+
+    Device = DeviceContext;
+    if (Device->Type == TmpfsObjectDevice) {
+        if (Irp->Direction != IrpUp) {
+            return;
+        }
+
+        switch (Irp->MinorCode) {
+        case IrpMinorQueryResources:
+        case IrpMinorQueryChildren:
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+            break;
+
+        case IrpMinorStartDevice:
+            IoSetDeviceMountable(Irp->Device);
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+            break;
+
+        case IrpMinorRemoveDevice:
+            MmFreePagedPool(Device);
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+            break;
+
+        default:
+            break;
+        }
+
+        return;
+    }
+
+    ASSERT(Device->Type == TmpfsObjectVolume);
+
+    Volume = DeviceContext;
+    if (Irp->Direction == IrpDown) {
+        switch (Irp->MinorCode) {
+        case IrpMinorQueryResources:
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+            break;
+
+        case IrpMinorStartDevice:
+            Status = IoRegisterDeviceInformation(Irp->Device,
+                                                 &TmpfsDeviceInformationUuid,
+                                                 TRUE);
+
+            IoCompleteIrp(TmpfsDriver, Irp, Status);
+            break;
+
+        case IrpMinorQueryChildren:
+            Irp->U.QueryChildren.ChildCount = 0;
+            Irp->U.QueryChildren.Children = NULL;
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+            break;
+
+        //
+        // Release the original reference. The system may still hold the
+        // volume's root open, in which case the last close destroys it.
+        //
+
+        case IrpMinorRemoveDevice:
+            IoRegisterDeviceInformation(Irp->Device,
+                                        &TmpfsDeviceInformationUuid,
+                                        FALSE);
+
+            TmpfspVolumeReleaseReference(Volume);
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+            break;
+
+        default:
+
+            ASSERT(FALSE);
+
+            IoCompleteIrp(TmpfsDriver, Irp, STATUS_NOT_SUPPORTED);
+            break;
+        }
+    }
+
+    return;
+}
+
+VOID
+TmpfsDispatchOpen (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles Open IRPs.
+
+Arguments:
+
+    Irp - Supplies a pointer to the I/O request packet.
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack. Presumably this pointer contains
+        driver-specific device context.
+
+    IrpContext - Supplies the context pointer supplied by the driver when
+        the IRP was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_NODE Node;
+    KSTATUS Status;
+    PTMPFS_VOLUME Volume;
+
+    ASSERT(Irp->MajorCode == IrpMajorOpen);
+
+    //
+    // The root device itself can be opened (mount does so to see what it is),
+    // but it has no contents.
+    //
+
+    Volume = DeviceContext;
+    if (Volume->Type == TmpfsObjectDevice) {
+        Irp->U.Open.DeviceContext = NULL;
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+        return;
+    }
+
+    //
+    // Memory doesn't make for a good page file.
+    //
+
+    if ((Irp->U.Open.OpenFlags & OPEN_FLAG_PAGE_FILE) != 0) {
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_NO_ELIGIBLE_DEVICES);
+        return;
+    }
+
+    KeAcquireSharedExclusiveLockShared(Volume->Lock);
+    Node = TmpfspGetNode(Volume, Irp->U.Open.FileProperties->FileId);
+    KeReleaseSharedExclusiveLockShared(Volume->Lock);
+    Status = STATUS_PATH_NOT_FOUND;
+    if (Node != NULL) {
+        TmpfspVolumeAddReference(Volume);
+        Irp->U.Open.DeviceContext = Node;
+        Status = STATUS_SUCCESS;
+    }
+
+    IoCompleteIrp(TmpfsDriver, Irp, Status);
+    return;
+}
+
+VOID
+TmpfsDispatchClose (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles Close IRPs.
+
+Arguments:
+
+    Irp - Supplies a pointer to the I/O request packet.
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack. Presumably this pointer contains
+        driver-specific device context.
+
+    IrpContext - Supplies the context pointer supplied by the driver when
+        the IRP was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_VOLUME Volume;
+
+    ASSERT(Irp->MajorCode == IrpMajorClose);
+
+    Volume = DeviceContext;
+    if (Volume->Type == TmpfsObjectVolume) {
+        TmpfspVolumeReleaseReference(Volume);
+    }
+
+    IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+    return;
+}
+
+VOID
+TmpfsDispatchIo (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles I/O IRPs. File data only comes through here when the
+    page cache misses or sheds dirty pages under memory pressure.
+
+Arguments:
+
+    Irp - Supplies a pointer to the I/O request packet.
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack. Presumably this pointer contains
+        driver-specific device context.
+
+    IrpContext - Supplies the context pointer supplied by the driver when
+        the IRP was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_NODE Node;
+    KSTATUS Status;
+    PTMPFS_VOLUME Volume;
+
+    ASSERT(Irp->Direction == IrpDown);
+    ASSERT(Irp->MajorCode == IrpMajorIo);
+
+    Volume = DeviceContext;
+    if (Volume->Type == TmpfsObjectDevice) {
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_NOT_SUPPORTED);
+        return;
+    }
+
+    Node = Irp->U.ReadWrite.DeviceContext;
+
+    ASSERT(Node != NULL);
+    ASSERT(Irp->U.ReadWrite.IoBuffer != NULL);
+
+    if (Node->Properties.Type == IoObjectRegularDirectory) {
+        if (Irp->MinorCode == IrpMinorIoWrite) {
+            Status = STATUS_ACCESS_DENIED;
+
+        } else {
+            KeAcquireSharedExclusiveLockShared(Volume->Lock);
+            Status = TmpfspReadDirectory(Volume, Node, Irp);
+            KeReleaseSharedExclusiveLockShared(Volume->Lock);
+        }
+
+    } else {
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Status = TmpfspPerformFileIo(Volume, Node, Irp);
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+    }
+
+    IoCompleteIrp(TmpfsDriver, Irp, Status);
+    return;
+}
+
+VOID
+TmpfsDispatchSystemControl (
+    PIRP Irp,
+    PVOID DeviceContext,
+    PVOID IrpContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles System Control IRPs.
+
+Arguments:
+
+    Irp - Supplies a pointer to the I/O request packet.
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack. Presumably this pointer contains
+        driver-specific device context.
+
+    IrpContext - Supplies the context pointer supplied by the driver when
+        the IRP was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PVOID Context;
+    PSYSTEM_CONTROL_FILE_OPERATION FileOperation;
+    PTMPFS_NODE Node;
+    KSTATUS Status;
+    PSYSTEM_CONTROL_TRUNCATE Truncate;
+    PTMPFS_VOLUME Volume;
+
+    Volume = DeviceContext;
+    if (Volume->Type == TmpfsObjectDevice) {
+        TmpfspDispatchDeviceSystemControl(Irp, DeviceContext);
+        return;
+    }
+
+    Context = Irp->U.SystemControl.SystemContext;
+    switch (Irp->MinorCode) {
+    case IrpMinorSystemControlLookup:
+        KeAcquireSharedExclusiveLockShared(Volume->Lock);
+        Status = TmpfspLookup(Volume, Context);
+        KeReleaseSharedExclusiveLockShared(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, Status);
+        break;
+
+    case IrpMinorSystemControlCreate:
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Status = TmpfspCreate(Volume, Context);
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, Status);
+        break;
+
+    //
+    // The system is done with an unlinked file, free it.
+    //
+
+    case IrpMinorSystemControlDelete:
+        FileOperation = (PSYSTEM_CONTROL_FILE_OPERATION)Context;
+
+        ASSERT(FileOperation->FileProperties->HardLinkCount == 0);
+        ASSERT(FileOperation->FileProperties->FileId != TMPFS_ROOT_FILE_ID);
+
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Node = TmpfspGetNode(Volume, FileOperation->FileProperties->FileId);
+        if (Node != NULL) {
+            TmpfspDestroyNode(Volume, Node);
+        }
+
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+        break;
+
+    //
+    // Save the properties so they survive the file object going away. The
+    // charged size is tracked separately, so the file size is just recorded.
+    //
+
+    case IrpMinorSystemControlWriteFileProperties:
+        FileOperation = (PSYSTEM_CONTROL_FILE_OPERATION)Context;
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Node = TmpfspGetNode(Volume, FileOperation->FileProperties->FileId);
+        if (Node != NULL) {
+            RtlCopyMemory(&(Node->Properties),
+                          FileOperation->FileProperties,
+                          sizeof(FILE_PROPERTIES));
+        }
+
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+        break;
+
+    case IrpMinorSystemControlUnlink:
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Status = TmpfspUnlink(Volume, Context);
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, Status);
+        break;
+
+    case IrpMinorSystemControlRename:
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Status = TmpfspRename(Volume, Context);
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, Status);
+        break;
+
+    //
+    // Truncate is also sent ahead of writes that extend a file, which is
+    // where the size limit is enforced.
+    //
+
+    case IrpMinorSystemControlTruncate:
+        Truncate = (PSYSTEM_CONTROL_TRUNCATE)Context;
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Status = TmpfspTruncate(Volume,
+                                Truncate->FileProperties,
+                                Truncate->NewSize);
+
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+        IoCompleteIrp(TmpfsDriver, Irp, Status);
+        break;
+
+    case IrpMinorSystemControlDeviceInformation:
+        TmpfspHandleDeviceInformationRequest(Irp, Volume);
+        break;
+
+    //
+    // There is nothing to synchronize to.
+    //
+
+    case IrpMinorSystemControlSynchronize:
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+        break;
+
+    //
+    // There are no blocks to describe.
+    //
+
+    case IrpMinorSystemControlGetBlockInformation:
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_NOT_SUPPORTED);
+        break;
+
+    //
+    // Ignore everything unrecognized.
+    //
+
+    default:
+        break;
+    }
+
+    return;
+}
+
+VOID
+TmpfspDispatchDeviceSystemControl (
+    PIRP Irp,
+    PTMPFS_DEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles System Control IRPs sent to the tmpfs root device.
+    The root looks like an empty block device so that it can be mounted, and
+    so that no disk file system mistakes it for something it understands.
+
+Arguments:
+
+    Irp - Supplies a pointer to the I/O request packet.
+
+    Device - Supplies a pointer to the root device context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PSYSTEM_CONTROL_LOOKUP Lookup;
+    PFILE_PROPERTIES Properties;
+    KSTATUS Status;
+
+    switch (Irp->MinorCode) {
+    case IrpMinorSystemControlLookup:
+        Lookup = (PSYSTEM_CONTROL_LOOKUP)Irp->U.SystemControl.SystemContext;
+        Status = STATUS_PATH_NOT_FOUND;
+        if (Lookup->Root != FALSE) {
+            Properties = &(Lookup->Properties);
+            Properties->FileId = 0;
+            Properties->Type = IoObjectBlockDevice;
+            Properties->HardLinkCount = 1;
+            Properties->BlockSize = MmPageSize();
+            Properties->BlockCount = 0;
+            Properties->StatusChangeTime = Device->CreationTime;
+            Properties->ModifiedTime = Properties->StatusChangeTime;
+            Properties->AccessTime = Properties->StatusChangeTime;
+            Properties->Permissions = FILE_PERMISSION_USER_READ |
+                                      FILE_PERMISSION_USER_WRITE;
+
+            WRITE_INT64_SYNC(&(Properties->FileSize), 0);
+            Lookup->Flags = LOOKUP_FLAG_NON_CACHED;
+            Status = STATUS_SUCCESS;
+        }
+
+        IoCompleteIrp(TmpfsDriver, Irp, Status);
+        break;
+
+    case IrpMinorSystemControlWriteFileProperties:
+    case IrpMinorSystemControlSynchronize:
+        IoCompleteIrp(TmpfsDriver, Irp, STATUS_SUCCESS);
+        break;
+
+    default:
+        break;
+    }
+
+    return;
+}
+
+KSTATUS
+TmpfspCreateVolume (
+    PVOID DeviceToken
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates an empty temporary volume and attaches it to the
+    given volume device.
+
+Arguments:
+
+    DeviceToken - Supplies the volume device token.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG PageShift;
+    FILE_PROPERTIES Properties;
+    PTMPFS_NODE Root;
+    KSTATUS Status;
+    PTMPFS_VOLUME Volume;
+
+    Volume = MmAllocatePagedPool(sizeof(TMPFS_VOLUME), TMPFS_ALLOCATION_TAG);
+    if (Volume == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateVolumeEnd;
+    }
+
+    RtlZeroMemory(Volume, sizeof(TMPFS_VOLUME));
+    Volume->Type = TmpfsObjectVolume;
+    RtlRedBlackTreeInitialize(&(Volume->NodeTree), 0, TmpfspCompareNodes);
+    Volume->NextFileId = TMPFS_ROOT_FILE_ID;
+    PageShift = MmPageShift();
+    Volume->MaxSize = ((ULONGLONG)MmGetTotalPhysicalPages() << PageShift) >>
+                      TMPFS_DEFAULT_MAX_SIZE_SHIFT;
+
+    Volume->Lock = KeCreateSharedExclusiveLock();
+    if (Volume->Lock == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateVolumeEnd;
+    }
+
+    //
+    // Create the root directory. Anyone can create files in it, but only
+    // remove their own, as befits a temporary directory.
+    //
+
+    RtlZeroMemory(&Properties, sizeof(FILE_PROPERTIES));
+    Properties.Type = IoObjectRegularDirectory;
+    Properties.Permissions = FILE_PERMISSION_ALL |
+                             FILE_PERMISSION_RESTRICTED;
+
+    Properties.HardLinkCount = 1;
+    KeGetSystemTime(&(Properties.AccessTime));
+    Properties.ModifiedTime = Properties.AccessTime;
+    Properties.StatusChangeTime = Properties.AccessTime;
+    Root = TmpfspCreateNode(Volume, &Properties);
+    if (Root == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateVolumeEnd;
+    }
+
+    ASSERT(Root->Properties.FileId == TMPFS_ROOT_FILE_ID);
+
+    Volume->Root = Root;
+    Status = IoAttachDriverToDevice(TmpfsDriver, DeviceToken, Volume);
+    if (!KSUCCESS(Status)) {
+        goto CreateVolumeEnd;
+    }
+
+    Volume->ReferenceCount = 1;
+
+CreateVolumeEnd:
+    if (!KSUCCESS(Status)) {
+        if (Volume != NULL) {
+            TmpfspDestroyVolume(Volume);
+        }
+    }
+
+    return Status;
+}
+
+VOID
+TmpfspDestroyVolume (
+    PTMPFS_VOLUME Volume
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a temporary volume and everything on it.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_ENTRY Entry;
+    PTMPFS_NODE Node;
+    PRED_BLACK_TREE_NODE TreeNode;
+
+    //
+    // Detach entries and free nodes until the tree is empty. The directory
+    // trees are torn down as their nodes are destroyed.
+    //
+
+    while (TRUE) {
+        TreeNode = RtlRedBlackTreeGetLowestNode(&(Volume->NodeTree));
+        if (TreeNode == NULL) {
+            break;
+        }
+
+        Node = RED_BLACK_TREE_VALUE(TreeNode, TMPFS_NODE, TreeNode);
+        while (Node->EntryCount != 0) {
+            TreeNode = RtlRedBlackTreeGetLowestNode(&(Node->EntryTree));
+            Entry = RED_BLACK_TREE_VALUE(TreeNode, TMPFS_ENTRY, NameNode);
+            TmpfspRemoveEntry(Entry->Node);
+        }
+
+        if (Node->Entry != NULL) {
+            TmpfspRemoveEntry(Node);
+        }
+
+        TmpfspDestroyNode(Volume, Node);
+    }
+
+    if (Volume->Lock != NULL) {
+        KeDestroySharedExclusiveLock(Volume->Lock);
+    }
+
+    MmFreePagedPool(Volume);
+    return;
+}
+
+VOID
+TmpfspVolumeAddReference (
+    PTMPFS_VOLUME Volume
+    )
+
+/*++
+
+Routine Description:
+
+    This routine increments the reference count on the given volume.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldReferenceCount;
+
+    OldReferenceCount = RtlAtomicAdd32(&(Volume->ReferenceCount), 1);
+
+    ASSERT((OldReferenceCount != 0) && (OldReferenceCount < 0x10000000));
+
+    return;
+}
+
+VOID
+TmpfspVolumeReleaseReference (
+    PTMPFS_VOLUME Volume
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decrements the reference count on the given volume, and
+    destroys it if it hits zero.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldReferenceCount;
+
+    OldReferenceCount = RtlAtomicAdd32(&(Volume->ReferenceCount), (ULONG)-1);
+
+    ASSERT((OldReferenceCount != 0) && (OldReferenceCount < 0x10000000));
+
+    if (OldReferenceCount == 1) {
+        TmpfspDestroyVolume(Volume);
+    }
+
+    return;
+}
+
+KSTATUS
+TmpfspLookup (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_LOOKUP Lookup
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks up a file by name, or the root of the volume. The
+    volume lock must be held.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Lookup - Supplies a pointer to the lookup request.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PTMPFS_NODE Directory;
+    PTMPFS_ENTRY Entry;
+    PTMPFS_NODE Node;
+
+    //
+    // Let the system know that file data on this volume has nowhere to go
+    // but the page cache.
+    //
+
+    if (Lookup->Root != FALSE) {
+        Node = Volume->Root;
+        Lookup->Flags = LOOKUP_FLAG_NO_BACKING_STORE;
+
+    } else {
+        Directory = TmpfspGetNode(Volume, Lookup->DirectoryProperties->FileId);
+        if ((Directory == NULL) ||
+            (Directory->Properties.Type != IoObjectRegularDirectory)) {
+
+            return STATUS_PATH_NOT_FOUND;
+        }
+
+        Entry = TmpfspFindEntry(Directory,
+                                Lookup->FileName,
+                                Lookup->FileNameSize);
+
+        if (Entry == NULL) {
+            return STATUS_PATH_NOT_FOUND;
+        }
+
+        Node = Entry->Node;
+    }
+
+    RtlCopyMemory(&(Lookup->Properties),
+                  &(Node->Properties),
+                  sizeof(FILE_PROPERTIES));
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+TmpfspCreate (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_CREATE Create
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file or directory. The volume lock must be held
+    exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Create - Supplies a pointer to the create request.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PTMPFS_NODE Directory;
+    PTMPFS_NODE Node;
+    KSTATUS Status;
+
+    Directory = TmpfspGetNode(Volume, Create->DirectoryProperties->FileId);
+    if ((Directory == NULL) ||
+        (Directory->Properties.Type != IoObjectRegularDirectory)) {
+
+        return STATUS_PATH_NOT_FOUND;
+    }
+
+    if (TmpfspFindEntry(Directory, Create->Name, Create->NameSize) != NULL) {
+        return STATUS_FILE_EXISTS;
+    }
+
+    Node = TmpfspCreateNode(Volume, &(Create->FileProperties));
+    if (Node == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    Status = TmpfspInsertEntry(Directory, Create->Name, Create->NameSize, Node);
+    if (!KSUCCESS(Status)) {
+        TmpfspDestroyNode(Volume, Node);
+        return Status;
+    }
+
+    RtlCopyMemory(&(Create->FileProperties),
+                  &(Node->Properties),
+                  sizeof(FILE_PROPERTIES));
+
+    Create->DirectorySize = TmpfspGetDirectorySize(Directory);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+TmpfspUnlink (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_UNLINK Unlink
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a directory entry. The node itself stays around until
+    the system sends a delete request for it. The volume lock must be held
+    exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Unlink - Supplies a pointer to the unlink request.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PTMPFS_NODE Directory;
+    PTMPFS_ENTRY Entry;
+
+    Unlink->Unlinked = FALSE;
+    Directory = TmpfspGetNode(Volume, Unlink->DirectoryProperties->FileId);
+    if (Directory == NULL) {
+        return STATUS_PATH_NOT_FOUND;
+    }
+
+    Entry = TmpfspFindEntry(Directory, Unlink->Name, Unlink->NameSize);
+    if ((Entry == NULL) ||
+        (Entry->Node->Properties.FileId != Unlink->FileProperties->FileId)) {
+
+        return STATUS_PATH_NOT_FOUND;
+    }
+
+    if (Entry->Node->EntryCount != 0) {
+        return STATUS_DIRECTORY_NOT_EMPTY;
+    }
+
+    TmpfspRemoveEntry(Entry->Node);
+    Unlink->Unlinked = TRUE;
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+TmpfspRename (
+    PTMPFS_VOLUME Volume,
+    PSYSTEM_CONTROL_RENAME Rename
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves a file to a new name, replacing whatever was there. The
+    volume lock must be held exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Rename - Supplies a pointer to the rename request.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PTMPFS_NODE Destination;
+    PTMPFS_NODE DestinationDirectory;
+    PTMPFS_ENTRY Entry;
+    PTMPFS_NODE Source;
+    KSTATUS Status;
+
+    Rename->SourceFileHardLinkDelta = 0;
+    Rename->DestinationFileUnlinked = FALSE;
+    DestinationDirectory = TmpfspGetNode(
+                               Volume,
+                               Rename->DestinationDirectoryProperties->FileId);
+
+    Source = TmpfspGetNode(Volume, Rename->SourceFileProperties->FileId);
+    if ((DestinationDirectory == NULL) || (Source == NULL) ||
+        (Source->Entry == NULL)) {
+
+        return STATUS_PATH_NOT_FOUND;
+    }
+
+    //
+    // Get rid of whatever currently sits at the destination. Directories can
+    // only be replaced if they're empty.
+    //
+
+    if (Rename->DestinationFileProperties != NULL) {
+        Destination = TmpfspGetNode(Volume,
+                                    Rename->DestinationFileProperties->FileId);
+
+        if ((Destination != NULL) && (Destination->Entry != NULL)) {
+            if (Destination->EntryCount != 0) {
+                return STATUS_DIRECTORY_NOT_EMPTY;
+            }
+
+            TmpfspRemoveEntry(Destination);
+            Rename->DestinationFileUnlinked = TRUE;
+        }
+    }
+
+    //
+    // Check that the destination name is free before taking the source out
+    // of its directory, so a failure leaves the source where it was.
+    //
+
+    Entry = TmpfspFindEntry(DestinationDirectory,
+                            Rename->Name,
+                            Rename->NameSize);
+
+    if (Entry != NULL) {
+        return STATUS_FILE_EXISTS;
+    }
+
+    TmpfspRemoveEntry(Source);
+    Status = TmpfspInsertEntry(DestinationDirectory,
+                               Rename->Name,
+                               Rename->NameSize,
+                               Source);
+
+    //
+    // The source is no longer linked anywhere if the insert failed.
+    //
+
+    if (!KSUCCESS(Status)) {
+        Rename->SourceFileHardLinkDelta = (ULONG)-1;
+        return Status;
+    }
+
+    Rename->DestinationDirectorySize =
+                                TmpfspGetDirectorySize(DestinationDirectory);
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+TmpfspTruncate (
+    PTMPFS_VOLUME Volume,
+    PFILE_PROPERTIES FileProperties,
+    ULONGLONG NewSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine changes the size of a file, charging or refunding the volume
+    as needed. The volume lock must be held exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    FileProperties - Supplies a pointer to the file's properties. The file
+        size is updated on success.
+
+    NewSize - Supplies the new file size.
+
+Return Value:
+
+    STATUS_VOLUME_FULL if growing the file would go over the volume's limit.
+
+    Other status codes.
+
+--*/
+
+{
+
+    PTMPFS_NODE Node;
+    ULONGLONG OldSize;
+    KSTATUS Status;
+
+    Node = TmpfspGetNode(Volume, FileProperties->FileId);
+    if (Node == NULL) {
+        return STATUS_PATH_NOT_FOUND;
+    }
+
+    if (Node->Properties.Type == IoObjectRegularDirectory) {
+        return STATUS_FILE_IS_DIRECTORY;
+    }
+
+    Status = TmpfspChargeNode(Volume, Node, NewSize);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    READ_INT64_SYNC(&(FileProperties->FileSize), &OldSize);
+    if (NewSize < OldSize) {
+        TmpfspTrimPages(Node, NewSize);
+    }
+
+    WRITE_INT64_SYNC(&(FileProperties->FileSize), NewSize);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+TmpfspReadDirectory (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Directory,
+    PIRP Irp
+    )
+
+/*++
+
+Routine Description:
+
+    This routine enumerates directory entries into the IRP's buffer. The
+    directory offset is the entry cookie. The volume lock must be held.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Directory - Supplies a pointer to the directory node.
+
+    Irp - Supplies a pointer to the read IRP.
+
+Return Value:
+
+    STATUS_MORE_PROCESSING_REQUIRED if the buffer filled up.
+
+    STATUS_END_OF_FILE if nothing was returned.
+
+    Other status codes.
+
+--*/
+
+{
+
+    UINTN BytesWritten;
+    PTMPFS_ENTRY Entry;
+    UINTN EntrySize;
+    PIO_BUFFER IoBuffer;
+    ULONGLONG NextOffset;
+    TMPFS_ENTRY SearchEntry;
+    UINTN SpaceLeft;
+    KSTATUS Status;
+    PRED_BLACK_TREE_NODE TreeNode;
+    DIRECTORY_ENTRY UserEntry;
+
+    ASSERT(Irp->U.ReadWrite.IoOffset >= DIRECTORY_CONTENTS_OFFSET);
+
+    IoBuffer = Irp->U.ReadWrite.IoBuffer;
+    BytesWritten = Irp->U.ReadWrite.IoBytesCompleted;
+
+    ASSERT(BytesWritten <= Irp->U.ReadWrite.IoSizeInBytes);
+
+    SpaceLeft = Irp->U.ReadWrite.IoSizeInBytes - BytesWritten;
+    NextOffset = Irp->U.ReadWrite.IoOffset;
+    SearchEntry.Cookie = NextOffset;
+    TreeNode = RtlRedBlackTreeSearchClosest(&(Directory->CookieTree),
+                                            &(SearchEntry.CookieNode),
+                                            TRUE);
+
+    Status = STATUS_SUCCESS;
+    while (TreeNode != NULL) {
+        Entry = RED_BLACK_TREE_VALUE(TreeNode, TMPFS_ENTRY, CookieNode);
+        EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) +
+                                   Entry->NameLength + 1,
+                                   8);
+
+        if (EntrySize > SpaceLeft) {
+            Status = STATUS_MORE_PROCESSING_REQUIRED;
+            break;
+        }
+
+        NextOffset = Entry->Cookie + 1;
+        UserEntry.FileId = Entry->Node->Properties.FileId;
+        UserEntry.NextOffset = NextOffset;
+        UserEntry.Size = EntrySize;
+        UserEntry.Type = Entry->Node->Properties.Type;
+        Status = MmCopyIoBufferData(IoBuffer,
+                                    &UserEntry,
+                                    BytesWritten,
+                                    sizeof(DIRECTORY_ENTRY),
+                                    TRUE);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Status = MmCopyIoBufferData(IoBuffer,
+                                    Entry->Name,
+                                    BytesWritten + sizeof(DIRECTORY_ENTRY),
+                                    Entry->NameLength + 1,
+                                    TRUE);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        BytesWritten += EntrySize;
+        SpaceLeft -= EntrySize;
+        TreeNode = RtlRedBlackTreeGetNextNode(&(Directory->CookieTree),
+                                              FALSE,
+                                              TreeNode);
+    }
+
+    if ((KSUCCESS(Status)) && (BytesWritten == 0)) {
+        Status = STATUS_END_OF_FILE;
+    }
+
+    Irp->U.ReadWrite.IoBytesCompleted = BytesWritten;
+    Irp->U.ReadWrite.NewIoOffset = NextOffset;
+    return Status;
+}
+
+KSTATUS
+TmpfspPerformFileIo (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Node,
+    PIRP Irp
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads or writes file data. Writes come from the page cache
+    shedding pages (or from non-cached I/O) and are stashed in paged pool.
+    Reads fill from those pages, with zeros for anything never pushed down.
+    The volume lock must be held exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Node - Supplies a pointer to the file node.
+
+    Irp - Supplies a pointer to the I/O IRP.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN BytesThisRound;
+    UINTN Completed;
+    ULONGLONG EndOffset;
+    ULONGLONG FileSize;
+    PIO_BUFFER IoBuffer;
+    ULONGLONG Offset;
+    PTMPFS_PAGE Page;
+    ULONG PageOffset;
+    ULONG PageSize;
+    TMPFS_PAGE SearchPage;
+    UINTN Size;
+    KSTATUS Status;
+    PRED_BLACK_TREE_NODE TreeNode;
+
+    IoBuffer = Irp->U.ReadWrite.IoBuffer;
+    Offset = Irp->U.ReadWrite.IoOffset;
+    Size = Irp->U.ReadWrite.IoSizeInBytes;
+    PageSize = MmPageSize();
+    Completed = 0;
+    Status = STATUS_SUCCESS;
+    if (Irp->MinorCode == IrpMinorIoRead) {
+        READ_INT64_SYNC(&(Irp->U.ReadWrite.FileProperties->FileSize),
+                        &FileSize);
+
+        if (Offset >= FileSize) {
+            Status = STATUS_END_OF_FILE;
+            goto PerformFileIoEnd;
+        }
+
+        if ((FileSize - Offset) < Size) {
+            Size = FileSize - Offset;
+        }
+
+    //
+    // Non-cached writes may extend the file without a truncate first, so
+    // make sure the space is paid for.
+    //
+
+    } else {
+
+        ASSERT(Irp->MinorCode == IrpMinorIoWrite);
+
+        EndOffset = Offset + Size;
+        if (EndOffset > Node->ChargedSize) {
+            Status = TmpfspChargeNode(Volume, Node, EndOffset);
+            if (!KSUCCESS(Status)) {
+                goto PerformFileIoEnd;
+            }
+        }
+    }
+
+    while (Completed < Size) {
+        PageOffset = REMAINDER(Offset, PageSize);
+        BytesThisRound = PageSize - PageOffset;
+        if (BytesThisRound > (Size - Completed)) {
+            BytesThisRound = Size - Completed;
+        }
+
+        SearchPage.Offset = Offset - PageOffset;
+        TreeNode = RtlRedBlackTreeSearch(&(Node->PageTree),
+                                         &(SearchPage.TreeNode));
+
+        Page = NULL;
+        if (TreeNode != NULL) {
+            Page = RED_BLACK_TREE_VALUE(TreeNode, TMPFS_PAGE, TreeNode);
+        }
+
+        if (Irp->MinorCode == IrpMinorIoRead) {
+            if (Page == NULL) {
+                Status = MmZeroIoBuffer(IoBuffer, Completed, BytesThisRound);
+
+            } else {
+                Status = MmCopyIoBufferData(IoBuffer,
+                                            Page->Data + PageOffset,
+                                            Completed,
+                                            BytesThisRound,
+                                            TRUE);
+            }
+
+        } else {
+            if (Page == NULL) {
+                Page = MmAllocatePagedPool(
+                               FIELD_OFFSET(TMPFS_PAGE, Data) + PageSize,
+                               TMPFS_ALLOCATION_TAG);
+
+                if (Page == NULL) {
+                    Status = STATUS_INSUFFICIENT_RESOURCES;
+                    break;
+                }
+
+                Page->Offset = SearchPage.Offset;
+                RtlZeroMemory(Page->Data, PageSize);
+                RtlRedBlackTreeInsert(&(Node->PageTree), &(Page->TreeNode));
+            }
+
+            Status = MmCopyIoBufferData(IoBuffer,
+                                        Page->Data + PageOffset,
+                                        Completed,
+                                        BytesThisRound,
+                                        FALSE);
+        }
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Completed += BytesThisRound;
+        Offset += BytesThisRound;
+    }
+
+PerformFileIoEnd:
+    Irp->U.ReadWrite.IoBytesCompleted = Completed;
+    Irp->U.ReadWrite.NewIoOffset = Irp->U.ReadWrite.IoOffset + Completed;
+    return Status;
+}
+
+VOID
+TmpfspHandleDeviceInformationRequest (
+    PIRP Irp,
+    PTMPFS_VOLUME Volume
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles requests to get and set the volume's device
+    information. Setting it changes the size limit.
+
+Arguments:
+
+    Irp - Supplies a pointer to the IRP making the request.
+
+    Volume - Supplies a pointer to the volume.
+
+Return Value:
+
+    None. Any completion status is set in the IRP.
+
+--*/
+
+{
+
+    PTMPFS_DEVICE_INFORMATION Information;
+    BOOL Match;
+    PSYSTEM_CONTROL_DEVICE_INFORMATION Request;
+    KSTATUS Status;
+
+    Request = Irp->U.SystemControl.SystemContext;
+
+    //
+    // If this is not a request for the tmpfs device information, ignore it.
+    //
+
+    Match = RtlAreUuidsEqual(&(Request->Uuid), &TmpfsDeviceInformationUuid);
+    if (Match == FALSE) {
+        return;
+    }
+
+    if (Request->DataSize < sizeof(TMPFS_DEVICE_INFORMATION)) {
+        Request->DataSize = sizeof(TMPFS_DEVICE_INFORMATION);
+        Status = STATUS_BUFFER_TOO_SMALL;
+        goto HandleDeviceInformationRequestEnd;
+    }
+
+    Request->DataSize = sizeof(TMPFS_DEVICE_INFORMATION);
+    Information = Request->Data;
+    if (Request->Set != FALSE) {
+        if (Information->Version < TMPFS_DEVICE_INFORMATION_VERSION) {
+            Status = STATUS_VERSION_MISMATCH;
+            goto HandleDeviceInformationRequestEnd;
+        }
+
+        //
+        // Shrinking below what is in use is allowed. It just means nothing
+        // can grow until enough is removed.
+        //
+
+        KeAcquireSharedExclusiveLockExclusive(Volume->Lock);
+        Volume->MaxSize = Information->MaxSize;
+        KeReleaseSharedExclusiveLockExclusive(Volume->Lock);
+    }
+
+    RtlZeroMemory(Information, sizeof(TMPFS_DEVICE_INFORMATION));
+    Information->Version = TMPFS_DEVICE_INFORMATION_VERSION;
+    KeAcquireSharedExclusiveLockShared(Volume->Lock);
+    Information->MaxSize = Volume->MaxSize;
+    Information->UsedSize = Volume->UsedSize;
+    Information->FileCount = Volume->NodeCount;
+    KeReleaseSharedExclusiveLockShared(Volume->Lock);
+    Status = STATUS_SUCCESS;
+
+HandleDeviceInformationRequestEnd:
+    IoCompleteIrp(TmpfsDriver, Irp, Status);
+    return;
+}
+
+KSTATUS
+TmpfspChargeNode (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Node,
+    ULONGLONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adjusts the space charged to the volume for a file to cover
+    the given size, rounded up to a page. The volume lock must be held
+    exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Node - Supplies a pointer to the file node.
+
+    Size - Supplies the size the file needs to be charged for.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_VOLUME_FULL if the volume does not have room to grow the file.
+
+--*/
+
+{
+
+    ULONGLONG Charge;
+    ULONGLONG Growth;
+
+    Charge = ALIGN_RANGE_UP(Size, MmPageSize());
+    if (Charge > Node->ChargedSize) {
+        Growth = Charge - Node->ChargedSize;
+        if ((Volume->UsedSize > Volume->MaxSize) ||
+            (Growth > (Volume->MaxSize - Volume->UsedSize))) {
+
+            return STATUS_VOLUME_FULL;
+        }
+
+        Volume->UsedSize += Growth;
+
+    } else {
+        Volume->UsedSize -= Node->ChargedSize - Charge;
+    }
+
+    Node->ChargedSize = Charge;
+    return STATUS_SUCCESS;
+}
+
+VOID
+TmpfspTrimPages (
+    PTMPFS_NODE Node,
+    ULONGLONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees any stored pages beyond the given size, and zeroes the
+    tail of the last page so that growing the file again reads zeros.
+
+Arguments:
+
+    Node - Supplies a pointer to the file node.
+
+    Size - Supplies the new file size.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_PAGE Page;
+    ULONG PageOffset;
+    ULONG PageSize;
+    TMPFS_PAGE SearchPage;
+    PRED_BLACK_TREE_NODE TreeNode;
+
+    PageSize = MmPageSize();
+    PageOffset = REMAINDER(Size, PageSize);
+    SearchPage.Offset = Size - PageOffset;
+    TreeNode = RtlRedBlackTreeSearchClosest(&(Node->PageTree),
+                                            &(SearchPage.TreeNode),
+                                            TRUE);
+
+    while (TreeNode != NULL) {
+        Page = RED_BLACK_TREE_VALUE(TreeNode, TMPFS_PAGE, TreeNode);
+        TreeNode = RtlRedBlackTreeGetNextNode(&(Node->PageTree),
+                                              FALSE,
+                                              TreeNode);
+
+        if ((Page->Offset == SearchPage.Offset) && (PageOffset != 0)) {
+            RtlZeroMemory(Page->Data + PageOffset, PageSize - PageOffset);
+            continue;
+        }
+
+        RtlRedBlackTreeRemove(&(Node->PageTree), &(Page->TreeNode));
+        MmFreePagedPool(Page);
+    }
+
+    return;
+}
+
+PTMPFS_NODE
+TmpfspCreateNode (
+    PTMPFS_VOLUME Volume,
+    PFILE_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new node and inserts it in the volume. The volume
+    lock must be held exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Properties - Supplies a pointer to the initial properties. The file ID,
+        size, and block information are filled in here.
+
+Return Value:
+
+    Returns a pointer to the new node on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PTMPFS_NODE Node;
+
+    Node = MmAllocatePagedPool(sizeof(TMPFS_NODE), TMPFS_ALLOCATION_TAG);
+    if (Node == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(Node, sizeof(TMPFS_NODE));
+    RtlCopyMemory(&(Node->Properties), Properties, sizeof(FILE_PROPERTIES));
+    Node->Properties.FileId = Volume->NextFileId;
+    Volume->NextFileId += 1;
+    Node->Properties.HardLinkCount = 1;
+    Node->Properties.BlockSize = MmPageSize();
+    Node->Properties.BlockCount = 0;
+    WRITE_INT64_SYNC(&(Node->Properties.FileSize), 0);
+    RtlRedBlackTreeInitialize(&(Node->EntryTree), 0, TmpfspCompareEntryNames);
+    RtlRedBlackTreeInitialize(&(Node->CookieTree),
+                              0,
+                              TmpfspCompareEntryCookies);
+
+    RtlRedBlackTreeInitialize(&(Node->PageTree), 0, TmpfspComparePages);
+    Node->NextCookie = DIRECTORY_CONTENTS_OFFSET;
+    RtlRedBlackTreeInsert(&(Volume->NodeTree), &(Node->TreeNode));
+    Volume->NodeCount += 1;
+    return Node;
+}
+
+VOID
+TmpfspDestroyNode (
+    PTMPFS_VOLUME Volume,
+    PTMPFS_NODE Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a node from the volume and frees it along with its
+    stored data. It must already be unlinked from its directory, and must not
+    have any entries. The volume lock must be held exclusively.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    Node - Supplies a pointer to the node to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(Node->Entry == NULL);
+    ASSERT(Node->EntryCount == 0);
+
+    TmpfspTrimPages(Node, 0);
+    TmpfspChargeNode(Volume, Node, 0);
+    RtlRedBlackTreeRemove(&(Volume->NodeTree), &(Node->TreeNode));
+    Volume->NodeCount -= 1;
+    MmFreePagedPool(Node);
+    return;
+}
+
+PTMPFS_NODE
+TmpfspGetNode (
+    PTMPFS_VOLUME Volume,
+    FILE_ID FileId
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds a node by file ID. The volume lock must be held.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume.
+
+    FileId - Supplies the file ID to look up.
+
+Return Value:
+
+    Returns a pointer to the node on success.
+
+    NULL if there is no such node.
+
+--*/
+
+{
+
+    TMPFS_NODE SearchNode;
+    PRED_BLACK_TREE_NODE TreeNode;
+
+    SearchNode.Properties.FileId = FileId;
+    TreeNode = RtlRedBlackTreeSearch(&(Volume->NodeTree),
+                                     &(SearchNode.TreeNode));
+
+    if (TreeNode == NULL) {
+        return NULL;
+    }
+
+    return RED_BLACK_TREE_VALUE(TreeNode, TMPFS_NODE, TreeNode);
+}
+
+PTMPFS_ENTRY
+TmpfspFindEntry (
+    PTMPFS_NODE Directory,
+    PCSTR Name,
+    ULONG NameSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds an entry in a directory by name. The volume lock must be
+    held.
+
+Arguments:
+
+    Directory - Supplies a pointer to the directory node.
+
+    Name - Supplies a pointer to the name, which may not be null terminated.
+
+    NameSize - Supplies the size of the name buffer including space for a null
+        terminator.
+
+Return Value:
+
+    Returns a pointer to the entry on success.
+
+    NULL if there is no entry by that name.
+
+--*/
+
+{
+
+    TMPFS_ENTRY SearchEntry;
+    PRED_BLACK_TREE_NODE TreeNode;
+
+    SearchEntry.Name = (PSTR)Name;
+    SearchEntry.NameLength = TmpfspGetNameLength(Name, NameSize);
+    TreeNode = RtlRedBlackTreeSearch(&(Directory->EntryTree),
+                                     &(SearchEntry.NameNode));
+
+    if (TreeNode == NULL) {
+        return NULL;
+    }
+
+    return RED_BLACK_TREE_VALUE(TreeNode, TMPFS_ENTRY, NameNode);
+}
+
+KSTATUS
+TmpfspInsertEntry (
+    PTMPFS_NODE Directory,
+    PCSTR Name,
+    ULONG NameSize,
+    PTMPFS_NODE Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a directory entry for a node. The volume lock must be
+    held exclusively.
+
+Arguments:
+
+    Directory - Supplies a pointer to the directory node.
+
+    Name - Supplies a pointer to the name, which may not be null terminated.
+
+    NameSize - Supplies the size of the name buffer including space for a null
+        terminator.
+
+    Node - Supplies a pointer to the node the entry names.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PTMPFS_ENTRY Entry;
+    ULONG NameLength;
+
+    ASSERT(Node->Entry == NULL);
+
+    NameLength = TmpfspGetNameLength(Name, NameSize);
+    if (NameLength == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Entry = MmAllocatePagedPool(sizeof(TMPFS_ENTRY) + NameLength + 1,
+                                TMPFS_ALLOCATION_TAG);
+
+    if (Entry == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    Entry->Name = (PSTR)(Entry + 1);
+    RtlCopyMemory(Entry->Name, Name, NameLength);
+    Entry->Name[NameLength] = '\0';
+    Entry->NameLength = NameLength;
+    Entry->Node = Node;
+    Entry->Cookie = Directory->NextCookie;
+    Directory->NextCookie += 1;
+    RtlRedBlackTreeInsert(&(Directory->EntryTree), &(Entry->NameNode));
+    RtlRedBlackTreeInsert(&(Directory->CookieTree), &(Entry->CookieNode));
+    Directory->EntryCount += 1;
+    Node->Entry = Entry;
+    Node->Parent = Directory;
+    return STATUS_SUCCESS;
+}
+
+VOID
+TmpfspRemoveEntry (
+    PTMPFS_NODE Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes and frees the directory entry naming the given node.
+    The volume lock must be held exclusively.
+
+Arguments:
+
+    Node - Supplies a pointer to the node whose entry should be removed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PTMPFS_NODE Directory;
+    PTMPFS_ENTRY Entry;
+
+    Directory = Node->Parent;
+    Entry = Node->Entry;
+
+    ASSERT((Directory != NULL) && (Entry != NULL));
+    ASSERT(Directory->EntryCount != 0);
+
+    RtlRedBlackTreeRemove(&(Directory->EntryTree), &(Entry->NameNode));
+    RtlRedBlackTreeRemove(&(Directory->CookieTree), &(Entry->CookieNode));
+    Directory->EntryCount -= 1;
+    Node->Entry = NULL;
+    Node->Parent = NULL;
+    MmFreePagedPool(Entry);
+    return;
+}
+
+ULONG
+TmpfspGetNameLength (
+    PCSTR Name,
+    ULONG NameSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the length of a name that may or may not be null
+    terminated.
+
+Arguments:
+
+    Name - Supplies a pointer to the name.
+
+    NameSize - Supplies the size of the name buffer including space for a null
+        terminator.
+
+Return Value:
+
+    Returns the length of the name, not including any terminator.
+
+--*/
+
+{
+
+    ULONG Length;
+
+    Length = 0;
+    while ((Length + 1 < NameSize) && (Name[Length] != '\0')) {
+        Length += 1;
+    }
+
+    return Length;
+}
+
+ULONGLONG
+TmpfspGetDirectorySize (
+    PTMPFS_NODE Directory
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the size to report for a directory. It only grows, in
+    keeping with how the system treats directory sizes.
+
+Arguments:
+
+    Directory - Supplies a pointer to the directory node.
+
+Return Value:
+
+    Returns the directory size in bytes.
+
+--*/
+
+{
+
+    return Directory->NextCookie * sizeof(DIRECTORY_ENTRY);
+}
+
+COMPARISON_RESULT
+TmpfspCompareNodes (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two nodes by file ID.
+
+Arguments:
+
+    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+
+    FirstNode - Supplies a pointer to the left side of the comparison.
+
+    SecondNode - Supplies a pointer to the second side of the comparison.
+
+Return Value:
+
+    Same if the two nodes have the same value.
+
+    Ascending if the first node is less than the second node.
+
+    Descending if the second node is less than the first node.
+
+--*/
+
+{
+
+    PTMPFS_NODE First;
+    PTMPFS_NODE Second;
+
+    First = RED_BLACK_TREE_VALUE(FirstNode, TMPFS_NODE, TreeNode);
+    Second = RED_BLACK_TREE_VALUE(SecondNode, TMPFS_NODE, TreeNode);
+    if (First->Properties.FileId < Second->Properties.FileId) {
+        return ComparisonResultAscending;
+    }
+
+    if (First->Properties.FileId > Second->Properties.FileId) {
+        return ComparisonResultDescending;
+    }
+
+    return ComparisonResultSame;
+}
+
+COMPARISON_RESULT
+TmpfspCompareEntryNames (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two directory entries by name.
+
+Arguments:
+
+    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+
+    FirstNode - Supplies a pointer to the left side of the comparison.
+
+    SecondNode - Supplies a pointer to the second side of the comparison.
+
+Return Value:
+
+    Same if the two nodes have the same value.
+
+    Ascending if the first node is less than the second node.
+
+    Descending if the second node is less than the first node.
+
+--*/
+
+{
+
+    PTMPFS_ENTRY First;
+    ULONG Index;
+    ULONG Length;
+    PTMPFS_ENTRY Second;
+
+    First = RED_BLACK_TREE_VALUE(FirstNode, TMPFS_ENTRY, NameNode);
+    Second = RED_BLACK_TREE_VALUE(SecondNode, TMPFS_ENTRY, NameNode);
+    Length = First->NameLength;
+    if (Second->NameLength < Length) {
+        Length = Second->NameLength;
+    }
+
+    for (Index = 0; Index < Length; Index += 1) {
+        if ((UCHAR)First->Name[Index] < (UCHAR)Second->Name[Index]) {
+            return ComparisonResultAscending;
+        }
+
+        if ((UCHAR)First->Name[Index] > (UCHAR)Second->Name[Index]) {
+            return ComparisonResultDescending;
+        }
+    }
+
+    if (First->NameLength < Second->NameLength) {
+        return ComparisonResultAscending;
+    }
+
+    if (First->NameLength > Second->NameLength) {
+        return ComparisonResultDescending;
+    }
+
+    return ComparisonResultSame;
+}
+
+COMPARISON_RESULT
+TmpfspCompareEntryCookies (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two directory entries by cookie.
+
+Arguments:
+
+    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+
+    FirstNode - Supplies a pointer to the left side of the comparison.
+
+    SecondNode - Supplies a pointer to the second side of the comparison.
+
+Return Value:
+
+    Same if the two nodes have the same value.
+
+    Ascending if the first node is less than the second node.
+
+    Descending if the second node is less than the first node.
+
+--*/
+
+{
+
+    PTMPFS_ENTRY First;
+    PTMPFS_ENTRY Second;
+
+    First = RED_BLACK_TREE_VALUE(FirstNode, TMPFS_ENTRY, CookieNode);
+    Second = RED_BLACK_TREE_VALUE(SecondNode, TMPFS_ENTRY, CookieNode);
+    if (First->Cookie < Second->Cookie) {
+        return ComparisonResultAscending;
+    }
+
+    if (First->Cookie > Second->Cookie) {
+        return ComparisonResultDescending;
+    }
+
+    return ComparisonResultSame;
+}
+
+COMPARISON_RESULT
+TmpfspComparePages (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two stored pages by file offset.
+
+Arguments:
+
+    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+
+    FirstNode - Supplies a pointer to the left side of the comparison.
+
+    SecondNode - Supplies a pointer to the second side of the comparison.
+
+Return Value:
+
+    Same if the two nodes have the same value.
+
+    Ascending if the first node is less than the second node.
+
+    Descending if the second node is less than the first node.
+
+--*/
+
+{
+
+    PTMPFS_PAGE First;
+    PTMPFS_PAGE Second;
+
+    First = RED_BLACK_TREE_VALUE(FirstNode, TMPFS_PAGE, TreeNode);
+    Second = RED_BLACK_TREE_VALUE(SecondNode, TMPFS_PAGE, TreeNode);
+    if (First->Offset < Second->Offset) {
+        return ComparisonResultAscending;
+    }
+
+    if (First->Offset > Second->Offset) {
+        return ComparisonResultDescending;
+    }
+
+    return ComparisonResultSame;
+}
+
@@ -1126,6 +1126,18 @@ Return Value:
         case IrpMinorStartDevice:
             if (Irp->Direction == IrpUp) {
                 Status = UsbMasspStartDisk(Disk);
+
+                //
+                // USB mass storage is nearly always flash, and the bulk-only
+                // transport runs one command at a time.
+                //
+
+                if (KSUCCESS(Status)) {
+                    Status = IoSetBlockDeviceScheduler(Irp->Device,
+                                                       IoBlockSchedulerNone,
+                                                       1);
+                }
+
                 IoCompleteIrp(UsbMassDriver, Irp, Status);
             }
 
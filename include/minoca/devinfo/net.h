@@ -78,6 +78,33 @@ Module Name:
 
 #define NETWORK_80211_MAX_SSID_LENGTH 32
 
+//
+// Define the UUID and version for the network device interrupt coalescing
+// information.
+//
+
+#define NETWORK_DEVICE_COALESCING_INFORMATION_UUID \
+    {{0x5B3C9E21, 0x7A4611F1, 0x9D2E0401, 0x0FDD7401}}
+
+#define NETWORK_DEVICE_COALESCING_INFORMATION_VERSION 0x00010000
+
+//
+// Define the network device interrupt coalescing information flags.
+//
+
+//
+// This flag is set if the device has its received frames polled by the
+// networking core rather than processing them from every interrupt.
+//
+
+#define NETWORK_DEVICE_COALESCING_FLAG_POLLED 0x00000001
+
+//
+// This flag is set if the device supports hardware interrupt coalescing.
+//
+
+#define NETWORK_DEVICE_COALESCING_FLAG_HARDWARE 0x00000002
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -211,6 +238,51 @@ typedef struct _NETWORK_80211_DEVICE_INFORMATION {
     NETWORK_ENCRYPTION_TYPE GroupEncryption;
 } NETWORK_80211_DEVICE_INFORMATION, *PNETWORK_80211_DEVICE_INFORMATION;
 
+/*++
+
+Structure Description:
+
+    This structure defines the interrupt coalescing and polling settings of a
+    network device.
+
+Members:
+
+    Version - Stores the table version. Future revisions will be backwards
+        compatible. Set to NETWORK_DEVICE_COALESCING_INFORMATION_VERSION.
+
+    Flags - Stores a bitfield of flags describing what the device supports.
+        See NETWORK_DEVICE_COALESCING_FLAG_* definitions. This is ignored on
+        set.
+
+    PollBudget - Stores the maximum number of received frames processed per
+        poll round before other devices get a turn. This is only meaningful
+        for polled devices.
+
+    ReceiveMicroseconds - Stores the number of microseconds the hardware
+        waits after receiving a frame before interrupting.
+
+    ReceiveFrames - Stores the number of received frames the hardware waits
+        for before interrupting.
+
+    TransmitMicroseconds - Stores the number of microseconds the hardware
+        waits after sending a frame before interrupting.
+
+    TransmitFrames - Stores the number of sent frames the hardware waits for
+        before interrupting.
+
+--*/
+
+typedef struct _NETWORK_DEVICE_COALESCING_INFORMATION {
+    ULONG Version;
+    ULONG Flags;
+    ULONG PollBudget;
+    ULONG ReceiveMicroseconds;
+    ULONG ReceiveFrames;
+    ULONG TransmitMicroseconds;
+    ULONG TransmitFrames;
+} NETWORK_DEVICE_COALESCING_INFORMATION,
+    *PNETWORK_DEVICE_COALESCING_INFORMATION;
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -0,0 +1,77 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    tmpfs.h
+
+Abstract:
+
+    This header contains definitions for the device information structure
+    published by memory-backed temporary file system volumes.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define TMPFS_DEVICE_INFORMATION_UUID \
+    {{0x9860A430, 0x78D2412A, 0x82565D02, 0xC7EFD9C2}}
+
+#define TMPFS_DEVICE_INFORMATION_VERSION 0x00010000
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the device information published by temporary file
+    system volumes. Only the maximum size can be set.
+
+Members:
+
+    Version - Stores the table version. Future revisions will be backwards
+        compatible. Set to TMPFS_DEVICE_INFORMATION_VERSION.
+
+    MaxSize - Stores the maximum number of bytes of file data the volume will
+        hold. Files are charged their size rounded up to a page.
+
+    UsedSize - Stores the number of bytes of file data currently charged to
+        the volume.
+
+    FileCount - Stores the number of files and directories on the volume.
+
+--*/
+
+typedef struct _TMPFS_DEVICE_INFORMATION {
+    ULONG Version;
+    ULONGLONG MaxSize;
+    ULONGLONG UsedSize;
+    ULONGLONG FileCount;
+} TMPFS_DEVICE_INFORMATION, *PTMPFS_DEVICE_INFORMATION;
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
@@ -35,7 +35,7 @@ Module Name:
 
 #define BOOT_INITIALIZATION_BLOCK_VERSION 3
 
-#define KERNEL_INITIALIZATION_BLOCK_VERSION 3
+#define KERNEL_INITIALIZATION_BLOCK_VERSION 4
 
 //
 // Define boot initialization flags.
@@ -302,6 +302,12 @@ Structure Description:
         counter, used for very early stall services. On some architectures or
         platforms this may be 0.
 
+    BootTimeline - Stores a pointer to the array of boot timeline events
+        recorded by the loader, timestamped with the cycle counter.
+
+    BootTimelineCount - Stores the number of valid events in the boot
+        timeline array.
+
 --*/
 
 typedef struct _KERNEL_INITIALIZATION_BLOCK {
@@ -327,6 +333,8 @@ typedef struct _KERNEL_INITIALIZATION_BLOCK {
     SYSTEM_FIRMWARE_TYPE FirmwareType;
     PVOID EfiRuntimeServices;
     ULONGLONG CycleCounterFrequency;
+    PBOOT_TIMELINE_EVENT BootTimeline;
+    ULONG BootTimelineCount;
 } KERNEL_INITIALIZATION_BLOCK, *PKERNEL_INITIALIZATION_BLOCK;
 
 /*++
@@ -95,6 +95,17 @@ Module Name:
 
 #define DEVICE_STATE_HISTORY 10
 
+//
+// Define kernel command line information for the I/O subsystem. The device
+// workers argument sets how many devices can be started or enumerated at
+// once, and the start times argument prints how long each device took to
+// start.
+//
+
+#define IO_KERNEL_ARGUMENT_COMPONENT "io"
+#define IO_KERNEL_ARGUMENT_DEVICE_WORKERS "devworkers"
+#define IO_KERNEL_ARGUMENT_START_TIMES "starttimes"
+
 //
 // Define the current version number of the driver function table.
 //
@@ -244,6 +255,14 @@ Module Name:
 
 #define OPEN_FLAG_ASYNCHRONOUS 0x00000800
 
+//
+// Set this flag to transfer data directly between the caller's buffer and the
+// backing device, bypassing the page cache, whenever the buffer, offset, and
+// size are block aligned. Unaligned I/O still goes through the page cache.
+//
+
+#define OPEN_FLAG_DIRECT 0x00001000
+
 //
 // Set this flag if a file should be atomically unlinked after creation so that
 // it never appears in the namespace. The call will fail if the file already
@@ -344,6 +363,13 @@ Module Name:
 
 #define IO_FLAG_FS_METADATA 0x00000010
 
+//
+// This flag indicates that a directory read should return the file properties
+// of each entry along with its name. See DIRECTORY_ENTRY_TYPE_PROPERTIES.
+//
+
+#define IO_FLAG_DIRECTORY_PROPERTIES 0x00000020
+
 //
 // Set this flag if the IRP needs to execute in a no-allocate code path. As a
 // result none of the data or code it touches can be pagable.
@@ -847,6 +873,41 @@ Module Name:
 #define DIRECTORY_OFFSET_DOT_DOT 1
 #define DIRECTORY_CONTENTS_OFFSET 2
 
+//
+// This bit is set in the type of a directory entry if a FILE_PROPERTIES
+// structure follows the entry's name. The name is padded out to an 8 byte
+// boundary, the properties are placed after it, and the entry size covers all
+// of it. The properties therefore always sit at the end of the entry.
+//
+
+#define DIRECTORY_ENTRY_TYPE_PROPERTIES 0x80
+#define DIRECTORY_ENTRY_TYPE_MASK 0x7F
+
+//
+// Define the number of bytes the file properties add to a directory entry.
+//
+
+#define DIRECTORY_ENTRY_PROPERTIES_SIZE \
+    ALIGN_RANGE_UP(sizeof(FILE_PROPERTIES), 8)
+
+//
+// This macro returns the size of a directory entry with properties given the
+// size of its name, including the null terminator.
+//
+
+#define DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(_NameSize)                  \
+    (ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + (_NameSize), 8) +          \
+     DIRECTORY_ENTRY_PROPERTIES_SIZE)
+
+//
+// This macro returns a pointer to the properties of a directory entry that
+// has the properties type bit set.
+//
+
+#define DIRECTORY_ENTRY_PROPERTIES(_Entry)                               \
+    ((PFILE_PROPERTIES)((PUCHAR)(_Entry) + (_Entry)->Size -              \
+                        DIRECTORY_ENTRY_PROPERTIES_SIZE))
+
 //
 // Set this flag in lookup if the device's data should not be cached. It is
 // intended for use with block devices.
@@ -854,6 +915,14 @@ Module Name:
 
 #define LOOKUP_FLAG_NON_CACHED 0x00000001
 
+//
+// Set this flag in a root lookup if the volume's file data lives only in the
+// page cache. Dirty data is then never written back during normal cleaning,
+// and is only sent down to the file system under memory pressure.
+//
+
+#define LOOKUP_FLAG_NO_BACKING_STORE 0x00000002
+
 //
 // Define the version number for the I/O cache statistics.
 //
@@ -868,6 +937,34 @@ Module Name:
 #define IO_GLOBAL_STATISTICS_VERSION 0x1
 #define IO_GLOBAL_STATISTICS_MAX_VERSION 0x10000000
 
+//
+// Define I/O priority values. An I/O priority is a class in the upper bits
+// and a level within the class in the lower bits, where level 0 is the most
+// urgent. A thread or process with class none uses the next priority up: the
+// thread falls back to its process, and the process to the best effort
+// default. These must line up with the IOPRIO_* definitions in
+// sys/resource.h in the C library.
+//
+
+#define IO_PRIORITY_CLASS_SHIFT 13
+#define IO_PRIORITY_LEVEL_MASK ((1 << IO_PRIORITY_CLASS_SHIFT) - 1)
+
+#define IO_PRIORITY_CLASS_NONE 0
+#define IO_PRIORITY_CLASS_REAL_TIME 1
+#define IO_PRIORITY_CLASS_BEST_EFFORT 2
+#define IO_PRIORITY_CLASS_IDLE 3
+
+#define IO_PRIORITY_LEVEL_COUNT 8
+#define IO_PRIORITY_DEFAULT_LEVEL 4
+
+#define IO_PRIORITY_CLASS(_Priority) ((_Priority) >> IO_PRIORITY_CLASS_SHIFT)
+#define IO_PRIORITY_LEVEL(_Priority) ((_Priority) & IO_PRIORITY_LEVEL_MASK)
+#define IO_PRIORITY_VALUE(_Class, _Level) \
+    (((_Class) << IO_PRIORITY_CLASS_SHIFT) | (_Level))
+
+#define IO_PRIORITY_DEFAULT \
+    IO_PRIORITY_VALUE(IO_PRIORITY_CLASS_BEST_EFFORT, IO_PRIORITY_DEFAULT_LEVEL)
+
 //
 // Define the device ID given to the object manager.
 //
@@ -1023,8 +1120,16 @@ typedef enum _IO_INFORMATION_TYPE {
     IoInformationBoot,
     IoInformationMountPoints,
     IoInformationCacheStatistics,
+    IoInformationBlockDeviceStatistics,
 } IO_INFORMATION_TYPE, *PIO_INFORMATION_TYPE;
 
+typedef enum _IO_BLOCK_SCHEDULER {
+    IoBlockSchedulerDefault,
+    IoBlockSchedulerNone,
+    IoBlockSchedulerDeadline,
+    IoBlockSchedulerCount
+} IO_BLOCK_SCHEDULER, *PIO_BLOCK_SCHEDULER;
+
 /*++
 
 Structure Description:
@@ -1485,6 +1590,12 @@ typedef enum _IO_OBJECT_TYPE {
     IoObjectTerminalSlave,
     IoObjectSharedMemoryObject,
     IoObjectSymbolicLink,
+    IoObjectEventPoll,
+    IoObjectEventCounter,
+    IoObjectTimer,
+    IoObjectAsyncIoContext,
+    IoObjectIoRing,
+    IoObjectFileWatch,
     IoObjectTypeCount
 } IO_OBJECT_TYPE, *PIO_OBJECT_TYPE;
 
@@ -1506,10 +1617,12 @@ Structure Description:
 
     Size - Stores the size of the entire entry, including the size of this
         structure plus the size of the null-terminated name after it, including
-        the null terminator byte.
+        the null terminator byte, plus the file properties if present.
 
     Type - Stores the type of the directory entry. This is of type
-        IO_OBJECT_TYPE. Other flags may be added to this field in the future.
+        IO_OBJECT_TYPE, masked by DIRECTORY_ENTRY_TYPE_MASK. The
+        DIRECTORY_ENTRY_TYPE_PROPERTIES bit indicates the file properties
+        follow the name. Other flags may be added to this field in the future.
 
 --*/
 
@@ -1651,7 +1764,10 @@ Structure Description:
     ReceiverList - Stores the head of the list of I/O handles that have agreed
         to get asynchronous signals.
 
-    Lock - Stores a pointer to the lock protecting the list.
+    EventPollList - Stores the head of the list of event poll watches
+        registered against this I/O object state.
+
+    Lock - Stores a pointer to the lock protecting the lists.
 
 --*/
 
@@ -1662,6 +1778,7 @@ typedef struct _IO_ASYNC_STATE {
     PERMISSION_SET SetterPermissions;
     ULONG Signal;
     LIST_ENTRY ReceiverList;
+    LIST_ENTRY EventPollList;
     PQUEUED_LOCK Lock;
 } IO_ASYNC_STATE, *PIO_ASYNC_STATE;
 
@@ -2614,6 +2731,79 @@ typedef struct _IO_GLOBAL_STATISTICS {
 
 /*++
 
+Structure Description:
+
+    This structure defines the statistics of a block device's request queue.
+
+Members:
+
+    DeviceId - Stores the device ID of the block device.
+
+    Scheduler - Stores the I/O scheduler the queue uses.
+
+    QueueDepth - Stores the number of requests the device is handed at once.
+
+    MaxQueuedRequests - Stores the largest number of requests ever queued or
+        in flight at once.
+
+    ReadRequests - Stores the number of reads submitted to the queue.
+
+    WriteRequests - Stores the number of writes submitted to the queue.
+
+    RealTimeRequests - Stores the number of requests submitted in the real
+        time I/O priority class.
+
+    IdleRequests - Stores the number of requests submitted in the idle I/O
+        priority class.
+
+    CompletedRequests - Stores the number of requests completed.
+
+    Dispatches - Stores the number of I/Os actually sent to the device. This
+        is less than the number of requests by the number merged.
+
+    FrontMerges - Stores the number of requests merged onto the front of a
+        waiting request.
+
+    BackMerges - Stores the number of requests merged onto the back of a
+        waiting request.
+
+    ExpiredRequests - Stores the number of requests issued out of order
+        because they waited past their deadline, including requests from a
+        lower I/O priority class that would otherwise have starved.
+
+    QueuedRequestSum - Stores the sum of the number of requests queued or in
+        flight seen by each new request. Divide by the total number of
+        requests to get the average queue depth.
+
+    TotalLatency - Stores the sum of the time, in microseconds, requests spent
+        from submission to completion.
+
+    MaxLatency - Stores the longest time, in microseconds, any request took
+        from submission to completion.
+
+--*/
+
+typedef struct _IO_BLOCK_DEVICE_STATISTICS {
+    DEVICE_ID DeviceId;
+    IO_BLOCK_SCHEDULER Scheduler;
+    ULONG QueueDepth;
+    ULONG MaxQueuedRequests;
+    ULONGLONG ReadRequests;
+    ULONGLONG WriteRequests;
+    ULONGLONG RealTimeRequests;
+    ULONGLONG IdleRequests;
+    ULONGLONG CompletedRequests;
+    ULONGLONG Dispatches;
+    ULONGLONG FrontMerges;
+    ULONGLONG BackMerges;
+    ULONGLONG ExpiredRequests;
+    ULONGLONG QueuedRequestSum;
+    ULONGLONG TotalLatency;
+    ULONGLONG MaxLatency;
+} IO_BLOCK_DEVICE_STATISTICS, *PIO_BLOCK_DEVICE_STATISTICS;
+
+/*++
+
 Structure Description:
 
     This structure defines system boot information.
@@ -4242,6 +4432,174 @@ Return Value:
 
 --*/
 
+KERNEL_API
+KSTATUS
+IoSendFile (
+    PIO_HANDLE Destination,
+    PIO_HANDLE Source,
+    PIO_OFFSET Offset,
+    UINTN SizeInBytes,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesCompleted
+    );
+
+/*++
+
+Routine Description:
+
+    This routine transfers data from a file to another I/O handle without
+    staging it in a caller supplied buffer. If the source file is cacheable,
+    its page cache entries are referenced into the I/O buffer handed to the
+    destination rather than copied.
+
+Arguments:
+
+    Destination - Supplies a pointer to the I/O handle to write to.
+
+    Source - Supplies a pointer to the I/O handle to read from. This must be a
+        seekable handle.
+
+    Offset - Supplies an optional pointer to the offset within the source to
+        start reading from. On return, this will be updated to the offset just
+        past the last byte transferred. If this is NULL, the source's current
+        file position is used and updated instead.
+
+    SizeInBytes - Supplies the number of bytes to transfer.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that each
+        write to the destination should be waited on before timing out.
+
+    BytesCompleted - Supplies a pointer where the number of bytes transferred
+        will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was transferred, or if the source
+    offset was at or beyond the end of the file.
+
+    Error codes if nothing could be transferred.
+
+--*/
+
+KERNEL_API
+KSTATUS
+IoSplice (
+    PIO_HANDLE Input,
+    PIO_OFFSET InputOffset,
+    PIO_HANDLE Output,
+    PIO_OFFSET OutputOffset,
+    UINTN SizeInBytes,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    );
+
+/*++
+
+Routine Description:
+
+    This routine moves data between two I/O handles, at least one of which
+    must be a pipe. Pages are moved between pipes, referenced from the page
+    cache, or written straight out of the pipe rather than being copied
+    through an intermediate buffer.
+
+Arguments:
+
+    Input - Supplies a pointer to the I/O handle to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        to read from. On return, this is advanced past the bytes moved. If
+        this is NULL, the input's current file position is used. This must be
+        NULL if the input is a pipe.
+
+    Output - Supplies a pointer to the I/O handle to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output to write to. On return, this is advanced past the bytes moved.
+        If this is NULL, the output's current file position is used. This must
+        be NULL if the output is a pipe.
+
+    SizeInBytes - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was moved.
+
+    STATUS_END_OF_FILE if the input pipe is empty and has no writers, or the
+    input file offset is at the end of the file.
+
+    STATUS_INVALID_PARAMETER if neither handle is a pipe, or an offset was
+    supplied for a pipe.
+
+    Other error codes if nothing could be moved.
+
+--*/
+
+KERNEL_API
+KSTATUS
+IoCopyFileRange (
+    PIO_HANDLE Destination,
+    PIO_OFFSET DestinationOffset,
+    PIO_HANDLE Source,
+    PIO_OFFSET SourceOffset,
+    UINTN SizeInBytes,
+    ULONG Flags,
+    PUINTN BytesCopied
+    );
+
+/*++
+
+Routine Description:
+
+    This routine copies a range of one regular file into another without
+    staging the data in a caller supplied buffer. If the source is cacheable,
+    its page cache entries are referenced into the I/O buffer handed to the
+    destination, so the data is copied only once.
+
+Arguments:
+
+    Destination - Supplies a pointer to the I/O handle of the file to write to.
+
+    DestinationOffset - Supplies an optional pointer to the offset within the
+        destination to write to. On return, this is advanced past the bytes
+        copied. If this is NULL, the destination's current file position is
+        used and updated instead.
+
+    Source - Supplies a pointer to the I/O handle of the file to read from.
+
+    SourceOffset - Supplies an optional pointer to the offset within the
+        source to read from. On return, this is advanced past the bytes
+        copied. If this is NULL, the source's current file position is used
+        and updated instead.
+
+    SizeInBytes - Supplies the number of bytes to copy.
+
+    Flags - Supplies a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+    BytesCopied - Supplies a pointer where the number of bytes copied will be
+        returned. This is zero if the source offset is at or beyond the end of
+        the file.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was copied, or if the source offset
+    was at or beyond the end of the file.
+
+    STATUS_INVALID_PARAMETER if flags were supplied, either handle is not a
+    regular file, the destination was opened for appending, or the source and
+    destination ranges overlap within the same file.
+
+    STATUS_FILE_IS_DIRECTORY if either handle is a directory.
+
+    Other error codes if nothing could be copied.
+
+--*/
+
 KERNEL_API
 KSTATUS
 IoFlush (
@@ -5647,7 +6005,7 @@ Return Value:
 --*/
 
 INTN
-IoSysDuplicateHandle (
+IoSysCreateEventPoll (
     PVOID SystemCallParameter
     );
 
@@ -5655,7 +6013,7 @@ IoSysDuplicateHandle (
 
 Routine Description:
 
-    This routine implements the system call for duplicating a file handle.
+    This routine creates a new event poll object on behalf of user mode.
 
 Arguments:
 
@@ -5672,7 +6030,7 @@ Return Value:
 --*/
 
 INTN
-IoSysFileControl (
+IoSysEventPollControl (
     PVOID SystemCallParameter
     );
 
@@ -5680,7 +6038,8 @@ IoSysFileControl (
 
 Routine Description:
 
-    This routine implements the file control system call.
+    This routine adds, modifies, or removes a handle from the interest set of
+    an event poll object.
 
 Arguments:
 
@@ -5697,7 +6056,7 @@ Return Value:
 --*/
 
 INTN
-IoSysGetSetFileInformation (
+IoSysEventPollWait (
     PVOID SystemCallParameter
     );
 
@@ -5705,7 +6064,8 @@ IoSysGetSetFileInformation (
 
 Routine Description:
 
-    This routine implements the get/set file information system call.
+    This routine waits for handles in an event poll object's interest set to
+    become ready.
 
 Arguments:
 
@@ -5715,14 +6075,15 @@ Routine Description:
 
 Return Value:
 
-    STATUS_SUCCESS or positive integer on success.
+    STATUS_SUCCESS or the number of events returned (a positive integer) on
+    success.
 
-    Error status code on failure.
+    Error status code (a negative integer) on failure.
 
 --*/
 
 INTN
-IoSysSeek (
+IoSysCreateEventCounter (
     PVOID SystemCallParameter
     );
 
@@ -5730,7 +6091,7 @@ IoSysSeek (
 
 Routine Description:
 
-    This routine implements the file seek system call.
+    This routine creates a new event counter object on behalf of user mode.
 
 Arguments:
 
@@ -5747,7 +6108,7 @@ Return Value:
 --*/
 
 INTN
-IoSysCreateSymbolicLink (
+IoSysCreateIoTimer (
     PVOID SystemCallParameter
     );
 
@@ -5755,7 +6116,7 @@ IoSysCreateSymbolicLink (
 
 Routine Description:
 
-    This routine creates a symbolic link.
+    This routine creates a new I/O timer object on behalf of user mode.
 
 Arguments:
 
@@ -5772,7 +6133,7 @@ Return Value:
 --*/
 
 INTN
-IoSysReadSymbolicLink (
+IoSysIoTimerControl (
     PVOID SystemCallParameter
     );
 
@@ -5780,7 +6141,7 @@ IoSysReadSymbolicLink (
 
 Routine Description:
 
-    This routine reads and returns the destination of a symbolic link.
+    This routine gets or sets the due time and period of an I/O timer.
 
 Arguments:
 
@@ -5797,7 +6158,7 @@ Return Value:
 --*/
 
 INTN
-IoSysCreateHardLink (
+IoSysSendFile (
     PVOID SystemCallParameter
     );
 
@@ -5805,7 +6166,8 @@ IoSysCreateHardLink (
 
 Routine Description:
 
-    This routine creates a hard link.
+    This routine implements the system call for transferring data from a file
+    to another handle.
 
 Arguments:
 
@@ -5815,14 +6177,15 @@ Routine Description:
 
 Return Value:
 
-    STATUS_SUCCESS or positive integer on success.
+    STATUS_SUCCESS or the number of bytes completed (a positive integer) on
+    success.
 
-    Error status code on failure.
+    Error status code (a negative integer) on failure.
 
 --*/
 
 INTN
-IoSysDelete (
+IoSysCreateAsyncIoContext (
     PVOID SystemCallParameter
     );
 
@@ -5830,7 +6193,8 @@ IoSysDelete (
 
 Routine Description:
 
-    This routine deletes an entry from a directory.
+    This routine creates a new asynchronous I/O context on behalf of user
+    mode.
 
 Arguments:
 
@@ -5847,7 +6211,7 @@ Return Value:
 --*/
 
 INTN
-IoSysRename (
+IoSysSubmitAsyncIo (
     PVOID SystemCallParameter
     );
 
@@ -5855,7 +6219,8 @@ IoSysRename (
 
 Routine Description:
 
-    This routine renames a file or directory.
+    This routine submits a batch of asynchronous I/O requests. The number of
+    requests submitted is returned on success.
 
 Arguments:
 
@@ -5872,7 +6237,7 @@ Return Value:
 --*/
 
 INTN
-IoSysUserControl (
+IoSysWaitForAsyncIo (
     PVOID SystemCallParameter
     );
 
@@ -5880,7 +6245,8 @@ IoSysUserControl (
 
 Routine Description:
 
-    This routine implements the user control system call.
+    This routine waits for a request submitted to an asynchronous I/O context
+    to complete.
 
 Arguments:
 
@@ -5897,7 +6263,7 @@ Return Value:
 --*/
 
 INTN
-IoSysMountOrUnmount (
+IoSysCreateIoRing (
     PVOID SystemCallParameter
     );
 
@@ -5905,7 +6271,7 @@ IoSysMountOrUnmount (
 
 Routine Description:
 
-    This routine mounts or unmounts a file, directory, volume, or device.
+    This routine creates a new I/O ring on behalf of user mode.
 
 Arguments:
 
@@ -5922,7 +6288,7 @@ Return Value:
 --*/
 
 INTN
-IoSysGetEffectiveAccess (
+IoSysEnterIoRing (
     PVOID SystemCallParameter
     );
 
@@ -5930,8 +6296,9 @@ IoSysGetEffectiveAccess (
 
 Routine Description:
 
-    This routine implements the system call for getting the current user's
-    access permission to a given path.
+    This routine consumes submissions from an I/O ring and optionally waits
+    for completions to be posted. The number of submissions consumed is
+    returned on success.
 
 Arguments:
 
@@ -5948,7 +6315,7 @@ Return Value:
 --*/
 
 INTN
-IoSysCreateTerminal (
+IoSysSplice (
     PVOID SystemCallParameter
     );
 
@@ -5956,8 +6323,8 @@ IoSysCreateTerminal (
 
 Routine Description:
 
-    This routine implements the system call for creating and opening a new
-    terminal.
+    This routine implements the system call for moving data between two
+    handles, at least one of which is a pipe.
 
 Arguments:
 
@@ -5967,14 +6334,15 @@ Routine Description:
 
 Return Value:
 
-    STATUS_SUCCESS or positive integer on success.
+    STATUS_SUCCESS or the number of bytes moved (a positive integer) on
+    success.
 
-    Error status code on failure.
+    Error status code (a negative integer) on failure.
 
 --*/
 
 INTN
-IoSysSocketCreatePair (
+IoSysSpliceMemory (
     PVOID SystemCallParameter
     );
 
@@ -5982,8 +6350,8 @@ IoSysSocketCreatePair (
 
 Routine Description:
 
-    This routine handles the system call that creates a pair of connected
-    sockets.
+    This routine implements the system call for placing user mode memory into
+    a pipe without copying it.
 
 Arguments:
 
@@ -5993,14 +6361,15 @@ Routine Description:
 
 Return Value:
 
-    STATUS_SUCCESS or positive integer on success.
+    STATUS_SUCCESS or the number of bytes placed in the pipe (a positive
+    integer) on success.
 
-    Error status code on failure.
+    Error status code (a negative integer) on failure.
 
 --*/
 
 INTN
-IoSysSocketCreate (
+IoSysCopyFileRange (
     PVOID SystemCallParameter
     );
 
@@ -6008,7 +6377,8 @@ IoSysSocketCreate (
 
 Routine Description:
 
-    This routine handles the system call that creates a new socket.
+    This routine implements the system call for copying a range of one file
+    into another.
 
 Arguments:
 
@@ -6018,14 +6388,15 @@ Routine Description:
 
 Return Value:
 
-    STATUS_SUCCESS or positive integer on success.
+    STATUS_SUCCESS or the number of bytes copied (a positive integer) on
+    success.
 
-    Error status code on failure.
+    Error status code (a negative integer) on failure.
 
 --*/
 
 INTN
-IoSysSocketBind (
+IoSysCreateFileWatch (
     PVOID SystemCallParameter
     );
 
@@ -6033,7 +6404,7 @@ IoSysSocketBind (
 
 Routine Description:
 
-    This routine attempts to bind a socket to a local address.
+    This routine creates a new file watch object on behalf of user mode.
 
 Arguments:
 
@@ -6050,7 +6421,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketListen (
+IoSysAddFileWatch (
     PVOID SystemCallParameter
     );
 
@@ -6058,8 +6429,8 @@ IoSysSocketListen (
 
 Routine Description:
 
-    This routine handles the system call that makes a socket listen and become
-    eligible to accept new incoming connections.
+    This routine adds a file or directory to a file watch, or updates the
+    events reported for one already being watched.
 
 Arguments:
 
@@ -6076,7 +6447,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketAccept (
+IoSysRemoveFileWatch (
     PVOID SystemCallParameter
     );
 
@@ -6084,8 +6455,7 @@ IoSysSocketAccept (
 
 Routine Description:
 
-    This routine handles the system call that accepts a new incoming
-    connection on a socket and spins it off into another socket.
+    This routine removes a file or directory from a file watch.
 
 Arguments:
 
@@ -6102,7 +6472,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketConnect (
+IoSysDuplicateHandle (
     PVOID SystemCallParameter
     );
 
@@ -6110,8 +6480,7 @@ IoSysSocketConnect (
 
 Routine Description:
 
-    This routine handles the system call that reaches and and attempts to
-    connect with another socket.
+    This routine implements the system call for duplicating a file handle.
 
 Arguments:
 
@@ -6128,7 +6497,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketPerformIo (
+IoSysFileControl (
     PVOID SystemCallParameter
     );
 
@@ -6136,10 +6505,7 @@ IoSysSocketPerformIo (
 
 Routine Description:
 
-    This routine handles the system call that sends a packet to a specific
-    destination or receives data from a destination. Sockets may also use the
-    generic perform I/O operations if the identity of the remote address is
-    either already known or not needed.
+    This routine implements the file control system call.
 
 Arguments:
 
@@ -6156,7 +6522,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketPerformVectoredIo (
+IoSysGetSetFileInformation (
     PVOID SystemCallParameter
     );
 
@@ -6164,8 +6530,7 @@ IoSysSocketPerformVectoredIo (
 
 Routine Description:
 
-    This routine handles the system call that performs socket I/O using I/O
-    vectors.
+    This routine implements the get/set file information system call.
 
 Arguments:
 
@@ -6182,7 +6547,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketGetSetInformation (
+IoSysSeek (
     PVOID SystemCallParameter
     );
 
@@ -6190,8 +6555,7 @@ IoSysSocketGetSetInformation (
 
 Routine Description:
 
-    This routine implements the system call for getting or setting socket
-    information.
+    This routine implements the file seek system call.
 
 Arguments:
 
@@ -6208,7 +6572,7 @@ Return Value:
 --*/
 
 INTN
-IoSysSocketShutdown (
+IoSysCreateSymbolicLink (
     PVOID SystemCallParameter
     );
 
@@ -6216,8 +6580,7 @@ IoSysSocketShutdown (
 
 Routine Description:
 
-    This routine implements the system call for shutting down communication to
-    a socket.
+    This routine creates a symbolic link.
 
 Arguments:
 
@@ -6234,7 +6597,7 @@ Return Value:
 --*/
 
 INTN
-IoSysLoadDriver (
+IoSysReadSymbolicLink (
     PVOID SystemCallParameter
     );
 
@@ -6242,7 +6605,7 @@ IoSysLoadDriver (
 
 Routine Description:
 
-    This routine loads a driver into the kernel's address space.
+    This routine reads and returns the destination of a symbolic link.
 
 Arguments:
 
@@ -6259,7 +6622,7 @@ Return Value:
 --*/
 
 INTN
-IoSysLocateDeviceInformation (
+IoSysCreateHardLink (
     PVOID SystemCallParameter
     );
 
@@ -6267,8 +6630,7 @@ IoSysLocateDeviceInformation (
 
 Routine Description:
 
-    This routine implements the user mode system call for locating device
-    information registrations by UUID or device ID.
+    This routine creates a hard link.
 
 Arguments:
 
@@ -6285,7 +6647,7 @@ Return Value:
 --*/
 
 INTN
-IoSysGetSetDeviceInformation (
+IoSysDelete (
     PVOID SystemCallParameter
     );
 
@@ -6293,8 +6655,7 @@ IoSysGetSetDeviceInformation (
 
 Routine Description:
 
-    This routine implements the user mode system call for getting and setting
-    device information.
+    This routine deletes an entry from a directory.
 
 Arguments:
 
@@ -6310,7 +6671,497 @@ Return Value:
 
 --*/
 
-VOID
+INTN
+IoSysRename (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine renames a file or directory.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysUserControl (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the user control system call.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysMountOrUnmount (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine mounts or unmounts a file, directory, volume, or device.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysGetEffectiveAccess (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for getting the current user's
+    access permission to a given path.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysCreateTerminal (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for creating and opening a new
+    terminal.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketCreatePair (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that creates a pair of connected
+    sockets.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketCreate (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that creates a new socket.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketBind (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine attempts to bind a socket to a local address.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketListen (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that makes a socket listen and become
+    eligible to accept new incoming connections.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketAccept (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that accepts a new incoming
+    connection on a socket and spins it off into another socket.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketConnect (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that reaches and and attempts to
+    connect with another socket.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketPerformIo (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that sends a packet to a specific
+    destination or receives data from a destination. Sockets may also use the
+    generic perform I/O operations if the identity of the remote address is
+    either already known or not needed.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketPerformVectoredIo (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that performs socket I/O using I/O
+    vectors.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketPerformBatchIo (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that sends or receives several
+    socket messages at once.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    Returns the number of messages completed on success.
+
+    Error status code if the first message failed.
+
+--*/
+
+INTN
+IoSysSocketGetSetInformation (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for getting or setting socket
+    information.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketShutdown (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for shutting down communication to
+    a socket.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysLoadDriver (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine loads a driver into the kernel's address space.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysLocateDeviceInformation (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the user mode system call for locating device
+    information registrations by UUID or device ID.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysGetSetDeviceInformation (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the user mode system call for getting and setting
+    device information.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+VOID
 IoIoHandleAddReference (
     PIO_HANDLE IoHandle
     );
@@ -7336,6 +8187,94 @@ Return Value:
 
 --*/
 
+KERNEL_API
+KSTATUS
+IoSetBlockDeviceScheduler (
+    PDEVICE Device,
+    IO_BLOCK_SCHEDULER Scheduler,
+    ULONG QueueDepth
+    );
+
+/*++
+
+Routine Description:
+
+    This routine configures the request queue in front of a block device.
+    Drivers call this to describe their media, usually when the device is
+    started.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+    Scheduler - Supplies the I/O scheduler to use. Supply
+        IoBlockSchedulerDefault to leave the scheduler unchanged. The deadline
+        scheduler sorts requests into a sweep across the disk, which suits
+        rotational media. Flash media has no seek penalty and is best served
+        by the no-op scheduler, which only merges requests.
+
+    QueueDepth - Supplies the number of requests the device can work on at
+        once. Supply 0 to leave the depth unchanged.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the scheduler is not valid.
+
+    STATUS_INSUFFICIENT_RESOURCES if the queue could not be created.
+
+--*/
+
+KERNEL_API
+KSTATUS
+IoPlugBlockDevice (
+    PDEVICE Device
+    );
+
+/*++
+
+Routine Description:
+
+    This routine plugs a block device's request queue, holding new requests
+    back so that they can be merged and sorted as a batch. Plugging is meant
+    for callers about to generate I/O from several threads at once. The queue
+    is unplugged early once enough requests are waiting, and no request waits
+    behind a plug for longer than a few milliseconds.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KERNEL_API
+VOID
+IoUnplugBlockDevice (
+    PDEVICE Device
+    );
+
+/*++
+
+Routine Description:
+
+    This routine releases a plug taken on a block device's request queue. Once
+    the last plug is released, the requests held back are started.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+Return Value:
+
+    None.
+
+--*/
+
 KERNEL_API
 ULONG
 IoGetCacheEntryDataSize (
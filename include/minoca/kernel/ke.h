@@ -94,6 +94,13 @@ Module Name:
 #define KERNEL_MAX_ARGUMENT_VALUES 10
 #define KERNEL_MAX_COMMAND_LINE 4096
 
+//
+// Define the size of the name buffer in a boot timeline event, including the
+// null terminator. Longer names are truncated.
+//
+
+#define BOOT_TIMELINE_NAME_SIZE 32
+
 //
 // Work queue flags.
 //
@@ -246,8 +253,19 @@ typedef enum _KE_INFORMATION_TYPE {
     KeInformationProcessorUsage,
     KeInformationProcessorCount,
     KeInformationKernelCommandLine,
+    KeInformationBootTimeline,
 } KE_INFORMATION_TYPE, *PKE_INFORMATION_TYPE;
 
+typedef enum _BOOT_TIMELINE_EVENT_TYPE {
+    BootTimelineEventInvalid,
+    BootTimelineEventLoader,
+    BootTimelineEventImageLoad,
+    BootTimelineEventKernelPhase,
+    BootTimelineEventDriverLoad,
+    BootTimelineEventDeviceStart,
+    BootTimelineEventUserMode
+} BOOT_TIMELINE_EVENT_TYPE, *PBOOT_TIMELINE_EVENT_TYPE;
+
 typedef enum _SYSTEM_RESET_TYPE {
     SystemResetInvalid,
     SystemResetShutdown,
@@ -736,6 +754,63 @@ typedef struct _PROCESSOR_COUNT_INFORMATION {
 
 /*++
 
+Structure Description:
+
+    This structure defines a single span of work recorded on the boot timeline.
+
+Members:
+
+    Type - Stores the category of the event.
+
+    Start - Stores the processor counter value when the work began, or 0 if
+        the counter was not available yet.
+
+    End - Stores the processor counter value when the work finished, or 0 if
+        the counter was not available yet.
+
+    Name - Stores the null terminated name of the image, driver, device, or
+        phase the event describes.
+
+--*/
+
+typedef struct _BOOT_TIMELINE_EVENT {
+    BOOT_TIMELINE_EVENT_TYPE Type;
+    ULONGLONG Start;
+    ULONGLONG End;
+    CHAR Name[BOOT_TIMELINE_NAME_SIZE];
+} BOOT_TIMELINE_EVENT, *PBOOT_TIMELINE_EVENT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the boot timeline information returned by the
+    system information call.
+
+Members:
+
+    Frequency - Stores the frequency of the processor counter that the event
+        timestamps are measured in, in Hertz. This may be zero if the counter
+        frequency is not known.
+
+    EventCount - Stores the number of events in the following array.
+
+    DroppedCount - Stores the number of events that could not be recorded
+        because the timeline was full.
+
+    Events - Stores the array of events, in the order they were recorded.
+
+--*/
+
+typedef struct _BOOT_TIMELINE_INFORMATION {
+    ULONGLONG Frequency;
+    ULONG EventCount;
+    ULONG DroppedCount;
+    BOOT_TIMELINE_EVENT Events[ANYSIZE_ARRAY];
+} BOOT_TIMELINE_INFORMATION, *PBOOT_TIMELINE_INFORMATION;
+
+/*++
+
 Structure Description:
 
     This structure defines a queued lock. These locks can be used at or below
@@ -2205,6 +2280,65 @@ Return Value:
 
 --*/
 
+KERNEL_API
+ULONGLONG
+KeGetBootTimelineTimestamp (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns a timestamp suitable for recording on the boot
+    timeline. This routine can be called at any runlevel.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current processor counter value, or 0 if the processor counter
+    is not yet available.
+
+--*/
+
+KERNEL_API
+VOID
+KeRecordBootTimelineEvent (
+    BOOT_TIMELINE_EVENT_TYPE Type,
+    PCSTR Name,
+    ULONGLONG Start,
+    ULONGLONG End
+    );
+
+/*++
+
+Routine Description:
+
+    This routine records an event on the boot timeline. Events are only
+    recorded until the first user mode process starts; after that this routine
+    does nothing. This routine can be called at any runlevel.
+
+Arguments:
+
+    Type - Supplies the category of the event.
+
+    Name - Supplies a pointer to the name of the event. Names longer than the
+        event buffer are truncated.
+
+    Start - Supplies the timestamp when the event began, as returned by
+        KeGetBootTimelineTimestamp.
+
+    End - Supplies the timestamp when the event finished.
+
+Return Value:
+
+    None.
+
+--*/
+
 KERNEL_API
 KSTATUS
 KeResetSystem (
@@ -2646,6 +2780,34 @@ Return Value:
 
 --*/
 
+KERNEL_API
+KSTATUS
+KeAddWorkQueueThreads (
+    PWORK_QUEUE WorkQueue,
+    ULONG ThreadCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds worker threads to a work queue, allowing that many more
+    of its work items to run concurrently. Work items on a queue with more
+    than one thread may complete out of order.
+
+Arguments:
+
+    WorkQueue - Supplies a pointer to the work queue.
+
+    ThreadCount - Supplies the number of threads to add.
+
+Return Value:
+
+    Status code. Threads that were created before a failure remain on the
+    queue.
+
+--*/
+
 KERNEL_API
 VOID
 KeFlushWorkQueue (
@@ -2657,7 +2819,9 @@ KeFlushWorkQueue (
 Routine Description:
 
     This routine flushes a work queue. If there are items on the work queue,
-    they will be completed before this routine returns.
+    they will be completed before this routine returns. This includes items
+    still running on other worker threads of the queue, so this routine must
+    not be called from a work item running on the queue being flushed.
 
 Arguments:
 
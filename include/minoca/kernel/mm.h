@@ -1560,6 +1560,30 @@ Return Value:
 
 --*/
 
+BOOL
+MmIsIoBufferUserMode (
+    PIO_BUFFER IoBuffer
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not the given I/O buffer describes a
+    region of user mode memory.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to an I/O buffer.
+
+Return Value:
+
+    TRUE if the I/O buffer describes user mode memory.
+
+    FALSE if the I/O buffer describes kernel mode memory.
+
+--*/
+
 KERNEL_API
 VOID
 MmSetIoBufferCurrentOffset (
@@ -3830,6 +3854,7 @@ Return Value:
 
 --*/
 
+KERNEL_API
 UINTN
 MmGetTotalPhysicalPages (
     VOID
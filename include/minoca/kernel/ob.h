@@ -103,9 +103,10 @@ Module Name:
 //
 // Define the maximum number of handles. This is fairly arbitrary, and it should
 // be possible to raise this so long as it doesn't collide with INVALID_HANDLE.
+// Handle tables only allocate space for the ranges of descriptors in use.
 //
 
-#define OB_MAX_HANDLES 0x1000
+#define OB_MAX_HANDLES 0x100000
 
 typedef enum _OBJECT_TYPE {
     ObjectInvalid,
@@ -127,6 +128,12 @@ typedef enum _OBJECT_TYPE {
     ObjectTerminalMaster,
     ObjectTerminalSlave,
     ObjectSharedMemoryObject,
+    ObjectEventPoll,
+    ObjectEventCounter,
+    ObjectIoTimer,
+    ObjectAsyncIoContext,
+    ObjectIoRing,
+    ObjectFileWatch,
     ObjectMaxTypes
 } OBJECT_TYPE, *POBJECT_TYPE;
 
@@ -225,8 +232,10 @@ VOID
 
 Routine Description:
 
-    This routine is called whenever a handle is looked up. It is called with
-    the handle table lock still held.
+    This routine is called whenever a handle is looked up. The handle table
+    lock is not held, but the handle cannot be destroyed or replaced until this
+    routine returns, so it can safely take a reference on the handle value. It
+    must not use the handle table.
 
 Arguments:
 
@@ -1139,7 +1148,7 @@ ObGetHandleValue (
 Routine Description:
 
     This routine looks up the given handle and returns the value associated
-    with that handle.
+    with that handle. The handle table lock is not acquired.
 
 Arguments:
 
@@ -1379,6 +1379,9 @@ Structure Description:
         process doesn't necessarily have a reference to. This pointer should
         not be touched without the terminal list lock held.
 
+    IoPriority - Stores the I/O priority of the process, used by threads that
+        do not have their own. See IO_PRIORITY_* definitions.
+
 --*/
 
 struct _KPROCESS {
@@ -1424,6 +1427,7 @@ struct _KPROCESS {
     RESOURCE_USAGE ChildResourceUsage;
     ULONG Umask;
     PVOID ControllingTerminal;
+    ULONG IoPriority;
 };
 
 /*++
@@ -1641,6 +1645,9 @@ Structure Description:
 
     Limits - Stores the resource limits associated with the thread.
 
+    IoPriority - Stores the I/O priority of the thread. If the class is none,
+        the process' I/O priority applies. See IO_PRIORITY_* definitions.
+
 --*/
 
 struct _KTHREAD {
@@ -1679,6 +1686,7 @@ struct _KTHREAD {
     RUNTIME_TIMER UserTimer;
     RUNTIME_TIMER ProfileTimer;
     RESOURCE_LIMIT Limits[ResourceLimitCount];
+    ULONG IoPriority;
 };
 
 /*++
@@ -3278,6 +3286,32 @@ Return Value:
 
 --*/
 
+INTN
+PsSysSetIoPriority (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call that gets or sets the I/O
+    priority of a process or thread.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
 INTN
 PsSysSetUmask (
     PVOID SystemCallParameter
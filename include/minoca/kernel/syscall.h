@@ -93,6 +93,7 @@ Module Name:
 #define SYS_OPEN_FLAG_NO_CONTROLLING_TERMINAL 0x00000200
 #define SYS_OPEN_FLAG_NO_ACCESS_TIME          0x00000400
 #define SYS_OPEN_FLAG_ASYNCHRONOUS            0x00000800
+#define SYS_OPEN_FLAG_DIRECT                  0x00001000
 
 #define SYS_OPEN_ACCESS_SHIFT 29
 #define SYS_OPEN_FLAG_READ    (IO_ACCESS_READ << SYS_OPEN_ACCESS_SHIFT)
@@ -118,14 +119,16 @@ Module Name:
      SYS_OPEN_FLAG_SYNCHRONIZED |               \
      SYS_OPEN_FLAG_NO_CONTROLLING_TERMINAL |    \
      SYS_OPEN_FLAG_NO_ACCESS_TIME |             \
-     SYS_OPEN_FLAG_ASYNCHRONOUS)
+     SYS_OPEN_FLAG_ASYNCHRONOUS |               \
+     SYS_OPEN_FLAG_DIRECT)
 
 #define SYS_FILE_CONTROL_EDITABLE_STATUS_FLAGS \
     (SYS_OPEN_FLAG_APPEND |                    \
      SYS_OPEN_FLAG_NON_BLOCKING |              \
      SYS_OPEN_FLAG_SYNCHRONIZED |              \
      SYS_OPEN_FLAG_NO_ACCESS_TIME |            \
-     SYS_OPEN_FLAG_ASYNCHRONOUS)
+     SYS_OPEN_FLAG_ASYNCHRONOUS |              \
+     SYS_OPEN_FLAG_DIRECT)
 
 //
 // Define delete flags.
@@ -150,8 +153,9 @@ Module Name:
 // Define file I/O flags.
 //
 
-#define SYS_IO_FLAG_WRITE 0x00000001
-#define SYS_IO_FLAG_MASK  0x00000001
+#define SYS_IO_FLAG_WRITE                0x00000001
+#define SYS_IO_FLAG_DIRECTORY_PROPERTIES 0x00000002
+#define SYS_IO_FLAG_MASK                 0x00000003
 
 //
 // Define flush flags.
@@ -259,6 +263,294 @@ Module Name:
     (POLL_EVENT_IN | POLL_EVENT_IN_HIGH_PRIORITY | POLL_EVENT_OUT | \
      POLL_EVENT_OUT_HIGH_PRIORITY)
 
+//
+// Define event poll flags, which are combined with the POLL_EVENT_* mask when
+// registering interest in a handle.
+//
+
+//
+// Set this flag to disable the watch after it reports an event once. It can
+// be re-armed with a modify operation.
+//
+
+#define EVENT_POLL_FLAG_ONE_SHOT        0x40000000
+
+//
+// Set this flag to only report the handle when new events arrive, rather
+// than every time the handle is found to be ready.
+//
+
+#define EVENT_POLL_FLAG_EDGE_TRIGGERED  0x80000000
+
+#define EVENT_POLL_FLAGS_MASK \
+    (EVENT_POLL_FLAG_ONE_SHOT | EVENT_POLL_FLAG_EDGE_TRIGGERED)
+
+//
+// Define event counter flags.
+//
+
+//
+// Set this flag to have each read decrement the counter by one rather than
+// resetting it to zero.
+//
+
+#define EVENT_COUNTER_FLAG_SEMAPHORE 0x00000001
+
+#define EVENT_COUNTER_FLAGS_MASK EVENT_COUNTER_FLAG_SEMAPHORE
+
+//
+// Define the largest value an event counter can hold.
+//
+
+#define EVENT_COUNTER_MAX_VALUE 0xFFFFFFFFFFFFFFFEULL
+
+//
+// Define I/O timer flags.
+//
+
+//
+// This flag is set if the timer was created against the real time clock. The
+// kernel runs every I/O timer off the time counter; the flag is recorded so
+// that user mode knows how to convert absolute due times for the timer.
+//
+
+#define IO_TIMER_FLAG_REAL_TIME 0x00000001
+
+#define IO_TIMER_FLAGS_MASK IO_TIMER_FLAG_REAL_TIME
+
+//
+// Define the status an asynchronous I/O result holds until the request
+// completes. The kernel never completes a request with this status.
+//
+
+#define ASYNC_IO_STATUS_PENDING STATUS_MORE_PROCESSING_REQUIRED
+
+//
+// Define the maximum number of requests that can be submitted at once.
+//
+
+#define ASYNC_IO_MAX_SUBMIT 1024
+
+//
+// Define I/O ring flags, supplied when the ring is created.
+//
+
+//
+// This flag is set to have a kernel thread poll the submission ring, so that
+// submitting I/O does not require a system call while the thread is awake.
+// Submissions on a polled ring must use registered handles, and any buffers
+// they refer to must be within the registered buffer region.
+//
+
+#define IO_RING_FLAG_KERNEL_POLL 0x00000001
+
+#define IO_RING_FLAGS_MASK IO_RING_FLAG_KERNEL_POLL
+
+//
+// Define I/O ring state flags, which the kernel sets in the ring header.
+//
+
+//
+// This flag is set when the kernel polling thread has gone to sleep. User
+// mode must enter the ring with IO_RING_ENTER_FLAG_WAKE to have new
+// submissions noticed.
+//
+
+#define IO_RING_STATE_NEED_WAKE 0x00000001
+
+//
+// Define I/O ring submission flags.
+//
+
+//
+// This flag is set if the submission's handle is an index into the ring's
+// registered handles rather than a handle.
+//
+
+#define IO_RING_SUBMISSION_FLAG_REGISTERED_HANDLE 0x00000001
+
+//
+// This flag is set if the submission's buffer is a byte offset into the
+// ring's registered buffer region rather than a pointer.
+//
+
+#define IO_RING_SUBMISSION_FLAG_REGISTERED_BUFFER 0x00000002
+
+#define IO_RING_SUBMISSION_FLAGS_MASK              \
+    (IO_RING_SUBMISSION_FLAG_REGISTERED_HANDLE |   \
+     IO_RING_SUBMISSION_FLAG_REGISTERED_BUFFER)
+
+//
+// Define I/O ring enter flags.
+//
+
+//
+// This flag is set to wake the ring's kernel polling thread.
+//
+
+#define IO_RING_ENTER_FLAG_WAKE 0x00000001
+
+#define IO_RING_ENTER_FLAGS_MASK IO_RING_ENTER_FLAG_WAKE
+
+//
+// Define the maximum number of entries in an I/O ring and the maximum number
+// of registered handles.
+//
+
+#define IO_RING_MAX_ENTRIES 4096
+#define IO_RING_MAX_REGISTERED_HANDLES 1024
+
+//
+// Define the layout of the shared I/O ring memory: a header, followed by the
+// submission entries, followed by the completion entries.
+//
+
+#define IO_RING_SUBMISSION_OFFSET sizeof(IO_RING_HEADER)
+#define IO_RING_COMPLETION_OFFSET(_SubmissionCount) \
+    (IO_RING_SUBMISSION_OFFSET +                    \
+     ((_SubmissionCount) * sizeof(IO_RING_SUBMISSION)))
+
+#define IO_RING_SIZE(_SubmissionCount, _CompletionCount) \
+    (IO_RING_COMPLETION_OFFSET(_SubmissionCount) +       \
+     ((_CompletionCount) * sizeof(IO_RING_COMPLETION)))
+
+//
+// Set this splice flag to fail rather than wait if the pipe side of the
+// operation is empty or full.
+//
+
+#define SYS_SPLICE_FLAG_NON_BLOCKING 0x00000001
+
+//
+// Set this splice flag to indicate that the caller will not touch the spliced
+// memory again. Spliced memory is always referenced rather than copied, so
+// this is accepted but changes nothing.
+//
+
+#define SYS_SPLICE_FLAG_GIFT 0x00000002
+
+#define SYS_SPLICE_FLAG_MASK \
+    (SYS_SPLICE_FLAG_NON_BLOCKING | SYS_SPLICE_FLAG_GIFT)
+
+//
+// Set this batched socket I/O flag to stop waiting once the first message has
+// completed. Later messages in the batch are only completed if they are
+// available immediately.
+//
+
+#define SYS_SOCKET_BATCH_FLAG_WAIT_FOR_ONE 0x00000001
+
+#define SYS_SOCKET_BATCH_FLAG_MASK SYS_SOCKET_BATCH_FLAG_WAIT_FOR_ONE
+
+//
+// Define file watch events. A watch on a directory reports these for the
+// entries within it, along with the entry's name. A watch on any file reports
+// them for the file itself, without a name. The values match the C library's
+// inotify event bits so that event records can be handed to user mode as is.
+//
+
+//
+// This event is reported when a file's contents are written or truncated.
+//
+
+#define FILE_WATCH_EVENT_MODIFY 0x00000002
+
+//
+// This event is reported when a file's owner, permissions, timestamps or link
+// count change.
+//
+
+#define FILE_WATCH_EVENT_ATTRIBUTES 0x00000004
+
+//
+// These events are reported to the old and new directories when an entry is
+// renamed. Both carry the same cookie so the two halves can be paired up.
+//
+
+#define FILE_WATCH_EVENT_MOVED_FROM 0x00000040
+#define FILE_WATCH_EVENT_MOVED_TO 0x00000080
+
+//
+// These events are reported to a directory when an entry is created in or
+// removed from it.
+//
+
+#define FILE_WATCH_EVENT_CREATE 0x00000100
+#define FILE_WATCH_EVENT_DELETE 0x00000200
+
+//
+// These events are reported to a watched file when its last link is removed
+// or when it is renamed.
+//
+
+#define FILE_WATCH_EVENT_DELETE_SELF 0x00000400
+#define FILE_WATCH_EVENT_MOVE_SELF 0x00000800
+
+#define FILE_WATCH_EVENT_MASK           \
+    (FILE_WATCH_EVENT_MODIFY |          \
+     FILE_WATCH_EVENT_ATTRIBUTES |      \
+     FILE_WATCH_EVENT_MOVED_FROM |      \
+     FILE_WATCH_EVENT_MOVED_TO |        \
+     FILE_WATCH_EVENT_CREATE |          \
+     FILE_WATCH_EVENT_DELETE |          \
+     FILE_WATCH_EVENT_DELETE_SELF |     \
+     FILE_WATCH_EVENT_MOVE_SELF)
+
+//
+// This event is reported, with a descriptor of -1, when events were dropped
+// because too many were queued.
+//
+
+#define FILE_WATCH_EVENT_OVERFLOW 0x00004000
+
+//
+// This event is reported when a watch is removed, either explicitly or
+// because the watched file went away.
+//
+
+#define FILE_WATCH_EVENT_IGNORED 0x00008000
+
+//
+// This bit is set in an event if the entry it describes is a directory.
+//
+
+#define FILE_WATCH_EVENT_DIRECTORY 0x40000000
+
+//
+// Define file watch flags, supplied when a watch is added.
+//
+
+//
+// Set this flag to fail if the path is not a directory.
+//
+
+#define FILE_WATCH_FLAG_DIRECTORY_ONLY 0x00000001
+
+//
+// Set this flag to watch a symbolic link itself rather than its target.
+//
+
+#define FILE_WATCH_FLAG_NO_FOLLOW 0x00000002
+
+//
+// Set this flag to add the given events to an existing watch on the same file
+// rather than replacing them.
+//
+
+#define FILE_WATCH_FLAG_ADD 0x00000004
+
+//
+// Set this flag to remove the watch after it reports one event.
+//
+
+#define FILE_WATCH_FLAG_ONE_SHOT 0x00000008
+
+#define FILE_WATCH_FLAGS_MASK           \
+    (FILE_WATCH_FLAG_DIRECTORY_ONLY |   \
+     FILE_WATCH_FLAG_NO_FOLLOW |        \
+     FILE_WATCH_FLAG_ADD |              \
+     FILE_WATCH_FLAG_ONE_SHOT)
+
 //
 // Define the effective access permission flags.
 //
@@ -351,6 +643,26 @@ typedef enum _SYSTEM_CALL_NUMBER {
     SystemCallSetITimer,
     SystemCallSetResourceLimit,
     SystemCallSetBreak,
+    SystemCallCreateEventPoll,
+    SystemCallEventPollControl,
+    SystemCallEventPollWait,
+    SystemCallCreateEventCounter,
+    SystemCallCreateIoTimer,
+    SystemCallIoTimerControl,
+    SystemCallSendFile,
+    SystemCallCreateAsyncIoContext,
+    SystemCallSubmitAsyncIo,
+    SystemCallWaitForAsyncIo,
+    SystemCallCreateIoRing,
+    SystemCallEnterIoRing,
+    SystemCallSplice,
+    SystemCallSpliceMemory,
+    SystemCallSocketPerformBatchIo,
+    SystemCallSetIoPriority,
+    SystemCallCopyFileRange,
+    SystemCallCreateFileWatch,
+    SystemCallAddFileWatch,
+    SystemCallRemoveFileWatch,
     SystemCallCount
 } SYSTEM_CALL_NUMBER, *PSYSTEM_CALL_NUMBER;
 
@@ -404,9 +716,19 @@ typedef enum _FILE_CONTROL_COMMAND {
     FileControlCommandSetDirectoryFlag,
     FileControlCommandCloseFrom,
     FileControlCommandGetPath,
+    FileControlCommandGetPipeSize,
+    FileControlCommandSetPipeSize,
+    FileControlCommandGetAsyncIoCount,
     FileControlCommandCount
 } FILE_CONTROL_COMMAND, *PFILE_CONTROL_COMMAND;
 
+typedef enum _EVENT_POLL_OPERATION {
+    EventPollOperationInvalid,
+    EventPollOperationAdd,
+    EventPollOperationDelete,
+    EventPollOperationModify
+} EVENT_POLL_OPERATION, *PEVENT_POLL_OPERATION;
+
 typedef enum _TIME_ZONE_OPERATION {
     TimeZoneOperationInvalid,
     TimeZoneOperationGetCurrentZoneData,
@@ -437,6 +759,32 @@ typedef enum _RESOURCE_USAGE_REQUEST {
     ResourceUsageRequestThread,
 } RESOURCE_USAGE_REQUEST, *PRESOURCE_USAGE_REQUEST;
 
+typedef enum _ASYNC_IO_OPERATION {
+    AsyncIoOperationInvalid,
+    AsyncIoOperationRead,
+    AsyncIoOperationWrite,
+    AsyncIoOperationFlush
+} ASYNC_IO_OPERATION, *PASYNC_IO_OPERATION;
+
+typedef enum _IO_RING_OPERATION {
+    IoRingOperationNop,
+    IoRingOperationRead,
+    IoRingOperationWrite,
+    IoRingOperationReadVector,
+    IoRingOperationPollAdd,
+    IoRingOperationAccept,
+    IoRingOperationSend,
+    IoRingOperationReceive,
+    IoRingOperationFlush,
+    IoRingOperationCount
+} IO_RING_OPERATION, *PIO_RING_OPERATION;
+
+typedef enum _IO_PRIORITY_REQUEST {
+    IoPriorityRequestInvalid,
+    IoPriorityRequestProcess,
+    IoPriorityRequestThread,
+} IO_PRIORITY_REQUEST, *PIO_PRIORITY_REQUEST;
+
 //
 // System call parameter structures
 //
@@ -954,6 +1302,165 @@ typedef struct _SYSTEM_CALL_POLL {
 
 /*++
 
+Structure Description:
+
+    This structure defines an event registered with or returned from an event
+    poll object.
+
+Members:
+
+    Events - Stores the bitmask of events. When registering, this is the set
+        of POLL_EVENT_* flags to watch for, plus any EVENT_POLL_FLAG_* flags.
+        When returned, this is the set of events that are signaled.
+
+    Data - Stores an opaque value supplied when registering the handle, which
+        is handed back whenever the handle is reported.
+
+--*/
+
+typedef struct _EVENT_POLL_EVENT {
+    ULONG Events;
+    ULONGLONG Data;
+} EVENT_POLL_EVENT, *PEVENT_POLL_EVENT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating an event
+    poll object.
+
+Members:
+
+    OpenFlags - Stores the open flags for the new handle. Only
+        SYS_OPEN_FLAG_CLOSE_ON_EXECUTE is permitted.
+
+    Handle - Stores the returned handle to the event poll object.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_EVENT_POLL {
+    ULONG OpenFlags;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_EVENT_POLL, *PSYSTEM_CALL_CREATE_EVENT_POLL;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for changing the set of
+    handles watched by an event poll object.
+
+Members:
+
+    EventPoll - Stores the handle to the event poll object.
+
+    Operation - Stores the operation to perform.
+
+    Handle - Stores the handle to add, modify, or remove.
+
+    Event - Stores the events and data to register for add and modify
+        operations. This is ignored for delete operations.
+
+--*/
+
+typedef struct _SYSTEM_CALL_EVENT_POLL_CONTROL {
+    HANDLE EventPoll;
+    EVENT_POLL_OPERATION Operation;
+    HANDLE Handle;
+    EVENT_POLL_EVENT Event;
+} SYSCALL_STRUCT SYSTEM_CALL_EVENT_POLL_CONTROL,
+    *PSYSTEM_CALL_EVENT_POLL_CONTROL;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for waiting on an event
+    poll object.
+
+Members:
+
+    EventPoll - Stores the handle to the event poll object.
+
+    SignalMask - Stores an optional pointer to a signal mask to set for the
+        duration of the wait.
+
+    Events - Stores a pointer to a buffer where the ready events are returned.
+
+    EventCount - Stores the number of elements in the events array.
+
+    TimeoutInMilliseconds - Stores the number of milliseconds to wait for a
+        handle to become ready before giving up.
+
+--*/
+
+typedef struct _SYSTEM_CALL_EVENT_POLL_WAIT {
+    HANDLE EventPoll;
+    PSIGNAL_SET SignalMask;
+    PEVENT_POLL_EVENT Events;
+    LONG EventCount;
+    ULONG TimeoutInMilliseconds;
+} SYSCALL_STRUCT SYSTEM_CALL_EVENT_POLL_WAIT, *PSYSTEM_CALL_EVENT_POLL_WAIT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating an event
+    counter object.
+
+Members:
+
+    OpenFlags - Stores the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Stores a bitfield of flags governing the counter's behavior. See
+        EVENT_COUNTER_FLAG_* definitions.
+
+    InitialValue - Stores the initial value of the counter.
+
+    Handle - Stores the returned handle to the event counter.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_EVENT_COUNTER {
+    ULONG OpenFlags;
+    ULONG Flags;
+    ULONG InitialValue;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_EVENT_COUNTER,
+    *PSYSTEM_CALL_CREATE_EVENT_COUNTER;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating an I/O
+    timer object, a timer whose expirations are read from a handle.
+
+Members:
+
+    OpenFlags - Stores the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Stores a bitfield of flags for the timer. See IO_TIMER_FLAG_*
+        definitions.
+
+    Handle - Stores the returned handle to the I/O timer.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_IO_TIMER {
+    ULONG OpenFlags;
+    ULONG Flags;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_IO_TIMER, *PSYSTEM_CALL_CREATE_IO_TIMER;
+
+/*++
+
 Structure Description:
 
     This structure defines the system call parameters for creating a new
@@ -1223,6 +1730,13 @@ Structure Description:
     Owner - Stores the ID of the process to receive signals on asynchronous
         I/O events.
 
+    PipeSize - Stores the size of a pipe's buffer in bytes. For set
+        operations, this supplies the requested size and returns the actual
+        size, which is rounded up to a power of two number of pages.
+
+    AsyncIoCount - Stores the number of asynchronous I/O requests submitted
+        against the handle that have not yet completed.
+
 --*/
 
 typedef union _FILE_CONTROL_PARAMETERS_UNION {
@@ -1232,6 +1746,8 @@ typedef union _FILE_CONTROL_PARAMETERS_UNION {
     ULONG Flags;
     FILE_PATH FilePath;
     PROCESS_ID Owner;
+    ULONG PipeSize;
+    ULONG AsyncIoCount;
 } FILE_CONTROL_PARAMETERS_UNION, *PFILE_CONTROL_PARAMETERS_UNION;
 
 /*++
@@ -1646,6 +2162,741 @@ typedef struct _SYSTEM_CALL_TIMER_CONTROL {
 
 /*++
 
+Structure Description:
+
+    This structure defines the system call parameters for getting or setting
+    the due time and period of an I/O timer.
+
+Members:
+
+    Handle - Stores the handle to the I/O timer.
+
+    Operation - Stores the operation to perform. Only TimerOperationGetTimer
+        and TimerOperationSetTimer are valid.
+
+    Flags - Stores the returned IO_TIMER_FLAG_* flags the timer was created
+        with.
+
+    TimerInformation - Stores the timer information. For set operations, this
+        supplies the new absolute due time and period, and returns the
+        previous ones. A due time of zero disarms the timer.
+
+--*/
+
+typedef struct _SYSTEM_CALL_IO_TIMER_CONTROL {
+    HANDLE Handle;
+    TIMER_OPERATION Operation;
+    ULONG Flags;
+    TIMER_INFORMATION TimerInformation;
+} SYSCALL_STRUCT SYSTEM_CALL_IO_TIMER_CONTROL, *PSYSTEM_CALL_IO_TIMER_CONTROL;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for transferring data
+    from a file directly to another handle.
+
+Members:
+
+    Destination - Stores the handle to write the data to.
+
+    Source - Stores the handle to the file to read the data from.
+
+    Offset - Stores the offset within the source file to start reading from.
+        Supply -1 to use and update the source's current file position. On
+        return, this contains the offset just past the last byte transferred.
+
+    Size - Stores the number of bytes to transfer.
+
+    TimeoutInMilliseconds - Stores the number of milliseconds that writes to
+        the destination should be waited on before timing out. Use
+        SYS_WAIT_TIME_INDEFINITE to wait forever.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SEND_FILE {
+    HANDLE Destination;
+    HANDLE Source;
+    IO_OFFSET Offset;
+    INTN Size;
+    ULONG TimeoutInMilliseconds;
+} SYSCALL_STRUCT SYSTEM_CALL_SEND_FILE, *PSYSTEM_CALL_SEND_FILE;
+
+/*++
+
+Structure Description:
+
+    This structure defines the result of an asynchronous I/O request. It lives
+    in user mode memory and is written by the kernel when the request
+    completes.
+
+Members:
+
+    Status - Stores the completion status of the request. This holds
+        ASYNC_IO_STATUS_PENDING until the request completes. The kernel writes
+        it last, after the bytes completed value is visible.
+
+    BytesCompleted - Stores the number of bytes transferred by the request.
+
+--*/
+
+typedef struct _ASYNC_IO_RESULT {
+    volatile KSTATUS Status;
+    UINTN BytesCompleted;
+} ASYNC_IO_RESULT, *PASYNC_IO_RESULT;
+
+/*++
+
+Structure Description:
+
+    This structure defines an asynchronous I/O request submitted to an
+    asynchronous I/O context.
+
+Members:
+
+    Handle - Stores the handle to perform the I/O on.
+
+    Operation - Stores the operation to perform.
+
+    SignalNumber - Stores the signal to send to the process when the request
+        completes, or zero to send no signal.
+
+    Offset - Stores the offset to perform the I/O at. Supply -1 to use the
+        handle's current file position.
+
+    Buffer - Stores the user mode buffer to read into or write from. This is
+        ignored for flush requests.
+
+    Size - Stores the number of bytes to transfer.
+
+    SignalValue - Stores the value to send with the completion signal.
+
+    Result - Stores a pointer to the result structure the kernel writes when
+        the request completes.
+
+--*/
+
+typedef struct _ASYNC_IO_REQUEST {
+    HANDLE Handle;
+    ASYNC_IO_OPERATION Operation;
+    ULONG SignalNumber;
+    IO_OFFSET Offset;
+    PVOID Buffer;
+    UINTN Size;
+    UINTN SignalValue;
+    PASYNC_IO_RESULT Result;
+} ASYNC_IO_REQUEST, *PASYNC_IO_REQUEST;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating an
+    asynchronous I/O context, which tracks completions of the asynchronous
+    I/O requests submitted to it.
+
+Members:
+
+    OpenFlags - Stores the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Handle - Stores the returned handle to the asynchronous I/O context.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT {
+    ULONG OpenFlags;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT,
+    *PSYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for submitting a batch
+    of asynchronous I/O requests.
+
+Members:
+
+    Context - Stores the handle to the asynchronous I/O context that tracks
+        the requests.
+
+    Requests - Stores a pointer to the array of requests to submit.
+
+    RequestCount - Stores the number of requests in the array. This can be at
+        most ASYNC_IO_MAX_SUBMIT.
+
+    SignalNumber - Stores the signal to send to the process once every request
+        in the batch has completed, or zero to send no signal.
+
+    SignalValue - Stores the value to send with the batch completion signal.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SUBMIT_ASYNC_IO {
+    HANDLE Context;
+    PASYNC_IO_REQUEST Requests;
+    ULONG RequestCount;
+    ULONG SignalNumber;
+    UINTN SignalValue;
+} SYSCALL_STRUCT SYSTEM_CALL_SUBMIT_ASYNC_IO, *PSYSTEM_CALL_SUBMIT_ASYNC_IO;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for waiting for
+    asynchronous I/O requests to complete.
+
+Members:
+
+    Context - Stores the handle to the asynchronous I/O context.
+
+    Generation - Stores the completion generation the caller last observed.
+        The call returns as soon as the context's generation differs from
+        this value. On return, this holds the current generation. Supply zero
+        to simply query the current generation.
+
+    TimeoutInMilliseconds - Stores the number of milliseconds to wait before
+        giving up.
+
+--*/
+
+typedef struct _SYSTEM_CALL_WAIT_FOR_ASYNC_IO {
+    HANDLE Context;
+    ULONGLONG Generation;
+    ULONG TimeoutInMilliseconds;
+} SYSCALL_STRUCT SYSTEM_CALL_WAIT_FOR_ASYNC_IO,
+    *PSYSTEM_CALL_WAIT_FOR_ASYNC_IO;
+
+/*++
+
+Structure Description:
+
+    This structure defines the header of the memory shared between user mode
+    and the kernel for an I/O ring. Indices are free running; the entry an
+    index refers to is found by masking it with the ring's mask.
+
+Members:
+
+    SubmissionHead - Stores the index of the next submission the kernel will
+        consume. Only the kernel writes this.
+
+    SubmissionTail - Stores the index one beyond the last submission user
+        mode has filled in. Only user mode writes this, after the entry is
+        visible.
+
+    SubmissionMask - Stores the number of submission entries minus one.
+
+    CompletionHead - Stores the index of the next completion user mode will
+        consume. Only user mode writes this.
+
+    CompletionTail - Stores the index one beyond the last completion the
+        kernel has posted. Only the kernel writes this, after the entry is
+        visible.
+
+    CompletionMask - Stores the number of completion entries minus one.
+
+    Flags - Stores a bitmask of IO_RING_STATE_* flags set by the kernel.
+
+    Dropped - Stores the number of completions the kernel discarded because
+        the completion ring was full. The kernel does not consume submissions
+        it cannot guarantee room for, so this only counts if user mode moves
+        the completion head incorrectly.
+
+    Reserved - Stores padding that keeps the entries cache line aligned.
+
+--*/
+
+typedef struct _IO_RING_HEADER {
+    volatile ULONG SubmissionHead;
+    volatile ULONG SubmissionTail;
+    ULONG SubmissionMask;
+    volatile ULONG CompletionHead;
+    volatile ULONG CompletionTail;
+    ULONG CompletionMask;
+    volatile ULONG Flags;
+    volatile ULONG Dropped;
+    ULONG Reserved[8];
+} IO_RING_HEADER, *PIO_RING_HEADER;
+
+/*++
+
+Structure Description:
+
+    This structure defines an operation submitted to an I/O ring.
+
+Members:
+
+    Operation - Stores the operation to perform.
+
+    Flags - Stores a bitmask of IO_RING_SUBMISSION_FLAG_* flags.
+
+    Handle - Stores the handle to operate on, or the index of a registered
+        handle.
+
+    OperationFlags - Stores flags specific to the operation. For poll
+        operations, this is the mask of POLL_EVENT_* flags to wait for. For
+        send and receive operations, this is a mask of SOCKET_IO_* flags. For
+        accept operations, this is a mask of SYS_OPEN_FLAG_NON_BLOCKING and
+        SYS_OPEN_FLAG_CLOSE_ON_EXECUTE for the new handle.
+
+    Offset - Stores the file offset for read and write operations. Supply -1
+        to use and update the handle's current file position.
+
+    Buffer - Stores the buffer for read, write, send, and receive operations,
+        or the byte offset into the registered buffer region. For vectored
+        reads, this is a pointer to an array of I/O vectors.
+
+    Size - Stores the number of bytes to transfer, or the number of elements
+        in the I/O vector array.
+
+    UserData - Stores an opaque value returned in the completion.
+
+--*/
+
+typedef struct _IO_RING_SUBMISSION {
+    IO_RING_OPERATION Operation;
+    ULONG Flags;
+    HANDLE Handle;
+    ULONG OperationFlags;
+    IO_OFFSET Offset;
+    PVOID Buffer;
+    UINTN Size;
+    ULONGLONG UserData;
+} IO_RING_SUBMISSION, *PIO_RING_SUBMISSION;
+
+/*++
+
+Structure Description:
+
+    This structure defines the completion of an operation submitted to an I/O
+    ring.
+
+Members:
+
+    UserData - Stores the user data value from the submission.
+
+    Status - Stores the final status of the operation.
+
+    Result - Stores the result of the operation. For transfers, this is the
+        number of bytes completed. For poll operations, this is the mask of
+        POLL_EVENT_* flags that were signaled. For accept operations, this is
+        the new handle.
+
+--*/
+
+typedef struct _IO_RING_COMPLETION {
+    ULONGLONG UserData;
+    KSTATUS Status;
+    UINTN Result;
+} IO_RING_COMPLETION, *PIO_RING_COMPLETION;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating an I/O
+    ring.
+
+Members:
+
+    OpenFlags - Stores the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Stores a bitmask of IO_RING_FLAG_* flags.
+
+    SubmissionCount - Stores the number of submission entries. This must be a
+        power of two no larger than IO_RING_MAX_ENTRIES.
+
+    CompletionCount - Stores the number of completion entries. This must be a
+        power of two no smaller than the submission count and no larger than
+        twice IO_RING_MAX_ENTRIES.
+
+    Ring - Stores a pointer to the page aligned memory holding the ring,
+        which must be a shared mapping so that it stays coherent across fork.
+        The kernel initializes the header.
+
+    RingSize - Stores the size of the ring memory in bytes. This must be at
+        least IO_RING_SIZE of the two entry counts.
+
+    BufferRegion - Stores an optional pointer to a region of memory to
+        register with the ring. Submissions can refer to buffers within the
+        region by offset, which avoids mapping them on every operation and
+        allows the kernel polling thread to reach them.
+
+    BufferRegionSize - Stores the size of the registered buffer region in
+        bytes.
+
+    Handles - Stores an optional pointer to an array of handles to register
+        with the ring. Submissions can refer to these by index.
+
+    HandleCount - Stores the number of elements in the handle array.
+
+    Handle - Stores the returned handle to the ring.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_IO_RING {
+    ULONG OpenFlags;
+    ULONG Flags;
+    ULONG SubmissionCount;
+    ULONG CompletionCount;
+    PVOID Ring;
+    UINTN RingSize;
+    PVOID BufferRegion;
+    UINTN BufferRegionSize;
+    PHANDLE Handles;
+    ULONG HandleCount;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_IO_RING, *PSYSTEM_CALL_CREATE_IO_RING;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for submitting I/O from
+    a ring and waiting for completions.
+
+Members:
+
+    Ring - Stores the handle to the I/O ring.
+
+    SubmitCount - Stores the maximum number of submissions to consume. This is
+        ignored for rings with a kernel polling thread.
+
+    WaitCount - Stores the number of completions that must be available in
+        the completion ring before the call returns.
+
+    Flags - Stores a bitmask of IO_RING_ENTER_FLAG_* flags.
+
+    TimeoutInMilliseconds - Stores the number of milliseconds to wait for
+        completions.
+
+--*/
+
+typedef struct _SYSTEM_CALL_ENTER_IO_RING {
+    HANDLE Ring;
+    ULONG SubmitCount;
+    ULONG WaitCount;
+    ULONG Flags;
+    ULONG TimeoutInMilliseconds;
+} SYSCALL_STRUCT SYSTEM_CALL_ENTER_IO_RING, *PSYSTEM_CALL_ENTER_IO_RING;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for moving data between
+    two handles, at least one of which is a pipe, without copying it through
+    user mode.
+
+Members:
+
+    Input - Stores the handle to read the data from.
+
+    InputOffset - Stores the offset within the input to start reading from.
+        Supply -1 to use and update the input's current file position. This
+        must be -1 if the input is a pipe. On return, this contains the offset
+        just past the last byte moved.
+
+    Output - Stores the handle to write the data to.
+
+    OutputOffset - Stores the offset within the output to start writing to.
+        Supply -1 to use and update the output's current file position. This
+        must be -1 if the output is a pipe. On return, this contains the
+        offset just past the last byte moved.
+
+    Size - Stores the maximum number of bytes to move.
+
+    Flags - Stores a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SPLICE {
+    HANDLE Input;
+    IO_OFFSET InputOffset;
+    HANDLE Output;
+    IO_OFFSET OutputOffset;
+    INTN Size;
+    ULONG Flags;
+} SYSCALL_STRUCT SYSTEM_CALL_SPLICE, *PSYSTEM_CALL_SPLICE;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for placing user mode
+    memory into a pipe without copying it.
+
+Members:
+
+    Handle - Stores the handle to the write side of the pipe.
+
+    VectorArray - Stores a pointer to an array of I/O vector structures which
+        describe the memory to place in the pipe. The memory must not be
+        modified until it has been read out of the pipe.
+
+    VectorCount - Stores the number of elements in the vector array.
+
+    Flags - Stores a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SPLICE_MEMORY {
+    HANDLE Handle;
+    PIO_VECTOR VectorArray;
+    UINTN VectorCount;
+    ULONG Flags;
+} SYSCALL_STRUCT SYSTEM_CALL_SPLICE_MEMORY, *PSYSTEM_CALL_SPLICE_MEMORY;
+
+/*++
+
+Structure Description:
+
+    This structure defines a single message in a batched socket I/O request.
+
+Members:
+
+    Parameters - Stores the socket I/O parameters for the message. On return,
+        the bytes completed, socket I/O flags, remote path size, and control
+        data size are updated as they would be for a single request.
+
+    VectorArray - Stores a pointer to an array of I/O vectors describing the
+        message data.
+
+    VectorCount - Stores the number of elements in the vector array.
+
+--*/
+
+typedef struct _SOCKET_IO_MESSAGE {
+    SOCKET_IO_PARAMETERS Parameters;
+    PIO_VECTOR VectorArray;
+    UINTN VectorCount;
+} SYSCALL_STRUCT SOCKET_IO_MESSAGE, *PSOCKET_IO_MESSAGE;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for sending or receiving
+    several socket messages with a single system call.
+
+Members:
+
+    Socket - Stores the socket to use.
+
+    Messages - Stores a pointer to the array of messages. Each message's
+        parameters say whether it is sent or received.
+
+    MessageCount - Stores the number of messages in the array.
+
+    Flags - Stores a bitfield of flags. See SYS_SOCKET_BATCH_FLAG_*
+        definitions.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO {
+    HANDLE Socket;
+    PSOCKET_IO_MESSAGE Messages;
+    UINTN MessageCount;
+    ULONG Flags;
+} SYSCALL_STRUCT SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO,
+    *PSYSTEM_CALL_SOCKET_PERFORM_BATCH_IO;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for getting or setting
+    the I/O priority of a process or thread.
+
+Members:
+
+    Request - Stores whether the priority of a process or a thread is
+        requested.
+
+    Id - Stores the process or thread ID. Supply -1 to use the current
+        process or thread. Threads must belong to the current process.
+
+    Set - Stores a boolean indicating whether to get the I/O priority (FALSE)
+        or set it (TRUE).
+
+    Priority - Stores the new I/O priority to set for set operations on input.
+        Returns the previous I/O priority. See IO_PRIORITY_* definitions.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SET_IO_PRIORITY {
+    IO_PRIORITY_REQUEST Request;
+    PROCESS_ID Id;
+    BOOL Set;
+    ULONG Priority;
+} SYSCALL_STRUCT SYSTEM_CALL_SET_IO_PRIORITY, *PSYSTEM_CALL_SET_IO_PRIORITY;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for copying a range of
+    one file into another within the kernel.
+
+Members:
+
+    Destination - Stores the handle to the file to write the data to.
+
+    DestinationOffset - Stores the offset within the destination to start
+        writing to. Supply -1 to use and update the destination's current file
+        position. On return, this contains the offset just past the last byte
+        copied.
+
+    Source - Stores the handle to the file to read the data from.
+
+    SourceOffset - Stores the offset within the source to start reading from.
+        Supply -1 to use and update the source's current file position. On
+        return, this contains the offset just past the last byte copied.
+
+    Size - Stores the number of bytes to copy.
+
+    Flags - Stores a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+--*/
+
+typedef struct _SYSTEM_CALL_COPY_FILE_RANGE {
+    HANDLE Destination;
+    IO_OFFSET DestinationOffset;
+    HANDLE Source;
+    IO_OFFSET SourceOffset;
+    INTN Size;
+    ULONG Flags;
+} SYSCALL_STRUCT SYSTEM_CALL_COPY_FILE_RANGE, *PSYSTEM_CALL_COPY_FILE_RANGE;
+
+/*++
+
+Structure Description:
+
+    This structure defines an event record read from a file watch handle. The
+    name follows the fixed portion of the record.
+
+Members:
+
+    Descriptor - Stores the descriptor of the watch that generated the event,
+        as returned when the watch was added.
+
+    Events - Stores the mask of events that occurred. See FILE_WATCH_EVENT_*
+        definitions.
+
+    Cookie - Stores a value shared by the two halves of a rename, or zero.
+
+    NameSize - Stores the size of the name in bytes, including the null
+        terminator and any padding needed to align the next record. This is
+        zero if the event is about the watched file itself.
+
+    Name - Stores the null terminated name of the directory entry the event
+        describes.
+
+--*/
+
+typedef struct _FILE_WATCH_EVENT {
+    LONG Descriptor;
+    ULONG Events;
+    ULONG Cookie;
+    ULONG NameSize;
+    CHAR Name[ANYSIZE_ARRAY];
+} FILE_WATCH_EVENT, *PFILE_WATCH_EVENT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating a file
+    watch object, which reports changes to files and directories as a stream
+    of FILE_WATCH_EVENT records.
+
+Members:
+
+    OpenFlags - Stores the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Handle - Stores the returned handle to the file watch.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_FILE_WATCH {
+    ULONG OpenFlags;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_FILE_WATCH,
+    *PSYSTEM_CALL_CREATE_FILE_WATCH;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for adding a file or
+    directory to a file watch.
+
+Members:
+
+    Handle - Stores the handle to the file watch.
+
+    Directory - Stores an optional handle to the directory to start path
+        traversal from if the specified path is relative. Supply INVALID_HANDLE
+        here to use the current directory for relative paths.
+
+    Path - Stores a pointer to the path of the file or directory to watch.
+
+    PathSize - Stores the size of the path buffer in bytes including the null
+        terminator.
+
+    Events - Stores the mask of events to report. See FILE_WATCH_EVENT_*
+        definitions.
+
+    Flags - Stores a bitfield of flags. See FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Stores the returned watch descriptor. Adding the same file to
+        a watch twice returns the same descriptor.
+
+--*/
+
+typedef struct _SYSTEM_CALL_ADD_FILE_WATCH {
+    HANDLE Handle;
+    HANDLE Directory;
+    PCSTR Path;
+    ULONG PathSize;
+    ULONG Events;
+    ULONG Flags;
+    LONG Descriptor;
+} SYSCALL_STRUCT SYSTEM_CALL_ADD_FILE_WATCH, *PSYSTEM_CALL_ADD_FILE_WATCH;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for removing a file or
+    directory from a file watch.
+
+Members:
+
+    Handle - Stores the handle to the file watch.
+
+    Descriptor - Stores the descriptor returned when the watch was added.
+
+--*/
+
+typedef struct _SYSTEM_CALL_REMOVE_FILE_WATCH {
+    HANDLE Handle;
+    LONG Descriptor;
+} SYSCALL_STRUCT SYSTEM_CALL_REMOVE_FILE_WATCH,
+    *PSYSTEM_CALL_REMOVE_FILE_WATCH;
+
+/*++
+
 Structure Description:
 
     This structure defines the system call parameters for getting the
@@ -2608,6 +3859,26 @@ typedef union _SYSTEM_CALL_PARAMETER_UNION {
     SYSTEM_CALL_SET_ITIMER SetITimer;
     SYSTEM_CALL_SET_RESOURCE_LIMIT SetResourceLimit;
     SYSTEM_CALL_SET_BREAK SetBreak;
+    SYSTEM_CALL_CREATE_EVENT_POLL CreateEventPoll;
+    SYSTEM_CALL_EVENT_POLL_CONTROL EventPollControl;
+    SYSTEM_CALL_EVENT_POLL_WAIT EventPollWait;
+    SYSTEM_CALL_CREATE_EVENT_COUNTER CreateEventCounter;
+    SYSTEM_CALL_CREATE_IO_TIMER CreateIoTimer;
+    SYSTEM_CALL_IO_TIMER_CONTROL IoTimerControl;
+    SYSTEM_CALL_SEND_FILE SendFile;
+    SYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT CreateAsyncIoContext;
+    SYSTEM_CALL_SUBMIT_ASYNC_IO SubmitAsyncIo;
+    SYSTEM_CALL_WAIT_FOR_ASYNC_IO WaitForAsyncIo;
+    SYSTEM_CALL_CREATE_IO_RING CreateIoRing;
+    SYSTEM_CALL_ENTER_IO_RING EnterIoRing;
+    SYSTEM_CALL_SPLICE Splice;
+    SYSTEM_CALL_SPLICE_MEMORY SpliceMemory;
+    SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO SocketPerformBatchIo;
+    SYSTEM_CALL_SET_IO_PRIORITY SetIoPriority;
+    SYSTEM_CALL_COPY_FILE_RANGE CopyFileRange;
+    SYSTEM_CALL_CREATE_FILE_WATCH CreateFileWatch;
+    SYSTEM_CALL_ADD_FILE_WATCH AddFileWatch;
+    SYSTEM_CALL_REMOVE_FILE_WATCH RemoveFileWatch;
 } SYSCALL_STRUCT SYSTEM_CALL_PARAMETER_UNION, *PSYSTEM_CALL_PARAMETER_UNION;
 
 typedef
@@ -434,6 +434,7 @@ FatEnumerateDirectory (
     UINTN BytesToRead,
     BOOL ReadSingleEntry,
     BOOL IncludeDotDirectories,
+    ULONG IoFlags,
     PVOID Irp,
     PUINTN BytesRead,
     PULONG ElementsRead
@@ -465,7 +466,8 @@ Routine Description:
         dot directories should be returned as well.
 
     IoFlags - Supplies flags regarding the I/O operation. See IO_FLAG_*
-        definitions.
+        definitions. If IO_FLAG_DIRECTORY_PROPERTIES is set, each entry
+        carries its file properties.
 
     Irp - Supplies an optional pointer to an IRP to use for transfers.
 
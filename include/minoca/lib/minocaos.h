@@ -259,6 +259,41 @@ typedef struct _OS_LIBRARY_SYMBOL {
     PVOID SymbolAddress;
 } OS_LIBRARY_SYMBOL, *POS_LIBRARY_SYMBOL;
 
+/*++
+
+Structure Description:
+
+    This structure describes an I/O ring from user mode's point of view.
+
+Members:
+
+    Handle - Stores the handle to the ring.
+
+    Header - Stores a pointer to the shared ring header.
+
+    Submissions - Stores a pointer to the shared submission entries.
+
+    Completions - Stores a pointer to the shared completion entries.
+
+    Size - Stores the size of the shared ring memory in bytes.
+
+    Flags - Stores the IO_RING_FLAG_* flags the ring was created with.
+
+    SubmissionTail - Stores the index one beyond the last submission handed
+        out, which is published to the kernel on the next submit.
+
+--*/
+
+typedef struct _OS_IO_RING {
+    HANDLE Handle;
+    PIO_RING_HEADER Header;
+    PIO_RING_SUBMISSION Submissions;
+    PIO_RING_COMPLETION Completions;
+    UINTN Size;
+    ULONG Flags;
+    ULONG SubmissionTail;
+} OS_IO_RING, *POS_IO_RING;
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -565,15 +600,823 @@ Routine Description:
         descriptors. Only SYS_OPEN_FLAG_CLOSE_ON_EXECUTE and
         SYS_OPEN_FLAG_NON_BLOCKING are permitted.
 
-    Permissions - Supplies the initial permissions to set on the pipe.
+    Permissions - Supplies the initial permissions to set on the pipe.
+
+    ReadHandle - Supplies a pointer where the handle to the read end of the
+        pipe will be returned on success. Handles are only returned if a
+        NULL path was passed in.
+
+    WriteHandle - Supplies a pointer where the handle to the write end of the
+        pipe will be returned on success. Handles are only returned in a NULL
+        path was passed in.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+VOID
+OsExitThread (
+    PVOID UnmapAddress,
+    UINTN UnmapSize
+    );
+
+/*++
+
+Routine Description:
+
+    This routine terminates the current thread, and optionally attempts to
+    unmap a region of memory on its way out. Usually this is the stack of the
+    thread that is exiting.
+
+Arguments:
+
+    UnmapAddress - Supplies an optional pointer to a region of memory to unmap
+        as the thread exits. Supply NULL to skip unmapping.
+
+    UnmapSize - Supplies the size of the region to unmap in bytes. This must be
+        aligned to the page size. If it is not, the unmap simply won't happen.
+        Supply 0 to skip the unmap and just exit the thread. If -1 is supplied,
+        this routine returns. This value can be used to warm up the PLT entry,
+        since lazy binding cannot take place after the thread's control block
+        has been destroyed.
+
+Return Value:
+
+    This routine does not return, unless the magic size is passed in.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateThread (
+    PSTR ThreadName,
+    ULONG ThreadNameBufferLength,
+    PTHREAD_ENTRY_ROUTINE ThreadRoutine,
+    PVOID Parameter,
+    PVOID StackBase,
+    ULONG StackSize,
+    PVOID ThreadPointer,
+    PTHREAD_ID ThreadId
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new thread.
+
+Arguments:
+
+    ThreadName - Supplies an optional pointer to the thread name.
+
+    ThreadNameBufferLength - Supplies the size of the thread name buffer,
+        including the null terminator.
+
+    ThreadRoutine - Supplies a pointer to the funtion that should be run on the
+        new thread.
+
+    Parameter - Supplies a pointer that will be passed directly to the thread
+        routine.
+
+    StackBase - Supplies an optional pointer to the stack base address. If
+        supplied, the kernel will not add a guard region or automatically
+        expand the stack.
+
+    StackSize - Supplies the size of the new thread's stack. Supply 0 to use
+        the system default.
+
+    ThreadPointer - Supplies the thread pointer to set for the new thread.
+
+    ThreadId - Supplies an optional pointer where the ID of the new thread will
+        be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsForkProcess (
+    PPROCESS_ID NewProcessId
+    );
+
+/*++
+
+Routine Description:
+
+    This routine forks the current process into two separate processes. The
+    child process begins executing in the middle of this function.
+
+Arguments:
+
+    NewProcessId - Supplies a pointer that on success contains the process ID
+        of the child process in the parent, and 0 in the child. This value
+        contains -1 if the new process failed to spawn.
+
+Return Value:
+
+    STATUS_SUCCESS in both the parent and child on success.
+
+    Other status codes are returned to the parent if the child failed to spawn.
+
+--*/
+
+OS_API
+KSTATUS
+OsExecuteImage (
+    PPROCESS_ENVIRONMENT Environment
+    );
+
+/*++
+
+Routine Description:
+
+    This routine replaces the currently running process with the given binary
+    image.
+
+Arguments:
+
+    Environment - Supplies a pointer to the environment to execute, which
+        includes the image name, parameters, and environment variables.
+
+Return Value:
+
+    If this routine succeeds, it will not return, as the process will be
+    replaced with the new executable. If the process could not be started,
+    a failing status code will be returned to the caller.
+
+--*/
+
+OS_API
+KSTATUS
+OsGetSystemVersion (
+    PSYSTEM_VERSION_INFORMATION VersionInformation,
+    BOOL WantStrings
+    );
+
+/*++
+
+Routine Description:
+
+    This routine gets the system version information.
+
+Arguments:
+
+    VersionInformation - Supplies a pointer where the system version
+        information will be returned. The caller should not attempt to modify
+        or free the strings pointed to by members of this structure.
+
+    WantStrings - Supplies a boolean indicating if the build strings are
+        desired or just the major/minor version information.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsGetCurrentDirectory (
+    BOOL Root,
+    PSTR *Buffer,
+    PUINTN BufferSize
+    );
+
+/*++
+
+Routine Description:
+
+    This routine retrieves a pointer to a null terminated string containing the
+    path to the current working directory or the current root directory.
+
+Arguments:
+
+    Root - Supplies a boolean indicating whether caller would like the current
+        working directory (FALSE) or the path to the current root directory
+        (TRUE). If the caller does not have permission to escape roots, or
+        does not currently have an altered root directory, then / is returned.
+
+    Buffer - Supplies a pointer that receives a pointer to a buffer that
+        contains a null terminated string for the path to the current
+        directory.
+
+    BufferSize - Supplies a pointer that receives the size of the buffer, in
+        bytes.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsChangeDirectory (
+    BOOL Root,
+    PSTR Path,
+    ULONG PathSize
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets the current working directory or current root directory.
+
+Arguments:
+
+    Root - Supplies a boolean indicating whether to change the current working
+        directory (FALSE) or the current root directory (TRUE). If attempting
+        to change the root, the caller must have permission to change the root,
+        must be running a single thread, and must not have any other handles
+        to directories open.
+
+    Path - Supplies a pointer to the path of the new working directory. If
+        trying to escape the root, supply NULL here. The caller must have
+        sufficient privileges to escape a root.
+
+    PathSize - Supplies the size of the path directory string in bytes
+        including the null terminator.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsChangeDirectoryHandle (
+    BOOL Root,
+    HANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets the current working directory or root directory to the
+    same directory opened with the given file handle.
+
+Arguments:
+
+    Root - Supplies a boolean indicating whether to change the current working
+        directory (FALSE) or the current root directory (TRUE). If attempting
+        to change the root, the caller must have permission to change the root,
+        must be running a single thread, and must not have any other handles
+        to directories open.
+
+    Handle - Supplies an open handle to a directory to change the current
+        working directroy to. Supply INVALID_HANDLE here to escape the root.
+        The caller must have sufficient privileges to escape a root.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsPoll (
+    PSIGNAL_SET SignalMask,
+    PPOLL_DESCRIPTOR Descriptors,
+    ULONG DescriptorCount,
+    ULONG TimeoutInMilliseconds,
+    PULONG DescriptorsSelected
+    );
+
+/*++
+
+Routine Description:
+
+    This routine polls several I/O handles.
+
+Arguments:
+
+    SignalMask - Supplies an optional pointer to a mask to set for the
+        duration of the wait.
+
+    Descriptors - Supplies a pointer to an array of poll descriptor structures
+        describing the descriptors and events to wait on.
+
+    DescriptorCount - Supplies the number of descriptors in the array.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait before
+        giving up.
+
+    DescriptorsSelected - Supplies a pointer where the number of descriptors
+        that had activity will be returned on success.
+
+Return Value:
+
+    STATUS_SUCCESS if one or more descriptors is ready for action.
+
+    STATUS_INSUFFICIENT_RESOURCES if memory could not be allocated for the
+        operation.
+
+    STATUS_INTERRUPTED if a signal was caught during the wait.
+
+    STATUS_TIMEOUT if no descriptors were ready in the given amount of time.
+
+    STATUS_INVALID_PARAMETER if more than MAX_LONG descriptors are supplied.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateEventPoll (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event poll object, which waits on a persistent
+    set of I/O handles.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_CLOSE_ON_EXECUTE is permitted.
+
+    Handle - Supplies a pointer where the handle to the new event poll object
+        will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsEventPollControl (
+    HANDLE EventPoll,
+    EVENT_POLL_OPERATION Operation,
+    HANDLE Handle,
+    PEVENT_POLL_EVENT Event
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds, modifies, or removes a handle from the set of handles
+    watched by an event poll object.
+
+Arguments:
+
+    EventPoll - Supplies the handle to the event poll object.
+
+    Operation - Supplies the operation to perform.
+
+    Handle - Supplies the handle to add, modify, or remove.
+
+    Event - Supplies an optional pointer to the events and data to register.
+        This is required for add and modify operations.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_FILE_EXISTS if the handle is already being watched on add.
+
+    STATUS_NOT_FOUND if the handle is not being watched on modify or delete.
+
+    STATUS_PERMISSION_DENIED if the handle does not support polling.
+
+    Other error codes on failure.
+
+--*/
+
+OS_API
+KSTATUS
+OsEventPollWait (
+    HANDLE EventPoll,
+    PSIGNAL_SET SignalMask,
+    PEVENT_POLL_EVENT Events,
+    ULONG EventCount,
+    ULONG TimeoutInMilliseconds,
+    PULONG EventsReturned
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits for handles watched by an event poll object to become
+    ready.
+
+Arguments:
+
+    EventPoll - Supplies the handle to the event poll object.
+
+    SignalMask - Supplies an optional pointer to a mask to set for the
+        duration of the wait.
+
+    Events - Supplies a pointer to an array where the ready events will be
+        returned.
+
+    EventCount - Supplies the number of elements in the events array.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait before
+        giving up.
+
+    EventsReturned - Supplies a pointer where the number of events returned
+        will be stored on success.
+
+Return Value:
+
+    STATUS_SUCCESS if one or more handles is ready.
+
+    STATUS_INTERRUPTED if a signal was caught during the wait.
+
+    STATUS_TIMEOUT if no handles were ready in the given amount of time.
+
+    STATUS_INVALID_PARAMETER if more than MAX_LONG events are supplied.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateEventCounter (
+    ULONG OpenFlags,
+    ULONG Flags,
+    ULONG InitialValue,
+    PHANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event counter object, a 64-bit counter that
+    can be read, written, and waited on through a handle.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Supplies a bitfield of flags governing the behavior of the
+        counter. See EVENT_COUNTER_FLAG_* definitions.
+
+    InitialValue - Supplies the initial value of the counter.
+
+    Handle - Supplies a pointer where the handle to the new event counter
+        will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateIoTimer (
+    ULONG OpenFlags,
+    ULONG Flags,
+    PHANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O timer object, a timer whose expirations
+    are read from a handle rather than delivered as signals.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Flags - Supplies a bitfield of flags for the timer. See IO_TIMER_FLAG_*
+        definitions.
+
+    Handle - Supplies a pointer where the handle to the new I/O timer will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsIoTimerControl (
+    HANDLE Handle,
+    TIMER_OPERATION Operation,
+    PTIMER_INFORMATION Information,
+    PULONG Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the due time and period of an I/O timer.
+
+Arguments:
+
+    Handle - Supplies the handle to the I/O timer.
+
+    Operation - Supplies the operation to perform. Only TimerOperationGetTimer
+        and TimerOperationSetTimer are valid.
+
+    Information - Supplies a pointer to the timer information. For set
+        operations, this supplies the new absolute due time and period in time
+        counter ticks. A due time of zero disarms the timer. On success, this
+        returns the previous due time and period.
+
+    Flags - Supplies an optional pointer where the IO_TIMER_FLAG_* flags the
+        timer was created with will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsSendFile (
+    HANDLE Destination,
+    HANDLE Source,
+    PIO_OFFSET Offset,
+    UINTN Size,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesCompleted
+    );
+
+/*++
+
+Routine Description:
+
+    This routine transfers data from a file directly to another handle, such
+    as a socket, without copying it through a user mode buffer.
+
+Arguments:
+
+    Destination - Supplies the handle to write the data to.
+
+    Source - Supplies the handle to the file to read the data from.
+
+    Offset - Supplies an optional pointer to the offset within the source file
+        to start reading from. On return, this will be updated to the offset
+        just past the last byte transferred. If this is NULL, the source's
+        current file position is used and updated.
+
+    Size - Supplies the number of bytes to transfer.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that writes to
+        the destination should be waited on before timing out. Use
+        SYS_WAIT_TIME_INDEFINITE to wait forever.
+
+    BytesCompleted - Supplies a pointer where the number of bytes transferred
+        will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsCopyFileRange (
+    HANDLE Destination,
+    PIO_OFFSET DestinationOffset,
+    HANDLE Source,
+    PIO_OFFSET SourceOffset,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesCopied
+    );
+
+/*++
+
+Routine Description:
+
+    This routine copies a range of one file into another within the kernel,
+    without copying it through a user mode buffer. Both handles must refer to
+    regular files.
+
+Arguments:
+
+    Destination - Supplies the handle to the file to write to.
+
+    DestinationOffset - Supplies an optional pointer to the offset within the
+        destination to write to. On return, this will be advanced past the
+        bytes copied. If this is NULL, the destination's current file position
+        is used and updated.
+
+    Source - Supplies the handle to the file to read from.
+
+    SourceOffset - Supplies an optional pointer to the offset within the
+        source to read from. On return, this will be advanced past the bytes
+        copied. If this is NULL, the source's current file position is used and
+        updated.
+
+    Size - Supplies the number of bytes to copy.
+
+    Flags - Supplies a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+    BytesCopied - Supplies a pointer where the number of bytes copied will be
+        returned. This is zero at the end of the source file.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateFileWatch (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch, which reports changes to the files
+    and directories added to it. Reading the watch's handle returns
+    FILE_WATCH_EVENT records.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Handle - Supplies a pointer where the handle to the new file watch will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsAddFileWatch (
+    HANDLE Handle,
+    HANDLE Directory,
+    PCSTR Path,
+    ULONG PathSize,
+    ULONG Events,
+    ULONG Flags,
+    PLONG Descriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a file or directory to a file watch. If the watch is
+    already watching the given file, the events reported for it are updated
+    instead.
+
+Arguments:
+
+    Handle - Supplies the handle to the file watch.
+
+    Directory - Supplies an optional handle to a directory to start the path
+        search from if the supplied path is relative. Supply INVALID_HANDLE
+        here to use the current directory for relative paths.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    PathSize - Supplies the size of the path buffer in bytes, including the
+        null terminator.
+
+    Events - Supplies the mask of events to report. See FILE_WATCH_EVENT_*
+        definitions.
+
+    Flags - Supplies a bitfield of flags. See FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Supplies a pointer where the descriptor identifying the file
+        in event records will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsRemoveFileWatch (
+    HANDLE Handle,
+    LONG Descriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes a file or directory from a file watch. A final
+    record with the FILE_WATCH_EVENT_IGNORED bit set is queued for the
+    descriptor.
+
+Arguments:
+
+    Handle - Supplies the handle to the file watch.
+
+    Descriptor - Supplies the descriptor returned when the file was added.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateAsyncIoContext (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new asynchronous I/O context, which asynchronous
+    I/O requests are submitted to. Reading the context returns the number of
+    requests completed since it was last read.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
+
+    Handle - Supplies a pointer where the handle to the new context will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsSubmitAsyncIo (
+    HANDLE Context,
+    PASYNC_IO_REQUEST Requests,
+    ULONG RequestCount,
+    ULONG SignalNumber,
+    UINTN SignalValue,
+    PULONG SubmittedCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine submits a batch of asynchronous I/O requests. Each request's
+    result structure is filled in when it completes, with the byte count
+    written before the status.
+
+Arguments:
+
+    Context - Supplies the handle to the asynchronous I/O context.
+
+    Requests - Supplies an array of requests to submit.
 
-    ReadHandle - Supplies a pointer where the handle to the read end of the
-        pipe will be returned on success. Handles are only returned if a
-        NULL path was passed in.
+    RequestCount - Supplies the number of elements in the array. This can be
+        at most ASYNC_IO_MAX_SUBMIT.
 
-    WriteHandle - Supplies a pointer where the handle to the write end of the
-        pipe will be returned on success. Handles are only returned in a NULL
-        path was passed in.
+    SignalNumber - Supplies an optional signal number to send to the process
+        once every request in the batch has completed. Supply zero to send no
+        signal for the batch.
+
+    SignalValue - Supplies the value to send with the batch signal.
+
+    SubmittedCount - Supplies a pointer where the number of requests
+        submitted will be returned. Requests are submitted in order, so if
+        this is less than the request count, the request at this index and
+        all those after it were not submitted.
 
 Return Value:
 
@@ -582,81 +1425,94 @@ Return Value:
 --*/
 
 OS_API
-VOID
-OsExitThread (
-    PVOID UnmapAddress,
-    UINTN UnmapSize
+KSTATUS
+OsWaitForAsyncIo (
+    HANDLE Context,
+    PULONGLONG Generation,
+    ULONG TimeoutInMilliseconds
     );
 
 /*++
 
 Routine Description:
 
-    This routine terminates the current thread, and optionally attempts to
-    unmap a region of memory on its way out. Usually this is the stack of the
-    thread that is exiting.
+    This routine waits for any request submitted to an asynchronous I/O
+    context to complete. The context keeps a generation number that advances
+    every time a request completes. Callers snap the generation, check their
+    results, and then wait for the generation to move past the snapped value.
 
 Arguments:
 
-    UnmapAddress - Supplies an optional pointer to a region of memory to unmap
-        as the thread exits. Supply NULL to skip unmapping.
+    Context - Supplies the handle to the asynchronous I/O context.
 
-    UnmapSize - Supplies the size of the region to unmap in bytes. This must be
-        aligned to the page size. If it is not, the unmap simply won't happen.
-        Supply 0 to skip the unmap and just exit the thread. If -1 is supplied,
-        this routine returns. This value can be used to warm up the PLT entry,
-        since lazy binding cannot take place after the thread's control block
-        has been destroyed.
+    Generation - Supplies a pointer that on input contains the generation
+        number last seen by the caller. Supply zero to simply query the
+        current generation. On output, returns the current generation.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait for
+        the generation to change. Use SYS_WAIT_TIME_INDEFINITE to wait
+        forever.
 
 Return Value:
 
-    This routine does not return, unless the magic size is passed in.
+    STATUS_SUCCESS if the generation differs from the one supplied.
+
+    STATUS_TIMEOUT if the generation did not change before the timeout
+    expired.
+
+    STATUS_INTERRUPTED if a signal arrived during the wait.
+
+    Other error codes on failure.
 
 --*/
 
 OS_API
 KSTATUS
-OsCreateThread (
-    PSTR ThreadName,
-    ULONG ThreadNameBufferLength,
-    PTHREAD_ENTRY_ROUTINE ThreadRoutine,
-    PVOID Parameter,
-    PVOID StackBase,
-    ULONG StackSize,
-    PVOID ThreadPointer,
-    PTHREAD_ID ThreadId
+OsCreateIoRing (
+    ULONG OpenFlags,
+    ULONG Flags,
+    ULONG SubmissionCount,
+    ULONG CompletionCount,
+    PVOID BufferRegion,
+    UINTN BufferRegionSize,
+    PHANDLE Handles,
+    ULONG HandleCount,
+    POS_IO_RING Ring
     );
 
 /*++
 
 Routine Description:
 
-    This routine creates a new thread.
+    This routine creates an I/O ring: a submission queue and a completion
+    queue in memory shared with the kernel, so that many I/O operations can
+    be issued and reaped with a single system call.
 
 Arguments:
 
-    ThreadName - Supplies an optional pointer to the thread name.
+    OpenFlags - Supplies the open flags for the new handle. Only
+        SYS_OPEN_FLAG_NON_BLOCKING and SYS_OPEN_FLAG_CLOSE_ON_EXECUTE are
+        permitted.
 
-    ThreadNameBufferLength - Supplies the size of the thread name buffer,
-        including the null terminator.
+    Flags - Supplies a bitmask of IO_RING_FLAG_* flags.
 
-    ThreadRoutine - Supplies a pointer to the funtion that should be run on the
-        new thread.
+    SubmissionCount - Supplies the number of submission entries. This must be
+        a power of two no larger than IO_RING_MAX_ENTRIES.
 
-    Parameter - Supplies a pointer that will be passed directly to the thread
-        routine.
+    CompletionCount - Supplies the number of completion entries. Supply zero
+        to use twice the submission count.
 
-    StackBase - Supplies an optional pointer to the stack base address. If
-        supplied, the kernel will not add a guard region or automatically
-        expand the stack.
+    BufferRegion - Supplies an optional pointer to a region of memory to
+        register with the ring, which submissions can refer to by offset.
 
-    StackSize - Supplies the size of the new thread's stack. Supply 0 to use
-        the system default.
+    BufferRegionSize - Supplies the size of the buffer region in bytes.
 
-    ThreadPointer - Supplies the thread pointer to set for the new thread.
+    Handles - Supplies an optional array of handles to register with the
+        ring, which submissions can refer to by index.
 
-    ThreadId - Supplies an optional pointer where the ID of the new thread will
-        be returned on success.
+    HandleCount - Supplies the number of elements in the handle array.
+
+    Ring - Supplies a pointer where the ring will be described on success.
 
 Return Value:
 
@@ -665,181 +1521,209 @@ Return Value:
 --*/
 
 OS_API
-KSTATUS
-OsForkProcess (
-    PPROCESS_ID NewProcessId
+VOID
+OsDestroyIoRing (
+    POS_IO_RING Ring
     );
 
 /*++
 
 Routine Description:
 
-    This routine forks the current process into two separate processes. The
-    child process begins executing in the middle of this function.
+    This routine closes an I/O ring and unmaps its shared memory. Operations
+    still in flight are canceled.
 
 Arguments:
 
-    NewProcessId - Supplies a pointer that on success contains the process ID
-        of the child process in the parent, and 0 in the child. This value
-        contains -1 if the new process failed to spawn.
+    Ring - Supplies a pointer to the ring to destroy.
 
 Return Value:
 
-    STATUS_SUCCESS in both the parent and child on success.
-
-    Other status codes are returned to the parent if the child failed to spawn.
+    None.
 
 --*/
 
 OS_API
-KSTATUS
-OsExecuteImage (
-    PPROCESS_ENVIRONMENT Environment
+PIO_RING_SUBMISSION
+OsGetIoRingSubmission (
+    POS_IO_RING Ring
     );
 
 /*++
 
 Routine Description:
 
-    This routine replaces the currently running process with the given binary
-    image.
+    This routine returns the next free submission entry in an I/O ring. The
+    caller fills it in, and it is handed to the kernel by the next call to
+    submit.
 
 Arguments:
 
-    Environment - Supplies a pointer to the environment to execute, which
-        includes the image name, parameters, and environment variables.
+    Ring - Supplies a pointer to the ring.
 
 Return Value:
 
-    If this routine succeeds, it will not return, as the process will be
-    replaced with the new executable. If the process could not be started,
-    a failing status code will be returned to the caller.
+    Returns a pointer to the submission entry.
+
+    NULL if the submission queue is full.
 
 --*/
 
 OS_API
 KSTATUS
-OsGetSystemVersion (
-    PSYSTEM_VERSION_INFORMATION VersionInformation,
-    BOOL WantStrings
+OsSubmitIoRing (
+    POS_IO_RING Ring,
+    ULONG WaitCount,
+    ULONG TimeoutInMilliseconds,
+    PULONG SubmittedCount
     );
 
 /*++
 
 Routine Description:
 
-    This routine gets the system version information.
+    This routine hands the submission entries filled in since the last call
+    to the kernel, and optionally waits for completions. For rings with a
+    kernel polling thread, the kernel is only entered if the thread needs
+    waking or the caller wants to wait.
 
 Arguments:
 
-    VersionInformation - Supplies a pointer where the system version
-        information will be returned. The caller should not attempt to modify
-        or free the strings pointed to by members of this structure.
+    Ring - Supplies a pointer to the ring.
 
-    WantStrings - Supplies a boolean indicating if the build strings are
-        desired or just the major/minor version information.
+    WaitCount - Supplies the number of entries that must be in the completion
+        queue before this routine returns. Supply zero to not wait.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait for
+        completions. Use SYS_WAIT_TIME_INDEFINITE to wait forever.
+
+    SubmittedCount - Supplies an optional pointer where the number of entries
+        the kernel consumed during the call will be returned. This is always
+        zero for polled rings.
 
 Return Value:
 
-    Status code.
+    Status code. STATUS_TIMEOUT is returned if fewer than the requested
+    number of completions arrived in time.
 
 --*/
 
 OS_API
-KSTATUS
-OsGetCurrentDirectory (
-    BOOL Root,
-    PSTR *Buffer,
-    PUINTN BufferSize
+ULONG
+OsGetIoRingCompletionCount (
+    POS_IO_RING Ring
     );
 
 /*++
 
 Routine Description:
 
-    This routine retrieves a pointer to a null terminated string containing the
-    path to the current working directory or the current root directory.
+    This routine returns the number of entries waiting in an I/O ring's
+    completion queue.
 
 Arguments:
 
-    Root - Supplies a boolean indicating whether caller would like the current
-        working directory (FALSE) or the path to the current root directory
-        (TRUE). If the caller does not have permission to escape roots, or
-        does not currently have an altered root directory, then / is returned.
+    Ring - Supplies a pointer to the ring.
 
-    Buffer - Supplies a pointer that receives a pointer to a buffer that
-        contains a null terminated string for the path to the current
-        directory.
+Return Value:
 
-    BufferSize - Supplies a pointer that receives the size of the buffer, in
-        bytes.
+    Returns the number of completions that can be reaped.
+
+--*/
+
+OS_API
+PIO_RING_COMPLETION
+OsGetIoRingCompletion (
+    POS_IO_RING Ring
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the oldest entry in an I/O ring's completion queue
+    without removing it.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
 
 Return Value:
 
-    Status code.
+    Returns a pointer to the completion entry. It remains valid until the
+    completion queue is advanced past it.
+
+    NULL if the completion queue is empty.
 
 --*/
 
 OS_API
-KSTATUS
-OsChangeDirectory (
-    BOOL Root,
-    PSTR Path,
-    ULONG PathSize
+VOID
+OsAdvanceIoRingCompletions (
+    POS_IO_RING Ring,
+    ULONG Count
     );
 
 /*++
 
 Routine Description:
 
-    This routine sets the current working directory or current root directory.
+    This routine removes entries from an I/O ring's completion queue once
+    the caller is done with them, freeing the slots for the kernel.
 
 Arguments:
 
-    Root - Supplies a boolean indicating whether to change the current working
-        directory (FALSE) or the current root directory (TRUE). If attempting
-        to change the root, the caller must have permission to change the root,
-        must be running a single thread, and must not have any other handles
-        to directories open.
-
-    Path - Supplies a pointer to the path of the new working directory. If
-        trying to escape the root, supply NULL here. The caller must have
-        sufficient privileges to escape a root.
+    Ring - Supplies a pointer to the ring.
 
-    PathSize - Supplies the size of the path directory string in bytes
-        including the null terminator.
+    Count - Supplies the number of completions to remove.
 
 Return Value:
 
-    Status code.
+    None.
 
 --*/
 
 OS_API
 KSTATUS
-OsChangeDirectoryHandle (
-    BOOL Root,
-    HANDLE Handle
+OsSplice (
+    HANDLE Input,
+    PIO_OFFSET InputOffset,
+    HANDLE Output,
+    PIO_OFFSET OutputOffset,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
     );
 
 /*++
 
 Routine Description:
 
-    This routine sets the current working directory or root directory to the
-    same directory opened with the given file handle.
+    This routine moves data between two handles, at least one of which must
+    be a pipe, without copying it through a user mode buffer.
 
 Arguments:
 
-    Root - Supplies a boolean indicating whether to change the current working
-        directory (FALSE) or the current root directory (TRUE). If attempting
-        to change the root, the caller must have permission to change the root,
-        must be running a single thread, and must not have any other handles
-        to directories open.
+    Input - Supplies the handle to read from.
 
-    Handle - Supplies an open handle to a directory to change the current
-        working directroy to. Supply INVALID_HANDLE here to escape the root.
-        The caller must have sufficient privileges to escape a root.
+    InputOffset - Supplies an optional pointer to the offset within the input
+        to read from. On return, this will be advanced past the bytes moved.
+        If this is NULL, the input's current file position is used. This must
+        be NULL if the input is a pipe.
+
+    Output - Supplies the handle to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output to write to. On return, this will be advanced past the bytes
+        moved. If this is NULL, the output's current file position is used.
+        This must be NULL if the output is a pipe.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned. This is zero at the end of the input.
 
 Return Value:
 
@@ -849,48 +1733,38 @@ Return Value:
 
 OS_API
 KSTATUS
-OsPoll (
-    PSIGNAL_SET SignalMask,
-    PPOLL_DESCRIPTOR Descriptors,
-    ULONG DescriptorCount,
-    ULONG TimeoutInMilliseconds,
-    PULONG DescriptorsSelected
+OsSpliceMemory (
+    HANDLE Handle,
+    PIO_VECTOR VectorArray,
+    UINTN VectorCount,
+    ULONG Flags,
+    PUINTN BytesSpliced
     );
 
 /*++
 
 Routine Description:
 
-    This routine polls several I/O handles.
+    This routine places the pages of the given user buffers into a pipe
+    without copying them. The memory must not be modified until the data has
+    been read out of the pipe.
 
 Arguments:
 
-    SignalMask - Supplies an optional pointer to a mask to set for the
-        duration of the wait.
+    Handle - Supplies the handle to the write end of a pipe.
 
-    Descriptors - Supplies a pointer to an array of poll descriptor structures
-        describing the descriptors and events to wait on.
+    VectorArray - Supplies an array of buffers to place into the pipe.
 
-    DescriptorCount - Supplies the number of descriptors in the array.
+    VectorCount - Supplies the number of elements in the vector array.
 
-    TimeoutInMilliseconds - Supplies the number of milliseconds to wait before
-        giving up.
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
 
-    DescriptorsSelected - Supplies a pointer where the number of descriptors
-        that had activity will be returned on success.
+    BytesSpliced - Supplies a pointer where the number of bytes placed in the
+        pipe will be returned.
 
 Return Value:
 
-    STATUS_SUCCESS if one or more descriptors is ready for action.
-
-    STATUS_INSUFFICIENT_RESOURCES if memory could not be allocated for the
-        operation.
-
-    STATUS_INTERRUPTED if a signal was caught during the wait.
-
-    STATUS_TIMEOUT if no descriptors were ready in the given amount of time.
-
-    STATUS_INVALID_PARAMETER if more than MAX_LONG descriptors are supplied.
+    Status code.
 
 --*/
 
@@ -2297,6 +3171,50 @@ Return Value:
 
 --*/
 
+OS_API
+KSTATUS
+OsSetIoPriority (
+    IO_PRIORITY_REQUEST Request,
+    PROCESS_ID Id,
+    PULONG NewValue,
+    PULONG OldValue
+    );
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the I/O priority of a process or thread.
+
+Arguments:
+
+    Request - Supplies whether to get or set the I/O priority of a process or
+        a thread.
+
+    Id - Supplies the process or thread ID. Supply -1 to use the current
+        process or thread. Threads must belong to the current process.
+
+    NewValue - Supplies an optional pointer to the new I/O priority to set. If
+        this is NULL, then a new value is not set. See IO_PRIORITY_*
+        definitions.
+
+    OldValue - Supplies an optional pointer where the previous I/O priority
+        will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the request type or priority is not valid.
+
+    STATUS_NO_SUCH_PROCESS or STATUS_NO_SUCH_THREAD if the ID was not found.
+
+    STATUS_PERMISSION_DENIED if the caller is trying to set the real time
+    class or another process' priority and does not have the scheduling
+    permission.
+
+--*/
+
 OS_API
 KSTATUS
 OsCreateTerminal (
@@ -3001,6 +3919,47 @@ Return Value:
 
 --*/
 
+OS_API
+KSTATUS
+OsSocketPerformBatchIo (
+    HANDLE Socket,
+    PSOCKET_IO_MESSAGE Messages,
+    UINTN MessageCount,
+    ULONG Flags,
+    PUINTN MessagesCompleted
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives several socket messages with a single
+    system call.
+
+Arguments:
+
+    Socket - Supplies the socket handle.
+
+    Messages - Supplies an array of messages. Each message's parameters say
+        whether it is sent or received, and are updated on return for the
+        messages that completed.
+
+    MessageCount - Supplies the number of messages in the array.
+
+    Flags - Supplies a bitfield of flags. See SYS_SOCKET_BATCH_FLAG_*
+        definitions.
+
+    MessagesCompleted - Supplies a pointer where the number of messages that
+        completed will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one message completed.
+
+    Otherwise, the error status of the first message.
+
+--*/
+
 OS_API
 KSTATUS
 OsSocketGetSetInformation (
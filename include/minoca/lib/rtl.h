@@ -1604,6 +1604,97 @@ Return Value:
 
 --*/
 
+RTL_API
+ULONG
+RtlComputeInternetChecksum (
+    ULONG InitialSum,
+    PCVOID Buffer,
+    ULONG Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds the given buffer into a running Internet checksum. The
+    sum is computed in memory byte order, so the folded result can be stored
+    straight into a packet header.
+
+Arguments:
+
+    InitialSum - Supplies the running sum to add to. Supply 0 initially.
+
+    Buffer - Supplies a pointer to the data to add.
+
+    Size - Supplies the size of the buffer, in bytes. This must be even unless
+        this is the last piece of data being summed.
+
+Return Value:
+
+    Returns the new running sum. Use RtlFoldInternetChecksum to turn this into
+    the final checksum.
+
+--*/
+
+RTL_API
+ULONG
+RtlCopyAndComputeInternetChecksum (
+    ULONG InitialSum,
+    PVOID Destination,
+    PCVOID Source,
+    ULONG Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine copies a buffer and adds it into a running Internet checksum
+    in the same pass over the data.
+
+Arguments:
+
+    InitialSum - Supplies the running sum to add to. Supply 0 initially.
+
+    Destination - Supplies a pointer where the data will be copied to.
+
+    Source - Supplies a pointer to the data to copy and add. The buffers must
+        not overlap.
+
+    Size - Supplies the number of bytes to copy. This must be even unless
+        this is the last piece of data being summed.
+
+Return Value:
+
+    Returns the new running sum. Use RtlFoldInternetChecksum to turn this into
+    the final checksum.
+
+--*/
+
+RTL_API
+USHORT
+RtlFoldInternetChecksum (
+    ULONG Sum
+    );
+
+/*++
+
+Routine Description:
+
+    This routine turns a running Internet checksum into the final 16-bit
+    checksum.
+
+Arguments:
+
+    Sum - Supplies the running sum.
+
+Return Value:
+
+    Returns the one's complement of the folded sum, in memory byte order. A
+    buffer that already contains a valid checksum comes out as zero.
+
+--*/
+
 RTL_API
 VOID
 RtlRaiseAssertion (
@@ -134,7 +134,15 @@ Module Name:
 // Define the current version number of the net link properties structure.
 //
 
-#define NET_LINK_PROPERTIES_VERSION 1
+#define NET_LINK_PROPERTIES_VERSION 2
+
+//
+// Define the number of received frames a polled link processes per round by
+// default, and the most it can be configured to process.
+//
+
+#define NET_LINK_DEFAULT_POLL_BUDGET 64
+#define NET_LINK_MAX_POLL_BUDGET 1024
 
 //
 // Define some common network link speeds.
@@ -254,11 +262,45 @@ typedef enum _NET_SOCKET_BINDING_TYPE {
 
 typedef enum _NET_LINK_INFORMATION_TYPE {
     NetLinkInformationInvalid,
-    NetLinkInformationChecksumOffload
+    NetLinkInformationChecksumOffload,
+    NetLinkInformationInterruptCoalescing
 } NET_LINK_INFORMATION_TYPE, *PNET_LINK_INFORMATION_TYPE;
 
 /*++
 
+Structure Description:
+
+    This structure defines the hardware interrupt coalescing settings of a
+    link, used with the NetLinkInformationInterruptCoalescing information
+    type. The device interrupts once either limit for a direction is reached.
+    Zero in both fields of a direction means interrupt for every frame.
+    Devices round the values to what their hardware supports.
+
+Members:
+
+    ReceiveMicroseconds - Stores the number of microseconds to wait after a
+        frame is received before interrupting.
+
+    ReceiveFrames - Stores the number of received frames to wait for before
+        interrupting.
+
+    TransmitMicroseconds - Stores the number of microseconds to wait after a
+        frame is sent before interrupting.
+
+    TransmitFrames - Stores the number of sent frames to wait for before
+        interrupting.
+
+--*/
+
+typedef struct _NET_LINK_INTERRUPT_COALESCING {
+    ULONG ReceiveMicroseconds;
+    ULONG ReceiveFrames;
+    ULONG TransmitMicroseconds;
+    ULONG TransmitFrames;
+} NET_LINK_INTERRUPT_COALESCING, *PNET_LINK_INTERRUPT_COALESCING;
+
+/*++
+
 Structure Description:
 
     This structure defines packet size information.
@@ -342,6 +384,8 @@ typedef struct _NET_LINK_ADDRESS_ENTRY {
     SYSTEM_TIME LeaseEndTime;
 } NET_LINK_ADDRESS_ENTRY, *PNET_LINK_ADDRESS_ENTRY;
 
+typedef struct _NET_BUFFER_POOL NET_BUFFER_POOL, *PNET_BUFFER_POOL;
+
 /*++
 
 Structure Description:
@@ -374,6 +418,10 @@ Structure Description:
         beginning of the footer data (ie the location to store the first byte
         of new footer).
 
+    Pool - Stores a pointer to the link buffer pool the buffer is recycled
+        into when freed, or NULL if it did not come from a link's pool. This
+        is private to the networking core.
+
 --*/
 
 typedef struct _NET_PACKET_BUFFER {
@@ -386,6 +434,7 @@ typedef struct _NET_PACKET_BUFFER {
     ULONG DataSize;
     ULONG DataOffset;
     ULONG FooterOffset;
+    PNET_BUFFER_POOL Pool;
 } NET_PACKET_BUFFER, *PNET_PACKET_BUFFER;
 
 /*++
@@ -505,6 +554,63 @@ Return Value:
 
 --*/
 
+typedef
+ULONG
+(*PNET_DEVICE_LINK_POLL) (
+    PVOID DeviceContext,
+    ULONG Budget
+    );
+
+/*++
+
+Routine Description:
+
+    This routine processes received frames on a link that has asked to be
+    polled, passing them to the networking core. The device's receive
+    interrupt remains masked while it is being polled. This routine is called
+    at low level.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link being polled.
+
+    Budget - Supplies the maximum number of frames to process.
+
+Return Value:
+
+    Returns the number of frames processed. Returning less than the budget
+    indicates the receive ring is empty, after which the networking core will
+    call the complete poll routine.
+
+--*/
+
+typedef
+VOID
+(*PNET_DEVICE_LINK_COMPLETE_POLL) (
+    PVOID DeviceContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when polling a link has drained its receive ring.
+    The device should unmask the receive interrupt it masked before asking to
+    be polled. Frames that arrive in between must raise an interrupt once it
+    is unmasked. This routine is called at low level.
+
+Arguments:
+
+    DeviceContext - Supplies a pointer to the device context associated with
+        the link.
+
+Return Value:
+
+    None.
+
+--*/
+
 /*++
 
 Structure Description:
@@ -523,12 +629,21 @@ Structure Description:
         that the network link is no longer in use by the networking core and
         any link interface context can be destroyed.
 
+    Poll - Supplies an optional pointer to a function used to process received
+        frames on a link that called NetSchedulePoll. Devices that supply this
+        must also supply the complete poll routine.
+
+    CompletePoll - Supplies an optional pointer to a function used to unmask
+        the receive interrupt once polling has drained the receive ring.
+
 --*/
 
 typedef struct _NET_DEVICE_LINK_INTERFACE {
     PNET_DEVICE_LINK_SEND Send;
     PNET_DEVICE_LINK_GET_SET_INFORMATION GetSetInformation;
     PNET_DEVICE_LINK_DESTROY_LINK DestroyLink;
+    PNET_DEVICE_LINK_POLL Poll;
+    PNET_DEVICE_LINK_COMPLETE_POLL CompletePoll;
 } NET_DEVICE_LINK_INTERFACE, *PNET_DEVICE_LINK_INTERFACE;
 
 /*++
@@ -626,6 +741,18 @@ Structure Description:
     AddressTranslationTree - Stores the tree containing translations between
         network addresses and physical addresses, keyed by network address.
 
+    PollState - Stores the polling state of the link. This is private to the
+        networking core.
+
+    PollBudget - Stores the maximum number of frames the device processes
+        per poll round.
+
+    PollWorkItem - Stores a pointer to the work item that polls the link, if
+        the device supports polling.
+
+    BufferPool - Stores a pointer to the pool of recycled packet buffers sized
+        for this link. This is private to the networking core.
+
 --*/
 
 typedef struct _NET_LINK {
@@ -640,6 +767,10 @@ typedef struct _NET_LINK {
     NET_LINK_PROPERTIES Properties;
     PKEVENT AddressTranslationEvent;
     RED_BLACK_TREE AddressTranslationTree;
+    volatile ULONG PollState;
+    ULONG PollBudget;
+    PWORK_ITEM PollWorkItem;
+    PNET_BUFFER_POOL BufferPool;
 } NET_LINK, *PNET_LINK;
 
 typedef
@@ -2587,6 +2718,34 @@ Return Value:
 
 --*/
 
+NET_API
+VOID
+NetSchedulePoll (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine asks the networking core to poll a link for received frames.
+    The device must mask its receive interrupt before calling this routine,
+    and leave it masked until the networking core calls the complete poll
+    routine. Calling this while a poll is already scheduled makes sure the
+    device gets polled once more before polling completes. This routine must
+    be called at low level.
+
+Arguments:
+
+    Link - Supplies a pointer to the link to poll. The link's device must
+        supply the poll and complete poll routines.
+
+Return Value:
+
+    None.
+
+--*/
+
 NET_API
 KSTATUS
 NetFindLinkForLocalAddress (
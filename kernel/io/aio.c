@@ -0,0 +1,1764 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    aio.c
+
+Abstract:
+
+    This module implements asynchronous I/O. Requests are submitted in batches
+    to an asynchronous I/O context, and their user buffers are locked down so
+    that a pool of kernel worker threads can perform the I/O outside the
+    submitting thread. Since many workers can be blocked in the I/O path at
+    once, a deep queue of requests reaches the storage stack concurrently
+    rather than one at a time. Completion is reported by writing a result
+    into user memory, and optionally by a signal. The context itself is
+    readable and pollable, counting completions like an event counter.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define ASYNC_IO_ALLOCATION_TAG 0x6F497341 // 'oIsA'
+
+//
+// Define the maximum number of asynchronous I/O worker threads. This bounds
+// the number of requests in flight at once, including I/O ring requests
+// parked waiting for a socket or pipe to become ready.
+//
+
+#define IO_ASYNC_MAX_WORKER_THREADS 64
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an asynchronous I/O context.
+
+Members:
+
+    Header - Stores the standard object header.
+
+    Lock - Stores a pointer to the lock serializing access to the context.
+
+    IoState - Stores a pointer to the I/O object state of the context's file
+        object. The in event is set whenever the completion count is non-zero.
+        This is NULL once the last handle to the context is closed.
+
+    HandleCount - Stores the number of open handles to the context.
+
+    Generation - Stores a counter that is incremented every time a request
+        completes. It starts at one so that zero is never a valid generation.
+
+    CompletionCount - Stores the number of requests that completed since the
+        context was last read.
+
+    WaiterListHead - Stores the head of the list of threads waiting for the
+        generation to change.
+
+--*/
+
+typedef struct _ASYNC_IO_CONTEXT {
+    OBJECT_HEADER Header;
+    PQUEUED_LOCK Lock;
+    PIO_OBJECT_STATE IoState;
+    volatile ULONG HandleCount;
+    ULONGLONG Generation;
+    ULONGLONG CompletionCount;
+    LIST_ENTRY WaiterListHead;
+} ASYNC_IO_CONTEXT, *PASYNC_IO_CONTEXT;
+
+/*++
+
+Structure Description:
+
+    This structure defines a thread waiting on an asynchronous I/O context.
+
+Members:
+
+    ListEntry - Stores pointers to the next and previous waiters on the
+        context.
+
+    Event - Stores a pointer to the event signaled when the generation
+        changes.
+
+--*/
+
+typedef struct _ASYNC_IO_WAITER {
+    LIST_ENTRY ListEntry;
+    PKEVENT Event;
+} ASYNC_IO_WAITER, *PASYNC_IO_WAITER;
+
+/*++
+
+Structure Description:
+
+    This structure defines a batch of asynchronous I/O requests that sends a
+    signal once they have all completed.
+
+Members:
+
+    ReferenceCount - Stores the number of requests in the batch that have not
+        completed, plus one while the batch is being submitted.
+
+    Process - Stores a pointer to the process to signal.
+
+    SignalQueueEntry - Stores a pointer to the signal to send.
+
+--*/
+
+typedef struct _ASYNC_IO_BATCH {
+    volatile ULONG ReferenceCount;
+    PKPROCESS Process;
+    PSIGNAL_QUEUE_ENTRY SignalQueueEntry;
+} ASYNC_IO_BATCH, *PASYNC_IO_BATCH;
+
+/*++
+
+Structure Description:
+
+    This structure defines a single asynchronous I/O request queued to the
+    worker threads.
+
+Members:
+
+    Header - Stores the generic work header used to queue the request to the
+        worker threads.
+
+    Context - Stores a pointer to the asynchronous I/O context the request was
+        submitted to. A reference is held on the context.
+
+    Process - Stores a pointer to the submitting process. A reference is held
+        on the process.
+
+    Handle - Stores a pointer to the I/O handle to perform the I/O on. A
+        reference is held on the handle.
+
+    Operation - Stores the operation to perform.
+
+    Offset - Stores the offset to perform the I/O at.
+
+    Size - Stores the number of bytes to transfer.
+
+    IoBuffer - Stores a pointer to the locked I/O buffer describing the user
+        mode data buffer.
+
+    ResultBuffer - Stores a pointer to the locked I/O buffer describing the
+        user mode result structure.
+
+    SignalQueueEntry - Stores an optional pointer to the signal to send when
+        the request completes.
+
+    Batch - Stores an optional pointer to the batch the request belongs to.
+
+--*/
+
+typedef struct _ASYNC_IO_WORK {
+    IO_ASYNC_WORK Header;
+    PASYNC_IO_CONTEXT Context;
+    PKPROCESS Process;
+    PIO_HANDLE Handle;
+    ASYNC_IO_OPERATION Operation;
+    IO_OFFSET Offset;
+    UINTN Size;
+    PIO_BUFFER IoBuffer;
+    PIO_BUFFER ResultBuffer;
+    PSIGNAL_QUEUE_ENTRY SignalQueueEntry;
+    PASYNC_IO_BATCH Batch;
+} ASYNC_IO_WORK, *PASYNC_IO_WORK;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+IopDestroyAsyncIoContext (
+    PVOID Object
+    );
+
+KSTATUS
+IopCreateAsyncIoWork (
+    PASYNC_IO_CONTEXT Context,
+    PASYNC_IO_REQUEST Request,
+    PASYNC_IO_BATCH Batch,
+    PASYNC_IO_WORK *NewWork
+    );
+
+VOID
+IopDestroyAsyncIoWork (
+    PASYNC_IO_WORK Work
+    );
+
+PSIGNAL_QUEUE_ENTRY
+IopCreateAsyncIoSignal (
+    ULONG SignalNumber,
+    UINTN SignalValue
+    );
+
+VOID
+IopAsyncIoWorkerThread (
+    PVOID Parameter
+    );
+
+VOID
+IopPerformAsyncIoWork (
+    PIO_ASYNC_WORK AsyncWork
+    );
+
+VOID
+IopAsyncIoBatchReleaseReference (
+    PASYNC_IO_BATCH Batch
+    );
+
+VOID
+IopCompleteAsyncIoContextRequest (
+    PASYNC_IO_CONTEXT Context
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the queue of work waiting for a worker thread, the lock that protects
+// it, and the event worker threads wait on while it is empty.
+//
+
+PQUEUED_LOCK IoAsyncIoQueueLock;
+LIST_ENTRY IoAsyncIoQueue;
+PKEVENT IoAsyncIoQueueEvent;
+
+//
+// Store the number of queued work items and worker threads. These are
+// protected by the queue lock.
+//
+
+ULONG IoAsyncIoQueuedCount;
+ULONG IoAsyncIoWorkerCount;
+ULONG IoAsyncIoIdleWorkerCount;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateAsyncIoContext (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new asynchronous I/O context on behalf of user
+    mode.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG HandleFlags;
+    PIO_HANDLE IoHandle;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+
+    ASSERT(Process != PsGetKernelProcess());
+
+    if ((Parameters->OpenFlags &
+         ~(SYS_OPEN_FLAG_NON_BLOCKING | SYS_OPEN_FLAG_CLOSE_ON_EXECUTE)) != 0) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateAsyncIoContextEnd;
+    }
+
+    OpenFlags = OPEN_FLAG_CREATE;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_NON_BLOCKING) != 0) {
+        OpenFlags |= OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = IopOpen(FALSE,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ,
+                     OpenFlags,
+                     IoObjectAsyncIoContext,
+                     NULL,
+                     FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE,
+                     &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateAsyncIoContextEnd;
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(Process->HandleTable,
+                            IoHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateAsyncIoContextEnd;
+    }
+
+    IoHandle = NULL;
+
+SysCreateAsyncIoContextEnd:
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysSubmitAsyncIo (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine submits a batch of asynchronous I/O requests. The number of
+    requests submitted is returned on success.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PASYNC_IO_BATCH Batch;
+    PASYNC_IO_CONTEXT Context;
+    PIO_HANDLE ContextHandle;
+    PSYSTEM_CALL_SUBMIT_ASYNC_IO Parameters;
+    PKPROCESS Process;
+    ASYNC_IO_REQUEST Request;
+    ULONG RequestIndex;
+    KSTATUS Status;
+    ULONG SubmittedCount;
+    PASYNC_IO_WORK Work;
+    LIST_ENTRY WorkList;
+
+    Batch = NULL;
+    Parameters = (PSYSTEM_CALL_SUBMIT_ASYNC_IO)SystemCallParameter;
+    Process = PsGetCurrentProcess();
+    SubmittedCount = 0;
+    INITIALIZE_LIST_HEAD(&WorkList);
+    ContextHandle = ObGetHandleValue(Process->HandleTable,
+                                     Parameters->Context,
+                                     NULL);
+
+    if (ContextHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSubmitAsyncIoEnd;
+    }
+
+    if ((ContextHandle->FileObject->Properties.Type !=
+         IoObjectAsyncIoContext) ||
+        (Parameters->RequestCount > ASYNC_IO_MAX_SUBMIT) ||
+        (Parameters->SignalNumber >= SIGNAL_COUNT)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysSubmitAsyncIoEnd;
+    }
+
+    Context = ContextHandle->FileObject->SpecialIo;
+    if (Parameters->RequestCount == 0) {
+        Status = STATUS_SUCCESS;
+        goto SysSubmitAsyncIoEnd;
+    }
+
+    //
+    // Set up the batch completion signal. The batch holds one extra reference
+    // while requests are being submitted so it cannot fire early.
+    //
+
+    if (Parameters->SignalNumber != 0) {
+        Batch = MmAllocatePagedPool(sizeof(ASYNC_IO_BATCH),
+                                    ASYNC_IO_ALLOCATION_TAG);
+
+        if (Batch == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto SysSubmitAsyncIoEnd;
+        }
+
+        Batch->ReferenceCount = 1;
+        Batch->Process = Process;
+        Batch->SignalQueueEntry = IopCreateAsyncIoSignal(
+                                                    Parameters->SignalNumber,
+                                                    Parameters->SignalValue);
+
+        if (Batch->SignalQueueEntry == NULL) {
+            MmFreePagedPool(Batch);
+            Batch = NULL;
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto SysSubmitAsyncIoEnd;
+        }
+
+        ObAddReference(Process);
+    }
+
+    //
+    // Prepare every request before queuing any of them so that the worker
+    // threads are woken once for the whole batch.
+    //
+
+    Status = STATUS_SUCCESS;
+    for (RequestIndex = 0;
+         RequestIndex < Parameters->RequestCount;
+         RequestIndex += 1) {
+
+        Status = MmCopyFromUserMode(&Request,
+                                    &(Parameters->Requests[RequestIndex]),
+                                    sizeof(ASYNC_IO_REQUEST));
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Status = IopCreateAsyncIoWork(Context, &Request, Batch, &Work);
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        INSERT_BEFORE(&(Work->Header.ListEntry), &WorkList);
+        SubmittedCount += 1;
+    }
+
+    if (SubmittedCount != 0) {
+        IopQueueAsyncWork(&WorkList, SubmittedCount);
+        Status = STATUS_SUCCESS;
+    }
+
+SysSubmitAsyncIoEnd:
+    if (Batch != NULL) {
+
+        //
+        // If nothing was submitted, nothing else references the batch and it
+        // should not send its signal.
+        //
+
+        if (SubmittedCount == 0) {
+            MmFreePagedPool(Batch->SignalQueueEntry);
+            ObReleaseReference(Batch->Process);
+            MmFreePagedPool(Batch);
+
+        } else {
+            IopAsyncIoBatchReleaseReference(Batch);
+        }
+    }
+
+    if (ContextHandle != NULL) {
+        IoIoHandleReleaseReference(ContextHandle);
+    }
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    return SubmittedCount;
+}
+
+INTN
+IoSysWaitForAsyncIo (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for a request submitted to an asynchronous I/O context
+    to complete.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PASYNC_IO_CONTEXT Context;
+    PIO_HANDLE ContextHandle;
+    PSYSTEM_CALL_WAIT_FOR_ASYNC_IO Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+    ASYNC_IO_WAITER Waiter;
+
+    Parameters = (PSYSTEM_CALL_WAIT_FOR_ASYNC_IO)SystemCallParameter;
+    Process = PsGetCurrentProcess();
+    Waiter.Event = NULL;
+    ContextHandle = ObGetHandleValue(Process->HandleTable,
+                                     Parameters->Context,
+                                     NULL);
+
+    if (ContextHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysWaitForAsyncIoEnd;
+    }
+
+    if (ContextHandle->FileObject->Properties.Type != IoObjectAsyncIoContext) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysWaitForAsyncIoEnd;
+    }
+
+    Context = ContextHandle->FileObject->SpecialIo;
+    KeAcquireQueuedLock(Context->Lock);
+    if ((Context->Generation != Parameters->Generation) ||
+        (Parameters->TimeoutInMilliseconds == 0)) {
+
+        Status = STATUS_SUCCESS;
+        if (Context->Generation == Parameters->Generation) {
+            Status = STATUS_TIMEOUT;
+        }
+
+        Parameters->Generation = Context->Generation;
+        KeReleaseQueuedLock(Context->Lock);
+        goto SysWaitForAsyncIoEnd;
+    }
+
+    KeReleaseQueuedLock(Context->Lock);
+
+    //
+    // Each waiter gets its own event, registered while the generation is
+    // known to be unchanged, so a completion cannot slip in between checking
+    // the generation and going to sleep.
+    //
+
+    Waiter.Event = KeCreateEvent(NULL);
+    if (Waiter.Event == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto SysWaitForAsyncIoEnd;
+    }
+
+    KeAcquireQueuedLock(Context->Lock);
+    if (Context->Generation != Parameters->Generation) {
+        KeSignalEvent(Waiter.Event, SignalOptionSignalAll);
+    }
+
+    INSERT_BEFORE(&(Waiter.ListEntry), &(Context->WaiterListHead));
+    KeReleaseQueuedLock(Context->Lock);
+    Status = KeWaitForEvent(Waiter.Event,
+                            TRUE,
+                            Parameters->TimeoutInMilliseconds);
+
+    KeAcquireQueuedLock(Context->Lock);
+    LIST_REMOVE(&(Waiter.ListEntry));
+    if (Context->Generation != Parameters->Generation) {
+        Status = STATUS_SUCCESS;
+    }
+
+    Parameters->Generation = Context->Generation;
+    KeReleaseQueuedLock(Context->Lock);
+
+SysWaitForAsyncIoEnd:
+    if (Waiter.Event != NULL) {
+        KeDestroyEvent(Waiter.Event);
+    }
+
+    if (ContextHandle != NULL) {
+        IoIoHandleReleaseReference(ContextHandle);
+    }
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = STATUS_RESTART_AFTER_SIGNAL;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopInitializeAsyncIoSupport (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    asynchronous I/O.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    INITIALIZE_LIST_HEAD(&IoAsyncIoQueue);
+    IoAsyncIoQueueLock = KeCreateQueuedLock();
+    if (IoAsyncIoQueueLock == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    IoAsyncIoQueueEvent = KeCreateEvent(NULL);
+    if (IoAsyncIoQueueEvent == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCreateAsyncIoContext (
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new asynchronous I/O context and its file object.
+
+Arguments:
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PASYNC_IO_CONTEXT Context;
+    BOOL Created;
+    FILE_PROPERTIES FileProperties;
+    PFILE_OBJECT NewFileObject;
+    KSTATUS Status;
+    PKTHREAD Thread;
+
+    ASSERT(*FileObject == NULL);
+
+    NewFileObject = NULL;
+
+    //
+    // Create the object. This reference is transferred to the file object's
+    // special I/O member on success.
+    //
+
+    Context = ObCreateObject(ObjectAsyncIoContext,
+                             NULL,
+                             NULL,
+                             0,
+                             sizeof(ASYNC_IO_CONTEXT),
+                             IopDestroyAsyncIoContext,
+                             0,
+                             IO_ALLOCATION_TAG);
+
+    if (Context == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateAsyncIoContextEnd;
+    }
+
+    Context->Generation = 1;
+    INITIALIZE_LIST_HEAD(&(Context->WaiterListHead));
+    Context->Lock = KeCreateQueuedLock();
+    if (Context->Lock == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateAsyncIoContextEnd;
+    }
+
+    Thread = KeGetCurrentThread();
+    IopFillOutFilePropertiesForObject(&FileProperties, &(Context->Header));
+    FileProperties.Permissions = Permissions;
+    FileProperties.Type = IoObjectAsyncIoContext;
+    FileProperties.UserId = Thread->Identity.EffectiveUserId;
+    FileProperties.GroupId = Thread->Identity.EffectiveGroupId;
+    Status = IopCreateOrLookupFileObject(&FileProperties,
+                                         ObGetRootObject(),
+                                         0,
+                                         &NewFileObject,
+                                         &Created);
+
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Release the reference added by filling out the file properties.
+        //
+
+        ObReleaseReference(Context);
+        goto CreateAsyncIoContextEnd;
+    }
+
+    ASSERT(Created != FALSE);
+    ASSERT(NewFileObject->IoState != NULL);
+
+    Context->IoState = NewFileObject->IoState;
+    IoSetIoObjectState(Context->IoState, POLL_EVENT_IN, FALSE);
+    NewFileObject->SpecialIo = Context;
+    Context = NULL;
+    *FileObject = NewFileObject;
+    Status = STATUS_SUCCESS;
+
+CreateAsyncIoContextEnd:
+
+    //
+    // On both success and failure, the file object's ready event needs to be
+    // signaled. Other threads may be waiting on the event.
+    //
+
+    if (NewFileObject != NULL) {
+        KeSignalEvent(NewFileObject->ReadyEvent, SignalOptionSignalAll);
+    }
+
+    if (Context != NULL) {
+        ObReleaseReference(Context);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopOpenAsyncIoContext (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an asynchronous I/O context is opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the new I/O handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PASYNC_IO_CONTEXT Context;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectAsyncIoContext);
+
+    Context = IoHandle->FileObject->SpecialIo;
+    RtlAtomicAdd32(&(Context->HandleCount), 1);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCloseAsyncIoContext (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an asynchronous I/O context handle is closed.
+    Requests still in flight when the last handle goes away stop updating the
+    context's I/O object state, which is destroyed with the file object.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PASYNC_IO_CONTEXT Context;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectAsyncIoContext);
+
+    Context = IoHandle->FileObject->SpecialIo;
+    if (RtlAtomicAdd32(&(Context->HandleCount), -1) != 1) {
+        return STATUS_SUCCESS;
+    }
+
+    KeAcquireQueuedLock(Context->Lock);
+    Context->IoState = NULL;
+    KeReleaseQueuedLock(Context->Lock);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopPerformAsyncIoContextIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads from an asynchronous I/O context. Reads return the
+    64-bit number of requests that completed since the last read. Writes are
+    not supported.
+
+Arguments:
+
+    Handle - Supplies a pointer to the asynchronous I/O context handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PASYNC_IO_CONTEXT Context;
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    PFILE_OBJECT FileObject;
+    ULONG ReturnedEvents;
+    KSTATUS Status;
+    ULONGLONG TimeCounterFrequency;
+    ULONG TimeoutInMilliseconds;
+    ULONGLONG Value;
+
+    FileObject = Handle->FileObject;
+
+    ASSERT(IoContext->IoBuffer != NULL);
+    ASSERT(FileObject->Properties.Type == IoObjectAsyncIoContext);
+
+    Context = FileObject->SpecialIo;
+    IoContext->BytesCompleted = 0;
+    if ((IoContext->Write != FALSE) ||
+        (IoContext->SizeInBytes < sizeof(ULONGLONG))) {
+
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // Wait for a completion. Another reader can take the count between the
+    // wake and the lock, so each wait only gets the time remaining until the
+    // original deadline.
+    //
+
+    TimeoutInMilliseconds = IoContext->TimeoutInMilliseconds;
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    while (TRUE) {
+        KeAcquireQueuedLock(Context->Lock);
+        if (Context->CompletionCount != 0) {
+            break;
+        }
+
+        KeReleaseQueuedLock(Context->Lock);
+        if (TimeoutInMilliseconds == 0) {
+            if (EndTime != 0) {
+                return STATUS_TIMEOUT;
+            }
+
+            return STATUS_TRY_AGAIN;
+        }
+
+        Status = IoWaitForIoObjectState(Context->IoState,
+                                        POLL_EVENT_IN,
+                                        TRUE,
+                                        TimeoutInMilliseconds,
+                                        &ReturnedEvents);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        if (EndTime != 0) {
+            CurrentTime = KeGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                TimeoutInMilliseconds = 0;
+
+            } else {
+                TimeoutInMilliseconds = ((EndTime - CurrentTime) *
+                                         MILLISECONDS_PER_SECOND) /
+                                        TimeCounterFrequency;
+            }
+        }
+    }
+
+    //
+    // Copy the value out before consuming it so that nothing is lost if the
+    // caller's buffer is bad.
+    //
+
+    Value = Context->CompletionCount;
+    Status = MmCopyIoBufferData(IoContext->IoBuffer,
+                                &Value,
+                                0,
+                                sizeof(ULONGLONG),
+                                TRUE);
+
+    if (KSUCCESS(Status)) {
+        Context->CompletionCount = 0;
+        IoSetIoObjectState(Context->IoState, POLL_EVENT_IN, FALSE);
+        IoContext->BytesCompleted = sizeof(ULONGLONG);
+    }
+
+    KeReleaseQueuedLock(Context->Lock);
+    return Status;
+}
+
+VOID
+IopQueueAsyncWork (
+    PLIST_ENTRY WorkList,
+    ULONG WorkCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hands a list of work to the asynchronous I/O worker threads,
+    creating more worker threads if there are not enough idle ones to start
+    all of the work right away.
+
+Arguments:
+
+    WorkList - Supplies a pointer to the head of a list of IO_ASYNC_WORK
+        structures. The list will be empty on return.
+
+    WorkCount - Supplies the number of entries in the list.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG NewWorkers;
+    KSTATUS Status;
+
+    ASSERT(LIST_EMPTY(WorkList) == FALSE);
+
+    NewWorkers = 0;
+    KeAcquireQueuedLock(IoAsyncIoQueueLock);
+    APPEND_LIST(WorkList, &IoAsyncIoQueue);
+    INITIALIZE_LIST_HEAD(WorkList);
+    IoAsyncIoQueuedCount += WorkCount;
+    if (IoAsyncIoQueuedCount > IoAsyncIoIdleWorkerCount) {
+        NewWorkers = IoAsyncIoQueuedCount - IoAsyncIoIdleWorkerCount;
+        if (NewWorkers >
+            (IO_ASYNC_MAX_WORKER_THREADS - IoAsyncIoWorkerCount)) {
+
+            NewWorkers = IO_ASYNC_MAX_WORKER_THREADS - IoAsyncIoWorkerCount;
+        }
+
+        IoAsyncIoWorkerCount += NewWorkers;
+    }
+
+    KeSignalEvent(IoAsyncIoQueueEvent, SignalOptionSignalAll);
+    KeReleaseQueuedLock(IoAsyncIoQueueLock);
+
+    //
+    // Worker threads are never torn down, so a burst of work leaves the pool
+    // sized for the deepest queue seen.
+    //
+
+    while (NewWorkers != 0) {
+        Status = PsCreateKernelThread(IopAsyncIoWorkerThread,
+                                      NULL,
+                                      "IopAsyncIoWorkerThread");
+
+        if (!KSUCCESS(Status)) {
+            KeAcquireQueuedLock(IoAsyncIoQueueLock);
+            IoAsyncIoWorkerCount -= NewWorkers;
+            KeReleaseQueuedLock(IoAsyncIoQueueLock);
+            break;
+        }
+
+        NewWorkers -= 1;
+    }
+
+    return;
+}
+
+KSTATUS
+IopLockUserIoBuffer (
+    PIO_BUFFER IoBuffer,
+    BOOL Write,
+    PIO_BUFFER *LockedBuffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine locks down the pages of an I/O buffer describing the current
+    process' user mode memory, so that it can be accessed from any thread
+    after the system call that created it returns.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to the user mode I/O buffer.
+
+    Write - Supplies a boolean indicating whether the memory will be written
+        to.
+
+    LockedBuffer - Supplies a pointer where a new I/O buffer describing the
+        same memory in locked pages will be returned on success. The caller
+        is responsible for freeing both buffers.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PIO_BUFFER_FRAGMENT Fragment;
+    UINTN FragmentIndex;
+    BOOL LockedCopy;
+    UINTN Size;
+    KSTATUS Status;
+    PIO_BUFFER ValidBuffer;
+
+    *LockedBuffer = NULL;
+
+    //
+    // Touch every page first so that copy-on-write pages are broken before
+    // the physical pages backing the buffer are pinned.
+    //
+
+    Size = 0;
+    for (FragmentIndex = 0;
+         FragmentIndex < IoBuffer->FragmentCount;
+         FragmentIndex += 1) {
+
+        Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+        Status = MmTouchUserModeBuffer(Fragment->VirtualAddress,
+                                       Fragment->Size,
+                                       Write);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        Size += Fragment->Size;
+    }
+
+    ValidBuffer = IoBuffer;
+    Status = MmValidateIoBuffer(0,
+                                MAX_ULONGLONG,
+                                1,
+                                Size,
+                                FALSE,
+                                &ValidBuffer,
+                                &LockedCopy);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    //
+    // A user mode buffer is never locked to begin with, so the validated
+    // buffer should always be a locked copy backed by the same pages.
+    //
+
+    ASSERT(ValidBuffer != IoBuffer);
+
+    if (LockedCopy == FALSE) {
+        MmFreeIoBuffer(ValidBuffer);
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    *LockedBuffer = ValidBuffer;
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopLockUserBuffer (
+    PVOID Buffer,
+    UINTN Size,
+    BOOL Write,
+    PIO_BUFFER *LockedBuffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates an I/O buffer for a region of the current process'
+    user mode memory, with the pages locked in memory so that it can be
+    accessed from any thread after the system call returns.
+
+Arguments:
+
+    Buffer - Supplies the user mode address of the region.
+
+    Size - Supplies the size of the region in bytes.
+
+    Write - Supplies a boolean indicating whether the region will be written
+        to.
+
+    LockedBuffer - Supplies a pointer where the locked I/O buffer will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    KSTATUS Status;
+    PIO_BUFFER UnlockedBuffer;
+
+    *LockedBuffer = NULL;
+    Status = MmCreateIoBuffer(Buffer, Size, 0, &UnlockedBuffer);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    Status = IopLockUserIoBuffer(UnlockedBuffer, Write, LockedBuffer);
+    MmFreeIoBuffer(UnlockedBuffer);
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopDestroyAsyncIoContext (
+    PVOID Object
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys an asynchronous I/O context.
+
+Arguments:
+
+    Object - Supplies a pointer to the context being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PASYNC_IO_CONTEXT Context;
+
+    Context = Object;
+
+    ASSERT(LIST_EMPTY(&(Context->WaiterListHead)) != FALSE);
+
+    if (Context->Lock != NULL) {
+        KeDestroyQueuedLock(Context->Lock);
+    }
+
+    return;
+}
+
+KSTATUS
+IopCreateAsyncIoWork (
+    PASYNC_IO_CONTEXT Context,
+    PASYNC_IO_REQUEST Request,
+    PASYNC_IO_BATCH Batch,
+    PASYNC_IO_WORK *NewWork
+    )
+
+/*++
+
+Routine Description:
+
+    This routine validates a user mode asynchronous I/O request and creates
+    the queued work for it, locking down the user buffers it refers to.
+
+Arguments:
+
+    Context - Supplies a pointer to the context the request is submitted to.
+
+    Request - Supplies a pointer to a kernel copy of the request.
+
+    Batch - Supplies an optional pointer to the batch the request belongs to.
+
+    NewWork - Supplies a pointer where a pointer to the new work will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PKPROCESS Process;
+    KSTATUS Status;
+    PASYNC_IO_WORK Work;
+
+    Process = PsGetCurrentProcess();
+    Work = MmAllocatePagedPool(sizeof(ASYNC_IO_WORK), ASYNC_IO_ALLOCATION_TAG);
+    if (Work == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateAsyncIoWorkEnd;
+    }
+
+    RtlZeroMemory(Work, sizeof(ASYNC_IO_WORK));
+    Work->Header.Routine = IopPerformAsyncIoWork;
+    Work->Operation = Request->Operation;
+    Work->Offset = Request->Offset;
+    Work->Size = Request->Size;
+    if ((Request->SignalNumber >= SIGNAL_COUNT) ||
+        (Request->Result == NULL) ||
+        ((Work->Offset < 0) && (Work->Offset != IO_OFFSET_NONE))) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto CreateAsyncIoWorkEnd;
+    }
+
+    Work->Handle = ObGetHandleValue(Process->HandleTable,
+                                    Request->Handle,
+                                    NULL);
+
+    if (Work->Handle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto CreateAsyncIoWorkEnd;
+    }
+
+    RtlAtomicAdd32(&(Work->Handle->AsyncIoCount), 1);
+
+    switch (Work->Operation) {
+    case AsyncIoOperationRead:
+    case AsyncIoOperationWrite:
+        if (Work->Size > (UINTN)MAX_INTN) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto CreateAsyncIoWorkEnd;
+        }
+
+        if (Work->Size != 0) {
+
+            //
+            // Reads write into the user buffer, so it needs to be probed for
+            // write access.
+            //
+
+            Status = IopLockUserBuffer(
+                                Request->Buffer,
+                                Work->Size,
+                                (Work->Operation == AsyncIoOperationRead),
+                                &(Work->IoBuffer));
+
+            if (!KSUCCESS(Status)) {
+                goto CreateAsyncIoWorkEnd;
+            }
+        }
+
+        break;
+
+    case AsyncIoOperationFlush:
+        break;
+
+    default:
+        Status = STATUS_INVALID_PARAMETER;
+        goto CreateAsyncIoWorkEnd;
+    }
+
+    Status = IopLockUserBuffer(Request->Result,
+                               sizeof(ASYNC_IO_RESULT),
+                               TRUE,
+                               &(Work->ResultBuffer));
+
+    if (!KSUCCESS(Status)) {
+        goto CreateAsyncIoWorkEnd;
+    }
+
+    if (Request->SignalNumber != 0) {
+        Work->SignalQueueEntry = IopCreateAsyncIoSignal(Request->SignalNumber,
+                                                        Request->SignalValue);
+
+        if (Work->SignalQueueEntry == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto CreateAsyncIoWorkEnd;
+        }
+    }
+
+    ObAddReference(Context);
+    Work->Context = Context;
+    ObAddReference(Process);
+    Work->Process = Process;
+    if (Batch != NULL) {
+        RtlAtomicAdd32(&(Batch->ReferenceCount), 1);
+        Work->Batch = Batch;
+    }
+
+    Status = STATUS_SUCCESS;
+
+CreateAsyncIoWorkEnd:
+    if (!KSUCCESS(Status)) {
+        if (Work != NULL) {
+            IopDestroyAsyncIoWork(Work);
+            Work = NULL;
+        }
+    }
+
+    *NewWork = Work;
+    return Status;
+}
+
+VOID
+IopDestroyAsyncIoWork (
+    PASYNC_IO_WORK Work
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases the resources held by an asynchronous I/O request.
+
+Arguments:
+
+    Work - Supplies a pointer to the request to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // The result has already been published, so user mode will never see a
+    // completed request still counted against the handle.
+    //
+
+    if (Work->Handle != NULL) {
+        RtlAtomicAdd32(&(Work->Handle->AsyncIoCount), -1);
+        IoIoHandleReleaseReference(Work->Handle);
+    }
+
+    if (Work->IoBuffer != NULL) {
+        MmFreeIoBuffer(Work->IoBuffer);
+    }
+
+    if (Work->ResultBuffer != NULL) {
+        MmFreeIoBuffer(Work->ResultBuffer);
+    }
+
+    if (Work->SignalQueueEntry != NULL) {
+        MmFreePagedPool(Work->SignalQueueEntry);
+    }
+
+    if (Work->Batch != NULL) {
+        IopAsyncIoBatchReleaseReference(Work->Batch);
+    }
+
+    if (Work->Context != NULL) {
+        ObReleaseReference(Work->Context);
+    }
+
+    if (Work->Process != NULL) {
+        ObReleaseReference(Work->Process);
+    }
+
+    MmFreePagedPool(Work);
+    return;
+}
+
+PSIGNAL_QUEUE_ENTRY
+IopCreateAsyncIoSignal (
+    ULONG SignalNumber,
+    UINTN SignalValue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates the signal sent when asynchronous I/O completes.
+    It is allocated up front so that completion cannot fail.
+
+Arguments:
+
+    SignalNumber - Supplies the signal number to send.
+
+    SignalValue - Supplies the value to send with the signal.
+
+Return Value:
+
+    Returns a pointer to the signal queue entry on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PSIGNAL_QUEUE_ENTRY SignalQueueEntry;
+    PKTHREAD Thread;
+
+    SignalQueueEntry = MmAllocatePagedPool(sizeof(SIGNAL_QUEUE_ENTRY),
+                                           ASYNC_IO_ALLOCATION_TAG);
+
+    if (SignalQueueEntry == NULL) {
+        return NULL;
+    }
+
+    Thread = KeGetCurrentThread();
+    RtlZeroMemory(SignalQueueEntry, sizeof(SIGNAL_QUEUE_ENTRY));
+    SignalQueueEntry->Parameters.SignalNumber = SignalNumber;
+    SignalQueueEntry->Parameters.SignalCode = SIGNAL_CODE_ASYNC_IO;
+    SignalQueueEntry->Parameters.FromU.SendingProcess =
+                                   Thread->OwningProcess->Identifiers.ProcessId;
+
+    SignalQueueEntry->Parameters.SendingUserId = Thread->Identity.RealUserId;
+    SignalQueueEntry->Parameters.Parameter = SignalValue;
+    SignalQueueEntry->CompletionRoutine = PsDefaultSignalCompletionRoutine;
+    return SignalQueueEntry;
+}
+
+VOID
+IopAsyncIoWorkerThread (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements an asynchronous I/O worker thread, which performs
+    queued work one item at a time.
+
+Arguments:
+
+    Parameter - Supplies an unused parameter.
+
+Return Value:
+
+    None. This thread never exits.
+
+--*/
+
+{
+
+    PIO_ASYNC_WORK Work;
+
+    KeAcquireQueuedLock(IoAsyncIoQueueLock);
+    while (TRUE) {
+        if (LIST_EMPTY(&IoAsyncIoQueue) != FALSE) {
+            KeSignalEvent(IoAsyncIoQueueEvent, SignalOptionUnsignal);
+            IoAsyncIoIdleWorkerCount += 1;
+            KeReleaseQueuedLock(IoAsyncIoQueueLock);
+            KeWaitForEvent(IoAsyncIoQueueEvent, FALSE, WAIT_TIME_INDEFINITE);
+            KeAcquireQueuedLock(IoAsyncIoQueueLock);
+            IoAsyncIoIdleWorkerCount -= 1;
+            continue;
+        }
+
+        Work = LIST_VALUE(IoAsyncIoQueue.Next, IO_ASYNC_WORK, ListEntry);
+        LIST_REMOVE(&(Work->ListEntry));
+        IoAsyncIoQueuedCount -= 1;
+        KeReleaseQueuedLock(IoAsyncIoQueueLock);
+        Work->Routine(Work);
+        KeAcquireQueuedLock(IoAsyncIoQueueLock);
+    }
+
+    return;
+}
+
+VOID
+IopPerformAsyncIoWork (
+    PIO_ASYNC_WORK AsyncWork
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs an asynchronous I/O request, reports its result,
+    and destroys it.
+
+Arguments:
+
+    AsyncWork - Supplies a pointer to the header of the request to perform.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN BytesCompleted;
+    KSTATUS Status;
+    PASYNC_IO_WORK Work;
+
+    Work = PARENT_STRUCTURE(AsyncWork, ASYNC_IO_WORK, Header);
+    BytesCompleted = 0;
+    switch (Work->Operation) {
+    case AsyncIoOperationRead:
+        Status = STATUS_SUCCESS;
+        if (Work->Size != 0) {
+            Status = IoReadAtOffset(Work->Handle,
+                                    Work->IoBuffer,
+                                    Work->Offset,
+                                    Work->Size,
+                                    0,
+                                    WAIT_TIME_INDEFINITE,
+                                    &BytesCompleted,
+                                    NULL);
+
+            if (Status == STATUS_END_OF_FILE) {
+                Status = STATUS_SUCCESS;
+            }
+        }
+
+        break;
+
+    case AsyncIoOperationWrite:
+        Status = STATUS_SUCCESS;
+        if (Work->Size != 0) {
+            Status = IoWriteAtOffset(Work->Handle,
+                                     Work->IoBuffer,
+                                     Work->Offset,
+                                     Work->Size,
+                                     0,
+                                     WAIT_TIME_INDEFINITE,
+                                     &BytesCompleted,
+                                     NULL);
+        }
+
+        break;
+
+    case AsyncIoOperationFlush:
+        Status = IoFlush(Work->Handle, 0, -1, 0);
+        break;
+
+    default:
+
+        ASSERT(FALSE);
+
+        Status = STATUS_INVALID_PARAMETER;
+        break;
+    }
+
+    if (Status == ASYNC_IO_STATUS_PENDING) {
+        Status = STATUS_UNSUCCESSFUL;
+    }
+
+    //
+    // Publish the byte count before the status, as user mode polls the status
+    // to learn that the request is done.
+    //
+
+    MmCopyIoBufferData(Work->ResultBuffer,
+                       &BytesCompleted,
+                       FIELD_OFFSET(ASYNC_IO_RESULT, BytesCompleted),
+                       sizeof(UINTN),
+                       TRUE);
+
+    RtlMemoryBarrier();
+    MmCopyIoBufferData(Work->ResultBuffer,
+                       &Status,
+                       FIELD_OFFSET(ASYNC_IO_RESULT, Status),
+                       sizeof(KSTATUS),
+                       TRUE);
+
+    if (Work->SignalQueueEntry != NULL) {
+        PsSignalProcess(Work->Process,
+                        Work->SignalQueueEntry->Parameters.SignalNumber,
+                        Work->SignalQueueEntry);
+
+        Work->SignalQueueEntry = NULL;
+    }
+
+    IopCompleteAsyncIoContextRequest(Work->Context);
+    IopDestroyAsyncIoWork(Work);
+    return;
+}
+
+VOID
+IopAsyncIoBatchReleaseReference (
+    PASYNC_IO_BATCH Batch
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a reference on an asynchronous I/O batch. When the
+    last reference is released, every request in the batch is done, so the
+    batch signal is sent and the batch is freed.
+
+Arguments:
+
+    Batch - Supplies a pointer to the batch.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldCount;
+
+    OldCount = RtlAtomicAdd32(&(Batch->ReferenceCount), (ULONG)-1);
+
+    ASSERT(OldCount != 0);
+
+    if (OldCount == 1) {
+        PsSignalProcess(Batch->Process,
+                        Batch->SignalQueueEntry->Parameters.SignalNumber,
+                        Batch->SignalQueueEntry);
+
+        ObReleaseReference(Batch->Process);
+        MmFreePagedPool(Batch);
+    }
+
+    return;
+}
+
+VOID
+IopCompleteAsyncIoContextRequest (
+    PASYNC_IO_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the completion of a request in its asynchronous I/O
+    context and wakes anyone waiting on the context.
+
+Arguments:
+
+    Context - Supplies a pointer to the context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PASYNC_IO_WAITER Waiter;
+
+    KeAcquireQueuedLock(Context->Lock);
+    Context->Generation += 1;
+    Context->CompletionCount += 1;
+    if (Context->IoState != NULL) {
+        IoSetIoObjectState(Context->IoState, POLL_EVENT_IN, TRUE);
+    }
+
+    CurrentEntry = Context->WaiterListHead.Next;
+    while (CurrentEntry != &(Context->WaiterListHead)) {
+        Waiter = LIST_VALUE(CurrentEntry, ASYNC_IO_WAITER, ListEntry);
+        KeSignalEvent(Waiter->Event, SignalOptionSignalAll);
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    KeReleaseQueuedLock(Context->Lock);
+    return;
+}
+
@@ -0,0 +1,1715 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    blockq.c
+
+Abstract:
+
+    This module implements the block device request queue. Reads and writes
+    bound for block devices are queued here on their way to the driver, where
+    requests for adjacent blocks are merged into one, and the order in which
+    requests reach the device is chosen by an I/O scheduler.
+
+    The queue has no worker threads. Each request is issued by the thread
+    that submitted it, once the scheduler picks it. A request merged into
+    another one is carried by that request's thread, and its submitter simply
+    waits for the result.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the default number of requests a block device is handed at once.
+// Devices that can only work on one command at a time set a depth of 1 when
+// they start. Requests beyond the depth wait in the queue, where they can be
+// merged.
+//
+
+#define BLOCK_QUEUE_DEFAULT_DEPTH 4
+
+//
+// Define the largest request that merging is allowed to build.
+//
+
+#define BLOCK_QUEUE_MAX_MERGE_SIZE (128 * _1KB)
+
+//
+// Define how long the deadline scheduler lets reads and writes wait before
+// they are serviced ahead of the sweep, in milliseconds.
+//
+
+#define BLOCK_QUEUE_READ_EXPIRE 500
+#define BLOCK_QUEUE_WRITE_EXPIRE 5000
+
+//
+// Define the number of requests queued behind a plug that cause the queue to
+// be unplugged early, and the longest time in milliseconds that a request
+// will sit behind a plug.
+//
+
+#define BLOCK_QUEUE_UNPLUG_THRESHOLD 8
+#define BLOCK_QUEUE_PLUG_TIMEOUT 4
+
+//
+// Define the number of I/O priority classes the queue keeps separately, and
+// the index of each. Class none never reaches the queue.
+//
+
+#define BLOCK_QUEUE_CLASS_COUNT 3
+#define BLOCK_QUEUE_CLASS_INDEX(_Priority) \
+    (IO_PRIORITY_CLASS(_Priority) - IO_PRIORITY_CLASS_REAL_TIME)
+
+#define BLOCK_QUEUE_CLASS_IDLE \
+    (IO_PRIORITY_CLASS_IDLE - IO_PRIORITY_CLASS_REAL_TIME)
+
+//
+// Define how long idle class requests wait before they are issued anyway,
+// in milliseconds. The deadline scheduler's read and write expiry apply to the
+// other classes, scaled by the priority level.
+//
+
+#define BLOCK_QUEUE_IDLE_READ_EXPIRE 2000
+#define BLOCK_QUEUE_IDLE_WRITE_EXPIRE 10000
+
+//
+// Define how long the device must go without other I/O before idle class
+// requests are issued, in milliseconds.
+//
+
+#define BLOCK_QUEUE_IDLE_DELAY 10
+
+//
+// Define the number of requests in a row one process can have issued before
+// waiting requests from other processes in the same class get a turn.
+//
+
+#define BLOCK_QUEUE_PROCESS_QUANTUM 8
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef enum _BLOCK_REQUEST_STATE {
+    BlockRequestQueued,
+    BlockRequestMerged,
+    BlockRequestDispatched,
+    BlockRequestComplete
+} BLOCK_REQUEST_STATE, *PBLOCK_REQUEST_STATE;
+
+/*++
+
+Structure Description:
+
+    This structure defines a block device request queue.
+
+Members:
+
+    ListEntry - Stores pointers to the next and previous queues in the global
+        list.
+
+    Device - Stores a pointer to the device the queue belongs to. The queue
+        does not hold a reference; it is destroyed with the device.
+
+    Lock - Stores a pointer to the lock protecting the queue.
+
+    Scheduler - Stores the scheduler that picks the next request to issue.
+
+    QueueDepth - Stores the maximum number of requests handed to the device
+        at once.
+
+    InFlight - Stores the number of requests currently with the device.
+
+    PendingCount - Stores the number of requests waiting to be issued, not
+        counting requests merged into other requests.
+
+    ClassPendingCount - Stores the number of waiting requests in each I/O
+        priority class.
+
+    PlugCount - Stores the number of outstanding plugs on the queue.
+
+    SortedListHead - Stores the list of waiting requests, sorted by offset.
+
+    FifoListHead - Stores the lists of waiting reads (index 0) and writes
+        (index 1) for each I/O priority class, each in arrival order.
+
+    HeadOffset - Stores the offset just past the last request issued, which
+        is where the deadline scheduler's sweep continues from.
+
+    BusyTime - Stores the time counter value when the device last started or
+        finished a request that was not in the idle class.
+
+    LastProcessId - Stores the ID of the process whose request was issued
+        last.
+
+    ProcessRunCount - Stores the number of requests in a row issued for the
+        last process.
+
+    Statistics - Stores the queue's statistics.
+
+--*/
+
+struct _BLOCK_QUEUE {
+    LIST_ENTRY ListEntry;
+    PDEVICE Device;
+    PQUEUED_LOCK Lock;
+    IO_BLOCK_SCHEDULER Scheduler;
+    ULONG QueueDepth;
+    ULONG InFlight;
+    ULONG PendingCount;
+    ULONG ClassPendingCount[BLOCK_QUEUE_CLASS_COUNT];
+    ULONG PlugCount;
+    LIST_ENTRY SortedListHead;
+    LIST_ENTRY FifoListHead[BLOCK_QUEUE_CLASS_COUNT][2];
+    IO_OFFSET HeadOffset;
+    ULONGLONG BusyTime;
+    PROCESS_ID LastProcessId;
+    ULONG ProcessRunCount;
+    IO_BLOCK_DEVICE_STATISTICS Statistics;
+};
+
+/*++
+
+Structure Description:
+
+    This structure defines a single request in a block queue. These live on
+    the submitting thread's stack.
+
+Members:
+
+    SortListEntry - Stores pointers to the next and previous requests in the
+        queue's sorted list. When the request is merged into another one, this
+        links it into the carrying request's merge list instead.
+
+    FifoListEntry - Stores pointers to the next and previous requests in the
+        queue's arrival order list for the request's class and direction.
+
+    MergeListHead - Stores the list of requests merged into this one, in
+        offset order.
+
+    WaitQueue - Stores the wait queue the submitting thread blocks on.
+
+    State - Stores the state of the request.
+
+    Status - Stores the completion status of the request.
+
+    Write - Stores a boolean indicating if this is a write (TRUE) or a read
+        (FALSE).
+
+    Parameters - Stores a pointer to the submitter's read/write parameters.
+
+    Class - Stores the queue's index for the I/O priority class of the
+        request.
+
+    ProcessId - Stores the ID of the process that submitted the request.
+
+    Offset - Stores the starting offset of the request, including any merged
+        requests in front of it.
+
+    Size - Stores the size of the request, including any merged requests.
+
+    SubmitTime - Stores the time counter value when the request was queued.
+
+    Deadline - Stores the time counter value by which the deadline scheduler
+        tries to issue the request.
+
+--*/
+
+typedef struct _BLOCK_REQUEST {
+    LIST_ENTRY SortListEntry;
+    LIST_ENTRY FifoListEntry;
+    LIST_ENTRY MergeListHead;
+    WAIT_QUEUE WaitQueue;
+    BLOCK_REQUEST_STATE State;
+    KSTATUS Status;
+    BOOL Write;
+    PIRP_READ_WRITE Parameters;
+    ULONG Class;
+    PROCESS_ID ProcessId;
+    IO_OFFSET Offset;
+    UINTN Size;
+    ULONGLONG SubmitTime;
+    ULONGLONG Deadline;
+} BLOCK_REQUEST, *PBLOCK_REQUEST;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+PBLOCK_QUEUE
+IopGetBlockQueue (
+    PDEVICE Device
+    );
+
+BOOL
+IopMergeBlockRequest (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Request
+    );
+
+BOOL
+IopCanMergeBlockRequests (
+    PBLOCK_REQUEST Request,
+    PBLOCK_REQUEST Other
+    );
+
+VOID
+IopInsertBlockRequest (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Request
+    );
+
+BOOL
+IopStartBlockRequests (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Self,
+    BOOL IgnorePlug
+    );
+
+PBLOCK_REQUEST
+IopSelectBlockRequest (
+    PBLOCK_QUEUE Queue
+    );
+
+PBLOCK_REQUEST
+IopFindOtherProcessRequest (
+    PBLOCK_QUEUE Queue,
+    ULONG Class,
+    PROCESS_ID ProcessId
+    );
+
+KSTATUS
+IopIssueBlockRequest (
+    PDEVICE Device,
+    PBLOCK_REQUEST Request
+    );
+
+VOID
+IopCompleteBlockRequest (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Request,
+    ULONGLONG EndTime,
+    ULONGLONG Frequency
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the list of block queues, used to gather statistics, and the lock
+// that protects it.
+//
+
+LIST_ENTRY IoBlockQueueList;
+PQUEUED_LOCK IoBlockQueueListLock;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+KERNEL_API
+KSTATUS
+IoSetBlockDeviceScheduler (
+    PDEVICE Device,
+    IO_BLOCK_SCHEDULER Scheduler,
+    ULONG QueueDepth
+    )
+
+/*++
+
+Routine Description:
+
+    This routine configures the request queue in front of a block device.
+    Drivers call this to describe their media, usually when the device is
+    started.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+    Scheduler - Supplies the I/O scheduler to use. Supply
+        IoBlockSchedulerDefault to leave the scheduler unchanged. The deadline
+        scheduler sorts requests into a sweep across the disk, which suits
+        rotational media. Flash media has no seek penalty and is best served
+        by the no-op scheduler, which only merges requests.
+
+    QueueDepth - Supplies the number of requests the device can work on at
+        once. Supply 0 to leave the depth unchanged.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the scheduler is not valid.
+
+    STATUS_INSUFFICIENT_RESOURCES if the queue could not be created.
+
+--*/
+
+{
+
+    PBLOCK_QUEUE Queue;
+
+    if (Scheduler >= IoBlockSchedulerCount) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Queue = IopGetBlockQueue(Device);
+    if (Queue == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    KeAcquireQueuedLock(Queue->Lock);
+    if (Scheduler != IoBlockSchedulerDefault) {
+        Queue->Scheduler = Scheduler;
+        Queue->Statistics.Scheduler = Scheduler;
+    }
+
+    if (QueueDepth != 0) {
+        Queue->QueueDepth = QueueDepth;
+        Queue->Statistics.QueueDepth = QueueDepth;
+        IopStartBlockRequests(Queue, NULL, FALSE);
+    }
+
+    KeReleaseQueuedLock(Queue->Lock);
+    return STATUS_SUCCESS;
+}
+
+KERNEL_API
+KSTATUS
+IoPlugBlockDevice (
+    PDEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine plugs a block device's request queue, holding new requests
+    back so that they can be merged and sorted as a batch. Plugging is meant
+    for callers about to generate I/O from several threads at once. The queue
+    is unplugged early once enough requests are waiting, and no request waits
+    behind a plug for longer than a few milliseconds.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PBLOCK_QUEUE Queue;
+
+    Queue = IopGetBlockQueue(Device);
+    if (Queue == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    KeAcquireQueuedLock(Queue->Lock);
+    Queue->PlugCount += 1;
+    KeReleaseQueuedLock(Queue->Lock);
+    return STATUS_SUCCESS;
+}
+
+KERNEL_API
+VOID
+IoUnplugBlockDevice (
+    PDEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a plug taken on a block device's request queue. Once
+    the last plug is released, the requests held back are started.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PBLOCK_QUEUE Queue;
+
+    Queue = Device->BlockQueue;
+
+    ASSERT(Queue != NULL);
+
+    KeAcquireQueuedLock(Queue->Lock);
+
+    ASSERT(Queue->PlugCount != 0);
+
+    Queue->PlugCount -= 1;
+    if (Queue->PlugCount == 0) {
+        IopStartBlockRequests(Queue, NULL, FALSE);
+    }
+
+    KeReleaseQueuedLock(Queue->Lock);
+    return;
+}
+
+KSTATUS
+IopInitializeBlockQueues (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes global support for block device request queues.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    INITIALIZE_LIST_HEAD(&IoBlockQueueList);
+    IoBlockQueueListLock = KeCreateQueuedLock();
+    if (IoBlockQueueListLock == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+ULONG
+IopGetCurrentIoPriority (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the I/O priority that applies to the current thread.
+    This is the thread's own priority if it has one, otherwise its process'
+    priority if that has one, otherwise the best effort default.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the I/O priority of the current thread. The class is never none.
+    With the class in the high bits, a lower value is a more urgent priority.
+
+--*/
+
+{
+
+    ULONG Priority;
+    PKTHREAD Thread;
+
+    Thread = KeGetCurrentThread();
+    Priority = Thread->IoPriority;
+    if (IO_PRIORITY_CLASS(Priority) == IO_PRIORITY_CLASS_NONE) {
+        Priority = Thread->OwningProcess->IoPriority;
+        if (IO_PRIORITY_CLASS(Priority) == IO_PRIORITY_CLASS_NONE) {
+            Priority = IO_PRIORITY_DEFAULT;
+        }
+    }
+
+    return Priority;
+}
+
+BOOL
+IopIsBlockQueueRequest (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCode,
+    PIRP_READ_WRITE Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not an I/O request should go through
+    the device's block request queue.
+
+Arguments:
+
+    Device - Supplies a pointer to the device the request is bound for.
+
+    MinorCode - Supplies the I/O minor code of the request.
+
+    Request - Supplies a pointer to the request parameters.
+
+Return Value:
+
+    TRUE if the request should be queued.
+
+    FALSE if the request should be sent straight to the device.
+
+--*/
+
+{
+
+    if ((Device->Header.Type != ObjectDevice) ||
+        (Request->FileProperties == NULL) ||
+        (Request->FileProperties->Type != IoObjectBlockDevice) ||
+        (Request->IoSizeInBytes == 0)) {
+
+        return FALSE;
+    }
+
+    if ((MinorCode != IrpMinorIoRead) && (MinorCode != IrpMinorIoWrite)) {
+        return FALSE;
+    }
+
+    //
+    // Queues are created the first time a device sees I/O. That needs an
+    // allocation, so leave requests that must not allocate alone until then.
+    //
+
+    if ((Device->BlockQueue == NULL) &&
+        ((Request->IoFlags & IO_FLAG_NO_ALLOCATE) != 0)) {
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+KSTATUS
+IopQueueBlockIo (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCode,
+    PIRP_READ_WRITE Parameters
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends a read or write to a block device through its request
+    queue. It returns once the I/O is complete.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+    MinorCode - Supplies the minor code of the request, either read or write.
+
+    Parameters - Supplies a pointer to the request parameters. On return, the
+        bytes completed and new offset are filled in.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONGLONG EndTime;
+    ULONGLONG Expire;
+    ULONGLONG Frequency;
+    BOOL Issue;
+    ULONG Priority;
+    PBLOCK_QUEUE Queue;
+    BLOCK_REQUEST Request;
+    ULONG Timeout;
+    KSTATUS WaitStatus;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Queue = IopGetBlockQueue(Device);
+    if (Queue == NULL) {
+        return IopDispatchIoIrp(Device, MinorCode, Parameters);
+    }
+
+    RtlZeroMemory(&Request, sizeof(BLOCK_REQUEST));
+    INITIALIZE_LIST_HEAD(&(Request.MergeListHead));
+    ObInitializeWaitQueue(&(Request.WaitQueue), NotSignaled);
+    Request.State = BlockRequestQueued;
+    Request.Status = STATUS_SUCCESS;
+    Request.Write = FALSE;
+    if (MinorCode == IrpMinorIoWrite) {
+        Request.Write = TRUE;
+    }
+
+    //
+    // The deadline depends on the I/O priority. Idle requests have a long
+    // fixed deadline, which is only there to keep them from starving. For
+    // the other classes, more urgent levels get shorter deadlines.
+    //
+
+    Priority = IopGetCurrentIoPriority();
+    Request.Class = BLOCK_QUEUE_CLASS_INDEX(Priority);
+    Request.ProcessId = PsGetCurrentProcess()->Identifiers.ProcessId;
+    if (Request.Class == BLOCK_QUEUE_CLASS_IDLE) {
+        Expire = BLOCK_QUEUE_IDLE_READ_EXPIRE;
+        if (Request.Write != FALSE) {
+            Expire = BLOCK_QUEUE_IDLE_WRITE_EXPIRE;
+        }
+
+    } else {
+        Expire = BLOCK_QUEUE_READ_EXPIRE;
+        if (Request.Write != FALSE) {
+            Expire = BLOCK_QUEUE_WRITE_EXPIRE;
+        }
+
+        Expire = (Expire * (IO_PRIORITY_LEVEL(Priority) + 1)) /
+                 (IO_PRIORITY_DEFAULT_LEVEL + 1);
+    }
+
+    Request.Parameters = Parameters;
+    Request.Offset = Parameters->IoOffset;
+    Request.Size = Parameters->IoSizeInBytes;
+    Frequency = HlQueryTimeCounterFrequency();
+    Request.SubmitTime = HlQueryTimeCounter();
+    Request.Deadline = Request.SubmitTime +
+                       ((Frequency * Expire) / MILLISECONDS_PER_SECOND);
+
+    KeAcquireQueuedLock(Queue->Lock);
+    if (Request.Write != FALSE) {
+        Queue->Statistics.WriteRequests += 1;
+
+    } else {
+        Queue->Statistics.ReadRequests += 1;
+    }
+
+    if (IO_PRIORITY_CLASS(Priority) == IO_PRIORITY_CLASS_REAL_TIME) {
+        Queue->Statistics.RealTimeRequests += 1;
+
+    } else if (IO_PRIORITY_CLASS(Priority) == IO_PRIORITY_CLASS_IDLE) {
+        Queue->Statistics.IdleRequests += 1;
+    }
+
+    Queue->Statistics.QueuedRequestSum += Queue->InFlight +
+                                          Queue->PendingCount;
+
+    if (IopMergeBlockRequest(Queue, &Request) == FALSE) {
+        IopInsertBlockRequest(Queue, &Request);
+        if ((Queue->InFlight + Queue->PendingCount) >
+            Queue->Statistics.MaxQueuedRequests) {
+
+            Queue->Statistics.MaxQueuedRequests = Queue->InFlight +
+                                                  Queue->PendingCount;
+        }
+    }
+
+    Issue = IopStartBlockRequests(Queue, &Request, FALSE);
+    KeReleaseQueuedLock(Queue->Lock);
+
+    //
+    // Wait for the scheduler to pick this request, or for the request that
+    // this one merged into to finish. A plugged queue is waited on with a
+    // timeout, after which the plug is ignored. Idle requests also wait with
+    // a timeout, since nothing else wakes them when the device goes idle.
+    //
+
+    while (Issue == FALSE) {
+        Timeout = WAIT_TIME_INDEFINITE;
+        if (Request.State == BlockRequestQueued) {
+            if (Queue->PlugCount != 0) {
+                Timeout = BLOCK_QUEUE_PLUG_TIMEOUT;
+
+            } else if (Request.Class == BLOCK_QUEUE_CLASS_IDLE) {
+                Timeout = BLOCK_QUEUE_IDLE_DELAY;
+            }
+        }
+
+        WaitStatus = ObWaitOnQueue(&(Request.WaitQueue), 0, Timeout);
+
+        //
+        // Always take the lock after waking. The thread that woke this one
+        // signals with the lock held, so this makes sure it is done with the
+        // request before the request goes out of scope.
+        //
+
+        KeAcquireQueuedLock(Queue->Lock);
+        if ((WaitStatus == STATUS_TIMEOUT) &&
+            (Request.State == BlockRequestQueued)) {
+
+            IopStartBlockRequests(Queue, NULL, TRUE);
+        }
+
+        if (Request.State == BlockRequestDispatched) {
+            Issue = TRUE;
+
+        } else if (Request.State == BlockRequestComplete) {
+            KeReleaseQueuedLock(Queue->Lock);
+            return Request.Status;
+
+        } else {
+            ObSignalQueue(&(Request.WaitQueue), SignalOptionUnsignal);
+        }
+
+        KeReleaseQueuedLock(Queue->Lock);
+    }
+
+    ASSERT(Request.State == BlockRequestDispatched);
+
+    Request.Status = IopIssueBlockRequest(Device, &Request);
+    EndTime = HlQueryTimeCounter();
+    KeAcquireQueuedLock(Queue->Lock);
+
+    ASSERT(Queue->InFlight != 0);
+
+    Queue->InFlight -= 1;
+    if (Request.Class != BLOCK_QUEUE_CLASS_IDLE) {
+        Queue->BusyTime = EndTime;
+    }
+
+    IopCompleteBlockRequest(Queue, &Request, EndTime, Frequency);
+    IopStartBlockRequests(Queue, NULL, FALSE);
+    KeReleaseQueuedLock(Queue->Lock);
+    return Request.Status;
+}
+
+VOID
+IopDestroyBlockQueue (
+    PDEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys the block request queue of a device being
+    destroyed.
+
+Arguments:
+
+    Device - Supplies a pointer to the device.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PBLOCK_QUEUE Queue;
+
+    Queue = Device->BlockQueue;
+    if (Queue == NULL) {
+        return;
+    }
+
+    ASSERT((Queue->InFlight == 0) && (Queue->PendingCount == 0));
+
+    KeAcquireQueuedLock(IoBlockQueueListLock);
+    LIST_REMOVE(&(Queue->ListEntry));
+    KeReleaseQueuedLock(IoBlockQueueListLock);
+    KeDestroyQueuedLock(Queue->Lock);
+    MmFreeNonPagedPool(Queue);
+    Device->BlockQueue = NULL;
+    return;
+}
+
+KSTATUS
+IopGetBlockDeviceStatistics (
+    PVOID Data,
+    PUINTN DataSize,
+    BOOL Set
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the statistics of every block device request queue.
+
+Arguments:
+
+    Data - Supplies a pointer to the data buffer where an array of
+        IO_BLOCK_DEVICE_STATISTICS structures is returned.
+
+    DataSize - Supplies a pointer that on input contains the size of the
+        data buffer. On output, contains the required size of the data buffer.
+
+    Set - Supplies a boolean indicating if this is a get operation (FALSE) or
+        a set operation (TRUE).
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_BUFFER_TOO_SMALL if the buffer was not big enough. The required
+    size is returned.
+
+    STATUS_ACCESS_DENIED for a set operation.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PIO_BLOCK_DEVICE_STATISTICS Entry;
+    PBLOCK_QUEUE Queue;
+    UINTN RequiredSize;
+    KSTATUS Status;
+
+    if (Set != FALSE) {
+        *DataSize = 0;
+        return STATUS_ACCESS_DENIED;
+    }
+
+    Entry = Data;
+    RequiredSize = 0;
+    Status = STATUS_SUCCESS;
+    KeAcquireQueuedLock(IoBlockQueueListLock);
+    CurrentEntry = IoBlockQueueList.Next;
+    while (CurrentEntry != &IoBlockQueueList) {
+        Queue = LIST_VALUE(CurrentEntry, BLOCK_QUEUE, ListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        RequiredSize += sizeof(IO_BLOCK_DEVICE_STATISTICS);
+        if (RequiredSize > *DataSize) {
+            Status = STATUS_BUFFER_TOO_SMALL;
+            continue;
+        }
+
+        KeAcquireQueuedLock(Queue->Lock);
+        RtlCopyMemory(Entry,
+                      &(Queue->Statistics),
+                      sizeof(IO_BLOCK_DEVICE_STATISTICS));
+
+        KeReleaseQueuedLock(Queue->Lock);
+        Entry += 1;
+    }
+
+    KeReleaseQueuedLock(IoBlockQueueListLock);
+    *DataSize = RequiredSize;
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+PBLOCK_QUEUE
+IopGetBlockQueue (
+    PDEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the block request queue for the given device,
+    creating it if necessary. A new queue on a device enumerated by another
+    block device (such as a partition) starts with the parent's settings.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+Return Value:
+
+    Returns a pointer to the queue on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    ULONG Class;
+    PBLOCK_QUEUE NewQueue;
+    PDEVICE Parent;
+    PBLOCK_QUEUE ParentQueue;
+    PBLOCK_QUEUE Queue;
+
+    Queue = Device->BlockQueue;
+    if (Queue != NULL) {
+        return Queue;
+    }
+
+    NewQueue = MmAllocateNonPagedPool(sizeof(BLOCK_QUEUE),
+                                      BLOCK_QUEUE_ALLOCATION_TAG);
+
+    if (NewQueue == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(NewQueue, sizeof(BLOCK_QUEUE));
+    NewQueue->Lock = KeCreateQueuedLock();
+    if (NewQueue->Lock == NULL) {
+        MmFreeNonPagedPool(NewQueue);
+        return NULL;
+    }
+
+    NewQueue->Device = Device;
+    NewQueue->Scheduler = IoBlockSchedulerDeadline;
+    NewQueue->QueueDepth = BLOCK_QUEUE_DEFAULT_DEPTH;
+    INITIALIZE_LIST_HEAD(&(NewQueue->SortedListHead));
+    for (Class = 0; Class < BLOCK_QUEUE_CLASS_COUNT; Class += 1) {
+        INITIALIZE_LIST_HEAD(&(NewQueue->FifoListHead[Class][0]));
+        INITIALIZE_LIST_HEAD(&(NewQueue->FifoListHead[Class][1]));
+    }
+    Parent = Device->ParentDevice;
+    while (Parent != NULL) {
+        ParentQueue = Parent->BlockQueue;
+        if (ParentQueue != NULL) {
+            NewQueue->Scheduler = ParentQueue->Scheduler;
+            NewQueue->QueueDepth = ParentQueue->QueueDepth;
+            break;
+        }
+
+        Parent = Parent->ParentDevice;
+    }
+
+    NewQueue->Statistics.DeviceId = Device->DeviceId;
+    NewQueue->Statistics.Scheduler = NewQueue->Scheduler;
+    NewQueue->Statistics.QueueDepth = NewQueue->QueueDepth;
+    Queue = (PVOID)RtlAtomicCompareExchange(
+                                     (volatile UINTN *)&(Device->BlockQueue),
+                                     (UINTN)NewQueue,
+                                     (UINTN)NULL);
+
+    if (Queue != NULL) {
+        KeDestroyQueuedLock(NewQueue->Lock);
+        MmFreeNonPagedPool(NewQueue);
+        return Queue;
+    }
+
+    KeAcquireQueuedLock(IoBlockQueueListLock);
+    INSERT_BEFORE(&(NewQueue->ListEntry), &IoBlockQueueList);
+    KeReleaseQueuedLock(IoBlockQueueListLock);
+    return NewQueue;
+}
+
+BOOL
+IopMergeBlockRequest (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts to merge a new request into a waiting request that
+    ends right where it starts (a back merge) or starts right where it ends
+    (a front merge). This routine assumes the queue lock is held.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue.
+
+    Request - Supplies a pointer to the new request.
+
+Return Value:
+
+    TRUE if the request was merged. It completes when the request it was
+    merged into does.
+
+    FALSE if the request could not be merged.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PBLOCK_REQUEST Other;
+
+    CurrentEntry = Queue->SortedListHead.Next;
+    while (CurrentEntry != &(Queue->SortedListHead)) {
+        Other = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if (Other->Offset > (Request->Offset + Request->Size)) {
+            break;
+        }
+
+        if (IopCanMergeBlockRequests(Request, Other) == FALSE) {
+            continue;
+        }
+
+        if ((Other->Offset + Other->Size) == Request->Offset) {
+            INSERT_BEFORE(&(Request->SortListEntry), &(Other->MergeListHead));
+            Queue->Statistics.BackMerges += 1;
+
+        } else if ((Request->Offset + Request->Size) == Other->Offset) {
+            INSERT_AFTER(&(Request->SortListEntry), &(Other->MergeListHead));
+            Other->Offset = Request->Offset;
+            Queue->Statistics.FrontMerges += 1;
+
+        } else {
+            continue;
+        }
+
+        Other->Size += Request->Size;
+        Request->State = BlockRequestMerged;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+BOOL
+IopCanMergeBlockRequests (
+    PBLOCK_REQUEST Request,
+    PBLOCK_REQUEST Other
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not a new request could be carried by
+    a waiting request, not counting where the two lie on the disk.
+
+Arguments:
+
+    Request - Supplies a pointer to the new request.
+
+    Other - Supplies a pointer to the waiting request.
+
+Return Value:
+
+    TRUE if the requests are compatible.
+
+    FALSE if they cannot be merged.
+
+--*/
+
+{
+
+    PIRP_READ_WRITE OtherParameters;
+    PIRP_READ_WRITE Parameters;
+
+    Parameters = Request->Parameters;
+    OtherParameters = Other->Parameters;
+    if ((Request->Write != Other->Write) ||
+        (Request->Class != Other->Class) ||
+        (Parameters->DeviceContext != OtherParameters->DeviceContext) ||
+        (Parameters->IoFlags != OtherParameters->IoFlags) ||
+        ((Request->Size + Other->Size) > BLOCK_QUEUE_MAX_MERGE_SIZE)) {
+
+        return FALSE;
+    }
+
+    //
+    // Merged requests are carried through a buffer allocated by the carrying
+    // thread, which also has to reach into every merged buffer. Leave the
+    // paging path and user mode buffers alone.
+    //
+
+    if (((Parameters->IoFlags &
+          (IO_FLAG_NO_ALLOCATE | IO_FLAG_SERVICING_FAULT)) != 0) ||
+        (MmIsIoBufferUserMode(Parameters->IoBuffer) != FALSE) ||
+        (MmIsIoBufferUserMode(OtherParameters->IoBuffer) != FALSE)) {
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+VOID
+IopInsertBlockRequest (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a request to the queue's sorted and arrival order lists.
+    This routine assumes the queue lock is held.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue.
+
+    Request - Supplies a pointer to the new request.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PBLOCK_REQUEST Other;
+
+    CurrentEntry = Queue->SortedListHead.Next;
+    while (CurrentEntry != &(Queue->SortedListHead)) {
+        Other = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+        if (Other->Offset > Request->Offset) {
+            break;
+        }
+
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    INSERT_BEFORE(&(Request->SortListEntry), CurrentEntry);
+    INSERT_BEFORE(&(Request->FifoListEntry),
+                  &(Queue->FifoListHead[Request->Class][Request->Write]));
+
+    Queue->PendingCount += 1;
+    Queue->ClassPendingCount[Request->Class] += 1;
+    return;
+}
+
+BOOL
+IopStartBlockRequests (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Self,
+    BOOL IgnorePlug
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hands waiting requests to their threads while the device has
+    room for them. This routine assumes the queue lock is held.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue.
+
+    Self - Supplies an optional pointer to the calling thread's own request.
+        This request is not signaled if it is picked.
+
+    IgnorePlug - Supplies a boolean indicating whether to start requests even
+        if the queue is plugged.
+
+Return Value:
+
+    TRUE if the caller's own request was picked.
+
+    FALSE otherwise.
+
+--*/
+
+{
+
+    PBLOCK_REQUEST Request;
+    BOOL SelfPicked;
+
+    SelfPicked = FALSE;
+    if ((Queue->PlugCount != 0) &&
+        (IgnorePlug == FALSE) &&
+        (Queue->PendingCount < BLOCK_QUEUE_UNPLUG_THRESHOLD)) {
+
+        return FALSE;
+    }
+
+    while ((Queue->InFlight < Queue->QueueDepth) &&
+           (Queue->PendingCount != 0)) {
+
+        Request = IopSelectBlockRequest(Queue);
+        if (Request == NULL) {
+            break;
+        }
+
+        LIST_REMOVE(&(Request->SortListEntry));
+        LIST_REMOVE(&(Request->FifoListEntry));
+        Queue->PendingCount -= 1;
+        Queue->ClassPendingCount[Request->Class] -= 1;
+        Queue->InFlight += 1;
+        Queue->Statistics.Dispatches += 1;
+        Queue->HeadOffset = Request->Offset + Request->Size;
+        if (Request->Class != BLOCK_QUEUE_CLASS_IDLE) {
+            Queue->BusyTime = HlQueryTimeCounter();
+        }
+
+        if (Request->ProcessId == Queue->LastProcessId) {
+            Queue->ProcessRunCount += 1;
+
+        } else {
+            Queue->LastProcessId = Request->ProcessId;
+            Queue->ProcessRunCount = 1;
+        }
+
+        Request->State = BlockRequestDispatched;
+        if (Request == Self) {
+            SelfPicked = TRUE;
+
+        } else {
+            ObSignalQueue(&(Request->WaitQueue), SignalOptionSignalAll);
+        }
+    }
+
+    return SelfPicked;
+}
+
+PBLOCK_REQUEST
+IopSelectBlockRequest (
+    PBLOCK_QUEUE Queue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine picks the next request to issue. Requests that have waited
+    past their deadline go first, most urgent class first, which is also what
+    keeps lower I/O priority classes from starving. Otherwise the most urgent
+    class with requests waiting is served, with idle class requests held back
+    until the device has had nothing else to do for a little while. Within a
+    class, the no-op scheduler issues requests in arrival order and the
+    deadline scheduler sweeps upward across the disk. A process that has had
+    a run of requests issued yields to other processes in the same class.
+    This routine assumes the queue lock is held and that at least one request
+    is waiting.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue.
+
+Return Value:
+
+    Returns a pointer to the request to issue next.
+
+    NULL if the only requests waiting are idle requests that must wait longer.
+
+--*/
+
+{
+
+    ULONG Class;
+    PLIST_ENTRY CurrentEntry;
+    ULONGLONG CurrentTime;
+    ULONGLONG IdleDelay;
+    ULONG Index;
+    PBLOCK_REQUEST Other;
+    PBLOCK_REQUEST Request;
+
+    ASSERT(Queue->PendingCount != 0);
+
+    CurrentTime = HlQueryTimeCounter();
+    for (Class = 0; Class < BLOCK_QUEUE_CLASS_COUNT; Class += 1) {
+        for (Index = 0; Index < 2; Index += 1) {
+            if (LIST_EMPTY(&(Queue->FifoListHead[Class][Index])) != FALSE) {
+                continue;
+            }
+
+            CurrentEntry = Queue->FifoListHead[Class][Index].Next;
+            Request = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, FifoListEntry);
+            if (Request->Deadline <= CurrentTime) {
+                Queue->Statistics.ExpiredRequests += 1;
+                return Request;
+            }
+        }
+    }
+
+    for (Class = 0; Class < BLOCK_QUEUE_CLASS_COUNT; Class += 1) {
+        if (Queue->ClassPendingCount[Class] != 0) {
+            break;
+        }
+    }
+
+    ASSERT(Class != BLOCK_QUEUE_CLASS_COUNT);
+
+    if (Class == BLOCK_QUEUE_CLASS_IDLE) {
+        IdleDelay = (HlQueryTimeCounterFrequency() * BLOCK_QUEUE_IDLE_DELAY) /
+                    MILLISECONDS_PER_SECOND;
+
+        if ((Queue->InFlight != 0) ||
+            ((CurrentTime - Queue->BusyTime) < IdleDelay)) {
+
+            return NULL;
+        }
+    }
+
+    Request = NULL;
+    if (Queue->Scheduler == IoBlockSchedulerNone) {
+        for (Index = 0; Index < 2; Index += 1) {
+            if (LIST_EMPTY(&(Queue->FifoListHead[Class][Index])) == FALSE) {
+                CurrentEntry = Queue->FifoListHead[Class][Index].Next;
+                Request = LIST_VALUE(CurrentEntry,
+                                     BLOCK_REQUEST,
+                                     FifoListEntry);
+
+                break;
+            }
+        }
+
+    } else {
+
+        ASSERT(Queue->Scheduler == IoBlockSchedulerDeadline);
+
+        //
+        // Continue the sweep from the end of the last request issued, wrapping
+        // back around to the lowest offset at the end of the disk.
+        //
+
+        CurrentEntry = Queue->SortedListHead.Next;
+        while (CurrentEntry != &(Queue->SortedListHead)) {
+            Other = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            if (Other->Class != Class) {
+                continue;
+            }
+
+            if (Request == NULL) {
+                Request = Other;
+            }
+
+            if (Other->Offset >= Queue->HeadOffset) {
+                Request = Other;
+                break;
+            }
+        }
+    }
+
+    ASSERT(Request != NULL);
+
+    if ((Request->ProcessId == Queue->LastProcessId) &&
+        (Queue->ProcessRunCount >= BLOCK_QUEUE_PROCESS_QUANTUM)) {
+
+        Other = IopFindOtherProcessRequest(Queue, Class, Request->ProcessId);
+        if (Other != NULL) {
+            Request = Other;
+        }
+    }
+
+    return Request;
+}
+
+PBLOCK_REQUEST
+IopFindOtherProcessRequest (
+    PBLOCK_QUEUE Queue,
+    ULONG Class,
+    PROCESS_ID ProcessId
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the oldest waiting request in the given class that was
+    submitted by a process other than the given one. This routine assumes the
+    queue lock is held.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue.
+
+    Class - Supplies the queue's index for the I/O priority class to search.
+
+    ProcessId - Supplies the ID of the process to skip.
+
+Return Value:
+
+    Returns a pointer to the oldest request from another process.
+
+    NULL if every waiting request in the class belongs to the given process.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PLIST_ENTRY ListHead;
+    ULONG Index;
+    PBLOCK_REQUEST Oldest;
+    PBLOCK_REQUEST Request;
+
+    Oldest = NULL;
+    for (Index = 0; Index < 2; Index += 1) {
+        ListHead = &(Queue->FifoListHead[Class][Index]);
+        CurrentEntry = ListHead->Next;
+        while (CurrentEntry != ListHead) {
+            Request = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, FifoListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            if (Request->ProcessId == ProcessId) {
+                continue;
+            }
+
+            if ((Oldest == NULL) ||
+                (Request->SubmitTime < Oldest->SubmitTime)) {
+
+                Oldest = Request;
+            }
+
+            break;
+        }
+    }
+
+    return Oldest;
+}
+
+KSTATUS
+IopIssueBlockRequest (
+    PDEVICE Device,
+    PBLOCK_REQUEST Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends a request picked by the scheduler to the device. If
+    other requests were merged into it, they are gathered into a single
+    buffer and sent as one I/O. The results for the merged requests are filled
+    in here, but they are not woken.
+
+Arguments:
+
+    Device - Supplies a pointer to the device.
+
+    Request - Supplies a pointer to the request to issue.
+
+Return Value:
+
+    Returns the status of the carrying request.
+
+--*/
+
+{
+
+    UINTN BufferOffset;
+    UINTN BytesCompleted;
+    PLIST_ENTRY CurrentEntry;
+    PIO_BUFFER MergeBuffer;
+    PBLOCK_REQUEST Merged;
+    IRP_MINOR_CODE MinorCode;
+    IRP_READ_WRITE Parameters;
+    PIRP_READ_WRITE PieceParameters;
+    KSTATUS Status;
+
+    MinorCode = IrpMinorIoRead;
+    if (Request->Write != FALSE) {
+        MinorCode = IrpMinorIoWrite;
+    }
+
+    if (LIST_EMPTY(&(Request->MergeListHead)) != FALSE) {
+        return IopDispatchIoIrp(Device, MinorCode, Request->Parameters);
+    }
+
+    //
+    // Put the carrying request in offset order with the requests merged into
+    // it so that the list describes the whole I/O.
+    //
+
+    CurrentEntry = Request->MergeListHead.Next;
+    while (CurrentEntry != &(Request->MergeListHead)) {
+        Merged = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+        if (Merged->Parameters->IoOffset > Request->Parameters->IoOffset) {
+            break;
+        }
+
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    INSERT_BEFORE(&(Request->SortListEntry), CurrentEntry);
+    MergeBuffer = MmAllocatePagedIoBuffer(Request->Size, 0);
+    if (MergeBuffer == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto IssueBlockRequestEnd;
+    }
+
+    if (Request->Write != FALSE) {
+        BufferOffset = 0;
+        CurrentEntry = Request->MergeListHead.Next;
+        while (CurrentEntry != &(Request->MergeListHead)) {
+            Merged = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            PieceParameters = Merged->Parameters;
+            Status = MmCopyIoBuffer(MergeBuffer,
+                                    BufferOffset,
+                                    PieceParameters->IoBuffer,
+                                    0,
+                                    PieceParameters->IoSizeInBytes);
+
+            if (!KSUCCESS(Status)) {
+                goto IssueBlockRequestEnd;
+            }
+
+            BufferOffset += PieceParameters->IoSizeInBytes;
+        }
+    }
+
+    RtlCopyMemory(&Parameters, Request->Parameters, sizeof(IRP_READ_WRITE));
+    Parameters.IoBuffer = MergeBuffer;
+    Parameters.IoOffset = Request->Offset;
+    Parameters.IoSizeInBytes = Request->Size;
+    Parameters.IoBytesCompleted = 0;
+    Parameters.NewIoOffset = Request->Offset;
+    Status = IopDispatchIoIrp(Device, MinorCode, &Parameters);
+
+    //
+    // Hand each piece the part of the result that covers it.
+    //
+
+    BufferOffset = 0;
+    CurrentEntry = Request->MergeListHead.Next;
+    while (CurrentEntry != &(Request->MergeListHead)) {
+        Merged = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        PieceParameters = Merged->Parameters;
+        BytesCompleted = 0;
+        if (Parameters.IoBytesCompleted > BufferOffset) {
+            BytesCompleted = Parameters.IoBytesCompleted - BufferOffset;
+            if (BytesCompleted > PieceParameters->IoSizeInBytes) {
+                BytesCompleted = PieceParameters->IoSizeInBytes;
+            }
+        }
+
+        Merged->Status = Status;
+        if ((Request->Write == FALSE) && (BytesCompleted != 0)) {
+            Merged->Status = MmCopyIoBuffer(PieceParameters->IoBuffer,
+                                            0,
+                                            MergeBuffer,
+                                            BufferOffset,
+                                            BytesCompleted);
+
+            if (!KSUCCESS(Merged->Status)) {
+                BytesCompleted = 0;
+
+            } else {
+                Merged->Status = Status;
+            }
+        }
+
+        PieceParameters->IoBytesCompleted = BytesCompleted;
+        PieceParameters->NewIoOffset = PieceParameters->IoOffset +
+                                       BytesCompleted;
+
+        BufferOffset += PieceParameters->IoSizeInBytes;
+    }
+
+    Status = STATUS_SUCCESS;
+
+IssueBlockRequestEnd:
+    if (MergeBuffer != NULL) {
+        MmFreeIoBuffer(MergeBuffer);
+    }
+
+    //
+    // If the pieces could not be gathered into one buffer, send them one at
+    // a time.
+    //
+
+    if (!KSUCCESS(Status)) {
+        CurrentEntry = Request->MergeListHead.Next;
+        while (CurrentEntry != &(Request->MergeListHead)) {
+            Merged = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            Merged->Status = IopDispatchIoIrp(Device,
+                                              MinorCode,
+                                              Merged->Parameters);
+        }
+    }
+
+    LIST_REMOVE(&(Request->SortListEntry));
+    return Request->Status;
+}
+
+VOID
+IopCompleteBlockRequest (
+    PBLOCK_QUEUE Queue,
+    PBLOCK_REQUEST Request,
+    ULONGLONG EndTime,
+    ULONGLONG Frequency
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the latency of a finished request and wakes the
+    threads of any requests merged into it. This routine assumes the queue
+    lock is held.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue.
+
+    Request - Supplies a pointer to the finished request.
+
+    EndTime - Supplies the time counter value when the I/O finished.
+
+    Frequency - Supplies the frequency of the time counter.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    ULONGLONG Latency;
+    PBLOCK_REQUEST Merged;
+    PIO_BLOCK_DEVICE_STATISTICS Statistics;
+
+    Statistics = &(Queue->Statistics);
+    Latency = ((EndTime - Request->SubmitTime) * MICROSECONDS_PER_SECOND) /
+              Frequency;
+
+    Statistics->CompletedRequests += 1;
+    Statistics->TotalLatency += Latency;
+    if (Latency > Statistics->MaxLatency) {
+        Statistics->MaxLatency = Latency;
+    }
+
+    CurrentEntry = Request->MergeListHead.Next;
+    while (CurrentEntry != &(Request->MergeListHead)) {
+        Merged = LIST_VALUE(CurrentEntry, BLOCK_REQUEST, SortListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        Latency = ((EndTime - Merged->SubmitTime) * MICROSECONDS_PER_SECOND) /
+                  Frequency;
+
+        Statistics->CompletedRequests += 1;
+        Statistics->TotalLatency += Latency;
+        if (Latency > Statistics->MaxLatency) {
+            Statistics->MaxLatency = Latency;
+        }
+
+        Merged->State = BlockRequestComplete;
+        ObSignalQueue(&(Merged->WaitQueue), SignalOptionSignalAll);
+    }
+
+    Request->State = BlockRequestComplete;
+    return;
+}
+
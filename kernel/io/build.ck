@@ -30,14 +30,19 @@ Module Name:
 
 function build() {
     base_sources = [
+        "aio.c",
         "arb.c",
+        "blockq.c",
         "cachedio.c",
+        "copyfile.c",
         "cstate.c",
         "device.c",
         "devinfo.c",
         "devrem.c",
         "devres.c",
         "driver.c",
+        "evcount.c",
+        "evpoll.c",
         "fileobj.c",
         "filesys.c",
         "flock.c",
@@ -47,11 +52,14 @@ function build() {
         "intrupt.c",
         "iobase.c",
         "iohandle.c",
+        "ioring.c",
+        "iotimer.c",
         "irp.c",
         "mount.c",
         "obfs.c",
         "pagecach.c",
         "path.c",
+        "pcindex.c",
         "perm.c",
         "pipe.c",
         "pminfo.c",
@@ -59,12 +67,15 @@ function build() {
         "pstate.c",
         "pty.c",
         "pwropt.c",
+        "sendfile.c",
         "shmemobj.c",
         "socket.c",
+        "splice.c",
         "stream.c",
         "testhook.c",
         "unsocket.c",
-        "userio.c"
+        "userio.c",
+        "watch.c"
     ];
 
     if ((arch == "armv7") || (arch == "armv6")) {
@@ -37,6 +37,13 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the maximum number of pages a read can span and still be attempted
+// without acquiring the file object lock.
+//
+
+#define IO_LOCKLESS_READ_MAX_PAGES 16
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -100,6 +107,12 @@ typedef struct _IO_WRITE_CONTEXT {
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+KSTATUS
+IopPerformLocklessCachedRead (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext
+    );
+
 KSTATUS
 IopPerformCachedRead (
     PFILE_OBJECT FileObject,
@@ -161,6 +174,31 @@ IopPerformDefaultPartialWrite (
     UINTN IoBufferOffset
     );
 
+ULONG
+IopGetDirectIoBlockSize (
+    PFILE_OBJECT FileObject
+    );
+
+PIO_BUFFER
+IopPrepareDirectIo (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext
+    );
+
+BOOL
+IopIsDirectIoPossible (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext
+    );
+
+KSTATUS
+IopPerformDirectIo (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext,
+    PIO_BUFFER DirectIoBuffer,
+    PVOID DeviceContext
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -198,8 +236,10 @@ Return Value:
 
 {
 
+    PIO_BUFFER DirectIoBuffer;
     PFILE_OBJECT FileObject;
     UINTN FlushCount;
+    BOOL LockHeld;
     BOOL LockHeldExclusive;
     IO_OFFSET OriginalOffset;
     ULONG PageShift;
@@ -232,6 +272,17 @@ Return Value:
 
     IopTrimPageCache(TimidTrim);
 
+    //
+    // Direct I/O needs the caller's buffer pinned. Do that before acquiring
+    // the file object lock, as touching the buffer may fault in pages that
+    // belong to this very file.
+    //
+
+    DirectIoBuffer = NULL;
+    if ((Handle->OpenFlags & OPEN_FLAG_DIRECT) != 0) {
+        DirectIoBuffer = IopPrepareDirectIo(FileObject, IoContext);
+    }
+
     //
     // If this is a write operation, then acquire the file object's lock
     // exclusively and perform the cached write.
@@ -263,13 +314,14 @@ Return Value:
 
                 Status = IopFlushFileObjects(0, 0, &FlushCount);
                 if (!KSUCCESS(Status)) {
-                    return Status;
+                    goto PerformCacheableIoOperationEnd;
                 }
             }
         }
 
         KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
         LockHeldExclusive = TRUE;
+        LockHeld = TRUE;
         if (OriginalOffset == IO_OFFSET_NONE) {
             IoContext->Offset =
                         RtlAtomicOr64((PULONGLONG)&(Handle->CurrentOffset), 0);
@@ -286,7 +338,21 @@ Return Value:
                             &(IoContext->Offset));
         }
 
-        if (IO_IS_FILE_OBJECT_CACHEABLE(FileObject) != FALSE) {
+        //
+        // Let any lockless readers know that the cached data may be changing
+        // underneath them.
+        //
+
+        IopBeginPageCacheIndexUpdate(FileObject->PageCacheIndex);
+        if ((DirectIoBuffer != NULL) &&
+            (IopIsDirectIoPossible(FileObject, IoContext) != FALSE)) {
+
+            Status = IopPerformDirectIo(FileObject,
+                                        IoContext,
+                                        DirectIoBuffer,
+                                        Handle->DeviceContext);
+
+        } else if (IO_IS_FILE_OBJECT_CACHEABLE(FileObject) != FALSE) {
             Status = IopPerformCachedWrite(FileObject, IoContext);
 
         } else {
@@ -295,15 +361,20 @@ Return Value:
                                               Handle->DeviceContext);
         }
 
+        IopEndPageCacheIndexUpdate(FileObject->PageCacheIndex);
+
         TimeType = FileObjectModifiedTime;
 
     //
     // Read operations acquire the file object's lock in shared mode and then
-    // perform the cached read.
+    // perform the cached read, unless the data can be copied out of the cache
+    // without the lock.
     //
 
     } else {
-        KeAcquireSharedExclusiveLockShared(FileObject->Lock);
+        LockHeldExclusive = FALSE;
+        LockHeld = FALSE;
+        Status = STATUS_TRY_AGAIN;
         if (OriginalOffset == IO_OFFSET_NONE) {
             IoContext->Offset =
                         RtlAtomicOr64((PULONGLONG)&(Handle->CurrentOffset), 0);
@@ -311,16 +382,41 @@ Return Value:
             StartOffset = IoContext->Offset;
         }
 
-        LockHeldExclusive = FALSE;
-        if (IO_IS_FILE_OBJECT_CACHEABLE(FileObject) != FALSE) {
-            Status = IopPerformCachedRead(FileObject,
-                                          IoContext,
-                                          &LockHeldExclusive);
+        //
+        // Small reads that are entirely cached can be satisfied without the
+        // file object lock. If that does not work out, fall back to the
+        // locked path, which starts over from scratch. Direct reads skip the
+        // lockless attempt, since they go to the device unless some of the
+        // range is cached.
+        //
 
-        } else {
-            Status = IopPerformNonCachedRead(FileObject,
-                                             IoContext,
-                                             Handle->DeviceContext);
+        if ((DirectIoBuffer == NULL) &&
+            (IO_IS_FILE_OBJECT_CACHEABLE(FileObject) != FALSE)) {
+
+            Status = IopPerformLocklessCachedRead(FileObject, IoContext);
+        }
+
+        if (Status == STATUS_TRY_AGAIN) {
+            KeAcquireSharedExclusiveLockShared(FileObject->Lock);
+            LockHeld = TRUE;
+            if ((DirectIoBuffer != NULL) &&
+                (IopIsDirectIoPossible(FileObject, IoContext) != FALSE)) {
+
+                Status = IopPerformDirectIo(FileObject,
+                                            IoContext,
+                                            DirectIoBuffer,
+                                            Handle->DeviceContext);
+
+            } else if (IO_IS_FILE_OBJECT_CACHEABLE(FileObject) != FALSE) {
+                Status = IopPerformCachedRead(FileObject,
+                                              IoContext,
+                                              &LockHeldExclusive);
+
+            } else {
+                Status = IopPerformNonCachedRead(FileObject,
+                                                 IoContext,
+                                                 Handle->DeviceContext);
+            }
         }
 
         TimeType = FileObjectAccessTime;
@@ -343,7 +439,12 @@ Return Value:
         if ((TimeType == FileObjectModifiedTime) ||
             ((Handle->OpenFlags & OPEN_FLAG_NO_ACCESS_TIME) == 0)) {
 
-            if (LockHeldExclusive == FALSE) {
+            if (LockHeld == FALSE) {
+                KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
+                LockHeldExclusive = TRUE;
+                LockHeld = TRUE;
+
+            } else if (LockHeldExclusive == FALSE) {
                 KeSharedExclusiveLockConvertToExclusive(FileObject->Lock);
                 LockHeldExclusive = TRUE;
             }
@@ -352,11 +453,26 @@ Return Value:
         }
     }
 
-    if (LockHeldExclusive != FALSE) {
-        KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
+    if (LockHeld != FALSE) {
+        if (LockHeldExclusive != FALSE) {
+            KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
+
+        } else {
+            KeReleaseSharedExclusiveLockShared(FileObject->Lock);
+        }
+    }
+
+    if ((IoContext->Write != FALSE) &&
+        (IoContext->BytesCompleted != 0) &&
+        (IoFileWatchCount != 0)) {
 
-    } else {
-        KeReleaseSharedExclusiveLockShared(FileObject->Lock);
+        IopNotifyPathEntryWatches(Handle->PathPoint.PathEntry,
+                                  FILE_WATCH_EVENT_MODIFY);
+    }
+
+PerformCacheableIoOperationEnd:
+    if ((DirectIoBuffer != NULL) && (DirectIoBuffer != IoContext->IoBuffer)) {
+        MmFreeIoBuffer(DirectIoBuffer);
     }
 
     return Status;
@@ -483,6 +599,169 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+KSTATUS
+IopPerformLocklessCachedRead (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts to satisfy a small read entirely from the page cache
+    without acquiring the file object lock. It only succeeds if every page of
+    the read is already cached and no writer or truncate changed the cached
+    data while the copy was in progress.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object for the device or file.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    STATUS_SUCCESS if the read was satisfied.
+
+    STATUS_TRY_AGAIN if the read needs to be performed with the file object
+    lock held. No bytes are reported as completed in this case.
+
+    Other error codes if copying to the destination buffer failed.
+
+--*/
+
+{
+
+    ULONG ByteOffset;
+    PPAGE_CACHE_ENTRY Entries[IO_LOCKLESS_READ_MAX_PAGES];
+    ULONG EntryCount;
+    ULONG EntryIndex;
+    ULONGLONG FileSize;
+    ULONG FoundCount;
+    PPAGE_CACHE_INDEX Index;
+    PIO_BUFFER IoBuffer;
+    IO_OFFSET PageAlignedOffset;
+    ULONG PageShift;
+    ULONG PageSize;
+    ULONG Sequence;
+    UINTN SizeInBytes;
+    KSTATUS Status;
+
+    ASSERT(IO_IS_FILE_OBJECT_CACHEABLE(FileObject) != FALSE);
+
+    IoContext->BytesCompleted = 0;
+    FoundCount = 0;
+    Index = FileObject->PageCacheIndex;
+    IoBuffer = NULL;
+
+    //
+    // An empty destination buffer is waiting to be filled with the page cache
+    // entries themselves. Let the locked path hand them over rather than
+    // copying them here.
+    //
+
+    if (IoContext->IoBuffer->FragmentCount == 0) {
+        return STATUS_TRY_AGAIN;
+    }
+
+    //
+    // An odd sequence number means an update is in progress.
+    //
+
+    Sequence = Index->Sequence;
+    if ((Sequence & 0x1) != 0) {
+        return STATUS_TRY_AGAIN;
+    }
+
+    RtlMemoryBarrier();
+
+    //
+    // Let the locked path deal with reads at or beyond the end of the file.
+    //
+
+    READ_INT64_SYNC(&(FileObject->Properties.FileSize), &FileSize);
+    if (IoContext->Offset >= FileSize) {
+        return STATUS_TRY_AGAIN;
+    }
+
+    SizeInBytes = IoContext->SizeInBytes;
+    if ((FileSize - IoContext->Offset) < SizeInBytes) {
+        SizeInBytes = FileSize - IoContext->Offset;
+    }
+
+    PageShift = MmPageShift();
+    PageSize = MmPageSize();
+    PageAlignedOffset = ALIGN_RANGE_DOWN(IoContext->Offset, PageSize);
+    ByteOffset = REMAINDER(IoContext->Offset, PageSize);
+    if (SizeInBytes >
+        ((IO_LOCKLESS_READ_MAX_PAGES << PageShift) - ByteOffset)) {
+
+        return STATUS_TRY_AGAIN;
+    }
+
+    EntryCount = ALIGN_RANGE_UP(SizeInBytes + ByteOffset, PageSize) >>
+                 PageShift;
+
+    FoundCount = IopLookupPageCacheEntriesLockless(FileObject,
+                                                   PageAlignedOffset,
+                                                   Entries,
+                                                   EntryCount);
+
+    if (FoundCount != EntryCount) {
+        Status = STATUS_TRY_AGAIN;
+        goto PerformLocklessCachedReadEnd;
+    }
+
+    IoBuffer = MmAllocateUninitializedIoBuffer(EntryCount << PageShift, 0);
+    if (IoBuffer == NULL) {
+        Status = STATUS_TRY_AGAIN;
+        goto PerformLocklessCachedReadEnd;
+    }
+
+    for (EntryIndex = 0; EntryIndex < EntryCount; EntryIndex += 1) {
+        MmIoBufferAppendPage(IoBuffer,
+                             Entries[EntryIndex],
+                             NULL,
+                             INVALID_PHYSICAL_ADDRESS);
+    }
+
+    Status = MmCopyIoBuffer(IoContext->IoBuffer,
+                            0,
+                            IoBuffer,
+                            ByteOffset,
+                            SizeInBytes);
+
+    if (!KSUCCESS(Status)) {
+        goto PerformLocklessCachedReadEnd;
+    }
+
+    //
+    // If anything changed the cached data during the copy, the destination
+    // may hold a mix of old and new data. Throw it away and do it again under
+    // the lock.
+    //
+
+    RtlMemoryBarrier();
+    if (Index->Sequence != Sequence) {
+        Status = STATUS_TRY_AGAIN;
+        goto PerformLocklessCachedReadEnd;
+    }
+
+    IoContext->BytesCompleted = SizeInBytes;
+
+PerformLocklessCachedReadEnd:
+    if (IoBuffer != NULL) {
+        MmFreeIoBuffer(IoBuffer);
+    }
+
+    for (EntryIndex = 0; EntryIndex < FoundCount; EntryIndex += 1) {
+        IoPageCacheEntryReleaseReference(Entries[EntryIndex]);
+    }
+
+    return Status;
+}
+
 KSTATUS
 IopPerformCachedRead (
     PFILE_OBJECT FileObject,
@@ -846,8 +1125,10 @@ Return Value:
     ULONG PageByteOffset;
     PPAGE_CACHE_ENTRY PageCacheEntry;
     ULONG PageSize;
+    FILE_PROPERTIES Properties;
     UINTN SizeInBytes;
     KSTATUS Status;
+    SYSTEM_CONTROL_TRUNCATE Truncate;
     IO_WRITE_CONTEXT WriteContext;
     BOOL WriteOutNow;
 
@@ -894,6 +1175,34 @@ Return Value:
                 return STATUS_OUT_OF_BOUNDS;
             }
         }
+
+    //
+    // Dirty data without backing store is never written back, so there is no
+    // later point at which running out of space could be reported. Let the
+    // file system charge for the new size before any pages are dirtied. It
+    // gets a copy of the properties so the file object's size is only updated
+    // as data actually lands.
+    //
+
+    } else if ((FileObject->Flags & FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0) {
+        EndOffset = IoContext->Offset + SizeInBytes;
+        READ_INT64_SYNC(&(FileObject->Properties.FileSize), &FileSize);
+        if (EndOffset > FileSize) {
+            RtlCopyMemory(&Properties,
+                          &(FileObject->Properties),
+                          sizeof(FILE_PROPERTIES));
+
+            Truncate.FileProperties = &Properties;
+            Truncate.DeviceContext = FileObject->DeviceContext;
+            Truncate.NewSize = EndOffset;
+            Status = IopSendSystemControlIrp(FileObject->Device,
+                                             IrpMinorSystemControlTruncate,
+                                             &Truncate);
+
+            if (!KSUCCESS(Status)) {
+                return Status;
+            }
+        }
     }
 
     //
@@ -1563,11 +1872,13 @@ Return Value:
     UINTN CopySize;
     ULONGLONG FileSize;
     ULONG PageSize;
+    BOOL Plugged;
     PIO_BUFFER ReadIoBuffer;
     IO_CONTEXT ReadIoContext;
     KSTATUS Status;
 
     PageSize = MmPageSize();
+    Plugged = FALSE;
     IoContext->BytesCompleted = 0;
 
     ASSERT(KeIsSharedExclusiveLockHeldExclusive(FileObject->Lock) != FALSE);
@@ -1644,7 +1955,25 @@ Return Value:
     ReadIoContext.Flags = IoContext->Flags;
     ReadIoContext.TimeoutInMilliseconds = IoContext->TimeoutInMilliseconds;
     ReadIoContext.Write = FALSE;
+
+    //
+    // Plug the queue around a read ahead so that the misses of other threads
+    // reading nearby are held long enough to merge with it.
+    //
+
+    if ((FileObject->Properties.Type == IoObjectBlockDevice) &&
+        (BlockAlignedSize > PageSize)) {
+
+        if (KSUCCESS(IoPlugBlockDevice(FileObject->Device))) {
+            Plugged = TRUE;
+        }
+    }
+
     Status = IopPerformNonCachedRead(FileObject, &ReadIoContext, NULL);
+    if (Plugged != FALSE) {
+        IoUnplugBlockDevice(FileObject->Device);
+    }
+
     if ((!KSUCCESS(Status)) &&
         ((Status != STATUS_END_OF_FILE) ||
          (ReadIoContext.BytesCompleted == 0))) {
@@ -2424,3 +2753,287 @@ Return Value:
     return Status;
 }
 
+
+ULONG
+IopGetDirectIoBlockSize (
+    PFILE_OBJECT FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the alignment that direct I/O to the given file object
+    must meet. This matches the block size used by the default non-cached
+    routines, so that aligned I/O never needs a bounce buffer.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object.
+
+Return Value:
+
+    Returns the direct I/O alignment, in bytes.
+
+--*/
+
+{
+
+    if (FileObject->Properties.Type == IoObjectBlockDevice) {
+        return FileObject->Properties.BlockSize;
+    }
+
+    return MmPageSize();
+}
+
+PIO_BUFFER
+IopPrepareDirectIo (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine checks whether an I/O request to a handle opened for direct
+    I/O has a suitable buffer and size, and if so pins the caller's buffer so
+    that the device can transfer straight into or out of it. The offset is
+    checked later, once the file object lock is held.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object being read or written.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Returns a pointer to the I/O buffer to hand to the device. If this is not
+    the context's own I/O buffer, the caller must free it.
+
+    NULL if the request has to go through the page cache.
+
+--*/
+
+{
+
+    ULONG BlockSize;
+    PIO_BUFFER_FRAGMENT Fragment;
+    UINTN FragmentIndex;
+    PIO_BUFFER IoBuffer;
+    PIO_BUFFER LockedBuffer;
+    KSTATUS Status;
+
+    if ((IO_IS_FILE_OBJECT_CACHEABLE(FileObject) == FALSE) ||
+        ((FileObject->Properties.Type != IoObjectRegularFile) &&
+         (FileObject->Properties.Type != IoObjectBlockDevice))) {
+
+        return NULL;
+    }
+
+    BlockSize = IopGetDirectIoBlockSize(FileObject);
+    if ((BlockSize == 0) ||
+        (IoContext->SizeInBytes == 0) ||
+        (IS_ALIGNED(IoContext->SizeInBytes, BlockSize) == FALSE)) {
+
+        return NULL;
+    }
+
+    //
+    // Kernel mode buffers are either already locked (as with asynchronous I/O
+    // and I/O rings) or get validated by the device, so they can be handed
+    // down as they are.
+    //
+
+    IoBuffer = IoContext->IoBuffer;
+    if (MmIsIoBufferUserMode(IoBuffer) == FALSE) {
+        return IoBuffer;
+    }
+
+    if ((MmGetIoBufferCurrentOffset(IoBuffer) != 0) ||
+        (MmGetIoBufferSize(IoBuffer) != IoContext->SizeInBytes)) {
+
+        return NULL;
+    }
+
+    for (FragmentIndex = 0;
+         FragmentIndex < IoBuffer->FragmentCount;
+         FragmentIndex += 1) {
+
+        Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+        if ((IS_POINTER_ALIGNED(Fragment->VirtualAddress, BlockSize) ==
+             FALSE) ||
+            (IS_ALIGNED(Fragment->Size, BlockSize) == FALSE)) {
+
+            return NULL;
+        }
+    }
+
+    //
+    // A read fills the caller's memory, so the pages need to be writable.
+    //
+
+    Status = IopLockUserIoBuffer(IoBuffer,
+                                 (IoContext->Write == FALSE),
+                                 &LockedBuffer);
+
+    if (!KSUCCESS(Status)) {
+        return NULL;
+    }
+
+    return LockedBuffer;
+}
+
+BOOL
+IopIsDirectIoPossible (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether a request with a prepared direct I/O
+    buffer can actually bypass the page cache. The offset must be aligned and
+    no part of the range may be cached, so that the device and the cache never
+    hold different data for the same range. Any cached page, clean or dirty,
+    sends the request through the cache instead. This routine assumes the file
+    object lock is held, exclusively for writes.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object.
+
+    IoContext - Supplies a pointer to the I/O context, with its final offset.
+
+Return Value:
+
+    TRUE if the request can be sent directly to the device.
+
+    FALSE if the request has to go through the page cache.
+
+--*/
+
+{
+
+    ULONG BlockSize;
+    ULONGLONG EndPageIndex;
+    ULONGLONG FileSize;
+    PPAGE_CACHE_INDEX Index;
+    PPAGE_CACHE_ENTRY PageCacheEntry;
+    ULONGLONG PageIndex;
+    ULONG PageShift;
+
+    ASSERT(KeIsSharedExclusiveLockHeld(FileObject->Lock) != FALSE);
+    ASSERT((IoContext->Write == FALSE) ||
+           (KeIsSharedExclusiveLockHeldExclusive(FileObject->Lock) != FALSE));
+
+    BlockSize = IopGetDirectIoBlockSize(FileObject);
+    if (IS_ALIGNED(IoContext->Offset, BlockSize) == FALSE) {
+        return FALSE;
+    }
+
+    //
+    // Let the cached path report the end of the file for reads that start
+    // beyond it.
+    //
+
+    if (IoContext->Write == FALSE) {
+        READ_INT64_SYNC(&(FileObject->Properties.FileSize), &FileSize);
+        if (IoContext->Offset >= FileSize) {
+            return FALSE;
+        }
+    }
+
+    Index = FileObject->PageCacheIndex;
+    if (Index->EntryCount == 0) {
+        return TRUE;
+    }
+
+    PageShift = MmPageShift();
+    PageIndex = IoContext->Offset >> PageShift;
+    EndPageIndex = ALIGN_RANGE_UP(IoContext->Offset + IoContext->SizeInBytes,
+                                  MmPageSize()) >> PageShift;
+
+    PageCacheEntry = IopFindNextPageCacheIndexEntry(Index,
+                                                    &PageIndex,
+                                                    PAGE_CACHE_TAG_NONE);
+
+    if ((PageCacheEntry != NULL) && (PageIndex < EndPageIndex)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+KSTATUS
+IopPerformDirectIo (
+    PFILE_OBJECT FileObject,
+    PIO_CONTEXT IoContext,
+    PIO_BUFFER DirectIoBuffer,
+    PVOID DeviceContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs a read or write that bypasses the page cache,
+    transferring data between the backing device and the pinned buffer. It is
+    assumed that the file lock is held.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+    DirectIoBuffer - Supplies a pointer to the buffer to hand to the device,
+        which describes the same memory as the context's I/O buffer.
+
+    DeviceContext - Supplies a pointer to the device context to use when
+        accessing the backing device.
+
+Return Value:
+
+    Status code. A failing status code does not necessarily mean no I/O made it
+    in or out. Check the bytes completed value in the I/O context to find out
+    how much occurred.
+
+--*/
+
+{
+
+    IO_CONTEXT DirectContext;
+    ULONGLONG FileSize;
+    KSTATUS Status;
+
+    RtlCopyMemory(&DirectContext, IoContext, sizeof(IO_CONTEXT));
+    DirectContext.IoBuffer = DirectIoBuffer;
+    DirectContext.BytesCompleted = 0;
+    if (IoContext->Write != FALSE) {
+        Status = IopPerformNonCachedWrite(FileObject,
+                                          &DirectContext,
+                                          DeviceContext);
+
+    } else {
+        Status = IopPerformNonCachedRead(FileObject,
+                                         &DirectContext,
+                                         DeviceContext);
+
+        //
+        // The device transfers whole blocks, so do not report anything past
+        // the end of the file as read.
+        //
+
+        READ_INT64_SYNC(&(FileObject->Properties.FileSize), &FileSize);
+        if ((IoContext->Offset + DirectContext.BytesCompleted) > FileSize) {
+            DirectContext.BytesCompleted = FileSize - IoContext->Offset;
+        }
+    }
+
+    IoContext->BytesCompleted = DirectContext.BytesCompleted;
+    return Status;
+}
@@ -0,0 +1,354 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    copyfile.c
+
+Abstract:
+
+    This module implements support for copying a range of one file into
+    another within the kernel. The source's page cache entries are handed to
+    the destination's write path directly, so the data is copied once, from
+    the source page to the destination page.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the maximum number of bytes copied per iteration of a file copy.
+// This bounds the number of source page cache entries pinned at once, while
+// being large enough that the destination write path sees long runs of full
+// pages.
+//
+
+#define IO_COPY_FILE_RANGE_CHUNK_SIZE (256 * _1KB)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCopyFileRange (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for copying a range of one file
+    into another.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or the number of bytes copied (a positive integer) on
+    success.
+
+    Error status code (a negative integer) on failure.
+
+--*/
+
+{
+
+    UINTN BytesCopied;
+    PKPROCESS CurrentProcess;
+    PIO_HANDLE Destination;
+    PIO_OFFSET DestinationOffset;
+    PSYSTEM_CALL_COPY_FILE_RANGE Parameters;
+    INTN Result;
+    PIO_HANDLE Source;
+    PIO_OFFSET SourceOffset;
+    KSTATUS Status;
+
+    CurrentProcess = PsGetCurrentProcess();
+    Parameters = (PSYSTEM_CALL_COPY_FILE_RANGE)SystemCallParameter;
+    BytesCopied = 0;
+    Source = NULL;
+    Destination = ObGetHandleValue(CurrentProcess->HandleTable,
+                                   Parameters->Destination,
+                                   NULL);
+
+    if (Destination == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysCopyFileRangeEnd;
+    }
+
+    Source = ObGetHandleValue(CurrentProcess->HandleTable,
+                              Parameters->Source,
+                              NULL);
+
+    if (Source == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysCopyFileRangeEnd;
+    }
+
+    if (Parameters->Size < 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCopyFileRangeEnd;
+    }
+
+    DestinationOffset = NULL;
+    if (Parameters->DestinationOffset != IO_OFFSET_NONE) {
+        if (Parameters->DestinationOffset < 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto SysCopyFileRangeEnd;
+        }
+
+        DestinationOffset = &(Parameters->DestinationOffset);
+    }
+
+    SourceOffset = NULL;
+    if (Parameters->SourceOffset != IO_OFFSET_NONE) {
+        if (Parameters->SourceOffset < 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto SysCopyFileRangeEnd;
+        }
+
+        SourceOffset = &(Parameters->SourceOffset);
+    }
+
+    Status = IoCopyFileRange(Destination,
+                             DestinationOffset,
+                             Source,
+                             SourceOffset,
+                             Parameters->Size,
+                             Parameters->Flags,
+                             &BytesCopied);
+
+SysCopyFileRangeEnd:
+    if (Destination != NULL) {
+        IoIoHandleReleaseReference(Destination);
+    }
+
+    if (Source != NULL) {
+        IoIoHandleReleaseReference(Source);
+    }
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = STATUS_RESTART_AFTER_SIGNAL;
+    }
+
+    Result = Status;
+    if (KSUCCESS(Status)) {
+
+        ASSERT(BytesCopied <= (UINTN)MAX_INTN);
+
+        Result = (INTN)BytesCopied;
+    }
+
+    return Result;
+}
+
+KERNEL_API
+KSTATUS
+IoCopyFileRange (
+    PIO_HANDLE Destination,
+    PIO_OFFSET DestinationOffset,
+    PIO_HANDLE Source,
+    PIO_OFFSET SourceOffset,
+    UINTN SizeInBytes,
+    ULONG Flags,
+    PUINTN BytesCopied
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies a range of one regular file into another without
+    staging the data in a caller supplied buffer. If the source is cacheable,
+    its page cache entries are referenced into the I/O buffer handed to the
+    destination, so the data is copied only once.
+
+Arguments:
+
+    Destination - Supplies a pointer to the I/O handle of the file to write to.
+
+    DestinationOffset - Supplies an optional pointer to the offset within the
+        destination to write to. On return, this is advanced past the bytes
+        copied. If this is NULL, the destination's current file position is
+        used and updated instead.
+
+    Source - Supplies a pointer to the I/O handle of the file to read from.
+
+    SourceOffset - Supplies an optional pointer to the offset within the
+        source to read from. On return, this is advanced past the bytes
+        copied. If this is NULL, the source's current file position is used
+        and updated instead.
+
+    SizeInBytes - Supplies the number of bytes to copy.
+
+    Flags - Supplies a bitfield of flags. No flags are currently defined, so
+        this must be zero.
+
+    BytesCopied - Supplies a pointer where the number of bytes copied will be
+        returned. This is zero if the source offset is at or beyond the end of
+        the file.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was copied, or if the source offset
+    was at or beyond the end of the file.
+
+    STATUS_INVALID_PARAMETER if flags were supplied, either handle is not a
+    regular file, the destination was opened for appending, or the source and
+    destination ranges overlap within the same file.
+
+    STATUS_FILE_IS_DIRECTORY if either handle is a directory.
+
+    Other error codes if nothing could be copied.
+
+--*/
+
+{
+
+    PFILE_OBJECT DestinationObject;
+    IO_OFFSET DestinationPosition;
+    PFILE_OBJECT SourceObject;
+    IO_OFFSET SourcePosition;
+    KSTATUS Status;
+    UINTN TotalBytes;
+    IO_OFFSET WriteOffset;
+
+    TotalBytes = 0;
+    if (Flags != 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto CopyFileRangeEnd;
+    }
+
+    DestinationObject = Destination->FileObject;
+    SourceObject = Source->FileObject;
+    if ((DestinationObject->Properties.Type == IoObjectRegularDirectory) ||
+        (SourceObject->Properties.Type == IoObjectRegularDirectory)) {
+
+        Status = STATUS_FILE_IS_DIRECTORY;
+        goto CopyFileRangeEnd;
+    }
+
+    if ((DestinationObject->Properties.Type != IoObjectRegularFile) ||
+        (SourceObject->Properties.Type != IoObjectRegularFile) ||
+        ((Destination->OpenFlags & OPEN_FLAG_APPEND) != 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto CopyFileRangeEnd;
+    }
+
+    if (SourceOffset != NULL) {
+        SourcePosition = *SourceOffset;
+
+    } else {
+        Status = IoSeek(Source, SeekCommandNop, 0, &SourcePosition);
+        if (!KSUCCESS(Status)) {
+            goto CopyFileRangeEnd;
+        }
+    }
+
+    if (DestinationOffset != NULL) {
+        DestinationPosition = *DestinationOffset;
+
+    } else {
+        Status = IoSeek(Destination, SeekCommandNop, 0, &DestinationPosition);
+        if (!KSUCCESS(Status)) {
+            goto CopyFileRangeEnd;
+        }
+    }
+
+    //
+    // Copying a file onto itself is only allowed if the ranges are disjoint,
+    // otherwise the copy would read back its own output.
+    //
+
+    if ((DestinationObject == SourceObject) &&
+        ((ULONGLONG)DestinationPosition <
+         (ULONGLONG)SourcePosition + SizeInBytes) &&
+        ((ULONGLONG)SourcePosition <
+         (ULONGLONG)DestinationPosition + SizeInBytes)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto CopyFileRangeEnd;
+    }
+
+    //
+    // Writes go to the destination's current position if no offset was
+    // supplied, which advances it along the way.
+    //
+
+    WriteOffset = IO_OFFSET_NONE;
+    if (DestinationOffset != NULL) {
+        WriteOffset = DestinationPosition;
+    }
+
+    Status = IopTransferFileData(Destination,
+                                 WriteOffset,
+                                 Source,
+                                 SourcePosition,
+                                 SizeInBytes,
+                                 IO_COPY_FILE_RANGE_CHUNK_SIZE,
+                                 WAIT_TIME_INDEFINITE,
+                                 &TotalBytes);
+
+    SourcePosition += TotalBytes;
+    DestinationPosition += TotalBytes;
+    if (DestinationOffset != NULL) {
+        *DestinationOffset = DestinationPosition;
+    }
+
+    if (SourceOffset != NULL) {
+        *SourceOffset = SourcePosition;
+
+    } else if (TotalBytes != 0) {
+        IoSeek(Source, SeekCommandFromBeginning, SourcePosition, NULL);
+    }
+
+CopyFileRangeEnd:
+    *BytesCopied = TotalBytes;
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -80,6 +80,11 @@ IopStartDevice (
     PDEVICE Device
     );
 
+VOID
+IopReportDeviceStarted (
+    PDEVICE Device
+    );
+
 KSTATUS
 IopAddDrivers (
     PDEVICE Device
@@ -112,11 +117,18 @@ IopGetUniqueDeviceId (
 //
 
 //
-// Store a pointer to the device work queue.
+// Store a pointer to the device work queue. It is serviced by several
+// threads, but a given device only ever has one work item in flight.
 //
 
 PWORK_QUEUE IoDeviceWorkQueue;
 
+//
+// Set this to TRUE to print how long each device took to start.
+//
+
+BOOL IoPrintDeviceStartTimes;
+
 //
 // Define the object that roots the device tree.
 //
@@ -2336,6 +2348,11 @@ Return Value:
     IRP_START_DEVICE StartDevice;
     KSTATUS Status;
 
+    if (Device->StartTime == 0) {
+        Device->StartTime = HlQueryTimeCounter();
+        Device->TimelineStart = KeGetBootTimelineTimestamp();
+    }
+
     //
     // Loop until a resting state is achieved.
     //
@@ -2470,6 +2487,7 @@ Return Value:
 
         case DeviceEnumerated:
             IopSetDeviceState(Device, DeviceStarted);
+            IopReportDeviceStarted(Device);
             if (((Device->Flags & DEVICE_FLAG_MOUNTABLE) != 0) &&
                 ((Device->Flags & DEVICE_FLAG_MOUNTED) == 0)) {
 
@@ -2545,6 +2563,51 @@ Return Value:
     return;
 }
 
+VOID
+IopReportDeviceStarted (
+    PDEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records how long a device took to start, adds it to the boot
+    timeline, and prints it if requested.
+
+Arguments:
+
+    Device - Supplies a pointer to the device that just started.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONGLONG Frequency;
+    ULONGLONG Now;
+
+    Now = HlQueryTimeCounter();
+    Device->StartDuration = Now - Device->StartTime;
+    KeRecordBootTimelineEvent(BootTimelineEventDeviceStart,
+                              Device->Header.Name,
+                              Device->TimelineStart,
+                              KeGetBootTimelineTimestamp());
+
+    if (IoPrintDeviceStartTimes != FALSE) {
+        Frequency = HlQueryTimeCounterFrequency();
+        RtlDebugPrint("Device %s started in %I64dms, at %I64dms\n",
+                      Device->Header.Name,
+                      Device->StartDuration * 1000ULL / Frequency,
+                      Now * 1000ULL / Frequency);
+    }
+
+    return;
+}
+
 KSTATUS
 IopAddDrivers (
     PDEVICE Device
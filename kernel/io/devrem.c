@@ -686,6 +686,12 @@ Return Value:
 
     ASSERT(LIST_EMPTY(&(Device->WorkQueue)) != FALSE);
 
+    //
+    // Tear down the block request queue, which should also be empty.
+    //
+
+    IopDestroyBlockQueue(Device);
+
     //
     // Detached the drivers from the device.
     //
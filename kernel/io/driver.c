@@ -387,10 +387,14 @@ Return Value:
     PLOADED_IMAGE DriverImage;
     PKPROCESS KernelProcess;
     ULONG LoadFlags;
+    ULONGLONG LoadStart;
+    BOOL NewDriver;
     KSTATUS Status;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
+    LoadStart = KeGetBootTimelineTimestamp();
+    NewDriver = FALSE;
     LoadFlags = IMAGE_LOAD_FLAG_IGNORE_INTERPRETER |
                 IMAGE_LOAD_FLAG_NO_STATIC_CONSTRUCTORS |
                 IMAGE_LOAD_FLAG_BIND_NOW;
@@ -415,6 +419,10 @@ Return Value:
                     NULL);
 
     if (KSUCCESS(Status)) {
+        if ((DriverImage->Flags & IMAGE_FLAG_INITIALIZED) == 0) {
+            NewDriver = TRUE;
+        }
+
         Status = IopInitializeImages(KernelProcess);
         if (!KSUCCESS(Status)) {
             ImImageReleaseReference(DriverImage);
@@ -429,6 +437,17 @@ Return Value:
 
     *DriverOut = DriverImage->SystemExtension;
 
+    //
+    // Only put the first load of each driver on the boot timeline.
+    //
+
+    if (NewDriver != FALSE) {
+        KeRecordBootTimelineEvent(BootTimelineEventDriverLoad,
+                                  DriverName,
+                                  LoadStart,
+                                  KeGetBootTimelineTimestamp());
+    }
+
 LoadDriverEnd:
     return Status;
 }
@@ -0,0 +1,575 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    evcount.c
+
+Abstract:
+
+    This module implements event counter objects. An event counter is a
+    64-bit value that is read and written through a handle. Writes add to the
+    counter and reads consume it. The counter signals readability whenever it
+    is non-zero, which makes it a cheap way to wake a thread that is waiting
+    in poll without the buffering overhead of a pipe.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an event counter object.
+
+Members:
+
+    Header - Stores the standard object header.
+
+    Lock - Stores a pointer to the lock serializing access to the counter.
+
+    IoState - Stores a pointer to the I/O object state of the event counter's
+        file object. The in event is set whenever the value is non-zero, and
+        the out event is set whenever the value is less than the maximum.
+
+    Value - Stores the current counter value.
+
+    Flags - Stores a bitfield of flags. See EVENT_COUNTER_FLAG_* definitions.
+
+--*/
+
+typedef struct _EVENT_COUNTER {
+    OBJECT_HEADER Header;
+    PQUEUED_LOCK Lock;
+    PIO_OBJECT_STATE IoState;
+    ULONGLONG Value;
+    ULONG Flags;
+} EVENT_COUNTER, *PEVENT_COUNTER;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+IopDestroyEventCounter (
+    PVOID Object
+    );
+
+VOID
+IopUpdateEventCounterState (
+    PEVENT_COUNTER EventCounter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateEventCounter (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event counter object on behalf of user mode.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG HandleFlags;
+    PIO_HANDLE IoHandle;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_CREATE_EVENT_COUNTER Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_CREATE_EVENT_COUNTER)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+
+    ASSERT(Process != PsGetKernelProcess());
+
+    if (((Parameters->OpenFlags &
+          ~(SYS_OPEN_FLAG_NON_BLOCKING |
+            SYS_OPEN_FLAG_CLOSE_ON_EXECUTE)) != 0) ||
+        ((Parameters->Flags & ~EVENT_COUNTER_FLAGS_MASK) != 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateEventCounterEnd;
+    }
+
+    OpenFlags = OPEN_FLAG_CREATE;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_NON_BLOCKING) != 0) {
+        OpenFlags |= OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = IopOpen(FALSE,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ | IO_ACCESS_WRITE,
+                     OpenFlags,
+                     IoObjectEventCounter,
+                     Parameters,
+                     FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE,
+                     &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateEventCounterEnd;
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(Process->HandleTable,
+                            IoHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateEventCounterEnd;
+    }
+
+    IoHandle = NULL;
+
+SysCreateEventCounterEnd:
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopCreateEventCounter (
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event counter object and its file object.
+
+Arguments:
+
+    OverrideParameter - Supplies a pointer to the event counter creation
+        parameters, a PSYSTEM_CALL_CREATE_EVENT_COUNTER.
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    BOOL Created;
+    PEVENT_COUNTER EventCounter;
+    FILE_PROPERTIES FileProperties;
+    PFILE_OBJECT NewFileObject;
+    PSYSTEM_CALL_CREATE_EVENT_COUNTER Parameters;
+    KSTATUS Status;
+    PKTHREAD Thread;
+
+    ASSERT(*FileObject == NULL);
+
+    EventCounter = NULL;
+    NewFileObject = NULL;
+    Parameters = OverrideParameter;
+    if (Parameters == NULL) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto CreateEventCounterEnd;
+    }
+
+    //
+    // Create the object. This reference is transferred to the file object's
+    // special I/O member on success.
+    //
+
+    EventCounter = ObCreateObject(ObjectEventCounter,
+                                  NULL,
+                                  NULL,
+                                  0,
+                                  sizeof(EVENT_COUNTER),
+                                  IopDestroyEventCounter,
+                                  0,
+                                  IO_ALLOCATION_TAG);
+
+    if (EventCounter == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateEventCounterEnd;
+    }
+
+    EventCounter->Value = Parameters->InitialValue;
+    EventCounter->Flags = Parameters->Flags;
+    EventCounter->Lock = KeCreateQueuedLock();
+    if (EventCounter->Lock == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateEventCounterEnd;
+    }
+
+    Thread = KeGetCurrentThread();
+    IopFillOutFilePropertiesForObject(&FileProperties,
+                                      &(EventCounter->Header));
+
+    FileProperties.Permissions = Permissions;
+    FileProperties.Type = IoObjectEventCounter;
+    FileProperties.UserId = Thread->Identity.EffectiveUserId;
+    FileProperties.GroupId = Thread->Identity.EffectiveGroupId;
+    Status = IopCreateOrLookupFileObject(&FileProperties,
+                                         ObGetRootObject(),
+                                         0,
+                                         &NewFileObject,
+                                         &Created);
+
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Release the reference added by filling out the file properties.
+        //
+
+        ObReleaseReference(EventCounter);
+        goto CreateEventCounterEnd;
+    }
+
+    ASSERT(Created != FALSE);
+    ASSERT(NewFileObject->IoState != NULL);
+
+    EventCounter->IoState = NewFileObject->IoState;
+    IopUpdateEventCounterState(EventCounter);
+    NewFileObject->SpecialIo = EventCounter;
+    EventCounter = NULL;
+    *FileObject = NewFileObject;
+    Status = STATUS_SUCCESS;
+
+CreateEventCounterEnd:
+
+    //
+    // On both success and failure, the file object's ready event needs to be
+    // signaled. Other threads may be waiting on the event.
+    //
+
+    if (NewFileObject != NULL) {
+        KeSignalEvent(NewFileObject->ReadyEvent, SignalOptionSignalAll);
+    }
+
+    if (EventCounter != NULL) {
+        ObReleaseReference(EventCounter);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopPerformEventCounterIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads from or writes to an event counter. Reads return the
+    64-bit counter value and writes add a 64-bit value to the counter.
+
+Arguments:
+
+    Handle - Supplies a pointer to the event counter I/O handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    PEVENT_COUNTER EventCounter;
+    ULONG EventsMask;
+    PFILE_OBJECT FileObject;
+    ULONG ReturnedEvents;
+    KSTATUS Status;
+    ULONGLONG TimeCounterFrequency;
+    ULONG TimeoutInMilliseconds;
+    ULONGLONG Value;
+
+    FileObject = Handle->FileObject;
+
+    ASSERT(IoContext->IoBuffer != NULL);
+    ASSERT(FileObject->Properties.Type == IoObjectEventCounter);
+
+    EventCounter = FileObject->SpecialIo;
+    IoContext->BytesCompleted = 0;
+    if (IoContext->SizeInBytes < sizeof(ULONGLONG)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Value = 0;
+    if (IoContext->Write != FALSE) {
+        Status = MmCopyIoBufferData(IoContext->IoBuffer,
+                                    &Value,
+                                    0,
+                                    sizeof(ULONGLONG),
+                                    FALSE);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        if (Value > EVENT_COUNTER_MAX_VALUE) {
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        EventsMask = POLL_EVENT_OUT;
+
+    } else {
+        EventsMask = POLL_EVENT_IN;
+    }
+
+    //
+    // Loop waiting for the counter to be able to satisfy the request. Writes
+    // block if adding the value would overflow the counter, and reads block
+    // while the counter is zero. Another thread can take the counter between
+    // the wake and the lock, so each wait only gets the time remaining until
+    // the original deadline.
+    //
+
+    TimeoutInMilliseconds = IoContext->TimeoutInMilliseconds;
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    while (TRUE) {
+        KeAcquireQueuedLock(EventCounter->Lock);
+        if (IoContext->Write != FALSE) {
+            if ((EVENT_COUNTER_MAX_VALUE - EventCounter->Value) >= Value) {
+                EventCounter->Value += Value;
+                break;
+            }
+
+        } else if (EventCounter->Value != 0) {
+            Value = EventCounter->Value;
+            if ((EventCounter->Flags & EVENT_COUNTER_FLAG_SEMAPHORE) != 0) {
+                Value = 1;
+            }
+
+            //
+            // Copy the value out before consuming it so that nothing is lost
+            // if the caller's buffer is bad.
+            //
+
+            Status = MmCopyIoBufferData(IoContext->IoBuffer,
+                                        &Value,
+                                        0,
+                                        sizeof(ULONGLONG),
+                                        TRUE);
+
+            if (!KSUCCESS(Status)) {
+                KeReleaseQueuedLock(EventCounter->Lock);
+                return Status;
+            }
+
+            EventCounter->Value -= Value;
+            break;
+        }
+
+        KeReleaseQueuedLock(EventCounter->Lock);
+        if (TimeoutInMilliseconds == 0) {
+            if (EndTime != 0) {
+                return STATUS_TIMEOUT;
+            }
+
+            return STATUS_TRY_AGAIN;
+        }
+
+        Status = IoWaitForIoObjectState(EventCounter->IoState,
+                                        EventsMask,
+                                        TRUE,
+                                        TimeoutInMilliseconds,
+                                        &ReturnedEvents);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        if (EndTime != 0) {
+            CurrentTime = KeGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                TimeoutInMilliseconds = 0;
+
+            } else {
+                TimeoutInMilliseconds = ((EndTime - CurrentTime) *
+                                         MILLISECONDS_PER_SECOND) /
+                                        TimeCounterFrequency;
+            }
+        }
+    }
+
+    IopUpdateEventCounterState(EventCounter);
+    KeReleaseQueuedLock(EventCounter->Lock);
+    IoContext->BytesCompleted = sizeof(ULONGLONG);
+    return STATUS_SUCCESS;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopDestroyEventCounter (
+    PVOID Object
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys an event counter object.
+
+Arguments:
+
+    Object - Supplies a pointer to the event counter object being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PEVENT_COUNTER EventCounter;
+
+    EventCounter = Object;
+    if (EventCounter->Lock != NULL) {
+        KeDestroyQueuedLock(EventCounter->Lock);
+    }
+
+    return;
+}
+
+VOID
+IopUpdateEventCounterState (
+    PEVENT_COUNTER EventCounter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets the in and out events of an event counter's I/O object
+    state to reflect its current value. The caller must either hold the
+    counter's lock or be the only user of the counter.
+
+Arguments:
+
+    EventCounter - Supplies a pointer to the event counter.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG ClearEvents;
+    ULONG SetEvents;
+
+    ClearEvents = 0;
+    SetEvents = 0;
+    if (EventCounter->Value != 0) {
+        SetEvents |= POLL_EVENT_IN;
+
+    } else {
+        ClearEvents |= POLL_EVENT_IN;
+    }
+
+    if (EventCounter->Value < EVENT_COUNTER_MAX_VALUE) {
+        SetEvents |= POLL_EVENT_OUT;
+
+    } else {
+        ClearEvents |= POLL_EVENT_OUT;
+    }
+
+    if (ClearEvents != 0) {
+        IoSetIoObjectState(EventCounter->IoState, ClearEvents, FALSE);
+    }
+
+    if (SetEvents != 0) {
+        IoSetIoObjectState(EventCounter->IoState, SetEvents, TRUE);
+    }
+
+    return;
+}
+
@@ -0,0 +1,1375 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    evpoll.c
+
+Abstract:
+
+    This module implements event poll objects. An event poll object holds a
+    persistent set of handles to watch. Rather than scanning every handle on
+    each wait like poll does, the I/O object states of the watched handles
+    push themselves onto the event poll's ready list when their events are
+    set, so the cost of a wait is proportional to the number of ready handles
+    rather than the number of watched handles.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the maximum number of events a single wait call can return.
+//
+
+#define EVENT_POLL_MAX_WAIT_EVENTS 1024
+
+//
+// Define the mask of poll events that can be registered with a watch.
+//
+
+#define EVENT_POLL_WATCH_EVENTS_MASK                                 \
+    (POLL_EVENT_IN | POLL_EVENT_IN_HIGH_PRIORITY | POLL_EVENT_OUT |  \
+     POLL_EVENT_OUT_HIGH_PRIORITY | POLL_EVENT_ERROR |               \
+     POLL_EVENT_DISCONNECTED)
+
+//
+// Define internal event poll watch flags. These must not overlap with the
+// EVENT_POLL_FLAG_* definitions.
+//
+
+//
+// This flag is set if a one-shot watch has fired and has not been re-armed.
+//
+
+#define EVENT_POLL_WATCH_FLAG_DISABLED 0x00000001
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an event poll object.
+
+Members:
+
+    Header - Stores the standard object header.
+
+    WatchLock - Stores a pointer to the lock that serializes adding and
+        removing watches. It is acquired before any async state lock, which
+        is acquired before the event poll lock.
+
+    Lock - Stores a pointer to the lock protecting the ready list, the watch
+        tree, and the mutable fields of each watch. The watch tree can also
+        be read while holding the watch lock.
+
+    IoState - Stores a pointer to the I/O object state of the event poll's
+        file object. The in event is set whenever the ready list is not empty.
+
+    WatchTree - Stores the tree of watches, keyed by descriptor and I/O handle.
+
+    ReadyList - Stores the head of the list of watches that may be ready.
+
+--*/
+
+typedef struct _EVENT_POLL {
+    OBJECT_HEADER Header;
+    PQUEUED_LOCK WatchLock;
+    PQUEUED_LOCK Lock;
+    PIO_OBJECT_STATE IoState;
+    RED_BLACK_TREE WatchTree;
+    LIST_ENTRY ReadyList;
+} EVENT_POLL, *PEVENT_POLL;
+
+/*++
+
+Structure Description:
+
+    This structure defines a single handle watched by an event poll object.
+
+Members:
+
+    TreeNode - Stores the node in the event poll's watch tree.
+
+    AsyncListEntry - Stores pointers to the next and previous watches
+        registered against the same I/O object state. This is protected by the
+        async state lock.
+
+    ReadyListEntry - Stores pointers to the next and previous watches in the
+        event poll's ready list. The next pointer is NULL if the watch is not
+        in the ready list.
+
+    EventPoll - Stores a pointer to the event poll that owns the watch.
+
+    IoHandle - Stores a pointer to the watched I/O handle. No reference is
+        held; the watch is destroyed when the handle is closed.
+
+    IoState - Stores a pointer to the watched I/O object state.
+
+    Async - Stores a pointer to the async state of the watched I/O object
+        state, which holds the list this watch is on.
+
+    Descriptor - Stores the user mode descriptor the watch was registered
+        with.
+
+    Events - Stores the mask of POLL_EVENT_* flags being watched.
+
+    Flags - Stores a bitmask of EVENT_POLL_FLAG_* and EVENT_POLL_WATCH_FLAG_*
+        flags.
+
+    Data - Stores the opaque value returned with each event.
+
+--*/
+
+typedef struct _EVENT_POLL_WATCH {
+    RED_BLACK_TREE_NODE TreeNode;
+    LIST_ENTRY AsyncListEntry;
+    LIST_ENTRY ReadyListEntry;
+    PEVENT_POLL EventPoll;
+    PIO_HANDLE IoHandle;
+    PIO_OBJECT_STATE IoState;
+    PIO_ASYNC_STATE Async;
+    HANDLE Descriptor;
+    ULONG Events;
+    ULONG Flags;
+    ULONGLONG Data;
+} EVENT_POLL_WATCH, *PEVENT_POLL_WATCH;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+IopDestroyEventPoll (
+    PVOID Object
+    );
+
+KSTATUS
+IopControlEventPoll (
+    PEVENT_POLL EventPoll,
+    EVENT_POLL_OPERATION Operation,
+    HANDLE Descriptor,
+    PIO_HANDLE IoHandle,
+    PEVENT_POLL_EVENT Event
+    );
+
+ULONG
+IopHarvestEventPoll (
+    PEVENT_POLL EventPoll,
+    PEVENT_POLL_EVENT Events,
+    ULONG EventCount
+    );
+
+VOID
+IopQueueEventPollWatch (
+    PEVENT_POLL_WATCH Watch
+    );
+
+VOID
+IopUnlinkEventPollWatch (
+    PEVENT_POLL_WATCH Watch
+    );
+
+COMPARISON_RESULT
+IopCompareEventPollWatches (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateEventPoll (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event poll object on behalf of user mode.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG HandleFlags;
+    PIO_HANDLE IoHandle;
+    PSYSTEM_CALL_CREATE_EVENT_POLL Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_CREATE_EVENT_POLL)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+
+    ASSERT(Process != PsGetKernelProcess());
+
+    if ((Parameters->OpenFlags & ~SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateEventPollEnd;
+    }
+
+    Status = IopOpen(FALSE,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ,
+                     OPEN_FLAG_CREATE,
+                     IoObjectEventPoll,
+                     NULL,
+                     FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE,
+                     &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateEventPollEnd;
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(Process->HandleTable,
+                            IoHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateEventPollEnd;
+    }
+
+    IoHandle = NULL;
+
+SysCreateEventPollEnd:
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysEventPollControl (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds, modifies, or removes a handle from the interest set of
+    an event poll object.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PIO_HANDLE EventPollHandle;
+    PIO_HANDLE IoHandle;
+    PSYSTEM_CALL_EVENT_POLL_CONTROL Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_EVENT_POLL_CONTROL)SystemCallParameter;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+    EventPollHandle = ObGetHandleValue(Process->HandleTable,
+                                       Parameters->EventPoll,
+                                       NULL);
+
+    if (EventPollHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysEventPollControlEnd;
+    }
+
+    if (EventPollHandle->FileObject->Properties.Type != IoObjectEventPoll) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysEventPollControlEnd;
+    }
+
+    IoHandle = ObGetHandleValue(Process->HandleTable, Parameters->Handle, NULL);
+    if (IoHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysEventPollControlEnd;
+    }
+
+    Status = IopControlEventPoll(EventPollHandle->FileObject->SpecialIo,
+                                 Parameters->Operation,
+                                 Parameters->Handle,
+                                 IoHandle,
+                                 &(Parameters->Event));
+
+SysEventPollControlEnd:
+    if (IoHandle != NULL) {
+        IoIoHandleReleaseReference(IoHandle);
+    }
+
+    if (EventPollHandle != NULL) {
+        IoIoHandleReleaseReference(EventPollHandle);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysEventPollWait (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for handles in an event poll object's interest set to
+    become ready.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or the number of events returned (a positive integer) on
+    success.
+
+    Error status code (a negative integer) on failure.
+
+--*/
+
+{
+
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    ULONG EventCount;
+    PEVENT_POLL EventPoll;
+    PIO_HANDLE EventPollHandle;
+    PEVENT_POLL_EVENT Events;
+    SIGNAL_SET OldSignalSet;
+    PSYSTEM_CALL_EVENT_POLL_WAIT Parameters;
+    BOOL RestoreSignalMask;
+    INTN Result;
+    ULONG ReturnedCount;
+    SIGNAL_SET SignalMask;
+    KSTATUS Status;
+    PKTHREAD Thread;
+    ULONGLONG TimeCounterFrequency;
+    ULONG TimeoutInMilliseconds;
+
+    Events = NULL;
+    Parameters = (PSYSTEM_CALL_EVENT_POLL_WAIT)SystemCallParameter;
+    RestoreSignalMask = FALSE;
+    ReturnedCount = 0;
+    Thread = KeGetCurrentThread();
+    EventPollHandle = ObGetHandleValue(Thread->OwningProcess->HandleTable,
+                                       Parameters->EventPoll,
+                                       NULL);
+
+    if (EventPollHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysEventPollWaitEnd;
+    }
+
+    if ((EventPollHandle->FileObject->Properties.Type != IoObjectEventPoll) ||
+        (Parameters->Events == NULL) ||
+        (Parameters->EventCount <= 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysEventPollWaitEnd;
+    }
+
+    EventPoll = EventPollHandle->FileObject->SpecialIo;
+    EventCount = Parameters->EventCount;
+    if (EventCount > EVENT_POLL_MAX_WAIT_EVENTS) {
+        EventCount = EVENT_POLL_MAX_WAIT_EVENTS;
+    }
+
+    Events = MmAllocatePagedPool(EventCount * sizeof(EVENT_POLL_EVENT),
+                                 IO_ALLOCATION_TAG);
+
+    if (Events == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto SysEventPollWaitEnd;
+    }
+
+    //
+    // Set the signal mask if supplied.
+    //
+
+    if (Parameters->SignalMask != NULL) {
+        Status = MmCopyFromUserMode(&SignalMask,
+                                    Parameters->SignalMask,
+                                    sizeof(SIGNAL_SET));
+
+        if (!KSUCCESS(Status)) {
+            goto SysEventPollWaitEnd;
+        }
+
+        PsSetSignalMask(&SignalMask, &OldSignalSet);
+        RestoreSignalMask = TRUE;
+    }
+
+    //
+    // Collect whatever is ready, and wait for the ready list to become
+    // non-empty if nothing is. Wake ups can be spurious if the only ready
+    // watches turn out to no longer be ready, so loop, counting each wait
+    // against the same deadline.
+    //
+
+    TimeoutInMilliseconds = Parameters->TimeoutInMilliseconds;
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    while (TRUE) {
+        ReturnedCount = IopHarvestEventPoll(EventPoll, Events, EventCount);
+        if ((ReturnedCount != 0) || (TimeoutInMilliseconds == 0)) {
+            break;
+        }
+
+        Status = IoWaitForIoObjectState(EventPoll->IoState,
+                                        POLL_EVENT_IN,
+                                        TRUE,
+                                        TimeoutInMilliseconds,
+                                        NULL);
+
+        if (!KSUCCESS(Status)) {
+            goto SysEventPollWaitEnd;
+        }
+
+        //
+        // Harvest one last time once the deadline has passed.
+        //
+
+        if (EndTime != 0) {
+            CurrentTime = KeGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                TimeoutInMilliseconds = 0;
+
+            } else {
+                TimeoutInMilliseconds = ((EndTime - CurrentTime) *
+                                         MILLISECONDS_PER_SECOND) /
+                                        TimeCounterFrequency;
+            }
+        }
+    }
+
+    if (ReturnedCount == 0) {
+        Status = STATUS_TIMEOUT;
+        goto SysEventPollWaitEnd;
+    }
+
+    Status = MmCopyToUserMode(Parameters->Events,
+                              Events,
+                              ReturnedCount * sizeof(EVENT_POLL_EVENT));
+
+SysEventPollWaitEnd:
+    if (RestoreSignalMask != FALSE) {
+
+        //
+        // If a signal arrived during the wait, then do not restore the blocked
+        // mask until it gets a chance to be dispatched. Save the old signal
+        // set to be restored during signal dispatch.
+        //
+
+        PsCheckRuntimeTimers(Thread);
+        if (Thread->SignalPending == ThreadSignalPending) {
+            Thread->RestoreSignals = OldSignalSet;
+            Thread->Flags |= THREAD_FLAG_RESTORE_SIGNALS;
+
+        } else {
+            PsSetSignalMask(&OldSignalSet, NULL);
+        }
+    }
+
+    if (Events != NULL) {
+        MmFreePagedPool(Events);
+    }
+
+    if (EventPollHandle != NULL) {
+        IoIoHandleReleaseReference(EventPollHandle);
+    }
+
+    Result = Status;
+    if (KSUCCESS(Result)) {
+        Result = ReturnedCount;
+    }
+
+    return Result;
+}
+
+KSTATUS
+IopCreateEventPoll (
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new event poll object and its file object.
+
+Arguments:
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    BOOL Created;
+    PEVENT_POLL EventPoll;
+    FILE_PROPERTIES FileProperties;
+    PFILE_OBJECT NewFileObject;
+    KSTATUS Status;
+    PKTHREAD Thread;
+
+    ASSERT(*FileObject == NULL);
+
+    NewFileObject = NULL;
+
+    //
+    // Create the object. This reference is transferred to the file object's
+    // special I/O member on success.
+    //
+
+    EventPoll = ObCreateObject(ObjectEventPoll,
+                               NULL,
+                               NULL,
+                               0,
+                               sizeof(EVENT_POLL),
+                               IopDestroyEventPoll,
+                               0,
+                               IO_ALLOCATION_TAG);
+
+    if (EventPoll == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateEventPollEnd;
+    }
+
+    RtlRedBlackTreeInitialize(&(EventPoll->WatchTree),
+                              0,
+                              IopCompareEventPollWatches);
+
+    INITIALIZE_LIST_HEAD(&(EventPoll->ReadyList));
+    EventPoll->WatchLock = KeCreateQueuedLock();
+    EventPoll->Lock = KeCreateQueuedLock();
+    if ((EventPoll->WatchLock == NULL) || (EventPoll->Lock == NULL)) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateEventPollEnd;
+    }
+
+    Thread = KeGetCurrentThread();
+    IopFillOutFilePropertiesForObject(&FileProperties, &(EventPoll->Header));
+    FileProperties.Permissions = Permissions;
+    FileProperties.Type = IoObjectEventPoll;
+    FileProperties.UserId = Thread->Identity.EffectiveUserId;
+    FileProperties.GroupId = Thread->Identity.EffectiveGroupId;
+    Status = IopCreateOrLookupFileObject(&FileProperties,
+                                         ObGetRootObject(),
+                                         0,
+                                         &NewFileObject,
+                                         &Created);
+
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Release the reference added by filling out the file properties.
+        //
+
+        ObReleaseReference(EventPoll);
+        goto CreateEventPollEnd;
+    }
+
+    ASSERT(Created != FALSE);
+    ASSERT(NewFileObject->IoState != NULL);
+
+    EventPoll->IoState = NewFileObject->IoState;
+    NewFileObject->SpecialIo = EventPoll;
+    EventPoll = NULL;
+    *FileObject = NewFileObject;
+    Status = STATUS_SUCCESS;
+
+CreateEventPollEnd:
+
+    //
+    // On both success and failure, the file object's ready event needs to be
+    // signaled. Other threads may be waiting on the event.
+    //
+
+    if (NewFileObject != NULL) {
+        KeSignalEvent(NewFileObject->ReadyEvent, SignalOptionSignalAll);
+    }
+
+    if (EventPoll != NULL) {
+        ObReleaseReference(EventPoll);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopCloseEventPoll (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an event poll handle is closed. It tears down
+    every watch the event poll object has.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PEVENT_POLL EventPoll;
+    PRED_BLACK_TREE_NODE Node;
+    PEVENT_POLL_WATCH Watch;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectEventPoll);
+
+    EventPoll = IoHandle->FileObject->SpecialIo;
+    if (EventPoll == NULL) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // Each watched handle is still open, as closing it must acquire the watch
+    // lock to find its watch in the tree, so the async state is still around.
+    //
+
+    KeAcquireQueuedLock(EventPoll->WatchLock);
+    while (TRUE) {
+        Node = RtlRedBlackTreeGetLowestNode(&(EventPoll->WatchTree));
+        if (Node == NULL) {
+            break;
+        }
+
+        Watch = RED_BLACK_TREE_VALUE(Node, EVENT_POLL_WATCH, TreeNode);
+        KeAcquireQueuedLock(Watch->Async->Lock);
+        IopUnlinkEventPollWatch(Watch);
+        KeReleaseQueuedLock(Watch->Async->Lock);
+        MmFreePagedPool(Watch);
+    }
+
+    KeReleaseQueuedLock(EventPoll->WatchLock);
+    return STATUS_SUCCESS;
+}
+
+VOID
+IopRemoveEventPollWatches (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the given I/O handle from every event poll object
+    watching it. It is called when an I/O handle is closed.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PIO_ASYNC_STATE Async;
+    PLIST_ENTRY CurrentEntry;
+    PEVENT_POLL EventPoll;
+    PRED_BLACK_TREE_NODE FoundNode;
+    PIO_OBJECT_STATE IoState;
+    EVENT_POLL_WATCH SearchWatch;
+    PEVENT_POLL_WATCH Watch;
+
+    IoState = IoHandle->FileObject->IoState;
+    if ((IoState == NULL) || (IoState->Async == NULL)) {
+        return;
+    }
+
+    //
+    // It is safe to check the list without the lock. Watches are only added
+    // by callers holding a reference on the handle, and the handle is being
+    // closed, so none of the watches this routine cares about can appear.
+    //
+
+    Async = IoState->Async;
+    if (LIST_EMPTY(&(Async->EventPollList)) != FALSE) {
+        return;
+    }
+
+    //
+    // Each event poll's watch lock comes before the async state lock, so
+    // find a watch on this handle, drop the async lock, and then look the
+    // watch up again by key under its event poll's watch lock. The event
+    // poll may have been closed in between, taking the watch with it. No new
+    // watches can show up for this handle, so this ends when the list has
+    // none left.
+    //
+
+    SearchWatch.IoHandle = IoHandle;
+    while (TRUE) {
+        EventPoll = NULL;
+        KeAcquireQueuedLock(Async->Lock);
+        CurrentEntry = Async->EventPollList.Next;
+        while (CurrentEntry != &(Async->EventPollList)) {
+            Watch = LIST_VALUE(CurrentEntry, EVENT_POLL_WATCH, AsyncListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            if (Watch->IoHandle == IoHandle) {
+                EventPoll = Watch->EventPoll;
+                SearchWatch.Descriptor = Watch->Descriptor;
+                ObAddReference(EventPoll);
+                break;
+            }
+        }
+
+        KeReleaseQueuedLock(Async->Lock);
+        if (EventPoll == NULL) {
+            break;
+        }
+
+        KeAcquireQueuedLock(EventPoll->WatchLock);
+        KeAcquireQueuedLock(Async->Lock);
+        FoundNode = RtlRedBlackTreeSearch(&(EventPoll->WatchTree),
+                                          &(SearchWatch.TreeNode));
+
+        if (FoundNode != NULL) {
+            Watch = RED_BLACK_TREE_VALUE(FoundNode, EVENT_POLL_WATCH, TreeNode);
+            IopUnlinkEventPollWatch(Watch);
+            MmFreePagedPool(Watch);
+        }
+
+        KeReleaseQueuedLock(Async->Lock);
+        KeReleaseQueuedLock(EventPoll->WatchLock);
+        ObReleaseReference(EventPoll);
+    }
+
+    return;
+}
+
+VOID
+IopNotifyEventPolls (
+    PIO_ASYNC_STATE Async,
+    ULONG Events
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues every event poll watch interested in the given events
+    onto its event poll's ready list. It is called when events are set in an
+    I/O object state.
+
+Arguments:
+
+    Async - Supplies a pointer to the async state of the I/O object state
+        whose events were set.
+
+    Events - Supplies the mask of events that were just set.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PEVENT_POLL_WATCH Watch;
+
+    KeAcquireQueuedLock(Async->Lock);
+    CurrentEntry = Async->EventPollList.Next;
+    while (CurrentEntry != &(Async->EventPollList)) {
+        Watch = LIST_VALUE(CurrentEntry, EVENT_POLL_WATCH, AsyncListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if ((Events & (Watch->Events | POLL_NONMASKABLE_EVENTS)) != 0) {
+            IopQueueEventPollWatch(Watch);
+        }
+    }
+
+    KeReleaseQueuedLock(Async->Lock);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopDestroyEventPoll (
+    PVOID Object
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys an event poll object.
+
+Arguments:
+
+    Object - Supplies a pointer to the event poll object being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PEVENT_POLL EventPoll;
+
+    EventPoll = Object;
+
+    ASSERT(RtlRedBlackTreeGetLowestNode(&(EventPoll->WatchTree)) == NULL);
+    ASSERT(LIST_EMPTY(&(EventPoll->ReadyList)) != FALSE);
+
+    if (EventPoll->WatchLock != NULL) {
+        KeDestroyQueuedLock(EventPoll->WatchLock);
+    }
+
+    if (EventPoll->Lock != NULL) {
+        KeDestroyQueuedLock(EventPoll->Lock);
+    }
+
+    return;
+}
+
+KSTATUS
+IopControlEventPoll (
+    PEVENT_POLL EventPoll,
+    EVENT_POLL_OPERATION Operation,
+    HANDLE Descriptor,
+    PIO_HANDLE IoHandle,
+    PEVENT_POLL_EVENT Event
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds, modifies, or removes a watch on an event poll object.
+
+Arguments:
+
+    EventPoll - Supplies a pointer to the event poll object.
+
+    Operation - Supplies the operation to perform.
+
+    Descriptor - Supplies the user mode descriptor of the handle.
+
+    IoHandle - Supplies a pointer to the I/O handle to watch.
+
+    Event - Supplies a pointer to the events and data to register. This is
+        ignored for delete operations.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the operation is invalid or the handle is an
+    event poll object. Event poll objects cannot be nested.
+
+    STATUS_PERMISSION_DENIED if the handle does not support polling.
+
+    STATUS_FILE_EXISTS if the handle is already being watched on add.
+
+    STATUS_NOT_FOUND if the handle is not being watched on modify or delete.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+--*/
+
+{
+
+    PIO_ASYNC_STATE Async;
+    PRED_BLACK_TREE_NODE FoundNode;
+    PIO_OBJECT_STATE IoState;
+    BOOL LockHeld;
+    PEVENT_POLL_WATCH NewWatch;
+    EVENT_POLL_WATCH SearchWatch;
+    KSTATUS Status;
+    PEVENT_POLL_WATCH Watch;
+
+    LockHeld = FALSE;
+    NewWatch = NULL;
+    if ((Operation != EventPollOperationAdd) &&
+        (Operation != EventPollOperationDelete) &&
+        (Operation != EventPollOperationModify)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto ControlEventPollEnd;
+    }
+
+    if (IoHandle->FileObject->Properties.Type == IoObjectEventPoll) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto ControlEventPollEnd;
+    }
+
+    IoState = IoHandle->FileObject->IoState;
+    if (IoState == NULL) {
+        Status = STATUS_PERMISSION_DENIED;
+        goto ControlEventPollEnd;
+    }
+
+    if (Operation == EventPollOperationAdd) {
+        NewWatch = MmAllocatePagedPool(sizeof(EVENT_POLL_WATCH),
+                                       IO_ALLOCATION_TAG);
+
+        if (NewWatch == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto ControlEventPollEnd;
+        }
+
+        RtlZeroMemory(NewWatch, sizeof(EVENT_POLL_WATCH));
+        Async = IopGetAsyncState(IoState);
+        if (Async == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto ControlEventPollEnd;
+        }
+
+    } else {
+        Async = IoState->Async;
+        if (Async == NULL) {
+            Status = STATUS_NOT_FOUND;
+            goto ControlEventPollEnd;
+        }
+    }
+
+    KeAcquireQueuedLock(EventPoll->WatchLock);
+    KeAcquireQueuedLock(Async->Lock);
+    LockHeld = TRUE;
+    SearchWatch.Descriptor = Descriptor;
+    SearchWatch.IoHandle = IoHandle;
+    FoundNode = RtlRedBlackTreeSearch(&(EventPoll->WatchTree),
+                                      &(SearchWatch.TreeNode));
+
+    Watch = NULL;
+    if (FoundNode != NULL) {
+        Watch = RED_BLACK_TREE_VALUE(FoundNode, EVENT_POLL_WATCH, TreeNode);
+    }
+
+    switch (Operation) {
+    case EventPollOperationAdd:
+        if (Watch != NULL) {
+            Status = STATUS_FILE_EXISTS;
+            goto ControlEventPollEnd;
+        }
+
+        Watch = NewWatch;
+        NewWatch = NULL;
+        Watch->EventPoll = EventPoll;
+        Watch->IoHandle = IoHandle;
+        Watch->IoState = IoState;
+        Watch->Async = Async;
+        Watch->Descriptor = Descriptor;
+        Watch->Events = Event->Events & EVENT_POLL_WATCH_EVENTS_MASK;
+        Watch->Flags = Event->Events & EVENT_POLL_FLAGS_MASK;
+        Watch->Data = Event->Data;
+        KeAcquireQueuedLock(EventPoll->Lock);
+        RtlRedBlackTreeInsert(&(EventPoll->WatchTree), &(Watch->TreeNode));
+        KeReleaseQueuedLock(EventPoll->Lock);
+        INSERT_BEFORE(&(Watch->AsyncListEntry), &(Async->EventPollList));
+        break;
+
+    case EventPollOperationModify:
+        if (Watch == NULL) {
+            Status = STATUS_NOT_FOUND;
+            goto ControlEventPollEnd;
+        }
+
+        KeAcquireQueuedLock(EventPoll->Lock);
+        Watch->Events = Event->Events & EVENT_POLL_WATCH_EVENTS_MASK;
+        Watch->Flags = Event->Events & EVENT_POLL_FLAGS_MASK;
+        Watch->Data = Event->Data;
+        KeReleaseQueuedLock(EventPoll->Lock);
+        break;
+
+    case EventPollOperationDelete:
+        if (Watch == NULL) {
+            Status = STATUS_NOT_FOUND;
+            goto ControlEventPollEnd;
+        }
+
+        IopUnlinkEventPollWatch(Watch);
+        MmFreePagedPool(Watch);
+        Watch = NULL;
+        break;
+
+    default:
+
+        ASSERT(FALSE);
+
+        break;
+    }
+
+    //
+    // If the handle is already ready, put it on the ready list now, as no
+    // future transition may come along to do it.
+    //
+
+    if ((Watch != NULL) &&
+        ((IoState->Events & (Watch->Events | POLL_NONMASKABLE_EVENTS)) != 0)) {
+
+        IopQueueEventPollWatch(Watch);
+    }
+
+    Status = STATUS_SUCCESS;
+
+ControlEventPollEnd:
+    if (LockHeld != FALSE) {
+        KeReleaseQueuedLock(Async->Lock);
+        KeReleaseQueuedLock(EventPoll->WatchLock);
+    }
+
+    if (NewWatch != NULL) {
+        MmFreePagedPool(NewWatch);
+    }
+
+    return Status;
+}
+
+ULONG
+IopHarvestEventPoll (
+    PEVENT_POLL EventPoll,
+    PEVENT_POLL_EVENT Events,
+    ULONG EventCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine collects the ready events from an event poll object without
+    blocking.
+
+Arguments:
+
+    EventPoll - Supplies a pointer to the event poll object.
+
+    Events - Supplies a pointer to an array where the ready events are
+        returned.
+
+    EventCount - Supplies the number of elements in the events array.
+
+Return Value:
+
+    Returns the number of events returned.
+
+--*/
+
+{
+
+    ULONG Count;
+    LIST_ENTRY RequeueList;
+    ULONG ReturnedEvents;
+    PEVENT_POLL_WATCH Watch;
+
+    Count = 0;
+    INITIALIZE_LIST_HEAD(&RequeueList);
+    KeAcquireQueuedLock(EventPoll->Lock);
+    while ((Count < EventCount) &&
+           (LIST_EMPTY(&(EventPoll->ReadyList)) == FALSE)) {
+
+        Watch = LIST_VALUE(EventPoll->ReadyList.Next,
+                           EVENT_POLL_WATCH,
+                           ReadyListEntry);
+
+        LIST_REMOVE(&(Watch->ReadyListEntry));
+        Watch->ReadyListEntry.Next = NULL;
+        if ((Watch->Flags & EVENT_POLL_WATCH_FLAG_DISABLED) != 0) {
+            continue;
+        }
+
+        //
+        // The watch was queued when its events went high, but they may have
+        // been cleared since. Only report what is signaled now.
+        //
+
+        ReturnedEvents = Watch->IoState->Events &
+                         (Watch->Events | POLL_NONMASKABLE_EVENTS);
+
+        if (ReturnedEvents == 0) {
+            continue;
+        }
+
+        Events[Count].Events = ReturnedEvents;
+        Events[Count].Data = Watch->Data;
+        Count += 1;
+
+        //
+        // One-shot watches go dormant until modified. Edge-triggered watches
+        // wait for the next transition. Level-triggered watches go back on
+        // the list so they are checked again next time.
+        //
+
+        if ((Watch->Flags & EVENT_POLL_FLAG_ONE_SHOT) != 0) {
+            Watch->Flags |= EVENT_POLL_WATCH_FLAG_DISABLED;
+
+        } else if ((Watch->Flags & EVENT_POLL_FLAG_EDGE_TRIGGERED) == 0) {
+            INSERT_BEFORE(&(Watch->ReadyListEntry), &RequeueList);
+        }
+    }
+
+    if (LIST_EMPTY(&RequeueList) == FALSE) {
+        APPEND_LIST(&RequeueList, &(EventPoll->ReadyList));
+    }
+
+    //
+    // Clear the event poll's own readiness while holding the lock so that a
+    // watch queued afterwards is guaranteed to set it again.
+    //
+
+    if (LIST_EMPTY(&(EventPoll->ReadyList)) != FALSE) {
+        IoSetIoObjectState(EventPoll->IoState, POLL_EVENT_IN, FALSE);
+    }
+
+    KeReleaseQueuedLock(EventPoll->Lock);
+    return Count;
+}
+
+VOID
+IopQueueEventPollWatch (
+    PEVENT_POLL_WATCH Watch
+    )
+
+/*++
+
+Routine Description:
+
+    This routine puts a watch on its event poll's ready list if it is not
+    already there. The caller must hold the watch's async state lock.
+
+Arguments:
+
+    Watch - Supplies a pointer to the watch to queue.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PEVENT_POLL EventPoll;
+    BOOL Queued;
+
+    EventPoll = Watch->EventPoll;
+    Queued = FALSE;
+    KeAcquireQueuedLock(EventPoll->Lock);
+    if ((Watch->ReadyListEntry.Next == NULL) &&
+        ((Watch->Flags & EVENT_POLL_WATCH_FLAG_DISABLED) == 0)) {
+
+        INSERT_BEFORE(&(Watch->ReadyListEntry), &(EventPoll->ReadyList));
+        Queued = TRUE;
+    }
+
+    KeReleaseQueuedLock(EventPoll->Lock);
+
+    //
+    // The event poll cannot go away while the async state lock is held, as
+    // closing it must acquire that lock to remove this watch.
+    //
+
+    if (Queued != FALSE) {
+        IoSetIoObjectState(EventPoll->IoState, POLL_EVENT_IN, TRUE);
+    }
+
+    return;
+}
+
+VOID
+IopUnlinkEventPollWatch (
+    PEVENT_POLL_WATCH Watch
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from its event poll and its async state. The
+    caller must hold the event poll's watch lock and the watch's async state
+    lock, and is responsible for freeing the watch.
+
+Arguments:
+
+    Watch - Supplies a pointer to the watch to unlink.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PEVENT_POLL EventPoll;
+
+    EventPoll = Watch->EventPoll;
+    KeAcquireQueuedLock(EventPoll->Lock);
+    RtlRedBlackTreeRemove(&(EventPoll->WatchTree), &(Watch->TreeNode));
+    if (Watch->ReadyListEntry.Next != NULL) {
+        LIST_REMOVE(&(Watch->ReadyListEntry));
+        Watch->ReadyListEntry.Next = NULL;
+    }
+
+    KeReleaseQueuedLock(EventPoll->Lock);
+    LIST_REMOVE(&(Watch->AsyncListEntry));
+    Watch->AsyncListEntry.Next = NULL;
+    return;
+}
+
+COMPARISON_RESULT
+IopCompareEventPollWatches (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two event poll watches by descriptor, then by I/O
+    handle. A descriptor may be closed and reused while a duplicate keeps the
+    old handle open, so the descriptor alone is not unique.
+
+Arguments:
+
+    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+
+    FirstNode - Supplies a pointer to the left side of the comparison.
+
+    SecondNode - Supplies a pointer to the second side of the comparison.
+
+Return Value:
+
+    Same if the two nodes have the same value.
+
+    Ascending if the first node is less than the second node.
+
+    Descending if the second node is less than the first node.
+
+--*/
+
+{
+
+    PEVENT_POLL_WATCH First;
+    PEVENT_POLL_WATCH Second;
+
+    First = RED_BLACK_TREE_VALUE(FirstNode, EVENT_POLL_WATCH, TreeNode);
+    Second = RED_BLACK_TREE_VALUE(SecondNode, EVENT_POLL_WATCH, TreeNode);
+    if ((UINTN)First->Descriptor < (UINTN)Second->Descriptor) {
+        return ComparisonResultAscending;
+    }
+
+    if ((UINTN)First->Descriptor > (UINTN)Second->Descriptor) {
+        return ComparisonResultDescending;
+    }
+
+    if ((UINTN)First->IoHandle < (UINTN)Second->IoHandle) {
+        return ComparisonResultAscending;
+    }
+
+    if ((UINTN)First->IoHandle > (UINTN)Second->IoHandle) {
+        return ComparisonResultDescending;
+    }
+
+    return ComparisonResultSame;
+}
+
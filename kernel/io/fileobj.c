@@ -40,10 +40,44 @@ Module Name:
 #define FILE_OBJECT_ALLOCATION_TAG 0x624F6946 // 'bOiF'
 #define FILE_OBJECT_MAX_REFERENCE_COUNT 0x10000000
 
+//
+// Define the number of shards the global file object table is split into.
+// This must be a power of two.
+//
+
+#define FILE_OBJECT_SHARD_SHIFT 6
+#define FILE_OBJECT_SHARD_COUNT (1 << FILE_OBJECT_SHARD_SHIFT)
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure defines one shard of the global file object table.
+
+Members:
+
+    Lock - Stores a pointer to the lock protecting the tree and the orphaned
+        list. It also makes a file object's transition to closing atomic with
+        respect to lookups in this shard.
+
+    Tree - Stores the tree of file objects in this shard, ordered by file ID
+        and device ID.
+
+    OrphanedList - Stores the list of file objects in this shard that failed
+        to close and are waiting to be retried.
+
+--*/
+
+typedef struct _FILE_OBJECT_SHARD {
+    PQUEUED_LOCK Lock;
+    RED_BLACK_TREE Tree;
+    LIST_ENTRY OrphanedList;
+} FILE_OBJECT_SHARD, *PFILE_OBJECT_SHARD;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -61,8 +95,15 @@ IopCompareFileObjectNodes (
     PRED_BLACK_TREE_NODE SecondNode
     );
 
+PFILE_OBJECT_SHARD
+IopGetFileObjectShard (
+    DEVICE_ID DeviceId,
+    FILE_ID FileId
+    );
+
 PFILE_OBJECT
 IopLookupFileObjectByProperties (
+    PFILE_OBJECT_SHARD Shard,
     PFILE_PROPERTIES Properties
     );
 
@@ -78,15 +119,21 @@ IopSendIoSignal (
     ULONG BandEvent
     );
 
+VOID
+IopAddMemoryOnlyFileObject (
+    PFILE_OBJECT FileObject
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 //
-// Store the global tree of file objects.
+// Store the global table of file objects, split into shards by device and
+// file ID so that opens and closes of unrelated files don't contend.
 //
 
-RED_BLACK_TREE IoFileObjectsTree;
+FILE_OBJECT_SHARD IoFileObjectShards[FILE_OBJECT_SHARD_COUNT];
 
 //
 // Store the global list of dirty file objects.
@@ -101,16 +148,13 @@ LIST_ENTRY IoFileObjectsDirtyList;
 PQUEUED_LOCK IoFileObjectsDirtyListLock;
 
 //
-// Store the global list of orphaned file objects.
-//
-
-LIST_ENTRY IoFileObjectsOrphanedList;
-
-//
-// Store a queued lock that protects both the tree and the list.
+// Store the global list of file objects without backing store that have dirty
+// pages, and a boolean indicating that some of them may have been evicted and
+// should be pruned. Both are protected by the dirty list lock.
 //
 
-PQUEUED_LOCK IoFileObjectsLock;
+LIST_ENTRY IoFileObjectsMemoryOnlyList;
+volatile BOOL IoFileObjectsMemoryOnlyPrune;
 
 //
 // Store a lock that can serialize flush operations.
@@ -214,6 +258,17 @@ Return Value:
         }
     }
 
+    //
+    // Let any event poll objects watching this state know about the change.
+    //
+
+    if ((Set != FALSE) &&
+        (IoState->Async != NULL) &&
+        (LIST_EMPTY(&(IoState->Async->EventPollList)) == FALSE)) {
+
+        IopNotifyEventPolls(IoState->Async, Events);
+    }
+
     return;
 }
 
@@ -683,14 +738,24 @@ Return Value:
 
 {
 
-    RtlRedBlackTreeInitialize(&IoFileObjectsTree, 0, IopCompareFileObjectNodes);
-    INITIALIZE_LIST_HEAD(&IoFileObjectsDirtyList);
-    INITIALIZE_LIST_HEAD(&IoFileObjectsOrphanedList);
-    IoFileObjectsLock = KeCreateQueuedLock();
-    if (IoFileObjectsLock == NULL) {
-        return STATUS_INSUFFICIENT_RESOURCES;
+    ULONG Index;
+    PFILE_OBJECT_SHARD Shard;
+
+    for (Index = 0; Index < FILE_OBJECT_SHARD_COUNT; Index += 1) {
+        Shard = &(IoFileObjectShards[Index]);
+        RtlRedBlackTreeInitialize(&(Shard->Tree),
+                                  0,
+                                  IopCompareFileObjectNodes);
+
+        INITIALIZE_LIST_HEAD(&(Shard->OrphanedList));
+        Shard->Lock = KeCreateQueuedLock();
+        if (Shard->Lock == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
     }
 
+    INITIALIZE_LIST_HEAD(&IoFileObjectsDirtyList);
+    INITIALIZE_LIST_HEAD(&IoFileObjectsMemoryOnlyList);
     IoFileObjectsDirtyListLock = KeCreateQueuedLock();
     if (IoFileObjectsDirtyListLock == NULL) {
         return STATUS_INSUFFICIENT_RESOURCES;
@@ -753,6 +818,7 @@ Return Value:
     BOOL LockHeld;
     PFILE_OBJECT NewObject;
     PFILE_OBJECT Object;
+    PFILE_OBJECT_SHARD Shard;
     KSTATUS Status;
 
     ASSERT(Properties->DeviceId != 0);
@@ -762,22 +828,23 @@ Return Value:
     LockHeld = FALSE;
     NewObject = NULL;
     Object = NULL;
+    Shard = IopGetFileObjectShard(Properties->DeviceId, Properties->FileId);
     while (TRUE) {
 
         //
         // See if the file object already exists.
         //
 
-        KeAcquireQueuedLock(IoFileObjectsLock);
+        KeAcquireQueuedLock(Shard->Lock);
         LockHeld = TRUE;
-        Object = IopLookupFileObjectByProperties(Properties);
+        Object = IopLookupFileObjectByProperties(Shard, Properties);
         if (Object == NULL) {
 
             //
             // There's no object, so drop the lock and go allocate one.
             //
 
-            KeReleaseQueuedLock(IoFileObjectsLock);
+            KeReleaseQueuedLock(Shard->Lock);
             LockHeld = FALSE;
             if (NewObject == NULL) {
                 NewObject = MmAllocatePagedPool(sizeof(FILE_OBJECT),
@@ -789,11 +856,14 @@ Return Value:
                 }
 
                 RtlZeroMemory(NewObject, sizeof(FILE_OBJECT));
-                INITIALIZE_LIST_HEAD(&(NewObject->FileLockList));
+                INITIALIZE_LIST_HEAD(&(NewObject->FileLockWaitList));
                 INITIALIZE_LIST_HEAD(&(NewObject->DirtyPageList));
-                RtlRedBlackTreeInitialize(&(NewObject->PageCacheTree),
-                                          0,
-                                          IopComparePageCacheEntries);
+                INITIALIZE_LIST_HEAD(&(NewObject->WatchListHead));
+                NewObject->PageCacheIndex = IopCreatePageCacheIndex();
+                if (NewObject->PageCacheIndex == NULL) {
+                    Status = STATUS_INSUFFICIENT_RESOURCES;
+                    goto CreateOrLookupFileObjectEnd;
+                }
 
                 NewObject->Lock = KeCreateSharedExclusiveLock();
                 if (NewObject->Lock == NULL) {
@@ -815,6 +885,18 @@ Return Value:
                     goto CreateOrLookupFileObjectEnd;
                 }
 
+                //
+                // Files on volumes that keep everything in memory inherit
+                // that from the volume.
+                //
+
+                if ((Device->Header.Type == ObjectVolume) &&
+                    ((((PVOLUME)Device)->Flags &
+                      VOLUME_FLAG_NO_BACKING_STORE) != 0)) {
+
+                    Flags |= FILE_OBJECT_FLAG_NO_BACKING_STORE;
+                }
+
                 NewObject->Flags = Flags;
                 NewObject->Device = Device;
                 ObAddReference(Device);
@@ -831,6 +913,12 @@ Return Value:
                 case IoObjectTerminalMaster:
                 case IoObjectTerminalSlave:
                 case IoObjectSharedMemoryObject:
+                case IoObjectEventPoll:
+                case IoObjectEventCounter:
+                case IoObjectTimer:
+                case IoObjectAsyncIoContext:
+                case IoObjectIoRing:
+                case IoObjectFileWatch:
                     break;
 
                 default:
@@ -859,12 +947,11 @@ Return Value:
             // added this entry since the lock was dropped, so check once more.
             //
 
-            KeAcquireQueuedLock(IoFileObjectsLock);
+            KeAcquireQueuedLock(Shard->Lock);
             LockHeld = TRUE;
-            Object = IopLookupFileObjectByProperties(Properties);
+            Object = IopLookupFileObjectByProperties(Shard, Properties);
             if (Object == NULL) {
-                RtlRedBlackTreeInsert(&IoFileObjectsTree,
-                                      &(NewObject->TreeEntry));
+                RtlRedBlackTreeInsert(&(Shard->Tree), &(NewObject->TreeEntry));
 
                 ASSERT(NewObject->ListEntry.Next == NULL);
 
@@ -874,7 +961,7 @@ Return Value:
             }
         }
 
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeReleaseQueuedLock(Shard->Lock);
         LockHeld = FALSE;
 
         //
@@ -912,7 +999,7 @@ Return Value:
 
 CreateOrLookupFileObjectEnd:
     if (LockHeld != FALSE) {
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeReleaseQueuedLock(Shard->Lock);
     }
 
     if (!KSUCCESS(Status)) {
@@ -928,6 +1015,10 @@ Return Value:
 
         ASSERT(NewObject->ListEntry.Next == NULL);
 
+        if (NewObject->PageCacheIndex != NULL) {
+            IopDestroyPageCacheIndex(NewObject->PageCacheIndex);
+        }
+
         if (NewObject->Lock != NULL) {
             KeDestroySharedExclusiveLock(NewObject->Lock);
         }
@@ -1021,22 +1112,50 @@ Return Value:
     PDEVICE Device;
     IRP_MINOR_CODE MinorCode;
     ULONG OldCount;
+    ULONG PreviousCount;
+    PFILE_OBJECT_SHARD Shard;
     KSTATUS Status;
 
     Status = STATUS_SUCCESS;
 
     //
-    // Acquire the lock before decrementing the reference count. This is needed
-    // to make the "decrement reference count, signal event, set closing"
-    // operation atomic. If it weren't, people could increment the reference
-    // count thinking the file object was good to use, and then this function
-    // would close it down on them. It's assumed that people calling add
-    // reference on the file object already had some other valid reference,
-    // otherwise the global lock would have to be acquired in the add reference
-    // routine as well.
+    // Releasing a reference that leaves more than the tree's reference and
+    // one other behind cannot start the close, so it doesn't need the lock.
+    // Lookups only ever add references, so once the count is seen above two
+    // a successful compare exchange is safe.
+    //
+
+    OldCount = Object->ReferenceCount;
+    while (OldCount > 2) {
+
+        ASSERT(OldCount < FILE_OBJECT_MAX_REFERENCE_COUNT);
+
+        PreviousCount = RtlAtomicCompareExchange32(&(Object->ReferenceCount),
+                                                   OldCount - 1,
+                                                   OldCount);
+
+        if (PreviousCount == OldCount) {
+            return STATUS_SUCCESS;
+        }
+
+        OldCount = PreviousCount;
+    }
+
+    //
+    // Acquire the shard lock before decrementing the reference count. This is
+    // needed to make the "decrement reference count, signal event, set
+    // closing" operation atomic. If it weren't, people could increment the
+    // reference count thinking the file object was good to use, and then this
+    // function would close it down on them. It's assumed that people calling
+    // add reference on the file object already had some other valid
+    // reference, otherwise the lock would have to be acquired in the add
+    // reference routine as well.
     //
 
-    KeAcquireQueuedLock(IoFileObjectsLock);
+    Shard = IopGetFileObjectShard(Object->Properties.DeviceId,
+                                  Object->Properties.FileId);
+
+    KeAcquireQueuedLock(Shard->Lock);
     OldCount = RtlAtomicAdd32(&(Object->ReferenceCount), -1);
 
     ASSERT((OldCount != 0) && (OldCount < FILE_OBJECT_MAX_REFERENCE_COUNT));
@@ -1056,7 +1175,7 @@ Return Value:
         //
 
         if ((Object->Flags & FILE_OBJECT_FLAG_CLOSING) != 0) {
-            KeReleaseQueuedLock(IoFileObjectsLock);
+            KeReleaseQueuedLock(Shard->Lock);
             goto FileObjectReleaseReferenceEnd;
         }
 
@@ -1090,7 +1209,7 @@ Return Value:
         //      deadlock with the failed file clean-up.
         //
 
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeReleaseQueuedLock(Shard->Lock);
 
         //
         // As dirty file objects sit on the dirty file object list with a
@@ -1146,13 +1265,13 @@ Return Value:
 
         //
         // The file system is officially disengaged from this file object,
-        // remove the file object from the global tree, allowing new callers to
-        // recreate the file object.
+        // remove the file object from its shard's tree, allowing new callers
+        // to recreate the file object.
         //
 
-        KeAcquireQueuedLock(IoFileObjectsLock);
-        RtlRedBlackTreeRemove(&IoFileObjectsTree, &(Object->TreeEntry));
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeAcquireQueuedLock(Shard->Lock);
+        RtlRedBlackTreeRemove(&(Shard->Tree), &(Object->TreeEntry));
+        KeReleaseQueuedLock(Shard->Lock);
 
         //
         // Now release everyone who got stuck while trying to open this closing
@@ -1169,12 +1288,14 @@ Return Value:
     //
 
     } else if (OldCount == 1) {
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeReleaseQueuedLock(Shard->Lock);
 
         ASSERT(Object->ListEntry.Next == NULL);
         ASSERT((Object->Flags & FILE_OBJECT_FLAG_CLOSING) != 0);
         ASSERT(Object->PathEntryCount == 0);
-        ASSERT(LIST_EMPTY(&(Object->FileLockList)) != FALSE);
+        ASSERT(Object->FileLockTree == NULL);
+        ASSERT(LIST_EMPTY(&(Object->FileLockWaitList)) != FALSE);
+        ASSERT(LIST_EMPTY(&(Object->WatchListHead)) != FALSE);
 
         //
         // If this was an object manager object, release the reference on the
@@ -1198,6 +1319,12 @@ Return Value:
             case IoObjectTerminalMaster:
             case IoObjectTerminalSlave:
             case IoObjectSharedMemoryObject:
+            case IoObjectEventPoll:
+            case IoObjectEventCounter:
+            case IoObjectTimer:
+            case IoObjectAsyncIoContext:
+            case IoObjectIoRing:
+            case IoObjectFileWatch:
                 ObReleaseReference(Object->SpecialIo);
                 break;
 
@@ -1218,8 +1345,12 @@ Return Value:
             MmDestroyImageSectionList(Object->ImageSectionList);
         }
 
-        ASSERT(RED_BLACK_TREE_EMPTY(&(Object->PageCacheTree)));
         ASSERT(LIST_EMPTY(&(Object->DirtyPageList)));
+        ASSERT(Object->MemoryOnlyListEntry.Next == NULL);
+
+        if (Object->PageCacheIndex != NULL) {
+            IopDestroyPageCacheIndex(Object->PageCacheIndex);
+        }
 
         if (Object->Lock != NULL) {
             KeDestroySharedExclusiveLock(Object->Lock);
@@ -1235,10 +1366,6 @@ Return Value:
             KeDestroyEvent(Object->ReadyEvent);
         }
 
-        if (Object->FileLockEvent != NULL) {
-            KeDestroyEvent(Object->FileLockEvent);
-        }
-
         MmFreePagedPool(Object);
         Object = NULL;
 
@@ -1248,7 +1375,7 @@ Return Value:
     //
 
     } else {
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeReleaseQueuedLock(Shard->Lock);
     }
 
 FileObjectReleaseReferenceEnd:
@@ -1269,12 +1396,12 @@ Return Value:
         // orphaned objects.
         //
 
-        KeAcquireQueuedLock(IoFileObjectsLock);
+        KeAcquireQueuedLock(Shard->Lock);
         if (Object->ReferenceCount == 1) {
-            INSERT_BEFORE(&(Object->ListEntry), &IoFileObjectsOrphanedList);
+            INSERT_BEFORE(&(Object->ListEntry), &(Shard->OrphanedList));
         }
 
-        KeReleaseQueuedLock(IoFileObjectsLock);
+        KeReleaseQueuedLock(Shard->Lock);
 
         //
         // The signal event acts as a memory barrier still protecting this
@@ -1406,7 +1533,20 @@ Return Value:
 
     ULONG ClearFlags;
     BOOL Exclusive;
+    ULONG SavedIoPriority;
     KSTATUS Status;
+    PKTHREAD Thread;
+
+    //
+    // Kernel threads writing data back do so on behalf of whoever dirtied it,
+    // so borrow their I/O priority.
+    //
+
+    Thread = KeGetCurrentThread();
+    SavedIoPriority = Thread->IoPriority;
+    if (Thread->OwningProcess == PsGetKernelProcess()) {
+        Thread->IoPriority = FileObject->WritebackIoPriority;
+    }
 
     if (FlushExclusive != FALSE) {
         KeAcquireSharedExclusiveLockExclusive(IoFlushLock);
@@ -1427,6 +1567,26 @@ Return Value:
                      FILE_OBJECT_FLAG_DIRTY_DATA;
 
         RtlAtomicAnd32(&(FileObject->Flags), ~ClearFlags);
+        if ((FileObject->Flags & FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0) {
+            IoFileObjectsMemoryOnlyPrune = TRUE;
+        }
+
+    //
+    // File objects without backing store have nowhere better to put their
+    // data than the page cache, so only push it down when asked to free a
+    // specific number of pages. Make sure the memory-only list is tracking
+    // any dirty pages that got here via the dirty list.
+    //
+
+    } else if (((FileObject->Flags & FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0) &&
+               (PageCount == NULL)) {
+
+        RtlAtomicAnd32(&(FileObject->Flags), ~FILE_OBJECT_FLAG_DIRTY_DATA);
+        IopAddMemoryOnlyFileObject(FileObject);
+        Status = IopFlushFileObjectProperties(FileObject, Flags);
+        if (!KSUCCESS(Status)) {
+            goto FlushFileObjectEnd;
+        }
 
     } else {
         Status = IopFlushPageCacheEntries(FileObject,
@@ -1462,6 +1622,7 @@ Return Value:
         KeReleaseSharedExclusiveLockShared(IoFlushLock);
     }
 
+    Thread->IoPriority = SavedIoPriority;
     return Status;
 }
 
@@ -1665,6 +1826,154 @@ Return Value:
     return TotalStatus;
 }
 
+KSTATUS
+IopFlushMemoryOnlyFileObjects (
+    UINTN PageCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine pushes dirty pages from file objects without backing store
+    down to their file systems so that the page cache can reclaim them. It
+    also drops file objects that no longer have dirty pages from the list.
+
+Arguments:
+
+    PageCount - Supplies the number of pages to push down. Supply 0 to only
+        prune the list.
+
+Return Value:
+
+    STATUS_SUCCESS if there is nothing more to do.
+
+    STATUS_TRY_AGAIN if pages were pushed down and the page cache should trim
+    again before asking for more.
+
+    Other status codes on failure.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PFILE_OBJECT CurrentObject;
+    UINTN FlushLimit;
+    UINTN OriginalCount;
+    PFILE_OBJECT ReleaseObject;
+    KSTATUS Status;
+
+    if ((PageCount == 0) && (IoFileObjectsMemoryOnlyPrune == FALSE)) {
+        return STATUS_SUCCESS;
+    }
+
+    OriginalCount = PageCount;
+    ReleaseObject = NULL;
+    Status = STATUS_SUCCESS;
+    KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
+    IoFileObjectsMemoryOnlyPrune = FALSE;
+
+    //
+    // Visit each file object at most once per call, since flushed entries
+    // rotate to the back of the list.
+    //
+
+    FlushLimit = 0;
+    CurrentEntry = IoFileObjectsMemoryOnlyList.Next;
+    while (CurrentEntry != &IoFileObjectsMemoryOnlyList) {
+        FlushLimit += 1;
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    CurrentEntry = IoFileObjectsMemoryOnlyList.Next;
+    while (CurrentEntry != &IoFileObjectsMemoryOnlyList) {
+        CurrentObject = LIST_VALUE(CurrentEntry,
+                                   FILE_OBJECT,
+                                   MemoryOnlyListEntry);
+
+        //
+        // Drop file objects whose dirty pages have all been written out or
+        // evicted. The list's reference cannot be released with the lock
+        // held, so hang on to it until the next time the lock is dropped.
+        //
+
+        if (LIST_EMPTY(&(CurrentObject->DirtyPageList))) {
+            CurrentEntry = CurrentEntry->Next;
+            LIST_REMOVE(&(CurrentObject->MemoryOnlyListEntry));
+            CurrentObject->MemoryOnlyListEntry.Next = NULL;
+            if (ReleaseObject != NULL) {
+                KeReleaseQueuedLock(IoFileObjectsDirtyListLock);
+                IopFileObjectReleaseReference(ReleaseObject);
+                KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
+                CurrentEntry = IoFileObjectsMemoryOnlyList.Next;
+            }
+
+            ReleaseObject = CurrentObject;
+            continue;
+        }
+
+        if ((PageCount == 0) || (FlushLimit == 0)) {
+            CurrentEntry = CurrentEntry->Next;
+            continue;
+        }
+
+        //
+        // Push this file's pages down. Rotate it to the back of the list so
+        // the next round of pressure picks on someone else first.
+        //
+
+        LIST_REMOVE(&(CurrentObject->MemoryOnlyListEntry));
+        INSERT_BEFORE(&(CurrentObject->MemoryOnlyListEntry),
+                      &IoFileObjectsMemoryOnlyList);
+
+        FlushLimit -= 1;
+        IopFileObjectAddReference(CurrentObject);
+        KeReleaseQueuedLock(IoFileObjectsDirtyListLock);
+        if (ReleaseObject != NULL) {
+            IopFileObjectReleaseReference(ReleaseObject);
+            ReleaseObject = NULL;
+        }
+
+        Status = IopFlushFileObject(CurrentObject,
+                                    0,
+                                    -1,
+                                    0,
+                                    FALSE,
+                                    &PageCount);
+
+        IopFileObjectReleaseReference(CurrentObject);
+        if (!KSUCCESS(Status)) {
+            KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
+            break;
+        }
+
+        //
+        // Start over from the front, as the list may have changed while the
+        // lock was dropped. Rotated entries end up at the back, so this makes
+        // forward progress.
+        //
+
+        KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
+        if (PageCount == 0) {
+            break;
+        }
+
+        CurrentEntry = IoFileObjectsMemoryOnlyList.Next;
+    }
+
+    KeReleaseQueuedLock(IoFileObjectsDirtyListLock);
+    if (ReleaseObject != NULL) {
+        IopFileObjectReleaseReference(ReleaseObject);
+    }
+
+    if ((KSUCCESS(Status)) && (PageCount != OriginalCount)) {
+        Status = STATUS_TRY_AGAIN;
+    }
+
+    return Status;
+}
+
 VOID
 IopEvictFileObject (
     PFILE_OBJECT FileObject,
@@ -1770,88 +2079,88 @@ Return Value:
 {
 
     PFILE_OBJECT CurrentObject;
+    ULONG Index;
     PRED_BLACK_TREE_NODE Node;
     PFILE_OBJECT ReleaseObject;
+    PFILE_OBJECT_SHARD Shard;
 
     ASSERT(DeviceId != 0);
 
     ReleaseObject = NULL;
 
     //
-    // Grab the global file objects lock and iterate over the file objects that
+    // Grab each shard's lock in turn and iterate over the file objects that
     // belong to the given device.
     //
 
-    KeAcquireQueuedLock(IoFileObjectsLock);
-    Node = RtlRedBlackTreeGetLowestNode(&IoFileObjectsTree);
-    while (Node != NULL) {
-        CurrentObject = RED_BLACK_TREE_VALUE(Node, FILE_OBJECT, TreeEntry);
+    for (Index = 0; Index < FILE_OBJECT_SHARD_COUNT; Index += 1) {
+        Shard = &(IoFileObjectShards[Index]);
+        KeAcquireQueuedLock(Shard->Lock);
+        Node = RtlRedBlackTreeGetLowestNode(&(Shard->Tree));
+        while (Node != NULL) {
+            CurrentObject = RED_BLACK_TREE_VALUE(Node, FILE_OBJECT, TreeEntry);
 
-        //
-        // Skip file objects that do not match the device ID. Also skip any
-        // file objects that only have 1 reference. This means that they are
-        // about to get removed from the tree if close/delete are successful.
-        // As such, they don't have any page cache entries, as a page cache
-        // entry takes a reference on the file object.
-        //
+            //
+            // Skip file objects that do not match the device ID. Also skip
+            // any file objects that only have 1 reference. This means that
+            // they are about to get removed from the tree if close/delete are
+            // successful. As such, they don't have any page cache entries, as
+            // a page cache entry takes a reference on the file object.
+            //
 
-        if ((CurrentObject->Properties.DeviceId != DeviceId) ||
-            (CurrentObject->ReferenceCount == 1)) {
+            if ((CurrentObject->Properties.DeviceId != DeviceId) ||
+                (CurrentObject->ReferenceCount == 1)) {
 
-            Node = RtlRedBlackTreeGetNextNode(&(IoFileObjectsTree),
-                                              FALSE,
-                                              Node);
+                Node = RtlRedBlackTreeGetNextNode(&(Shard->Tree), FALSE, Node);
 
-            CurrentObject = NULL;
-            continue;
-        }
+                CurrentObject = NULL;
+                continue;
+            }
 
-        //
-        // Take a reference on this object so it does not disappear when the
-        // lock is released.
-        //
+            //
+            // Take a reference on this object so it does not disappear when
+            // the lock is released.
+            //
 
-        IopFileObjectAddReference(CurrentObject);
-        KeReleaseQueuedLock(IoFileObjectsLock);
-        KeAcquireSharedExclusiveLockExclusive(CurrentObject->Lock);
+            IopFileObjectAddReference(CurrentObject);
+            KeReleaseQueuedLock(Shard->Lock);
+            KeAcquireSharedExclusiveLockExclusive(CurrentObject->Lock);
 
-        //
-        // Call the eviction routine for the current file object.
-        //
+            //
+            // Call the eviction routine for the current file object.
+            //
 
-        IopEvictFileObject(CurrentObject, 0, Flags);
+            IopEvictFileObject(CurrentObject, 0, Flags);
 
-        //
-        // Release the reference taken on the release object.
-        //
+            //
+            // Release the reference taken on the release object.
+            //
 
-        if (ReleaseObject != NULL) {
+            if (ReleaseObject != NULL) {
 
-            ASSERT(ReleaseObject->ReferenceCount >= 2);
+                ASSERT(ReleaseObject->ReferenceCount >= 2);
 
-            IopFileObjectReleaseReference(ReleaseObject);
-            ReleaseObject = NULL;
-        }
+                IopFileObjectReleaseReference(ReleaseObject);
+                ReleaseObject = NULL;
+            }
 
-        KeReleaseSharedExclusiveLockExclusive(CurrentObject->Lock);
-        KeAcquireQueuedLock(IoFileObjectsLock);
+            KeReleaseSharedExclusiveLockExclusive(CurrentObject->Lock);
+            KeAcquireQueuedLock(Shard->Lock);
 
-        //
-        // The current object and node should match.
-        //
+            //
+            // The current object and node should match.
+            //
 
-        ASSERT(&(CurrentObject->TreeEntry) == Node);
+            ASSERT(&(CurrentObject->TreeEntry) == Node);
 
-        Node = RtlRedBlackTreeGetNextNode(&(IoFileObjectsTree),
-                                          FALSE,
-                                          Node);
+            Node = RtlRedBlackTreeGetNextNode(&(Shard->Tree), FALSE, Node);
+            ReleaseObject = CurrentObject;
+            CurrentObject = NULL;
+        }
 
-        ReleaseObject = CurrentObject;
-        CurrentObject = NULL;
+        KeReleaseQueuedLock(Shard->Lock);
     }
 
-    KeReleaseQueuedLock(IoFileObjectsLock);
-
     //
     // Release any lingering references.
     //
@@ -1979,6 +2288,106 @@ Return Value:
     return;
 }
 
+VOID
+IopGetFileObjectProperties (
+    PFILE_OBJECT FileObject,
+    PFILE_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes a snapshot of the given file object's properties. The
+    file object lock does not need to be held, so the properties may be
+    momentarily stale, but the file size is read atomically.
+
+Arguments:
+
+    FileObject - Supplies a pointer to a file object.
+
+    Properties - Supplies a pointer where the properties will be returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONGLONG FileSize;
+
+    RtlCopyMemory(Properties,
+                  &(FileObject->Properties),
+                  sizeof(FILE_PROPERTIES));
+
+    READ_INT64_SYNC(&(FileObject->Properties.FileSize), &FileSize);
+    WRITE_INT64_SYNC(&(Properties->FileSize), FileSize);
+    return;
+}
+
+BOOL
+IopGetCachedFileObjectProperties (
+    DEVICE_ID DeviceId,
+    FILE_ID FileId,
+    PFILE_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes a snapshot of the properties of the file object with
+    the given device and file IDs, if such a file object is currently in the
+    file object table. No reference is taken on the file object.
+
+Arguments:
+
+    DeviceId - Supplies the device ID of the file.
+
+    FileId - Supplies the file ID of the file.
+
+    Properties - Supplies a pointer where the properties will be returned.
+
+Return Value:
+
+    TRUE if the file object was found and its properties were returned.
+
+    FALSE if there is no file object for the given IDs.
+
+--*/
+
+{
+
+    PRED_BLACK_TREE_NODE FoundNode;
+    PFILE_OBJECT Object;
+    FILE_OBJECT SearchObject;
+    PFILE_OBJECT_SHARD Shard;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    //
+    // File objects are only removed from the table with the shard lock held,
+    // so the properties can be copied out without taking a reference.
+    //
+
+    Shard = IopGetFileObjectShard(DeviceId, FileId);
+    SearchObject.Properties.FileId = FileId;
+    SearchObject.Properties.DeviceId = DeviceId;
+    KeAcquireQueuedLock(Shard->Lock);
+    FoundNode = RtlRedBlackTreeSearch(&(Shard->Tree),
+                                      &(SearchObject.TreeEntry));
+
+    if (FoundNode != NULL) {
+        Object = RED_BLACK_TREE_VALUE(FoundNode, FILE_OBJECT, TreeEntry);
+        IopGetFileObjectProperties(Object, Properties);
+    }
+
+    KeReleaseQueuedLock(Shard->Lock);
+    return (FoundNode != NULL);
+}
+
 KSTATUS
 IopModifyFileObjectSize (
     PFILE_OBJECT FileObject,
@@ -2041,6 +2450,13 @@ Return Value:
     FileObject->Properties.BlockCount =
                        ALIGN_RANGE_UP(NewFileSize, BlockSize) / BlockSize;
 
+    //
+    // Lockless page cache readers must not see the file size change without
+    // also noticing that the cached data may have changed.
+    //
+
+    IopBeginPageCacheIndexUpdate(FileObject->PageCacheIndex);
+
     //
     // If this is a shared memory object, then handle that separately.
     //
@@ -2068,20 +2484,19 @@ Return Value:
     }
 
     IopMarkFileObjectPropertiesDirty(FileObject);
-    if (!KSUCCESS(Status)) {
-        goto ModifyFileObjectSizeEnd;
-    }
 
     //
     // If the new size is less than the current size, then work needs to be
     // done to make sure the system isn't using any of the truncated data.
     //
 
-    if (NewFileSize < FileSize) {
+    if ((KSUCCESS(Status)) && (NewFileSize < FileSize)) {
         Offset = ALIGN_RANGE_UP(NewFileSize, IoGetCacheEntryDataSize());
         IopEvictFileObject(FileObject, Offset, EVICTION_FLAG_TRUNCATE);
     }
 
+    IopEndPageCacheIndexUpdate(FileObject->PageCacheIndex);
+
 ModifyFileObjectSizeEnd:
 
     //
@@ -2175,44 +2590,52 @@ Return Value:
 {
 
     PFILE_OBJECT CurrentObject;
+    ULONG Index;
     LIST_ENTRY LocalList;
+    PFILE_OBJECT_SHARD Shard;
 
-    //
-    // Exit immediately if there are no orphaned file objects.
-    //
+    for (Index = 0; Index < FILE_OBJECT_SHARD_COUNT; Index += 1) {
+        Shard = &(IoFileObjectShards[Index]);
 
-    if (LIST_EMPTY(&IoFileObjectsOrphanedList) != FALSE) {
-        return;
-    }
+        //
+        // Skip shards without any orphaned file objects.
+        //
 
-    //
-    // Grab the global file objects lock, migrate the global orphaned file
-    // object list to a local list head and iterate over it. All objects on the
-    // list should have only 1 reference. If another thread resurrects any
-    // object during iteration, it will remove it from the local list and this
-    // routine will not see it. For those file objects processed, just add an
-    // extra reference with the lock held and release it with the lock released.
-    // This should kick off another attempt at closing out the file object.
-    //
+        if (LIST_EMPTY(&(Shard->OrphanedList)) != FALSE) {
+            continue;
+        }
+
+        //
+        // Grab the shard lock, migrate the shard's orphaned file object list
+        // to a local list head and iterate over it. All objects on the list
+        // should have only 1 reference. If another thread resurrects any
+        // object during iteration, it will remove it from the local list and
+        // this routine will not see it. For those file objects processed, just
+        // add an extra reference with the lock held and release it with the
+        // lock released. This should kick off another attempt at closing out
+        // the file object.
+        //
 
-    INITIALIZE_LIST_HEAD(&LocalList);
-    KeAcquireQueuedLock(IoFileObjectsLock);
-    MOVE_LIST(&IoFileObjectsOrphanedList, &LocalList);
-    INITIALIZE_LIST_HEAD(&IoFileObjectsOrphanedList);
-    while (LIST_EMPTY(&LocalList) == FALSE) {
-        CurrentObject = LIST_VALUE(LocalList.Next, FILE_OBJECT, ListEntry);
-        LIST_REMOVE(&(CurrentObject->ListEntry));
-        CurrentObject->ListEntry.Next = NULL;
+        INITIALIZE_LIST_HEAD(&LocalList);
+        KeAcquireQueuedLock(Shard->Lock);
+        MOVE_LIST(&(Shard->OrphanedList), &LocalList);
+        INITIALIZE_LIST_HEAD(&(Shard->OrphanedList));
+        while (LIST_EMPTY(&LocalList) == FALSE) {
+            CurrentObject = LIST_VALUE(LocalList.Next, FILE_OBJECT, ListEntry);
+            LIST_REMOVE(&(CurrentObject->ListEntry));
+            CurrentObject->ListEntry.Next = NULL;
 
-        ASSERT(CurrentObject->ReferenceCount == 1);
+            ASSERT(CurrentObject->ReferenceCount == 1);
 
-        IopFileObjectAddReference(CurrentObject);
-        KeReleaseQueuedLock(IoFileObjectsLock);
-        IopFileObjectReleaseReference(CurrentObject);
-        KeAcquireQueuedLock(IoFileObjectsLock);
+            IopFileObjectAddReference(CurrentObject);
+            KeReleaseQueuedLock(Shard->Lock);
+            IopFileObjectReleaseReference(CurrentObject);
+            KeAcquireQueuedLock(Shard->Lock);
+        }
+
+        KeReleaseQueuedLock(Shard->Lock);
     }
 
-    KeReleaseQueuedLock(IoFileObjectsLock);
     return;
 }
 
@@ -2356,6 +2779,35 @@ Return Value:
 
 {
 
+    ULONG Priority;
+
+    //
+    // Dirty pages of a file without backing store are only tracked so they
+    // can be found under memory pressure. Deleted files and dirty properties
+    // still go through the dirty list like everything else.
+    //
+
+    if (((FileObject->Flags & FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0) &&
+        (FileObject->Properties.HardLinkCount != 0)) {
+
+        IopAddMemoryOnlyFileObject(FileObject);
+        if ((FileObject->Flags & FILE_OBJECT_FLAG_DIRTY_PROPERTIES) == 0) {
+            return;
+        }
+    }
+
+    //
+    // Remember who is waiting on this data so that writeback goes out at
+    // their I/O priority rather than the page cache thread's.
+    //
+
+    Priority = IopGetCurrentIoPriority();
+    if (((FileObject->Flags & FILE_OBJECT_FLAG_DIRTY_DATA) == 0) ||
+        (Priority < FileObject->WritebackIoPriority)) {
+
+        FileObject->WritebackIoPriority = Priority;
+    }
+
     if ((FileObject->Flags & FILE_OBJECT_FLAG_DIRTY_DATA) == 0) {
         KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
         RtlAtomicOr32(&(FileObject->Flags), FILE_OBJECT_FLAG_DIRTY_DATA);
@@ -2458,31 +2910,38 @@ Return Value:
 {
 
     PFILE_OBJECT FileObject;
+    ULONG Index;
     PRED_BLACK_TREE_NODE Node;
+    PFILE_OBJECT_SHARD Shard;
 
-    KeAcquireQueuedLock(IoFileObjectsLock);
-    KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
-    Node = RtlRedBlackTreeGetLowestNode(&IoFileObjectsTree);
-    while (Node != NULL) {
-        FileObject = RED_BLACK_TREE_VALUE(Node, FILE_OBJECT, TreeEntry);
-        if (!LIST_EMPTY(&(FileObject->DirtyPageList))) {
-            if (IS_FILE_OBJECT_CLEAN(FileObject)) {
-                RtlDebugPrint("FILE_OBJECT 0x%x marked as clean with "
-                              "non-empty dirty list.\n",
-                              FileObject);
-            }
+    for (Index = 0; Index < FILE_OBJECT_SHARD_COUNT; Index += 1) {
+        Shard = &(IoFileObjectShards[Index]);
+        KeAcquireQueuedLock(Shard->Lock);
+        KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
+        Node = RtlRedBlackTreeGetLowestNode(&(Shard->Tree));
+        while (Node != NULL) {
+            FileObject = RED_BLACK_TREE_VALUE(Node, FILE_OBJECT, TreeEntry);
+            if (!LIST_EMPTY(&(FileObject->DirtyPageList))) {
+                if (IS_FILE_OBJECT_CLEAN(FileObject)) {
+                    RtlDebugPrint("FILE_OBJECT 0x%x marked as clean with "
+                                  "non-empty dirty list.\n",
+                                  FileObject);
+                }
 
-            if (FileObject->ListEntry.Next == NULL) {
-                RtlDebugPrint("FILE_OBJECT 0x%x dirty but not in dirty list.\n",
-                              FileObject);
+                if (FileObject->ListEntry.Next == NULL) {
+                    RtlDebugPrint("FILE_OBJECT 0x%x dirty but not in dirty "
+                                  "list.\n",
+                                  FileObject);
+                }
             }
+
+            Node = RtlRedBlackTreeGetNextNode(&(Shard->Tree), FALSE, Node);
         }
 
-        Node = RtlRedBlackTreeGetNextNode(&IoFileObjectsTree, FALSE, Node);
+        KeReleaseQueuedLock(IoFileObjectsDirtyListLock);
+        KeReleaseQueuedLock(Shard->Lock);
     }
 
-    KeReleaseQueuedLock(IoFileObjectsDirtyListLock);
-    KeReleaseQueuedLock(IoFileObjectsLock);
     return;
 }
 
@@ -2529,6 +2988,7 @@ Return Value:
 
     RtlZeroMemory(Async, sizeof(IO_ASYNC_STATE));
     INITIALIZE_LIST_HEAD(&(Async->ReceiverList));
+    INITIALIZE_LIST_HEAD(&(Async->EventPollList));
     Async->Lock = KeCreateQueuedLock();
     if (Async->Lock == NULL) {
         goto GetAsyncStateEnd;
@@ -2698,8 +3158,50 @@ Return Value:
     return ComparisonResultSame;
 }
 
+PFILE_OBJECT_SHARD
+IopGetFileObjectShard (
+    DEVICE_ID DeviceId,
+    FILE_ID FileId
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the file object table shard that owns the file object
+    with the given device and file IDs.
+
+Arguments:
+
+    DeviceId - Supplies the device ID of the file object.
+
+    FileId - Supplies the file ID of the file object.
+
+Return Value:
+
+    Returns a pointer to the shard.
+
+--*/
+
+{
+
+    ULONG Hash;
+
+    //
+    // File IDs are often small sequential numbers, and object manager file
+    // IDs are pointers, so mix in all the bits with a multiplicative hash and
+    // take the top ones.
+    //
+
+    Hash = (ULONG)FileId ^ (ULONG)(FileId >> 32);
+    Hash ^= (ULONG)DeviceId * 0x9E3779B1;
+    Hash *= 0x9E3779B1;
+    return &(IoFileObjectShards[Hash >> (32 - FILE_OBJECT_SHARD_SHIFT)]);
+}
+
 PFILE_OBJECT
 IopLookupFileObjectByProperties (
+    PFILE_OBJECT_SHARD Shard,
     PFILE_PROPERTIES Properties
     )
 
@@ -2708,11 +3210,13 @@ IopLookupFileObjectByProperties (
 Routine Description:
 
     This routine attempts to look up a file object with the given properties
-    (specifically the device and file IDs). It assumes the global file objects
-    lock is already held.
+    (specifically the device and file IDs). It assumes the lock of the shard
+    owning those IDs is already held.
 
 Arguments:
 
+    Shard - Supplies a pointer to the shard owning the file object.
+
     Properties - Supplies a pointer to the file object properties.
 
 Return Value:
@@ -2736,7 +3240,7 @@ Return Value:
     Object = NULL;
     SearchObject.Properties.FileId = Properties->FileId;
     SearchObject.Properties.DeviceId = Properties->DeviceId;
-    FoundNode = RtlRedBlackTreeSearch(&IoFileObjectsTree,
+    FoundNode = RtlRedBlackTreeSearch(&(Shard->Tree),
                                       &(SearchObject.TreeEntry));
 
     if (FoundNode != NULL) {
@@ -2785,6 +3289,7 @@ Return Value:
 {
 
     ASSERT(LIST_EMPTY(&(Async->ReceiverList)));
+    ASSERT(LIST_EMPTY(&(Async->EventPollList)));
 
     if (Async->Lock != NULL) {
         KeDestroyQueuedLock(Async->Lock);
@@ -2917,3 +3422,48 @@ Return Value:
     return;
 }
 
+VOID
+IopAddMemoryOnlyFileObject (
+    PFILE_OBJECT FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine puts a file object without backing store on the list of
+    memory-only file objects if it has dirty pages and is not already there.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT((FileObject->Flags & FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0);
+
+    if ((FileObject->MemoryOnlyListEntry.Next != NULL) ||
+        (LIST_EMPTY(&(FileObject->DirtyPageList)) != FALSE)) {
+
+        return;
+    }
+
+    KeAcquireQueuedLock(IoFileObjectsDirtyListLock);
+    if ((FileObject->MemoryOnlyListEntry.Next == NULL) &&
+        (LIST_EMPTY(&(FileObject->DirtyPageList)) == FALSE)) {
+
+        IopFileObjectAddReference(FileObject);
+        INSERT_BEFORE(&(FileObject->MemoryOnlyListEntry),
+                      &IoFileObjectsMemoryOnlyList);
+    }
+
+    KeReleaseQueuedLock(IoFileObjectsDirtyListLock);
+    return;
+}
+
@@ -708,6 +708,7 @@ Return Value:
     ULONG FileObjectFlags;
     PKPROCESS KernelProcess;
     BOOL Match;
+    UINTN OldValue;
     PARTITION_DEVICE_INFORMATION PartitionInformation;
     UINTN PartitionInformationSize;
     PPATH_POINT PathPoint;
@@ -776,6 +777,11 @@ Return Value:
         FileObjectFlags |= FILE_OBJECT_FLAG_NON_CACHED;
     }
 
+    if ((RootLookupFlags & LOOKUP_FLAG_NO_BACKING_STORE) != 0) {
+        Volume->Flags |= VOLUME_FLAG_NO_BACKING_STORE;
+        FileObjectFlags |= FILE_OBJECT_FLAG_NO_BACKING_STORE;
+    }
+
     //
     // Create or lookup a file object for the volume.
     //
@@ -869,9 +875,19 @@ Return Value:
                             PartitionInformation.PartitionId,
                             sizeof(BootInformation.SystemPartitionIdentifier));
 
-            if ((Match != FALSE) && (IoSystemVolume == NULL)) {
-                IoSystemVolume = Volume;
-                SystemVolume = TRUE;
+            //
+            // Volumes can arrive in parallel on the device work queue, so
+            // claim the system volume slot atomically.
+            //
+
+            if (Match != FALSE) {
+                OldValue = RtlAtomicCompareExchange((PUINTN)&IoSystemVolume,
+                                                    (UINTN)Volume,
+                                                    (UINTN)NULL);
+
+                if (OldValue == (UINTN)NULL) {
+                    SystemVolume = TRUE;
+                }
             }
         }
     }
@@ -1412,9 +1428,9 @@ Return Value:
     // If this was the system volume, unset the global variable.
     //
 
-    if (Volume == IoSystemVolume) {
-        IoSystemVolume = NULL;
-    }
+    RtlAtomicCompareExchange((PUINTN)&IoSystemVolume,
+                             (UINTN)NULL,
+                             (UINTN)Volume);
 
 DestroyVolumeEnd:
     return;
@@ -36,6 +36,13 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define how many processes deep the deadlock detection will follow a chain
+// of blocked lock requests before giving up and letting the request wait.
+//
+
+#define FILE_LOCK_MAX_DEADLOCK_DEPTH 16
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -44,12 +51,24 @@ Module Name:
 
 Structure Description:
 
-    This structure defines an active file lock.
+    This structure defines an active file lock. Locks are kept in an AVL
+    interval tree per file object, ordered by offset and augmented with the
+    largest end offset in each subtree so overlap queries can skip subtrees
+    that end before the region in question.
 
 Members:
 
-    ListEntry - Stores pointers to the next and previous lock entries in the
-        file object.
+    ListEntry - Stores pointers to the next and previous lock entries when the
+        entry is on a local list, such as while being freed.
+
+    Left - Stores a pointer to the left child in the lock tree.
+
+    Right - Stores a pointer to the right child in the lock tree.
+
+    Height - Stores the height of the subtree rooted at this entry.
+
+    MaxEnd - Stores the largest end offset of any lock in the subtree rooted
+        at this entry.
 
     Type - Stores the lock type.
 
@@ -62,41 +81,190 @@ Structure Description:
 
 --*/
 
-typedef struct _FILE_LOCK_ENTRY {
+struct _FILE_LOCK_ENTRY {
     LIST_ENTRY ListEntry;
+    PFILE_LOCK_ENTRY Left;
+    PFILE_LOCK_ENTRY Right;
+    ULONG Height;
+    ULONGLONG MaxEnd;
     FILE_LOCK_TYPE Type;
     PKPROCESS Process;
     ULONGLONG Offset;
     ULONGLONG Size;
-} FILE_LOCK_ENTRY, *PFILE_LOCK_ENTRY;
+};
+
+/*++
+
+Structure Description:
+
+    This structure defines a thread blocked waiting to acquire a file lock.
+
+Members:
+
+    FileListEntry - Stores pointers to the next and previous waiters on the
+        same file object.
+
+    ListEntry - Stores pointers to the next and previous waiters in the global
+        list used for deadlock detection.
+
+    Process - Stores a pointer to the process that is waiting.
+
+    BlockingProcess - Stores a pointer to the process that owns the lock this
+        waiter is blocked on.
+
+    Offset - Stores the offset of the region the waiter wants to lock.
+
+    End - Stores the end offset of the region the waiter wants to lock.
+
+    Event - Stores a pointer to the event the waiter is blocked on.
+
+--*/
+
+typedef struct _FILE_LOCK_WAITER {
+    LIST_ENTRY FileListEntry;
+    LIST_ENTRY ListEntry;
+    PKPROCESS Process;
+    PKPROCESS BlockingProcess;
+    ULONGLONG Offset;
+    ULONGLONG End;
+    PKEVENT Event;
+} FILE_LOCK_WAITER, *PFILE_LOCK_WAITER;
 
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
-KSTATUS
-IopTryToSetFileLock (
+VOID
+IopApplyFileLock (
     PFILE_OBJECT FileObject,
     PFILE_LOCK_ENTRY NewEntry,
-    PLIST_ENTRY FreeList,
-    BOOL DryRun
+    PLIST_ENTRY FreeList
+    );
+
+KSTATUS
+IopQueueFileLockWaiter (
+    PFILE_LOCK_WAITER Waiter
+    );
+
+VOID
+IopWakeFileLockWaiters (
+    PFILE_OBJECT FileObject,
+    ULONGLONG Offset,
+    ULONGLONG End
+    );
+
+PFILE_LOCK_ENTRY
+IopFindFileLockConflict (
+    PFILE_LOCK_ENTRY Node,
+    ULONGLONG Offset,
+    ULONGLONG End,
+    FILE_LOCK_TYPE Type,
+    PKPROCESS Process
+    );
+
+VOID
+IopCollectFileLocks (
+    PFILE_LOCK_ENTRY Node,
+    ULONGLONG Offset,
+    ULONGLONG End,
+    PKPROCESS Process,
+    PLIST_ENTRY List
+    );
+
+PFILE_LOCK_ENTRY
+IopInsertFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    PFILE_LOCK_ENTRY Entry
+    );
+
+PFILE_LOCK_ENTRY
+IopRemoveFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    PFILE_LOCK_ENTRY Entry
+    );
+
+PFILE_LOCK_ENTRY
+IopRemoveMinimumFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    PFILE_LOCK_ENTRY *Minimum
+    );
+
+PFILE_LOCK_ENTRY
+IopBalanceFileLockNode (
+    PFILE_LOCK_ENTRY Node
+    );
+
+PFILE_LOCK_ENTRY
+IopRotateFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    BOOL Left
+    );
+
+VOID
+IopUpdateFileLockNode (
+    PFILE_LOCK_ENTRY Node
     );
 
 BOOL
-IopDoFileLocksOverlap (
-    ULONGLONG IncomingOffset,
-    ULONGLONG IncomingSize,
-    PFILE_LOCK_ENTRY LockEntry
+IopIsFileLockBefore (
+    PFILE_LOCK_ENTRY First,
+    PFILE_LOCK_ENTRY Second
+    );
+
+ULONGLONG
+IopGetFileLockEnd (
+    ULONGLONG Offset,
+    ULONGLONG Size
     );
 
 //
 // -------------------------------------------------------------------- Globals
 //
 
+//
+// Store the global list of blocked file lock waiters, and the lock that
+// protects it. This is only used to detect deadlocks.
+//
+
+LIST_ENTRY IoFileLockWaiterList;
+PQUEUED_LOCK IoFileLockWaiterLock;
+
 //
 // ------------------------------------------------------------------ Functions
 //
 
+KSTATUS
+IopInitializeFileLockSupport (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs global initialization for user mode file locks.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    INITIALIZE_LIST_HEAD(&IoFileLockWaiterList);
+    IoFileLockWaiterLock = KeCreateQueuedLock();
+    if (IoFileLockWaiterLock == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
 KSTATUS
 IopGetFileLock (
     PIO_HANDLE IoHandle,
@@ -126,11 +294,9 @@ Return Value:
 
 {
 
-    PLIST_ENTRY CurrentEntry;
+    ULONGLONG End;
     PFILE_OBJECT FileObject;
     PFILE_LOCK_ENTRY FoundEntry;
-    PFILE_LOCK_ENTRY LockEntry;
-    BOOL Overlap;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
@@ -139,27 +305,13 @@ Return Value:
     }
 
     FileObject = IoHandle->FileObject;
-    FoundEntry = NULL;
-    KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
-    CurrentEntry = FileObject->FileLockList.Next;
-    while (CurrentEntry != &(FileObject->FileLockList)) {
-        LockEntry = LIST_VALUE(CurrentEntry, FILE_LOCK_ENTRY, ListEntry);
-        CurrentEntry = CurrentEntry->Next;
-
-        //
-        // If the caller only wants write locks, then skip read locks.
-        //
-
-        if ((Lock->Type == FileLockRead) && (LockEntry->Type == FileLockRead)) {
-            continue;
-        }
-
-        Overlap = IopDoFileLocksOverlap(Lock->Offset, Lock->Size, LockEntry);
-        if (Overlap != FALSE) {
-            FoundEntry = LockEntry;
-            break;
-        }
-    }
+    End = IopGetFileLockEnd(Lock->Offset, Lock->Size);
+    KeAcquireSharedExclusiveLockShared(FileObject->Lock);
+    FoundEntry = IopFindFileLockConflict(FileObject->FileLockTree,
+                                         Lock->Offset,
+                                         End,
+                                         Lock->Type,
+                                         NULL);
 
     if (FoundEntry != NULL) {
         Lock->Type = FoundEntry->Type;
@@ -171,7 +323,7 @@ Return Value:
         Lock->Type = FileLockUnlock;
     }
 
-    KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
+    KeReleaseSharedExclusiveLockShared(FileObject->Lock);
     return STATUS_SUCCESS;
 }
 
@@ -207,16 +359,17 @@ Return Value:
 
 {
 
+    PFILE_LOCK_ENTRY Conflict;
+    ULONGLONG End;
     PFILE_LOCK_ENTRY Entry;
     PFILE_OBJECT FileObject;
     LIST_ENTRY FreeList;
     BOOL LockHeld;
     PFILE_LOCK_ENTRY NewEntry;
-    PKEVENT NewEvent;
-    PKEVENT PreviousEvent;
     FILE_LOCK_ENTRY RemoveEntry;
     PFILE_LOCK_ENTRY SplitEntry;
     KSTATUS Status;
+    FILE_LOCK_WAITER Waiter;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
@@ -225,6 +378,7 @@ Return Value:
     NewEntry = NULL;
     SplitEntry = NULL;
     LockHeld = FALSE;
+    Waiter.Event = NULL;
     if ((Lock->Type == FileLockInvalid) || (Lock->Type >= FileLockTypeCount)) {
         Status = STATUS_INVALID_PARAMETER;
         goto SetFileLockEnd;
@@ -272,37 +426,22 @@ Return Value:
     NewEntry->Offset = Lock->Offset;
     NewEntry->Size = Lock->Size;
     NewEntry->Process = PsGetCurrentProcess();
+    End = IopGetFileLockEnd(NewEntry->Offset, NewEntry->Size);
+
+    //
+    // At most one existing lock can be split in two, so one spare entry is
+    // all that's ever needed.
+    //
+
     SplitEntry = MmAllocateNonPagedPool(sizeof(FILE_LOCK_ENTRY),
                                         FILE_LOCK_ALLOCATION_TAG);
 
-    if (NewEntry == NULL) {
+    if (SplitEntry == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto SetFileLockEnd;
     }
 
     INSERT_BEFORE(&(SplitEntry->ListEntry), &FreeList);
-
-    //
-    // Race to create the event if not created.
-    //
-
-    if (FileObject->FileLockEvent == NULL) {
-        NewEvent = KeCreateEvent(NULL);
-        if (NewEvent == NULL) {
-            Status = STATUS_INSUFFICIENT_RESOURCES;
-            goto SetFileLockEnd;
-        }
-
-        PreviousEvent = (PKEVENT)RtlAtomicCompareExchange(
-                                          (PUINTN)&(FileObject->FileLockEvent),
-                                          (UINTN)NewEvent,
-                                          (UINTN)NULL);
-
-        if (PreviousEvent != NULL) {
-            KeDestroyEvent(NewEvent);
-        }
-    }
-
     while (TRUE) {
         if (LockHeld == FALSE) {
             KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
@@ -310,63 +449,85 @@ Return Value:
         }
 
         //
-        // If this really is setting a lock, do a dry run to see if this would
-        // work.
+        // If this really is setting a lock, see if another process holds a
+        // conflicting one.
         //
 
         if (Lock->Type != FileLockUnlock) {
-            Status = IopTryToSetFileLock(FileObject,
-                                         NewEntry,
-                                         NULL,
-                                         TRUE);
+            Conflict = IopFindFileLockConflict(FileObject->FileLockTree,
+                                               NewEntry->Offset,
+                                               End,
+                                               NewEntry->Type,
+                                               NewEntry->Process);
 
-            if (!KSUCCESS(Status)) {
+            if (Conflict != NULL) {
+                Status = STATUS_RESOURCE_IN_USE;
+                if (Blocking == FALSE) {
+                    break;
+                }
 
                 //
-                // Wait for something to unlock.
+                // Register as a waiter on the region. This fails if the
+                // owner of the conflicting lock is itself waiting, directly
+                // or indirectly, on this process.
                 //
 
-                if (Blocking != FALSE) {
-                    KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
-                    LockHeld = FALSE;
-                    Status = KeWaitForEvent(FileObject->FileLockEvent,
-                                            TRUE,
-                                            WAIT_TIME_INDEFINITE);
+                if (Waiter.Event == NULL) {
+                    Waiter.Event = KeCreateEvent(NULL);
+                    if (Waiter.Event == NULL) {
+                        Status = STATUS_INSUFFICIENT_RESOURCES;
+                        break;
+                    }
+                }
 
-                    //
-                    // The thread was interrupted.
-                    //
+                Waiter.Process = NewEntry->Process;
+                Waiter.BlockingProcess = Conflict->Process;
+                Waiter.Offset = NewEntry->Offset;
+                Waiter.End = End;
+                Status = IopQueueFileLockWaiter(&Waiter);
+                if (!KSUCCESS(Status)) {
+                    break;
+                }
 
-                    if (!KSUCCESS(Status)) {
-                        if (Status == STATUS_INTERRUPTED) {
-                            Status = STATUS_RESTART_AFTER_SIGNAL;
-                        }
+                KeSignalEvent(Waiter.Event, SignalOptionUnsignal);
+                INSERT_BEFORE(&(Waiter.FileListEntry),
+                              &(FileObject->FileLockWaitList));
 
-                        goto SetFileLockEnd;
-                    }
+                KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
+                Status = KeWaitForEvent(Waiter.Event,
+                                        TRUE,
+                                        WAIT_TIME_INDEFINITE);
 
-                    continue;
+                KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
+                LIST_REMOVE(&(Waiter.FileListEntry));
+                KeAcquireQueuedLock(IoFileLockWaiterLock);
+                LIST_REMOVE(&(Waiter.ListEntry));
+                KeReleaseQueuedLock(IoFileLockWaiterLock);
 
                 //
-                // Not blocking, the dry run was the only attempt.
+                // The thread was interrupted.
                 //
 
-                } else {
+                if (!KSUCCESS(Status)) {
+                    if (Status == STATUS_INTERRUPTED) {
+                        Status = STATUS_RESTART_AFTER_SIGNAL;
+                    }
+
                     break;
                 }
+
+                continue;
             }
         }
 
         //
-        // Do this for real. This should not fail, as any failures should
-        // have happened during the try run.
+        // Do this for real. This cannot fail now that no conflicts were
+        // found.
         //
 
-        Status = IopTryToSetFileLock(FileObject, NewEntry, &FreeList, FALSE);
-
-        ASSERT(KSUCCESS(Status));
-
+        IopApplyFileLock(FileObject, NewEntry, &FreeList);
         NewEntry = NULL;
+        Status = STATUS_SUCCESS;
         break;
     }
 
@@ -375,6 +536,10 @@ Return Value:
         KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
     }
 
+    if (Waiter.Event != NULL) {
+        KeDestroyEvent(Waiter.Event);
+    }
+
     if ((NewEntry != NULL) && (NewEntry != &RemoveEntry)) {
         MmFreeNonPagedPool(NewEntry);
     }
@@ -429,7 +594,7 @@ Return Value:
     //
 
     FileObject = IoHandle->FileObject;
-    if (LIST_EMPTY(&(FileObject->FileLockList)) != FALSE) {
+    if (FileObject->FileLockTree == NULL) {
         return;
     }
 
@@ -437,25 +602,28 @@ Return Value:
     KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
 
     //
-    // Loop through and remove any active locks belonging to this process.
+    // Pull out any active locks belonging to this process, and wake anyone
+    // waiting on the regions they covered.
     //
 
-    CurrentEntry = FileObject->FileLockList.Next;
-    while (CurrentEntry != &(FileObject->FileLockList)) {
+    IopCollectFileLocks(FileObject->FileLockTree,
+                        0,
+                        MAX_ULONGLONG,
+                        Process,
+                        &FreeList);
+
+    CurrentEntry = FreeList.Next;
+    while (CurrentEntry != &FreeList) {
         LockEntry = LIST_VALUE(CurrentEntry, FILE_LOCK_ENTRY, ListEntry);
         CurrentEntry = CurrentEntry->Next;
-        if (LockEntry->Process == Process) {
-            LIST_REMOVE(&(LockEntry->ListEntry));
-            INSERT_BEFORE(&(LockEntry->ListEntry), &FreeList);
-        }
-    }
-
-    //
-    // If locks were removed, signal anyone blocked on this file.
-    //
-
-    if (LIST_EMPTY(&FreeList) == FALSE) {
-        KeSignalEvent(FileObject->FileLockEvent, SignalOptionSignalAll);
+        FileObject->FileLockTree = IopRemoveFileLockNode(
+                                                      FileObject->FileLockTree,
+                                                      LockEntry);
+
+        IopWakeFileLockWaiters(FileObject,
+                               LockEntry->Offset,
+                               IopGetFileLockEnd(LockEntry->Offset,
+                                                 LockEntry->Size));
     }
 
     KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
@@ -477,269 +645,825 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
-KSTATUS
-IopTryToSetFileLock (
+VOID
+IopApplyFileLock (
     PFILE_OBJECT FileObject,
     PFILE_LOCK_ENTRY NewEntry,
-    PLIST_ENTRY FreeList,
-    BOOL DryRun
+    PLIST_ENTRY FreeList
     )
 
 /*++
 
 Routine Description:
 
-    This routine attempts to lock or unlocks a portion of a file. If the
-    process already has a lock on any part of the region, the old lock is
-    replaced with this new region. Remove a lock by specifying a lock type of
-    unlock. This routine assumes the file properties lock is already held.
+    This routine locks or unlocks a portion of a file, assuming there are no
+    conflicting locks from other processes. Locks the process already has in
+    the region are trimmed or split around it, and locks of the same type that
+    overlap or abut it are merged into it. This routine assumes the file
+    object lock is held exclusively.
 
 Arguments:
 
     FileObject - Supplies a pointer to the file object.
 
-    NewEntry - Supplies a pointer to the new lock to add.
+    NewEntry - Supplies a pointer to the new lock to add. If the type is
+        unlock, the region is only removed and the entry is not inserted.
 
     FreeList - Supplies a pointer to a list head that on input contains one
         free entry, needed to potentially split an entry. On output, entries
         that need to be freed will be put on this list.
 
-    DryRun - Supplies a pointer indicating if the lock should actually be
-        created/destroyed or just checked.
-
 Return Value:
 
-    Status code.
+    None.
 
 --*/
 
 {
 
-    PLIST_ENTRY CurrentEntry;
+    LIST_ENTRY Collected;
+    ULONGLONG End;
+    ULONGLONG LockEnd;
     PFILE_LOCK_ENTRY LockEntry;
-    BOOL LocksRemoved;
     ULONGLONG NewEnd;
-    BOOL Overlap;
-    PKPROCESS Process;
+    ULONGLONG NewOffset;
+    BOOL Released;
+    ULONGLONG SearchEnd;
+    ULONGLONG SearchOffset;
     PFILE_LOCK_ENTRY SplitEntry;
-    KSTATUS Status;
 
-    LocksRemoved = FALSE;
-    NewEnd = NewEntry->Offset + NewEntry->Size;
-    Process = PsGetCurrentProcess();
-    Status = STATUS_SUCCESS;
-    CurrentEntry = FileObject->FileLockList.Next;
-    while (CurrentEntry != &(FileObject->FileLockList)) {
-        LockEntry = LIST_VALUE(CurrentEntry, FILE_LOCK_ENTRY, ListEntry);
-        CurrentEntry = CurrentEntry->Next;
+    NewOffset = NewEntry->Offset;
+    NewEnd = IopGetFileLockEnd(NewOffset, NewEntry->Size);
+    End = NewEnd;
+    Released = FALSE;
 
-        //
-        // If the lock belongs to the current process and overlaps the given
-        // region, it is to be removed.
-        //
+    //
+    // Gather this process' locks that overlap or abut the region. The ones
+    // that only abut it matter for merging.
+    //
 
-        if (LockEntry->Process == Process) {
-            Overlap = IopDoFileLocksOverlap(NewEntry->Offset,
-                                            NewEntry->Size,
-                                            LockEntry);
+    SearchOffset = NewOffset;
+    if (SearchOffset != 0) {
+        SearchOffset -= 1;
+    }
 
-            if ((Overlap != FALSE) && (DryRun == FALSE)) {
-                LocksRemoved = TRUE;
+    SearchEnd = NewEnd;
+    if (SearchEnd != MAX_ULONGLONG) {
+        SearchEnd += 1;
+    }
 
-                //
-                // If the existing entry starts before the new one, it needs to
-                // be shrunk or split.
-                //
+    INITIALIZE_LIST_HEAD(&Collected);
+    IopCollectFileLocks(FileObject->FileLockTree,
+                        SearchOffset,
+                        SearchEnd,
+                        NewEntry->Process,
+                        &Collected);
 
-                if (LockEntry->Offset < NewEntry->Offset) {
+    while (LIST_EMPTY(&Collected) == FALSE) {
+        LockEntry = LIST_VALUE(Collected.Next, FILE_LOCK_ENTRY, ListEntry);
+        LIST_REMOVE(&(LockEntry->ListEntry));
+        FileObject->FileLockTree = IopRemoveFileLockNode(
+                                                      FileObject->FileLockTree,
+                                                      LockEntry);
 
-                    //
-                    // If it ends after the new one, split it.
-                    //
+        LockEnd = IopGetFileLockEnd(LockEntry->Offset, LockEntry->Size);
 
-                    if ((NewEntry->Size != 0) &&
-                        ((LockEntry->Offset + LockEntry->Size > NewEnd) ||
-                         (LockEntry->Size == 0))) {
+        //
+        // A lock of the same type gets absorbed into the new one. Since a
+        // process' own locks never overlap each other, this can't make the
+        // new lock run into any of the other collected entries.
+        //
 
-                        ASSERT(LIST_EMPTY(FreeList) == FALSE);
+        if (LockEntry->Type == NewEntry->Type) {
+            if (LockEntry->Offset < NewEntry->Offset) {
+                NewEntry->Offset = LockEntry->Offset;
+            }
 
-                        SplitEntry = LIST_VALUE(FreeList->Next,
-                                                FILE_LOCK_ENTRY,
-                                                ListEntry);
+            if (LockEnd > End) {
+                End = LockEnd;
+            }
 
-                        LIST_REMOVE(&(SplitEntry->ListEntry));
-                        SplitEntry->Type = LockEntry->Type;
-                        SplitEntry->Offset = NewEnd;
-                        if (LockEntry->Size == 0) {
-                            SplitEntry->Size = 0;
+            INSERT_BEFORE(&(LockEntry->ListEntry), FreeList);
+            continue;
+        }
 
-                        } else {
-                            SplitEntry->Size = LockEntry->Offset +
-                                               LockEntry->Size - NewEnd;
-                        }
+        //
+        // A lock of a different type that merely abuts the region stays as
+        // it is.
+        //
 
-                        INSERT_AFTER(&(SplitEntry->ListEntry),
-                                     &(LockEntry->ListEntry));
-                    }
+        if ((LockEnd <= NewOffset) || (LockEntry->Offset >= NewEnd)) {
+            FileObject->FileLockTree = IopInsertFileLockNode(
+                                                      FileObject->FileLockTree,
+                                                      LockEntry);
 
-                    //
-                    // Shrink its length.
-                    //
+            continue;
+        }
 
-                    LockEntry->Size = NewEntry->Offset - LockEntry->Offset;
+        //
+        // Keep whatever parts of the old lock stick out on either side of the
+        // new region. If it sticks out of both sides, split it.
+        //
 
-                //
-                // The current entry starts within the new entry. If it
-                // ends after the new entry, shrink it.
-                //
+        Released = TRUE;
+        if (LockEnd > NewEnd) {
+            if (LockEntry->Offset < NewOffset) {
 
-                } else if ((NewEntry->Size != 0) &&
-                           ((LockEntry->Offset + LockEntry->Size > NewEnd) ||
-                            (LockEntry->Size == 0))) {
+                ASSERT(LIST_EMPTY(FreeList) == FALSE);
 
-                    if (LockEntry->Size != 0) {
-                        LockEntry->Size = LockEntry->Offset + LockEntry->Size -
-                                          NewEnd;
-                    }
+                SplitEntry = LIST_VALUE(FreeList->Next,
+                                        FILE_LOCK_ENTRY,
+                                        ListEntry);
 
-                    LockEntry->Offset = NewEnd;
+                LIST_REMOVE(&(SplitEntry->ListEntry));
+                SplitEntry->Type = LockEntry->Type;
+                SplitEntry->Process = LockEntry->Process;
+                SplitEntry->Offset = NewEnd;
+                SplitEntry->Size = LockEntry->Size;
+                if (LockEntry->Size != 0) {
+                    SplitEntry->Size = LockEnd - NewEnd;
+                }
 
-                //
-                // The new entry completely swallows the existing one.
-                //
+                FileObject->FileLockTree = IopInsertFileLockNode(
+                                                      FileObject->FileLockTree,
+                                                      SplitEntry);
 
-                } else {
-                    LIST_REMOVE(&(LockEntry->ListEntry));
-                    INSERT_BEFORE(&(LockEntry->ListEntry), FreeList);
+                LockEntry->Size = NewOffset - LockEntry->Offset;
+
+            } else {
+                if (LockEntry->Size != 0) {
+                    LockEntry->Size = LockEnd - NewEnd;
                 }
+
+                LockEntry->Offset = NewEnd;
             }
 
+        } else if (LockEntry->Offset < NewOffset) {
+            LockEntry->Size = NewOffset - LockEntry->Offset;
+
         //
-        // Another process owns this lock.
+        // The new entry completely swallows the existing one.
         //
 
         } else {
+            INSERT_BEFORE(&(LockEntry->ListEntry), FreeList);
+            continue;
+        }
 
-            //
-            // Read locks can coexist.
-            //
+        FileObject->FileLockTree = IopInsertFileLockNode(
+                                                      FileObject->FileLockTree,
+                                                      LockEntry);
+    }
 
-            if ((NewEntry->Type == FileLockRead) &&
-                (LockEntry->Type == FileLockRead)) {
+    if (NewEntry->Type != FileLockUnlock) {
+        NewEntry->Size = 0;
+        if (End != MAX_ULONGLONG) {
+            NewEntry->Size = End - NewEntry->Offset;
+        }
 
-                continue;
-            }
+        FileObject->FileLockTree = IopInsertFileLockNode(
+                                                      FileObject->FileLockTree,
+                                                      NewEntry);
+    }
+
+    //
+    // Only waiters on the part of the file that changed hands can make
+    // progress.
+    //
 
-            //
-            // If the file lock overlaps with the incoming one, then fail.
-            //
+    if (Released != FALSE) {
+        IopWakeFileLockWaiters(FileObject, NewOffset, NewEnd);
+    }
 
-            Overlap = IopDoFileLocksOverlap(NewEntry->Offset,
-                                            NewEntry->Size,
-                                            LockEntry);
+    return;
+}
 
-            //
-            // This routine should not be discovering overlaps on the real
-            // deal.
-            //
+KSTATUS
+IopQueueFileLockWaiter (
+    PFILE_LOCK_WAITER Waiter
+    )
 
-            ASSERT((Overlap == FALSE) || (DryRun != FALSE));
+/*++
 
-            if (Overlap != FALSE) {
-                Status = STATUS_RESOURCE_IN_USE;
-                KeSignalEvent(FileObject->FileLockEvent, SignalOptionUnsignal);
-                break;
-            }
-        }
-    }
+Routine Description:
+
+    This routine adds a waiter to the global list of blocked lock requests,
+    unless doing so would complete a cycle of processes waiting on each other.
+
+Arguments:
+
+    Waiter - Supplies a pointer to the initialized waiter.
+
+Return Value:
+
+    STATUS_SUCCESS if the waiter was queued.
+
+    STATUS_DEADLOCK if the process that owns the blocking lock is already
+    waiting, directly or indirectly, on the waiter's process.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    ULONG Depth;
+    PKPROCESS Owner;
+    PFILE_LOCK_WAITER Waiting;
+
+    KeAcquireQueuedLock(IoFileLockWaiterLock);
 
     //
-    // Add the new entry if conditions are right.
+    // Follow the chain of "owner is waiting on" links from the blocking
+    // process. Blocked processes are few, and the depth is bounded, so this
+    // stays cheap.
     //
 
-    if ((KSUCCESS(Status)) && (DryRun == FALSE) &&
-        (NewEntry->Type != FileLockUnlock)) {
+    Owner = Waiter->BlockingProcess;
+    for (Depth = 0; Depth < FILE_LOCK_MAX_DEADLOCK_DEPTH; Depth += 1) {
+        if (Owner == Waiter->Process) {
+            KeReleaseQueuedLock(IoFileLockWaiterLock);
+            return STATUS_DEADLOCK;
+        }
 
-        INSERT_AFTER(&(NewEntry->ListEntry), &(FileObject->FileLockList));
-    }
+        Waiting = NULL;
+        CurrentEntry = IoFileLockWaiterList.Next;
+        while (CurrentEntry != &IoFileLockWaiterList) {
+            Waiting = LIST_VALUE(CurrentEntry, FILE_LOCK_WAITER, ListEntry);
+            if (Waiting->Process == Owner) {
+                break;
+            }
 
-    if (LocksRemoved != FALSE) {
-        KeSignalEvent(FileObject->FileLockEvent, SignalOptionSignalAll);
+            Waiting = NULL;
+            CurrentEntry = CurrentEntry->Next;
+        }
+
+        if (Waiting == NULL) {
+            break;
+        }
+
+        Owner = Waiting->BlockingProcess;
     }
 
-    return Status;
+    INSERT_BEFORE(&(Waiter->ListEntry), &IoFileLockWaiterList);
+    KeReleaseQueuedLock(IoFileLockWaiterLock);
+    return STATUS_SUCCESS;
 }
 
-BOOL
-IopDoFileLocksOverlap (
-    ULONGLONG IncomingOffset,
-    ULONGLONG IncomingSize,
-    PFILE_LOCK_ENTRY LockEntry
+VOID
+IopWakeFileLockWaiters (
+    PFILE_OBJECT FileObject,
+    ULONGLONG Offset,
+    ULONGLONG End
     )
 
 /*++
 
 Routine Description:
 
-    This routine checks to see if the given lock entry overlaps with the
-    incoming lock. The lock types are not checked by this routine, only the
-    regions.
+    This routine wakes the waiters on a file object whose regions overlap the
+    given released region. This routine assumes the file object lock is held
+    exclusively.
 
 Arguments:
 
-    IncomingOffset - Supplies the file offset of the incoming lock.
+    FileObject - Supplies a pointer to the file object.
 
-    IncomingSize - Supplies the file size of the incoming lock.
+    Offset - Supplies the start of the released region.
 
-    LockEntry - Supplies a pointer to the existing lock entry.
+    End - Supplies the end of the released region.
 
 Return Value:
 
-    TRUE if the lock entry overlaps the incoming lock.
-
-    FALSE if the lock entry does not overlap.
+    None.
 
 --*/
 
 {
 
-    //
-    // If the incoming lock goes to the end of the file, then this lock
-    // overlaps if it has an offset greater than the incoming one or its
-    // size is also zero.
-    //
+    PLIST_ENTRY CurrentEntry;
+    PFILE_LOCK_WAITER Waiter;
 
-    if (IncomingSize == 0) {
-        if ((LockEntry->Size == 0) || (LockEntry->Offset >= IncomingOffset)) {
-            return TRUE;
+    CurrentEntry = FileObject->FileLockWaitList.Next;
+    while (CurrentEntry != &(FileObject->FileLockWaitList)) {
+        Waiter = LIST_VALUE(CurrentEntry, FILE_LOCK_WAITER, FileListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if ((Waiter->Offset < End) && (Offset < Waiter->End)) {
+            KeSignalEvent(Waiter->Event, SignalOptionSignalAll);
         }
+    }
 
-    //
-    // The incoming lock spans a specific region. This lock overlaps if
-    // one of these conditions is met:
-    // 1. Size == 0 and the offset starts before the incoming lock's end.
-    // 2. Offset <= IncomingOffset and Offset + Size > IncomingOffset.
-    // 3. Offset > IncomingOffset and Offset < IncomingOffset + IncomingSize.
-    //
+    return;
+}
 
-    } else {
-        if (LockEntry->Size == 0) {
-            if (LockEntry->Offset < IncomingOffset + IncomingSize) {
-                return TRUE;
-            }
+PFILE_LOCK_ENTRY
+IopFindFileLockConflict (
+    PFILE_LOCK_ENTRY Node,
+    ULONGLONG Offset,
+    ULONGLONG End,
+    FILE_LOCK_TYPE Type,
+    PKPROCESS Process
+    )
 
-        } else if (LockEntry->Offset <= IncomingOffset) {
-            if (LockEntry->Offset + LockEntry->Size > IncomingOffset) {
-                return TRUE;
-            }
+/*++
 
-        } else {
-            if (LockEntry->Offset < IncomingOffset + IncomingSize) {
-                return TRUE;
-            }
-        }
+Routine Description:
+
+    This routine finds the lowest lock in the given subtree that overlaps the
+    given region and is incompatible with a lock of the given type.
+
+Arguments:
+
+    Node - Supplies a pointer to the root of the subtree to search.
+
+    Offset - Supplies the start of the region.
+
+    End - Supplies the end of the region.
+
+    Type - Supplies the type of lock being requested. Read locks are
+        compatible with other read locks.
+
+    Process - Supplies an optional pointer to the requesting process, whose
+        own locks never conflict. Supply NULL to consider locks from all
+        processes.
+
+Return Value:
+
+    Returns a pointer to the conflicting lock, or NULL if there is none.
+
+--*/
+
+{
+
+    PFILE_LOCK_ENTRY Found;
+
+    //
+    // Nothing in this subtree reaches the region.
+    //
+
+    if ((Node == NULL) || (Node->MaxEnd <= Offset)) {
+        return NULL;
+    }
+
+    Found = IopFindFileLockConflict(Node->Left, Offset, End, Type, Process);
+    if (Found != NULL) {
+        return Found;
+    }
+
+    //
+    // This node and everything to its right start after the region.
+    //
+
+    if (Node->Offset >= End) {
+        return NULL;
+    }
+
+    if ((IopGetFileLockEnd(Node->Offset, Node->Size) > Offset) &&
+        (Node->Process != Process) &&
+        ((Type != FileLockRead) || (Node->Type != FileLockRead))) {
+
+        return Node;
+    }
+
+    return IopFindFileLockConflict(Node->Right, Offset, End, Type, Process);
+}
+
+VOID
+IopCollectFileLocks (
+    PFILE_LOCK_ENTRY Node,
+    ULONGLONG Offset,
+    ULONGLONG End,
+    PKPROCESS Process,
+    PLIST_ENTRY List
+    )
+
+/*++
+
+Routine Description:
+
+    This routine puts every lock in the given subtree that belongs to the
+    given process and overlaps the given region onto a list. The entries are
+    not removed from the tree.
+
+Arguments:
+
+    Node - Supplies a pointer to the root of the subtree to search.
+
+    Offset - Supplies the start of the region.
+
+    End - Supplies the end of the region.
+
+    Process - Supplies a pointer to the process whose locks to collect.
+
+    List - Supplies a pointer to the list head to add the locks to.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if ((Node == NULL) || (Node->MaxEnd <= Offset)) {
+        return;
+    }
+
+    IopCollectFileLocks(Node->Left, Offset, End, Process, List);
+    if (Node->Offset >= End) {
+        return;
+    }
+
+    if ((Node->Process == Process) &&
+        (IopGetFileLockEnd(Node->Offset, Node->Size) > Offset)) {
+
+        INSERT_BEFORE(&(Node->ListEntry), List);
+    }
+
+    IopCollectFileLocks(Node->Right, Offset, End, Process, List);
+    return;
+}
+
+PFILE_LOCK_ENTRY
+IopInsertFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    PFILE_LOCK_ENTRY Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine inserts a lock into a lock tree.
+
+Arguments:
+
+    Node - Supplies a pointer to the root of the subtree to insert into.
+
+    Entry - Supplies a pointer to the lock to insert.
+
+Return Value:
+
+    Returns the new root of the subtree.
+
+--*/
+
+{
+
+    if (Node == NULL) {
+        Entry->Left = NULL;
+        Entry->Right = NULL;
+        IopUpdateFileLockNode(Entry);
+        return Entry;
+    }
+
+    if (IopIsFileLockBefore(Entry, Node) != FALSE) {
+        Node->Left = IopInsertFileLockNode(Node->Left, Entry);
+
+    } else {
+        Node->Right = IopInsertFileLockNode(Node->Right, Entry);
+    }
+
+    return IopBalanceFileLockNode(Node);
+}
+
+PFILE_LOCK_ENTRY
+IopRemoveFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    PFILE_LOCK_ENTRY Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a lock from a lock tree.
+
+Arguments:
+
+    Node - Supplies a pointer to the root of the subtree containing the lock.
+
+    Entry - Supplies a pointer to the lock to remove.
+
+Return Value:
+
+    Returns the new root of the subtree.
+
+--*/
+
+{
+
+    PFILE_LOCK_ENTRY Minimum;
+    PFILE_LOCK_ENTRY Right;
+
+    ASSERT(Node != NULL);
+
+    if (Node != Entry) {
+        if (IopIsFileLockBefore(Entry, Node) != FALSE) {
+            Node->Left = IopRemoveFileLockNode(Node->Left, Entry);
+
+        } else {
+            Node->Right = IopRemoveFileLockNode(Node->Right, Entry);
+        }
+
+        return IopBalanceFileLockNode(Node);
+    }
+
+    if (Node->Left == NULL) {
+        return Node->Right;
+    }
+
+    if (Node->Right == NULL) {
+        return Node->Left;
+    }
+
+    //
+    // Replace the node with the lowest node from its right subtree.
+    //
+
+    Right = IopRemoveMinimumFileLockNode(Node->Right, &Minimum);
+    Minimum->Left = Node->Left;
+    Minimum->Right = Right;
+    return IopBalanceFileLockNode(Minimum);
+}
+
+PFILE_LOCK_ENTRY
+IopRemoveMinimumFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    PFILE_LOCK_ENTRY *Minimum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the lowest lock from a lock tree.
+
+Arguments:
+
+    Node - Supplies a pointer to the root of the subtree.
+
+    Minimum - Supplies a pointer where the removed lock will be returned.
+
+Return Value:
+
+    Returns the new root of the subtree.
+
+--*/
+
+{
+
+    if (Node->Left == NULL) {
+        *Minimum = Node;
+        return Node->Right;
+    }
+
+    Node->Left = IopRemoveMinimumFileLockNode(Node->Left, Minimum);
+    return IopBalanceFileLockNode(Node);
+}
+
+PFILE_LOCK_ENTRY
+IopBalanceFileLockNode (
+    PFILE_LOCK_ENTRY Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine restores the AVL balance at the given node, whose subtrees
+    are balanced and differ in height by at most two.
+
+Arguments:
+
+    Node - Supplies a pointer to the node to balance.
+
+Return Value:
+
+    Returns the new root of the subtree.
+
+--*/
+
+{
+
+    LONG Balance;
+    ULONG LeftHeight;
+    ULONG RightHeight;
+
+    LeftHeight = 0;
+    if (Node->Left != NULL) {
+        LeftHeight = Node->Left->Height;
+    }
+
+    RightHeight = 0;
+    if (Node->Right != NULL) {
+        RightHeight = Node->Right->Height;
+    }
+
+    Balance = (LONG)LeftHeight - (LONG)RightHeight;
+    if (Balance > 1) {
+        LeftHeight = 0;
+        if (Node->Left->Left != NULL) {
+            LeftHeight = Node->Left->Left->Height;
+        }
+
+        RightHeight = 0;
+        if (Node->Left->Right != NULL) {
+            RightHeight = Node->Left->Right->Height;
+        }
+
+        if (LeftHeight < RightHeight) {
+            Node->Left = IopRotateFileLockNode(Node->Left, TRUE);
+        }
+
+        return IopRotateFileLockNode(Node, FALSE);
+    }
+
+    if (Balance < -1) {
+        LeftHeight = 0;
+        if (Node->Right->Left != NULL) {
+            LeftHeight = Node->Right->Left->Height;
+        }
+
+        RightHeight = 0;
+        if (Node->Right->Right != NULL) {
+            RightHeight = Node->Right->Right->Height;
+        }
+
+        if (RightHeight < LeftHeight) {
+            Node->Right = IopRotateFileLockNode(Node->Right, FALSE);
+        }
+
+        return IopRotateFileLockNode(Node, TRUE);
+    }
+
+    IopUpdateFileLockNode(Node);
+    return Node;
+}
+
+PFILE_LOCK_ENTRY
+IopRotateFileLockNode (
+    PFILE_LOCK_ENTRY Node,
+    BOOL Left
+    )
+
+/*++
+
+Routine Description:
+
+    This routine rotates a lock tree node, updating the augmented data.
+
+Arguments:
+
+    Node - Supplies a pointer to the node to rotate.
+
+    Left - Supplies a boolean indicating whether to rotate left (TRUE), in
+        which case the right child becomes the root, or right (FALSE).
+
+Return Value:
+
+    Returns the new root of the subtree.
+
+--*/
+
+{
+
+    PFILE_LOCK_ENTRY Pivot;
+
+    if (Left != FALSE) {
+        Pivot = Node->Right;
+        Node->Right = Pivot->Left;
+        Pivot->Left = Node;
+
+    } else {
+        Pivot = Node->Left;
+        Node->Left = Pivot->Right;
+        Pivot->Right = Node;
+    }
+
+    IopUpdateFileLockNode(Node);
+    IopUpdateFileLockNode(Pivot);
+    return Pivot;
+}
+
+VOID
+IopUpdateFileLockNode (
+    PFILE_LOCK_ENTRY Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine recomputes the height and maximum end offset of a lock tree
+    node from its children.
+
+Arguments:
+
+    Node - Supplies a pointer to the node to update.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Height;
+    ULONGLONG MaxEnd;
+
+    Height = 0;
+    MaxEnd = IopGetFileLockEnd(Node->Offset, Node->Size);
+    if (Node->Left != NULL) {
+        Height = Node->Left->Height;
+        if (Node->Left->MaxEnd > MaxEnd) {
+            MaxEnd = Node->Left->MaxEnd;
+        }
+    }
+
+    if (Node->Right != NULL) {
+        if (Node->Right->Height > Height) {
+            Height = Node->Right->Height;
+        }
+
+        if (Node->Right->MaxEnd > MaxEnd) {
+            MaxEnd = Node->Right->MaxEnd;
+        }
+    }
+
+    Node->Height = Height + 1;
+    Node->MaxEnd = MaxEnd;
+    return;
+}
+
+BOOL
+IopIsFileLockBefore (
+    PFILE_LOCK_ENTRY First,
+    PFILE_LOCK_ENTRY Second
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines the order of two locks in a lock tree. Locks are
+    ordered by offset, with ties broken by address, since locks from
+    different processes can start at the same place.
+
+Arguments:
+
+    First - Supplies a pointer to the first lock.
+
+    Second - Supplies a pointer to the second lock.
+
+Return Value:
+
+    TRUE if the first lock sorts before the second.
+
+    FALSE otherwise.
+
+--*/
+
+{
+
+    if (First->Offset != Second->Offset) {
+        return First->Offset < Second->Offset;
+    }
+
+    return (UINTN)First < (UINTN)Second;
+}
+
+ULONGLONG
+IopGetFileLockEnd (
+    ULONGLONG Offset,
+    ULONGLONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the exclusive end offset of a lock region.
+
+Arguments:
+
+    Offset - Supplies the start of the region.
+
+    Size - Supplies the size of the region. Zero means the region extends to
+        the end of the file, however far that goes.
+
+Return Value:
+
+    Returns the end offset, or MAX_ULONGLONG if the region is unbounded.
+
+--*/
+
+{
+
+    if ((Size == 0) || (Offset + Size < Offset)) {
+        return MAX_ULONGLONG;
     }
 
-    return FALSE;
+    return Offset + Size;
 }
 
@@ -128,6 +128,10 @@ Return Value:
         Status = IopGetCacheStatistics(Data, DataSize, Set);
         break;
 
+    case IoInformationBlockDeviceStatistics:
+        Status = IopGetBlockDeviceStatistics(Data, DataSize, Set);
+        break;
+
     default:
         Status = STATUS_INVALID_PARAMETER;
         *DataSize = 0;
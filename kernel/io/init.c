@@ -39,6 +39,17 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the default and maximum number of threads servicing the device work
+// queue. Each device's work is processed in order by one thread at a time,
+// but separate devices, such as sibling subtrees being probed, proceed in
+// parallel up to this limit. Device start is dominated by waiting on
+// hardware, so this does not need to track the processor count.
+//
+
+#define IO_DEVICE_WORKER_DEFAULT_THREADS 4
+#define IO_DEVICE_WORKER_MAX_THREADS 16
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -99,6 +110,11 @@ IopInitializePhysicalAddressArbiterIterator (
     PVOID Context
     );
 
+ULONG
+IopGetDeviceWorkerThreadCount (
+    VOID
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -135,6 +151,7 @@ Return Value:
 
     PBOOT_ENTRY BootEntry;
     ULONG Flags;
+    ULONGLONG PhaseStart;
     KSTATUS Status;
     UINTN SystemDirectorySize;
 
@@ -298,6 +315,15 @@ Return Value:
         goto InitializeEnd;
     }
 
+    //
+    // Initialize support for user mode file locks.
+    //
+
+    Status = IopInitializeFileLockSupport();
+    if (!KSUCCESS(Status)) {
+        goto InitializeEnd;
+    }
+
     //
     // Initialize support for path traversal.
     //
@@ -320,11 +346,17 @@ Return Value:
     // Initialize support for the page cache.
     //
 
+    PhaseStart = KeGetBootTimelineTimestamp();
     Status = IopInitializePageCache();
     if (!KSUCCESS(Status)) {
         goto InitializeEnd;
     }
 
+    KeRecordBootTimelineEvent(BootTimelineEventKernelPhase,
+                              "IopInitializePageCache",
+                              PhaseStart,
+                              KeGetBootTimelineTimestamp());
+
     //
     // Initialize support for terminals.
     //
@@ -343,6 +375,33 @@ Return Value:
         goto InitializeEnd;
     }
 
+    //
+    // Initialize file watch support.
+    //
+
+    Status = IopInitializeFileWatchSupport();
+    if (!KSUCCESS(Status)) {
+        goto InitializeEnd;
+    }
+
+    //
+    // Initialize asynchronous I/O support.
+    //
+
+    Status = IopInitializeAsyncIoSupport();
+    if (!KSUCCESS(Status)) {
+        goto InitializeEnd;
+    }
+
+    //
+    // Initialize block device request queues.
+    //
+
+    Status = IopInitializeBlockQueues();
+    if (!KSUCCESS(Status)) {
+        goto InitializeEnd;
+    }
+
     //
     // Initialize the device database.
     //
@@ -424,7 +483,9 @@ Return Value:
 
 {
 
+    PKERNEL_ARGUMENT Argument;
     KSTATUS Status;
+    ULONG ThreadCount;
     ULONG WorkQueueFlags;
 
     WorkQueueFlags = WORK_QUEUE_FLAG_SUPPORT_DISPATCH_LEVEL;
@@ -434,6 +495,27 @@ Return Value:
         goto InitializeDeviceSupportEnd;
     }
 
+    //
+    // The work queue comes with one thread. Add the rest so that independent
+    // devices can be started and enumerated concurrently.
+    //
+
+    ThreadCount = IopGetDeviceWorkerThreadCount();
+    if (ThreadCount > 1) {
+        Status = KeAddWorkQueueThreads(IoDeviceWorkQueue, ThreadCount - 1);
+        if (!KSUCCESS(Status)) {
+            goto InitializeDeviceSupportEnd;
+        }
+    }
+
+    Argument = KeGetKernelArgument(NULL,
+                                   IO_KERNEL_ARGUMENT_COMPONENT,
+                                   IO_KERNEL_ARGUMENT_START_TIMES);
+
+    if (Argument != NULL) {
+        IoPrintDeviceStartTimes = TRUE;
+    }
+
     //
     // Create and initialize the root device.
     //
@@ -1066,3 +1148,58 @@ Return Value:
     return;
 }
 
+ULONG
+IopGetDeviceWorkerThreadCount (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines how many threads should service the device work
+    queue, honoring the kernel command line if it specifies a count.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the number of device worker threads, at least one.
+
+--*/
+
+{
+
+    PKERNEL_ARGUMENT Argument;
+    LONGLONG Count;
+    PCSTR String;
+    ULONG StringSize;
+    KSTATUS Status;
+
+    Argument = KeGetKernelArgument(NULL,
+                                   IO_KERNEL_ARGUMENT_COMPONENT,
+                                   IO_KERNEL_ARGUMENT_DEVICE_WORKERS);
+
+    if ((Argument == NULL) || (Argument->ValueCount == 0)) {
+        return IO_DEVICE_WORKER_DEFAULT_THREADS;
+    }
+
+    String = Argument->Values[0];
+    StringSize = RtlStringLength(String) + 1;
+    Status = RtlStringScanInteger(&String, &StringSize, 10, FALSE, &Count);
+    if (!KSUCCESS(Status)) {
+        return IO_DEVICE_WORKER_DEFAULT_THREADS;
+    }
+
+    if (Count < 1) {
+        Count = 1;
+
+    } else if (Count > IO_DEVICE_WORKER_MAX_THREADS) {
+        Count = IO_DEVICE_WORKER_MAX_THREADS;
+    }
+
+    return (ULONG)Count;
+}
+
@@ -40,6 +40,13 @@ Module Name:
 
 #define IO_RENAME_ATTEMPTS_MAX 10000
 
+//
+// Define the largest bounce buffer used to read directory entries from a file
+// system that does not return file properties itself.
+//
+
+#define IO_DIRECTORY_PROPERTIES_BOUNCE_SIZE _64KB
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -106,9 +113,21 @@ IopAddRelativeDirectoryEntries (
     PIO_OFFSET Offset,
     PIO_BUFFER IoBuffer,
     UINTN BufferSize,
+    ULONG Flags,
     PUINTN BytesConsumed
     );
 
+KSTATUS
+IopAddDirectoryEntryProperties (
+    PIO_HANDLE Handle,
+    PVOID Entries,
+    UINTN EntriesSize,
+    PIO_BUFFER IoBuffer,
+    UINTN BufferSize,
+    PUINTN BytesConsumed,
+    PIO_OFFSET NextOffset
+    );
+
 VOID
 IopFixMountPointDirectoryEntries (
     PIO_HANDLE Handle,
@@ -1199,6 +1218,7 @@ Return Value:
     BOOL StatusChanged;
     PKTHREAD Thread;
     BOOL Updated;
+    ULONG WatchEvents;
 
     LockHeldExclusive = FALSE;
     LockHeldShared = FALSE;
@@ -1468,6 +1488,15 @@ Return Value:
 
     if (Updated != FALSE) {
         IopMarkFileObjectPropertiesDirty(FileObject);
+        if (IoFileWatchCount != 0) {
+            WatchEvents = FILE_WATCH_EVENT_ATTRIBUTES;
+            if (ModifyFileSize != FALSE) {
+                WatchEvents |= FILE_WATCH_EVENT_MODIFY;
+            }
+
+            IopNotifyPathEntryWatches(Handle->PathPoint.PathEntry,
+                                      WatchEvents);
+        }
     }
 
     Status = STATUS_SUCCESS;
@@ -1677,6 +1706,7 @@ Return Value:
     PATH_POINT SourcePathPoint;
     PPATH_POINT SourceStartPathPoint;
     KSTATUS Status;
+    PFILE_OBJECT WatchDirectory;
 
     DestinationDirectory = NULL;
     DestinationDirectoryPathPoint.PathEntry = NULL;
@@ -2232,6 +2262,25 @@ Return Value:
         IopFileObjectDecrementHardLinkCount(DestinationFileObject);
         IopPathUnlink(DestinationPathPoint.PathEntry);
 
+        //
+        // A file replaced by the rename only changes from its own point of
+        // view; the directory sees the moved file arrive under that name.
+        //
+
+        if (IoFileWatchCount != 0) {
+            WatchDirectory = NULL;
+            if (!KSUCCESS(Status)) {
+                WatchDirectory = DestinationDirectoryFileObject;
+            }
+
+            IopNotifyFileWatches(WatchDirectory,
+                                 DestinationFile,
+                                 DestinationFileSize,
+                                 DestinationFileObject,
+                                 FILE_WATCH_EVENT_DELETE,
+                                 0);
+        }
+
     //
     // If there's a negative destination entry, remove it. The rename moved
     // the source onto the destination, in which case the file object
@@ -2261,6 +2310,15 @@ Return Value:
             IopUpdateFileObjectTime(DestinationDirectoryFileObject,
                                     FileObjectModifiedTime);
 
+            if (IoFileWatchCount != 0) {
+                IopNotifyFileWatches(DestinationDirectoryFileObject,
+                                     DestinationFile,
+                                     DestinationFileSize,
+                                     SourceFileObject,
+                                     FILE_WATCH_EVENT_CREATE,
+                                     0);
+            }
+
         //
         // Otherwise, the delta is -1. Decrement the hard link count and unlink
         // it from the source path entry. Unfortunately, this rename turned
@@ -2272,6 +2330,15 @@ Return Value:
             ASSERT(RenameRequest.SourceFileHardLinkDelta == (ULONG)-1);
 
             IopFileObjectDecrementHardLinkCount(SourceFileObject);
+            if (IoFileWatchCount != 0) {
+                IopNotifyFileWatches(SourceDirectoryFileObject,
+                                     SourcePathPoint.PathEntry->Name,
+                                     SourcePathPoint.PathEntry->NameSize,
+                                     SourceFileObject,
+                                     FILE_WATCH_EVENT_DELETE,
+                                     0);
+            }
+
             IopPathUnlink(SourcePathPoint.PathEntry);
             IopUpdateFileObjectTime(SourceDirectoryFileObject,
                                     FileObjectModifiedTime);
@@ -2299,9 +2366,8 @@ Return Value:
                                        SourceFileObject);
 
             if (NewPathEntry != NULL) {
-                INSERT_BEFORE(
-                        &(NewPathEntry->SiblingListEntry),
-                        &(DestinationDirectoryPathPoint.PathEntry->ChildList));
+                IopPathInsertChild(DestinationDirectoryPathPoint.PathEntry,
+                                   NewPathEntry);
 
                 IopFileObjectAddReference(SourceFileObject);
             }
@@ -2326,6 +2392,16 @@ Return Value:
 
         IopUpdateFileObjectTime(SourceDirectoryFileObject,
                                 FileObjectModifiedTime);
+
+        if (IoFileWatchCount != 0) {
+            IopNotifyFileWatchesOfRename(SourceDirectoryFileObject,
+                                         SourcePathPoint.PathEntry->Name,
+                                         SourcePathPoint.PathEntry->NameSize,
+                                         DestinationDirectoryFileObject,
+                                         DestinationFile,
+                                         DestinationFileSize,
+                                         SourceFileObject);
+        }
     }
 
     IopUpdateFileObjectTime(SourceFileObject, FileObjectStatusTime);
@@ -3415,6 +3491,11 @@ Return Value:
             if (!KSUCCESS(Status)) {
                 goto OpenPathEntryEnd;
             }
+
+            if (IoFileWatchCount != 0) {
+                IopNotifyPathEntryWatches(NewHandle->PathPoint.PathEntry,
+                                          FILE_WATCH_EVENT_MODIFY);
+            }
         }
 
         Status = STATUS_SUCCESS;
@@ -3465,6 +3546,24 @@ Return Value:
         Status = IopTerminalOpenSlave(NewHandle);
         break;
 
+    case IoObjectEventPoll:
+    case IoObjectEventCounter:
+    case IoObjectFileWatch:
+        Status = STATUS_SUCCESS;
+        break;
+
+    case IoObjectAsyncIoContext:
+        Status = IopOpenAsyncIoContext(NewHandle);
+        break;
+
+    case IoObjectIoRing:
+        Status = IopOpenIoRing(NewHandle);
+        break;
+
+    case IoObjectTimer:
+        Status = IopOpenIoTimer(NewHandle);
+        break;
+
     case IoObjectSharedMemoryObject:
         if ((Flags & OPEN_FLAG_TRUNCATE) != 0) {
             Status = IopModifyFileObjectSize(FileObject, NULL, 0);
@@ -3672,6 +3771,39 @@ Return Value:
 
         break;
 
+    case IoObjectEventPoll:
+        Status = IopCreateEventPoll(CreatePermissions, FileObject);
+        break;
+
+    case IoObjectEventCounter:
+        Status = IopCreateEventCounter(OverrideParameter,
+                                       CreatePermissions,
+                                       FileObject);
+
+        break;
+
+    case IoObjectTimer:
+        Status = IopCreateIoTimer(OverrideParameter,
+                                  CreatePermissions,
+                                  FileObject);
+
+        break;
+
+    case IoObjectAsyncIoContext:
+        Status = IopCreateAsyncIoContext(CreatePermissions, FileObject);
+        break;
+
+    case IoObjectIoRing:
+        Status = IopCreateIoRing(OverrideParameter,
+                                 CreatePermissions,
+                                 FileObject);
+
+        break;
+
+    case IoObjectFileWatch:
+        Status = IopCreateFileWatch(CreatePermissions, FileObject);
+        break;
+
     default:
 
         ASSERT(FALSE);
@@ -3714,6 +3846,12 @@ Return Value:
     FileObject = NULL;
     if (IoHandle->PathPoint.PathEntry != NULL) {
         FileObject = IoHandle->FileObject;
+
+        //
+        // Stop any event poll objects from watching this handle.
+        //
+
+        IopRemoveEventPollWatches(IoHandle);
         switch (FileObject->Properties.Type) {
         case IoObjectRegularFile:
         case IoObjectRegularDirectory:
@@ -3762,6 +3900,22 @@ Return Value:
             Status = IopTerminalCloseSlave(IoHandle);
             break;
 
+        case IoObjectEventPoll:
+            Status = IopCloseEventPoll(IoHandle);
+            break;
+
+        case IoObjectTimer:
+            Status = IopCloseIoTimer(IoHandle);
+            break;
+
+        case IoObjectAsyncIoContext:
+            Status = IopCloseAsyncIoContext(IoHandle);
+            break;
+
+        case IoObjectIoRing:
+            Status = IopCloseIoRing(IoHandle);
+            break;
+
         default:
             Status = STATUS_SUCCESS;
             break;
@@ -4104,6 +4258,14 @@ Return Value:
 
     if (Unlinked != FALSE) {
         IopPathCleanCache(PathPoint->PathEntry);
+        if (IoFileWatchCount != 0) {
+            IopNotifyFileWatches(DirectoryFileObject,
+                                 PathPoint->PathEntry->Name,
+                                 PathPoint->PathEntry->NameSize,
+                                 FileObject,
+                                 FILE_WATCH_EVENT_DELETE,
+                                 0);
+        }
     }
 
     if (!KSUCCESS(Status)) {
@@ -5298,6 +5460,16 @@ Return Value:
         Context->Flags |= IO_FLAG_DATA_SYNCHRONIZED;
     }
 
+    //
+    // Only directory reads know how to return file properties.
+    //
+
+    if ((FileObject->Properties.Type != IoObjectRegularDirectory) &&
+        (FileObject->Properties.Type != IoObjectObjectDirectory)) {
+
+        Context->Flags &= ~IO_FLAG_DIRECTORY_PROPERTIES;
+    }
+
     //
     // Fail if the caller hadn't opened the file with the correct access.
     //
@@ -5355,6 +5527,34 @@ Return Value:
         Status = IopPerformObjectIoOperation(Handle, Context);
         break;
 
+    //
+    // Event poll objects are waited on, not read or written.
+    //
+
+    case IoObjectEventPoll:
+        Status = STATUS_INVALID_PARAMETER;
+        break;
+
+    case IoObjectEventCounter:
+        Status = IopPerformEventCounterIoOperation(Handle, Context);
+        break;
+
+    case IoObjectTimer:
+        Status = IopPerformIoTimerIoOperation(Handle, Context);
+        break;
+
+    case IoObjectAsyncIoContext:
+        Status = IopPerformAsyncIoContextIoOperation(Handle, Context);
+        break;
+
+    case IoObjectIoRing:
+        Status = IopPerformIoRingIoOperation(Handle, Context);
+        break;
+
+    case IoObjectFileWatch:
+        Status = IopPerformFileWatchIoOperation(Handle, Context);
+        break;
+
     default:
 
         ASSERT(FALSE);
@@ -5574,6 +5774,11 @@ Return Value:
 
 {
 
+    PIO_BUFFER BounceBuffer;
+    PVOID BounceData;
+    UINTN BounceSize;
+    UINTN BytesCompleted;
+    KSTATUS CopyStatus;
     PDEVICE Device;
     PFILE_OBJECT FileObject;
     BOOL LockHeldExclusive;
@@ -5581,8 +5786,12 @@ Return Value:
     KSTATUS Status;
 
     ASSERT(Context->IoBuffer != NULL);
-    ASSERT((Context->Write == FALSE) && (Context->Flags == 0));
+    ASSERT(Context->Write == FALSE);
+    ASSERT((Context->Flags & ~IO_FLAG_DIRECTORY_PROPERTIES) == 0);
 
+    BounceBuffer = NULL;
+    BounceData = NULL;
+    BytesCompleted = 0;
     Context->BytesCompleted = 0;
     Parameters.IoBytesCompleted = Context->BytesCompleted;
     FileObject = Handle->FileObject;
@@ -5613,6 +5822,7 @@ Return Value:
                                             &(Parameters.IoOffset),
                                             Context->IoBuffer,
                                             Context->SizeInBytes,
+                                            Context->Flags,
                                             &(Parameters.IoBytesCompleted));
 
     Parameters.NewIoOffset = Parameters.IoOffset;
@@ -5639,6 +5849,45 @@ Return Value:
     Parameters.TimeoutInMilliseconds = Context->TimeoutInMilliseconds;
     Parameters.IoSizeInBytes = Context->SizeInBytes;
     Parameters.FileProperties = &(FileObject->Properties);
+    BytesCompleted = Parameters.IoBytesCompleted;
+
+    //
+    // If file properties were requested, have the file system read into a
+    // bounce buffer. Entries the file system did not fill in properties for
+    // grow as they are copied out, so the bounce buffer need not be any
+    // larger than the remainder of the caller's buffer.
+    //
+
+    if ((Context->Flags & IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+        BounceSize = Context->SizeInBytes - BytesCompleted;
+        if (BounceSize > IO_DIRECTORY_PROPERTIES_BOUNCE_SIZE) {
+            BounceSize = IO_DIRECTORY_PROPERTIES_BOUNCE_SIZE;
+        }
+
+        if (BounceSize < sizeof(DIRECTORY_ENTRY)) {
+            Status = STATUS_MORE_PROCESSING_REQUIRED;
+            goto PerformDirectoryIoOperationEnd;
+        }
+
+        BounceData = MmAllocatePagedPool(BounceSize, IO_ALLOCATION_TAG);
+        if (BounceData == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto PerformDirectoryIoOperationEnd;
+        }
+
+        Status = MmCreateIoBuffer(BounceData,
+                                  BounceSize,
+                                  IO_BUFFER_FLAG_KERNEL_MODE_DATA,
+                                  &BounceBuffer);
+
+        if (!KSUCCESS(Status)) {
+            goto PerformDirectoryIoOperationEnd;
+        }
+
+        Parameters.IoBuffer = BounceBuffer;
+        Parameters.IoSizeInBytes = BounceSize;
+        Parameters.IoBytesCompleted = 0;
+    }
 
     //
     // Acquire the file lock in shared mode and fire off the I/O!
@@ -5661,6 +5910,49 @@ Return Value:
     }
 
 PerformDirectoryIoOperationEnd:
+    if (LockHeldExclusive != FALSE) {
+        KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
+
+    } else {
+        KeReleaseSharedExclusiveLockShared(FileObject->Lock);
+    }
+
+    //
+    // Copy the entries out of the bounce buffer, adding properties along the
+    // way. This may need to look up children of this directory, so it must be
+    // done without the directory lock held. The new offset is wherever the
+    // copy stopped.
+    //
+
+    if (BounceBuffer != NULL) {
+        if ((KSUCCESS(Status)) ||
+            (Status == STATUS_END_OF_FILE) ||
+            (Status == STATUS_MORE_PROCESSING_REQUIRED)) {
+
+            Parameters.NewIoOffset = Parameters.IoOffset;
+            if (Parameters.IoBytesCompleted != 0) {
+                CopyStatus = IopAddDirectoryEntryProperties(
+                                                Handle,
+                                                BounceData,
+                                                Parameters.IoBytesCompleted,
+                                                Context->IoBuffer,
+                                                Context->SizeInBytes,
+                                                &BytesCompleted,
+                                                &(Parameters.NewIoOffset));
+
+                if (CopyStatus != STATUS_SUCCESS) {
+                    Status = CopyStatus;
+                }
+            }
+        }
+
+        Parameters.IoBytesCompleted = BytesCompleted;
+        MmFreeIoBuffer(BounceBuffer);
+    }
+
+    if (BounceData != NULL) {
+        MmFreePagedPool(BounceData);
+    }
 
     //
     // Adjust the current offset.
@@ -5671,13 +5963,6 @@ Return Value:
                             Parameters.NewIoOffset);
     }
 
-    if (LockHeldExclusive != FALSE) {
-        KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
-
-    } else {
-        KeReleaseSharedExclusiveLockShared(FileObject->Lock);
-    }
-
     //
     // Modify the file IDs of any directory entries that are mount points.
     // This needs to happen for any directory entries read from disk.
@@ -5699,6 +5984,7 @@ IopAddRelativeDirectoryEntries (
     PIO_OFFSET Offset,
     PIO_BUFFER IoBuffer,
     UINTN BufferSize,
+    ULONG Flags,
     PUINTN BytesConsumed
     )
 
@@ -5721,6 +6007,10 @@ Routine Description:
 
     BufferSize - Supplies the size of the I/O buffer, in bytes.
 
+    Flags - Supplies the I/O flags for the read. If
+        IO_FLAG_DIRECTORY_PROPERTIES is set, the entries include the file
+        properties of the directory and its parent.
+
     BytesConsumed - Supplies the a pointer that on input contains the number
         of bytes in the buffer that have already been used. On output, it will
         contain the updated number of bytes used.
@@ -5735,13 +6025,14 @@ Return Value:
 {
 
     UINTN BytesAvailable;
-    PDIRECTORY_ENTRY Entry;
+    DIRECTORY_ENTRY Entry;
     ULONG EntrySize;
     PFILE_OBJECT FileObject;
     IO_OFFSET FileOffset;
-    UCHAR LocalBuffer[sizeof(DIRECTORY_ENTRY) + sizeof("..") + 8];
     PATH_POINT Parent;
     PKPROCESS Process;
+    FILE_PROPERTIES Properties;
+    PFILE_PROPERTIES PropertiesPointer;
     PPATH_POINT Root;
     KSTATUS Status;
 
@@ -5749,7 +6040,11 @@ Return Value:
 
     BytesAvailable = BufferSize - *BytesConsumed;
     FileOffset = *Offset;
-    Entry = (PDIRECTORY_ENTRY)LocalBuffer;
+    PropertiesPointer = NULL;
+    if ((Flags & IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+        PropertiesPointer = &Properties;
+    }
+
     Status = STATUS_MORE_PROCESSING_REQUIRED;
 
     //
@@ -5759,38 +6054,51 @@ Return Value:
 
     if (FileOffset == DIRECTORY_OFFSET_DOT) {
         EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + sizeof("."), 8);
+        if (PropertiesPointer != NULL) {
+            EntrySize = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(sizeof("."));
+        }
+
         if (BytesAvailable > EntrySize) {
-            Entry->Size = EntrySize;
-            Entry->Type = IoObjectRegularDirectory;
-            Entry->NextOffset = DIRECTORY_OFFSET_DOT_DOT;
+            Entry.Type = IoObjectRegularDirectory;
+            Entry.NextOffset = DIRECTORY_OFFSET_DOT_DOT;
             FileObject = Handle->FileObject;
 
             ASSERT(FileObject == Handle->PathPoint.PathEntry->FileObject);
 
-            Entry->FileId = FileObject->Properties.FileId;
-            RtlCopyMemory(Entry + 1, ".", sizeof("."));
-            Status = MmCopyIoBufferData(IoBuffer,
-                                        Entry,
-                                        *BytesConsumed,
-                                        EntrySize,
-                                        TRUE);
+            Entry.FileId = FileObject->Properties.FileId;
+            if (PropertiesPointer != NULL) {
+                IopGetFileObjectProperties(FileObject, PropertiesPointer);
+            }
+
+            Status = IopWriteDirectoryEntry(IoBuffer,
+                                            *BytesConsumed,
+                                            &Entry,
+                                            ".",
+                                            sizeof("."),
+                                            PropertiesPointer);
 
             if (!KSUCCESS(Status)) {
                 goto AddRelativeDirectoryEntriesEnd;
             }
 
+            ASSERT(Entry.Size == EntrySize);
+
             *BytesConsumed += EntrySize;
             BytesAvailable -= EntrySize;
-            FileOffset = Entry->NextOffset;
+            FileOffset = Entry.NextOffset;
+            Status = STATUS_MORE_PROCESSING_REQUIRED;
         }
     }
 
     if (FileOffset == DIRECTORY_OFFSET_DOT_DOT) {
         EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + sizeof(".."), 8);
+        if (PropertiesPointer != NULL) {
+            EntrySize = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(sizeof(".."));
+        }
+
         if (BytesAvailable > EntrySize) {
-            Entry->Size = EntrySize;
-            Entry->Type = IoObjectRegularDirectory;
-            Entry->NextOffset = DIRECTORY_CONTENTS_OFFSET;
+            Entry.Type = IoObjectRegularDirectory;
+            Entry.NextOffset = DIRECTORY_CONTENTS_OFFSET;
 
             //
             // Get the parent path point. Provide the process root to prevent
@@ -5807,22 +6115,29 @@ Return Value:
 
             IopGetParentPathPoint(Root, &(Handle->PathPoint), &Parent);
             FileObject = Parent.PathEntry->FileObject;
+            Entry.FileId = FileObject->Properties.FileId;
+            if (PropertiesPointer != NULL) {
+                IopGetFileObjectProperties(FileObject, PropertiesPointer);
+            }
+
             IO_PATH_POINT_RELEASE_REFERENCE(&Parent);
-            Entry->FileId = FileObject->Properties.FileId;
-            RtlCopyMemory(Entry + 1, "..", sizeof(".."));
-            Status = MmCopyIoBufferData(IoBuffer,
-                                        Entry,
-                                        *BytesConsumed,
-                                        EntrySize,
-                                        TRUE);
+            Status = IopWriteDirectoryEntry(IoBuffer,
+                                            *BytesConsumed,
+                                            &Entry,
+                                            "..",
+                                            sizeof(".."),
+                                            PropertiesPointer);
 
             if (!KSUCCESS(Status)) {
                 goto AddRelativeDirectoryEntriesEnd;
             }
 
+            ASSERT(Entry.Size == EntrySize);
+
             *BytesConsumed += EntrySize;
             BytesAvailable -= EntrySize;
-            FileOffset = Entry->NextOffset;
+            FileOffset = Entry.NextOffset;
+            Status = STATUS_MORE_PROCESSING_REQUIRED;
         }
     }
 
@@ -5835,6 +6150,260 @@ Return Value:
     return Status;
 }
 
+KSTATUS
+IopAddDirectoryEntryProperties (
+    PIO_HANDLE Handle,
+    PVOID Entries,
+    UINTN EntriesSize,
+    PIO_BUFFER IoBuffer,
+    UINTN BufferSize,
+    PUINTN BytesConsumed,
+    PIO_OFFSET NextOffset
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies directory entries read from a file system out to the
+    caller's buffer, attaching the file properties of each entry. Properties
+    of files with a live file object come from the file object, as those are
+    the most current. Otherwise the properties the file system returned are
+    used, and if the file system did not return any, the entry is looked up.
+    Entries that have disappeared by the time they are looked up are skipped.
+
+Arguments:
+
+    Handle - Supplies the open directory handle the entries were read from.
+
+    Entries - Supplies a pointer to the directory entries read from the file
+        system.
+
+    EntriesSize - Supplies the size of the directory entries, in bytes.
+
+    IoBuffer - Supplies a pointer to the caller's I/O buffer.
+
+    BufferSize - Supplies the size of the caller's I/O buffer, in bytes.
+
+    BytesConsumed - Supplies the a pointer that on input contains the number
+        of bytes in the caller's buffer that have already been used. On
+        output, it will contain the updated number of bytes used.
+
+    NextOffset - Supplies a pointer that receives the directory offset to
+        continue reading from after the last entry consumed. This is left
+        untouched if no entries are consumed.
+
+Return Value:
+
+    STATUS_SUCCESS if all the entries were consumed.
+
+    STATUS_MORE_PROCESSING_REQUIRED if the caller's buffer filled up first.
+
+    Other error codes on failure.
+
+--*/
+
+{
+
+    PATH_POINT ChildPathPoint;
+    DEVICE_ID DeviceId;
+    PDIRECTORY_ENTRY Entry;
+    UINTN EntryOffset;
+    PSTR Name;
+    ULONG NameSize;
+    DIRECTORY_ENTRY NewEntry;
+    ULONG NewEntrySize;
+    FILE_PROPERTIES Properties;
+    KSTATUS Status;
+
+    DeviceId = Handle->FileObject->Properties.DeviceId;
+    EntryOffset = 0;
+    Status = STATUS_SUCCESS;
+    while (EntryOffset + sizeof(DIRECTORY_ENTRY) <= EntriesSize) {
+        Entry = Entries + EntryOffset;
+        if ((Entry->Size <= sizeof(DIRECTORY_ENTRY)) ||
+            (EntryOffset + Entry->Size > EntriesSize)) {
+
+            ASSERT(FALSE);
+
+            Status = STATUS_FILE_CORRUPT;
+            break;
+        }
+
+        Name = (PSTR)(Entry + 1);
+        NameSize = RtlStringLength(Name) + 1;
+
+        ASSERT(((Entry->Type & DIRECTORY_ENTRY_TYPE_PROPERTIES) == 0) ||
+               (Entry->Size ==
+                DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(NameSize)));
+
+        NewEntrySize = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(NameSize);
+        if (*BytesConsumed + NewEntrySize > BufferSize) {
+            Status = STATUS_MORE_PROCESSING_REQUIRED;
+            break;
+        }
+
+        if (IopGetCachedFileObjectProperties(DeviceId,
+                                             Entry->FileId,
+                                             &Properties) == FALSE) {
+
+            if ((Entry->Type & DIRECTORY_ENTRY_TYPE_PROPERTIES) != 0) {
+                RtlCopyMemory(&Properties,
+                              DIRECTORY_ENTRY_PROPERTIES(Entry),
+                              sizeof(FILE_PROPERTIES));
+
+                Properties.DeviceId = DeviceId;
+
+            } else {
+                Status = IopPathLookup(TRUE,
+                                       NULL,
+                                       &(Handle->PathPoint),
+                                       FALSE,
+                                       Name,
+                                       NameSize,
+                                       OPEN_FLAG_NO_MOUNT_POINT,
+                                       IoObjectInvalid,
+                                       NULL,
+                                       0,
+                                       &ChildPathPoint);
+
+                if (KSUCCESS(Status)) {
+                    IopGetFileObjectProperties(
+                                          ChildPathPoint.PathEntry->FileObject,
+                                          &Properties);
+                }
+
+                if (ChildPathPoint.PathEntry != NULL) {
+                    IO_PATH_POINT_RELEASE_REFERENCE(&ChildPathPoint);
+                }
+
+                //
+                // Skip entries that were removed since the directory was
+                // read.
+                //
+
+                if (Status == STATUS_PATH_NOT_FOUND) {
+                    Status = STATUS_SUCCESS;
+                    *NextOffset = Entry->NextOffset;
+                    EntryOffset += Entry->Size;
+                    continue;
+                }
+
+                if (!KSUCCESS(Status)) {
+                    break;
+                }
+            }
+        }
+
+        NewEntry.FileId = Entry->FileId;
+        NewEntry.NextOffset = Entry->NextOffset;
+        NewEntry.Type = Entry->Type & DIRECTORY_ENTRY_TYPE_MASK;
+        Status = IopWriteDirectoryEntry(IoBuffer,
+                                        *BytesConsumed,
+                                        &NewEntry,
+                                        Name,
+                                        NameSize,
+                                        &Properties);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        *BytesConsumed += NewEntrySize;
+        *NextOffset = Entry->NextOffset;
+        EntryOffset += Entry->Size;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopWriteDirectoryEntry (
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    PDIRECTORY_ENTRY Entry,
+    PCSTR Name,
+    ULONG NameSize,
+    PFILE_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes a directory entry out to an I/O buffer. The caller
+    must have already checked that the entry fits.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to the I/O buffer to write to.
+
+    Offset - Supplies the offset within the I/O buffer to write the entry at.
+
+    Entry - Supplies a pointer to the directory entry. The file ID, next
+        offset, and type must be filled in. This routine fills in the size,
+        and sets the properties bit in the type if properties are supplied.
+
+    Name - Supplies a pointer to the null terminated name of the entry.
+
+    NameSize - Supplies the size of the name in bytes, including the null
+        terminator.
+
+    Properties - Supplies an optional pointer to the file properties to place
+        after the name.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    ASSERT((Entry->Type & DIRECTORY_ENTRY_TYPE_PROPERTIES) == 0);
+
+    if (Properties != NULL) {
+        Entry->Size = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(NameSize);
+        Entry->Type |= DIRECTORY_ENTRY_TYPE_PROPERTIES;
+
+    } else {
+        Entry->Size = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + NameSize, 8);
+    }
+
+    Status = MmCopyIoBufferData(IoBuffer,
+                                Entry,
+                                Offset,
+                                sizeof(DIRECTORY_ENTRY),
+                                TRUE);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    Status = MmCopyIoBufferData(IoBuffer,
+                                (PVOID)Name,
+                                Offset + sizeof(DIRECTORY_ENTRY),
+                                NameSize,
+                                TRUE);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    if (Properties != NULL) {
+        Status = MmCopyIoBufferData(
+                        IoBuffer,
+                        Properties,
+                        Offset + Entry->Size - DIRECTORY_ENTRY_PROPERTIES_SIZE,
+                        sizeof(FILE_PROPERTIES),
+                        TRUE);
+    }
+
+    return Status;
+}
+
 VOID
 IopFixMountPointDirectoryEntries (
     PIO_HANDLE Handle,
@@ -5875,6 +6444,8 @@ Return Value:
     FILE_ID OriginalFileId;
     PFILE_OBJECT OriginalFileObject;
     PPATH_POINT PathPoint;
+    FILE_PROPERTIES Properties;
+    UINTN PropertiesOffset;
     KSTATUS Status;
     FILE_ID TargetFileId;
     PFILE_OBJECT TargetFileObject;
@@ -5961,6 +6532,18 @@ Return Value:
                                Offset,
                                sizeof(DIRECTORY_ENTRY),
                                TRUE);
+
+            if ((DirectoryEntry.Type & DIRECTORY_ENTRY_TYPE_PROPERTIES) != 0) {
+                IopGetFileObjectProperties(TargetFileObject, &Properties);
+                PropertiesOffset = Offset + DirectoryEntry.Size -
+                                   DIRECTORY_ENTRY_PROPERTIES_SIZE;
+
+                MmCopyIoBufferData(IoBuffer,
+                                   &Properties,
+                                   PropertiesOffset,
+                                   sizeof(FILE_PROPERTIES),
+                                   TRUE);
+            }
         }
 
         Offset += DirectoryEntry.Size;
@@ -63,6 +63,7 @@ Module Name:
 #define FILE_LOCK_ALLOCATION_TAG 0x6B434C46 // 'kcLF'
 #define SOCKET_INFORMATION_ALLOCATION_TAG 0x666E4953 // 'fnIS'
 #define UNIX_SOCKET_ALLOCATION_TAG 0x6F536E55 // 'oSnU'
+#define BLOCK_QUEUE_ALLOCATION_TAG 0x516B6C42 // 'QklB'
 
 #define IRP_MAGIC_VALUE (USHORT)IRP_ALLOCATION_TAG
 
@@ -170,6 +171,13 @@ Module Name:
 
 #define VOLUME_FLAG_UNMOUNTING 0x00000001
 
+//
+// This flag is set when the volume's file system keeps its data only in
+// memory and has no backing device to write to.
+//
+
+#define VOLUME_FLAG_NO_BACKING_STORE 0x00000002
+
 //
 // This flag is set in the file object if it is closing.
 //
@@ -213,6 +221,14 @@ Module Name:
 
 #define FILE_OBJECT_FLAG_DIRTY_DATA 0x00000040
 
+//
+// This flag is set if the file object's data lives only in the page cache.
+// Dirty pages are not written back during normal cleaning; they are only
+// pushed down to the file system when memory gets tight.
+//
+
+#define FILE_OBJECT_FLAG_NO_BACKING_STORE 0x00000080
+
 //
 // The resource allocation work is currently assigned to the system work queue.
 //
@@ -327,6 +343,9 @@ typedef enum _FILE_OBJECT_TIME_TYPE {
 } FILE_OBJECT_TIME_TYPE, *PFILE_OBJECT_TIME_TYPE;
 
 typedef struct _DEVICE_POWER DEVICE_POWER, *PDEVICE_POWER;
+typedef struct _PAGE_CACHE_INDEX PAGE_CACHE_INDEX, *PPAGE_CACHE_INDEX;
+typedef struct _BLOCK_QUEUE BLOCK_QUEUE, *PBLOCK_QUEUE;
+typedef struct _FILE_LOCK_ENTRY FILE_LOCK_ENTRY, *PFILE_LOCK_ENTRY;
 
 /*++
 
@@ -341,8 +360,8 @@ Structure Description:
 
     ListEntry - Stores an entry into the list of file objects.
 
-    PageCacheTree - Stores a tree root for the page cache entries that
-        belong to this file object.
+    PageCacheIndex - Stores a pointer to the radix tree index of the page
+        cache entries that belong to this file object.
 
     DirtyPageList - Stores the head of the list of dirty page cache entries
         in this file object. This list is synchronized by the global page
@@ -385,11 +404,22 @@ Structure Description:
 
     Properties - Stores the characteristics for this file.
 
-    FileLockList - Stores the head of the list of file locks held on this
-        file object. This is a user mode thing.
+    FileLockTree - Stores a pointer to the root of the interval tree of file
+        locks held on this file object. This is a user mode thing.
 
-    FileLockEvent - Stores a pointer to the event that's signalled when a file
-        object lock is released.
+    FileLockWaitList - Stores the head of the list of threads waiting to
+        acquire a file lock on this file object.
+
+    WritebackIoPriority - Stores the most urgent I/O priority of the threads
+        that dirtied the file object's data since it was last clean. Kernel
+        threads writing the data back borrow this priority.
+
+    MemoryOnlyListEntry - Stores an entry into the global list of file objects
+        without backing store that have dirty pages. This is protected by the
+        dirty file objects list lock.
+
+    WatchListHead - Stores the head of the list of file watches registered on
+        this file object. This is protected by the global file watch lock.
 
 --*/
 
@@ -397,7 +427,7 @@ typedef struct _FILE_OBJECT FILE_OBJECT, *PFILE_OBJECT;
 struct _FILE_OBJECT {
     RED_BLACK_TREE_NODE TreeEntry;
     LIST_ENTRY ListEntry;
-    RED_BLACK_TREE PageCacheTree;
+    PPAGE_CACHE_INDEX PageCacheIndex;
     LIST_ENTRY DirtyPageList;
     volatile ULONG ReferenceCount;
     volatile ULONG PathEntryCount;
@@ -410,8 +440,11 @@ struct _FILE_OBJECT {
     volatile PVOID DeviceContext;
     volatile ULONG Flags;
     FILE_PROPERTIES Properties;
-    LIST_ENTRY FileLockList;
-    PKEVENT FileLockEvent;
+    PFILE_LOCK_ENTRY FileLockTree;
+    LIST_ENTRY FileLockWaitList;
+    volatile ULONG WritebackIoPriority;
+    LIST_ENTRY MemoryOnlyListEntry;
+    LIST_ENTRY WatchListHead;
 };
 
 /*++
@@ -425,6 +458,10 @@ Structure Description:
     SiblingListEntry - Stores pointers to the next and previous entries in
         the parent directory.
 
+    HashListEntry - Stores pointers to the next and previous entries in the
+        parent directory's child hash bucket. The next pointer is NULL if the
+        parent has no hash table or this entry is not in it.
+
     CacheListEntry - Stores pointers to the next and previous entries in the
         LRU list of the path entry cache.
 
@@ -456,12 +493,23 @@ Structure Description:
 
     ChildList - Stores the list of children for this node.
 
+    ChildHashTable - Stores an optional pointer to an array of list heads that
+        index the children by name hash. This is only allocated once a
+        directory has accumulated enough children to make walking the child
+        list expensive.
+
+    ChildHashBucketCount - Stores the number of buckets in the child hash
+        table. This is always a power of two.
+
+    ChildCount - Stores the number of entries on the child list.
+
     FileObject - Stores a pointer to the file object backing this path entry.
 
 --*/
 
 struct _PATH_ENTRY {
     LIST_ENTRY SiblingListEntry;
+    LIST_ENTRY HashListEntry;
     LIST_ENTRY CacheListEntry;
     volatile ULONG ReferenceCount;
     volatile ULONG MountCount;
@@ -472,6 +520,9 @@ struct _PATH_ENTRY {
     ULONG Hash;
     PPATH_ENTRY Parent;
     LIST_ENTRY ChildList;
+    PLIST_ENTRY ChildHashTable;
+    ULONG ChildHashBucketCount;
+    ULONG ChildCount;
     PFILE_OBJECT FileObject;
 };
 
@@ -558,6 +609,9 @@ Structure Description:
         Never manipulate this value directly, use the APIs provided to add
         or release a reference.
 
+    AsyncIoCount - Stores the number of asynchronous I/O requests submitted
+        against the handle that have not yet completed.
+
     Device - Stores a pointer to the underlying device or object that performs
         the I/O.
 
@@ -581,6 +635,7 @@ struct _IO_HANDLE {
     ULONG OpenFlags;
     ULONG Access;
     volatile ULONG ReferenceCount;
+    volatile ULONG AsyncIoCount;
     PVOID DeviceContext;
     PATH_POINT PathPoint;
     PFILE_OBJECT FileObject;
@@ -970,6 +1025,20 @@ Structure Description:
 
     Power - Stores the power management information for the device.
 
+    BlockQueue - Stores a pointer to the request queue in front of the device,
+        for block devices. This is created when the device sees its first
+        read or write.
+
+    StartTime - Stores the time counter value when the device first began
+        the start sequence.
+
+    StartDuration - Stores the number of time counter ticks it took the
+        device to go from the beginning of the start sequence to started,
+        including time spent waiting for resources and enumeration.
+
+    TimelineStart - Stores the boot timeline timestamp from when the device
+        first began the start sequence.
+
 --*/
 
 struct _DEVICE {
@@ -1001,6 +1070,10 @@ struct _DEVICE {
     PRESOURCE_ALLOCATION_LIST ProcessorLocalResources;
     PRESOURCE_ALLOCATION_LIST BootResources;
     PDEVICE_POWER Power;
+    PBLOCK_QUEUE BlockQueue;
+    ULONGLONG StartTime;
+    ULONGLONG StartDuration;
+    ULONGLONG TimelineStart;
 };
 
 /*++
@@ -1053,6 +1126,53 @@ struct _DRIVER {
     ULONG Flags;
 };
 
+typedef struct _IO_ASYNC_WORK IO_ASYNC_WORK, *PIO_ASYNC_WORK;
+
+typedef
+VOID
+(*PIO_ASYNC_WORK_ROUTINE) (
+    PIO_ASYNC_WORK Work
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs a unit of asynchronous I/O work on an asynchronous
+    I/O worker thread. The routine owns the work and must free it.
+
+Arguments:
+
+    Work - Supplies a pointer to the work to perform.
+
+Return Value:
+
+    None.
+
+--*/
+
+/*++
+
+Structure Description:
+
+    This structure defines a unit of work queued to the asynchronous I/O
+    worker threads. It is embedded in a larger structure describing the
+    request.
+
+Members:
+
+    ListEntry - Stores pointers to the next and previous entries in the
+        queue of pending work.
+
+    Routine - Stores a pointer to the routine that performs the work.
+
+--*/
+
+struct _IO_ASYNC_WORK {
+    LIST_ENTRY ListEntry;
+    PIO_ASYNC_WORK_ROUTINE Routine;
+};
+
 typedef
 KSTATUS
 (*PFILE_OBJECT_ITERATION_ROUTINE) (
@@ -1099,6 +1219,13 @@ extern PQUEUED_LOCK IoDeviceDatabaseLock;
 
 extern PWORK_QUEUE IoDeviceWorkQueue;
 
+//
+// Store a boolean indicating whether to print how long each device took to
+// start.
+//
+
+extern BOOL IoPrintDeviceStartTimes;
+
 //
 // Define the object that roots the device tree.
 //
@@ -1195,6 +1322,14 @@ extern PSHARED_EXCLUSIVE_LOCK IoMountLock;
 
 extern PSTR IoSystemDirectoryPath;
 
+//
+// Store the number of files being watched across the whole system. The hooks
+// that report file changes check this before doing anything else, so they
+// cost a single read when nothing is being watched.
+//
+
+extern volatile ULONG IoFileWatchCount;
+
 //
 // -------------------------------------------------------- Function Prototypes
 //
@@ -2344,6 +2479,47 @@ Return Value:
 
 --*/
 
+KSTATUS
+IopWriteDirectoryEntry (
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    PDIRECTORY_ENTRY Entry,
+    PCSTR Name,
+    ULONG NameSize,
+    PFILE_PROPERTIES Properties
+    );
+
+/*++
+
+Routine Description:
+
+    This routine writes a directory entry out to an I/O buffer. The caller
+    must have already checked that the entry fits.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to the I/O buffer to write to.
+
+    Offset - Supplies the offset within the I/O buffer to write the entry at.
+
+    Entry - Supplies a pointer to the directory entry. The file ID, next
+        offset, and type must be filled in. This routine fills in the size,
+        and sets the properties bit in the type if properties are supplied.
+
+    Name - Supplies a pointer to the null terminated name of the entry.
+
+    NameSize - Supplies the size of the name in bytes, including the null
+        terminator.
+
+    Properties - Supplies an optional pointer to the file properties to place
+        after the name.
+
+Return Value:
+
+    Status code.
+
+--*/
+
 KSTATUS
 IopCreateIoHandle (
     PIO_HANDLE *Handle
@@ -2632,6 +2808,35 @@ Return Value:
 
 --*/
 
+KSTATUS
+IopFlushMemoryOnlyFileObjects (
+    UINTN PageCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine pushes dirty pages from file objects without backing store
+    down to their file systems so that the page cache can reclaim them. It
+    also drops file objects that no longer have dirty pages from the list.
+
+Arguments:
+
+    PageCount - Supplies the number of pages to push down. Supply 0 to only
+        prune the list.
+
+Return Value:
+
+    STATUS_SUCCESS if there is nothing more to do.
+
+    STATUS_TRY_AGAIN if pages were pushed down and the page cache should trim
+    again before asking for more.
+
+    Other status codes on failure.
+
+--*/
+
 VOID
 IopEvictFileObject (
     PFILE_OBJECT FileObject,
@@ -2809,6 +3014,63 @@ Return Value:
 
 --*/
 
+VOID
+IopGetFileObjectProperties (
+    PFILE_OBJECT FileObject,
+    PFILE_PROPERTIES Properties
+    );
+
+/*++
+
+Routine Description:
+
+    This routine takes a snapshot of the given file object's properties. The
+    file object lock does not need to be held, so the properties may be
+    momentarily stale, but the file size is read atomically.
+
+Arguments:
+
+    FileObject - Supplies a pointer to a file object.
+
+    Properties - Supplies a pointer where the properties will be returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+BOOL
+IopGetCachedFileObjectProperties (
+    DEVICE_ID DeviceId,
+    FILE_ID FileId,
+    PFILE_PROPERTIES Properties
+    );
+
+/*++
+
+Routine Description:
+
+    This routine takes a snapshot of the properties of the file object with
+    the given device and file IDs, if such a file object is currently in the
+    file object table. No reference is taken on the file object.
+
+Arguments:
+
+    DeviceId - Supplies the device ID of the file.
+
+    FileId - Supplies the file ID of the file.
+
+    Properties - Supplies a pointer where the properties will be returned.
+
+Return Value:
+
+    TRUE if the file object was found and its properties were returned.
+
+    FALSE if there is no file object for the given IDs.
+
+--*/
+
 KSTATUS
 IopModifyFileObjectSize (
     PFILE_OBJECT FileObject,
@@ -3195,62 +3457,121 @@ Return Value:
 --*/
 
 KSTATUS
-IopInitializeTerminalSupport (
-    VOID
+IopGetSetPipeSize (
+    PIO_HANDLE Handle,
+    BOOL Set,
+    PULONG Size
     );
 
 /*++
 
 Routine Description:
 
-    This routine is called during system initialization to set up support for
-    terminals.
+    This routine gets or sets the size of a pipe's buffer.
 
 Arguments:
 
-    None.
+    Handle - Supplies a pointer to an open handle to the pipe.
+
+    Set - Supplies a boolean indicating whether to set the buffer size (TRUE)
+        or just get it (FALSE).
+
+    Size - Supplies a pointer that on input contains the requested buffer size
+        in bytes for set operations. The size is rounded up to a power of two
+        number of pages. On output, contains the size of the buffer.
 
 Return Value:
 
-    Status code.
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_HANDLE if the handle is not a pipe.
+
+    STATUS_PERMISSION_DENIED if the caller asked for more than an unprivileged
+    pipe may hold and does not have the resources permission.
+
+    STATUS_RESOURCE_IN_USE if the pipe holds more data than would fit in the
+    requested size.
 
 --*/
 
 KSTATUS
-IopTerminalOpenMaster (
-    PIO_HANDLE IoHandle
+IopSpliceFromPipe (
+    PIO_HANDLE Input,
+    PIO_HANDLE Output,
+    PIO_OFFSET OutputOffset,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
     );
 
 /*++
 
 Routine Description:
 
-    This routine is called when a master terminal was just opened.
+    This routine moves data out of a pipe and into another handle. If the
+    output is also a pipe, whole pages are handed from one pipe to the other
+    without being copied. Otherwise each page is written to the output
+    directly from the pipe's buffer ring.
 
 Arguments:
 
-    IoHandle - Supplies a pointer to the I/O handle for the terminal.
+    Input - Supplies a pointer to a handle to the pipe to read from.
+
+    Output - Supplies a pointer to the handle to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset to write to in
+        the output. On return, this is advanced by the number of bytes
+        written. If this is NULL, the output's current file position is used.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
 
 Return Value:
 
-    Status code.
+    Status code. STATUS_END_OF_FILE is returned if the pipe is empty and has
+    no writers.
 
 --*/
 
 KSTATUS
-IopTerminalCloseMaster (
-    PIO_HANDLE IoHandle
+IopSpliceToPipe (
+    PIO_HANDLE Input,
+    PIO_OFFSET InputOffset,
+    PIO_HANDLE Output,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
     );
 
 /*++
 
 Routine Description:
 
-    This routine is called when a master terminal was just closed.
+    This routine moves data from a handle that is not a pipe into a pipe. If
+    the input is a cacheable file, references to its page cache entries are
+    placed in the pipe rather than copies of them. Other inputs are read
+    directly into the pipe's own pages.
 
 Arguments:
 
-    IoHandle - Supplies a pointer to the handle to close.
+    Input - Supplies a pointer to the handle to read from.
+
+    InputOffset - Supplies an optional pointer to the offset to read from in
+        the input. On return, this is advanced by the number of bytes read. If
+        this is NULL, the input's current file position is used and updated.
+
+    Output - Supplies a pointer to a handle to the pipe to write to.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
 
 Return Value:
 
@@ -3259,19 +3580,32 @@ Return Value:
 --*/
 
 KSTATUS
-IopTerminalOpenSlave (
-    PIO_HANDLE IoHandle
+IopSpliceMemoryToPipe (
+    PIO_HANDLE Output,
+    PIO_BUFFER UserBuffer,
+    ULONG Flags,
+    PUINTN BytesSpliced
     );
 
 /*++
 
 Routine Description:
 
-    This routine opens the slave side of a terminal object.
+    This routine places user mode memory into a pipe without copying it. The
+    pages are locked and referenced by the pipe until they are read out, so
+    the caller must not modify them until then.
 
 Arguments:
 
-    IoHandle - Supplies a pointer to the I/O handle for the terminal.
+    Output - Supplies a pointer to a handle to the pipe to write to.
+
+    UserBuffer - Supplies a pointer to an I/O buffer describing the current
+        process' user mode memory to splice.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes placed in the
+        pipe will be returned.
 
 Return Value:
 
@@ -3280,19 +3614,23 @@ Return Value:
 --*/
 
 KSTATUS
-IopTerminalCloseSlave (
-    PIO_HANDLE IoHandle
+IopCreateEventPoll (
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
     );
 
 /*++
 
 Routine Description:
 
-    This routine is called when a master terminal was just closed.
+    This routine creates a new event poll object and its file object.
 
 Arguments:
 
-    IoHandle - Supplies a pointer to the handle to close.
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
 
 Return Value:
 
@@ -3301,106 +3639,906 @@ Return Value:
 --*/
 
 KSTATUS
-IopPerformTerminalMasterIoOperation (
-    PIO_HANDLE Handle,
-    PIO_CONTEXT IoContext
+IopCloseEventPoll (
+    PIO_HANDLE IoHandle
     );
 
 /*++
 
 Routine Description:
 
-    This routine reads from or writes to the master end of a terminal.
+    This routine is called when an event poll handle is closed. It tears down
+    every watch the event poll object has.
 
 Arguments:
 
-    Handle - Supplies a pointer to the master terminal I/O handle.
-
-    IoContext - Supplies a pointer to the I/O context.
+    IoHandle - Supplies a pointer to the I/O handle being closed.
 
 Return Value:
 
-    Status code. A failing status code does not necessarily mean no I/O made it
-    in or out. Check the bytes completed value in the I/O context to find out
-    how much occurred.
+    Status code.
 
 --*/
 
-KSTATUS
-IopPerformTerminalSlaveIoOperation (
-    PIO_HANDLE Handle,
-    PIO_CONTEXT IoContext
+VOID
+IopRemoveEventPollWatches (
+    PIO_HANDLE IoHandle
     );
 
 /*++
 
 Routine Description:
 
-    This routine reads from or writes to the slave end of a terminal.
+    This routine removes the given I/O handle from every event poll object
+    watching it. It is called when an I/O handle is closed.
 
 Arguments:
 
-    Handle - Supplies a pointer to the slave terminal I/O handle.
-
-    IoContext - Supplies a pointer to the I/O context.
+    IoHandle - Supplies a pointer to the I/O handle being closed.
 
 Return Value:
 
-    Status code. A failing status code does not necessarily mean no I/O made it
-    in or out. Check the bytes completed value in the I/O context to find out
-    how much occurred.
+    None.
 
 --*/
 
-KSTATUS
-IopCreateTerminal (
-    IO_OBJECT_TYPE Type,
-    PVOID OverrideParameter,
-    FILE_PERMISSIONS CreatePermissions,
-    PFILE_OBJECT *FileObject
+VOID
+IopNotifyEventPolls (
+    PIO_ASYNC_STATE Async,
+    ULONG Events
     );
 
 /*++
 
 Routine Description:
 
-    This routine creates a terminal master or slave.
+    This routine queues every event poll watch interested in the given events
+    onto its event poll's ready list. It is called when events are set in an
+    I/O object state.
 
 Arguments:
 
-    Type - Supplies the type of special object to create.
-
-    OverrideParameter - Supplies an optional parameter to send along with the
-        override type.
-
-    CreatePermissions - Supplies the permissions to assign to the new file.
+    Async - Supplies a pointer to the async state of the I/O object state
+        whose events were set.
 
-    FileObject - Supplies a pointer where a pointer to the new file object
-        will be returned on success.
+    Events - Supplies the mask of events that were just set.
 
 Return Value:
 
-    Status code.
+    None.
 
 --*/
 
 KSTATUS
-IopUnlinkTerminal (
-    PFILE_OBJECT FileObject,
-    PBOOL Unlinked
+IopCreateEventCounter (
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
     );
 
 /*++
 
 Routine Description:
 
-    This routine unlinks a terminal from the accessible namespace.
+    This routine creates a new event counter object and its file object.
 
 Arguments:
 
-    FileObject - Supplies a pointer to the terminal's file object.
+    OverrideParameter - Supplies a pointer to the event counter creation
+        parameters, a PSYSTEM_CALL_CREATE_EVENT_COUNTER.
 
-    Unlinked - Supplies a pointer to a boolean that receives whether or not the
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopPerformEventCounterIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads from or writes to an event counter. Reads return the
+    64-bit counter value and writes add a 64-bit value to the counter.
+
+Arguments:
+
+    Handle - Supplies a pointer to the event counter I/O handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCreateIoTimer (
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O timer object and its file object.
+
+Arguments:
+
+    OverrideParameter - Supplies a pointer to the I/O timer creation
+        parameters, a PSYSTEM_CALL_CREATE_IO_TIMER.
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopOpenIoTimer (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O timer is opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the new I/O handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCloseIoTimer (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O timer handle is closed. The timer is
+    disarmed when the last handle goes away.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopPerformIoTimerIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads from an I/O timer. Reads return the 64-bit number of
+    expirations since the last read.
+
+Arguments:
+
+    Handle - Supplies a pointer to the I/O timer handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopInitializeAsyncIoSupport (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    asynchronous I/O.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCreateAsyncIoContext (
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new asynchronous I/O context and its file object.
+
+Arguments:
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+VOID
+IopQueueAsyncWork (
+    PLIST_ENTRY WorkList,
+    ULONG WorkCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine hands a list of work to the asynchronous I/O worker threads,
+    creating more worker threads if there are not enough idle ones to start
+    all of the work right away.
+
+Arguments:
+
+    WorkList - Supplies a pointer to the head of a list of IO_ASYNC_WORK
+        structures. The list will be empty on return.
+
+    WorkCount - Supplies the number of entries in the list.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+IopLockUserIoBuffer (
+    PIO_BUFFER IoBuffer,
+    BOOL Write,
+    PIO_BUFFER *LockedBuffer
+    );
+
+/*++
+
+Routine Description:
+
+    This routine locks down the pages of an I/O buffer describing the current
+    process' user mode memory, so that it can be accessed from any thread
+    after the system call that created it returns.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to the user mode I/O buffer.
+
+    Write - Supplies a boolean indicating whether the memory will be written
+        to.
+
+    LockedBuffer - Supplies a pointer where a new I/O buffer describing the
+        same memory in locked pages will be returned on success. The caller
+        is responsible for freeing both buffers.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopLockUserBuffer (
+    PVOID Buffer,
+    UINTN Size,
+    BOOL Write,
+    PIO_BUFFER *LockedBuffer
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates an I/O buffer for a region of the current process'
+    user mode memory, with the pages locked in memory so that it can be
+    accessed from any thread after the system call returns.
+
+Arguments:
+
+    Buffer - Supplies the user mode address of the region.
+
+    Size - Supplies the size of the region in bytes.
+
+    Write - Supplies a boolean indicating whether the region will be written
+        to.
+
+    LockedBuffer - Supplies a pointer where the locked I/O buffer will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopOpenAsyncIoContext (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when an asynchronous I/O context is opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the new I/O handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCloseAsyncIoContext (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when an asynchronous I/O context handle is closed.
+    Requests still in flight when the last handle goes away stop updating the
+    context's I/O object state, which is destroyed with the file object.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopPerformAsyncIoContextIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads from an asynchronous I/O context. Reads return the
+    64-bit number of requests that completed since the last read. Writes are
+    not supported.
+
+Arguments:
+
+    Handle - Supplies a pointer to the asynchronous I/O context handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCreateIoRing (
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O ring and its file object. The shared ring
+    memory and registered buffer region are locked, mapped into the kernel,
+    and the ring header is initialized.
+
+Arguments:
+
+    OverrideParameter - Supplies a pointer to the I/O ring creation
+        parameters, a PSYSTEM_CALL_CREATE_IO_RING.
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopOpenIoRing (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O ring is opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the new I/O handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCloseIoRing (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O ring handle is closed. When the last
+    handle goes away, the polling thread is stopped, parked operations are
+    canceled, and the registered handles are released.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopPerformIoRingIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine handles reads and writes to an I/O ring, which are not
+    supported. The ring is only operated through its shared memory and
+    polled for completions.
+
+Arguments:
+
+    Handle - Supplies a pointer to the I/O ring handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    STATUS_NOT_SUPPORTED always.
+
+--*/
+
+KSTATUS
+IopInitializeFileWatchSupport (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    file watch objects.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCreateFileWatch (
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch object and its file object.
+
+Arguments:
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopPerformFileWatchIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads queued event records from a file watch. Writes are not
+    supported.
+
+Arguments:
+
+    Handle - Supplies a pointer to the file watch I/O handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+VOID
+IopNotifyFileWatches (
+    PFILE_OBJECT Directory,
+    PCSTR Name,
+    ULONG NameSize,
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Cookie
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reports that something happened to an entry in a directory.
+    Watches on the directory receive the events along with the entry's name,
+    and watches on the entry's file object receive the corresponding events
+    about the file itself. Callers should check IoFileWatchCount before
+    calling this routine.
+
+Arguments:
+
+    Directory - Supplies an optional pointer to the file object of the
+        directory containing the entry. Supply NULL to only notify watches on
+        the file itself.
+
+    Name - Supplies a pointer to the name of the entry within the directory.
+
+    NameSize - Supplies the size of the name buffer in bytes, including the
+        null terminator.
+
+    FileObject - Supplies an optional pointer to the file object the entry
+        refers to.
+
+    Events - Supplies the events that occurred, from the directory's point of
+        view. See FILE_WATCH_EVENT_* definitions.
+
+    Cookie - Supplies the cookie pairing the two halves of a rename, or zero.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopNotifyFileWatchesOfRename (
+    PFILE_OBJECT SourceDirectory,
+    PCSTR SourceName,
+    ULONG SourceNameSize,
+    PFILE_OBJECT DestinationDirectory,
+    PCSTR DestinationName,
+    ULONG DestinationNameSize,
+    PFILE_OBJECT FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reports a successful rename to any interested file watches.
+    Callers should check IoFileWatchCount before calling this routine.
+
+Arguments:
+
+    SourceDirectory - Supplies a pointer to the directory the file was moved
+        out of.
+
+    SourceName - Supplies a pointer to the old name of the file.
+
+    SourceNameSize - Supplies the size of the old name buffer in bytes,
+        including the null terminator.
+
+    DestinationDirectory - Supplies a pointer to the directory the file was
+        moved into.
+
+    DestinationName - Supplies a pointer to the new name of the file.
+
+    DestinationNameSize - Supplies the size of the new name buffer in bytes,
+        including the null terminator.
+
+    FileObject - Supplies a pointer to the file object that was renamed.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+IopInitializeTerminalSupport (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    terminals.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopTerminalOpenMaster (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when a master terminal was just opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle for the terminal.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopTerminalCloseMaster (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when a master terminal was just closed.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the handle to close.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopTerminalOpenSlave (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine opens the slave side of a terminal object.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle for the terminal.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopTerminalCloseSlave (
+    PIO_HANDLE IoHandle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when a master terminal was just closed.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the handle to close.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopPerformTerminalMasterIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads from or writes to the master end of a terminal.
+
+Arguments:
+
+    Handle - Supplies a pointer to the master terminal I/O handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code. A failing status code does not necessarily mean no I/O made it
+    in or out. Check the bytes completed value in the I/O context to find out
+    how much occurred.
+
+--*/
+
+KSTATUS
+IopPerformTerminalSlaveIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads from or writes to the slave end of a terminal.
+
+Arguments:
+
+    Handle - Supplies a pointer to the slave terminal I/O handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code. A failing status code does not necessarily mean no I/O made it
+    in or out. Check the bytes completed value in the I/O context to find out
+    how much occurred.
+
+--*/
+
+KSTATUS
+IopCreateTerminal (
+    IO_OBJECT_TYPE Type,
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS CreatePermissions,
+    PFILE_OBJECT *FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a terminal master or slave.
+
+Arguments:
+
+    Type - Supplies the type of special object to create.
+
+    OverrideParameter - Supplies an optional parameter to send along with the
+        override type.
+
+    CreatePermissions - Supplies the permissions to assign to the new file.
+
+    FileObject - Supplies a pointer where a pointer to the new file object
+        will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopUnlinkTerminal (
+    PFILE_OBJECT FileObject,
+    PBOOL Unlinked
+    );
+
+/*++
+
+Routine Description:
+
+    This routine unlinks a terminal from the accessible namespace.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the terminal's file object.
+
+    Unlinked - Supplies a pointer to a boolean that receives whether or not the
         terminal was successfully unlinked.
 
 Return Value:
@@ -4071,6 +5209,32 @@ Return Value:
 
 --*/
 
+VOID
+IopPathInsertChild (
+    PPATH_ENTRY Parent,
+    PPATH_ENTRY Entry
+    );
+
+/*++
+
+Routine Description:
+
+    This routine links the given path entry into its parent's list of
+    children, making it visible to path walks. This assumes the caller holds
+    the parent path entry's file object lock exclusively.
+
+Arguments:
+
+    Parent - Supplies a pointer to the parent path entry.
+
+    Entry - Supplies a pointer to the path entry to insert.
+
+Return Value:
+
+    None.
+
+--*/
+
 VOID
 IopPathUnlink (
     PPATH_ENTRY Entry
@@ -4095,6 +5259,34 @@ Return Value:
 
 --*/
 
+VOID
+IopNotifyPathEntryWatches (
+    PPATH_ENTRY Entry,
+    ULONG Events
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reports that something happened to the file at the given
+    path entry. Watches on the file and on its parent directory are notified.
+    Callers should check IoFileWatchCount before calling this routine.
+
+Arguments:
+
+    Entry - Supplies an optional pointer to the path entry the events are
+        about. Nothing is reported for NULL or negative path entries.
+
+    Events - Supplies the events that occurred, from the parent directory's
+        point of view. See FILE_WATCH_EVENT_* definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 IopGetPathFromRoot (
     PPATH_POINT Entry,
@@ -4546,7 +5738,37 @@ IopSendIoIrp (
 
 Routine Description:
 
-    This routine sends an I/O IRP.
+    This routine sends an I/O IRP. Reads and writes to block devices pass
+    through the device's request queue on the way.
+
+Arguments:
+
+    Device - Supplies a pointer to the device to send the IRP to.
+
+    MinorCodeNumber - Supplies the minor code number to send to the IRP.
+
+    Request - Supplies a pointer that on input contains the I/O request
+        parameters.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopDispatchIoIrp (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCodeNumber,
+    PIRP_READ_WRITE Request
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends an I/O IRP straight to the device, bypassing any block
+    request queue.
 
 Arguments:
 
@@ -4793,6 +6015,27 @@ Return Value:
 
 --*/
 
+KSTATUS
+IopInitializeFileLockSupport (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs global initialization for user mode file locks.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
 KSTATUS
 IopGetFileLock (
     PIO_HANDLE IoHandle,
@@ -4900,3 +6143,220 @@ Return Value:
 
 --*/
 
+KSTATUS
+IopInitializeBlockQueues (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes global support for block device request queues.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+ULONG
+IopGetCurrentIoPriority (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the I/O priority that applies to the current thread.
+    This is the thread's own priority if it has one, otherwise its process'
+    priority if that has one, otherwise the best effort default.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the I/O priority of the current thread. The class is never none.
+    With the class in the high bits, a lower value is a more urgent priority.
+
+--*/
+
+BOOL
+IopIsBlockQueueRequest (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCode,
+    PIRP_READ_WRITE Request
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not an I/O request should go through
+    the device's block request queue.
+
+Arguments:
+
+    Device - Supplies a pointer to the device the request is bound for.
+
+    MinorCode - Supplies the I/O minor code of the request.
+
+    Request - Supplies a pointer to the request parameters.
+
+Return Value:
+
+    TRUE if the request should be queued.
+
+    FALSE if the request should be sent straight to the device.
+
+--*/
+
+KSTATUS
+IopQueueBlockIo (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCode,
+    PIRP_READ_WRITE Parameters
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends a read or write to a block device through its request
+    queue. It returns once the I/O is complete.
+
+Arguments:
+
+    Device - Supplies a pointer to the block device.
+
+    MinorCode - Supplies the minor code of the request, either read or write.
+
+    Parameters - Supplies a pointer to the request parameters. On return, the
+        bytes completed and new offset are filled in.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+VOID
+IopDestroyBlockQueue (
+    PDEVICE Device
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys the block request queue of a device being
+    destroyed.
+
+Arguments:
+
+    Device - Supplies a pointer to the device.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+IopGetBlockDeviceStatistics (
+    PVOID Data,
+    PUINTN DataSize,
+    BOOL Set
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the statistics of every block device request queue.
+
+Arguments:
+
+    Data - Supplies a pointer to the data buffer where an array of
+        IO_BLOCK_DEVICE_STATISTICS structures is returned.
+
+    DataSize - Supplies a pointer that on input contains the size of the
+        data buffer. On output, contains the required size of the data buffer.
+
+    Set - Supplies a boolean indicating if this is a get operation (FALSE) or
+        a set operation (TRUE).
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_BUFFER_TOO_SMALL if the buffer was not big enough. The required
+    size is returned.
+
+    STATUS_ACCESS_DENIED for a set operation.
+
+--*/
+
+KSTATUS
+IopTransferFileData (
+    PIO_HANDLE Destination,
+    IO_OFFSET DestinationOffset,
+    PIO_HANDLE Source,
+    IO_OFFSET SourceOffset,
+    UINTN SizeInBytes,
+    UINTN ChunkSize,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesCompleted
+    );
+
+/*++
+
+Routine Description:
+
+    This routine moves data from a seekable handle to another handle a chunk
+    at a time. If the source file is cacheable, its page cache entries are
+    referenced into the I/O buffer handed to the destination rather than
+    copied. Neither handle's file position is changed, except by writes to the
+    destination at its current position.
+
+Arguments:
+
+    Destination - Supplies a pointer to the I/O handle to write to.
+
+    DestinationOffset - Supplies the offset within the destination to write
+        to, or IO_OFFSET_NONE to write at the destination's current position.
+
+    Source - Supplies a pointer to the I/O handle to read from.
+
+    SourceOffset - Supplies the offset within the source to start reading
+        from.
+
+    SizeInBytes - Supplies the number of bytes to transfer.
+
+    ChunkSize - Supplies the maximum number of bytes to transfer per read and
+        write. This bounds the number of page cache entries pinned at once.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that each
+        write to the destination should be waited on before timing out.
+
+    BytesCompleted - Supplies a pointer where the number of bytes transferred
+        will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was transferred, or if the source
+    offset was at or beyond the end of the file. A partial transfer is
+    reported as a success so that the caller learns how far the offsets
+    advanced. The error will come back on the next attempt if it persists.
+
+    Error codes if nothing could be transferred.
+
+--*/
+
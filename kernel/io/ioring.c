@@ -0,0 +1,2308 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    ioring.c
+
+Abstract:
+
+    This module implements I/O rings. An I/O ring is a pair of queues in
+    memory shared between user mode and the kernel: user mode fills in
+    submissions, and the kernel consumes them in batches and posts a
+    completion for each one, so that many operations cost a single system
+    call, or none at all when a kernel thread polls the submission queue.
+    Operations are attempted right away in the consuming thread without
+    blocking. Those that would block are parked on the asynchronous I/O
+    worker threads, which wait for the handle to become ready.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define IO_RING_ALLOCATION_TAG 0x676E5249 // 'gnRI'
+
+//
+// Define how long a worker thread waits for a parked operation's handle to
+// become ready before checking whether the ring has been closed.
+//
+
+#define IO_RING_WAIT_SLICE 1000
+
+//
+// Define how long the kernel polling thread keeps polling an idle submission
+// queue before going to sleep.
+//
+
+#define IO_RING_POLL_IDLE_MICROSECONDS 50000
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an I/O ring.
+
+Members:
+
+    Header - Stores the standard object header.
+
+    Lock - Stores a pointer to the lock protecting the completion queue, the
+        count of operations in flight, the deferred work list, and the I/O
+        object state.
+
+    SubmitLock - Stores a pointer to the lock serializing consumers of the
+        submission queue, and the registered handles.
+
+    IoState - Stores a pointer to the I/O object state of the ring's file
+        object. The in event is set whenever a completion is posted. This is
+        NULL once the last handle to the ring is closed.
+
+    HandleCount - Stores the number of open handles to the ring.
+
+    Flags - Stores the IO_RING_FLAG_* flags the ring was created with.
+
+    Closing - Stores a boolean indicating that the last handle to the ring
+        has been closed, and parked operations should be canceled.
+
+    RingBuffer - Stores a pointer to the locked I/O buffer describing the
+        shared ring memory.
+
+    Shared - Stores the kernel mapping of the shared ring header.
+
+    Submissions - Stores the kernel mapping of the submission entries.
+
+    Completions - Stores the kernel mapping of the completion entries.
+
+    SubmissionMask - Stores the number of submission entries minus one.
+
+    CompletionMask - Stores the number of completion entries minus one.
+
+    SubmissionHead - Stores the kernel's private copy of the submission head.
+        User mode cannot move this out from under the kernel.
+
+    CompletionTail - Stores the kernel's private copy of the completion tail.
+
+    InFlight - Stores the number of submissions that have been consumed but
+        not yet completed. Each one has a slot in the completion queue
+        reserved for it.
+
+    BufferRegion - Stores a pointer to the locked I/O buffer describing the
+        registered buffer region, if any.
+
+    BufferRegionAddress - Stores the kernel mapping of the registered buffer
+        region.
+
+    BufferRegionSize - Stores the size of the registered buffer region in
+        bytes.
+
+    RegisteredHandles - Stores an array of registered handles. A reference is
+        held on each.
+
+    RegisteredHandleCount - Stores the number of registered handles.
+
+    DeferredListHead - Stores the head of the list of parked operations that
+        are ready, but need to be finished in the context of the process the
+        next time the ring is entered.
+
+    PollEvent - Stores a pointer to the event the kernel polling thread sleeps
+        on when the submission queue is idle.
+
+--*/
+
+typedef struct _IO_RING {
+    OBJECT_HEADER Header;
+    PQUEUED_LOCK Lock;
+    PQUEUED_LOCK SubmitLock;
+    PIO_OBJECT_STATE IoState;
+    volatile ULONG HandleCount;
+    ULONG Flags;
+    volatile BOOL Closing;
+    PIO_BUFFER RingBuffer;
+    PIO_RING_HEADER Shared;
+    PIO_RING_SUBMISSION Submissions;
+    PIO_RING_COMPLETION Completions;
+    ULONG SubmissionMask;
+    ULONG CompletionMask;
+    ULONG SubmissionHead;
+    ULONG CompletionTail;
+    ULONG InFlight;
+    PIO_BUFFER BufferRegion;
+    PVOID BufferRegionAddress;
+    UINTN BufferRegionSize;
+    PIO_HANDLE *RegisteredHandles;
+    ULONG RegisteredHandleCount;
+    LIST_ENTRY DeferredListHead;
+    PKEVENT PollEvent;
+} IO_RING, *PIO_RING;
+
+/*++
+
+Structure Description:
+
+    This structure defines a single operation consumed from an I/O ring.
+    Operations that complete right away only ever live on the stack; those
+    that are parked are copied into paged pool.
+
+Members:
+
+    Header - Stores the generic work header used to queue the operation to
+        the asynchronous I/O worker threads. The list entry is also used to
+        put the operation on the ring's deferred list.
+
+    Ring - Stores a pointer to the ring. A reference is held on the ring once
+        the operation is parked.
+
+    Submission - Stores a copy of the submission.
+
+    Handle - Stores a pointer to the I/O handle to operate on. A reference is
+        held on the handle.
+
+    IoBuffer - Stores a pointer to the I/O buffer describing the data buffer.
+        Once the operation is parked, user mode buffers are locked.
+
+    UserBuffer - Stores a boolean indicating whether the I/O buffer describes
+        user mode memory, as opposed to the registered buffer region.
+
+--*/
+
+typedef struct _IO_RING_WORK {
+    IO_ASYNC_WORK Header;
+    PIO_RING Ring;
+    IO_RING_SUBMISSION Submission;
+    PIO_HANDLE Handle;
+    PIO_BUFFER IoBuffer;
+    BOOL UserBuffer;
+} IO_RING_WORK, *PIO_RING_WORK;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+IopDestroyIoRing (
+    PVOID Object
+    );
+
+KSTATUS
+IopMapIoRingUserBuffer (
+    PVOID Buffer,
+    UINTN Size,
+    PIO_BUFFER *LockedBuffer,
+    PVOID *KernelAddress
+    );
+
+KSTATUS
+IopRegisterIoRingHandles (
+    PIO_RING Ring,
+    PHANDLE Handles,
+    ULONG HandleCount
+    );
+
+VOID
+IopReleaseIoRingHandles (
+    PIO_RING Ring
+    );
+
+ULONG
+IopConsumeIoRingSubmissions (
+    PIO_RING Ring,
+    ULONG Count,
+    BOOL FromPoller
+    );
+
+BOOL
+IopReserveIoRingCompletion (
+    PIO_RING Ring
+    );
+
+KSTATUS
+IopPrepareIoRingWork (
+    PIO_RING Ring,
+    PIO_RING_WORK Work,
+    BOOL FromPoller
+    );
+
+KSTATUS
+IopParkIoRingWork (
+    PIO_RING_WORK Work,
+    PIO_RING_WORK *ParkedWork
+    );
+
+VOID
+IopDestroyIoRingWork (
+    PIO_RING_WORK Work,
+    BOOL Parked
+    );
+
+KSTATUS
+IopPerformIoRingOperation (
+    PIO_RING_WORK Work,
+    BOOL InProcess,
+    PUINTN Result
+    );
+
+ULONG
+IopGetIoRingWaitEvents (
+    PIO_RING_WORK Work
+    );
+
+VOID
+IopPerformParkedIoRingWork (
+    PIO_ASYNC_WORK AsyncWork
+    );
+
+VOID
+IopRunDeferredIoRingWork (
+    PIO_RING Ring
+    );
+
+VOID
+IopPostIoRingCompletion (
+    PIO_RING Ring,
+    ULONGLONG UserData,
+    KSTATUS Status,
+    UINTN Result
+    );
+
+KSTATUS
+IopWaitForIoRingCompletions (
+    PIO_RING Ring,
+    ULONG WaitCount,
+    ULONG TimeoutInMilliseconds
+    );
+
+KSTATUS
+IopStartIoRingPoller (
+    PIO_RING Ring
+    );
+
+VOID
+IopIoRingPollThread (
+    PVOID Parameter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateIoRing (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O ring on behalf of user mode.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG HandleFlags;
+    PIO_HANDLE IoHandle;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_CREATE_IO_RING Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_CREATE_IO_RING)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+
+    ASSERT(Process != PsGetKernelProcess());
+
+    if ((Parameters->OpenFlags &
+         ~(SYS_OPEN_FLAG_NON_BLOCKING | SYS_OPEN_FLAG_CLOSE_ON_EXECUTE)) != 0) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateIoRingEnd;
+    }
+
+    OpenFlags = OPEN_FLAG_CREATE;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_NON_BLOCKING) != 0) {
+        OpenFlags |= OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = IopOpen(FALSE,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ,
+                     OpenFlags,
+                     IoObjectIoRing,
+                     Parameters,
+                     FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE,
+                     &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateIoRingEnd;
+    }
+
+    if ((Parameters->Flags & IO_RING_FLAG_KERNEL_POLL) != 0) {
+        Status = IopStartIoRingPoller(IoHandle->FileObject->SpecialIo);
+        if (!KSUCCESS(Status)) {
+            goto SysCreateIoRingEnd;
+        }
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(Process->HandleTable,
+                            IoHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateIoRingEnd;
+    }
+
+    IoHandle = NULL;
+
+SysCreateIoRingEnd:
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysEnterIoRing (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine consumes submissions from an I/O ring and optionally waits
+    for completions to be posted. The number of submissions consumed is
+    returned on success.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG ConsumedCount;
+    PSYSTEM_CALL_ENTER_IO_RING Parameters;
+    PKPROCESS Process;
+    PIO_RING Ring;
+    PIO_HANDLE RingHandle;
+    KSTATUS Status;
+
+    ConsumedCount = 0;
+    Parameters = (PSYSTEM_CALL_ENTER_IO_RING)SystemCallParameter;
+    Process = PsGetCurrentProcess();
+    RingHandle = ObGetHandleValue(Process->HandleTable, Parameters->Ring, NULL);
+    if (RingHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysEnterIoRingEnd;
+    }
+
+    if ((RingHandle->FileObject->Properties.Type != IoObjectIoRing) ||
+        ((Parameters->Flags & ~IO_RING_ENTER_FLAGS_MASK) != 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysEnterIoRingEnd;
+    }
+
+    Ring = RingHandle->FileObject->SpecialIo;
+
+    //
+    // A polled ring's submissions are only ever consumed by its polling
+    // thread, which keeps them in order.
+    //
+
+    if ((Ring->Flags & IO_RING_FLAG_KERNEL_POLL) != 0) {
+        if ((Parameters->Flags & IO_RING_ENTER_FLAG_WAKE) != 0) {
+            KeSignalEvent(Ring->PollEvent, SignalOptionSignalAll);
+        }
+
+    } else if (Parameters->SubmitCount != 0) {
+        ConsumedCount = IopConsumeIoRingSubmissions(Ring,
+                                                    Parameters->SubmitCount,
+                                                    FALSE);
+    }
+
+    IopRunDeferredIoRingWork(Ring);
+    Status = STATUS_SUCCESS;
+    if (Parameters->WaitCount != 0) {
+        Status = IopWaitForIoRingCompletions(Ring,
+                                             Parameters->WaitCount,
+                                             Parameters->TimeoutInMilliseconds);
+    }
+
+SysEnterIoRingEnd:
+    if (RingHandle != NULL) {
+        IoIoHandleReleaseReference(RingHandle);
+    }
+
+    //
+    // Once submissions have been consumed they are gone from the ring, so the
+    // count must make it back to user mode even if the wait failed. The
+    // completions report what happened to them.
+    //
+
+    if (ConsumedCount != 0) {
+        return ConsumedCount;
+    }
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = STATUS_RESTART_AFTER_SIGNAL;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopCreateIoRing (
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O ring and its file object. The shared ring
+    memory and registered buffer region are locked, mapped into the kernel,
+    and the ring header is initialized.
+
+Arguments:
+
+    OverrideParameter - Supplies a pointer to the I/O ring creation
+        parameters, a PSYSTEM_CALL_CREATE_IO_RING.
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG CompletionCount;
+    BOOL Created;
+    FILE_PROPERTIES FileProperties;
+    PFILE_OBJECT NewFileObject;
+    PSYSTEM_CALL_CREATE_IO_RING Parameters;
+    PIO_RING Ring;
+    PVOID RingAddress;
+    KSTATUS Status;
+    ULONG SubmissionCount;
+    PKTHREAD Thread;
+
+    ASSERT(*FileObject == NULL);
+
+    NewFileObject = NULL;
+    Parameters = OverrideParameter;
+    Ring = NULL;
+    if (Parameters == NULL) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto CreateIoRingEnd;
+    }
+
+    SubmissionCount = Parameters->SubmissionCount;
+    CompletionCount = Parameters->CompletionCount;
+    if (((Parameters->Flags & ~IO_RING_FLAGS_MASK) != 0) ||
+        (SubmissionCount == 0) ||
+        (SubmissionCount > IO_RING_MAX_ENTRIES) ||
+        (POWER_OF_2(SubmissionCount) == FALSE) ||
+        (CompletionCount < SubmissionCount) ||
+        (CompletionCount > (IO_RING_MAX_ENTRIES * 2)) ||
+        (POWER_OF_2(CompletionCount) == FALSE) ||
+        (Parameters->RingSize <
+         IO_RING_SIZE(SubmissionCount, CompletionCount)) ||
+        (Parameters->HandleCount > IO_RING_MAX_REGISTERED_HANDLES) ||
+        ((Parameters->HandleCount != 0) && (Parameters->Handles == NULL)) ||
+        ((Parameters->BufferRegionSize != 0) &&
+         (Parameters->BufferRegion == NULL))) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto CreateIoRingEnd;
+    }
+
+    //
+    // Create the object. This reference is transferred to the file object's
+    // special I/O member on success.
+    //
+
+    Ring = ObCreateObject(ObjectIoRing,
+                          NULL,
+                          NULL,
+                          0,
+                          sizeof(IO_RING),
+                          IopDestroyIoRing,
+                          0,
+                          IO_ALLOCATION_TAG);
+
+    if (Ring == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateIoRingEnd;
+    }
+
+    Ring->Flags = Parameters->Flags;
+    INITIALIZE_LIST_HEAD(&(Ring->DeferredListHead));
+    Ring->Lock = KeCreateQueuedLock();
+    Ring->SubmitLock = KeCreateQueuedLock();
+    Ring->PollEvent = KeCreateEvent(NULL);
+    if ((Ring->Lock == NULL) ||
+        (Ring->SubmitLock == NULL) ||
+        (Ring->PollEvent == NULL)) {
+
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateIoRingEnd;
+    }
+
+    //
+    // Lock down the shared memory and map it into the kernel, so that both
+    // worker threads and the polling thread can post to it.
+    //
+
+    Status = IopMapIoRingUserBuffer(
+                                Parameters->Ring,
+                                IO_RING_SIZE(SubmissionCount, CompletionCount),
+                                &(Ring->RingBuffer),
+                                &RingAddress);
+
+    if (!KSUCCESS(Status)) {
+        goto CreateIoRingEnd;
+    }
+
+    Ring->Shared = RingAddress;
+    Ring->Submissions = RingAddress + IO_RING_SUBMISSION_OFFSET;
+    Ring->Completions = RingAddress +
+                        IO_RING_COMPLETION_OFFSET(SubmissionCount);
+    Ring->SubmissionMask = SubmissionCount - 1;
+    Ring->CompletionMask = CompletionCount - 1;
+    RtlZeroMemory(Ring->Shared, sizeof(IO_RING_HEADER));
+    Ring->Shared->SubmissionMask = Ring->SubmissionMask;
+    Ring->Shared->CompletionMask = Ring->CompletionMask;
+    if (Parameters->BufferRegionSize != 0) {
+        Status = IopMapIoRingUserBuffer(Parameters->BufferRegion,
+                                        Parameters->BufferRegionSize,
+                                        &(Ring->BufferRegion),
+                                        &(Ring->BufferRegionAddress));
+
+        if (!KSUCCESS(Status)) {
+            goto CreateIoRingEnd;
+        }
+
+        Ring->BufferRegionSize = Parameters->BufferRegionSize;
+    }
+
+    if (Parameters->HandleCount != 0) {
+        Status = IopRegisterIoRingHandles(Ring,
+                                          Parameters->Handles,
+                                          Parameters->HandleCount);
+
+        if (!KSUCCESS(Status)) {
+            goto CreateIoRingEnd;
+        }
+    }
+
+    Thread = KeGetCurrentThread();
+    IopFillOutFilePropertiesForObject(&FileProperties, &(Ring->Header));
+    FileProperties.Permissions = Permissions;
+    FileProperties.Type = IoObjectIoRing;
+    FileProperties.UserId = Thread->Identity.EffectiveUserId;
+    FileProperties.GroupId = Thread->Identity.EffectiveGroupId;
+    Status = IopCreateOrLookupFileObject(&FileProperties,
+                                         ObGetRootObject(),
+                                         0,
+                                         &NewFileObject,
+                                         &Created);
+
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Release the reference added by filling out the file properties.
+        //
+
+        ObReleaseReference(Ring);
+        goto CreateIoRingEnd;
+    }
+
+    ASSERT(Created != FALSE);
+    ASSERT(NewFileObject->IoState != NULL);
+
+    Ring->IoState = NewFileObject->IoState;
+    IoSetIoObjectState(Ring->IoState, POLL_EVENT_IN, FALSE);
+    NewFileObject->SpecialIo = Ring;
+    Ring = NULL;
+    *FileObject = NewFileObject;
+    Status = STATUS_SUCCESS;
+
+CreateIoRingEnd:
+
+    //
+    // On both success and failure, the file object's ready event needs to be
+    // signaled. Other threads may be waiting on the event.
+    //
+
+    if (NewFileObject != NULL) {
+        KeSignalEvent(NewFileObject->ReadyEvent, SignalOptionSignalAll);
+    }
+
+    if (Ring != NULL) {
+        ObReleaseReference(Ring);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopOpenIoRing (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O ring is opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the new I/O handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PIO_RING Ring;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectIoRing);
+
+    Ring = IoHandle->FileObject->SpecialIo;
+    RtlAtomicAdd32(&(Ring->HandleCount), 1);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCloseIoRing (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O ring handle is closed. When the last
+    handle goes away, the polling thread is stopped, parked operations are
+    canceled, and the registered handles are released.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    LIST_ENTRY DeferredList;
+    PIO_RING Ring;
+    PIO_RING_WORK Work;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectIoRing);
+
+    Ring = IoHandle->FileObject->SpecialIo;
+    if (RtlAtomicAdd32(&(Ring->HandleCount), -1) != 1) {
+        return STATUS_SUCCESS;
+    }
+
+    INITIALIZE_LIST_HEAD(&DeferredList);
+    KeAcquireQueuedLock(Ring->Lock);
+    Ring->Closing = TRUE;
+    Ring->IoState = NULL;
+    if (LIST_EMPTY(&(Ring->DeferredListHead)) == FALSE) {
+        MOVE_LIST(&(Ring->DeferredListHead), &DeferredList);
+        INITIALIZE_LIST_HEAD(&(Ring->DeferredListHead));
+    }
+
+    KeReleaseQueuedLock(Ring->Lock);
+    while (LIST_EMPTY(&DeferredList) == FALSE) {
+        Work = LIST_VALUE(DeferredList.Next, IO_RING_WORK, Header.ListEntry);
+        LIST_REMOVE(&(Work->Header.ListEntry));
+        IopPostIoRingCompletion(Ring,
+                                Work->Submission.UserData,
+                                STATUS_OPERATION_CANCELLED,
+                                0);
+
+        IopDestroyIoRingWork(Work, TRUE);
+    }
+
+    //
+    // Wake the polling thread so it notices the ring is closing, then wait
+    // for any consumer to finish with the registered handles before dropping
+    // them. Operations already underway hold their own handle references.
+    //
+
+    KeSignalEvent(Ring->PollEvent, SignalOptionSignalAll);
+    KeAcquireQueuedLock(Ring->SubmitLock);
+    IopReleaseIoRingHandles(Ring);
+    KeReleaseQueuedLock(Ring->SubmitLock);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopPerformIoRingIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles reads and writes to an I/O ring, which are not
+    supported. The ring is only operated through its shared memory and
+    polled for completions.
+
+Arguments:
+
+    Handle - Supplies a pointer to the I/O ring handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    STATUS_NOT_SUPPORTED always.
+
+--*/
+
+{
+
+    ASSERT(Handle->FileObject->Properties.Type == IoObjectIoRing);
+
+    IoContext->BytesCompleted = 0;
+    return STATUS_NOT_SUPPORTED;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopDestroyIoRing (
+    PVOID Object
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys an I/O ring.
+
+Arguments:
+
+    Object - Supplies a pointer to the ring being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PIO_RING Ring;
+
+    Ring = Object;
+
+    ASSERT(Ring->InFlight == 0);
+    ASSERT(LIST_EMPTY(&(Ring->DeferredListHead)) != FALSE);
+
+    IopReleaseIoRingHandles(Ring);
+    if (Ring->BufferRegion != NULL) {
+        MmFreeIoBuffer(Ring->BufferRegion);
+    }
+
+    if (Ring->RingBuffer != NULL) {
+        MmFreeIoBuffer(Ring->RingBuffer);
+    }
+
+    if (Ring->PollEvent != NULL) {
+        KeDestroyEvent(Ring->PollEvent);
+    }
+
+    if (Ring->SubmitLock != NULL) {
+        KeDestroyQueuedLock(Ring->SubmitLock);
+    }
+
+    if (Ring->Lock != NULL) {
+        KeDestroyQueuedLock(Ring->Lock);
+    }
+
+    return;
+}
+
+KSTATUS
+IopMapIoRingUserBuffer (
+    PVOID Buffer,
+    UINTN Size,
+    PIO_BUFFER *LockedBuffer,
+    PVOID *KernelAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine locks down a region of the current process' user mode memory
+    and maps it virtually contiguously into kernel address space.
+
+Arguments:
+
+    Buffer - Supplies the user mode address of the region.
+
+    Size - Supplies the size of the region in bytes.
+
+    LockedBuffer - Supplies a pointer where the locked I/O buffer will be
+        returned on success. Freeing it unmaps and unlocks the region.
+
+    KernelAddress - Supplies a pointer where the kernel address of the region
+        will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PIO_BUFFER Locked;
+    KSTATUS Status;
+    PIO_BUFFER Unlocked;
+
+    *LockedBuffer = NULL;
+    *KernelAddress = NULL;
+    Status = MmCreateIoBuffer(Buffer, Size, 0, &Unlocked);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    Status = IopLockUserIoBuffer(Unlocked, TRUE, &Locked);
+    MmFreeIoBuffer(Unlocked);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    Status = MmMapIoBuffer(Locked, FALSE, FALSE, TRUE);
+    if (!KSUCCESS(Status)) {
+        MmFreeIoBuffer(Locked);
+        return Status;
+    }
+
+    *LockedBuffer = Locked;
+    *KernelAddress = Locked->Fragment[0].VirtualAddress;
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopRegisterIoRingHandles (
+    PIO_RING Ring,
+    PHANDLE Handles,
+    ULONG HandleCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks up and references the handles registered with a new
+    I/O ring.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+    Handles - Supplies the user mode array of handles.
+
+    HandleCount - Supplies the number of elements in the array.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    PIO_HANDLE IoHandle;
+    ULONG Index;
+    PKPROCESS Process;
+    KSTATUS Status;
+    PHANDLE UserHandles;
+
+    Process = PsGetCurrentProcess();
+    AllocationSize = HandleCount * (sizeof(HANDLE) + sizeof(PIO_HANDLE));
+    Ring->RegisteredHandles = MmAllocatePagedPool(AllocationSize,
+                                                  IO_RING_ALLOCATION_TAG);
+
+    if (Ring->RegisteredHandles == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    UserHandles = (PHANDLE)(Ring->RegisteredHandles + HandleCount);
+    Status = MmCopyFromUserMode(UserHandles,
+                                Handles,
+                                HandleCount * sizeof(HANDLE));
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    for (Index = 0; Index < HandleCount; Index += 1) {
+        IoHandle = ObGetHandleValue(Process->HandleTable,
+                                    UserHandles[Index],
+                                    NULL);
+
+        if (IoHandle == NULL) {
+            return STATUS_INVALID_HANDLE;
+        }
+
+        //
+        // A ring referencing itself, or another ring, would never be freed.
+        //
+
+        if (IoHandle->FileObject->Properties.Type == IoObjectIoRing) {
+            IoIoHandleReleaseReference(IoHandle);
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        Ring->RegisteredHandles[Index] = IoHandle;
+        Ring->RegisteredHandleCount += 1;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+IopReleaseIoRingHandles (
+    PIO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases the handles registered with an I/O ring. The caller
+    must hold the submit lock or otherwise have exclusive access to the ring.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Index;
+
+    if (Ring->RegisteredHandles == NULL) {
+        return;
+    }
+
+    for (Index = 0; Index < Ring->RegisteredHandleCount; Index += 1) {
+        IoIoHandleReleaseReference(Ring->RegisteredHandles[Index]);
+    }
+
+    MmFreePagedPool(Ring->RegisteredHandles);
+    Ring->RegisteredHandles = NULL;
+    Ring->RegisteredHandleCount = 0;
+    return;
+}
+
+ULONG
+IopConsumeIoRingSubmissions (
+    PIO_RING Ring,
+    ULONG Count,
+    BOOL FromPoller
+    )
+
+/*++
+
+Routine Description:
+
+    This routine consumes submissions from an I/O ring. Each operation is
+    attempted right away without blocking. Operations that would block are
+    parked on the asynchronous I/O worker threads as a single batch.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+    Count - Supplies the maximum number of submissions to consume.
+
+    FromPoller - Supplies a boolean indicating whether the caller is the
+        ring's kernel polling thread, which cannot touch user memory.
+
+Return Value:
+
+    Returns the number of submissions consumed. This stops short if the
+    submission queue empties, or if there would be no room in the completion
+    queue for more operations.
+
+--*/
+
+{
+
+    ULONG Consumed;
+    BOOL NonBlocking;
+    ULONG ParkedCount;
+    LIST_ENTRY ParkedList;
+    PIO_RING_WORK ParkedWork;
+    UINTN Result;
+    KSTATUS Status;
+    ULONG Tail;
+    IO_RING_WORK Work;
+
+    Consumed = 0;
+    ParkedCount = 0;
+    INITIALIZE_LIST_HEAD(&ParkedList);
+    KeAcquireQueuedLock(Ring->SubmitLock);
+    while ((Consumed < Count) && (Ring->Closing == FALSE)) {
+        Tail = Ring->Shared->SubmissionTail;
+        if (Tail == Ring->SubmissionHead) {
+            break;
+        }
+
+        if (IopReserveIoRingCompletion(Ring) == FALSE) {
+            break;
+        }
+
+        //
+        // Read the entry only after seeing the tail that covers it, and take
+        // a private copy so user mode cannot change it mid-operation.
+        //
+
+        RtlMemoryBarrier();
+        RtlCopyMemory(&(Work.Submission),
+                      &(Ring->Submissions[Ring->SubmissionHead &
+                                          Ring->SubmissionMask]),
+                      sizeof(IO_RING_SUBMISSION));
+
+        Ring->SubmissionHead += 1;
+        Ring->Shared->SubmissionHead = Ring->SubmissionHead;
+        Consumed += 1;
+        Result = 0;
+        Status = IopPrepareIoRingWork(Ring, &Work, FromPoller);
+        if (KSUCCESS(Status)) {
+            Status = IopPerformIoRingOperation(&Work, !FromPoller, &Result);
+            if ((Status == STATUS_TRY_AGAIN) || (Status == STATUS_TIMEOUT)) {
+
+                //
+                // Transfers on non-blocking handles fail rather than wait.
+                // Polls and flushes always wait, as do accepts the polling
+                // thread cannot finish itself.
+                //
+
+                NonBlocking = FALSE;
+                if ((Work.Handle->OpenFlags & OPEN_FLAG_NON_BLOCKING) != 0) {
+                    switch (Work.Submission.Operation) {
+                    case IoRingOperationPollAdd:
+                    case IoRingOperationFlush:
+                        break;
+
+                    case IoRingOperationAccept:
+                        if (FromPoller == FALSE) {
+                            NonBlocking = TRUE;
+                        }
+
+                        break;
+
+                    default:
+                        NonBlocking = TRUE;
+                        break;
+                    }
+                }
+
+                //
+                // Park operations that would block. If they cannot be parked,
+                // fail them rather than blocking the consumer.
+                //
+
+                Status = STATUS_TRY_AGAIN;
+                if (NonBlocking == FALSE) {
+                    Status = IopParkIoRingWork(&Work, &ParkedWork);
+                    if (KSUCCESS(Status)) {
+                        INSERT_BEFORE(&(ParkedWork->Header.ListEntry),
+                                      &ParkedList);
+
+                        ParkedCount += 1;
+                        continue;
+                    }
+                }
+            }
+        }
+
+        IopDestroyIoRingWork(&Work, FALSE);
+        IopPostIoRingCompletion(Ring,
+                                Work.Submission.UserData,
+                                Status,
+                                Result);
+    }
+
+    KeReleaseQueuedLock(Ring->SubmitLock);
+    if (ParkedCount != 0) {
+        IopQueueAsyncWork(&ParkedList, ParkedCount);
+    }
+
+    return Consumed;
+}
+
+BOOL
+IopReserveIoRingCompletion (
+    PIO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reserves a slot in the completion queue for an operation
+    about to be consumed.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    TRUE if a slot was reserved.
+
+    FALSE if the completion queue has no free slots.
+
+--*/
+
+{
+
+    ULONG Entries;
+    BOOL Reserved;
+    ULONG Used;
+
+    Entries = Ring->CompletionMask + 1;
+    Reserved = FALSE;
+    KeAcquireQueuedLock(Ring->Lock);
+    Used = Ring->CompletionTail - Ring->Shared->CompletionHead;
+    if ((Used <= Entries) && ((Entries - Used) > Ring->InFlight)) {
+        Ring->InFlight += 1;
+        Reserved = TRUE;
+    }
+
+    KeReleaseQueuedLock(Ring->Lock);
+    return Reserved;
+}
+
+KSTATUS
+IopPrepareIoRingWork (
+    PIO_RING Ring,
+    PIO_RING_WORK Work,
+    BOOL FromPoller
+    )
+
+/*++
+
+Routine Description:
+
+    This routine validates a submission and looks up the handle and buffer
+    it refers to.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+    Work - Supplies a pointer to the operation, with the submission filled
+        in. The rest of the structure is initialized by this routine. The
+        caller must destroy the operation regardless of the result.
+
+    FromPoller - Supplies a boolean indicating whether the caller is the
+        ring's kernel polling thread, which cannot touch user memory.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PVOID Buffer;
+    UINTN Offset;
+    PKPROCESS Process;
+    UINTN Size;
+    KSTATUS Status;
+    PIO_RING_SUBMISSION Submission;
+
+    Submission = &(Work->Submission);
+    Work->Ring = Ring;
+    Work->Handle = NULL;
+    Work->IoBuffer = NULL;
+    Work->UserBuffer = FALSE;
+    if (((Submission->Flags & ~IO_RING_SUBMISSION_FLAGS_MASK) != 0) ||
+        (Submission->Operation >= IoRingOperationCount) ||
+        ((Submission->Offset < 0) && (Submission->Offset != IO_OFFSET_NONE))) {
+
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Submission->Operation == IoRingOperationNop) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // Look up the handle.
+    //
+
+    if ((Submission->Flags & IO_RING_SUBMISSION_FLAG_REGISTERED_HANDLE) != 0) {
+        if ((UINTN)(Submission->Handle) >= Ring->RegisteredHandleCount) {
+            return STATUS_INVALID_HANDLE;
+        }
+
+        Work->Handle = Ring->RegisteredHandles[(UINTN)(Submission->Handle)];
+        IoIoHandleAddReference(Work->Handle);
+
+    } else {
+        if (FromPoller != FALSE) {
+            return STATUS_NOT_SUPPORTED;
+        }
+
+        Process = PsGetCurrentProcess();
+        Work->Handle = ObGetHandleValue(Process->HandleTable,
+                                        Submission->Handle,
+                                        NULL);
+
+        if (Work->Handle == NULL) {
+            return STATUS_INVALID_HANDLE;
+        }
+    }
+
+    //
+    // Describe the buffer.
+    //
+
+    Size = Submission->Size;
+    switch (Submission->Operation) {
+    case IoRingOperationRead:
+    case IoRingOperationWrite:
+    case IoRingOperationSend:
+    case IoRingOperationReceive:
+        if (Size > (UINTN)MAX_INTN) {
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        if ((Submission->Flags & IO_RING_SUBMISSION_FLAG_REGISTERED_BUFFER) !=
+            0) {
+
+            Offset = (UINTN)(Submission->Buffer);
+            if ((Offset > Ring->BufferRegionSize) ||
+                (Size > (Ring->BufferRegionSize - Offset))) {
+
+                return STATUS_INVALID_PARAMETER;
+            }
+
+            Buffer = Ring->BufferRegionAddress + Offset;
+            Status = MmCreateIoBuffer(Buffer,
+                                      Size,
+                                      IO_BUFFER_FLAG_KERNEL_MODE_DATA,
+                                      &(Work->IoBuffer));
+
+        } else {
+            if (FromPoller != FALSE) {
+                return STATUS_NOT_SUPPORTED;
+            }
+
+            Status = MmCreateIoBuffer(Submission->Buffer,
+                                      Size,
+                                      0,
+                                      &(Work->IoBuffer));
+
+            Work->UserBuffer = TRUE;
+        }
+
+        break;
+
+    case IoRingOperationReadVector:
+        if ((FromPoller != FALSE) ||
+            ((Submission->Flags & IO_RING_SUBMISSION_FLAG_REGISTERED_BUFFER) !=
+             0)) {
+
+            return STATUS_NOT_SUPPORTED;
+        }
+
+        Status = MmCreateIoBufferFromVector(Submission->Buffer,
+                                            FALSE,
+                                            Size,
+                                            &(Work->IoBuffer));
+
+        Work->UserBuffer = TRUE;
+        break;
+
+    case IoRingOperationPollAdd:
+    case IoRingOperationAccept:
+    case IoRingOperationFlush:
+        Status = STATUS_SUCCESS;
+        break;
+
+    default:
+
+        ASSERT(FALSE);
+
+        Status = STATUS_INVALID_PARAMETER;
+        break;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopParkIoRingWork (
+    PIO_RING_WORK Work,
+    PIO_RING_WORK *ParkedWork
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies an operation that would block so it can be handed to
+    a worker thread, locking down any user mode buffer it refers to.
+
+Arguments:
+
+    Work - Supplies a pointer to the operation on the consumer's stack. On
+        success, its handle and buffer references are transferred to the
+        parked copy.
+
+    ParkedWork - Supplies a pointer where the parked copy will be returned on
+        success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PIO_BUFFER LockedBuffer;
+    PIO_RING_WORK NewWork;
+    KSTATUS Status;
+    BOOL Write;
+
+    *ParkedWork = NULL;
+    NewWork = MmAllocatePagedPool(sizeof(IO_RING_WORK),
+                                  IO_RING_ALLOCATION_TAG);
+
+    if (NewWork == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if ((Work->IoBuffer != NULL) && (Work->UserBuffer != FALSE)) {
+        Write = FALSE;
+        if ((Work->Submission.Operation == IoRingOperationRead) ||
+            (Work->Submission.Operation == IoRingOperationReadVector) ||
+            (Work->Submission.Operation == IoRingOperationReceive)) {
+
+            Write = TRUE;
+        }
+
+        Status = IopLockUserIoBuffer(Work->IoBuffer, Write, &LockedBuffer);
+        if (!KSUCCESS(Status)) {
+            MmFreePagedPool(NewWork);
+            return Status;
+        }
+
+        MmFreeIoBuffer(Work->IoBuffer);
+        Work->IoBuffer = LockedBuffer;
+    }
+
+    RtlCopyMemory(NewWork, Work, sizeof(IO_RING_WORK));
+    NewWork->Header.Routine = IopPerformParkedIoRingWork;
+    ObAddReference(NewWork->Ring);
+    Work->Handle = NULL;
+    Work->IoBuffer = NULL;
+    *ParkedWork = NewWork;
+    return STATUS_SUCCESS;
+}
+
+VOID
+IopDestroyIoRingWork (
+    PIO_RING_WORK Work,
+    BOOL Parked
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases the resources held by an I/O ring operation.
+
+Arguments:
+
+    Work - Supplies a pointer to the operation.
+
+    Parked - Supplies a boolean indicating whether the operation was parked,
+        in which case it holds a ring reference and is freed as well.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Work->Handle != NULL) {
+        IoIoHandleReleaseReference(Work->Handle);
+        Work->Handle = NULL;
+    }
+
+    if (Work->IoBuffer != NULL) {
+        MmFreeIoBuffer(Work->IoBuffer);
+        Work->IoBuffer = NULL;
+    }
+
+    if (Parked != FALSE) {
+        ObReleaseReference(Work->Ring);
+        MmFreePagedPool(Work);
+    }
+
+    return;
+}
+
+KSTATUS
+IopPerformIoRingOperation (
+    PIO_RING_WORK Work,
+    BOOL InProcess,
+    PUINTN Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts an I/O ring operation without blocking.
+
+Arguments:
+
+    Work - Supplies a pointer to the prepared operation.
+
+    InProcess - Supplies a boolean indicating whether the caller is running
+        in the context of the process that owns the ring. Accepted
+        connections can only be given handles in that context.
+
+    Result - Supplies a pointer where the result of the operation is
+        returned.
+
+Return Value:
+
+    STATUS_TRY_AGAIN or STATUS_TIMEOUT if the operation would block.
+
+    Other status codes for the operation's final result.
+
+--*/
+
+{
+
+    UINTN BytesCompleted;
+    ULONG Events;
+    PIO_OBJECT_STATE IoState;
+    NETWORK_ADDRESS LocalAddress;
+    HANDLE NewHandle;
+    PIO_HANDLE NewIoHandle;
+    PKPROCESS Process;
+    PSTR RemotePath;
+    UINTN RemotePathSize;
+    SOCKET_IO_PARAMETERS SocketParameters;
+    KSTATUS Status;
+    PIO_RING_SUBMISSION Submission;
+
+    BytesCompleted = 0;
+    Submission = &(Work->Submission);
+    switch (Submission->Operation) {
+    case IoRingOperationNop:
+        Status = STATUS_SUCCESS;
+        break;
+
+    case IoRingOperationRead:
+    case IoRingOperationReadVector:
+        Status = STATUS_SUCCESS;
+        if (Work->IoBuffer != NULL) {
+            Status = IoReadAtOffset(Work->Handle,
+                                    Work->IoBuffer,
+                                    Submission->Offset,
+                                    MmGetIoBufferSize(Work->IoBuffer),
+                                    0,
+                                    0,
+                                    &BytesCompleted,
+                                    NULL);
+
+            if (Status == STATUS_END_OF_FILE) {
+                Status = STATUS_SUCCESS;
+            }
+        }
+
+        break;
+
+    case IoRingOperationWrite:
+        Status = IoWriteAtOffset(Work->Handle,
+                                 Work->IoBuffer,
+                                 Submission->Offset,
+                                 Submission->Size,
+                                 0,
+                                 0,
+                                 &BytesCompleted,
+                                 NULL);
+
+        break;
+
+    case IoRingOperationSend:
+    case IoRingOperationReceive:
+        RtlZeroMemory(&SocketParameters, sizeof(SOCKET_IO_PARAMETERS));
+        SocketParameters.Size = Submission->Size;
+        SocketParameters.SocketIoFlags = Submission->OperationFlags;
+        SocketParameters.TimeoutInMilliseconds = 0;
+        if (Submission->Operation == IoRingOperationSend) {
+            Status = IoSocketSendData(FALSE,
+                                      Work->Handle,
+                                      &SocketParameters,
+                                      Work->IoBuffer);
+
+        } else {
+            Status = IoSocketReceiveData(FALSE,
+                                         Work->Handle,
+                                         &SocketParameters,
+                                         Work->IoBuffer);
+        }
+
+        BytesCompleted = SocketParameters.BytesCompleted;
+        break;
+
+    case IoRingOperationPollAdd:
+        Events = Submission->OperationFlags;
+        IoState = Work->Handle->FileObject->IoState;
+        switch (Work->Handle->FileObject->Properties.Type) {
+        case IoObjectRegularFile:
+        case IoObjectRegularDirectory:
+        case IoObjectObjectDirectory:
+        case IoObjectSharedMemoryObject:
+            Events &= POLL_NONMASKABLE_FILE_EVENTS;
+            break;
+
+        default:
+
+            ASSERT(IoState != NULL);
+
+            Events = IoState->Events & (Events | POLL_NONMASKABLE_EVENTS);
+            break;
+        }
+
+        BytesCompleted = Events;
+        Status = STATUS_SUCCESS;
+        if (Events == 0) {
+            Status = STATUS_TRY_AGAIN;
+        }
+
+        break;
+
+    case IoRingOperationAccept:
+        if (InProcess == FALSE) {
+            Status = STATUS_TRY_AGAIN;
+            break;
+        }
+
+        //
+        // Only accept once a connection is waiting, as accepting blocks.
+        //
+
+        IoState = Work->Handle->FileObject->IoState;
+        if ((IoState == NULL) ||
+            ((IoState->Events & (POLL_EVENT_IN | POLL_NONMASKABLE_EVENTS)) ==
+             0)) {
+
+            Status = STATUS_TRY_AGAIN;
+            break;
+        }
+
+        NewIoHandle = NULL;
+        Status = IoSocketAccept(Work->Handle,
+                                &NewIoHandle,
+                                &LocalAddress,
+                                &RemotePath,
+                                &RemotePathSize);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        if ((Submission->OperationFlags & SYS_OPEN_FLAG_NON_BLOCKING) != 0) {
+            NewIoHandle->OpenFlags |= OPEN_FLAG_NON_BLOCKING;
+        }
+
+        Events = 0;
+        if ((Submission->OperationFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) !=
+            0) {
+
+            Events |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+        }
+
+        Process = PsGetCurrentProcess();
+        Status = ObCreateHandle(Process->HandleTable,
+                                NewIoHandle,
+                                Events,
+                                &NewHandle);
+
+        if (!KSUCCESS(Status)) {
+            IoIoHandleReleaseReference(NewIoHandle);
+            break;
+        }
+
+        BytesCompleted = (UINTN)NewHandle;
+        break;
+
+    case IoRingOperationFlush:
+
+        //
+        // Flushes always wait on the storage stack, so never hold up the
+        // consumer with them.
+        //
+
+        Status = STATUS_TRY_AGAIN;
+        break;
+
+    default:
+
+        ASSERT(FALSE);
+
+        Status = STATUS_INVALID_PARAMETER;
+        break;
+    }
+
+    *Result = BytesCompleted;
+    return Status;
+}
+
+ULONG
+IopGetIoRingWaitEvents (
+    PIO_RING_WORK Work
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines which poll events a parked I/O ring operation
+    is waiting for.
+
+Arguments:
+
+    Work - Supplies a pointer to the operation.
+
+Return Value:
+
+    Returns a mask of POLL_EVENT_* flags, or zero if the operation does not
+    wait for its handle to become ready.
+
+--*/
+
+{
+
+    switch (Work->Submission.Operation) {
+    case IoRingOperationRead:
+    case IoRingOperationReadVector:
+    case IoRingOperationReceive:
+    case IoRingOperationAccept:
+        return POLL_EVENT_IN;
+
+    case IoRingOperationWrite:
+    case IoRingOperationSend:
+        return POLL_EVENT_OUT;
+
+    case IoRingOperationPollAdd:
+        return Work->Submission.OperationFlags;
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+VOID
+IopPerformParkedIoRingWork (
+    PIO_ASYNC_WORK AsyncWork
+    )
+
+/*++
+
+Routine Description:
+
+    This routine runs a parked I/O ring operation on an asynchronous I/O
+    worker thread. It waits for the handle to become ready, retries the
+    operation, and posts its completion. Accepts that become ready are handed
+    back to the ring to be finished the next time it is entered.
+
+Arguments:
+
+    AsyncWork - Supplies a pointer to the header of the parked operation.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Events;
+    PIO_OBJECT_STATE IoState;
+    UINTN Result;
+    PIO_RING Ring;
+    KSTATUS Status;
+    PIO_RING_WORK Work;
+
+    Work = PARENT_STRUCTURE(AsyncWork, IO_RING_WORK, Header);
+    Ring = Work->Ring;
+    Result = 0;
+    if (Work->Submission.Operation == IoRingOperationFlush) {
+        Status = IoFlush(Work->Handle, 0, -1, 0);
+        goto PerformParkedIoRingWorkEnd;
+    }
+
+    Events = IopGetIoRingWaitEvents(Work);
+    IoState = Work->Handle->FileObject->IoState;
+    while (TRUE) {
+        if (Ring->Closing != FALSE) {
+            Status = STATUS_OPERATION_CANCELLED;
+            break;
+        }
+
+        //
+        // Wait in slices so that closing the ring eventually cancels the
+        // operation even if the handle never becomes ready.
+        //
+
+        if ((IoState != NULL) && (Events != 0)) {
+            Status = IoWaitForIoObjectState(IoState,
+                                            Events,
+                                            FALSE,
+                                            IO_RING_WAIT_SLICE,
+                                            NULL);
+
+            if (Status == STATUS_TIMEOUT) {
+                continue;
+            }
+
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+        }
+
+        if (Work->Submission.Operation == IoRingOperationAccept) {
+            KeAcquireQueuedLock(Ring->Lock);
+            if (Ring->Closing == FALSE) {
+                INSERT_BEFORE(&(Work->Header.ListEntry),
+                              &(Ring->DeferredListHead));
+
+                if (Ring->IoState != NULL) {
+                    IoSetIoObjectState(Ring->IoState, POLL_EVENT_IN, TRUE);
+                }
+
+                Work = NULL;
+            }
+
+            KeReleaseQueuedLock(Ring->Lock);
+            if (Work == NULL) {
+                return;
+            }
+
+            continue;
+        }
+
+        Status = IopPerformIoRingOperation(Work, FALSE, &Result);
+        if ((Status != STATUS_TRY_AGAIN) && (Status != STATUS_TIMEOUT)) {
+            break;
+        }
+
+        //
+        // Something else got there first. Without an I/O object state to
+        // wait on, back off before trying again.
+        //
+
+        if (IoState == NULL) {
+            KeYield();
+        }
+    }
+
+PerformParkedIoRingWorkEnd:
+    IopPostIoRingCompletion(Ring, Work->Submission.UserData, Status, Result);
+    IopDestroyIoRingWork(Work, TRUE);
+    return;
+}
+
+VOID
+IopRunDeferredIoRingWork (
+    PIO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finishes parked operations that became ready but need the
+    context of the ring's process, namely accepts, which create handles.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LIST_ENTRY DeferredList;
+    ULONG ParkedCount;
+    LIST_ENTRY ParkedList;
+    UINTN Result;
+    KSTATUS Status;
+    PIO_RING_WORK Work;
+
+    if (LIST_EMPTY(&(Ring->DeferredListHead)) != FALSE) {
+        return;
+    }
+
+    INITIALIZE_LIST_HEAD(&DeferredList);
+    INITIALIZE_LIST_HEAD(&ParkedList);
+    ParkedCount = 0;
+    KeAcquireQueuedLock(Ring->Lock);
+    if (LIST_EMPTY(&(Ring->DeferredListHead)) == FALSE) {
+        MOVE_LIST(&(Ring->DeferredListHead), &DeferredList);
+        INITIALIZE_LIST_HEAD(&(Ring->DeferredListHead));
+    }
+
+    KeReleaseQueuedLock(Ring->Lock);
+    while (LIST_EMPTY(&DeferredList) == FALSE) {
+        Work = LIST_VALUE(DeferredList.Next, IO_RING_WORK, Header.ListEntry);
+        LIST_REMOVE(&(Work->Header.ListEntry));
+        Status = IopPerformIoRingOperation(Work, TRUE, &Result);
+
+        //
+        // If another thread took the connection, go back to waiting.
+        //
+
+        if ((Status == STATUS_TRY_AGAIN) || (Status == STATUS_TIMEOUT)) {
+            INSERT_BEFORE(&(Work->Header.ListEntry), &ParkedList);
+            ParkedCount += 1;
+            continue;
+        }
+
+        IopPostIoRingCompletion(Ring,
+                                Work->Submission.UserData,
+                                Status,
+                                Result);
+
+        IopDestroyIoRingWork(Work, TRUE);
+    }
+
+    if (ParkedCount != 0) {
+        IopQueueAsyncWork(&ParkedList, ParkedCount);
+    }
+
+    return;
+}
+
+VOID
+IopPostIoRingCompletion (
+    PIO_RING Ring,
+    ULONGLONG UserData,
+    KSTATUS Status,
+    UINTN Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine posts a completion to an I/O ring, releasing the slot that
+    was reserved for it, and wakes anyone waiting on the ring.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+    UserData - Supplies the user data from the submission.
+
+    Status - Supplies the final status of the operation.
+
+    Result - Supplies the result of the operation.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PIO_RING_COMPLETION Completion;
+    ULONG Used;
+
+    KeAcquireQueuedLock(Ring->Lock);
+
+    ASSERT(Ring->InFlight != 0);
+
+    Ring->InFlight -= 1;
+
+    //
+    // A slot was reserved for this completion, so the queue can only be full
+    // if user mode moved its head backwards.
+    //
+
+    Used = Ring->CompletionTail - Ring->Shared->CompletionHead;
+    if (Used > Ring->CompletionMask) {
+        Ring->Shared->Dropped += 1;
+
+    } else {
+        Completion = &(Ring->Completions[Ring->CompletionTail &
+                                         Ring->CompletionMask]);
+
+        Completion->UserData = UserData;
+        Completion->Status = Status;
+        Completion->Result = Result;
+
+        //
+        // Make the entry visible before the tail that covers it.
+        //
+
+        RtlMemoryBarrier();
+        Ring->CompletionTail += 1;
+        Ring->Shared->CompletionTail = Ring->CompletionTail;
+    }
+
+    if (Ring->IoState != NULL) {
+        IoSetIoObjectState(Ring->IoState, POLL_EVENT_IN, TRUE);
+    }
+
+    KeReleaseQueuedLock(Ring->Lock);
+    return;
+}
+
+KSTATUS
+IopWaitForIoRingCompletions (
+    PIO_RING Ring,
+    ULONG WaitCount,
+    ULONG TimeoutInMilliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits until an I/O ring's completion queue holds at least
+    the given number of entries.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring. The caller must hold a handle to
+        the ring, keeping its I/O object state alive.
+
+    WaitCount - Supplies the number of completions to wait for.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG Available;
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    ULONG Entries;
+    KSTATUS Status;
+    ULONGLONG TimeCounterFrequency;
+    ULONG WaitTime;
+
+    Entries = Ring->CompletionMask + 1;
+    if (WaitCount > Entries) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    WaitTime = TimeoutInMilliseconds;
+    while (TRUE) {
+        IopRunDeferredIoRingWork(Ring);
+
+        //
+        // Clear the in event under the lock if there is nothing to wait for
+        // so that a completion posted after this check wakes the wait.
+        //
+
+        KeAcquireQueuedLock(Ring->Lock);
+        Available = Ring->CompletionTail - Ring->Shared->CompletionHead;
+        if (Available > Entries) {
+            Available = 0;
+        }
+
+        if (Available >= WaitCount) {
+            KeReleaseQueuedLock(Ring->Lock);
+            Status = STATUS_SUCCESS;
+            break;
+        }
+
+        if (LIST_EMPTY(&(Ring->DeferredListHead)) == FALSE) {
+            KeReleaseQueuedLock(Ring->Lock);
+            continue;
+        }
+
+        ASSERT(Ring->IoState != NULL);
+
+        IoSetIoObjectState(Ring->IoState, POLL_EVENT_IN, FALSE);
+        KeReleaseQueuedLock(Ring->Lock);
+        if (TimeoutInMilliseconds == 0) {
+            Status = STATUS_TIMEOUT;
+            break;
+        }
+
+        Status = IoWaitForIoObjectState(Ring->IoState,
+                                        POLL_EVENT_IN,
+                                        TRUE,
+                                        WaitTime,
+                                        NULL);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        if (EndTime != 0) {
+            CurrentTime = KeGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                WaitTime = 0;
+
+            } else {
+                WaitTime = ((EndTime - CurrentTime) * MILLISECONDS_PER_SECOND) /
+                           TimeCounterFrequency;
+            }
+
+            //
+            // Check one last time once the deadline has passed.
+            //
+
+            if (WaitTime == 0) {
+                TimeoutInMilliseconds = 0;
+            }
+        }
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopStartIoRingPoller (
+    PIO_RING Ring
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts the kernel thread that polls an I/O ring's submission
+    queue.
+
+Arguments:
+
+    Ring - Supplies a pointer to the ring.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    ASSERT((Ring->Flags & IO_RING_FLAG_KERNEL_POLL) != 0);
+
+    ObAddReference(Ring);
+    Status = PsCreateKernelThread(IopIoRingPollThread,
+                                  Ring,
+                                  "IopIoRingPollThread");
+
+    if (!KSUCCESS(Status)) {
+        ObReleaseReference(Ring);
+    }
+
+    return Status;
+}
+
+VOID
+IopIoRingPollThread (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the kernel thread that polls an I/O ring's
+    submission queue. It keeps polling while submissions arrive, and goes to
+    sleep after the queue has been idle for a while, setting a flag in the
+    shared header that tells user mode to wake it.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the ring. The thread owns a reference
+        on the ring, released when the thread exits.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONGLONG IdleStart;
+    ULONGLONG IdleTicks;
+    PIO_RING Ring;
+
+    Ring = Parameter;
+    IdleTicks = KeConvertMicrosecondsToTimeTicks(
+                                               IO_RING_POLL_IDLE_MICROSECONDS);
+    IdleStart = KeGetRecentTimeCounter();
+    while (Ring->Closing == FALSE) {
+        if (IopConsumeIoRingSubmissions(Ring, MAX_ULONG, TRUE) != 0) {
+            IdleStart = KeGetRecentTimeCounter();
+            continue;
+        }
+
+        if ((KeGetRecentTimeCounter() - IdleStart) < IdleTicks) {
+            KeYield();
+            continue;
+        }
+
+        //
+        // Advertise that the thread is going to sleep, then look once more so
+        // that a submission made before user mode saw the flag is not missed.
+        // If the submissions are only stuck behind a full completion queue,
+        // sleep anyway: user mode wakes the thread after reaping.
+        //
+
+        KeSignalEvent(Ring->PollEvent, SignalOptionUnsignal);
+        RtlAtomicOr32(&(Ring->Shared->Flags), IO_RING_STATE_NEED_WAKE);
+        RtlMemoryBarrier();
+        if ((Ring->Shared->SubmissionTail == Ring->SubmissionHead) ||
+            (IopConsumeIoRingSubmissions(Ring, MAX_ULONG, TRUE) == 0)) {
+
+            KeWaitForEvent(Ring->PollEvent, FALSE, WAIT_TIME_INDEFINITE);
+        }
+
+        RtlAtomicAnd32(&(Ring->Shared->Flags), ~IO_RING_STATE_NEED_WAKE);
+        IdleStart = KeGetRecentTimeCounter();
+    }
+
+    ObReleaseReference(Ring);
+    return;
+}
@@ -0,0 +1,851 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    iotimer.c
+
+Abstract:
+
+    This module implements I/O timer objects. An I/O timer is a kernel timer
+    whose expirations are delivered through a handle rather than as a signal.
+    The handle becomes readable when the timer expires, and a read returns the
+    number of expirations since the previous read.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an I/O timer object.
+
+Members:
+
+    Header - Stores the standard object header.
+
+    Lock - Stores a pointer to the lock serializing reads, timer changes, and
+        updates to the I/O object state.
+
+    IoState - Stores a pointer to the I/O object state of the timer's file
+        object. The in event is set whenever there are unread expirations.
+
+    Timer - Stores a pointer to the kernel timer.
+
+    Dpc - Stores a pointer to the DPC that runs when the timer expires.
+
+    WorkItem - Stores a pointer to the work item queued by the DPC to signal
+        the I/O object state at low level.
+
+    Period - Stores the period of the timer in time counter ticks, or zero
+        for a one-shot timer.
+
+    Flags - Stores the IO_TIMER_FLAG_* flags the timer was created with.
+
+    ExpirationCount - Stores the number of expirations that have not yet been
+        read. This is incremented atomically by the DPC.
+
+    HandleCount - Stores the number of open handles to the timer. The timer is
+        disarmed when the last handle is closed.
+
+--*/
+
+typedef struct _IO_TIMER {
+    OBJECT_HEADER Header;
+    PQUEUED_LOCK Lock;
+    PIO_OBJECT_STATE IoState;
+    PKTIMER Timer;
+    PDPC Dpc;
+    PWORK_ITEM WorkItem;
+    ULONGLONG Period;
+    ULONG Flags;
+    volatile ULONG ExpirationCount;
+    volatile ULONG HandleCount;
+} IO_TIMER, *PIO_TIMER;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+IopDestroyIoTimer (
+    PVOID Object
+    );
+
+VOID
+IopCancelIoTimer (
+    PIO_TIMER IoTimer
+    );
+
+VOID
+IopIoTimerDpcRoutine (
+    PDPC Dpc
+    );
+
+VOID
+IopIoTimerWorkRoutine (
+    PVOID Parameter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateIoTimer (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O timer object on behalf of user mode.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG HandleFlags;
+    PIO_HANDLE IoHandle;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_CREATE_IO_TIMER Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_CREATE_IO_TIMER)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+
+    ASSERT(Process != PsGetKernelProcess());
+
+    if (((Parameters->OpenFlags &
+          ~(SYS_OPEN_FLAG_NON_BLOCKING |
+            SYS_OPEN_FLAG_CLOSE_ON_EXECUTE)) != 0) ||
+        ((Parameters->Flags & ~IO_TIMER_FLAGS_MASK) != 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateIoTimerEnd;
+    }
+
+    OpenFlags = OPEN_FLAG_CREATE;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_NON_BLOCKING) != 0) {
+        OpenFlags |= OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = IopOpen(FALSE,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ,
+                     OpenFlags,
+                     IoObjectTimer,
+                     Parameters,
+                     FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE,
+                     &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateIoTimerEnd;
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(Process->HandleTable,
+                            IoHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateIoTimerEnd;
+    }
+
+    IoHandle = NULL;
+
+SysCreateIoTimerEnd:
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysIoTimerControl (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets or sets the due time and period of an I/O timer.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PIO_HANDLE IoHandle;
+    PIO_TIMER IoTimer;
+    ULONGLONG OriginalDueTime;
+    ULONGLONG OriginalPeriod;
+    PSYSTEM_CALL_IO_TIMER_CONTROL Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_IO_TIMER_CONTROL)SystemCallParameter;
+    Process = PsGetCurrentProcess();
+    IoHandle = ObGetHandleValue(Process->HandleTable, Parameters->Handle, NULL);
+    if (IoHandle == NULL) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    if (IoHandle->FileObject->Properties.Type != IoObjectTimer) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysIoTimerControlEnd;
+    }
+
+    IoTimer = IoHandle->FileObject->SpecialIo;
+    KeAcquireQueuedLock(IoTimer->Lock);
+    OriginalDueTime = KeGetTimerDueTime(IoTimer->Timer);
+    OriginalPeriod = 0;
+    if (OriginalDueTime != 0) {
+        OriginalPeriod = IoTimer->Period;
+    }
+
+    switch (Parameters->Operation) {
+    case TimerOperationGetTimer:
+        Status = STATUS_SUCCESS;
+        break;
+
+    //
+    // Arm or disarm the timer, throwing away any unread expirations from the
+    // previous setting.
+    //
+
+    case TimerOperationSetTimer:
+        IopCancelIoTimer(IoTimer);
+        RtlAtomicExchange32(&(IoTimer->ExpirationCount), 0);
+        IoSetIoObjectState(IoTimer->IoState, POLL_EVENT_IN, FALSE);
+        IoTimer->Period = Parameters->TimerInformation.Period;
+        Status = STATUS_SUCCESS;
+        if (Parameters->TimerInformation.DueTime != 0) {
+            Status = KeQueueTimer(IoTimer->Timer,
+                                  TimerQueueSoftWake,
+                                  Parameters->TimerInformation.DueTime,
+                                  IoTimer->Period,
+                                  0,
+                                  IoTimer->Dpc);
+        }
+
+        break;
+
+    default:
+        Status = STATUS_INVALID_PARAMETER;
+        break;
+    }
+
+    KeReleaseQueuedLock(IoTimer->Lock);
+    Parameters->TimerInformation.DueTime = OriginalDueTime;
+    Parameters->TimerInformation.Period = OriginalPeriod;
+    Parameters->TimerInformation.OverflowCount = 0;
+    Parameters->Flags = IoTimer->Flags;
+
+SysIoTimerControlEnd:
+    IoIoHandleReleaseReference(IoHandle);
+    return Status;
+}
+
+KSTATUS
+IopCreateIoTimer (
+    PVOID OverrideParameter,
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new I/O timer object and its file object.
+
+Arguments:
+
+    OverrideParameter - Supplies a pointer to the I/O timer creation
+        parameters, a PSYSTEM_CALL_CREATE_IO_TIMER.
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    BOOL Created;
+    FILE_PROPERTIES FileProperties;
+    PIO_TIMER IoTimer;
+    PFILE_OBJECT NewFileObject;
+    PSYSTEM_CALL_CREATE_IO_TIMER Parameters;
+    KSTATUS Status;
+    PKTHREAD Thread;
+
+    ASSERT(*FileObject == NULL);
+
+    IoTimer = NULL;
+    NewFileObject = NULL;
+    Parameters = OverrideParameter;
+    if (Parameters == NULL) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto CreateIoTimerEnd;
+    }
+
+    //
+    // Create the object. This reference is transferred to the file object's
+    // special I/O member on success.
+    //
+
+    IoTimer = ObCreateObject(ObjectIoTimer,
+                             NULL,
+                             NULL,
+                             0,
+                             sizeof(IO_TIMER),
+                             IopDestroyIoTimer,
+                             0,
+                             IO_ALLOCATION_TAG);
+
+    if (IoTimer == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateIoTimerEnd;
+    }
+
+    IoTimer->Flags = Parameters->Flags;
+    Status = STATUS_INSUFFICIENT_RESOURCES;
+    IoTimer->Lock = KeCreateQueuedLock();
+    if (IoTimer->Lock == NULL) {
+        goto CreateIoTimerEnd;
+    }
+
+    IoTimer->Timer = KeCreateTimer(IO_ALLOCATION_TAG);
+    if (IoTimer->Timer == NULL) {
+        goto CreateIoTimerEnd;
+    }
+
+    IoTimer->Dpc = KeCreateDpc(IopIoTimerDpcRoutine, IoTimer);
+    if (IoTimer->Dpc == NULL) {
+        goto CreateIoTimerEnd;
+    }
+
+    IoTimer->WorkItem = KeCreateWorkItem(NULL,
+                                         WorkPriorityNormal,
+                                         IopIoTimerWorkRoutine,
+                                         IoTimer,
+                                         IO_ALLOCATION_TAG);
+
+    if (IoTimer->WorkItem == NULL) {
+        goto CreateIoTimerEnd;
+    }
+
+    Thread = KeGetCurrentThread();
+    IopFillOutFilePropertiesForObject(&FileProperties, &(IoTimer->Header));
+    FileProperties.Permissions = Permissions;
+    FileProperties.Type = IoObjectTimer;
+    FileProperties.UserId = Thread->Identity.EffectiveUserId;
+    FileProperties.GroupId = Thread->Identity.EffectiveGroupId;
+    Status = IopCreateOrLookupFileObject(&FileProperties,
+                                         ObGetRootObject(),
+                                         0,
+                                         &NewFileObject,
+                                         &Created);
+
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Release the reference added by filling out the file properties.
+        //
+
+        ObReleaseReference(IoTimer);
+        goto CreateIoTimerEnd;
+    }
+
+    ASSERT(Created != FALSE);
+    ASSERT(NewFileObject->IoState != NULL);
+
+    IoTimer->IoState = NewFileObject->IoState;
+    NewFileObject->SpecialIo = IoTimer;
+    IoTimer = NULL;
+    *FileObject = NewFileObject;
+    Status = STATUS_SUCCESS;
+
+CreateIoTimerEnd:
+
+    //
+    // On both success and failure, the file object's ready event needs to be
+    // signaled. Other threads may be waiting on the event.
+    //
+
+    if (NewFileObject != NULL) {
+        KeSignalEvent(NewFileObject->ReadyEvent, SignalOptionSignalAll);
+    }
+
+    if (IoTimer != NULL) {
+        ObReleaseReference(IoTimer);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopOpenIoTimer (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O timer is opened.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the new I/O handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PIO_TIMER IoTimer;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectTimer);
+
+    IoTimer = IoHandle->FileObject->SpecialIo;
+    RtlAtomicAdd32(&(IoTimer->HandleCount), 1);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCloseIoTimer (
+    PIO_HANDLE IoHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when an I/O timer handle is closed. The timer is
+    disarmed when the last handle goes away.
+
+Arguments:
+
+    IoHandle - Supplies a pointer to the I/O handle being closed.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PIO_TIMER IoTimer;
+
+    ASSERT(IoHandle->FileObject->Properties.Type == IoObjectTimer);
+
+    IoTimer = IoHandle->FileObject->SpecialIo;
+    if (RtlAtomicAdd32(&(IoTimer->HandleCount), -1) != 1) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // Once the timer and DPC are quiet, flush the work queue so that the
+    // work item is no longer touching the I/O object state, which goes away
+    // with the file object.
+    //
+
+    KeAcquireQueuedLock(IoTimer->Lock);
+    IopCancelIoTimer(IoTimer);
+    KeReleaseQueuedLock(IoTimer->Lock);
+    KeFlushWorkQueue(NULL);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopPerformIoTimerIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads from an I/O timer. Reads return the 64-bit number of
+    expirations since the last read.
+
+Arguments:
+
+    Handle - Supplies a pointer to the I/O timer handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    ULONGLONG Expirations;
+    PFILE_OBJECT FileObject;
+    PIO_TIMER IoTimer;
+    ULONG ReturnedEvents;
+    KSTATUS Status;
+    ULONGLONG TimeCounterFrequency;
+    ULONG TimeoutInMilliseconds;
+
+    FileObject = Handle->FileObject;
+
+    ASSERT(IoContext->IoBuffer != NULL);
+    ASSERT(FileObject->Properties.Type == IoObjectTimer);
+
+    IoTimer = FileObject->SpecialIo;
+    IoContext->BytesCompleted = 0;
+    if (IoContext->Write != FALSE) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (IoContext->SizeInBytes < sizeof(ULONGLONG)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // Wait for the timer to expire. Another reader can take the expirations
+    // between the wake and the lock, so each wait only gets the time
+    // remaining until the original deadline.
+    //
+
+    TimeoutInMilliseconds = IoContext->TimeoutInMilliseconds;
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    while (TRUE) {
+        KeAcquireQueuedLock(IoTimer->Lock);
+        Expirations = RtlAtomicExchange32(&(IoTimer->ExpirationCount), 0);
+        if (Expirations != 0) {
+            break;
+        }
+
+        //
+        // The work item sets the in event under the lock only if there are
+        // expirations, so clearing it here cannot lose a wake up.
+        //
+
+        IoSetIoObjectState(IoTimer->IoState, POLL_EVENT_IN, FALSE);
+        KeReleaseQueuedLock(IoTimer->Lock);
+        if (TimeoutInMilliseconds == 0) {
+            if (EndTime != 0) {
+                return STATUS_TIMEOUT;
+            }
+
+            return STATUS_TRY_AGAIN;
+        }
+
+        Status = IoWaitForIoObjectState(IoTimer->IoState,
+                                        POLL_EVENT_IN,
+                                        TRUE,
+                                        TimeoutInMilliseconds,
+                                        &ReturnedEvents);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        if (EndTime != 0) {
+            CurrentTime = KeGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                TimeoutInMilliseconds = 0;
+
+            } else {
+                TimeoutInMilliseconds = ((EndTime - CurrentTime) *
+                                         MILLISECONDS_PER_SECOND) /
+                                        TimeCounterFrequency;
+            }
+        }
+    }
+
+    Status = MmCopyIoBufferData(IoContext->IoBuffer,
+                                &Expirations,
+                                0,
+                                sizeof(ULONGLONG),
+                                TRUE);
+
+    //
+    // Put the expirations back if they could not be handed to the caller.
+    //
+
+    if (!KSUCCESS(Status)) {
+        RtlAtomicAdd32(&(IoTimer->ExpirationCount), (ULONG)Expirations);
+
+    } else {
+        IoContext->BytesCompleted = sizeof(ULONGLONG);
+        if (IoTimer->ExpirationCount == 0) {
+            IoSetIoObjectState(IoTimer->IoState, POLL_EVENT_IN, FALSE);
+        }
+    }
+
+    KeReleaseQueuedLock(IoTimer->Lock);
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopDestroyIoTimer (
+    PVOID Object
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys an I/O timer object.
+
+Arguments:
+
+    Object - Supplies a pointer to the I/O timer object being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PIO_TIMER IoTimer;
+
+    IoTimer = Object;
+
+    ASSERT(IoTimer->HandleCount == 0);
+    ASSERT((IoTimer->Timer == NULL) ||
+           (KeGetTimerDueTime(IoTimer->Timer) == 0));
+
+    if (IoTimer->Timer != NULL) {
+        KeDestroyTimer(IoTimer->Timer);
+    }
+
+    if (IoTimer->Dpc != NULL) {
+        KeDestroyDpc(IoTimer->Dpc);
+    }
+
+    if (IoTimer->WorkItem != NULL) {
+        KeDestroyWorkItem(IoTimer->WorkItem);
+    }
+
+    if (IoTimer->Lock != NULL) {
+        KeDestroyQueuedLock(IoTimer->Lock);
+    }
+
+    return;
+}
+
+VOID
+IopCancelIoTimer (
+    PIO_TIMER IoTimer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine cancels an I/O timer and waits for its DPC to finish. The
+    work item may still be queued when this routine returns. This routine
+    assumes the timer lock is held.
+
+Arguments:
+
+    IoTimer - Supplies a pointer to the I/O timer to cancel.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(KeIsQueuedLockHeld(IoTimer->Lock) != FALSE);
+
+    //
+    // After the timer's cancelled, the DPC is queued or it isn't going to be.
+    // Cancelling or flushing the DPC means the work item is queued or it
+    // isn't going to be.
+    //
+
+    KeCancelTimer(IoTimer->Timer);
+    if (!KSUCCESS(KeCancelDpc(IoTimer->Dpc))) {
+        KeFlushDpc(IoTimer->Dpc);
+    }
+
+    return;
+}
+
+VOID
+IopIoTimerDpcRoutine (
+    PDPC Dpc
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the DPC routine that fires when an I/O timer
+    expires. It counts the expiration and queues the work item to signal the
+    I/O object state.
+
+Arguments:
+
+    Dpc - Supplies a pointer to the DPC that is running.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PIO_TIMER IoTimer;
+
+    //
+    // Only the first expiration since the count was last consumed needs to
+    // queue the work item. If a stale work item is still queued, it will
+    // pick this expiration up when it runs.
+    //
+
+    IoTimer = (PIO_TIMER)(Dpc->UserData);
+    if (RtlAtomicAdd32(&(IoTimer->ExpirationCount), 1) == 0) {
+        KeQueueWorkItem(IoTimer->WorkItem);
+    }
+
+    return;
+}
+
+VOID
+IopIoTimerWorkRoutine (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the I/O timer expiration work routine. It sets the
+    in event on the timer's I/O object state, which must be done at low level.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the I/O timer.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PIO_TIMER IoTimer;
+
+    IoTimer = (PIO_TIMER)Parameter;
+    KeAcquireQueuedLock(IoTimer->Lock);
+    if (IoTimer->ExpirationCount != 0) {
+        IoSetIoObjectState(IoTimer->IoState, POLL_EVENT_IN, TRUE);
+    }
+
+    KeReleaseQueuedLock(IoTimer->Lock);
+    return;
+}
+
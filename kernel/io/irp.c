@@ -1380,7 +1380,46 @@ IopSendIoIrp (
 
 Routine Description:
 
-    This routine sends an I/O IRP.
+    This routine sends an I/O IRP. Reads and writes to block devices pass
+    through the device's request queue on the way.
+
+Arguments:
+
+    Device - Supplies a pointer to the device to send the IRP to.
+
+    MinorCodeNumber - Supplies the minor code number to send to the IRP.
+
+    Request - Supplies a pointer that on input contains the I/O request
+        parameters.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    if (IopIsBlockQueueRequest(Device, MinorCodeNumber, Request) != FALSE) {
+        return IopQueueBlockIo(Device, MinorCodeNumber, Request);
+    }
+
+    return IopDispatchIoIrp(Device, MinorCodeNumber, Request);
+}
+
+KSTATUS
+IopDispatchIoIrp (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCodeNumber,
+    PIRP_READ_WRITE Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends an I/O IRP straight to the device, bypassing any block
+    request queue.
 
 Arguments:
 
@@ -1409,7 +1448,7 @@ Return Value:
     IoIrp = IoCreateIrp(Device, IrpMajorIo, 0);
     if (IoIrp == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto SendIoIrpEnd;
+        goto DispatchIoIrpEnd;
     }
 
     Thread = KeGetCurrentThread();
@@ -1432,7 +1471,7 @@ Return Value:
     IoIrp->U.ReadWrite.IoBufferState.IoBuffer = NULL;
     Status = IoSendSynchronousIrp(IoIrp);
     if (!KSUCCESS(Status)) {
-        goto SendIoIrpEnd;
+        goto DispatchIoIrpEnd;
     }
 
     ASSERT(IoIrp->U.ReadWrite.IoBufferState.IoBuffer == NULL);
@@ -1461,7 +1500,7 @@ Return Value:
 
     Status = IoGetIrpStatus(IoIrp);
 
-SendIoIrpEnd:
+DispatchIoIrpEnd:
     if (IoIrp != NULL) {
         IoDestroyIrp(IoIrp);
     }
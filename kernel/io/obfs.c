@@ -88,6 +88,7 @@ Return Value:
     POBJECT_HEADER Child;
     PFILE_OBJECT ChildFileObject;
     PATH_POINT ChildPathPoint;
+    PFILE_PROPERTIES ChildProperties;
     PLIST_ENTRY CurrentEntry;
     DIRECTORY_ENTRY DirectoryEntry;
     ULONG EntrySize;
@@ -105,6 +106,8 @@ Return Value:
     PATH_POINT ParentPathPoint;
     PVOID PreviousChild;
     PKPROCESS Process;
+    PFILE_PROPERTIES Properties;
+    FILE_PROPERTIES PropertiesBuffer;
     PPATH_POINT Root;
     KSTATUS Status;
 
@@ -127,6 +130,10 @@ Return Value:
     FileObject = IoHandle->FileObject;
     NameBuffer = NULL;
     Object = (POBJECT_HEADER)(UINTN)(FileObject->Properties.FileId);
+    Properties = NULL;
+    if ((IoContext->Flags & IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+        Properties = &PropertiesBuffer;
+    }
 
     ASSERT(FileObject->Properties.Type == IoObjectObjectDirectory);
     ASSERT(FileObject->Properties.DeviceId == OBJECT_MANAGER_DEVICE_ID);
@@ -145,6 +152,9 @@ Return Value:
             Name = ".";
             NameSize = sizeof(".");
             FileId = FileObject->Properties.FileId;
+            if (Properties != NULL) {
+                IopGetFileObjectProperties(FileObject, Properties);
+            }
 
         } else {
             Name = "..";
@@ -168,33 +178,34 @@ Return Value:
 
             ParentFileObject = ParentPathPoint.PathEntry->FileObject;
             FileId = ParentFileObject->Properties.FileId;
+            if (Properties != NULL) {
+                IopGetFileObjectProperties(ParentFileObject, Properties);
+            }
+
             IO_PATH_POINT_RELEASE_REFERENCE(&ParentPathPoint);
         }
 
-        EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + NameSize, 8);
+        if (Properties != NULL) {
+            EntrySize = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(NameSize);
+
+        } else {
+            EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + NameSize, 8);
+        }
+
         if (BytesRead + EntrySize > IoContext->SizeInBytes) {
             Status = STATUS_MORE_PROCESSING_REQUIRED;
             goto PerformObjectIoOperationEnd;
         }
 
         DirectoryEntry.Type = IoObjectRegularDirectory;
-        DirectoryEntry.Size = EntrySize;
         DirectoryEntry.FileId = FileId;
-        Status = MmCopyIoBufferData(IoContext->IoBuffer,
-                                    &DirectoryEntry,
-                                    BytesRead,
-                                    sizeof(DIRECTORY_ENTRY),
-                                    TRUE);
-
-        if (!KSUCCESS(Status)) {
-            goto PerformObjectIoOperationEnd;
-        }
-
-        Status = MmCopyIoBufferData(IoContext->IoBuffer,
-                                    Name,
-                                    BytesRead + sizeof(DIRECTORY_ENTRY),
-                                    NameSize,
-                                    TRUE);
+        DirectoryEntry.NextOffset = Index + 1;
+        Status = IopWriteDirectoryEntry(IoContext->IoBuffer,
+                                        BytesRead,
+                                        &DirectoryEntry,
+                                        Name,
+                                        NameSize,
+                                        Properties);
 
         if (!KSUCCESS(Status)) {
             goto PerformObjectIoOperationEnd;
@@ -314,6 +325,7 @@ Return Value:
         //
 
         FileId = (FILE_ID)(UINTN)Child;
+        ChildProperties = NULL;
         Status = IopPathLookup(TRUE,
                                NULL,
                                &(IoHandle->PathPoint),
@@ -329,6 +341,10 @@ Return Value:
         if (KSUCCESS(Status)) {
             ChildFileObject = ChildPathPoint.PathEntry->FileObject;
             FileId = ChildFileObject->Properties.FileId;
+            if (Properties != NULL) {
+                IopGetFileObjectProperties(ChildFileObject, Properties);
+                ChildProperties = Properties;
+            }
         }
 
         if (ChildPathPoint.PathEntry != NULL) {
@@ -362,30 +378,28 @@ Return Value:
 
         } else {
             NameSize = NeededSize;
-            EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + NameSize, 8);
+            if (ChildProperties != NULL) {
+                EntrySize = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(NameSize);
+
+            } else {
+                EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + NameSize,
+                                           8);
+            }
+
             if (BytesRead + EntrySize > IoContext->SizeInBytes) {
                 Status = STATUS_MORE_PROCESSING_REQUIRED;
                 goto PerformObjectIoOperationEnd;
             }
 
-            DirectoryEntry.Size = EntrySize;
             DirectoryEntry.FileId = FileId;
+            DirectoryEntry.NextOffset = Index + 1;
             DirectoryEntry.Type = IoObjectRegularDirectory;
-            Status = MmCopyIoBufferData(IoContext->IoBuffer,
-                                        &DirectoryEntry,
-                                        BytesRead,
-                                        sizeof(DIRECTORY_ENTRY),
-                                        TRUE);
-
-            if (!KSUCCESS(Status)) {
-                goto PerformObjectIoOperationEnd;
-            }
-
-            Status = MmCopyIoBufferData(IoContext->IoBuffer,
-                                        NameBuffer,
-                                        BytesRead + sizeof(DIRECTORY_ENTRY),
-                                        NameSize,
-                                        TRUE);
+            Status = IopWriteDirectoryEntry(IoContext->IoBuffer,
+                                            BytesRead,
+                                            &DirectoryEntry,
+                                            NameBuffer,
+                                            NameSize,
+                                            ChildProperties);
 
             if (!KSUCCESS(Status)) {
                 goto PerformObjectIoOperationEnd;
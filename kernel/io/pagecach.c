@@ -104,6 +104,14 @@ Module Name:
 
 #define PAGE_CACHE_ENTRY_FLAG_MAPPED 0x00000008
 
+//
+// Set this flag if the page cache entry is published in its file object's
+// page cache index. Lockless lookups check this after taking a reference to
+// make sure the entry was not removed out from under them.
+//
+
+#define PAGE_CACHE_ENTRY_FLAG_INDEXED 0x00000010
+
 //
 // If any of the dirty mask bits are set, then the page cache entry needs to
 // be cleaned and flushed.
@@ -172,10 +180,24 @@ Module Name:
 
 #define PAGE_CACHE_CLEAN_DELAY_MIN (5000 * MICROSECONDS_PER_MILLISECOND)
 
+//
+// Define the number of LRU updates each processor collects before taking the
+// clean list lock to apply them all at once.
+//
+
+#define PAGE_CACHE_LIST_BATCH_SIZE 14
+
 //
 // --------------------------------------------------------------------- Macros
 //
 
+//
+// This macro returns the bit representing the lock for the given list type in
+// a mask of page cache list locks.
+//
+
+#define PAGE_CACHE_LIST_LOCK(_ListType) (1 << (_ListType))
+
 #define IS_IO_OBJECT_TYPE_LINKABLE(_IoObjectType)     \
     ((_IoObjectType == IoObjectRegularFile) ||        \
      (_IoObjectType == IoObjectSymbolicLink) ||       \
@@ -192,6 +214,20 @@ typedef enum _PAGE_CACHE_STATE {
     PageCacheStateDirty,
 } PAGE_CACHE_STATE, *PPAGE_CACHE_STATE;
 
+//
+// Each type of page cache list has its own lock, which protects every list of
+// that type (including the local lists that the flush and trim routines pull
+// entries onto). When more than one of these locks is needed, they must be
+// acquired in the order they are listed here.
+//
+
+typedef enum _PAGE_CACHE_LIST_TYPE {
+    PageCacheListDirty,
+    PageCacheListClean,
+    PageCacheListRemoval,
+    PageCacheListTypeCount
+} PAGE_CACHE_LIST_TYPE, *PPAGE_CACHE_LIST_TYPE;
+
 /*++
 
 Structure Description:
@@ -200,12 +236,9 @@ Structure Description:
 
 Members:
 
-    Node - Stores the Red-Black tree node information for this page cache
-        entry.
-
     ListEntry - Stores this page cache entry's list entry in an LRU list, local
-        list, or dirty list. This list entry is protected by the global page
-        cache list lock.
+        list, or dirty list. This list entry is protected by the lock for the
+        entry's list type.
 
     FileObject - Stores a pointer to the file object for the device or file to
         which the page cache entry belongs.
@@ -226,10 +259,14 @@ Structure Description:
     Flags - Stores a bitmask of page cache entry flags. See
         PAGE_CACHE_ENTRY_FLAG_* for definitions.
 
+    ListType - Stores the type of list the entry was last put on, which
+        determines the lock that protects the list entry, even once it has
+        been pulled off the list. This can only be changed with both the old
+        and the new list type's locks held. See PAGE_CACHE_LIST_TYPE.
+
 --*/
 
 struct _PAGE_CACHE_ENTRY {
-    RED_BLACK_TREE_NODE Node;
     LIST_ENTRY ListEntry;
     PFILE_OBJECT FileObject;
     IO_OFFSET Offset;
@@ -238,8 +275,35 @@ struct _PAGE_CACHE_ENTRY {
     PPAGE_CACHE_ENTRY BackingEntry;
     volatile ULONG ReferenceCount;
     volatile ULONG Flags;
+    volatile ULONG ListType;
 };
 
+/*++
+
+Structure Description:
+
+    This structure defines a processor's batch of page cache entries waiting
+    to be moved to the back of the clean LRU list. Each entry in the batch
+    holds a reference.
+
+Members:
+
+    Lock - Stores a spin lock that protects the batch. This is almost always
+        only acquired by the owning processor, but allows other processors to
+        drain the batch.
+
+    Count - Stores the number of valid elements in the entries array.
+
+    Entries - Stores the batched page cache entries.
+
+--*/
+
+typedef struct _PAGE_CACHE_LIST_BATCH {
+    KSPIN_LOCK Lock;
+    ULONG Count;
+    PPAGE_CACHE_ENTRY Entries[PAGE_CACHE_LIST_BATCH_SIZE];
+} PAGE_CACHE_LIST_BATCH, *PPAGE_CACHE_LIST_BATCH;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -262,7 +326,7 @@ IopDestroyPageCacheEntry (
     PPAGE_CACHE_ENTRY Entry
     );
 
-VOID
+KSTATUS
 IopInsertPageCacheEntry (
     PPAGE_CACHE_ENTRY NewEntry,
     PPAGE_CACHE_ENTRY LinkEntry
@@ -294,6 +358,7 @@ IopTrimRemovalPageCacheList (
 VOID
 IopRemovePageCacheEntriesFromList (
     PLIST_ENTRY PageCacheListHead,
+    PAGE_CACHE_LIST_TYPE ListType,
     PLIST_ENTRY DestroyListHead,
     BOOL TimidEffort,
     PUINTN TargetRemoveCount
@@ -324,16 +389,62 @@ IopRemovePageCacheEntryVirtualAddress (
     );
 
 VOID
-IopRemovePageCacheEntryFromTree (
+IopRemovePageCacheEntryFromIndex (
     PPAGE_CACHE_ENTRY Entry
     );
 
+VOID
+IopSetPageCacheEntryTag (
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    );
+
+VOID
+IopClearPageCacheEntryTag (
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    );
+
 VOID
 IopUpdatePageCacheEntryList (
     PPAGE_CACHE_ENTRY PageCacheEntry,
     BOOL Created
     );
 
+VOID
+IopApplyPageCacheListBatch (
+    PPAGE_CACHE_ENTRY *Entries,
+    ULONG Count
+    );
+
+VOID
+IopDrainPageCacheListBatches (
+    VOID
+    );
+
+ULONG
+IopLockPageCacheEntryList (
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG LockMask
+    );
+
+VOID
+IopAcquirePageCacheListLocks (
+    ULONG LockMask
+    );
+
+VOID
+IopReleasePageCacheListLocks (
+    ULONG LockMask
+    );
+
+VOID
+IopMovePageCacheEntryToList (
+    PPAGE_CACHE_ENTRY Entry,
+    PLIST_ENTRY ListHead,
+    PAGE_CACHE_LIST_TYPE ListType
+    );
+
 BOOL
 IopIsPageCacheTooBig (
     PUINTN FreePhysicalPages
@@ -356,7 +467,7 @@ IopCheckFileObjectPageCache (
 //
 // Stores the list head for the page cache entries that are ordered from least
 // to most recently used. This will mostly contain clean entries, but could
-// have a few dirty entries on it.
+// have a few dirty entries on it. It is protected by the clean list lock.
 //
 
 LIST_ENTRY IoPageCacheCleanList;
@@ -365,7 +476,8 @@ LIST_ENTRY IoPageCacheCleanList;
 // Stores the list head for page cache entries that are clean but not mapped.
 // The unmap loop moves entries from the clean list to here to avoid iterating
 // over them too many times. These entries are considered even less used than
-// the clean list.
+// the clean list. Entries move between this and the clean list in bulk, so it
+// shares the clean list lock.
 //
 
 LIST_ENTRY IoPageCacheCleanUnmappedList;
@@ -373,16 +485,25 @@ LIST_ENTRY IoPageCacheCleanUnmappedList;
 //
 // Stores the list head for the list of page cache entries that are ready to be
 // removed from the cache. Usually these are evicted page cache entries that
-// still have a reference.
+// still have a reference. It is protected by the removal list lock.
 //
 
 LIST_ENTRY IoPageCacheRemovalList;
 
 //
-// Stores a lock to protect access to the lists of page cache entries.
+// Stores the locks that protect the lists of page cache entries, indexed by
+// list type. The file object dirty page lists are all protected by the dirty
+// list lock.
+//
+
+PQUEUED_LOCK IoPageCacheListLocks[PageCacheListTypeCount];
+
+//
+// Stores the array of per-processor LRU update batches and its size.
 //
 
-PQUEUED_LOCK IoPageCacheListLock;
+PPAGE_CACHE_LIST_BATCH IoPageCacheListBatches;
+ULONG IoPageCacheListBatchCount;
 
 //
 // Store the target number of free pages in the system the page cache shoots
@@ -422,8 +543,8 @@ UINTN IoPageCacheLowMemoryCleanPageMinimum = 0;
 
 //
 // The physical page count tracks the current number of physical pages in use
-// by the cache. This includes pages that are active in the tree and pages that
-// are not in the tree, awaiting destruction.
+// by the cache. This includes pages that are active in the index and pages
+// that are not in the index, awaiting destruction.
 //
 
 volatile UINTN IoPageCachePhysicalPageCount = 0;
@@ -434,6 +555,14 @@ volatile UINTN IoPageCachePhysicalPageCount = 0;
 
 volatile UINTN IoPageCacheDirtyPageCount = 0;
 
+//
+// Stores the number of dirty pages that belong to file objects without backing
+// store. These are included in the dirty page count, but there is nowhere to
+// clean them to, so they do not count against the dirty limits.
+//
+
+volatile UINTN IoPageCacheMemoryOnlyPageCount = 0;
+
 //
 // Stores the number of pages in the cache that are marked pending dirty. This
 // value may become negative but it's only used for debugging. It should be 0
@@ -660,6 +789,7 @@ Return Value:
 
 {
 
+    ULONG LockMask;
     ULONG OldReferenceCount;
 
     OldReferenceCount = RtlAtomicAdd32(&(Entry->ReferenceCount), -1);
@@ -675,7 +805,9 @@ Return Value:
         (Entry->ListEntry.Next == NULL) &&
         ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0)) {
 
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        LockMask = IopLockPageCacheEntryList(
+                                   Entry,
+                                   PAGE_CACHE_LIST_LOCK(PageCacheListClean));
 
         //
         // Double check to make sure it's not on a list or dirty now.
@@ -684,10 +816,12 @@ Return Value:
         if ((Entry->ListEntry.Next == NULL) &&
             ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0)) {
 
-            INSERT_BEFORE(&(Entry->ListEntry), &IoPageCacheCleanList);
+            IopMovePageCacheEntryToList(Entry,
+                                        &IoPageCacheCleanList,
+                                        PageCacheListClean);
         }
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(LockMask);
     }
 
     return;
@@ -899,6 +1033,7 @@ Return Value:
 {
 
     PPAGE_CACHE_ENTRY DirtyEntry;
+    ULONG LockMask;
     BOOL MarkDirty;
     ULONG OldFlags;
 
@@ -943,21 +1078,23 @@ Return Value:
         //
 
         MarkDirty = FALSE;
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        LockMask = IopLockPageCacheEntryList(
+                                   DirtyEntry,
+                                   PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
+
         if (((DirtyEntry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_PENDING) != 0) &&
             ((DirtyEntry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY) == 0)) {
 
-            if (DirtyEntry->ListEntry.Next != NULL) {
-                LIST_REMOVE(&(DirtyEntry->ListEntry));
-            }
-
-            INSERT_BEFORE(&(DirtyEntry->ListEntry),
-                          &(DirtyEntry->FileObject->DirtyPageList));
+            IopMovePageCacheEntryToList(
+                                    DirtyEntry,
+                                    &(DirtyEntry->FileObject->DirtyPageList),
+                                    PageCacheListDirty);
 
+            IopSetPageCacheEntryTag(DirtyEntry, PAGE_CACHE_TAG_DIRTY);
             MarkDirty = TRUE;
         }
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(LockMask);
 
         //
         // Marking the file object dirty is only useful if this routine put the
@@ -995,10 +1132,14 @@ Return Value:
 
 {
 
+    UINTN AllocationSize;
+    ULONG BatchIndex;
     PBLOCK_ALLOCATOR BlockAllocator;
     ULONGLONG CurrentTime;
+    ULONG ListType;
     ULONG PageShift;
     UINTN PhysicalPages;
+    ULONG ProcessorCount;
     KSTATUS Status;
     UINTN TotalPhysicalPages;
     UINTN TotalVirtualMemory;
@@ -1006,12 +1147,35 @@ Return Value:
     INITIALIZE_LIST_HEAD(&IoPageCacheCleanList);
     INITIALIZE_LIST_HEAD(&IoPageCacheCleanUnmappedList);
     INITIALIZE_LIST_HEAD(&IoPageCacheRemovalList);
-    IoPageCacheListLock = KeCreateQueuedLock();
-    if (IoPageCacheListLock == NULL) {
+    for (ListType = 0; ListType < PageCacheListTypeCount; ListType += 1) {
+        IoPageCacheListLocks[ListType] = KeCreateQueuedLock();
+        if (IoPageCacheListLocks[ListType] == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializePageCacheEnd;
+        }
+    }
+
+    //
+    // Create a batch of pending LRU updates for each processor.
+    //
+
+    ProcessorCount = KeGetActiveProcessorCount();
+    AllocationSize = ProcessorCount * sizeof(PAGE_CACHE_LIST_BATCH);
+    IoPageCacheListBatches = MmAllocateNonPagedPool(AllocationSize,
+                                                    PAGE_CACHE_ALLOCATION_TAG);
+
+    if (IoPageCacheListBatches == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto InitializePageCacheEnd;
     }
 
+    RtlZeroMemory(IoPageCacheListBatches, AllocationSize);
+    for (BatchIndex = 0; BatchIndex < ProcessorCount; BatchIndex += 1) {
+        KeInitializeSpinLock(&(IoPageCacheListBatches[BatchIndex].Lock));
+    }
+
+    IoPageCacheListBatchCount = ProcessorCount;
+
     //
     // Create a timer to schedule the page cache worker.
     //
@@ -1023,13 +1187,15 @@ Return Value:
     }
 
     //
-    // Create the block allocator for the page cache entry structures.
+    // Create the block allocator for the page cache entry structures. Lockless
+    // lookups inspect entries at dispatch level, so they must be non-paged.
     //
 
     BlockAllocator = MmCreateBlockAllocator(
                                     sizeof(PAGE_CACHE_ENTRY),
                                     0,
                                     PAGE_CACHE_BLOCK_ALLOCATOR_EXPANSION_COUNT,
+                                    BLOCK_ALLOCATOR_FLAG_NON_PAGED |
                                     BLOCK_ALLOCATOR_FLAG_TRIM,
                                     PAGE_CACHE_ALLOCATION_TAG);
 
@@ -1039,6 +1205,10 @@ Return Value:
     }
 
     IoPageCacheBlockAllocator = BlockAllocator;
+    Status = IopInitializePageCacheIndexing();
+    if (!KSUCCESS(Status)) {
+        goto InitializePageCacheEnd;
+    }
 
     //
     // Determine an appropriate limit on the size of the page cache based on
@@ -1155,9 +1325,17 @@ Return Value:
 
 InitializePageCacheEnd:
     if (!KSUCCESS(Status)) {
-        if (IoPageCacheListLock != NULL) {
-            KeDestroyQueuedLock(IoPageCacheListLock);
-            IoPageCacheListLock = NULL;
+        for (ListType = 0; ListType < PageCacheListTypeCount; ListType += 1) {
+            if (IoPageCacheListLocks[ListType] != NULL) {
+                KeDestroyQueuedLock(IoPageCacheListLocks[ListType]);
+                IoPageCacheListLocks[ListType] = NULL;
+            }
+        }
+
+        if (IoPageCacheListBatches != NULL) {
+            MmFreeNonPagedPool(IoPageCacheListBatches);
+            IoPageCacheListBatches = NULL;
+            IoPageCacheListBatchCount = 0;
         }
 
         if (IoPageCacheWorkTimer != NULL) {
@@ -1235,6 +1413,94 @@ Return Value:
     return FoundEntry;
 }
 
+ULONG
+IopLookupPageCacheEntriesLockless (
+    PFILE_OBJECT FileObject,
+    IO_OFFSET Offset,
+    PPAGE_CACHE_ENTRY *Entries,
+    ULONG EntryCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks up a run of consecutive page cache entries without
+    acquiring the file object lock. The run stops at the first page that is
+    not in the cache. A reference is taken on each entry returned. The caller
+    is responsible for making sure the data it reads from the entries is
+    consistent, usually by checking the page cache index sequence number.
+
+Arguments:
+
+    FileObject - Supplies a pointer to a file object for the device or file.
+
+    Offset - Supplies the page-aligned offset of the first entry to look up.
+
+    Entries - Supplies an array where the referenced entries are returned.
+
+    EntryCount - Supplies the maximum number of entries to look up.
+
+Return Value:
+
+    Returns the number of consecutive entries found, starting at the given
+    offset.
+
+--*/
+
+{
+
+    PPAGE_CACHE_ENTRY Entry;
+    ULONG Found;
+    ULONG Index;
+    ULONG LookupCount;
+    RUNLEVEL OldRunLevel;
+    ULONG PageShift;
+
+    ASSERT(IS_ALIGNED(Offset, MmPageSize()) != FALSE);
+
+    PageShift = MmPageShift();
+    Found = 0;
+    OldRunLevel = IopBeginLocklessPageCacheLookup();
+    LookupCount = IopGangLookupPageCacheIndex(FileObject->PageCacheIndex,
+                                              Offset >> PageShift,
+                                              PAGE_CACHE_TAG_NONE,
+                                              Entries,
+                                              EntryCount);
+
+    for (Index = 0; Index < LookupCount; Index += 1) {
+        Entry = Entries[Index];
+        if (Entry->Offset != Offset + ((IO_OFFSET)Index << PageShift)) {
+            break;
+        }
+
+        //
+        // Take the reference and only then check that the entry is still in
+        // the index. Removal clears the flag before checking the reference
+        // count, so either this routine sees the removal or the remover sees
+        // the reference. The entry cannot be freed until this lookup section
+        // ends, so a raw decrement is safe if the entry has been removed.
+        //
+
+        RtlAtomicAdd32(&(Entry->ReferenceCount), 1);
+        if (((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0) ||
+            (Entry->FileObject != FileObject)) {
+
+            RtlAtomicAdd32(&(Entry->ReferenceCount), -1);
+            break;
+        }
+
+        Found += 1;
+    }
+
+    IopEndLocklessPageCacheLookup(OldRunLevel);
+    for (Index = 0; Index < Found; Index += 1) {
+        IopUpdatePageCacheEntryList(Entries[Index], FALSE);
+    }
+
+    return Found;
+}
+
 PPAGE_CACHE_ENTRY
 IopCreateOrLookupPageCacheEntry (
     PFILE_OBJECT FileObject,
@@ -1283,6 +1549,7 @@ Return Value:
 
     BOOL Created;
     PPAGE_CACHE_ENTRY NewEntry;
+    KSTATUS Status;
 
     ASSERT(KeIsSharedExclusiveLockHeldExclusive(FileObject->Lock));
     ASSERT((LinkEntry == NULL) ||
@@ -1311,7 +1578,14 @@ Return Value:
         // sneak into the cache. Insert this new entry.
         //
 
-        IopInsertPageCacheEntry(NewEntry, LinkEntry);
+        Status = IopInsertPageCacheEntry(NewEntry, LinkEntry);
+        if (!KSUCCESS(Status)) {
+            NewEntry->ReferenceCount = 0;
+            IopDestroyPageCacheEntry(NewEntry);
+            NewEntry = NULL;
+            goto CreateOrLookupPageCacheEntryEnd;
+        }
+
         Created = TRUE;
     }
 
@@ -1397,6 +1671,7 @@ Return Value:
 {
 
     PPAGE_CACHE_ENTRY NewEntry;
+    KSTATUS Status;
 
     ASSERT(KeIsSharedExclusiveLockHeldExclusive(FileObject->Lock) != FALSE);
     ASSERT((LinkEntry == NULL) ||
@@ -1421,7 +1696,13 @@ Return Value:
 
     ASSERT(IopLookupPageCacheEntryHelper(FileObject, Offset) == NULL);
 
-    IopInsertPageCacheEntry(NewEntry, LinkEntry);
+    Status = IopInsertPageCacheEntry(NewEntry, LinkEntry);
+    if (!KSUCCESS(Status)) {
+        NewEntry->ReferenceCount = 0;
+        IopDestroyPageCacheEntry(NewEntry);
+        NewEntry = NULL;
+        goto CreateAndInsertPageCacheEntryEnd;
+    }
 
     //
     // Add the newly created page cach entry to the appropriate list.
@@ -1686,14 +1967,16 @@ Return Value:
     PIO_BUFFER FlushBuffer;
     IO_OFFSET FlushNextOffset;
     UINTN FlushSize;
-    BOOL GetNextNode;
+    PPAGE_CACHE_INDEX Index;
     LIST_ENTRY LocalList;
-    PRED_BLACK_TREE_NODE Node;
+    ULONGLONG NextPageIndex;
     BOOL PageCacheThread;
     UINTN PagesFlushed;
     ULONG PageShift;
     ULONG PageSize;
-    PAGE_CACHE_ENTRY SearchEntry;
+    BOOL Plugged;
+    BOOL Searching;
+    ULONG SearchTag;
     BOOL SkipEntry;
     KSTATUS Status;
     KSTATUS TotalStatus;
@@ -1704,6 +1987,7 @@ Return Value:
     CacheEntry = NULL;
     FlushBuffer = NULL;
     PagesFlushed = 0;
+    Plugged = FALSE;
     PageShift = MmPageShift();
     Status = STATUS_SUCCESS;
     TotalStatus = STATUS_SUCCESS;
@@ -1773,30 +2057,42 @@ Return Value:
 
     PageSize = MmPageSize();
 
+    //
+    // Writing back more than a page of a block device can take several
+    // requests. Plug the device's queue so that these writes and those of
+    // other threads are held long enough to be merged and sorted as a batch.
+    //
+
+    if ((FileObject->Properties.Type == IoObjectBlockDevice) &&
+        ((Size == -1ULL) || (Size > PageSize))) {
+
+        if (KSUCCESS(IoPlugBlockDevice(FileObject->Device))) {
+            Plugged = TRUE;
+        }
+    }
+
+    Index = FileObject->PageCacheIndex;
+
     //
     // Determine which page cache entry the flush should start on.
     //
 
-    SearchEntry.FileObject = FileObject;
     FlushNextOffset = Offset;
     FlushSize = 0;
     CleanStreak = 0;
-    SearchEntry.Offset = Offset;
-    SearchEntry.Flags = 0;
-    Node = NULL;
+    NextPageIndex = Offset >> PageShift;
+    Searching = FALSE;
 
     //
     // Loop over page cache entries. For non-synchronized flush-all operations,
     // iteration grabs the first entry in the dirty list, then iterates using
-    // the tree to maximize contiguous runs. Starting from the list avoids
-    // chewing up CPU time scanning through the tree. For explicit flush
-    // operations of a specific region, iterate using only the tree.
+    // the index to maximize contiguous runs. Starting from the list avoids
+    // chewing up CPU time scanning through the index. For explicit flush
+    // operations of a specific region, iterate using only the index.
     //
 
     if (UseDirtyPageList == FALSE) {
-        Node = RtlRedBlackTreeSearchClosest(&(FileObject->PageCacheTree),
-                                            &(SearchEntry.Node),
-                                            TRUE);
+        Searching = TRUE;
 
     //
     // Move all dirty entries over to a local list to avoid processing them
@@ -1804,80 +2100,95 @@ Return Value:
     //
 
     } else {
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        IopAcquirePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
         if (!LIST_EMPTY(&(FileObject->DirtyPageList))) {
             MOVE_LIST(&(FileObject->DirtyPageList), &LocalList);
             INITIALIZE_LIST_HEAD(&(FileObject->DirtyPageList));
         }
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
     }
 
-    //
-    // Either the first node was selected, or the node will be taken from the
-    // list. Don't move to the next node.
-    //
-
-    GetNextNode = FALSE;
     while (TRUE) {
 
         //
-        // Get the next greatest node in the tree if necessary.
+        // Search the index for the next entry if iterating. Clean entries
+        // only matter if they might extend the current run, or if this is a
+        // synchronized flush that needs to look at backing entries and writes
+        // in flight. Otherwise use the dirty tag to skip over clean regions.
         //
 
-        if ((Node != NULL) && (GetNextNode != FALSE)) {
-            Node = RtlRedBlackTreeGetNextNode(&(FileObject->PageCacheTree),
-                                              FALSE,
-                                              Node);
+        CacheEntry = NULL;
+        if (Searching != FALSE) {
+            SearchTag = PAGE_CACHE_TAG_DIRTY;
+            if (((Flags & IO_FLAG_DATA_SYNCHRONIZED) != 0) ||
+                ((FlushSize != 0) &&
+                 (CleanStreak < PAGE_CACHE_FLUSH_MAX_CLEAN_STREAK) &&
+                 (NextPageIndex == (FlushNextOffset >> PageShift)))) {
+
+                SearchTag = PAGE_CACHE_TAG_NONE;
+            }
+
+            CacheEntry = IopFindNextPageCacheIndexEntry(Index,
+                                                        &NextPageIndex,
+                                                        SearchTag);
+
+            if (CacheEntry == NULL) {
+                Searching = FALSE;
+            }
         }
 
-        if ((Node == NULL) && (UseDirtyPageList != FALSE)) {
-            KeAcquireQueuedLock(IoPageCacheListLock);
+        if ((CacheEntry == NULL) && (UseDirtyPageList != FALSE)) {
+            IopAcquirePageCacheListLocks(
+                                   PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
+
             while (!LIST_EMPTY(&LocalList)) {
                 CacheEntry = LIST_VALUE(LocalList.Next,
                                         PAGE_CACHE_ENTRY,
                                         ListEntry);
 
-                Node = &(CacheEntry->Node);
-
                 //
-                // The node might have been pulled from the tree while the file
-                // object lock was dropped, but that routine didn't yet get
-                // far enough to pull it off the list. Do it for them.
+                // The entry might have been pulled from the index while the
+                // file object lock was dropped, but that routine didn't yet
+                // get far enough to pull it off the list. Do it for them.
                 //
 
-                if (Node->Parent == NULL) {
+                if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0) {
                     LIST_REMOVE(&(CacheEntry->ListEntry));
                     CacheEntry->ListEntry.Next = NULL;
-                    Node = NULL;
+                    CacheEntry = NULL;
                     continue;
                 }
 
                 break;
             }
 
-            KeReleaseQueuedLock(IoPageCacheListLock);
+            IopReleasePageCacheListLocks(
+                                   PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
+
+            if (CacheEntry != NULL) {
+                Searching = TRUE;
+            }
         }
 
         //
         // Stop if there's nothing left.
         //
 
-        if (Node == NULL) {
+        if (CacheEntry == NULL) {
             break;
         }
 
-        CacheEntry = RED_BLACK_TREE_VALUE(Node, PAGE_CACHE_ENTRY, Node);
         if ((Size != -1ULL) && (CacheEntry->Offset >= (Offset + Size))) {
             break;
         }
 
         //
-        // Determine if the current entry can be skipped and plan to iterate to
-        // the next node on the next loop.
+        // Determine if the current entry can be skipped and plan to search
+        // beyond it on the next loop.
         //
 
-        GetNextNode = TRUE;
+        NextPageIndex = (CacheEntry->Offset >> PageShift) + 1;
         SkipEntry = FALSE;
         BackingEntry = CacheEntry->BackingEntry;
 
@@ -1891,16 +2202,24 @@ Return Value:
             SkipEntry = TRUE;
 
             //
-            // If this is a synchronized flush and the backing entry is dirty,
-            // then write it out.
+            // If this is a synchronized flush and the backing entry is dirty
+            // or another flush is still writing this page, then write it out.
             //
 
-            if (((Flags & IO_FLAG_DATA_SYNCHRONIZED) != 0) &&
-                (BackingEntry != NULL) &&
-                ((BackingEntry->Flags &
-                  PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) != 0)) {
+            if ((Flags & IO_FLAG_DATA_SYNCHRONIZED) != 0) {
+                if ((BackingEntry != NULL) &&
+                    ((BackingEntry->Flags &
+                      PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) != 0)) {
 
-                SkipEntry = FALSE;
+                    SkipEntry = FALSE;
+
+                } else if (IopGetPageCacheIndexTag(
+                                          Index,
+                                          CacheEntry->Offset >> PageShift,
+                                          PAGE_CACHE_TAG_WRITEBACK) != FALSE) {
+
+                    SkipEntry = FALSE;
+                }
             }
 
             //
@@ -1946,7 +2265,7 @@ Return Value:
 
         if (SkipEntry != FALSE) {
             if (UseDirtyPageList != FALSE) {
-                Node = NULL;
+                Searching = FALSE;
             }
 
             continue;
@@ -2029,10 +2348,13 @@ Return Value:
         //
         // If this cache entry has not been dealt with, add it to the buffer
         // now. As the flush routine may release the lock (for block devices),
-        // also check to make sure the cache entry is still in the tree.
+        // also check to make sure the cache entry is still in the index.
         //
 
-        if ((CacheEntry != NULL) && (CacheEntry->Node.Parent != NULL)) {
+        if ((CacheEntry != NULL) &&
+            ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0)) {
+
+
             MmIoBufferAppendPage(FlushBuffer,
                                  CacheEntry,
                                  NULL,
@@ -2042,36 +2364,17 @@ Return Value:
             FlushNextOffset = CacheEntry->Offset + PageSize;
 
         //
-        // Reset the iteration if the dirty list is valid.
+        // Reset the iteration if the dirty list is valid. Otherwise the
+        // search picks up after this entry, which works even if the entry was
+        // ripped out of the index while the lock was dropped.
         //
 
         } else if (UseDirtyPageList != FALSE) {
-            Node = NULL;
-
-        //
-        // If the node was ripped out of the tree while the lock was dropped
-        // during the flush, search for the next closest node. Make sure not to
-        // get the next node on the next loop, or else this one would be
-        // skipped.
-        //
-
-        } else if (Node->Parent == NULL) {
-            if (CacheEntry == NULL) {
-                CacheEntry = RED_BLACK_TREE_VALUE(Node, PAGE_CACHE_ENTRY, Node);
-            }
-
-            ASSERT(&(CacheEntry->Node) == Node);
-
-            Node = RtlRedBlackTreeSearchClosest(&(FileObject->PageCacheTree),
-                                                &(CacheEntry->Node),
-                                                TRUE);
-
-            GetNextNode = FALSE;
+            Searching = FALSE;
         }
 
         //
-        // Now that the next node has been found, release the reference taken
-        // on the next cache entry.
+        // Release the reference taken on the next cache entry.
         //
 
         if (CacheEntry != NULL) {
@@ -2117,6 +2420,9 @@ Return Value:
     Status = STATUS_SUCCESS;
 
 FlushPageCacheEntriesEnd:
+    if (Plugged != FALSE) {
+        IoUnplugBlockDevice(FileObject->Device);
+    }
 
     //
     // If there are still entries on the local list, put those back on the
@@ -2125,12 +2431,12 @@ Return Value:
     //
 
     if (!LIST_EMPTY(&LocalList)) {
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        IopAcquirePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
         if (!LIST_EMPTY(&LocalList)) {
             APPEND_LIST(&LocalList, &(FileObject->DirtyPageList));
         }
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
     }
 
     if ((!KSUCCESS(Status)) && (KSUCCESS(TotalStatus))) {
@@ -2229,11 +2535,12 @@ Return Value:
     PPAGE_CACHE_ENTRY CacheEntry;
     BOOL Destroyed;
     LIST_ENTRY DestroyListHead;
-    PRED_BLACK_TREE_NODE Node;
-    PAGE_CACHE_ENTRY SearchEntry;
+    PPAGE_CACHE_INDEX Index;
+    ULONG LockMask;
+    ULONGLONG PageIndex;
 
     //
-    // The tree is being modified, so the file object lock must be held
+    // The index is being modified, so the file object lock must be held
     // exclusively.
     //
 
@@ -2258,33 +2565,41 @@ Return Value:
     // Quickly exit if there is nothing to evict.
     //
 
-    if (RED_BLACK_TREE_EMPTY(&(FileObject->PageCacheTree)) != FALSE) {
+    Index = FileObject->PageCacheIndex;
+    if (Index->EntryCount == 0) {
         return;
     }
 
     //
-    // Iterate over the file object's tree of page cache entries.
+    // Let any lockless readers know that the cached contents are changing
+    // underneath them.
     //
 
+    IopBeginPageCacheIndexUpdate(Index);
     INITIALIZE_LIST_HEAD(&DestroyListHead);
 
     //
-    // Find the page cache entry in the file object's tree that is closest (but
-    // greater than or equal) to the given eviction offset.
+    // Pending LRU updates hold references on their entries. Apply them now so
+    // that entries with no other references can be destroyed right away
+    // rather than waiting on the removal list.
+    //
+
+    IopDrainPageCacheListBatches();
+
+    //
+    // Iterate over the file object's page cache entries, starting with the
+    // first page cache entry at or beyond the given eviction offset.
     //
 
-    SearchEntry.FileObject = FileObject;
-    SearchEntry.Offset = Offset;
-    SearchEntry.Flags = 0;
-    Node = RtlRedBlackTreeSearchClosest(&(FileObject->PageCacheTree),
-                                        &(SearchEntry.Node),
-                                        TRUE);
+    PageIndex = ALIGN_RANGE_UP(Offset, MmPageSize()) >> MmPageShift();
+    while (TRUE) {
+        CacheEntry = IopFindNextPageCacheIndexEntry(Index,
+                                                    &PageIndex,
+                                                    PAGE_CACHE_TAG_NONE);
 
-    while (Node != NULL) {
-        CacheEntry = LIST_VALUE(Node, PAGE_CACHE_ENTRY, Node);
-        Node = RtlRedBlackTreeGetNextNode(&(FileObject->PageCacheTree),
-                                          FALSE,
-                                          Node);
+        if (CacheEntry == NULL) {
+            break;
+        }
 
         //
         // Assert this is a cache entry after the eviction offset.
@@ -2293,51 +2608,59 @@ Return Value:
         ASSERT(CacheEntry->Offset >= Offset);
 
         //
-        // Remove the node from the page cache tree. It should not be found on
-        // look-up again.
+        // Remove the entry from the page cache index. It should not be found
+        // on look-up again.
         //
 
-        ASSERT(CacheEntry->Node.Parent != NULL);
+        ASSERT((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0);
 
-        IopRemovePageCacheEntryFromTree(CacheEntry);
+        IopRemovePageCacheEntryFromIndex(CacheEntry);
 
         //
         // Remove the cache entry from its current list. If it has no
-        // references, move it to the destroy list. Otherwise, stick it on the
-        // removal list to be destroyed later. The reference count must be
-        // checked while the page cache list lock is held as the list traversal
+        // references, it is headed for the destroy list. Otherwise, stick it
+        // on the removal list to be destroyed later. The reference count must
+        // be checked while the entry's list lock is held as the list traversal
         // routines can add references with only the list lock held (not the
         // file object lock).
         //
 
         Destroyed = FALSE;
-        KeAcquireQueuedLock(IoPageCacheListLock);
-        if (CacheEntry->ListEntry.Next != NULL) {
-            LIST_REMOVE(&(CacheEntry->ListEntry));
-        }
+        LockMask = IopLockPageCacheEntryList(
+                                 CacheEntry,
+                                 PAGE_CACHE_LIST_LOCK(PageCacheListRemoval));
 
         if (CacheEntry->ReferenceCount == 0) {
-            INSERT_BEFORE(&(CacheEntry->ListEntry), &DestroyListHead);
+            if (CacheEntry->ListEntry.Next != NULL) {
+                LIST_REMOVE(&(CacheEntry->ListEntry));
+                CacheEntry->ListEntry.Next = NULL;
+            }
+
             Destroyed = TRUE;
 
         } else {
-            INSERT_BEFORE(&(CacheEntry->ListEntry), &IoPageCacheRemovalList);
+            IopMovePageCacheEntryToList(CacheEntry,
+                                        &IoPageCacheRemovalList,
+                                        PageCacheListRemoval);
         }
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(LockMask);
 
         //
-        // If the cache entry was moved to the destroyed list, clean it once
-        // and for all. No new references can be taken from page cache entry
-        // lookup and it is now on a local list, so no list traversal routines
-        // can add references.
+        // If the cache entry is to be destroyed, clean it once and for all
+        // and then put it on the destroy list. No new references can be taken
+        // from page cache entry lookup and it is not on any list, so no list
+        // traversal routines can add references.
         //
 
         if (Destroyed != FALSE) {
             IopMarkPageCacheEntryClean(CacheEntry, FALSE);
+            INSERT_BEFORE(&(CacheEntry->ListEntry), &DestroyListHead);
         }
     }
 
+    IopEndPageCacheIndexUpdate(Index);
+
     //
     // With the evicted page cache entries removed from the cache, loop through
     // and destroy them. This gets called by truncate and device removal, so
@@ -2541,6 +2864,7 @@ Return Value:
 
 {
 
+    ULONG LockMask;
     BOOL MarkedClean;
     ULONG OldFlags;
 
@@ -2576,6 +2900,12 @@ Return Value:
             if ((OldFlags & PAGE_CACHE_ENTRY_FLAG_MAPPED) != 0) {
                 RtlAtomicAdd(&IoPageCacheMappedDirtyPageCount, (UINTN)-1);
             }
+
+            if ((Entry->FileObject->Flags &
+                 FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0) {
+
+                RtlAtomicAdd(&IoPageCacheMemoryOnlyPageCount, (UINTN)-1);
+            }
         }
 
         if ((OldFlags & PAGE_CACHE_ENTRY_FLAG_DIRTY_PENDING) != 0) {
@@ -2587,7 +2917,12 @@ Return Value:
         // it only transitioned from dirty-pending to clean.
         //
 
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        LockMask = 0;
+        if (MoveToCleanList != FALSE) {
+            LockMask = PAGE_CACHE_LIST_LOCK(PageCacheListClean);
+        }
+
+        LockMask = IopLockPageCacheEntryList(Entry, LockMask);
 
         ASSERT((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY) == 0);
 
@@ -2599,24 +2934,26 @@ Return Value:
         //
 
         if ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_PENDING) == 0) {
-            if (Entry->ListEntry.Next != NULL) {
-                LIST_REMOVE(&(Entry->ListEntry));
-                Entry->ListEntry.Next = NULL;
-            }
+            IopClearPageCacheEntryTag(Entry, PAGE_CACHE_TAG_DIRTY);
 
             //
             // If requested, move the page cache entry to the back of the LRU
             // list; assume that this page has been fairly recently used on
-            // account of it having been dirty. If the page is already on a
-            // list, then leave it as its current location.
+            // account of it having been dirty.
             //
 
             if (MoveToCleanList != FALSE) {
-                INSERT_BEFORE(&(Entry->ListEntry), &IoPageCacheCleanList);
+                IopMovePageCacheEntryToList(Entry,
+                                            &IoPageCacheCleanList,
+                                            PageCacheListClean);
+
+            } else if (Entry->ListEntry.Next != NULL) {
+                LIST_REMOVE(&(Entry->ListEntry));
+                Entry->ListEntry.Next = NULL;
             }
         }
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(LockMask);
         MarkedClean = TRUE;
 
     } else {
@@ -2653,6 +2990,7 @@ Return Value:
 
     PPAGE_CACHE_ENTRY DirtyEntry;
     PFILE_OBJECT FileObject;
+    ULONG LockMask;
     BOOL MarkedDirty;
     ULONG OldFlags;
 
@@ -2711,25 +3049,27 @@ Return Value:
             RtlAtomicAdd(&IoPageCacheMappedDirtyPageCount, 1);
         }
 
+        if ((FileObject->Flags & FILE_OBJECT_FLAG_NO_BACKING_STORE) != 0) {
+            RtlAtomicAdd(&IoPageCacheMemoryOnlyPageCount, 1);
+        }
+
         MarkedDirty = TRUE;
 
         //
-        // Remove the page cache entry from the clean LRU if it's on one.
+        // Remove the page cache entry from the clean LRU if it's on one, and
+        // add it to the dirty page list of the file object.
         //
 
-        KeAcquireQueuedLock(IoPageCacheListLock);
-        if (DirtyEntry->ListEntry.Next != NULL) {
-            LIST_REMOVE(&(DirtyEntry->ListEntry));
-        }
-
-        //
-        // Add it to the dirty page list of the file object.
-        //
+        LockMask = IopLockPageCacheEntryList(
+                                   DirtyEntry,
+                                   PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
 
-        INSERT_BEFORE(&(DirtyEntry->ListEntry),
-                      &(FileObject->DirtyPageList));
+        IopMovePageCacheEntryToList(DirtyEntry,
+                                    &(FileObject->DirtyPageList),
+                                    PageCacheListDirty);
 
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopSetPageCacheEntryTag(DirtyEntry, PAGE_CACHE_TAG_DIRTY);
+        IopReleasePageCacheListLocks(LockMask);
         IopMarkFileObjectDirty(DirtyEntry->FileObject);
 
     } else {
@@ -3172,6 +3512,7 @@ Return Value:
     INITIALIZE_LIST_HEAD(&DestroyListHead);
     if (!LIST_EMPTY(&IoPageCacheCleanUnmappedList)) {
         IopRemovePageCacheEntriesFromList(&IoPageCacheCleanUnmappedList,
+                                          PageCacheListClean,
                                           &DestroyListHead,
                                           TimidEffort,
                                           &TargetRemoveCount);
@@ -3179,6 +3520,7 @@ Return Value:
 
     if (TargetRemoveCount != 0) {
         IopRemovePageCacheEntriesFromList(&IoPageCacheCleanList,
+                                          PageCacheListClean,
                                           &DestroyListHead,
                                           TimidEffort,
                                           &TargetRemoveCount);
@@ -3258,8 +3600,22 @@ Return Value:
     UINTN FreePages;
     UINTN IdealSize;
     UINTN MaxDirty;
+    UINTN MemoryOnlyPages;
+
+    //
+    // Pages without backing store can't be cleaned, so they don't count. The
+    // two counters aren't read atomically, so guard against underflow.
+    //
 
     DirtyPages = IoPageCacheDirtyPageCount;
+    MemoryOnlyPages = IoPageCacheMemoryOnlyPageCount;
+    if (DirtyPages > MemoryOnlyPages) {
+        DirtyPages -= MemoryOnlyPages;
+
+    } else {
+        DirtyPages = 0;
+    }
+
     if (DirtyPages >= IoPageCacheMaxDirtyPages) {
         return TRUE;
     }
@@ -3290,55 +3646,6 @@ Return Value:
     return FALSE;
 }
 
-COMPARISON_RESULT
-IopComparePageCacheEntries (
-    PRED_BLACK_TREE Tree,
-    PRED_BLACK_TREE_NODE FirstNode,
-    PRED_BLACK_TREE_NODE SecondNode
-    )
-
-/*++
-
-Routine Description:
-
-    This routine compares two Red-Black tree nodes contained inside file
-    objects.
-
-Arguments:
-
-    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
-
-    FirstNode - Supplies a pointer to the left side of the comparison.
-
-    SecondNode - Supplies a pointer to the second side of the comparison.
-
-Return Value:
-
-    Same if the two nodes have the same value.
-
-    Ascending if the first node is less than the second node.
-
-    Descending if the second node is less than the first node.
-
---*/
-
-{
-
-    PPAGE_CACHE_ENTRY FirstEntry;
-    PPAGE_CACHE_ENTRY SecondEntry;
-
-    FirstEntry = RED_BLACK_TREE_VALUE(FirstNode, PAGE_CACHE_ENTRY, Node);
-    SecondEntry = RED_BLACK_TREE_VALUE(SecondNode, PAGE_CACHE_ENTRY, Node);
-    if (FirstEntry->Offset < SecondEntry->Offset) {
-        return ComparisonResultAscending;
-
-    } else if (FirstEntry->Offset > SecondEntry->Offset) {
-        return ComparisonResultDescending;
-    }
-
-    return ComparisonResultSame;
-}
-
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -3405,6 +3712,7 @@ Return Value:
     }
 
     NewEntry->ReferenceCount = 1;
+    NewEntry->ListType = PageCacheListClean;
 
 CreatePageCacheEntryEnd:
     return NewEntry;
@@ -3443,15 +3751,25 @@ Return Value:
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
-    RemovedCount = 0;
-    while (LIST_EMPTY(ListHead) == FALSE) {
-        CurrentEntry = ListHead->Next;
-        CacheEntry = LIST_VALUE(CurrentEntry, PAGE_CACHE_ENTRY, ListEntry);
+    //
+    // Lockless lookups may still be looking at these entries, having found
+    // them before they were removed from the index. Wait for those to finish
+    // before tearing anything down.
+    //
+
+    if (LIST_EMPTY(ListHead) == FALSE) {
+        IopSynchronizeLocklessPageCacheLookups();
+    }
+
+    RemovedCount = 0;
+    while (LIST_EMPTY(ListHead) == FALSE) {
+        CurrentEntry = ListHead->Next;
+        CacheEntry = LIST_VALUE(CurrentEntry, PAGE_CACHE_ENTRY, ListEntry);
         LIST_REMOVE(CurrentEntry);
         CurrentEntry->Next = NULL;
 
         ASSERT(CacheEntry->ReferenceCount == 0);
-        ASSERT(CacheEntry->Node.Parent == NULL);
+        ASSERT((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0);
 
         if ((IoPageCacheDebugFlags & PAGE_CACHE_DEBUG_EVICTION) != 0) {
             RtlDebugPrint("PAGE CACHE: Destroy entry 0x%08x: file object "
@@ -3480,6 +3798,7 @@ Return Value:
         }
     }
 
+    IopReclaimPageCacheIndexNodes();
     return;
 }
 
@@ -3517,7 +3836,7 @@ Return Value:
     ASSERT((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0);
     ASSERT(Entry->ListEntry.Next == NULL);
     ASSERT(Entry->ReferenceCount == 0);
-    ASSERT(Entry->Node.Parent == NULL);
+    ASSERT((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0);
 
     //
     // If this is the page owner, then free the physical page.
@@ -3574,7 +3893,7 @@ Return Value:
     return;
 }
 
-VOID
+KSTATUS
 IopInsertPageCacheEntry (
     PPAGE_CACHE_ENTRY NewEntry,
     PPAGE_CACHE_ENTRY LinkEntry
@@ -3585,9 +3904,9 @@ IopInsertPageCacheEntry (
 Routine Description:
 
     This routine inserts the new page cache entry into the page cache and links
-    it to the link entry once it is inserted. This routine assumes that the
-    page cache tree lock is held exclusively and that there is not already an
-    entry for the same file and offset in the tree.
+    it to the link entry. This routine assumes that the file object lock is
+    held exclusively and that there is not already an entry for the same file
+    and offset in the index.
 
 Arguments:
 
@@ -3599,27 +3918,36 @@ Routine Description:
 
 Return Value:
 
-    None.
+    Status code. On failure, the new entry is not inserted or linked.
 
 --*/
 
 {
 
     ULONG ClearFlags;
+    PPAGE_CACHE_INDEX Index;
     IO_OBJECT_TYPE LinkType;
     IO_OBJECT_TYPE NewType;
     ULONG OldFlags;
+    ULONGLONG PageIndex;
+    KSTATUS Status;
     PVOID VirtualAddress;
 
     ASSERT(KeIsSharedExclusiveLockHeldExclusive(NewEntry->FileObject->Lock));
     ASSERT(NewEntry->Flags == 0);
 
     //
-    // Insert the new entry into its file object's tree.
+    // Make room in the index first, as that is the only step that can fail.
+    // The entry is not published until it is completely set up, since
+    // lockless lookups can find it the moment it is.
     //
 
-    RtlRedBlackTreeInsert(&(NewEntry->FileObject->PageCacheTree),
-                          &(NewEntry->Node));
+    Index = NewEntry->FileObject->PageCacheIndex;
+    PageIndex = NewEntry->Offset >> MmPageShift();
+    Status = IopReservePageCacheIndexSlot(Index, PageIndex);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
 
     //
     // Now link the new entry to the supplied link entry based on their I/O
@@ -3663,7 +3991,7 @@ Return Value:
 
             IoPageCacheEntryAddReference(NewEntry);
             LinkEntry->BackingEntry = NewEntry;
-            NewEntry->Flags = PAGE_CACHE_ENTRY_FLAG_OWNER;
+            NewEntry->Flags |= PAGE_CACHE_ENTRY_FLAG_OWNER;
             ClearFlags = PAGE_CACHE_ENTRY_FLAG_OWNER |
                          PAGE_CACHE_ENTRY_FLAG_MAPPED;
 
@@ -3709,7 +4037,9 @@ Return Value:
                                               NewEntry);
     }
 
-    return;
+    RtlAtomicOr32(&(NewEntry->Flags), PAGE_CACHE_ENTRY_FLAG_INDEXED);
+    IopInsertPageCacheIndexEntry(Index, PageIndex, NewEntry);
+    return STATUS_SUCCESS;
 }
 
 PPAGE_CACHE_ENTRY
@@ -3723,7 +4053,7 @@ IopLookupPageCacheEntryHelper (
 Routine Description:
 
     This routine searches for a page cache entry based on the file object and
-    offset. This routine assumes the page cache lock is held. If found, this
+    offset. This routine assumes the file object lock is held. If found, this
     routine takes a reference on the page cache entry.
 
 Arguments:
@@ -3742,20 +4072,18 @@ Return Value:
 {
 
     PPAGE_CACHE_ENTRY FoundEntry;
-    PRED_BLACK_TREE_NODE FoundNode;
-    PAGE_CACHE_ENTRY SearchEntry;
 
-    SearchEntry.FileObject = FileObject;
-    SearchEntry.Offset = Offset;
-    SearchEntry.Flags = 0;
-    FoundNode = RtlRedBlackTreeSearch(&(FileObject->PageCacheTree),
-                                      &(SearchEntry.Node));
+    ASSERT(IS_ALIGNED(Offset, MmPageSize()) != FALSE);
 
-    if (FoundNode == NULL) {
+    FoundEntry = IopLookupPageCacheIndex(FileObject->PageCacheIndex,
+                                         Offset >> MmPageShift());
+
+    if (FoundEntry == NULL) {
         return NULL;
     }
 
-    FoundEntry = RED_BLACK_TREE_VALUE(FoundNode, PAGE_CACHE_ENTRY, Node);
+    ASSERT(FoundEntry->Offset == Offset);
+
     IoPageCacheEntryAddReference(FoundEntry);
     return FoundEntry;
 }
@@ -3786,6 +4114,8 @@ Return Value:
 {
 
     ULONGLONG CurrentTime;
+    UINTN FreePages;
+    UINTN MemoryOnlyFlushCount;
     PKEVENT PhysicalMemoryWarningEvent;
     PVOID SignalingObject;
     KSTATUS Status;
@@ -3848,6 +4178,13 @@ Return Value:
 
         while (TRUE) {
 
+            //
+            // Apply the LRU updates every processor has batched up, dropping
+            // the references they hold so the entries can be trimmed.
+            //
+
+            IopDrainPageCacheListBatches();
+
             //
             // Blast away the list of page cache entries that are ready for
             // removal.
@@ -3855,6 +4192,13 @@ Return Value:
 
             IopTrimRemovalPageCacheList();
 
+            //
+            // Free any page cache index nodes that were pruned since the last
+            // pass.
+            //
+
+            IopReclaimPageCacheIndexNodes();
+
             //
             // Attempt to trim out some clean page cache entries from the LRU
             // list. This routine should only do any work if memory is tight.
@@ -3865,6 +4209,26 @@ Return Value:
 
             IopTrimPageCache(FALSE);
 
+            //
+            // If trimming wasn't enough, push pages from memory-only file
+            // objects down to their file systems (which can in turn page them
+            // out) and go around again to trim them. This also prunes those
+            // file objects that have gone clean.
+            //
+
+            MemoryOnlyFlushCount = 0;
+            if ((IopIsPageCacheTooBig(&FreePages) != FALSE) &&
+                (FreePages < IoPageCacheHeadroomPagesRetreat)) {
+
+                MemoryOnlyFlushCount = IoPageCacheHeadroomPagesRetreat -
+                                       FreePages;
+            }
+
+            Status = IopFlushMemoryOnlyFileObjects(MemoryOnlyFlushCount);
+            if (Status == STATUS_TRY_AGAIN) {
+                continue;
+            }
+
             //
             // Flush some dirty file objects.
             //
@@ -3889,7 +4253,8 @@ Return Value:
             KeCancelTimer(IoPageCacheWorkTimer);
             RtlAtomicExchange32(&IoPageCacheState, PageCacheStateClean);
             if ((!LIST_EMPTY(&IoFileObjectsDirtyList)) ||
-                (IoPageCacheDirtyPageCount != 0)) {
+                (IoPageCacheDirtyPageCount !=
+                 IoPageCacheMemoryOnlyPageCount)) {
 
                 IopSchedulePageCacheThread();
             }
@@ -3944,6 +4309,7 @@ Return Value:
     BOOL MarkedClean;
     ULONG PageSize;
     KSTATUS Status;
+    UINTN WritebackSize;
 
     CacheEntry = MmGetIoBufferPageCacheEntry(FlushBuffer, 0);
     FileObject = CacheEntry->FileObject;
@@ -3970,6 +4336,7 @@ Return Value:
     BufferOffset = 0;
     BytesToWrite = 0;
     Clean = TRUE;
+    WritebackSize = 0;
     while (BufferOffset < FlushSize) {
         CacheEntry = MmGetIoBufferPageCacheEntry(FlushBuffer, BufferOffset);
 
@@ -3977,7 +4344,7 @@ Return Value:
         // Evicted entries should never be in a flush buffer.
         //
 
-        ASSERT(CacheEntry->Node.Parent != NULL);
+        ASSERT((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0);
 
         MarkedClean = IopMarkPageCacheEntryClean(CacheEntry, TRUE);
         if (MarkedClean != FALSE) {
@@ -4020,6 +4387,20 @@ Return Value:
         goto FlushPageCacheBufferEnd;
     }
 
+    //
+    // Tag the pages as being under writeback so that synchronized flushes
+    // racing with this one know the data has not yet reached the disk.
+    //
+
+    BufferOffset = 0;
+    while (BufferOffset < BytesToWrite) {
+        CacheEntry = MmGetIoBufferPageCacheEntry(FlushBuffer, BufferOffset);
+        IopSetPageCacheEntryTag(CacheEntry, PAGE_CACHE_TAG_WRITEBACK);
+        BufferOffset += PageSize;
+    }
+
+    WritebackSize = BytesToWrite;
+
     //
     // For block devices, drop the lock. They're responsible for their own
     // synchronization.
@@ -4079,6 +4460,13 @@ Return Value:
     Status = STATUS_SUCCESS;
 
 FlushPageCacheBufferEnd:
+    BufferOffset = 0;
+    while (BufferOffset < WritebackSize) {
+        CacheEntry = MmGetIoBufferPageCacheEntry(FlushBuffer, BufferOffset);
+        IopClearPageCacheEntryTag(CacheEntry, PAGE_CACHE_TAG_WRITEBACK);
+        BufferOffset += PageSize;
+    }
+
     if (!KSUCCESS(Status)) {
 
         //
@@ -4141,6 +4529,7 @@ Return Value:
 
     INITIALIZE_LIST_HEAD(&DestroyListHead);
     IopRemovePageCacheEntriesFromList(&IoPageCacheRemovalList,
+                                      PageCacheListRemoval,
                                       &DestroyListHead,
                                       FALSE,
                                       NULL);
@@ -4167,6 +4556,7 @@ Return Value:
 VOID
 IopRemovePageCacheEntriesFromList (
     PLIST_ENTRY PageCacheListHead,
+    PAGE_CACHE_LIST_TYPE ListType,
     PLIST_ENTRY DestroyListHead,
     BOOL TimidEffort,
     PUINTN TargetRemoveCount
@@ -4177,15 +4567,17 @@ IopRemovePageCacheEntriesFromList (
 Routine Description:
 
     This routine processes page cache entries in the given list, removing them
-    from the tree and the list, if possible. If a target remove count is
+    from the index and the list, if possible. If a target remove count is
     supplied, then the removal process will stop as soon as the removal count
-    reaches 0 or the end of the list is reached. This routine assumes that the
-    page cache tree lock is held exclusively.
+    reaches 0 or the end of the list is reached.
 
 Arguments:
 
     PageCacheListHead - Supplies a pointer to the head of the page cache list.
 
+    ListType - Supplies the type of the given list, which determines the lock
+        that protects it.
+
     DestroyListHead - Supplies a pointer to the head of the list of page cache
         entries that can be destroyed as a result of the removal process.
 
@@ -4211,15 +4603,19 @@ Return Value:
     PPAGE_CACHE_ENTRY CacheEntry;
     PFILE_OBJECT FileObject;
     ULONG Flags;
+    ULONG ListLock;
     LIST_ENTRY LocalList;
     PSHARED_EXCLUSIVE_LOCK Lock;
+    ULONG LockMask;
     PLIST_ENTRY MoveList;
+    PAGE_CACHE_LIST_TYPE MoveListType;
     BOOL PageTakenDown;
     KSTATUS Status;
 
-    KeAcquireQueuedLock(IoPageCacheListLock);
+    ListLock = PAGE_CACHE_LIST_LOCK(ListType);
+    IopAcquirePageCacheListLocks(ListLock);
     if (LIST_EMPTY(PageCacheListHead)) {
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(ListLock);
         return;
     }
 
@@ -4238,11 +4634,16 @@ Return Value:
         FileObject = CacheEntry->FileObject;
         Flags = CacheEntry->Flags;
 
+        ASSERT(CacheEntry->ListType == ListType);
+
         //
         // If the page cache entry has not been evicted, potentially skip it.
+        // Entries still in the index are only ever found on the clean lists.
         //
 
-        if (CacheEntry->Node.Parent != NULL) {
+        if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0) {
+
+            ASSERT(ListType == PageCacheListClean);
 
             //
             // Remove anything with a reference to avoid iterating through it
@@ -4287,20 +4688,29 @@ Return Value:
         // For timid attempts, try to get the lock without dropping the list
         // lock (since for a single attempt lock inversions are not an issue).
         // If it fails, just move on in case this thread already owns the lock
-        // in question further up the stack.
+        // in question further up the stack. The removal list lock comes after
+        // the clean list lock, so it is safe to acquire it here.
         //
 
         Lock = FileObject->Lock;
         if (TimidEffort != FALSE) {
             if (KeTryToAcquireSharedExclusiveLockExclusive(Lock) == FALSE) {
                 LIST_REMOVE(&(CacheEntry->ListEntry));
-                if (CacheEntry->Node.Parent != NULL) {
+                CacheEntry->ListEntry.Next = NULL;
+                if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0) {
                     INSERT_BEFORE(&(CacheEntry->ListEntry),
                                   &IoPageCacheCleanList);
 
                 } else {
-                    INSERT_BEFORE(&(CacheEntry->ListEntry),
-                                  &IoPageCacheRemovalList);
+                    LockMask = PAGE_CACHE_LIST_LOCK(PageCacheListRemoval) &
+                               ~ListLock;
+
+                    IopAcquirePageCacheListLocks(LockMask);
+                    IopMovePageCacheEntryToList(CacheEntry,
+                                                &IoPageCacheRemovalList,
+                                                PageCacheListRemoval);
+
+                    IopReleasePageCacheListLocks(LockMask);
                 }
 
                 continue;
@@ -4313,7 +4723,7 @@ Return Value:
         //
 
         IoPageCacheEntryAddReference(CacheEntry);
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(ListLock);
 
         //
         // Acquire the lock if not already acquired.
@@ -4327,11 +4737,11 @@ Return Value:
         if (CacheEntry->ReferenceCount == 1) {
 
             //
-            // If the page cache entry is already removed from the tree, then
+            // If the page cache entry is already removed from the index, then
             // just mark it clean and grab the flags.
             //
 
-            if (CacheEntry->Node.Parent == NULL) {
+            if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0) {
                 IopMarkPageCacheEntryClean(CacheEntry, FALSE);
                 PageTakenDown = TRUE;
 
@@ -4349,7 +4759,7 @@ Return Value:
                     if ((CacheEntry->Flags &
                          PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) {
 
-                        IopRemovePageCacheEntryFromTree(CacheEntry);
+                        IopRemovePageCacheEntryFromIndex(CacheEntry);
                         PageTakenDown = TRUE;
                     }
                 }
@@ -4370,11 +4780,18 @@ Return Value:
         }
 
         //
-        // Drop the file object lock and reacquire the list lock.
+        // Drop the file object lock and reacquire the list lock. The entry
+        // may have been moved to some other type of list in the meantime, and
+        // may need to go to either the clean or removal list, so grab all the
+        // locks that could be needed.
         //
 
         KeReleaseSharedExclusiveLockExclusive(Lock);
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        LockMask = IopLockPageCacheEntryList(
+                                 CacheEntry,
+                                 ListLock |
+                                 PAGE_CACHE_LIST_LOCK(PageCacheListClean) |
+                                 PAGE_CACHE_LIST_LOCK(PageCacheListRemoval));
 
         //
         // If the page was successfully destroyed and still only has one
@@ -4383,6 +4800,7 @@ Return Value:
         //
 
         MoveList = NULL;
+        MoveListType = PageCacheListTypeCount;
         if ((PageTakenDown != FALSE) &&
             (CacheEntry->ReferenceCount == 1)) {
 
@@ -4394,33 +4812,47 @@ Return Value:
         // If the page cache has been evicted, move it to the removal list.
         //
 
-        } else if (CacheEntry->Node.Parent == NULL) {
+        } else if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0) {
             MoveList = &IoPageCacheRemovalList;
+            MoveListType = PageCacheListRemoval;
 
         //
         // Otherwise if it is clean, remove it from the local list and put it
-        // on the clean list. It has to go on a list because releasing the
-        // reference might try to stick it on a list if it sees it's clean and
-        // not on a list. The list lock, however, is already held and would
-        // cause a deadlock. If the object is now dirty, it was likely removed
-        // from the list or about to be removed.
+        // on the clean list. If the object is now dirty, it was likely
+        // removed from the list or about to be removed.
         //
 
         } else {
             if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) {
                 MoveList = &IoPageCacheCleanList;
+                MoveListType = PageCacheListClean;
             }
         }
 
-        if (MoveList != NULL) {
+        //
+        // The destroy list is private to this thread, so the entry's list type
+        // is left alone when moving it there.
+        //
+
+        if (MoveList == DestroyListHead) {
             if (CacheEntry->ListEntry.Next != NULL) {
                 LIST_REMOVE(&(CacheEntry->ListEntry));
             }
 
             INSERT_BEFORE(&(CacheEntry->ListEntry), MoveList);
+
+        } else if (MoveList != NULL) {
+            IopMovePageCacheEntryToList(CacheEntry, MoveList, MoveListType);
         }
 
+        //
+        // Releasing the reference may need to put the entry on a list, so it
+        // cannot be done with any list locks held.
+        //
+
+        IopReleasePageCacheListLocks(LockMask);
         IoPageCacheEntryReleaseReference(CacheEntry);
+        IopAcquirePageCacheListLocks(ListLock);
     }
 
     //
@@ -4431,7 +4863,7 @@ Return Value:
         APPEND_LIST(&LocalList, PageCacheListHead);
     }
 
-    KeReleaseQueuedLock(IoPageCacheListLock);
+    IopReleasePageCacheListLocks(ListLock);
     return;
 }
 
@@ -4468,8 +4900,10 @@ Return Value:
     PFILE_OBJECT FileObject;
     UINTN FreeVirtualPages;
     PSHARED_EXCLUSIVE_LOCK Lock;
+    ULONG LockMask;
     UINTN MappedCleanPageCount;
     PLIST_ENTRY MoveList;
+    PAGE_CACHE_LIST_TYPE MoveListType;
     ULONG PageSize;
     LIST_ENTRY ReturnList;
     UINTN TargetUnmapCount;
@@ -4546,7 +4980,7 @@ Return Value:
     UnmapSize = 0;
     UnmapCount = 0;
     PageSize = MmPageSize();
-    KeAcquireQueuedLock(IoPageCacheListLock);
+    IopAcquirePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListClean));
     while ((!LIST_EMPTY(&IoPageCacheCleanList)) &&
            ((TargetUnmapCount != UnmapCount) ||
             (MmGetVirtualMemoryWarningLevel() != MemoryWarningLevelNone))) {
@@ -4631,7 +5065,7 @@ Return Value:
         //
 
         IoPageCacheEntryAddReference(CacheEntry);
-        KeReleaseQueuedLock(IoPageCacheListLock);
+        IopReleasePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListClean));
         if (TimidEffort == FALSE) {
             KeAcquireSharedExclusiveLockExclusive(Lock);
         }
@@ -4665,11 +5099,15 @@ Return Value:
         }
 
         //
-        // Drop the file object lock and reacquire the list lock.
+        // Drop the file object lock and reacquire the list lock, along with
+        // the locks for wherever the entry is now and might need to go.
         //
 
         KeReleaseSharedExclusiveLockExclusive(Lock);
-        KeAcquireQueuedLock(IoPageCacheListLock);
+        LockMask = IopLockPageCacheEntryList(
+                                 CacheEntry,
+                                 PAGE_CACHE_LIST_LOCK(PageCacheListClean) |
+                                 PAGE_CACHE_LIST_LOCK(PageCacheListRemoval));
 
         //
         // If the page cache entry was evicted by another thread, it is either
@@ -4680,8 +5118,10 @@ Return Value:
         //
 
         MoveList = NULL;
-        if (CacheEntry->Node.Parent == NULL) {
+        MoveListType = PageCacheListClean;
+        if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0) {
             MoveList = &IoPageCacheRemovalList;
+            MoveListType = PageCacheListRemoval;
 
         } else {
             if ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) {
@@ -4697,14 +5137,17 @@ Return Value:
         }
 
         if (MoveList != NULL) {
-            if (CacheEntry->ListEntry.Next != NULL) {
-                LIST_REMOVE(&(CacheEntry->ListEntry));
-            }
-
-            INSERT_BEFORE(&(CacheEntry->ListEntry), MoveList);
+            IopMovePageCacheEntryToList(CacheEntry, MoveList, MoveListType);
         }
 
+        //
+        // Releasing the reference may need to put the entry on a list, so it
+        // cannot be done with any list locks held.
+        //
+
+        IopReleasePageCacheListLocks(LockMask);
         IoPageCacheEntryReleaseReference(CacheEntry);
+        IopAcquirePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListClean));
     }
 
     //
@@ -4716,7 +5159,7 @@ Return Value:
         APPEND_LIST(&ReturnList, &IoPageCacheCleanList);
     }
 
-    KeReleaseQueuedLock(IoPageCacheListLock);
+    IopReleasePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListClean));
 
     //
     // If there is a remaining region of contiguous virtual memory that needs
@@ -4797,7 +5240,7 @@ Return Value:
         CacheEntry = MmGetIoBufferPageCacheEntry(IoBuffer, BufferOffset);
         if ((CacheEntry == NULL) ||
             (CacheEntry->FileObject != FileObject) ||
-            (CacheEntry->Node.Parent == NULL) ||
+            ((CacheEntry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) == 0) ||
             (CacheEntry->Offset != Offset)) {
 
             return FALSE;
@@ -4997,7 +5440,7 @@ Return Value:
 }
 
 VOID
-IopRemovePageCacheEntryFromTree (
+IopRemovePageCacheEntryFromIndex (
     PPAGE_CACHE_ENTRY Entry
     )
 
@@ -5005,8 +5448,10 @@ IopRemovePageCacheEntryFromTree (
 
 Routine Description:
 
-    This routine removes a page cache entry from the page cache tree. This
-    routine assumes that the page cache's tree lock is held exclusively.
+    This routine removes a page cache entry from its file object's page cache
+    index. This routine assumes that the file object lock is held exclusively.
+    Callers must check the reference count only after this routine returns, to
+    synchronize with lockless lookups.
 
 Arguments:
 
@@ -5021,7 +5466,7 @@ Return Value:
 {
 
     ASSERT(KeIsSharedExclusiveLockHeldExclusive(Entry->FileObject->Lock));
-    ASSERT(Entry->Node.Parent != NULL);
+    ASSERT((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0);
 
     //
     // If a backing entry exists, then MM needs to know that the backing entry
@@ -5033,8 +5478,10 @@ Return Value:
                                               Entry->BackingEntry);
     }
 
-    RtlRedBlackTreeRemove(&(Entry->FileObject->PageCacheTree), &(Entry->Node));
-    Entry->Node.Parent = NULL;
+    IopRemovePageCacheIndexEntry(Entry->FileObject->PageCacheIndex,
+                                 Entry->Offset >> MmPageShift());
+
+    RtlAtomicAnd32(&(Entry->Flags), ~PAGE_CACHE_ENTRY_FLAG_INDEXED);
     if ((IoPageCacheDebugFlags & PAGE_CACHE_DEBUG_EVICTION) != 0) {
         RtlDebugPrint("PAGE CACHE: Remove PAGE_CACHE_ENTRY 0x%08x: FILE_OBJECT "
                       "0x%08x, offset 0x%I64x, physical address "
@@ -5050,6 +5497,81 @@ Return Value:
     return;
 }
 
+VOID
+IopSetPageCacheEntryTag (
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets a tag on the given page cache entry in its file object's
+    page cache index. Nothing happens if the entry has been removed from the
+    index.
+
+Arguments:
+
+    Entry - Supplies a pointer to a page cache entry.
+
+    Tag - Supplies the tag to set. See PAGE_CACHE_TAG_* for definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0) {
+        IopSetPageCacheIndexTag(Entry->FileObject->PageCacheIndex,
+                                Entry->Offset >> MmPageShift(),
+                                Entry,
+                                Tag);
+    }
+
+    return;
+}
+
+VOID
+IopClearPageCacheEntryTag (
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine clears a tag from the given page cache entry in its file
+    object's page cache index.
+
+Arguments:
+
+    Entry - Supplies a pointer to a page cache entry.
+
+    Tag - Supplies the tag to clear. See PAGE_CACHE_TAG_* for definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0) {
+        IopClearPageCacheIndexTag(Entry->FileObject->PageCacheIndex,
+                                  Entry->Offset >> MmPageShift(),
+                                  Entry,
+                                  Tag);
+    }
+
+    return;
+}
+
 VOID
 IopUpdatePageCacheEntryList (
     PPAGE_CACHE_ENTRY Entry,
@@ -5062,7 +5584,9 @@ Routine Description:
 
     This routine updates a page cache entry's list entry by putting it on the
     appropriate list. This should be used when a page cache entry is looked up
-    or when it is created.
+    or when it is created. The update is batched up on the current processor
+    and applied later along with others, so the caller must hold a reference
+    on the entry.
 
 Arguments:
 
@@ -5080,45 +5604,363 @@ Return Value:
 
 {
 
-    KeAcquireQueuedLock(IoPageCacheListLock);
+    PPAGE_CACHE_LIST_BATCH Batch;
+    ULONG Count;
+    PPAGE_CACHE_ENTRY Entries[PAGE_CACHE_LIST_BATCH_SIZE];
+    RUNLEVEL OldRunLevel;
+
+    ASSERT(Entry->ReferenceCount != 0);
+    ASSERT((Created == FALSE) ||
+           ((Entry->ListEntry.Next == NULL) &&
+            ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0)));
 
     //
-    // If the page cache entry is not new, then it might already be on a
-    // list. If it's on a clean list, move it to the back. If it's clean
-    // and not on a list, then it probably got ripped off the list because
-    // there are references on it.
+    // The batch holds its own reference so that the entry cannot be
+    // destroyed before the batch is applied.
     //
 
-    if (Created == FALSE) {
+    IoPageCacheEntryAddReference(Entry);
+    Count = 0;
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Batch = &(IoPageCacheListBatches[KeGetCurrentProcessorNumber()]);
+    KeAcquireSpinLock(&(Batch->Lock));
+    Batch->Entries[Batch->Count] = Entry;
+    Batch->Count += 1;
 
-        //
-        // If it's dirty, it should always be on the dirty list.
-        //
+    //
+    // If the batch is full, take it over and apply it once back at low level.
+    //
+
+    if (Batch->Count == PAGE_CACHE_LIST_BATCH_SIZE) {
+        Count = Batch->Count;
+        RtlCopyMemory(Entries, Batch->Entries, Count * sizeof(PVOID));
+        Batch->Count = 0;
+    }
+
+    KeReleaseSpinLock(&(Batch->Lock));
+    KeLowerRunLevel(OldRunLevel);
+    if (Count != 0) {
+        IopApplyPageCacheListBatch(Entries, Count);
+    }
+
+    return;
+}
+
+VOID
+IopApplyPageCacheListBatch (
+    PPAGE_CACHE_ENTRY *Entries,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves a batch of recently used page cache entries to the back
+    of the clean LRU list and then releases the references the batch held.
+
+Arguments:
+
+    Entries - Supplies an array of page cache entries, each of which comes with
+        a reference that this routine releases.
+
+    Count - Supplies the number of entries in the array.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Applied;
+    PPAGE_CACHE_ENTRY Entry;
+    ULONG Index;
+    ULONG LockMask;
+
+    ASSERT(Count <= (sizeof(ULONG) * BITS_PER_BYTE));
+
+    //
+    // Entries that are dirty should stay on the dirty list, and entries that
+    // are no longer indexed were evicted and should stay on the removal list.
+    // Most entries are already somewhere under the clean list lock, so handle
+    // those all at once.
+    //
 
-        ASSERT(((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) ||
-               (Entry->ListEntry.Next != NULL));
+    Applied = 0;
+    IopAcquirePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListClean));
+    for (Index = 0; Index < Count; Index += 1) {
+        Entry = Entries[Index];
+        if (Entry->ListType == PageCacheListClean) {
+            if (((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) &&
+                ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0)) {
 
-        if (((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) &&
-            (Entry->ListEntry.Next != NULL)) {
+                IopMovePageCacheEntryToList(Entry,
+                                            &IoPageCacheCleanList,
+                                            PageCacheListClean);
+            }
 
-            LIST_REMOVE(&(Entry->ListEntry));
-            INSERT_BEFORE(&(Entry->ListEntry), &IoPageCacheCleanList);
+            Applied |= 1 << Index;
         }
+    }
+
+    IopReleasePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListClean));
 
     //
-    // New pages do not start on a list. Stick it on the back of the clean
-    // list.
+    // Handle the stragglers that were under some other list lock one by one.
+    // Then release the batch's references. This may put entries that were
+    // skipped back on a list, so it must be done without list locks held.
     //
 
-    } else {
+    for (Index = 0; Index < Count; Index += 1) {
+        Entry = Entries[Index];
+        if ((Applied & (1 << Index)) == 0) {
+            LockMask = IopLockPageCacheEntryList(
+                                   Entry,
+                                   PAGE_CACHE_LIST_LOCK(PageCacheListClean));
+
+            if (((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0) &&
+                ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_INDEXED) != 0)) {
+
+                IopMovePageCacheEntryToList(Entry,
+                                            &IoPageCacheCleanList,
+                                            PageCacheListClean);
+            }
+
+            IopReleasePageCacheListLocks(LockMask);
+        }
+
+        IoPageCacheEntryReleaseReference(Entry);
+    }
+
+    return;
+}
+
+VOID
+IopDrainPageCacheListBatches (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine applies the pending LRU updates batched up on every
+    processor, releasing the references they hold.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPAGE_CACHE_LIST_BATCH Batch;
+    ULONG BatchIndex;
+    ULONG Count;
+    PPAGE_CACHE_ENTRY Entries[PAGE_CACHE_LIST_BATCH_SIZE];
+    RUNLEVEL OldRunLevel;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    for (BatchIndex = 0;
+         BatchIndex < IoPageCacheListBatchCount;
+         BatchIndex += 1) {
+
+        Batch = &(IoPageCacheListBatches[BatchIndex]);
+        if (Batch->Count == 0) {
+            continue;
+        }
+
+        OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+        KeAcquireSpinLock(&(Batch->Lock));
+        Count = Batch->Count;
+        RtlCopyMemory(Entries, Batch->Entries, Count * sizeof(PVOID));
+        Batch->Count = 0;
+        KeReleaseSpinLock(&(Batch->Lock));
+        KeLowerRunLevel(OldRunLevel);
+        if (Count != 0) {
+            IopApplyPageCacheListBatch(Entries, Count);
+        }
+    }
+
+    return;
+}
+
+ULONG
+IopLockPageCacheEntryList (
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG LockMask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine acquires the lock that protects the given page cache entry's
+    list entry, along with any other list locks the caller needs. The entry's
+    list type cannot change until the locks are released.
+
+Arguments:
+
+    Entry - Supplies a pointer to the page cache entry whose list lock should
+        be acquired.
+
+    LockMask - Supplies a mask of additional list locks to acquire. See
+        PAGE_CACHE_LIST_LOCK.
+
+Return Value:
+
+    Returns the mask of list locks acquired, which should be passed to the
+    release routine.
+
+--*/
+
+{
+
+    ULONG AcquiredMask;
+    ULONG ListType;
+
+    //
+    // The list type can only change with its current lock held, so once the
+    // lock is acquired and the type is seen to still match, it is stable.
+    //
+
+    while (TRUE) {
+        ListType = Entry->ListType;
+
+        ASSERT(ListType < PageCacheListTypeCount);
+
+        AcquiredMask = LockMask | PAGE_CACHE_LIST_LOCK(ListType);
+        IopAcquirePageCacheListLocks(AcquiredMask);
+        if (Entry->ListType == ListType) {
+            break;
+        }
+
+        IopReleasePageCacheListLocks(AcquiredMask);
+    }
+
+    return AcquiredMask;
+}
+
+VOID
+IopAcquirePageCacheListLocks (
+    ULONG LockMask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine acquires a set of page cache list locks in the proper order.
+
+Arguments:
+
+    LockMask - Supplies the mask of list locks to acquire. See
+        PAGE_CACHE_LIST_LOCK.
+
+Return Value:
+
+    None.
 
-        ASSERT(Entry->ListEntry.Next == NULL);
-        ASSERT((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) == 0);
+--*/
+
+{
 
-        INSERT_BEFORE(&(Entry->ListEntry), &IoPageCacheCleanList);
+    ULONG ListType;
+
+    for (ListType = 0; ListType < PageCacheListTypeCount; ListType += 1) {
+        if ((LockMask & PAGE_CACHE_LIST_LOCK(ListType)) != 0) {
+            KeAcquireQueuedLock(IoPageCacheListLocks[ListType]);
+        }
     }
 
-    KeReleaseQueuedLock(IoPageCacheListLock);
+    return;
+}
+
+VOID
+IopReleasePageCacheListLocks (
+    ULONG LockMask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a set of page cache list locks.
+
+Arguments:
+
+    LockMask - Supplies the mask of list locks to release. See
+        PAGE_CACHE_LIST_LOCK.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG ListType;
+
+    ListType = PageCacheListTypeCount;
+    while (ListType != 0) {
+        ListType -= 1;
+        if ((LockMask & PAGE_CACHE_LIST_LOCK(ListType)) != 0) {
+            KeReleaseQueuedLock(IoPageCacheListLocks[ListType]);
+        }
+    }
+
+    return;
+}
+
+VOID
+IopMovePageCacheEntryToList (
+    PPAGE_CACHE_ENTRY Entry,
+    PLIST_ENTRY ListHead,
+    PAGE_CACHE_LIST_TYPE ListType
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves a page cache entry to the back of the given list,
+    pulling it off of whatever list it is currently on. The caller must hold
+    the locks for both the entry's current list type and the new list type.
+
+Arguments:
+
+    Entry - Supplies a pointer to the page cache entry to move.
+
+    ListHead - Supplies a pointer to the head of the list to move it to.
+
+    ListType - Supplies the type of the destination list.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(KeIsQueuedLockHeld(IoPageCacheListLocks[Entry->ListType]) != FALSE);
+    ASSERT(KeIsQueuedLockHeld(IoPageCacheListLocks[ListType]) != FALSE);
+
+    if (Entry->ListEntry.Next != NULL) {
+        LIST_REMOVE(&(Entry->ListEntry));
+    }
+
+    INSERT_BEFORE(&(Entry->ListEntry), ListHead);
+    Entry->ListType = ListType;
     return;
 }
 
@@ -5264,7 +6106,7 @@ Return Value:
 
     PLIST_ENTRY CurrentEntry;
     PPAGE_CACHE_ENTRY Entry;
-    PRED_BLACK_TREE_NODE TreeNode;
+    ULONGLONG PageIndex;
 
     //
     // This routine produces a lot of false negatives for block devices because
@@ -5276,10 +6118,17 @@ Return Value:
     }
 
     KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
-    KeAcquireQueuedLock(IoPageCacheListLock);
-    TreeNode = RtlRedBlackTreeGetLowestNode(&(FileObject->PageCacheTree));
-    while (TreeNode != NULL) {
-        Entry = RED_BLACK_TREE_VALUE(TreeNode, PAGE_CACHE_ENTRY, Node);
+    IopAcquirePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
+    PageIndex = 0;
+    while (TRUE) {
+        Entry = IopFindNextPageCacheIndexEntry(FileObject->PageCacheIndex,
+                                               &PageIndex,
+                                               PAGE_CACHE_TAG_NONE);
+
+        if (Entry == NULL) {
+            break;
+        }
+
         if ((Entry->Flags & PAGE_CACHE_ENTRY_FLAG_DIRTY_MASK) != 0) {
             if (Entry->ListEntry.Next == NULL) {
                 RtlDebugPrint("PAGE_CACHE_ENTRY 0x%x for FILE_OBJECT 0x%x "
@@ -5305,14 +6154,23 @@ Return Value:
                                   Entry->Offset);
                 }
             }
+
+            if (IopGetPageCacheIndexTag(FileObject->PageCacheIndex,
+                                        PageIndex,
+                                        PAGE_CACHE_TAG_DIRTY) == FALSE) {
+
+                RtlDebugPrint("PAGE_CACHE_ENTRY 0x%x for FILE_OBJECT 0x%x "
+                              "Offset 0x%I64x dirty but not tagged.\n",
+                              Entry,
+                              FileObject,
+                              Entry->Offset);
+            }
         }
 
-        TreeNode = RtlRedBlackTreeGetNextNode(&(FileObject->PageCacheTree),
-                                              FALSE,
-                                              TreeNode);
+        PageIndex += 1;
     }
 
-    KeReleaseQueuedLock(IoPageCacheListLock);
+    IopReleasePageCacheListLocks(PAGE_CACHE_LIST_LOCK(PageCacheListDirty));
     KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
     return;
 }
@@ -37,10 +37,61 @@ Module Name:
 
 #define PAGE_CACHE_DIRTY_PENANCE_PAGES 128
 
+//
+// Define the number of page index bits consumed at each level of the page
+// cache index, and the resulting number of slots in each index node.
+//
+
+#define PAGE_CACHE_INDEX_SHIFT 6
+#define PAGE_CACHE_INDEX_SLOTS (1 << PAGE_CACHE_INDEX_SHIFT)
+#define PAGE_CACHE_INDEX_MASK (PAGE_CACHE_INDEX_SLOTS - 1)
+
+//
+// Define the tags that can be applied to entries in the page cache index.
+//
+
+#define PAGE_CACHE_TAG_DIRTY 0
+#define PAGE_CACHE_TAG_WRITEBACK 1
+#define PAGE_CACHE_TAG_COUNT 2
+#define PAGE_CACHE_TAG_NONE ((ULONG)-1)
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+typedef struct _PAGE_CACHE_INDEX_NODE
+    PAGE_CACHE_INDEX_NODE, *PPAGE_CACHE_INDEX_NODE;
+
+/*++
+
+Structure Description:
+
+    This structure defines a page cache index, which maps a file object's page
+    offsets to its page cache entries. Modifications are serialized by the
+    file object lock and the index spin lock. Lookups may be done without any
+    locks from inside a lockless lookup section.
+
+Members:
+
+    Root - Stores a pointer to the root node of the radix tree.
+
+    Lock - Stores the spin lock serializing modifications to the nodes.
+
+    Sequence - Stores a sequence number that is odd while the cached data is
+        being changed. Lockless readers use this to detect overlapping writes
+        and truncates.
+
+    EntryCount - Stores the number of page cache entries in the index.
+
+--*/
+
+struct _PAGE_CACHE_INDEX {
+    PPAGE_CACHE_INDEX_NODE volatile Root;
+    KSPIN_LOCK Lock;
+    volatile ULONG Sequence;
+    UINTN EntryCount;
+};
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -102,6 +153,41 @@ Return Value:
 
 --*/
 
+ULONG
+IopLookupPageCacheEntriesLockless (
+    PFILE_OBJECT FileObject,
+    IO_OFFSET Offset,
+    PPAGE_CACHE_ENTRY *Entries,
+    ULONG EntryCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine looks up a run of consecutive page cache entries without
+    acquiring the file object lock. The run stops at the first page that is
+    not in the cache. A reference is taken on each entry returned. The caller
+    is responsible for making sure the data it reads from the entries is
+    consistent, usually by checking the page cache index sequence number.
+
+Arguments:
+
+    FileObject - Supplies a pointer to a file object for the device or file.
+
+    Offset - Supplies the page-aligned offset of the first entry to look up.
+
+    Entries - Supplies an array where the referenced entries are returned.
+
+    EntryCount - Supplies the maximum number of entries to look up.
+
+Return Value:
+
+    Returns the number of consecutive entries found, starting at the given
+    offset.
+
+--*/
+
 PPAGE_CACHE_ENTRY
 IopCreateOrLookupPageCacheEntry (
     PFILE_OBJECT FileObject,
@@ -583,35 +669,512 @@ Return Value:
 
 --*/
 
-COMPARISON_RESULT
-IopComparePageCacheEntries (
-    PRED_BLACK_TREE Tree,
-    PRED_BLACK_TREE_NODE FirstNode,
-    PRED_BLACK_TREE_NODE SecondNode
+KSTATUS
+IopInitializePageCacheIndexing (
+    VOID
     );
 
 /*++
 
 Routine Description:
 
-    This routine compares two Red-Black tree nodes contained inside file
-    objects.
+    This routine initializes global support for page cache indices.
 
 Arguments:
 
-    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+PPAGE_CACHE_INDEX
+IopCreatePageCacheIndex (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates an empty page cache index.
 
-    FirstNode - Supplies a pointer to the left side of the comparison.
+Arguments:
 
-    SecondNode - Supplies a pointer to the second side of the comparison.
+    None.
 
 Return Value:
 
-    Same if the two nodes have the same value.
+    Returns a pointer to the new index on success.
+
+    NULL on allocation failure.
+
+--*/
+
+VOID
+IopDestroyPageCacheIndex (
+    PPAGE_CACHE_INDEX Index
+    );
+
+/*++
 
-    Ascending if the first node is less than the second node.
+Routine Description:
 
-    Descending if the second node is less than the first node.
+    This routine destroys a page cache index. The index must not contain any
+    page cache entries, though it may still have empty nodes left over from
+    reservations. The caller must guarantee that no lockless lookups can be
+    operating on the index.
+
+Arguments:
+
+    Index - Supplies a pointer to the index to destroy.
+
+Return Value:
+
+    None.
 
 --*/
 
+KSTATUS
+IopReservePageCacheIndexSlot (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    );
+
+/*++
+
+Routine Description:
+
+    This routine makes sure all the nodes needed to hold an entry at the given
+    page index exist, so that a subsequent insert cannot fail. The caller must
+    hold the owning file object lock exclusive, which serializes all changes to
+    the shape of the index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to reserve.
+
+Return Value:
+
+    STATUS_SUCCESS if the slot is ready for insertion.
+
+    STATUS_INSUFFICIENT_RESOURCES if a node could not be allocated.
+
+--*/
+
+VOID
+IopInsertPageCacheIndexEntry (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    PPAGE_CACHE_ENTRY Entry
+    );
+
+/*++
+
+Routine Description:
+
+    This routine publishes a page cache entry in the index. The slot must have
+    been reserved and must be empty. The entry must be fully initialized, as
+    lockless lookups may find it as soon as it is inserted. The caller must
+    hold the owning file object lock exclusive.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to insert at.
+
+    Entry - Supplies a pointer to the page cache entry to insert.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopRemovePageCacheIndexEntry (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes the page cache entry at the given page index from the
+    index, clearing its tags and pruning any nodes that become empty. Pruned
+    nodes are not freed until lockless lookups have drained. The caller must
+    hold the owning file object lock exclusive.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to remove.
+
+Return Value:
+
+    None.
+
+--*/
+
+PPAGE_CACHE_ENTRY
+IopLookupPageCacheIndex (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    );
+
+/*++
+
+Routine Description:
+
+    This routine looks up the page cache entry at the given page index. No
+    reference is taken. The caller must either hold the owning file object
+    lock or be inside a lockless lookup.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to look up.
+
+Return Value:
+
+    Returns a pointer to the page cache entry on success.
+
+    NULL if there is no entry at the given page index.
+
+--*/
+
+PPAGE_CACHE_ENTRY
+IopFindNextPageCacheIndexEntry (
+    PPAGE_CACHE_INDEX Index,
+    PULONGLONG PageIndex,
+    ULONG Tag
+    );
+
+/*++
+
+Routine Description:
+
+    This routine finds the page cache entry with the lowest page index greater
+    than or equal to the given one, optionally requiring a tag. No reference is
+    taken. The caller must either hold the owning file object lock or be inside
+    a lockless lookup.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies a pointer that on input contains the page index to
+        start searching at. On success, returns the page index of the found
+        entry.
+
+    Tag - Supplies the tag the entry must have, or PAGE_CACHE_TAG_NONE to
+        return any entry.
+
+Return Value:
+
+    Returns a pointer to the page cache entry on success.
+
+    NULL if there are no more entries.
+
+--*/
+
+ULONG
+IopGangLookupPageCacheIndex (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    ULONG Tag,
+    PPAGE_CACHE_ENTRY *Entries,
+    ULONG EntryCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine collects up to the given number of page cache entries in
+    ascending order, starting at the given page index. No references are
+    taken. The caller must either hold the owning file object lock or be
+    inside a lockless lookup.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to start at.
+
+    Tag - Supplies the tag the entries must have, or PAGE_CACHE_TAG_NONE to
+        return any entries.
+
+    Entries - Supplies an array where the found entries are returned.
+
+    EntryCount - Supplies the number of elements in the entries array.
+
+Return Value:
+
+    Returns the number of entries returned.
+
+--*/
+
+VOID
+IopSetPageCacheIndexTag (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    );
+
+/*++
+
+Routine Description:
+
+    This routine tags the entry at the given page index. Nothing happens if
+    the given entry is not the one at the given page index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index of the entry to tag.
+
+    Entry - Supplies a pointer to the page cache entry expected to be at the
+        given page index.
+
+    Tag - Supplies the tag to set.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopClearPageCacheIndexTag (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    );
+
+/*++
+
+Routine Description:
+
+    This routine clears a tag from the entry at the given page index. Nothing
+    happens if the given entry is not the one at the given page index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index of the entry to untag.
+
+    Entry - Supplies a pointer to the page cache entry expected to be at the
+        given page index.
+
+    Tag - Supplies the tag to clear.
+
+Return Value:
+
+    None.
+
+--*/
+
+BOOL
+IopGetPageCacheIndexTag (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    ULONG Tag
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether the entry at the given page index has the
+    given tag. The result is only a snapshot unless the caller synchronizes
+    with whoever sets and clears the tag.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index of the entry to query.
+
+    Tag - Supplies the tag to query.
+
+Return Value:
+
+    TRUE if the entry is tagged.
+
+    FALSE if the entry is not tagged or there is no entry.
+
+--*/
+
+BOOL
+IopIsPageCacheIndexTagged (
+    PPAGE_CACHE_INDEX Index,
+    ULONG Tag
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether any entry in the index has the given tag.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    Tag - Supplies the tag to query.
+
+Return Value:
+
+    TRUE if some entry is tagged.
+
+    FALSE if no entries are tagged.
+
+--*/
+
+VOID
+IopBeginPageCacheIndexUpdate (
+    PPAGE_CACHE_INDEX Index
+    );
+
+/*++
+
+Routine Description:
+
+    This routine marks the start of a change to the data cached by the index,
+    such as a write or a truncate. Lockless readers that overlap with the
+    update will notice and fall back to acquiring the file object lock. The
+    caller must hold the owning file object lock exclusive.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopEndPageCacheIndexUpdate (
+    PPAGE_CACHE_INDEX Index
+    );
+
+/*++
+
+Routine Description:
+
+    This routine marks the end of a change to the data cached by the index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+Return Value:
+
+    None.
+
+--*/
+
+RUNLEVEL
+IopBeginLocklessPageCacheLookup (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine enters a lockless lookup section. Page cache entries and index
+    nodes seen inside the section are not freed until the section ends. The
+    section runs at dispatch level, so it must be short and must not touch
+    paged memory.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the previous run level, which must be passed to the end routine.
+
+--*/
+
+VOID
+IopEndLocklessPageCacheLookup (
+    RUNLEVEL OldRunLevel
+    );
+
+/*++
+
+Routine Description:
+
+    This routine leaves a lockless lookup section.
+
+Arguments:
+
+    OldRunLevel - Supplies the run level returned when the section began.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopSynchronizeLocklessPageCacheLookups (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits until every lockless lookup section that was active when
+    this routine was called has ended. Anything unpublished from an index
+    before this call can be freed once it returns.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopReclaimPageCacheIndexNodes (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine frees any index nodes that were pruned from their trees, once
+    lockless lookups that might still see them have drained.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
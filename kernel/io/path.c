@@ -58,6 +58,32 @@ Module Name:
 
 #define PATH_UNREACHABLE_PATH_PREFIX "(unreachable)/"
 
+//
+// Define the number of children a directory path entry must have before its
+// children get indexed by a hash table rather than just a list.
+//
+
+#define PATH_ENTRY_CHILD_HASH_THRESHOLD 16
+
+//
+// Define the initial and maximum number of buckets in a child hash table, and
+// the average chain length that triggers the table to grow. The bucket counts
+// must be powers of two.
+//
+
+#define PATH_ENTRY_CHILD_HASH_INITIAL_BUCKETS 32
+#define PATH_ENTRY_CHILD_HASH_MAX_BUCKETS 0x10000
+#define PATH_ENTRY_CHILD_HASH_LOAD_FACTOR 2
+
+//
+// This macro returns the list head for the bucket in the given path entry's
+// child hash table that the given hash lands in.
+//
+
+#define PATH_ENTRY_CHILD_BUCKET(_PathEntry, _Hash) \
+    (&((_PathEntry)->ChildHashTable[ \
+                           (_Hash) & ((_PathEntry)->ChildHashBucketCount - 1)]))
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -121,6 +147,12 @@ IopFindPathPoint (
     PPATH_POINT Result
     );
 
+VOID
+IopResizePathEntryChildHashTable (
+    PPATH_ENTRY Parent,
+    ULONG BucketCount
+    );
+
 VOID
 IopPathEntryReleaseReference (
     PPATH_ENTRY Entry,
@@ -1040,6 +1072,83 @@ Return Value:
     return FALSE;
 }
 
+VOID
+IopPathInsertChild (
+    PPATH_ENTRY Parent,
+    PPATH_ENTRY Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine links the given path entry into its parent's list of
+    children, making it visible to path walks. This assumes the caller holds
+    the parent path entry's file object lock exclusively.
+
+Arguments:
+
+    Parent - Supplies a pointer to the parent path entry.
+
+    Entry - Supplies a pointer to the path entry to insert.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG BucketCount;
+
+    ASSERT(Entry->Parent == Parent);
+    ASSERT((Entry->SiblingListEntry.Next == NULL) &&
+           (Entry->HashListEntry.Next == NULL));
+
+    ASSERT((Parent->FileObject == NULL) ||
+           (KeIsSharedExclusiveLockHeldExclusive(Parent->FileObject->Lock)));
+
+    INSERT_BEFORE(&(Entry->SiblingListEntry), &(Parent->ChildList));
+    Parent->ChildCount += 1;
+
+    //
+    // Once a directory gets big enough, index its children by hash so that
+    // lookups don't have to compare against every sibling. Grow the table as
+    // the directory fills up to keep the chains short. Failure to allocate a
+    // table is not fatal, lookups just fall back to the slower path.
+    //
+
+    BucketCount = Parent->ChildHashBucketCount;
+    if (BucketCount == 0) {
+        if (Parent->ChildCount > PATH_ENTRY_CHILD_HASH_THRESHOLD) {
+            IopResizePathEntryChildHashTable(
+                                        Parent,
+                                        PATH_ENTRY_CHILD_HASH_INITIAL_BUCKETS);
+        }
+
+    } else if ((BucketCount < PATH_ENTRY_CHILD_HASH_MAX_BUCKETS) &&
+               (Parent->ChildCount >
+                (BucketCount * PATH_ENTRY_CHILD_HASH_LOAD_FACTOR))) {
+
+        IopResizePathEntryChildHashTable(Parent, BucketCount << 2);
+    }
+
+    //
+    // The resize routine hashes in every child, including this one. If there
+    // is a table and this entry didn't get added, add it now.
+    //
+
+    if ((Parent->ChildHashTable != NULL) &&
+        (Entry->HashListEntry.Next == NULL)) {
+
+        INSERT_BEFORE(&(Entry->HashListEntry),
+                      PATH_ENTRY_CHILD_BUCKET(Parent, Entry->Hash));
+    }
+
+    return;
+}
+
 VOID
 IopPathUnlink (
     PPATH_ENTRY Entry
@@ -1077,8 +1186,71 @@ Return Value:
     if (Entry->SiblingListEntry.Next != NULL) {
         LIST_REMOVE(&(Entry->SiblingListEntry));
         Entry->SiblingListEntry.Next = NULL;
+
+        ASSERT(Entry->Parent->ChildCount != 0);
+
+        Entry->Parent->ChildCount -= 1;
+        if (Entry->HashListEntry.Next != NULL) {
+            LIST_REMOVE(&(Entry->HashListEntry));
+            Entry->HashListEntry.Next = NULL;
+        }
+    }
+
+    return;
+}
+
+VOID
+IopNotifyPathEntryWatches (
+    PPATH_ENTRY Entry,
+    ULONG Events
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reports events on the given path entry to any file watches
+    on its file object or on its parent directory. Callers should check
+    IoFileWatchCount before calling this routine.
+
+Arguments:
+
+    Entry - Supplies an optional pointer to the path entry that changed.
+
+    Events - Supplies the events that occurred. See FILE_WATCH_EVENT_*
+        definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFILE_OBJECT Directory;
+
+    if ((Entry == NULL) || (Entry->FileObject == NULL)) {
+        return;
+    }
+
+    //
+    // Only entries still linked into their parent have a name there worth
+    // reporting.
+    //
+
+    Directory = NULL;
+    if ((Entry->Parent != NULL) && (Entry->SiblingListEntry.Next != NULL)) {
+        Directory = Entry->Parent->FileObject;
     }
 
+    IopNotifyFileWatches(Directory,
+                         Entry->Name,
+                         Entry->NameSize,
+                         Entry->FileObject,
+                         Events,
+                         0);
+
     return;
 }
 
@@ -2314,6 +2486,7 @@ Return Value:
     ULONG FileObjectFlags;
     BOOL FoundPathPoint;
     BOOL Negative;
+    BOOL NewFile;
     POBJECT_HEADER Object;
     PPATH_ENTRY PathEntry;
     PDEVICE PathRoot;
@@ -2329,6 +2502,7 @@ Return Value:
     DoNotCache = FALSE;
     FileObject = NULL;
     Negative = FALSE;
+    NewFile = FALSE;
     PathEntry = NULL;
     PathRoot = DirectoryEntry->FileObject->Device;
 
@@ -2503,6 +2677,8 @@ Return Value:
 
                 ASSERT(Created != FALSE);
 
+                NewFile = TRUE;
+
                 //
                 // If requested, unlink the file now that it has been created
                 // and the necessary data recorded. If the unlink fails, leave
@@ -2955,10 +3131,7 @@ Return Value:
         Result->PathEntry->FileObject = FileObject;
         IopFileObjectAddPathEntryReference(Result->PathEntry->FileObject);
         if ((OpenFlags & OPEN_FLAG_UNLINK_ON_CREATE) != 0) {
-            if (Result->PathEntry->SiblingListEntry.Next != NULL) {
-                LIST_REMOVE(&(Result->PathEntry->SiblingListEntry));
-                Result->PathEntry->SiblingListEntry.Next = NULL;
-            }
+            IopPathUnlink(Result->PathEntry);
         }
 
     //
@@ -2993,8 +3166,7 @@ Return Value:
             ASSERT((FileObject == NULL) ||
                    (FileObject->Properties.HardLinkCount != 0));
 
-            INSERT_BEFORE(&(PathEntry->SiblingListEntry),
-                          &(DirectoryEntry->ChildList));
+            IopPathInsertChild(DirectoryEntry, PathEntry);
         }
 
         Result->PathEntry = PathEntry;
@@ -3002,6 +3174,10 @@ Return Value:
         Result->MountPoint = Directory->MountPoint;
     }
 
+    if ((NewFile != FALSE) && (IoFileWatchCount != 0)) {
+        IopNotifyPathEntryWatches(Result->PathEntry, FILE_WATCH_EVENT_CREATE);
+    }
+
     FileObject = NULL;
     Status = STATUS_SUCCESS;
 
@@ -3244,22 +3420,41 @@ Return Value:
     PPATH_ENTRY Entry;
     PMOUNT_POINT FoundMountPoint;
     PPATH_ENTRY FoundPathEntry;
+    PLIST_ENTRY ListHead;
     PFILE_OBJECT ParentFileObject;
+    PPATH_ENTRY ParentPathEntry;
     BOOL ResultValid;
 
     ResultValid = FALSE;
-    ParentFileObject = Parent->PathEntry->FileObject;
+    ParentPathEntry = Parent->PathEntry;
+    ParentFileObject = ParentPathEntry->FileObject;
 
     ASSERT(NameSize != 0);
     ASSERT(KeIsSharedExclusiveLockHeld(ParentFileObject->Lock) != FALSE);
 
     //
-    // Cruise through the cached list looking for this entry.
+    // Cruise through the cached children looking for this entry. If the
+    // directory is big enough to have a hash table, only the one bucket needs
+    // to be searched. Negative entries live in the same structures, so a miss
+    // that was previously seen is also found quickly here.
     //
 
-    CurrentEntry = Parent->PathEntry->ChildList.Next;
-    while (CurrentEntry != &(Parent->PathEntry->ChildList)) {
-        Entry = LIST_VALUE(CurrentEntry, PATH_ENTRY, SiblingListEntry);
+    if (ParentPathEntry->ChildHashTable != NULL) {
+        ListHead = PATH_ENTRY_CHILD_BUCKET(ParentPathEntry, Hash);
+
+    } else {
+        ListHead = &(ParentPathEntry->ChildList);
+    }
+
+    CurrentEntry = ListHead->Next;
+    while (CurrentEntry != ListHead) {
+        if (ListHead == &(ParentPathEntry->ChildList)) {
+            Entry = LIST_VALUE(CurrentEntry, PATH_ENTRY, SiblingListEntry);
+
+        } else {
+            Entry = LIST_VALUE(CurrentEntry, PATH_ENTRY, HashListEntry);
+        }
+
         CurrentEntry = CurrentEntry->Next;
 
         //
@@ -3318,6 +3513,78 @@ Return Value:
     return ResultValid;
 }
 
+VOID
+IopResizePathEntryChildHashTable (
+    PPATH_ENTRY Parent,
+    ULONG BucketCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates or grows the hash table indexing a directory path
+    entry's children, and rehashes all of the current children into it. The
+    caller must hold the parent's file object lock exclusively. On allocation
+    failure the existing table, if any, is left in place.
+
+Arguments:
+
+    Parent - Supplies a pointer to the directory path entry.
+
+    BucketCount - Supplies the new number of buckets, which must be a power of
+        two.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY Buckets;
+    PPATH_ENTRY Child;
+    PLIST_ENTRY CurrentEntry;
+    ULONG Index;
+
+    ASSERT(POWER_OF_2(BucketCount) != FALSE);
+    ASSERT(BucketCount > Parent->ChildHashBucketCount);
+
+    Buckets = MmAllocatePagedPool(BucketCount * sizeof(LIST_ENTRY),
+                                  PATH_ALLOCATION_TAG);
+
+    if (Buckets == NULL) {
+        return;
+    }
+
+    for (Index = 0; Index < BucketCount; Index += 1) {
+        INITIALIZE_LIST_HEAD(&(Buckets[Index]));
+    }
+
+    if (Parent->ChildHashTable != NULL) {
+        MmFreePagedPool(Parent->ChildHashTable);
+    }
+
+    Parent->ChildHashTable = Buckets;
+    Parent->ChildHashBucketCount = BucketCount;
+
+    //
+    // The old buckets are gone, so just overwrite each child's hash list
+    // entry rather than removing it.
+    //
+
+    CurrentEntry = Parent->ChildList.Next;
+    while (CurrentEntry != &(Parent->ChildList)) {
+        Child = LIST_VALUE(CurrentEntry, PATH_ENTRY, SiblingListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        INSERT_BEFORE(&(Child->HashListEntry),
+                      PATH_ENTRY_CHILD_BUCKET(Parent, Child->Hash));
+    }
+
+    return;
+}
+
 VOID
 IopPathEntryReleaseReference (
     PPATH_ENTRY Entry,
@@ -3589,10 +3856,7 @@ Return Value:
         // entries.
         //
 
-        if (Entry->SiblingListEntry.Next != NULL) {
-            LIST_REMOVE(&(Entry->SiblingListEntry));
-            Entry->SiblingListEntry.Next = NULL;
-        }
+        IopPathUnlink(Entry);
 
         ASSERT(ParentFileObject != NULL);
 
@@ -3621,6 +3885,12 @@ Return Value:
         IopFileObjectReleaseReference(Entry->FileObject);
     }
 
+    ASSERT(Entry->ChildCount == 0);
+
+    if (Entry->ChildHashTable != NULL) {
+        MmFreePagedPool(Entry->ChildHashTable);
+    }
+
     MmFreePagedPool(Entry);
     return Parent;
 }
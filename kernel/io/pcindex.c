@@ -0,0 +1,1486 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    pcindex.c
+
+Abstract:
+
+    This module implements the page cache index, a radix tree keyed by page
+    offset that maps a file object's offsets to its page cache entries. The
+    index supports lookups that do not acquire any locks, tags for dirty and
+    writeback entries, and gang lookups.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+#include "pagecach.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PAGE_CACHE_INDEX_ALLOCATION_TAG 0x78644950 // 'xdIP'
+
+//
+// Define the block expansion count for the index node block allocator.
+//
+
+#define PAGE_CACHE_INDEX_BLOCK_ALLOCATOR_EXPANSION_COUNT 0x10
+
+//
+// Define the total number of bits in a page index.
+//
+
+#define PAGE_CACHE_INDEX_BITS 64
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro determines the slot within the given node that the given page
+// index lives in.
+//
+
+#define PAGE_CACHE_INDEX_SLOT(_Node, _PageIndex) \
+    (ULONG)(((_PageIndex) >> (_Node)->Shift) & PAGE_CACHE_INDEX_MASK)
+
+//
+// This macro evaluates to non-zero if the given page index is beyond the range
+// covered by the given node when that node is the root.
+//
+
+#define PAGE_CACHE_INDEX_BEYOND_ROOT(_Node, _PageIndex)                   \
+    ((((_Node)->Shift + PAGE_CACHE_INDEX_SHIFT) < PAGE_CACHE_INDEX_BITS) && \
+     (((_PageIndex) >> ((_Node)->Shift + PAGE_CACHE_INDEX_SHIFT)) != 0))
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines a node in the page cache index.
+
+Members:
+
+    Parent - Stores a pointer to the parent node, or NULL if this is the root.
+
+    FreeListEntry - Stores this node's entry in the list of nodes waiting for
+        lockless lookups to drain before being freed.
+
+    Shift - Stores the amount to shift a page index right to get the slot
+        number within this node. Leaf nodes have a shift of zero.
+
+    ParentSlot - Stores the index of this node within its parent's slots.
+
+    Count - Stores the number of non-null slots in this node.
+
+    Tags - Stores a bitmap per tag of which slots are tagged. In interior
+        nodes, a bit is set if anything underneath that slot is tagged.
+
+    Slots - Stores the child nodes, or page cache entries for leaf nodes.
+
+--*/
+
+struct _PAGE_CACHE_INDEX_NODE {
+    PPAGE_CACHE_INDEX_NODE Parent;
+    LIST_ENTRY FreeListEntry;
+    ULONG Shift;
+    ULONG ParentSlot;
+    ULONG Count;
+    ULONGLONG Tags[PAGE_CACHE_TAG_COUNT];
+    PVOID volatile Slots[PAGE_CACHE_INDEX_SLOTS];
+};
+
+/*++
+
+Structure Description:
+
+    This structure defines the lockless lookup state for a single processor.
+    It is padded out so that processors do not share cache lines.
+
+Members:
+
+    Sequence - Stores a sequence number that is odd while the processor is
+        inside a lockless lookup and even otherwise.
+
+--*/
+
+typedef struct _PAGE_CACHE_LOOKUP_STATE {
+    volatile ULONG Sequence;
+    ULONG Padding[15];
+} PAGE_CACHE_LOOKUP_STATE, *PPAGE_CACHE_LOOKUP_STATE;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+PPAGE_CACHE_INDEX_NODE
+IopCreatePageCacheIndexNode (
+    ULONG Shift
+    );
+
+PPAGE_CACHE_INDEX_NODE
+IopFindPageCacheIndexLeaf (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    );
+
+VOID
+IopDeferPageCacheIndexNodeFree (
+    PLIST_ENTRY NodeList
+    );
+
+VOID
+IopFreePageCacheIndexSubtree (
+    PPAGE_CACHE_INDEX_NODE Node
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the block allocator for index nodes. Lockless lookups run at dispatch
+// level, so the nodes must be non-paged.
+//
+
+PBLOCK_ALLOCATOR IoPageCacheIndexNodeAllocator;
+
+//
+// Store the array of per-processor lockless lookup states and its size.
+//
+
+PPAGE_CACHE_LOOKUP_STATE IoPageCacheLookupStates;
+ULONG IoPageCacheLookupStateCount;
+
+//
+// Store the list of index nodes that have been removed from their trees but
+// may still be visible to lockless lookups, and the lock protecting it.
+//
+
+LIST_ENTRY IoPageCacheIndexFreeList;
+KSPIN_LOCK IoPageCacheIndexFreeListLock;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+KSTATUS
+IopInitializePageCacheIndexing (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes global support for page cache indices.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    PBLOCK_ALLOCATOR BlockAllocator;
+    ULONG ProcessorCount;
+    KSTATUS Status;
+
+    INITIALIZE_LIST_HEAD(&IoPageCacheIndexFreeList);
+    KeInitializeSpinLock(&IoPageCacheIndexFreeListLock);
+    BlockAllocator = MmCreateBlockAllocator(
+                              sizeof(PAGE_CACHE_INDEX_NODE),
+                              0,
+                              PAGE_CACHE_INDEX_BLOCK_ALLOCATOR_EXPANSION_COUNT,
+                              BLOCK_ALLOCATOR_FLAG_NON_PAGED |
+                              BLOCK_ALLOCATOR_FLAG_TRIM,
+                              PAGE_CACHE_INDEX_ALLOCATION_TAG);
+
+    if (BlockAllocator == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto InitializePageCacheIndexingEnd;
+    }
+
+    //
+    // All processors are online by the time I/O initializes, so the lookup
+    // state array can be sized once.
+    //
+
+    ProcessorCount = KeGetActiveProcessorCount();
+    AllocationSize = ProcessorCount * sizeof(PAGE_CACHE_LOOKUP_STATE);
+    IoPageCacheLookupStates = MmAllocateNonPagedPool(
+                                              AllocationSize,
+                                              PAGE_CACHE_INDEX_ALLOCATION_TAG);
+
+    if (IoPageCacheLookupStates == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto InitializePageCacheIndexingEnd;
+    }
+
+    RtlZeroMemory(IoPageCacheLookupStates, AllocationSize);
+    IoPageCacheLookupStateCount = ProcessorCount;
+    IoPageCacheIndexNodeAllocator = BlockAllocator;
+    BlockAllocator = NULL;
+    Status = STATUS_SUCCESS;
+
+InitializePageCacheIndexingEnd:
+    if (BlockAllocator != NULL) {
+        MmDestroyBlockAllocator(BlockAllocator);
+    }
+
+    return Status;
+}
+
+PPAGE_CACHE_INDEX
+IopCreatePageCacheIndex (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates an empty page cache index.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the new index on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX Index;
+
+    Index = MmAllocateNonPagedPool(sizeof(PAGE_CACHE_INDEX),
+                                   PAGE_CACHE_INDEX_ALLOCATION_TAG);
+
+    if (Index == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(Index, sizeof(PAGE_CACHE_INDEX));
+    KeInitializeSpinLock(&(Index->Lock));
+    return Index;
+}
+
+VOID
+IopDestroyPageCacheIndex (
+    PPAGE_CACHE_INDEX Index
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a page cache index. The index must not contain any
+    page cache entries, though it may still have empty nodes left over from
+    reservations. The caller must guarantee that no lockless lookups can be
+    operating on the index.
+
+Arguments:
+
+    Index - Supplies a pointer to the index to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(Index->EntryCount == 0);
+
+    if (Index->Root != NULL) {
+        IopFreePageCacheIndexSubtree(Index->Root);
+        Index->Root = NULL;
+    }
+
+    MmFreeNonPagedPool(Index);
+    return;
+}
+
+KSTATUS
+IopReservePageCacheIndexSlot (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine makes sure all the nodes needed to hold an entry at the given
+    page index exist, so that a subsequent insert cannot fail. The caller must
+    hold the owning file object lock exclusive, which serializes all changes to
+    the shape of the index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to reserve.
+
+Return Value:
+
+    STATUS_SUCCESS if the slot is ready for insertion.
+
+    STATUS_INSUFFICIENT_RESOURCES if a node could not be allocated.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Child;
+    PPAGE_CACHE_INDEX_NODE NewNode;
+    PPAGE_CACHE_INDEX_NODE Node;
+    RUNLEVEL OldRunLevel;
+    ULONG Shift;
+    ULONG Slot;
+    ULONG Tag;
+
+    //
+    // Create a root that covers the page index if there is no root.
+    //
+
+    if (Index->Root == NULL) {
+        Shift = 0;
+        while (((Shift + PAGE_CACHE_INDEX_SHIFT) < PAGE_CACHE_INDEX_BITS) &&
+               ((PageIndex >> (Shift + PAGE_CACHE_INDEX_SHIFT)) != 0)) {
+
+            Shift += PAGE_CACHE_INDEX_SHIFT;
+        }
+
+        NewNode = IopCreatePageCacheIndexNode(Shift);
+        if (NewNode == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+        KeAcquireSpinLock(&(Index->Lock));
+        RtlMemoryBarrier();
+        Index->Root = NewNode;
+        KeReleaseSpinLock(&(Index->Lock));
+        KeLowerRunLevel(OldRunLevel);
+    }
+
+    //
+    // Grow the tree upwards until the root covers the page index. The old
+    // root becomes the first child of the new root. Lookups racing with this
+    // see either the old root (which still correctly describes the lower
+    // indices) or the new one.
+    //
+
+    while (PAGE_CACHE_INDEX_BEYOND_ROOT(Index->Root, PageIndex)) {
+        Node = Index->Root;
+        NewNode = IopCreatePageCacheIndexNode(Node->Shift +
+                                              PAGE_CACHE_INDEX_SHIFT);
+
+        if (NewNode == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+        KeAcquireSpinLock(&(Index->Lock));
+        NewNode->Slots[0] = Node;
+        NewNode->Count = 1;
+        for (Tag = 0; Tag < PAGE_CACHE_TAG_COUNT; Tag += 1) {
+            if (Node->Tags[Tag] != 0) {
+                NewNode->Tags[Tag] = 1;
+            }
+        }
+
+        Node->Parent = NewNode;
+        Node->ParentSlot = 0;
+        RtlMemoryBarrier();
+        Index->Root = NewNode;
+        KeReleaseSpinLock(&(Index->Lock));
+        KeLowerRunLevel(OldRunLevel);
+    }
+
+    //
+    // Now walk down to the leaf, creating any missing interior nodes.
+    //
+
+    Node = Index->Root;
+    while (Node->Shift != 0) {
+        Slot = PAGE_CACHE_INDEX_SLOT(Node, PageIndex);
+        Child = Node->Slots[Slot];
+        if (Child == NULL) {
+            Child = IopCreatePageCacheIndexNode(Node->Shift -
+                                                PAGE_CACHE_INDEX_SHIFT);
+
+            if (Child == NULL) {
+                return STATUS_INSUFFICIENT_RESOURCES;
+            }
+
+            Child->Parent = Node;
+            Child->ParentSlot = Slot;
+            OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+            KeAcquireSpinLock(&(Index->Lock));
+            RtlMemoryBarrier();
+            Node->Slots[Slot] = Child;
+            Node->Count += 1;
+            KeReleaseSpinLock(&(Index->Lock));
+            KeLowerRunLevel(OldRunLevel);
+        }
+
+        Node = Child;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+IopInsertPageCacheIndexEntry (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    PPAGE_CACHE_ENTRY Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine publishes a page cache entry in the index. The slot must have
+    been reserved and must be empty. The entry must be fully initialized, as
+    lockless lookups may find it as soon as it is inserted. The caller must
+    hold the owning file object lock exclusive.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to insert at.
+
+    Entry - Supplies a pointer to the page cache entry to insert.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Leaf;
+    RUNLEVEL OldRunLevel;
+    ULONG Slot;
+
+    Leaf = IopFindPageCacheIndexLeaf(Index, PageIndex);
+
+    ASSERT(Leaf != NULL);
+
+    Slot = PAGE_CACHE_INDEX_SLOT(Leaf, PageIndex);
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    KeAcquireSpinLock(&(Index->Lock));
+
+    ASSERT(Leaf->Slots[Slot] == NULL);
+
+    RtlMemoryBarrier();
+    Leaf->Slots[Slot] = Entry;
+    Leaf->Count += 1;
+    Index->EntryCount += 1;
+    KeReleaseSpinLock(&(Index->Lock));
+    KeLowerRunLevel(OldRunLevel);
+    return;
+}
+
+VOID
+IopRemovePageCacheIndexEntry (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the page cache entry at the given page index from the
+    index, clearing its tags and pruning any nodes that become empty. Pruned
+    nodes are not freed until lockless lookups have drained. The caller must
+    hold the owning file object lock exclusive.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to remove.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LIST_ENTRY FreeList;
+    PPAGE_CACHE_INDEX_NODE Node;
+    RUNLEVEL OldRunLevel;
+    PPAGE_CACHE_INDEX_NODE Parent;
+    ULONGLONG SlotMask;
+    ULONG Slot;
+    ULONG Tag;
+
+    INITIALIZE_LIST_HEAD(&FreeList);
+    Node = IopFindPageCacheIndexLeaf(Index, PageIndex);
+
+    ASSERT(Node != NULL);
+
+    Slot = PAGE_CACHE_INDEX_SLOT(Node, PageIndex);
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    KeAcquireSpinLock(&(Index->Lock));
+
+    ASSERT(Node->Slots[Slot] != NULL);
+
+    Node->Slots[Slot] = NULL;
+    Node->Count -= 1;
+    Index->EntryCount -= 1;
+
+    //
+    // Clear the tags for the slot, and then walk up clearing tags for any
+    // node that no longer has anything tagged underneath it.
+    //
+
+    for (Tag = 0; Tag < PAGE_CACHE_TAG_COUNT; Tag += 1) {
+        Parent = Node;
+        SlotMask = 1ULL << Slot;
+        while ((Parent != NULL) && ((Parent->Tags[Tag] & SlotMask) != 0)) {
+            Parent->Tags[Tag] &= ~SlotMask;
+            if (Parent->Tags[Tag] != 0) {
+                break;
+            }
+
+            SlotMask = 1ULL << Parent->ParentSlot;
+            Parent = Parent->Parent;
+        }
+    }
+
+    //
+    // Prune empty nodes. Their slots are all null, so any lookup still
+    // wandering through them will simply miss.
+    //
+
+    while ((Node != NULL) && (Node->Count == 0)) {
+        Parent = Node->Parent;
+        if (Parent != NULL) {
+
+            ASSERT(Parent->Slots[Node->ParentSlot] == Node);
+
+            Parent->Slots[Node->ParentSlot] = NULL;
+            Parent->Count -= 1;
+
+        } else {
+
+            ASSERT(Index->Root == Node);
+
+            Index->Root = NULL;
+        }
+
+        INSERT_BEFORE(&(Node->FreeListEntry), &FreeList);
+        Node = Parent;
+    }
+
+    KeReleaseSpinLock(&(Index->Lock));
+    if (!LIST_EMPTY(&FreeList)) {
+        IopDeferPageCacheIndexNodeFree(&FreeList);
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+    return;
+}
+
+PPAGE_CACHE_ENTRY
+IopLookupPageCacheIndex (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks up the page cache entry at the given page index. No
+    reference is taken. The caller must either hold the owning file object
+    lock or be inside a lockless lookup.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to look up.
+
+Return Value:
+
+    Returns a pointer to the page cache entry on success.
+
+    NULL if there is no entry at the given page index.
+
+--*/
+
+{
+
+    PVOID Child;
+    PPAGE_CACHE_INDEX_NODE Node;
+
+    Node = Index->Root;
+    if ((Node == NULL) || (PAGE_CACHE_INDEX_BEYOND_ROOT(Node, PageIndex))) {
+        return NULL;
+    }
+
+    while (TRUE) {
+        Child = Node->Slots[PAGE_CACHE_INDEX_SLOT(Node, PageIndex)];
+        if ((Child == NULL) || (Node->Shift == 0)) {
+            break;
+        }
+
+        Node = Child;
+    }
+
+    return Child;
+}
+
+PPAGE_CACHE_ENTRY
+IopFindNextPageCacheIndexEntry (
+    PPAGE_CACHE_INDEX Index,
+    PULONGLONG PageIndex,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the page cache entry with the lowest page index greater
+    than or equal to the given one, optionally requiring a tag. No reference is
+    taken. The caller must either hold the owning file object lock or be inside
+    a lockless lookup.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies a pointer that on input contains the page index to
+        start searching at. On success, returns the page index of the found
+        entry.
+
+    Tag - Supplies the tag the entry must have, or PAGE_CACHE_TAG_NONE to
+        return any entry.
+
+Return Value:
+
+    Returns a pointer to the page cache entry on success.
+
+    NULL if there are no more entries.
+
+--*/
+
+{
+
+    PVOID Child;
+    ULONGLONG Current;
+    ULONGLONG Next;
+    PPAGE_CACHE_INDEX_NODE Node;
+    PPAGE_CACHE_INDEX_NODE Root;
+    ULONG Slot;
+
+    Current = *PageIndex;
+
+    //
+    // Start from the root each time a node is exhausted rather than following
+    // parent pointers, which might be changing underneath a lockless lookup.
+    // The search index only ever moves forward, so this terminates.
+    //
+
+Restart:
+    Root = Index->Root;
+    if ((Root == NULL) || (PAGE_CACHE_INDEX_BEYOND_ROOT(Root, Current))) {
+        return NULL;
+    }
+
+    Node = Root;
+    while (TRUE) {
+        Slot = PAGE_CACHE_INDEX_SLOT(Node, Current);
+        while (Slot < PAGE_CACHE_INDEX_SLOTS) {
+            Child = Node->Slots[Slot];
+            if ((Child != NULL) &&
+                ((Tag == PAGE_CACHE_TAG_NONE) ||
+                 ((Node->Tags[Tag] & (1ULL << Slot)) != 0))) {
+
+                break;
+            }
+
+            //
+            // Move the search index to the start of the next slot. Finding
+            // nothing in the very last slot of the index means the end.
+            //
+
+            Next = ((Current >> Node->Shift) + 1) << Node->Shift;
+            if (Next <= Current) {
+                return NULL;
+            }
+
+            Current = Next;
+            Slot += 1;
+        }
+
+        if (Slot == PAGE_CACHE_INDEX_SLOTS) {
+            if (Node == Root) {
+                return NULL;
+            }
+
+            goto Restart;
+        }
+
+        if (Node->Shift == 0) {
+            *PageIndex = Current;
+            return Child;
+        }
+
+        Node = Child;
+    }
+
+    return NULL;
+}
+
+ULONG
+IopGangLookupPageCacheIndex (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    ULONG Tag,
+    PPAGE_CACHE_ENTRY *Entries,
+    ULONG EntryCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine collects up to the given number of page cache entries in
+    ascending order, starting at the given page index. No references are
+    taken. The caller must either hold the owning file object lock or be
+    inside a lockless lookup.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to start at.
+
+    Tag - Supplies the tag the entries must have, or PAGE_CACHE_TAG_NONE to
+        return any entries.
+
+    Entries - Supplies an array where the found entries are returned.
+
+    EntryCount - Supplies the number of elements in the entries array.
+
+Return Value:
+
+    Returns the number of entries returned.
+
+--*/
+
+{
+
+    ULONG Count;
+    PPAGE_CACHE_ENTRY Entry;
+
+    Count = 0;
+    while (Count < EntryCount) {
+        Entry = IopFindNextPageCacheIndexEntry(Index, &PageIndex, Tag);
+        if (Entry == NULL) {
+            break;
+        }
+
+        Entries[Count] = Entry;
+        Count += 1;
+        PageIndex += 1;
+        if (PageIndex == 0) {
+            break;
+        }
+    }
+
+    return Count;
+}
+
+VOID
+IopSetPageCacheIndexTag (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine tags the entry at the given page index. Nothing happens if
+    the given entry is not the one at the given page index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index of the entry to tag.
+
+    Entry - Supplies a pointer to the page cache entry expected to be at the
+        given page index.
+
+    Tag - Supplies the tag to set.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Node;
+    RUNLEVEL OldRunLevel;
+    ULONG Slot;
+
+    ASSERT(Tag < PAGE_CACHE_TAG_COUNT);
+
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    KeAcquireSpinLock(&(Index->Lock));
+    Node = IopFindPageCacheIndexLeaf(Index, PageIndex);
+    if (Node != NULL) {
+        Slot = PAGE_CACHE_INDEX_SLOT(Node, PageIndex);
+        if (Node->Slots[Slot] == Entry) {
+            while (Node != NULL) {
+                if ((Node->Tags[Tag] & (1ULL << Slot)) != 0) {
+                    break;
+                }
+
+                Node->Tags[Tag] |= 1ULL << Slot;
+                Slot = Node->ParentSlot;
+                Node = Node->Parent;
+            }
+        }
+    }
+
+    KeReleaseSpinLock(&(Index->Lock));
+    KeLowerRunLevel(OldRunLevel);
+    return;
+}
+
+VOID
+IopClearPageCacheIndexTag (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    PPAGE_CACHE_ENTRY Entry,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine clears a tag from the entry at the given page index. Nothing
+    happens if the given entry is not the one at the given page index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index of the entry to untag.
+
+    Entry - Supplies a pointer to the page cache entry expected to be at the
+        given page index.
+
+    Tag - Supplies the tag to clear.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Node;
+    RUNLEVEL OldRunLevel;
+    ULONGLONG SlotMask;
+
+    ASSERT(Tag < PAGE_CACHE_TAG_COUNT);
+
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    KeAcquireSpinLock(&(Index->Lock));
+    Node = IopFindPageCacheIndexLeaf(Index, PageIndex);
+    if ((Node != NULL) &&
+        (Node->Slots[PAGE_CACHE_INDEX_SLOT(Node, PageIndex)] == Entry)) {
+
+        SlotMask = 1ULL << PAGE_CACHE_INDEX_SLOT(Node, PageIndex);
+        while ((Node != NULL) && ((Node->Tags[Tag] & SlotMask) != 0)) {
+            Node->Tags[Tag] &= ~SlotMask;
+            if (Node->Tags[Tag] != 0) {
+                break;
+            }
+
+            SlotMask = 1ULL << Node->ParentSlot;
+            Node = Node->Parent;
+        }
+    }
+
+    KeReleaseSpinLock(&(Index->Lock));
+    KeLowerRunLevel(OldRunLevel);
+    return;
+}
+
+BOOL
+IopGetPageCacheIndexTag (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether the entry at the given page index has the
+    given tag. The result is only a snapshot unless the caller synchronizes
+    with whoever sets and clears the tag.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index of the entry to query.
+
+    Tag - Supplies the tag to query.
+
+Return Value:
+
+    TRUE if the entry is tagged.
+
+    FALSE if the entry is not tagged or there is no entry.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Node;
+    ULONG Slot;
+
+    ASSERT(Tag < PAGE_CACHE_TAG_COUNT);
+
+    Node = IopFindPageCacheIndexLeaf(Index, PageIndex);
+    if (Node == NULL) {
+        return FALSE;
+    }
+
+    Slot = PAGE_CACHE_INDEX_SLOT(Node, PageIndex);
+    if ((Node->Tags[Tag] & (1ULL << Slot)) != 0) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+BOOL
+IopIsPageCacheIndexTagged (
+    PPAGE_CACHE_INDEX Index,
+    ULONG Tag
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether any entry in the index has the given tag.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    Tag - Supplies the tag to query.
+
+Return Value:
+
+    TRUE if some entry is tagged.
+
+    FALSE if no entries are tagged.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Root;
+
+    ASSERT(Tag < PAGE_CACHE_TAG_COUNT);
+
+    Root = Index->Root;
+    if ((Root != NULL) && (Root->Tags[Tag] != 0)) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+VOID
+IopBeginPageCacheIndexUpdate (
+    PPAGE_CACHE_INDEX Index
+    )
+
+/*++
+
+Routine Description:
+
+    This routine marks the start of a change to the data cached by the index,
+    such as a write or a truncate. Lockless readers that overlap with the
+    update will notice and fall back to acquiring the file object lock. The
+    caller must hold the owning file object lock exclusive.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldSequence;
+
+    OldSequence = RtlAtomicAdd32(&(Index->Sequence), 1);
+
+    ASSERT((OldSequence & 0x1) == 0);
+
+    return;
+}
+
+VOID
+IopEndPageCacheIndexUpdate (
+    PPAGE_CACHE_INDEX Index
+    )
+
+/*++
+
+Routine Description:
+
+    This routine marks the end of a change to the data cached by the index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldSequence;
+
+    OldSequence = RtlAtomicAdd32(&(Index->Sequence), 1);
+
+    ASSERT((OldSequence & 0x1) != 0);
+
+    return;
+}
+
+RUNLEVEL
+IopBeginLocklessPageCacheLookup (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine enters a lockless lookup section. Page cache entries and index
+    nodes seen inside the section are not freed until the section ends. The
+    section runs at dispatch level, so it must be short and must not touch
+    paged memory.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the previous run level, which must be passed to the end routine.
+
+--*/
+
+{
+
+    RUNLEVEL OldRunLevel;
+    PPAGE_CACHE_LOOKUP_STATE State;
+
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    State = &(IoPageCacheLookupStates[KeGetCurrentProcessorNumber()]);
+
+    ASSERT((State->Sequence & 0x1) == 0);
+
+    State->Sequence += 1;
+    RtlMemoryBarrier();
+    return OldRunLevel;
+}
+
+VOID
+IopEndLocklessPageCacheLookup (
+    RUNLEVEL OldRunLevel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine leaves a lockless lookup section.
+
+Arguments:
+
+    OldRunLevel - Supplies the run level returned when the section began.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPAGE_CACHE_LOOKUP_STATE State;
+
+    State = &(IoPageCacheLookupStates[KeGetCurrentProcessorNumber()]);
+
+    ASSERT((State->Sequence & 0x1) != 0);
+
+    RtlMemoryBarrier();
+    State->Sequence += 1;
+    KeLowerRunLevel(OldRunLevel);
+    return;
+}
+
+VOID
+IopSynchronizeLocklessPageCacheLookups (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits until every lockless lookup section that was active when
+    this routine was called has ended. Anything unpublished from an index
+    before this call can be freed once it returns.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Processor;
+    ULONG Sequence;
+    PPAGE_CACHE_LOOKUP_STATE State;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    RtlMemoryBarrier();
+    for (Processor = 0;
+         Processor < IoPageCacheLookupStateCount;
+         Processor += 1) {
+
+        State = &(IoPageCacheLookupStates[Processor]);
+        Sequence = State->Sequence;
+        if ((Sequence & 0x1) != 0) {
+            while (State->Sequence == Sequence) {
+                ArProcessorYield();
+            }
+        }
+    }
+
+    RtlMemoryBarrier();
+    return;
+}
+
+VOID
+IopReclaimPageCacheIndexNodes (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees any index nodes that were pruned from their trees, once
+    lockless lookups that might still see them have drained.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LIST_ENTRY LocalList;
+    PPAGE_CACHE_INDEX_NODE Node;
+    RUNLEVEL OldRunLevel;
+
+    if (LIST_EMPTY(&IoPageCacheIndexFreeList)) {
+        return;
+    }
+
+    INITIALIZE_LIST_HEAD(&LocalList);
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    KeAcquireSpinLock(&IoPageCacheIndexFreeListLock);
+    if (!LIST_EMPTY(&IoPageCacheIndexFreeList)) {
+        MOVE_LIST(&IoPageCacheIndexFreeList, &LocalList);
+        INITIALIZE_LIST_HEAD(&IoPageCacheIndexFreeList);
+    }
+
+    KeReleaseSpinLock(&IoPageCacheIndexFreeListLock);
+    KeLowerRunLevel(OldRunLevel);
+    if (LIST_EMPTY(&LocalList)) {
+        return;
+    }
+
+    IopSynchronizeLocklessPageCacheLookups();
+    while (!LIST_EMPTY(&LocalList)) {
+        Node = LIST_VALUE(LocalList.Next,
+                          PAGE_CACHE_INDEX_NODE,
+                          FreeListEntry);
+
+        LIST_REMOVE(&(Node->FreeListEntry));
+        MmFreeBlock(IoPageCacheIndexNodeAllocator, Node);
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+PPAGE_CACHE_INDEX_NODE
+IopCreatePageCacheIndexNode (
+    ULONG Shift
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates and initializes an empty index node.
+
+Arguments:
+
+    Shift - Supplies the shift of the node.
+
+Return Value:
+
+    Returns a pointer to the new node on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Node;
+
+    Node = MmAllocateBlock(IoPageCacheIndexNodeAllocator, NULL);
+    if (Node == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(Node, sizeof(PAGE_CACHE_INDEX_NODE));
+    Node->Shift = Shift;
+    return Node;
+}
+
+PPAGE_CACHE_INDEX_NODE
+IopFindPageCacheIndexLeaf (
+    PPAGE_CACHE_INDEX Index,
+    ULONGLONG PageIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the leaf node that holds the given page index.
+
+Arguments:
+
+    Index - Supplies a pointer to the page cache index.
+
+    PageIndex - Supplies the page index to find.
+
+Return Value:
+
+    Returns a pointer to the leaf node on success.
+
+    NULL if the path to the leaf does not exist.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Node;
+
+    Node = Index->Root;
+    if ((Node == NULL) || (PAGE_CACHE_INDEX_BEYOND_ROOT(Node, PageIndex))) {
+        return NULL;
+    }
+
+    while ((Node != NULL) && (Node->Shift != 0)) {
+        Node = Node->Slots[PAGE_CACHE_INDEX_SLOT(Node, PageIndex)];
+    }
+
+    return Node;
+}
+
+VOID
+IopDeferPageCacheIndexNodeFree (
+    PLIST_ENTRY NodeList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues a list of pruned index nodes to be freed after
+    lockless lookups drain. This routine must be called at dispatch level.
+
+Arguments:
+
+    NodeList - Supplies a pointer to the head of the list of nodes.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(KeGetRunLevel() == RunLevelDispatch);
+
+    KeAcquireSpinLock(&IoPageCacheIndexFreeListLock);
+    APPEND_LIST(NodeList, &IoPageCacheIndexFreeList);
+    KeReleaseSpinLock(&IoPageCacheIndexFreeListLock);
+    return;
+}
+
+VOID
+IopFreePageCacheIndexSubtree (
+    PPAGE_CACHE_INDEX_NODE Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine immediately frees an index node and all nodes beneath it. It
+    must only be called on nodes that cannot be seen by lockless lookups.
+
+Arguments:
+
+    Node - Supplies a pointer to the top of the subtree to free.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPAGE_CACHE_INDEX_NODE Child;
+    PPAGE_CACHE_INDEX_NODE Parent;
+    ULONG Slot;
+
+    //
+    // Walk the subtree without recursion, freeing children before parents.
+    // Slots are nulled out as children are freed so that revisiting a parent
+    // picks up where it left off.
+    //
+
+    while (Node != NULL) {
+        Child = NULL;
+        if (Node->Shift != 0) {
+            for (Slot = 0; Slot < PAGE_CACHE_INDEX_SLOTS; Slot += 1) {
+                if (Node->Slots[Slot] != NULL) {
+                    Child = Node->Slots[Slot];
+                    Node->Slots[Slot] = NULL;
+                    break;
+                }
+            }
+        }
+
+        if (Child != NULL) {
+            Node = Child;
+            continue;
+        }
+
+        ASSERT((Node->Shift != 0) || (Node->Count == 0));
+
+        Parent = Node->Parent;
+        MmFreeBlock(IoPageCacheIndexNodeAllocator, Node);
+        Node = Parent;
+    }
+
+    return;
+}
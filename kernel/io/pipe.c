@@ -13,7 +13,10 @@ Module Name:
 
 Abstract:
 
-    This module implements support for pipes.
+    This module implements support for pipes. Pipe data lives in a ring of
+    page sized buffers. Each buffer either holds a page owned by the pipe that
+    writes are copied into, or an I/O buffer describing pages spliced in from
+    user memory, the page cache, or another pipe.
 
 Author:
 
@@ -48,12 +51,86 @@ Module Name:
 
 #define PIPE_FLAG_OBJECT_NAMED 0x00000001
 
+//
+// This flag is set while a splice has the head of the buffer ring checked
+// out and is writing it to another handle without the pipe lock held. Other
+// readers wait until it is done.
+//
+
+#define PIPE_FLAG_READ_BUSY 0x00000002
+
+//
+// This flag is set while a splice has reserved free slots at the tail of the
+// buffer ring and is reading into them without the pipe lock held. Other
+// writers wait until it is done.
+//
+
+#define PIPE_FLAG_WRITE_BUSY 0x00000004
+
+//
+// Define the number of pages in a new pipe's buffer ring.
+//
+
+#define PIPE_DEFAULT_PAGE_COUNT 16
+
+//
+// Define the largest buffer that can be requested for a pipe without the
+// resources permission.
+//
+
+#define PIPE_MAX_USER_SIZE (1024 * _1KB)
+
+//
+// Define the absolute maximum number of pages in a pipe's buffer ring.
+//
+
+#define PIPE_MAX_PAGE_COUNT 0x10000
+
+//
+// This macro returns a pointer to the pipe buffer at the given index, relative
+// to the oldest buffer in the ring.
+//
+
+#define PIPE_GET_BUFFER(_Pipe, _Index) \
+    (&((_Pipe)->Buffers[((_Pipe)->Head + (_Index)) & \
+                        ((_Pipe)->BufferCount - 1)]))
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
 /*++
 
+Structure Description:
+
+    This structure defines one page sized slot in a pipe's buffer ring.
+
+Members:
+
+    Page - Stores an optional pointer to a page owned by the pipe. If there is
+        no I/O buffer, the slot's data lives here. The page is kept when the
+        slot is drained so that later writes do not need to allocate.
+
+    IoBuffer - Stores an optional pointer to an I/O buffer holding pages that
+        were spliced into the pipe. The pipe owns the I/O buffer and frees it
+        once its data has been consumed.
+
+    Offset - Stores the offset of the first unread byte within the page or
+        I/O buffer.
+
+    Size - Stores the number of unread bytes in the slot.
+
+--*/
+
+typedef struct _PIPE_BUFFER {
+    PVOID Page;
+    PIO_BUFFER IoBuffer;
+    ULONG Offset;
+    ULONG Size;
+} PIPE_BUFFER, *PPIPE_BUFFER;
+
+/*++
+
 Structure Description:
 
     This structure defines a data pipe.
@@ -62,9 +139,22 @@ Structure Description:
 
     Header - Stores the standard object header.
 
-    Flags - Stores the flags used when the pipe was created.
+    Flags - Stores a bitmask of PIPE_FLAG_* definitions. The busy flags are
+        protected by the pipe lock.
+
+    Lock - Stores a pointer to the lock serializing access to the buffer ring.
+
+    IoState - Stores a pointer to the I/O object state of the pipe's file
+        object.
 
-    StreamBuffer - Stores a pointer to the stream buffer backing the pipe.
+    Buffers - Stores the array of slots making up the buffer ring.
+
+    BufferCount - Stores the number of slots in the ring. This is always a
+        power of two.
+
+    Head - Stores the index of the oldest occupied slot in the ring.
+
+    Occupied - Stores the number of slots holding unread data.
 
     ReaderCount - Stores the number of readers that have the pipe open.
 
@@ -75,7 +165,12 @@ Structure Description:
 typedef struct _PIPE {
     OBJECT_HEADER Header;
     ULONG Flags;
-    PSTREAM_BUFFER StreamBuffer;
+    PQUEUED_LOCK Lock;
+    PIO_OBJECT_STATE IoState;
+    PPIPE_BUFFER Buffers;
+    ULONG BufferCount;
+    ULONG Head;
+    ULONG Occupied;
     ULONG ReaderCount;
     ULONG WriterCount;
 } PIPE, *PPIPE;
@@ -106,6 +201,96 @@ IopDestroyPipe (
     PVOID PipeObject
     );
 
+KSTATUS
+IopReadPipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN ByteCount,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking,
+    PUINTN BytesRead
+    );
+
+KSTATUS
+IopWritePipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN ByteCount,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking,
+    PUINTN BytesWritten
+    );
+
+KSTATUS
+IopSplicePipeToPipe (
+    PIO_HANDLE Input,
+    PIO_HANDLE Output,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    );
+
+KSTATUS
+IopWaitForPipeData (
+    PPIPE Pipe,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking
+    );
+
+KSTATUS
+IopWaitForPipeSpace (
+    PPIPE Pipe,
+    UINTN Required,
+    BOOL WholePage,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking
+    );
+
+KSTATUS
+IopCopyToPipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    UINTN Size,
+    PUINTN BytesCopied
+    );
+
+KSTATUS
+IopCopyFromPipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    UINTN Size,
+    PUINTN BytesCopied
+    );
+
+PVOID
+IopGetPipeBufferPage (
+    PPIPE_BUFFER Buffer
+    );
+
+VOID
+IopConsumePipeBuffer (
+    PPIPE Pipe,
+    UINTN Size
+    );
+
+UINTN
+IopGetPipeFreeSpace (
+    PPIPE Pipe
+    );
+
+VOID
+IopUpdatePipeEvents (
+    PPIPE Pipe
+    );
+
+ULONG
+IopGetSpliceTimeout (
+    PIO_HANDLE Handle,
+    ULONG Flags
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -380,17 +565,35 @@ Return Value:
     //
 
     ASSERT((*FileObject)->IoState != NULL);
+    ASSERT(MmPageSize() >= PIPE_ATOMIC_WRITE_SIZE);
+
+    NewPipe->Lock = KeCreateQueuedLock();
+    if (NewPipe->Lock == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreatePipeEnd;
+    }
+
+    //
+    // Only the slot array is allocated up front. Pages are allocated as
+    // writes first need them.
+    //
 
-    NewPipe->StreamBuffer = IoCreateStreamBuffer((*FileObject)->IoState,
-                                                 0,
-                                                 0,
-                                                 PIPE_ATOMIC_WRITE_SIZE);
+    NewPipe->Buffers = MmAllocatePagedPool(
+                              sizeof(PIPE_BUFFER) * PIPE_DEFAULT_PAGE_COUNT,
+                              IO_ALLOCATION_TAG);
 
-    if (NewPipe->StreamBuffer == NULL) {
+    if (NewPipe->Buffers == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto CreatePipeEnd;
     }
 
+    RtlZeroMemory(NewPipe->Buffers,
+                  sizeof(PIPE_BUFFER) * PIPE_DEFAULT_PAGE_COUNT);
+
+    NewPipe->BufferCount = PIPE_DEFAULT_PAGE_COUNT;
+    NewPipe->IoState = (*FileObject)->IoState;
+    IoSetIoObjectState(NewPipe->IoState, POLL_EVENT_OUT, TRUE);
+
     //
     // Now that the pipe's ready, release anyone else who happened to find this
     // file object in the mean time.
@@ -529,7 +732,7 @@ Return Value:
         goto OpenPipeEnd;
     }
 
-    IoState = IoStreamBufferGetIoObjectState(Pipe->StreamBuffer);
+    IoState = Pipe->IoState;
     if ((IoHandle->Access & IO_ACCESS_READ) != 0) {
         Pipe->ReaderCount += 1;
 
@@ -622,11 +825,9 @@ Return Value:
     // properly.
     //
 
-    Status = IoStreamBufferConnect(Pipe->StreamBuffer);
-    if (!KSUCCESS(Status)) {
-        goto OpenPipeEnd;
-    }
-
+    KeAcquireQueuedLock(Pipe->Lock);
+    IopUpdatePipeEvents(Pipe);
+    KeReleaseQueuedLock(Pipe->Lock);
     Status = STATUS_SUCCESS;
 
 OpenPipeEnd:
@@ -677,7 +878,7 @@ Return Value:
     KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
     LockHeld = TRUE;
     Pipe = FileObject->SpecialIo;
-    IoState = IoStreamBufferGetIoObjectState(Pipe->StreamBuffer);
+    IoState = Pipe->IoState;
     if ((IoHandle->Access & IO_ACCESS_READ) != 0) {
         Pipe->ReaderCount -= 1;
         if (Pipe->ReaderCount == 0) {
@@ -789,12 +990,12 @@ Return Value:
             Status = STATUS_BROKEN_PIPE;
 
         } else {
-            Status = IoWriteStreamBuffer(Pipe->StreamBuffer,
-                                         IoContext->IoBuffer,
-                                         IoContext->SizeInBytes,
-                                         IoContext->TimeoutInMilliseconds,
-                                         NonBlocking,
-                                         &PipeBytesCompleted);
+            Status = IopWritePipe(Pipe,
+                                  IoContext->IoBuffer,
+                                  IoContext->SizeInBytes,
+                                  IoContext->TimeoutInMilliseconds,
+                                  NonBlocking,
+                                  &PipeBytesCompleted);
         }
 
     } else {
@@ -802,14 +1003,21 @@ Return Value:
             NonBlocking = TRUE;
         }
 
-        Status = IoReadStreamBuffer(Pipe->StreamBuffer,
-                                    IoContext->IoBuffer,
-                                    IoContext->SizeInBytes,
-                                    IoContext->TimeoutInMilliseconds,
-                                    NonBlocking,
-                                    &PipeBytesCompleted);
+        Status = IopReadPipe(Pipe,
+                             IoContext->IoBuffer,
+                             IoContext->SizeInBytes,
+                             IoContext->TimeoutInMilliseconds,
+                             NonBlocking,
+                             &PipeBytesCompleted);
+
+        //
+        // A disconnected pipe can still report try again if a splice was
+        // holding the remaining data.
+        //
 
-        if ((Status == STATUS_TRY_AGAIN) && (Pipe->WriterCount == 0)) {
+        if ((Status == STATUS_TRY_AGAIN) &&
+            (Pipe->WriterCount == 0) &&
+            (Pipe->Occupied == 0)) {
 
             ASSERT(PipeBytesCompleted == 0);
 
@@ -821,40 +1029,1772 @@ Return Value:
     return Status;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
+KSTATUS
+IopGetSetPipeSize (
+    PIO_HANDLE Handle,
+    BOOL Set,
+    PULONG Size
+    )
 
-VOID
-IopDestroyPipe (
-    PVOID PipeObject
+/*++
+
+Routine Description:
+
+    This routine gets or sets the size of a pipe's buffer.
+
+Arguments:
+
+    Handle - Supplies a pointer to an open handle to the pipe.
+
+    Set - Supplies a boolean indicating whether to set the buffer size (TRUE)
+        or just get it (FALSE).
+
+    Size - Supplies a pointer that on input contains the requested buffer size
+        in bytes for set operations. The size is rounded up to a power of two
+        number of pages. On output, contains the size of the buffer.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_HANDLE if the handle is not a pipe.
+
+    STATUS_PERMISSION_DENIED if the caller asked for more than an unprivileged
+    pipe may hold and does not have the resources permission.
+
+    STATUS_RESOURCE_IN_USE if the pipe holds more data than would fit in the
+    requested size, or a splice is in the middle of moving data through it.
+
+--*/
+
+{
+
+    ULONG Index;
+    PPIPE_BUFFER NewBuffers;
+    ULONG NewCount;
+    PPIPE_BUFFER OldBuffer;
+    ULONG PageCount;
+    ULONG PageShift;
+    ULONG PageSize;
+    PPIPE Pipe;
+    ULONG SpareIndex;
+    KSTATUS Status;
+
+    if (Handle->FileObject->Properties.Type != IoObjectPipe) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    Pipe = Handle->FileObject->SpecialIo;
+    PageSize = MmPageSize();
+    PageShift = MmPageShift();
+    if (Set == FALSE) {
+        KeAcquireQueuedLock(Pipe->Lock);
+        *Size = Pipe->BufferCount << PageShift;
+        KeReleaseQueuedLock(Pipe->Lock);
+        return STATUS_SUCCESS;
+    }
+
+    if (*Size > (PIPE_MAX_PAGE_COUNT << PageShift)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    PageCount = ALIGN_RANGE_UP(*Size, PageSize) >> PageShift;
+    NewCount = 1;
+    while (NewCount < PageCount) {
+        NewCount <<= 1;
+    }
+
+    if ((NewCount << PageShift) > PIPE_MAX_USER_SIZE) {
+        Status = PsCheckPermission(PERMISSION_RESOURCES);
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+    }
+
+    NewBuffers = MmAllocatePagedPool(sizeof(PIPE_BUFFER) * NewCount,
+                                     IO_ALLOCATION_TAG);
+
+    if (NewBuffers == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(NewBuffers, sizeof(PIPE_BUFFER) * NewCount);
+    KeAcquireQueuedLock(Pipe->Lock);
+    if ((Pipe->Occupied > NewCount) ||
+        ((Pipe->Flags & (PIPE_FLAG_READ_BUSY | PIPE_FLAG_WRITE_BUSY)) != 0)) {
+
+        KeReleaseQueuedLock(Pipe->Lock);
+        MmFreePagedPool(NewBuffers);
+        return STATUS_RESOURCE_IN_USE;
+    }
+
+    //
+    // Move the occupied slots to the front of the new ring, then carry over
+    // as many spare pages as there is room for.
+    //
+
+    for (Index = 0; Index < Pipe->Occupied; Index += 1) {
+        OldBuffer = PIPE_GET_BUFFER(Pipe, Index);
+        NewBuffers[Index] = *OldBuffer;
+        RtlZeroMemory(OldBuffer, sizeof(PIPE_BUFFER));
+    }
+
+    SpareIndex = Pipe->Occupied;
+    for (Index = 0; Index < Pipe->BufferCount; Index += 1) {
+        OldBuffer = &(Pipe->Buffers[Index]);
+        if (OldBuffer->Page == NULL) {
+            continue;
+        }
+
+        ASSERT((OldBuffer->IoBuffer == NULL) && (OldBuffer->Size == 0));
+
+        while ((SpareIndex < NewCount) &&
+               (NewBuffers[SpareIndex].Page != NULL)) {
+
+            SpareIndex += 1;
+        }
+
+        if (SpareIndex < NewCount) {
+            NewBuffers[SpareIndex].Page = OldBuffer->Page;
+
+        } else {
+            MmFreePagedPool(OldBuffer->Page);
+        }
+    }
+
+    MmFreePagedPool(Pipe->Buffers);
+    Pipe->Buffers = NewBuffers;
+    Pipe->BufferCount = NewCount;
+    Pipe->Head = 0;
+    if ((Pipe->IoState->Events & POLL_ERROR_EVENTS) == 0) {
+        IopUpdatePipeEvents(Pipe);
+    }
+
+    KeReleaseQueuedLock(Pipe->Lock);
+    *Size = NewCount << PageShift;
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopSpliceFromPipe (
+    PIO_HANDLE Input,
+    PIO_HANDLE Output,
+    PIO_OFFSET OutputOffset,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
     )
 
 /*++
 
 Routine Description:
 
-    This routine destroys all resources associated with a pipe.
+    This routine moves data out of a pipe and into another handle. If the
+    output is also a pipe, whole pages are handed from one pipe to the other
+    without being copied. Otherwise each page is written to the output
+    directly from the pipe's buffer ring.
 
 Arguments:
 
-    PipeObject - Supplies a pointer to the pipe object being destroyed.
+    Input - Supplies a pointer to a handle to the pipe to read from.
+
+    Output - Supplies a pointer to the handle to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset to write to in
+        the output. On return, this is advanced by the number of bytes
+        written. If this is NULL, the output's current file position is used.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
 
 Return Value:
 
-    None.
+    Status code. STATUS_END_OF_FILE is returned if the pipe is empty and has
+    no writers.
 
 --*/
 
 {
 
+    PPIPE_BUFFER Buffer;
+    UINTN BytesThisRound;
+    UINTN BytesWritten;
+    IO_BUFFER LocalIoBuffer;
+    BOOL NonBlocking;
+    IO_OFFSET Offset;
     PPIPE Pipe;
+    KSTATUS Status;
+    ULONG Timeout;
+    PIO_BUFFER WriteBuffer;
 
-    Pipe = (PPIPE)PipeObject;
-    if (Pipe->StreamBuffer != NULL) {
-        IoDestroyStreamBuffer(Pipe->StreamBuffer);
+    *BytesSpliced = 0;
+
+    ASSERT(Input->FileObject->Properties.Type == IoObjectPipe);
+
+    if ((Input->Access & IO_ACCESS_READ) == 0) {
+        return STATUS_INVALID_HANDLE;
     }
 
-    return;
+    if (Output->FileObject->Properties.Type == IoObjectPipe) {
+
+        ASSERT(OutputOffset == NULL);
+
+        return IopSplicePipeToPipe(Input, Output, Size, Flags, BytesSpliced);
+    }
+
+    Pipe = Input->FileObject->SpecialIo;
+    NonBlocking = FALSE;
+    if (Pipe->WriterCount == 0) {
+        NonBlocking = TRUE;
+    }
+
+    Status = IopWaitForPipeData(Pipe,
+                                IopGetSpliceTimeout(Input, Flags),
+                                NonBlocking);
+
+    if (!KSUCCESS(Status)) {
+        if ((Status == STATUS_TRY_AGAIN) &&
+            (Pipe->WriterCount == 0) &&
+            (Pipe->Occupied == 0)) {
+
+            Status = STATUS_END_OF_FILE;
+        }
+
+        return Status;
+    }
+
+    //
+    // Write each slot straight out of the ring. Mark the head of the ring
+    // busy so that other readers keep out of it, and drop the pipe lock
+    // around each write so that writers can keep filling the tail.
+    //
+
+    Pipe->Flags |= PIPE_FLAG_READ_BUSY;
+    Timeout = IopGetSpliceTimeout(Output, Flags);
+    Offset = IO_OFFSET_NONE;
+    if (OutputOffset != NULL) {
+        Offset = *OutputOffset;
+    }
+
+    while ((Size != 0) && (Pipe->Occupied != 0)) {
+        Buffer = PIPE_GET_BUFFER(Pipe, 0);
+        BytesThisRound = Buffer->Size;
+        if (BytesThisRound > Size) {
+            BytesThisRound = Size;
+        }
+
+        if (Buffer->IoBuffer != NULL) {
+            WriteBuffer = Buffer->IoBuffer;
+            MmSetIoBufferCurrentOffset(WriteBuffer, Buffer->Offset);
+
+        } else {
+            WriteBuffer = &LocalIoBuffer;
+            Status = MmInitializeIoBuffer(WriteBuffer,
+                                          Buffer->Page + Buffer->Offset,
+                                          INVALID_PHYSICAL_ADDRESS,
+                                          BytesThisRound,
+                                          IO_BUFFER_FLAG_KERNEL_MODE_DATA);
+
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+        }
+
+        //
+        // Writers only ever append, so the head slot stays put while the
+        // lock is dropped.
+        //
+
+        KeReleaseQueuedLock(Pipe->Lock);
+        Status = IoWriteAtOffset(Output,
+                                 WriteBuffer,
+                                 Offset,
+                                 BytesThisRound,
+                                 0,
+                                 Timeout,
+                                 &BytesWritten,
+                                 NULL);
+
+        KeAcquireQueuedLock(Pipe->Lock);
+        if (Buffer->IoBuffer != NULL) {
+            MmSetIoBufferCurrentOffset(Buffer->IoBuffer, 0);
+
+        } else {
+            MmFreeIoBuffer(WriteBuffer);
+        }
+
+        IopConsumePipeBuffer(Pipe, BytesWritten);
+        *BytesSpliced += BytesWritten;
+        Size -= BytesWritten;
+        if (Offset != IO_OFFSET_NONE) {
+            Offset += BytesWritten;
+        }
+
+        if ((!KSUCCESS(Status)) || (BytesWritten != BytesThisRound)) {
+            break;
+        }
+    }
+
+    Pipe->Flags &= ~PIPE_FLAG_READ_BUSY;
+    if ((Pipe->IoState->Events & POLL_ERROR_EVENTS) == 0) {
+        IopUpdatePipeEvents(Pipe);
+    }
+
+    KeReleaseQueuedLock(Pipe->Lock);
+    if (OutputOffset != NULL) {
+        *OutputOffset = Offset;
+    }
+
+    if (*BytesSpliced != 0) {
+        Status = STATUS_SUCCESS;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopSpliceToPipe (
+    PIO_HANDLE Input,
+    PIO_OFFSET InputOffset,
+    PIO_HANDLE Output,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves data from a handle that is not a pipe into a pipe. If
+    the input is a cacheable file, references to its page cache entries are
+    placed in the pipe rather than copies of them. Other inputs are read
+    directly into the pipe's own pages.
+
+Arguments:
+
+    Input - Supplies a pointer to the handle to read from.
+
+    InputOffset - Supplies an optional pointer to the offset to read from in
+        the input. On return, this is advanced by the number of bytes read. If
+        this is NULL, the input's current file position is used and updated.
+
+    Output - Supplies a pointer to a handle to the pipe to write to.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PPIPE_BUFFER Buffer;
+    UINTN BytesRead;
+    UINTN BytesThisRound;
+    ULONG ByteOffset;
+    BOOL Cacheable;
+    UINTN DataOffset;
+    UINTN FreeSize;
+    ULONG Index;
+    PIO_BUFFER IoBuffer;
+    PVOID PageCacheEntry;
+    ULONG PageOffset;
+    ULONG PageSize;
+    PPIPE Pipe;
+    IO_OFFSET ReadOffset;
+    UINTN ReadSize;
+    PIO_BUFFER SlotBuffer;
+    IO_OFFSET SourceOffset;
+    KSTATUS Status;
+
+    *BytesSpliced = 0;
+
+    ASSERT(Output->FileObject->Properties.Type == IoObjectPipe);
+    ASSERT(Input->FileObject->Properties.Type != IoObjectPipe);
+
+    if ((Output->Access & IO_ACCESS_WRITE) == 0) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    Pipe = Output->FileObject->SpecialIo;
+    if (Pipe->ReaderCount == 0) {
+        return STATUS_BROKEN_PIPE;
+    }
+
+    IoBuffer = NULL;
+    PageSize = MmPageSize();
+    Cacheable = IO_IS_FILE_OBJECT_CACHEABLE(Input->FileObject);
+    SourceOffset = IO_OFFSET_NONE;
+    if (InputOffset != NULL) {
+        SourceOffset = *InputOffset;
+
+    } else if (Cacheable != FALSE) {
+        Status = IoSeek(Input, SeekCommandNop, 0, &SourceOffset);
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+    }
+
+    Status = IopWaitForPipeSpace(Pipe,
+                                 0,
+                                 TRUE,
+                                 IopGetSpliceTimeout(Output, Flags),
+                                 FALSE);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    FreeSize = (Pipe->BufferCount - Pipe->Occupied) * PageSize;
+    if (Size > FreeSize) {
+        Size = FreeSize;
+    }
+
+    //
+    // For cacheable files, read a page aligned region into an empty buffer.
+    // The cached read path fills it with references to the page cache entries
+    // themselves, which are then handed to the pipe's slots.
+    //
+
+    if (Cacheable != FALSE) {
+        ReadOffset = ALIGN_RANGE_DOWN(SourceOffset, PageSize);
+        ByteOffset = (ULONG)(SourceOffset - ReadOffset);
+        ReadSize = ALIGN_RANGE_UP(Size + ByteOffset, PageSize);
+        if (ReadSize > FreeSize) {
+            ReadSize = FreeSize;
+        }
+
+        IoBuffer = MmAllocateUninitializedIoBuffer(ReadSize, 0);
+
+    //
+    // Other inputs may not be able to give data back, so make sure every slot
+    // that could be filled has a page before anything is read. The data is
+    // then copied once, from the read buffer into those pages.
+    //
+
+    } else {
+        ReadOffset = SourceOffset;
+        ByteOffset = 0;
+        ReadSize = Size;
+        for (Index = 0;
+             Index < ALIGN_RANGE_UP(ReadSize, PageSize) / PageSize;
+             Index += 1) {
+
+            Buffer = PIPE_GET_BUFFER(Pipe, Pipe->Occupied + Index);
+            if (IopGetPipeBufferPage(Buffer) == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+                goto SpliceToPipeEnd;
+            }
+        }
+
+        IoBuffer = MmAllocatePagedIoBuffer(ReadSize, 0);
+    }
+
+    if (IoBuffer == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto SpliceToPipeEnd;
+    }
+
+    //
+    // Reserve the free slots by keeping other writers out, and drop the pipe
+    // lock for the read. Readers only consume from the head of the ring, so
+    // the slots past the occupied ones stay put until they are published.
+    //
+
+    Pipe->Flags |= PIPE_FLAG_WRITE_BUSY;
+    KeReleaseQueuedLock(Pipe->Lock);
+    Status = IoReadAtOffset(Input,
+                            IoBuffer,
+                            ReadOffset,
+                            ReadSize,
+                            0,
+                            IopGetSpliceTimeout(Input, Flags),
+                            &BytesRead,
+                            NULL);
+
+    KeAcquireQueuedLock(Pipe->Lock);
+    if ((!KSUCCESS(Status)) && (BytesRead == 0)) {
+        goto SpliceToPipeEnd;
+    }
+
+    Status = STATUS_SUCCESS;
+    if (BytesRead <= ByteOffset) {
+        goto SpliceToPipeEnd;
+    }
+
+    BytesRead -= ByteOffset;
+    if (BytesRead > Size) {
+        BytesRead = Size;
+    }
+
+    //
+    // Hand the data to the pipe a page at a time.
+    //
+
+    DataOffset = ByteOffset;
+    while (BytesRead != 0) {
+        PageOffset = REMAINDER(DataOffset, PageSize);
+        BytesThisRound = PageSize - PageOffset;
+        if (BytesThisRound > BytesRead) {
+            BytesThisRound = BytesRead;
+        }
+
+        ASSERT(Pipe->Occupied < Pipe->BufferCount);
+
+        Buffer = PIPE_GET_BUFFER(Pipe, Pipe->Occupied);
+
+        ASSERT((Buffer->IoBuffer == NULL) && (Buffer->Size == 0));
+
+        PageCacheEntry = MmGetIoBufferPageCacheEntry(IoBuffer,
+                                                     DataOffset - PageOffset);
+
+        if (PageCacheEntry != NULL) {
+            SlotBuffer = MmAllocateUninitializedIoBuffer(PageSize, 0);
+            if (SlotBuffer == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+                break;
+            }
+
+            MmIoBufferAppendPage(SlotBuffer,
+                                 PageCacheEntry,
+                                 NULL,
+                                 INVALID_PHYSICAL_ADDRESS);
+
+            Buffer->IoBuffer = SlotBuffer;
+            Buffer->Offset = PageOffset;
+
+        } else {
+            if (IopGetPipeBufferPage(Buffer) == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+                break;
+            }
+
+            Status = MmCopyIoBufferData(IoBuffer,
+                                        Buffer->Page,
+                                        DataOffset,
+                                        BytesThisRound,
+                                        FALSE);
+
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+
+            Buffer->Offset = 0;
+        }
+
+        Buffer->Size = BytesThisRound;
+        Pipe->Occupied += 1;
+        DataOffset += BytesThisRound;
+        BytesRead -= BytesThisRound;
+        *BytesSpliced += BytesThisRound;
+    }
+
+    //
+    // Report a partial transfer as success. Only seekable inputs can have
+    // bytes left over here, and those get read again next time.
+    //
+
+    if (*BytesSpliced != 0) {
+        Status = STATUS_SUCCESS;
+        if (InputOffset != NULL) {
+            *InputOffset = SourceOffset + *BytesSpliced;
+
+        } else if (Cacheable != FALSE) {
+            IoSeek(Input,
+                   SeekCommandFromBeginning,
+                   SourceOffset + *BytesSpliced,
+                   NULL);
+        }
+    }
+
+SpliceToPipeEnd:
+    Pipe->Flags &= ~PIPE_FLAG_WRITE_BUSY;
+    IopUpdatePipeEvents(Pipe);
+    KeReleaseQueuedLock(Pipe->Lock);
+    if (IoBuffer != NULL) {
+        MmFreeIoBuffer(IoBuffer);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopSpliceMemoryToPipe (
+    PIO_HANDLE Output,
+    PIO_BUFFER UserBuffer,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    )
+
+/*++
+
+Routine Description:
+
+    This routine places user mode memory into a pipe without copying it. The
+    pages are locked and referenced by the pipe until they are read out, so
+    the caller must not modify them until then.
+
+Arguments:
+
+    Output - Supplies a pointer to a handle to the pipe to write to.
+
+    UserBuffer - Supplies a pointer to an I/O buffer describing the current
+        process' user mode memory to splice.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes placed in the
+        pipe will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PVOID Address;
+    PPIPE_BUFFER Buffer;
+    UINTN BytesThisRound;
+    PIO_BUFFER_FRAGMENT Fragment;
+    UINTN FragmentIndex;
+    UINTN FragmentSize;
+    PIO_BUFFER LockedBuffer;
+    ULONG PageSize;
+    PPIPE Pipe;
+    KSTATUS Status;
+    ULONG Timeout;
+
+    *BytesSpliced = 0;
+    if (Output->FileObject->Properties.Type != IoObjectPipe) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    if ((Output->Access & IO_ACCESS_WRITE) == 0) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    Pipe = Output->FileObject->SpecialIo;
+    if (Pipe->ReaderCount == 0) {
+        return STATUS_BROKEN_PIPE;
+    }
+
+    ASSERT(MmIsIoBufferUserMode(UserBuffer) != FALSE);
+
+    PageSize = MmPageSize();
+    Timeout = IopGetSpliceTimeout(Output, Flags);
+    Status = STATUS_SUCCESS;
+    for (FragmentIndex = 0;
+         FragmentIndex < UserBuffer->FragmentCount;
+         FragmentIndex += 1) {
+
+        Fragment = &(UserBuffer->Fragment[FragmentIndex]);
+        Address = Fragment->VirtualAddress;
+        FragmentSize = Fragment->Size;
+        while (FragmentSize != 0) {
+
+            //
+            // Each slot gets the part of one user page. Lock it down before
+            // taking the pipe lock, as this may need to page it in.
+            //
+
+            BytesThisRound = PageSize - REMAINDER((UINTN)Address, PageSize);
+            if (BytesThisRound > FragmentSize) {
+                BytesThisRound = FragmentSize;
+            }
+
+            Status = IopLockUserBuffer(Address,
+                                       BytesThisRound,
+                                       FALSE,
+                                       &LockedBuffer);
+
+            if (!KSUCCESS(Status)) {
+                goto SpliceMemoryToPipeEnd;
+            }
+
+            Status = IopWaitForPipeSpace(Pipe, 0, TRUE, Timeout, FALSE);
+            if (!KSUCCESS(Status)) {
+                MmFreeIoBuffer(LockedBuffer);
+                goto SpliceMemoryToPipeEnd;
+            }
+
+            Buffer = PIPE_GET_BUFFER(Pipe, Pipe->Occupied);
+
+            ASSERT((Buffer->IoBuffer == NULL) && (Buffer->Size == 0));
+
+            Buffer->IoBuffer = LockedBuffer;
+            Buffer->Offset = 0;
+            Buffer->Size = BytesThisRound;
+            Pipe->Occupied += 1;
+            IopUpdatePipeEvents(Pipe);
+            KeReleaseQueuedLock(Pipe->Lock);
+            *BytesSpliced += BytesThisRound;
+            Address += BytesThisRound;
+            FragmentSize -= BytesThisRound;
+        }
+    }
+
+SpliceMemoryToPipeEnd:
+    if (*BytesSpliced != 0) {
+        Status = STATUS_SUCCESS;
+    }
+
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopDestroyPipe (
+    PVOID PipeObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys all resources associated with a pipe.
+
+Arguments:
+
+    PipeObject - Supplies a pointer to the pipe object being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPIPE_BUFFER Buffer;
+    ULONG Index;
+    PPIPE Pipe;
+
+    Pipe = (PPIPE)PipeObject;
+    if (Pipe->Buffers != NULL) {
+        for (Index = 0; Index < Pipe->BufferCount; Index += 1) {
+            Buffer = &(Pipe->Buffers[Index]);
+            if (Buffer->IoBuffer != NULL) {
+                MmFreeIoBuffer(Buffer->IoBuffer);
+            }
+
+            if (Buffer->Page != NULL) {
+                MmFreePagedPool(Buffer->Page);
+            }
+        }
+
+        MmFreePagedPool(Pipe->Buffers);
+    }
+
+    if (Pipe->Lock != NULL) {
+        KeDestroyQueuedLock(Pipe->Lock);
+    }
+
+    Pipe->IoState = NULL;
+    return;
+}
+
+KSTATUS
+IopReadPipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN ByteCount,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking,
+    PUINTN BytesRead
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads from a pipe's buffer ring, waiting until at least one
+    byte is available.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe to read from.
+
+    IoBuffer - Supplies a pointer to the I/O buffer where the read data will be
+        returned on success.
+
+    ByteCount - Supplies the number of bytes to read.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that the I/O
+        operation should be waited on before timing out. Use
+        WAIT_TIME_INDEFINITE to wait forever on the I/O.
+
+    NonBlocking - Supplies a boolean indicating if this read should avoid
+        blocking.
+
+    BytesRead - Supplies a pointer where the number of bytes actually read will
+        be returned.
+
+Return Value:
+
+    Status code. If a failing status code is returned, then check the number of
+    bytes read to see if any valid data was returned.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    *BytesRead = 0;
+    Status = IopWaitForPipeData(Pipe, TimeoutInMilliseconds, NonBlocking);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    Status = IopCopyFromPipe(Pipe, IoBuffer, 0, ByteCount, BytesRead);
+
+    //
+    // Don't adjust the events if the error events are set, as this is probably
+    // a disconnected pipe with some data left in it.
+    //
+
+    if ((Pipe->IoState->Events & POLL_ERROR_EVENTS) == 0) {
+        IopUpdatePipeEvents(Pipe);
+    }
+
+    KeReleaseQueuedLock(Pipe->Lock);
+    return Status;
+}
+
+KSTATUS
+IopWritePipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN ByteCount,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking,
+    PUINTN BytesWritten
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data into a pipe's buffer ring. Writes of up to the
+    atomic write size are never interleaved with other writes.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe to write to.
+
+    IoBuffer - Supplies a pointer to the I/O buffer containing the data to
+        write.
+
+    ByteCount - Supplies the number of bytes to write.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that the I/O
+        operation should be waited on before timing out. Use
+        WAIT_TIME_INDEFINITE to wait forever on the I/O.
+
+    NonBlocking - Supplies a boolean indicating if this write should avoid
+        blocking.
+
+    BytesWritten - Supplies a pointer where the number of bytes actually written
+        will be returned.
+
+Return Value:
+
+    Status code. If a failing status code is returned, then check the number of
+    bytes written to see if any valid data was written.
+
+--*/
+
+{
+
+    UINTN BytesThisRound;
+    UINTN Required;
+    KSTATUS Status;
+
+    *BytesWritten = 0;
+    Status = STATUS_SUCCESS;
+    while (ByteCount != 0) {
+        Required = ByteCount;
+        if (Required > PIPE_ATOMIC_WRITE_SIZE) {
+            Required = PIPE_ATOMIC_WRITE_SIZE;
+        }
+
+        Status = IopWaitForPipeSpace(Pipe,
+                                     Required,
+                                     FALSE,
+                                     TimeoutInMilliseconds,
+                                     NonBlocking);
+
+        if (!KSUCCESS(Status)) {
+            if ((Status == STATUS_TRY_AGAIN) && (*BytesWritten != 0)) {
+                Status = STATUS_SUCCESS;
+            }
+
+            break;
+        }
+
+        Status = IopCopyToPipe(Pipe,
+                               IoBuffer,
+                               *BytesWritten,
+                               ByteCount,
+                               &BytesThisRound);
+
+        *BytesWritten += BytesThisRound;
+        ByteCount -= BytesThisRound;
+        IopUpdatePipeEvents(Pipe);
+        KeReleaseQueuedLock(Pipe->Lock);
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopSplicePipeToPipe (
+    PIO_HANDLE Input,
+    PIO_HANDLE Output,
+    UINTN Size,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves data from one pipe to another. Whole slots are moved by
+    swapping their pages or I/O buffers between the two rings, so only a
+    trailing partial slot is ever copied.
+
+Arguments:
+
+    Input - Supplies a pointer to a handle to the pipe to read from.
+
+    Output - Supplies a pointer to a handle to the pipe to write to.
+
+    Size - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN BytesThisRound;
+    PPIPE_BUFFER Destination;
+    PPIPE First;
+    PPIPE InputPipe;
+    BOOL NonBlocking;
+    PPIPE OutputPipe;
+    PVOID Page;
+    PPIPE Second;
+    PPIPE_BUFFER Source;
+    KSTATUS Status;
+
+    *BytesSpliced = 0;
+    InputPipe = Input->FileObject->SpecialIo;
+    OutputPipe = Output->FileObject->SpecialIo;
+    if (InputPipe == OutputPipe) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if ((Output->Access & IO_ACCESS_WRITE) == 0) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    if (OutputPipe->ReaderCount == 0) {
+        return STATUS_BROKEN_PIPE;
+    }
+
+    //
+    // Always acquire the two pipe locks in address order.
+    //
+
+    First = InputPipe;
+    Second = OutputPipe;
+    if ((UINTN)First > (UINTN)Second) {
+        First = OutputPipe;
+        Second = InputPipe;
+    }
+
+    while (TRUE) {
+        NonBlocking = FALSE;
+        if (InputPipe->WriterCount == 0) {
+            NonBlocking = TRUE;
+        }
+
+        Status = IopWaitForPipeData(InputPipe,
+                                    IopGetSpliceTimeout(Input, Flags),
+                                    NonBlocking);
+
+        if (!KSUCCESS(Status)) {
+            if ((Status == STATUS_TRY_AGAIN) &&
+                (InputPipe->WriterCount == 0) &&
+                (InputPipe->Occupied == 0)) {
+
+                Status = STATUS_END_OF_FILE;
+            }
+
+            return Status;
+        }
+
+        KeReleaseQueuedLock(InputPipe->Lock);
+        Status = IopWaitForPipeSpace(OutputPipe,
+                                     0,
+                                     TRUE,
+                                     IopGetSpliceTimeout(Output, Flags),
+                                     FALSE);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        KeReleaseQueuedLock(OutputPipe->Lock);
+        KeAcquireQueuedLock(First->Lock);
+        KeAcquireQueuedLock(Second->Lock);
+        if ((InputPipe->Occupied != 0) &&
+            ((InputPipe->Flags & PIPE_FLAG_READ_BUSY) == 0) &&
+            (OutputPipe->Occupied < OutputPipe->BufferCount) &&
+            ((OutputPipe->Flags & PIPE_FLAG_WRITE_BUSY) == 0)) {
+
+            break;
+        }
+
+        //
+        // Someone else got in between the waits. Go around again.
+        //
+
+        KeReleaseQueuedLock(Second->Lock);
+        KeReleaseQueuedLock(First->Lock);
+    }
+
+    Status = STATUS_SUCCESS;
+    while ((Size != 0) &&
+           (InputPipe->Occupied != 0) &&
+           (OutputPipe->Occupied < OutputPipe->BufferCount)) {
+
+        Source = PIPE_GET_BUFFER(InputPipe, 0);
+        Destination = PIPE_GET_BUFFER(OutputPipe, OutputPipe->Occupied);
+
+        ASSERT((Destination->IoBuffer == NULL) && (Destination->Size == 0));
+
+        //
+        // Move the whole slot if it all fits. Owned pages are swapped so that
+        // the input pipe gets the output's spare page, if it had one.
+        //
+
+        if (Source->Size <= Size) {
+            BytesThisRound = Source->Size;
+            Destination->IoBuffer = Source->IoBuffer;
+            Destination->Offset = Source->Offset;
+            Destination->Size = Source->Size;
+            if (Source->IoBuffer == NULL) {
+                Page = Destination->Page;
+                Destination->Page = Source->Page;
+                Source->Page = Page;
+            }
+
+            Source->IoBuffer = NULL;
+            Source->Offset = 0;
+            Source->Size = 0;
+            InputPipe->Head = (InputPipe->Head + 1) &
+                              (InputPipe->BufferCount - 1);
+
+            InputPipe->Occupied -= 1;
+
+        //
+        // Copy the part of the final slot that was asked for.
+        //
+
+        } else {
+            BytesThisRound = Size;
+            if (IopGetPipeBufferPage(Destination) == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+                break;
+            }
+
+            if (Source->IoBuffer != NULL) {
+                Status = MmCopyIoBufferData(Source->IoBuffer,
+                                            Destination->Page,
+                                            Source->Offset,
+                                            BytesThisRound,
+                                            FALSE);
+
+                if (!KSUCCESS(Status)) {
+                    break;
+                }
+
+            } else {
+                RtlCopyMemory(Destination->Page,
+                              Source->Page + Source->Offset,
+                              BytesThisRound);
+            }
+
+            Destination->Offset = 0;
+            Destination->Size = BytesThisRound;
+            IopConsumePipeBuffer(InputPipe, BytesThisRound);
+        }
+
+        OutputPipe->Occupied += 1;
+        *BytesSpliced += BytesThisRound;
+        Size -= BytesThisRound;
+    }
+
+    if ((InputPipe->IoState->Events & POLL_ERROR_EVENTS) == 0) {
+        IopUpdatePipeEvents(InputPipe);
+    }
+
+    IopUpdatePipeEvents(OutputPipe);
+    KeReleaseQueuedLock(Second->Lock);
+    KeReleaseQueuedLock(First->Lock);
+    if (*BytesSpliced != 0) {
+        Status = STATUS_SUCCESS;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopWaitForPipeData (
+    PPIPE Pipe,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits until a pipe has data in it, and acquires the pipe
+    lock.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe to wait on.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait before
+        timing out. Use WAIT_TIME_INDEFINITE to wait forever.
+
+    NonBlocking - Supplies a boolean indicating if this routine should only
+        check the current state rather than waiting.
+
+Return Value:
+
+    STATUS_SUCCESS if the pipe has data. The pipe lock is held in this case,
+    and the caller is responsible for releasing it.
+
+    STATUS_END_OF_FILE if the pipe is empty and the error events are set.
+
+    STATUS_TRY_AGAIN if the pipe is empty or a splice is reading from it, and
+    this was a non-blocking call.
+
+    Other error codes if the wait failed.
+
+--*/
+
+{
+
+    ULONG EventsMask;
+    ULONG ReturnedEvents;
+    KSTATUS Status;
+
+    EventsMask = POLL_EVENT_IN | POLL_ERROR_EVENTS;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    while (TRUE) {
+        if (NonBlocking == FALSE) {
+            Status = IoWaitForIoObjectState(Pipe->IoState,
+                                            EventsMask,
+                                            TRUE,
+                                            TimeoutInMilliseconds,
+                                            &ReturnedEvents);
+
+            if (!KSUCCESS(Status)) {
+                return Status;
+            }
+
+        } else {
+            ReturnedEvents = Pipe->IoState->Events & EventsMask;
+        }
+
+        //
+        // Multiple threads might have come out of waiting. Acquire the lock
+        // and check again.
+        //
+
+        KeAcquireQueuedLock(Pipe->Lock);
+        if ((Pipe->Flags & PIPE_FLAG_READ_BUSY) != 0) {
+
+            //
+            // A splice is writing out the head of the ring. The in event
+            // stays clear until it is done, unless the pipe is disconnected,
+            // in which case there is nothing to wait on but the splice.
+            //
+
+            if ((Pipe->IoState->Events & POLL_ERROR_EVENTS) == 0) {
+                IoSetIoObjectState(Pipe->IoState, POLL_EVENT_IN, FALSE);
+                KeReleaseQueuedLock(Pipe->Lock);
+                if (NonBlocking != FALSE) {
+                    return STATUS_TRY_AGAIN;
+                }
+
+            } else {
+                KeReleaseQueuedLock(Pipe->Lock);
+                if (TimeoutInMilliseconds == 0) {
+                    return STATUS_TRY_AGAIN;
+                }
+
+                KeYield();
+            }
+
+            continue;
+        }
+
+        if (Pipe->Occupied != 0) {
+            return STATUS_SUCCESS;
+        }
+
+        //
+        // If the IN flag is set, then that would mean this routine is busy
+        // spinning.
+        //
+
+        ASSERT((NonBlocking != FALSE) ||
+               ((Pipe->IoState->Events & POLL_ERROR_EVENTS) != 0) ||
+               ((Pipe->IoState->Events & POLL_EVENT_IN) == 0));
+
+        KeReleaseQueuedLock(Pipe->Lock);
+        if ((ReturnedEvents & POLL_ERROR_EVENTS) != 0) {
+            return STATUS_END_OF_FILE;
+        }
+
+        if (NonBlocking != FALSE) {
+            return STATUS_TRY_AGAIN;
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopWaitForPipeSpace (
+    PPIPE Pipe,
+    UINTN Required,
+    BOOL WholePage,
+    ULONG TimeoutInMilliseconds,
+    BOOL NonBlocking
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits until a pipe has room for more data, and acquires the
+    pipe lock.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe to wait on.
+
+    Required - Supplies the number of bytes of free space needed.
+
+    WholePage - Supplies a boolean indicating whether an empty slot is needed
+        rather than just the required number of bytes.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait before
+        timing out. Use WAIT_TIME_INDEFINITE to wait forever.
+
+    NonBlocking - Supplies a boolean indicating if this routine should only
+        check the current state rather than waiting.
+
+Return Value:
+
+    STATUS_SUCCESS if the pipe has room. The pipe lock is held in this case,
+    and the caller is responsible for releasing it.
+
+    STATUS_BROKEN_PIPE if the error events are set.
+
+    STATUS_TRY_AGAIN if the pipe is full or a splice is writing to it, and
+    this was a non-blocking call.
+
+    Other error codes if the wait failed.
+
+--*/
+
+{
+
+    ULONG EventsMask;
+    BOOL Ready;
+    ULONG ReturnedEvents;
+    KSTATUS Status;
+
+    EventsMask = POLL_EVENT_OUT | POLL_ERROR_EVENTS;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    while (TRUE) {
+        if (NonBlocking == FALSE) {
+            Status = IoWaitForIoObjectState(Pipe->IoState,
+                                            EventsMask,
+                                            TRUE,
+                                            TimeoutInMilliseconds,
+                                            &ReturnedEvents);
+
+            if (!KSUCCESS(Status)) {
+                return Status;
+            }
+
+            if (ReturnedEvents != POLL_EVENT_OUT) {
+                return STATUS_BROKEN_PIPE;
+            }
+        }
+
+        KeAcquireQueuedLock(Pipe->Lock);
+        if ((Pipe->Flags & PIPE_FLAG_WRITE_BUSY) != 0) {
+            Ready = FALSE;
+
+        } else if (WholePage != FALSE) {
+            Ready = (Pipe->Occupied < Pipe->BufferCount);
+
+        } else {
+            Ready = (IopGetPipeFreeSpace(Pipe) >= Required);
+        }
+
+        if (Ready != FALSE) {
+            return STATUS_SUCCESS;
+        }
+
+        IoSetIoObjectState(Pipe->IoState, POLL_EVENT_OUT, FALSE);
+        KeReleaseQueuedLock(Pipe->Lock);
+        if (NonBlocking != FALSE) {
+            return STATUS_TRY_AGAIN;
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCopyToPipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    UINTN Size,
+    PUINTN BytesCopied
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data into the free space of a pipe's buffer ring,
+    filling up the newest slot before starting new ones. The pipe lock must be
+    held.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe to copy into.
+
+    IoBuffer - Supplies a pointer to the I/O buffer containing the data.
+
+    Offset - Supplies the offset into the I/O buffer to copy from.
+
+    Size - Supplies the number of bytes to copy.
+
+    BytesCopied - Supplies a pointer where the number of bytes copied will be
+        returned. This may be less than requested if the ring fills up.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PPIPE_BUFFER Buffer;
+    UINTN BytesThisRound;
+    BOOL NewBuffer;
+    ULONG PageSize;
+    KSTATUS Status;
+
+    *BytesCopied = 0;
+    PageSize = MmPageSize();
+    Status = STATUS_SUCCESS;
+    while (Size != 0) {
+        NewBuffer = FALSE;
+        Buffer = NULL;
+        if (Pipe->Occupied != 0) {
+            Buffer = PIPE_GET_BUFFER(Pipe, Pipe->Occupied - 1);
+            if ((Buffer->IoBuffer != NULL) ||
+                (Buffer->Offset + Buffer->Size == PageSize)) {
+
+                Buffer = NULL;
+            }
+        }
+
+        if (Buffer == NULL) {
+            if (Pipe->Occupied == Pipe->BufferCount) {
+                break;
+            }
+
+            Buffer = PIPE_GET_BUFFER(Pipe, Pipe->Occupied);
+
+            ASSERT((Buffer->IoBuffer == NULL) && (Buffer->Size == 0));
+
+            if (IopGetPipeBufferPage(Buffer) == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+                break;
+            }
+
+            Buffer->Offset = 0;
+            NewBuffer = TRUE;
+        }
+
+        BytesThisRound = PageSize - (Buffer->Offset + Buffer->Size);
+        if (BytesThisRound > Size) {
+            BytesThisRound = Size;
+        }
+
+        Status = MmCopyIoBufferData(
+                              IoBuffer,
+                              Buffer->Page + Buffer->Offset + Buffer->Size,
+                              Offset + *BytesCopied,
+                              BytesThisRound,
+                              FALSE);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Buffer->Size += BytesThisRound;
+        if (NewBuffer != FALSE) {
+            Pipe->Occupied += 1;
+        }
+
+        *BytesCopied += BytesThisRound;
+        Size -= BytesThisRound;
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopCopyFromPipe (
+    PPIPE Pipe,
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    UINTN Size,
+    PUINTN BytesCopied
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data out of a pipe's buffer ring, consuming it. The
+    pipe lock must be held.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe to copy from.
+
+    IoBuffer - Supplies a pointer to the I/O buffer to copy the data into.
+
+    Offset - Supplies the offset into the I/O buffer to copy to.
+
+    Size - Supplies the maximum number of bytes to copy.
+
+    BytesCopied - Supplies a pointer where the number of bytes copied will be
+        returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PPIPE_BUFFER Buffer;
+    UINTN BytesThisRound;
+    KSTATUS Status;
+
+    *BytesCopied = 0;
+    Status = STATUS_SUCCESS;
+    while ((Size != 0) && (Pipe->Occupied != 0)) {
+        Buffer = PIPE_GET_BUFFER(Pipe, 0);
+        BytesThisRound = Buffer->Size;
+        if (BytesThisRound > Size) {
+            BytesThisRound = Size;
+        }
+
+        if (Buffer->IoBuffer != NULL) {
+            Status = MmCopyIoBuffer(IoBuffer,
+                                    Offset + *BytesCopied,
+                                    Buffer->IoBuffer,
+                                    Buffer->Offset,
+                                    BytesThisRound);
+
+        } else {
+            Status = MmCopyIoBufferData(IoBuffer,
+                                        Buffer->Page + Buffer->Offset,
+                                        Offset + *BytesCopied,
+                                        BytesThisRound,
+                                        TRUE);
+        }
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        IopConsumePipeBuffer(Pipe, BytesThisRound);
+        *BytesCopied += BytesThisRound;
+        Size -= BytesThisRound;
+    }
+
+    return Status;
+}
+
+PVOID
+IopGetPipeBufferPage (
+    PPIPE_BUFFER Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the page owned by the given pipe buffer, allocating
+    it if the slot does not have one yet.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the pipe buffer.
+
+Return Value:
+
+    Returns a pointer to the page on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    if (Buffer->Page == NULL) {
+        Buffer->Page = MmAllocatePagedPool(MmPageSize(), IO_ALLOCATION_TAG);
+    }
+
+    return Buffer->Page;
+}
+
+VOID
+IopConsumePipeBuffer (
+    PPIPE Pipe,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine marks data at the head of a pipe as read, retiring the head
+    slot if it has been drained. The pipe lock must be held.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe.
+
+    Size - Supplies the number of bytes consumed from the head slot.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PPIPE_BUFFER Buffer;
+
+    if (Size == 0) {
+        return;
+    }
+
+    ASSERT(Pipe->Occupied != 0);
+
+    Buffer = PIPE_GET_BUFFER(Pipe, 0);
+
+    ASSERT(Size <= Buffer->Size);
+
+    Buffer->Offset += Size;
+    Buffer->Size -= Size;
+    if (Buffer->Size != 0) {
+        return;
+    }
+
+    //
+    // Spliced pages are released as soon as they are read. Owned pages stay
+    // with the slot for reuse.
+    //
+
+    if (Buffer->IoBuffer != NULL) {
+        MmFreeIoBuffer(Buffer->IoBuffer);
+        Buffer->IoBuffer = NULL;
+    }
+
+    Buffer->Offset = 0;
+    Pipe->Head = (Pipe->Head + 1) & (Pipe->BufferCount - 1);
+    Pipe->Occupied -= 1;
+    return;
+}
+
+UINTN
+IopGetPipeFreeSpace (
+    PPIPE Pipe
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the number of bytes that can be copied into a pipe
+    before it fills up. The pipe lock must be held.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe.
+
+Return Value:
+
+    Returns the number of free bytes in the pipe.
+
+--*/
+
+{
+
+    PPIPE_BUFFER Buffer;
+    UINTN FreeSpace;
+    ULONG PageSize;
+
+    PageSize = MmPageSize();
+    FreeSpace = (Pipe->BufferCount - Pipe->Occupied) * PageSize;
+    if (Pipe->Occupied != 0) {
+        Buffer = PIPE_GET_BUFFER(Pipe, Pipe->Occupied - 1);
+        if (Buffer->IoBuffer == NULL) {
+            FreeSpace += PageSize - (Buffer->Offset + Buffer->Size);
+        }
+    }
+
+    return FreeSpace;
+}
+
+VOID
+IopUpdatePipeEvents (
+    PPIPE Pipe
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets the in and out poll events of a pipe to reflect the
+    current contents of its buffer ring. Each event is kept clear while a
+    splice has that end of the ring checked out. The pipe lock must be held.
+
+Arguments:
+
+    Pipe - Supplies a pointer to the pipe.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (((Pipe->Flags & PIPE_FLAG_WRITE_BUSY) == 0) &&
+        (IopGetPipeFreeSpace(Pipe) >= PIPE_ATOMIC_WRITE_SIZE)) {
+
+        IoSetIoObjectState(Pipe->IoState, POLL_EVENT_OUT, TRUE);
+
+    } else {
+        IoSetIoObjectState(Pipe->IoState, POLL_EVENT_OUT, FALSE);
+    }
+
+    if (((Pipe->Flags & PIPE_FLAG_READ_BUSY) == 0) &&
+        (Pipe->Occupied != 0)) {
+        IoSetIoObjectState(Pipe->IoState, POLL_EVENT_IN, TRUE);
+
+    } else {
+        IoSetIoObjectState(Pipe->IoState, POLL_EVENT_IN, FALSE);
+    }
+
+    return;
+}
+
+ULONG
+IopGetSpliceTimeout (
+    PIO_HANDLE Handle,
+    ULONG Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the timeout to use when waiting on either side of a
+    splice operation.
+
+Arguments:
+
+    Handle - Supplies a pointer to the handle being waited on.
+
+    Flags - Supplies the splice flags. See SYS_SPLICE_FLAG_* definitions.
+
+Return Value:
+
+    Returns zero if the handle or the operation is non-blocking, or
+    WAIT_TIME_INDEFINITE otherwise.
+
+--*/
+
+{
+
+    if (((Handle->OpenFlags & OPEN_FLAG_NON_BLOCKING) != 0) ||
+        ((Flags & SYS_SPLICE_FLAG_NON_BLOCKING) != 0)) {
+
+        return 0;
+    }
+
+    return WAIT_TIME_INDEFINITE;
 }
 
@@ -0,0 +1,438 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    sendfile.c
+
+Abstract:
+
+    This module implements support for transferring data from a file directly
+    to another handle, usually a socket, without bouncing it through user mode.
+    Reads from cacheable files are page aligned so that the page cache entries
+    themselves are handed to the destination rather than a copy of them.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the maximum number of bytes transferred per iteration of a send file
+// operation. This bounds the number of page cache entries pinned at once.
+//
+
+#define IO_SEND_FILE_CHUNK_SIZE (64 * _1KB)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysSendFile (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for transferring data from a file
+    to another handle.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or the number of bytes completed (a positive integer) on
+    success.
+
+    Error status code (a negative integer) on failure.
+
+--*/
+
+{
+
+    UINTN BytesCompleted;
+    PKPROCESS CurrentProcess;
+    PIO_HANDLE Destination;
+    PIO_OFFSET Offset;
+    PSYSTEM_CALL_SEND_FILE Parameters;
+    INTN Result;
+    PIO_HANDLE Source;
+    KSTATUS Status;
+
+    CurrentProcess = PsGetCurrentProcess();
+    Parameters = (PSYSTEM_CALL_SEND_FILE)SystemCallParameter;
+    BytesCompleted = 0;
+    Source = NULL;
+    Destination = ObGetHandleValue(CurrentProcess->HandleTable,
+                                   Parameters->Destination,
+                                   NULL);
+
+    if (Destination == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSendFileEnd;
+    }
+
+    Source = ObGetHandleValue(CurrentProcess->HandleTable,
+                              Parameters->Source,
+                              NULL);
+
+    if (Source == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSendFileEnd;
+    }
+
+    if (Parameters->Size <= 0) {
+        Status = STATUS_SUCCESS;
+        goto SysSendFileEnd;
+    }
+
+    ASSERT(SYS_WAIT_TIME_INDEFINITE == WAIT_TIME_INDEFINITE);
+
+    Offset = NULL;
+    if (Parameters->Offset != IO_OFFSET_NONE) {
+        if (Parameters->Offset < 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto SysSendFileEnd;
+        }
+
+        Offset = &(Parameters->Offset);
+    }
+
+    Status = IoSendFile(Destination,
+                        Source,
+                        Offset,
+                        Parameters->Size,
+                        Parameters->TimeoutInMilliseconds,
+                        &BytesCompleted);
+
+    if (Status == STATUS_BROKEN_PIPE) {
+
+        ASSERT(CurrentProcess != PsGetKernelProcess());
+
+        PsSignalProcess(CurrentProcess, SIGNAL_BROKEN_PIPE, NULL);
+    }
+
+SysSendFileEnd:
+    if (Destination != NULL) {
+        IoIoHandleReleaseReference(Destination);
+    }
+
+    if (Source != NULL) {
+        IoIoHandleReleaseReference(Source);
+    }
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = STATUS_RESTART_AFTER_SIGNAL;
+    }
+
+    Result = Status;
+    if (KSUCCESS(Status)) {
+
+        ASSERT(BytesCompleted <= (UINTN)MAX_INTN);
+
+        Result = (INTN)BytesCompleted;
+    }
+
+    return Result;
+}
+
+KERNEL_API
+KSTATUS
+IoSendFile (
+    PIO_HANDLE Destination,
+    PIO_HANDLE Source,
+    PIO_OFFSET Offset,
+    UINTN SizeInBytes,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesCompleted
+    )
+
+/*++
+
+Routine Description:
+
+    This routine transfers data from a file to another I/O handle without
+    staging it in a caller supplied buffer. If the source file is cacheable,
+    its page cache entries are referenced into the I/O buffer handed to the
+    destination rather than copied.
+
+Arguments:
+
+    Destination - Supplies a pointer to the I/O handle to write to.
+
+    Source - Supplies a pointer to the I/O handle to read from. This must be a
+        seekable handle.
+
+    Offset - Supplies an optional pointer to the offset within the source to
+        start reading from. On return, this will be updated to the offset just
+        past the last byte transferred. If this is NULL, the source's current
+        file position is used and updated instead.
+
+    SizeInBytes - Supplies the number of bytes to transfer.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that each
+        write to the destination should be waited on before timing out.
+
+    BytesCompleted - Supplies a pointer where the number of bytes transferred
+        will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was transferred, or if the source
+    offset was at or beyond the end of the file.
+
+    Error codes if nothing could be transferred.
+
+--*/
+
+{
+
+    IO_OFFSET SourceOffset;
+    KSTATUS Status;
+    UINTN TotalBytes;
+
+    TotalBytes = 0;
+    if (Offset != NULL) {
+        SourceOffset = *Offset;
+
+    } else {
+        Status = IoSeek(Source, SeekCommandNop, 0, &SourceOffset);
+        if (!KSUCCESS(Status)) {
+            goto SendFileEnd;
+        }
+    }
+
+    Status = IopTransferFileData(Destination,
+                                 IO_OFFSET_NONE,
+                                 Source,
+                                 SourceOffset,
+                                 SizeInBytes,
+                                 IO_SEND_FILE_CHUNK_SIZE,
+                                 TimeoutInMilliseconds,
+                                 &TotalBytes);
+
+    SourceOffset += TotalBytes;
+    if (Offset != NULL) {
+        *Offset = SourceOffset;
+
+    } else if (TotalBytes != 0) {
+        IoSeek(Source, SeekCommandFromBeginning, SourceOffset, NULL);
+    }
+
+SendFileEnd:
+    *BytesCompleted = TotalBytes;
+    return Status;
+}
+
+KSTATUS
+IopTransferFileData (
+    PIO_HANDLE Destination,
+    IO_OFFSET DestinationOffset,
+    PIO_HANDLE Source,
+    IO_OFFSET SourceOffset,
+    UINTN SizeInBytes,
+    UINTN ChunkSize,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesCompleted
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves data from a seekable handle to another handle a chunk
+    at a time. If the source file is cacheable, its page cache entries are
+    referenced into the I/O buffer handed to the destination rather than
+    copied. Neither handle's file position is changed, except by writes to the
+    destination at its current position.
+
+Arguments:
+
+    Destination - Supplies a pointer to the I/O handle to write to.
+
+    DestinationOffset - Supplies the offset within the destination to write
+        to, or IO_OFFSET_NONE to write at the destination's current position.
+
+    Source - Supplies a pointer to the I/O handle to read from.
+
+    SourceOffset - Supplies the offset within the source to start reading
+        from.
+
+    SizeInBytes - Supplies the number of bytes to transfer.
+
+    ChunkSize - Supplies the maximum number of bytes to transfer per read and
+        write. This bounds the number of page cache entries pinned at once.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds that each
+        write to the destination should be waited on before timing out.
+
+    BytesCompleted - Supplies a pointer where the number of bytes transferred
+        will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was transferred, or if the source
+    offset was at or beyond the end of the file. A partial transfer is
+    reported as a success so that the caller learns how far the offsets
+    advanced. The error will come back on the next attempt if it persists.
+
+    Error codes if nothing could be transferred.
+
+--*/
+
+{
+
+    ULONG ByteOffset;
+    UINTN BytesRead;
+    UINTN BytesThisRound;
+    UINTN BytesWritten;
+    BOOL Cacheable;
+    PIO_BUFFER IoBuffer;
+    ULONG PageSize;
+    IO_OFFSET ReadOffset;
+    UINTN ReadSize;
+    KSTATUS Status;
+    UINTN TotalBytes;
+
+    TotalBytes = 0;
+    PageSize = MmPageSize();
+    Cacheable = IO_IS_FILE_OBJECT_CACHEABLE(Source->FileObject);
+    Status = STATUS_SUCCESS;
+    while (TotalBytes < SizeInBytes) {
+        BytesThisRound = SizeInBytes - TotalBytes;
+        if (BytesThisRound > ChunkSize) {
+            BytesThisRound = ChunkSize;
+        }
+
+        //
+        // For cacheable files, read a page aligned region into an empty
+        // buffer. The cached read path then fills the buffer with references
+        // to the page cache entries themselves rather than copying them.
+        //
+
+        if (Cacheable != FALSE) {
+            ReadOffset = ALIGN_RANGE_DOWN(SourceOffset, PageSize);
+            ByteOffset = (ULONG)(SourceOffset - ReadOffset);
+            ReadSize = ALIGN_RANGE_UP(BytesThisRound + ByteOffset, PageSize);
+            IoBuffer = MmAllocateUninitializedIoBuffer(ReadSize, 0);
+
+        } else {
+            ReadOffset = SourceOffset;
+            ByteOffset = 0;
+            ReadSize = BytesThisRound;
+            IoBuffer = MmAllocatePagedIoBuffer(ReadSize, 0);
+        }
+
+        if (IoBuffer == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            break;
+        }
+
+        Status = IoReadAtOffset(Source,
+                                IoBuffer,
+                                ReadOffset,
+                                ReadSize,
+                                0,
+                                WAIT_TIME_INDEFINITE,
+                                &BytesRead,
+                                NULL);
+
+        if (!KSUCCESS(Status)) {
+            MmFreeIoBuffer(IoBuffer);
+            if (Status == STATUS_END_OF_FILE) {
+                Status = STATUS_SUCCESS;
+            }
+
+            break;
+        }
+
+        if (BytesRead <= ByteOffset) {
+            MmFreeIoBuffer(IoBuffer);
+            break;
+        }
+
+        BytesRead -= ByteOffset;
+        if (BytesRead > BytesThisRound) {
+            BytesRead = BytesThisRound;
+        }
+
+        //
+        // Skip the leading portion of the first page that was only read to
+        // keep the request aligned, and hand the rest to the destination.
+        //
+
+        MmIoBufferIncrementOffset(IoBuffer, ByteOffset);
+        Status = IoWriteAtOffset(Destination,
+                                 IoBuffer,
+                                 DestinationOffset,
+                                 BytesRead,
+                                 0,
+                                 TimeoutInMilliseconds,
+                                 &BytesWritten,
+                                 NULL);
+
+        MmFreeIoBuffer(IoBuffer);
+        TotalBytes += BytesWritten;
+        SourceOffset += BytesWritten;
+        if (DestinationOffset != IO_OFFSET_NONE) {
+            DestinationOffset += BytesWritten;
+        }
+
+        if ((!KSUCCESS(Status)) || (BytesWritten != BytesRead)) {
+            break;
+        }
+    }
+
+    if (TotalBytes != 0) {
+        Status = STATUS_SUCCESS;
+    }
+
+    *BytesCompleted = TotalBytes;
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -1825,6 +1825,168 @@ Return Value:
     return Status;
 }
 
+INTN
+IoSysSocketPerformBatchIo (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that sends or receives several
+    socket messages at once.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    Returns the number of messages completed on success.
+
+    Error status code if the first message failed.
+
+--*/
+
+{
+
+    UINTN Completed;
+    PIO_BUFFER IoBuffer;
+    PIO_HANDLE IoHandle;
+    PSOCKET_IO_PARAMETERS IoParameters;
+    SOCKET_IO_MESSAGE Message;
+    PSYSTEM_CALL_SOCKET_PERFORM_BATCH_IO Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+    PSOCKET_IO_MESSAGE UserMessage;
+    BOOL Write;
+
+    Completed = 0;
+    IoBuffer = NULL;
+    IoParameters = &(Message.Parameters);
+    IoParameters->BytesCompleted = 0;
+    Parameters = (PSYSTEM_CALL_SOCKET_PERFORM_BATCH_IO)SystemCallParameter;
+    Process = PsGetCurrentProcess();
+    Write = FALSE;
+
+    ASSERT(SYS_WAIT_TIME_INDEFINITE == WAIT_TIME_INDEFINITE);
+
+    IoHandle = ObGetHandleValue(Process->HandleTable, Parameters->Socket, NULL);
+    if (IoHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSocketPerformBatchIoEnd;
+    }
+
+    if ((Parameters->Flags & ~SYS_SOCKET_BATCH_FLAG_MASK) != 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysSocketPerformBatchIoEnd;
+    }
+
+    Status = STATUS_SUCCESS;
+    UserMessage = Parameters->Messages;
+    while (Completed < Parameters->MessageCount) {
+        Status = MmCopyFromUserMode(&Message,
+                                    UserMessage,
+                                    sizeof(SOCKET_IO_MESSAGE));
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        IoParameters->BytesCompleted = 0;
+        IoParameters->IoFlags &= SYS_IO_FLAG_MASK;
+        Status = MmCreateIoBufferFromVector(Message.VectorArray,
+                                            FALSE,
+                                            Message.VectorCount,
+                                            &IoBuffer);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        //
+        // Non-blocking handles always have a timeout of zero, as do all but
+        // the first message when the caller only wants to wait for one.
+        //
+
+        if (((IoHandle->OpenFlags & OPEN_FLAG_NON_BLOCKING) != 0) ||
+            ((Completed != 0) &&
+             ((Parameters->Flags & SYS_SOCKET_BATCH_FLAG_WAIT_FOR_ONE) != 0))) {
+
+            IoParameters->TimeoutInMilliseconds = 0;
+        }
+
+        Write = FALSE;
+        if ((IoParameters->IoFlags & SYS_IO_FLAG_WRITE) != 0) {
+            Write = TRUE;
+            Status = IoSocketSendData(FALSE, IoHandle, IoParameters, IoBuffer);
+            if (Status == STATUS_BROKEN_PIPE) {
+
+                ASSERT(Process != PsGetKernelProcess());
+
+                PsSignalProcess(Process, SIGNAL_BROKEN_PIPE, NULL);
+            }
+
+        } else {
+            Status = IoSocketReceiveData(FALSE,
+                                         IoHandle,
+                                         IoParameters,
+                                         IoBuffer);
+        }
+
+        MmFreeIoBuffer(IoBuffer);
+        IoBuffer = NULL;
+
+        //
+        // A message that moved some data counts as done even if it hit an
+        // error, which is reported on the next call instead. The end of a
+        // stream completes a message with no data and ends the batch.
+        //
+
+        if ((KSUCCESS(Status)) ||
+            (Status == STATUS_END_OF_FILE) ||
+            (IoParameters->BytesCompleted != 0)) {
+
+            MmCopyToUserMode(&(UserMessage->Parameters),
+                             IoParameters,
+                             sizeof(SOCKET_IO_PARAMETERS));
+
+            Completed += 1;
+            UserMessage += 1;
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+
+            continue;
+        }
+
+        break;
+    }
+
+SysSocketPerformBatchIoEnd:
+    if (IoHandle != NULL) {
+
+        //
+        // An interrupted socket cannot be restarted if a timeout has been set.
+        //
+
+        if ((Completed == 0) && (Status == STATUS_INTERRUPTED)) {
+            Status = IopConvertInterruptedSocketStatus(IoHandle, 0, Write);
+        }
+
+        IoIoHandleReleaseReference(IoHandle);
+    }
+
+    if (Completed != 0) {
+        return Completed;
+    }
+
+    return Status;
+}
+
 INTN
 IoSysSocketGetSetInformation (
     PVOID SystemCallParameter
@@ -0,0 +1,398 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    splice.c
+
+Abstract:
+
+    This module implements support for splicing data into and out of pipes.
+    Splicing moves whole pages between pipes, files, sockets and user memory
+    by reference wherever possible, rather than copying the data through a
+    user mode buffer.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysSplice (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for moving data between two
+    handles, at least one of which is a pipe.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or the number of bytes moved (a positive integer) on
+    success.
+
+    Error status code (a negative integer) on failure.
+
+--*/
+
+{
+
+    UINTN BytesSpliced;
+    PKPROCESS CurrentProcess;
+    PIO_HANDLE Input;
+    PIO_OFFSET InputOffset;
+    PIO_HANDLE Output;
+    PIO_OFFSET OutputOffset;
+    PSYSTEM_CALL_SPLICE Parameters;
+    INTN Result;
+    KSTATUS Status;
+
+    CurrentProcess = PsGetCurrentProcess();
+    Parameters = (PSYSTEM_CALL_SPLICE)SystemCallParameter;
+    BytesSpliced = 0;
+    Output = NULL;
+    Input = ObGetHandleValue(CurrentProcess->HandleTable,
+                             Parameters->Input,
+                             NULL);
+
+    if (Input == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSpliceEnd;
+    }
+
+    Output = ObGetHandleValue(CurrentProcess->HandleTable,
+                              Parameters->Output,
+                              NULL);
+
+    if (Output == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSpliceEnd;
+    }
+
+    if (Parameters->Size < 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysSpliceEnd;
+    }
+
+    InputOffset = NULL;
+    if (Parameters->InputOffset != IO_OFFSET_NONE) {
+        if (Parameters->InputOffset < 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto SysSpliceEnd;
+        }
+
+        InputOffset = &(Parameters->InputOffset);
+    }
+
+    OutputOffset = NULL;
+    if (Parameters->OutputOffset != IO_OFFSET_NONE) {
+        if (Parameters->OutputOffset < 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto SysSpliceEnd;
+        }
+
+        OutputOffset = &(Parameters->OutputOffset);
+    }
+
+    Status = IoSplice(Input,
+                      InputOffset,
+                      Output,
+                      OutputOffset,
+                      Parameters->Size,
+                      Parameters->Flags,
+                      &BytesSpliced);
+
+    if (Status == STATUS_END_OF_FILE) {
+        Status = STATUS_SUCCESS;
+
+    } else if (Status == STATUS_BROKEN_PIPE) {
+
+        ASSERT(CurrentProcess != PsGetKernelProcess());
+
+        PsSignalProcess(CurrentProcess, SIGNAL_BROKEN_PIPE, NULL);
+    }
+
+SysSpliceEnd:
+    if (Input != NULL) {
+        IoIoHandleReleaseReference(Input);
+    }
+
+    if (Output != NULL) {
+        IoIoHandleReleaseReference(Output);
+    }
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = STATUS_RESTART_AFTER_SIGNAL;
+    }
+
+    Result = Status;
+    if (KSUCCESS(Status)) {
+
+        ASSERT(BytesSpliced <= (UINTN)MAX_INTN);
+
+        Result = (INTN)BytesSpliced;
+    }
+
+    return Result;
+}
+
+INTN
+IoSysSpliceMemory (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for placing user mode memory into
+    a pipe without copying it.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or the number of bytes placed in the pipe (a positive
+    integer) on success.
+
+    Error status code (a negative integer) on failure.
+
+--*/
+
+{
+
+    UINTN BytesSpliced;
+    PKPROCESS CurrentProcess;
+    PIO_HANDLE Handle;
+    PSYSTEM_CALL_SPLICE_MEMORY Parameters;
+    INTN Result;
+    KSTATUS Status;
+    PIO_BUFFER UserBuffer;
+
+    CurrentProcess = PsGetCurrentProcess();
+    Parameters = (PSYSTEM_CALL_SPLICE_MEMORY)SystemCallParameter;
+    BytesSpliced = 0;
+    UserBuffer = NULL;
+    Handle = ObGetHandleValue(CurrentProcess->HandleTable,
+                              Parameters->Handle,
+                              NULL);
+
+    if (Handle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSpliceMemoryEnd;
+    }
+
+    if ((Parameters->Flags & ~SYS_SPLICE_FLAG_MASK) != 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysSpliceMemoryEnd;
+    }
+
+    Status = MmCreateIoBufferFromVector(Parameters->VectorArray,
+                                        FALSE,
+                                        Parameters->VectorCount,
+                                        &UserBuffer);
+
+    if (!KSUCCESS(Status)) {
+        goto SysSpliceMemoryEnd;
+    }
+
+    Status = IopSpliceMemoryToPipe(Handle,
+                                   UserBuffer,
+                                   Parameters->Flags,
+                                   &BytesSpliced);
+
+    if (Status == STATUS_BROKEN_PIPE) {
+
+        ASSERT(CurrentProcess != PsGetKernelProcess());
+
+        PsSignalProcess(CurrentProcess, SIGNAL_BROKEN_PIPE, NULL);
+    }
+
+SysSpliceMemoryEnd:
+    if (UserBuffer != NULL) {
+        MmFreeIoBuffer(UserBuffer);
+    }
+
+    if (Handle != NULL) {
+        IoIoHandleReleaseReference(Handle);
+    }
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = STATUS_RESTART_AFTER_SIGNAL;
+    }
+
+    Result = Status;
+    if (KSUCCESS(Status)) {
+
+        ASSERT(BytesSpliced <= (UINTN)MAX_INTN);
+
+        Result = (INTN)BytesSpliced;
+    }
+
+    return Result;
+}
+
+KERNEL_API
+KSTATUS
+IoSplice (
+    PIO_HANDLE Input,
+    PIO_OFFSET InputOffset,
+    PIO_HANDLE Output,
+    PIO_OFFSET OutputOffset,
+    UINTN SizeInBytes,
+    ULONG Flags,
+    PUINTN BytesSpliced
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves data between two I/O handles, at least one of which
+    must be a pipe. Pages are moved between pipes, referenced from the page
+    cache, or written straight out of the pipe rather than being copied
+    through an intermediate buffer.
+
+Arguments:
+
+    Input - Supplies a pointer to the I/O handle to read from.
+
+    InputOffset - Supplies an optional pointer to the offset within the input
+        to read from. On return, this is advanced past the bytes moved. If
+        this is NULL, the input's current file position is used. This must be
+        NULL if the input is a pipe.
+
+    Output - Supplies a pointer to the I/O handle to write to.
+
+    OutputOffset - Supplies an optional pointer to the offset within the
+        output to write to. On return, this is advanced past the bytes moved.
+        If this is NULL, the output's current file position is used. This must
+        be NULL if the output is a pipe.
+
+    SizeInBytes - Supplies the maximum number of bytes to move.
+
+    Flags - Supplies a bitfield of flags. See SYS_SPLICE_FLAG_* definitions.
+
+    BytesSpliced - Supplies a pointer where the number of bytes moved will be
+        returned.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one byte was moved.
+
+    STATUS_END_OF_FILE if the input pipe is empty and has no writers, or the
+    input file offset is at the end of the file.
+
+    STATUS_INVALID_PARAMETER if neither handle is a pipe, or an offset was
+    supplied for a pipe.
+
+    Other error codes if nothing could be moved.
+
+--*/
+
+{
+
+    BOOL InputIsPipe;
+    BOOL OutputIsPipe;
+
+    *BytesSpliced = 0;
+    if ((Flags & ~SYS_SPLICE_FLAG_MASK) != 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    InputIsPipe = FALSE;
+    if (Input->FileObject->Properties.Type == IoObjectPipe) {
+        InputIsPipe = TRUE;
+    }
+
+    OutputIsPipe = FALSE;
+    if (Output->FileObject->Properties.Type == IoObjectPipe) {
+        OutputIsPipe = TRUE;
+    }
+
+    if ((InputIsPipe == FALSE) && (OutputIsPipe == FALSE)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (((InputIsPipe != FALSE) && (InputOffset != NULL)) ||
+        ((OutputIsPipe != FALSE) && (OutputOffset != NULL))) {
+
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (SizeInBytes == 0) {
+        return STATUS_SUCCESS;
+    }
+
+    if (InputIsPipe != FALSE) {
+        return IopSpliceFromPipe(Input,
+                                 Output,
+                                 OutputOffset,
+                                 SizeInBytes,
+                                 Flags,
+                                 BytesSpliced);
+    }
+
+    return IopSpliceToPipe(Input,
+                           InputOffset,
+                           Output,
+                           SizeInBytes,
+                           Flags,
+                           BytesSpliced);
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -58,6 +58,15 @@ Module Name:
 
 #define UNIX_SOCKET_MAX_CONTROL_DATA 32768
 
+//
+// Define the size at or above which a blocking stream send from user mode that
+// does not fit in the send buffer pins the sender's pages and lets the
+// receiver copy straight out of them, rather than first copying the data into
+// kernel packets.
+//
+
+#define UNIX_SOCKET_PINNED_SEND_THRESHOLD (64 * _1KB)
+
 //
 // Define local socket flags.
 //
@@ -140,6 +149,19 @@ Structure Description:
     HandleCount - Stores the number of file handles being passed in this
         message.
 
+    PinnedBuffer - Stores an optional pointer to the sender's locked I/O
+        buffer. If this is set, the data lives in the sender's pages rather
+        than after this structure, and the packet is not charged against the
+        sender's send list.
+
+    PinnedOffset - Stores the offset within the pinned buffer where this
+        packet's data begins.
+
+    CompletionEvent - Stores an optional pointer to the event the sender of a
+        pinned packet waits on. Whoever takes a pinned packet off the receive
+        list signals this event rather than destroying the packet, and the
+        sender destroys it.
+
 --*/
 
 typedef struct _UNIX_SOCKET_PACKET {
@@ -151,10 +173,40 @@ typedef struct _UNIX_SOCKET_PACKET {
     UNIX_SOCKET_CREDENTIALS Credentials;
     PIO_HANDLE *Handles;
     UINTN HandleCount;
+    PIO_BUFFER PinnedBuffer;
+    UINTN PinnedOffset;
+    PKEVENT CompletionEvent;
 } UNIX_SOCKET_PACKET, *PUNIX_SOCKET_PACKET;
 
 /*++
 
+Structure Description:
+
+    This structure defines a receiver blocked on a Unix socket whose receive
+    list is empty. A sender that finds one copies its data straight into the
+    receiver's buffer instead of queuing a packet. The structure lives on the
+    receiver's stack and is only touched with the socket lock held.
+
+Members:
+
+    IoBuffer - Stores a pointer to the receiver's buffer, with its pages locked
+        so that it can be written from the sender's context.
+
+    Size - Stores the size of the receiver's buffer in bytes.
+
+    BytesReceived - Stores the number of bytes a sender copied in. This is
+        zero until a sender fills the buffer.
+
+--*/
+
+typedef struct _UNIX_SOCKET_RECEIVER {
+    PIO_BUFFER IoBuffer;
+    UINTN Size;
+    UINTN BytesReceived;
+} UNIX_SOCKET_RECEIVER, *PUNIX_SOCKET_RECEIVER;
+
+/*++
+
 Structure Description:
 
     This structure defines a Unix socket object.
@@ -202,6 +254,9 @@ Structure Description:
     Credentials - Stores the credentials of the process when the socket was
         connected.
 
+    Receiver - Stores an optional pointer to a receiver blocked waiting for
+        data with nothing on the receive list.
+
 --*/
 
 struct _UNIX_SOCKET {
@@ -220,6 +275,7 @@ struct _UNIX_SOCKET {
     PUNIX_SOCKET Remote;
     ULONG Flags;
     UNIX_SOCKET_CREDENTIALS Credentials;
+    PUNIX_SOCKET_RECEIVER Receiver;
 };
 
 //
@@ -251,6 +307,32 @@ IopUnixSocketDestroyPacket (
     PUNIX_SOCKET_PACKET Packet
     );
 
+VOID
+IopUnixSocketReleasePacket (
+    PUNIX_SOCKET_PACKET Packet
+    );
+
+KSTATUS
+IopUnixSocketSendDirect (
+    PUNIX_SOCKET Sender,
+    PUNIX_SOCKET Remote,
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    UINTN Size,
+    PUINTN BytesSent
+    );
+
+KSTATUS
+IopUnixSocketSendPinned (
+    PUNIX_SOCKET Sender,
+    PUNIX_SOCKET Remote,
+    PIO_BUFFER PinnedBuffer,
+    UINTN Offset,
+    UINTN Size,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesSent
+    );
+
 KSTATUS
 IopUnixSocketSendControlData (
     BOOL FromKernelMode,
@@ -1348,11 +1430,14 @@ Return Value:
     UINTN BytesCompleted;
     PNETWORK_ADDRESS Destination;
     NETWORK_ADDRESS DestinationLocal;
+    BOOL Direct;
     PFILE_OBJECT FileObject;
     ULONG OpenFlags;
     PUNIX_SOCKET_PACKET Packet;
     UINTN PacketSize;
     PATH_POINT PathPoint;
+    BOOL Pinned;
+    PIO_BUFFER PinnedBuffer;
     PKPROCESS Process;
     PSTR RemoteCopy;
     PSTR RemotePath;
@@ -1370,6 +1455,7 @@ Return Value:
     BytesCompleted = 0;
     Packet = NULL;
     IO_INITIALIZE_PATH_POINT(&PathPoint);
+    PinnedBuffer = NULL;
     RemoteCopy = NULL;
     UnixSocket = (PUNIX_SOCKET)Socket;
     KeAcquireQueuedLock(UnixSocket->Lock);
@@ -1485,6 +1571,28 @@ Return Value:
 
     OpenFlags = IoGetIoHandleOpenFlags(Socket->IoHandle);
 
+    //
+    // Data without control messages can skip the packet queue, either by
+    // going straight into the buffer of a receiver that is already waiting or,
+    // for large blocking stream sends that overflow the send buffer, by
+    // queuing a packet that refers to the sender's pinned pages.
+    //
+
+    Direct = FALSE;
+    Pinned = FALSE;
+    if ((Parameters->ControlData == NULL) ||
+        (Parameters->ControlDataSize == 0)) {
+
+        Direct = TRUE;
+        if ((FromKernelMode == FALSE) &&
+            (Socket->Type == NetSocketStream) &&
+            (Parameters->TimeoutInMilliseconds != 0) &&
+            ((OpenFlags & OPEN_FLAG_NON_BLOCKING) == 0)) {
+
+            Pinned = TRUE;
+        }
+    }
+
     //
     // Loop while there's data to send.
     //
@@ -1519,6 +1627,77 @@ Return Value:
             }
         }
 
+        if (Direct != FALSE) {
+            KeReleaseQueuedLock(UnixSocket->Lock);
+            UnixSocketLockHeld = FALSE;
+            Status = IopUnixSocketSendDirect(UnixSocket,
+                                             RemoteUnixSocket,
+                                             IoBuffer,
+                                             BytesCompleted,
+                                             Size,
+                                             &PacketSize);
+
+            if (!KSUCCESS(Status)) {
+                goto UnixSocketSendDataEnd;
+            }
+
+            if (PacketSize != 0) {
+                BytesCompleted += PacketSize;
+                Size -= PacketSize;
+                continue;
+            }
+
+            KeAcquireQueuedLock(UnixSocket->Lock);
+            UnixSocketLockHeld = TRUE;
+
+            //
+            // Only pin the sender's pages if the send buffer cannot hold the
+            // rest of the data. A send that fits is queued normally so that
+            // it completes without waiting for the receiver.
+            //
+
+            if ((Pinned != FALSE) &&
+                (Size >= UNIX_SOCKET_PINNED_SEND_THRESHOLD) &&
+                ((UnixSocket->SendListSize + Size) >
+                 UnixSocket->SendListMax)) {
+
+                KeReleaseQueuedLock(UnixSocket->Lock);
+                UnixSocketLockHeld = FALSE;
+                if (PinnedBuffer == NULL) {
+                    Status = IopLockUserIoBuffer(IoBuffer,
+                                                 FALSE,
+                                                 &PinnedBuffer);
+
+                    if (!KSUCCESS(Status)) {
+                        PinnedBuffer = NULL;
+                        Pinned = FALSE;
+                    }
+                }
+
+                if (PinnedBuffer != NULL) {
+                    Status = IopUnixSocketSendPinned(
+                                            UnixSocket,
+                                            RemoteUnixSocket,
+                                            PinnedBuffer,
+                                            BytesCompleted,
+                                            Size,
+                                            Parameters->TimeoutInMilliseconds,
+                                            &PacketSize);
+
+                    BytesCompleted += PacketSize;
+                    Size -= PacketSize;
+                    if (!KSUCCESS(Status)) {
+                        goto UnixSocketSendDataEnd;
+                    }
+
+                    continue;
+                }
+
+                KeAcquireQueuedLock(UnixSocket->Lock);
+                UnixSocketLockHeld = TRUE;
+            }
+        }
+
         if (UnixSocket->SendListSize >= UnixSocket->SendListMax) {
             PacketSize = 0;
 
@@ -1693,6 +1872,10 @@ Return Value:
         MmFreePagedPool(RemoteCopy);
     }
 
+    if (PinnedBuffer != NULL) {
+        MmFreeIoBuffer(PinnedBuffer);
+    }
+
     if (!KSUCCESS(Status)) {
 
         //
@@ -1765,20 +1948,28 @@ Return Value:
 
     UINTN ByteCount;
     UINTN BytesReceived;
+    ULONGLONG CurrentTime;
+    BOOL Direct;
+    ULONGLONG EndTime;
     PUNIX_SOCKET FirstSender;
     ULONG OpenFlags;
     PUNIX_SOCKET_PACKET Packet;
+    UNIX_SOCKET_RECEIVER Receiver;
+    BOOL Registered;
     PUNIX_SOCKET Remote;
     NETWORK_ADDRESS RemoteAddressLocal;
     ULONG ReturnedEvents;
     UINTN SenderCopySize;
     UINTN Size;
     KSTATUS Status;
+    ULONGLONG TimeCounterFrequency;
+    ULONG TimeoutInMilliseconds;
     PUNIX_SOCKET UnixSocket;
     BOOL UnixSocketLockHeld;
 
     BytesReceived = 0;
     FirstSender = NULL;
+    Receiver.IoBuffer = NULL;
     Size = Parameters->Size;
     UnixSocket = (PUNIX_SOCKET)Socket;
     UnixSocketLockHeld = FALSE;
@@ -1786,10 +1977,45 @@ Return Value:
     ASSERT(Socket->Domain == NetDomainLocal);
 
     //
-    // Loop reading stuff.
+    // A blocking receive from user mode that doesn't want to know where the
+    // data came from can let a sender copy straight into its buffer while it
+    // waits.
     //
 
     OpenFlags = IoGetIoHandleOpenFlags(Socket->IoHandle);
+    Direct = FALSE;
+    if ((FromKernelMode == FALSE) &&
+        (Parameters->TimeoutInMilliseconds != 0) &&
+        ((OpenFlags & OPEN_FLAG_NON_BLOCKING) == 0) &&
+        (Parameters->NetworkAddress == NULL) &&
+        ((Parameters->RemotePath == NULL) ||
+         (Parameters->RemotePathSize == 0))) {
+
+        Direct = TRUE;
+    }
+
+    //
+    // The loop can go around several times before data shows up, so each
+    // wait only gets the time remaining until the original deadline.
+    //
+
+    TimeoutInMilliseconds = Parameters->TimeoutInMilliseconds;
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+
+    //
+    // Loop reading stuff.
+    //
+
     while (Size != 0) {
         if (UnixSocketLockHeld == FALSE) {
             KeAcquireQueuedLock(UnixSocket->Lock);
@@ -1839,18 +2065,90 @@ Return Value:
                 goto UnixSocketReceiveDataEnd;
             }
 
+            //
+            // Lock the receive buffer down the first time this receive has to
+            // wait, so that a sender can fill it directly. The list has to be
+            // checked again once the lock is reacquired.
+            //
+
+            if ((Direct != FALSE) && (Receiver.IoBuffer == NULL)) {
+                KeReleaseQueuedLock(UnixSocket->Lock);
+                UnixSocketLockHeld = FALSE;
+                Status = IopLockUserIoBuffer(IoBuffer,
+                                             TRUE,
+                                             &(Receiver.IoBuffer));
+
+                if (!KSUCCESS(Status)) {
+                    Receiver.IoBuffer = NULL;
+                    Direct = FALSE;
+                }
+
+                continue;
+            }
+
+            if ((EndTime != 0) && (TimeoutInMilliseconds == 0)) {
+                Status = STATUS_TIMEOUT;
+                goto UnixSocketReceiveDataEnd;
+            }
+
+            Registered = FALSE;
+            if ((Receiver.IoBuffer != NULL) && (UnixSocket->Receiver == NULL)) {
+                Receiver.Size = Size;
+                Receiver.BytesReceived = 0;
+                UnixSocket->Receiver = &Receiver;
+                Registered = TRUE;
+            }
+
             KeReleaseQueuedLock(UnixSocket->Lock);
             UnixSocketLockHeld = FALSE;
             Status = IoWaitForIoObjectState(Socket->IoState,
                                             POLL_EVENT_IN,
                                             TRUE,
-                                            Parameters->TimeoutInMilliseconds,
+                                            TimeoutInMilliseconds,
                                             &ReturnedEvents);
 
+            //
+            // Take the receiver back off the socket. A sender may have filled
+            // it even if the wait failed.
+            //
+
+            if (Registered != FALSE) {
+                KeAcquireQueuedLock(UnixSocket->Lock);
+                UnixSocketLockHeld = TRUE;
+                if (UnixSocket->Receiver == &Receiver) {
+                    UnixSocket->Receiver = NULL;
+                }
+
+                if (Receiver.BytesReceived != 0) {
+                    if (LIST_EMPTY(&(UnixSocket->ReceiveList)) != FALSE) {
+                        IoSetIoObjectState(Socket->IoState,
+                                           POLL_EVENT_IN,
+                                           FALSE);
+                    }
+
+                    BytesReceived = Receiver.BytesReceived;
+                    Parameters->ControlDataSize = 0;
+                    Status = STATUS_SUCCESS;
+                    goto UnixSocketReceiveDataEnd;
+                }
+            }
+
             if (!KSUCCESS(Status)) {
                 goto UnixSocketReceiveDataEnd;
             }
 
+            if (EndTime != 0) {
+                CurrentTime = KeGetRecentTimeCounter();
+                if (CurrentTime >= EndTime) {
+                    TimeoutInMilliseconds = 0;
+
+                } else {
+                    TimeoutInMilliseconds = ((EndTime - CurrentTime) *
+                                             MILLISECONDS_PER_SECOND) /
+                                            TimeCounterFrequency;
+                }
+            }
+
             continue;
 
         //
@@ -1884,11 +2182,20 @@ Return Value:
                 ByteCount = Size;
             }
 
-            Status = MmCopyIoBufferData(IoBuffer,
-                                        Packet->Data + Packet->Offset,
+            if (Packet->PinnedBuffer != NULL) {
+                Status = MmCopyIoBuffer(IoBuffer,
                                         BytesReceived,
-                                        ByteCount,
-                                        TRUE);
+                                        Packet->PinnedBuffer,
+                                        Packet->PinnedOffset + Packet->Offset,
+                                        ByteCount);
+
+            } else {
+                Status = MmCopyIoBufferData(IoBuffer,
+                                            Packet->Data + Packet->Offset,
+                                            BytesReceived,
+                                            ByteCount,
+                                            TRUE);
+            }
 
             if (!KSUCCESS(Status)) {
                 goto UnixSocketReceiveDataEnd;
@@ -1972,6 +2279,7 @@ Return Value:
                 (Socket->Type == NetSocketDatagram)) {
 
                 LIST_REMOVE(&(Packet->ListEntry));
+                Packet->ListEntry.Next = NULL;
                 if (LIST_EMPTY(&(UnixSocket->ReceiveList)) != FALSE) {
                     IoSetIoObjectState(Socket->IoState, POLL_EVENT_IN, FALSE);
                 }
@@ -1984,22 +2292,7 @@ Return Value:
 
                 KeReleaseQueuedLock(UnixSocket->Lock);
                 UnixSocketLockHeld = FALSE;
-                KeAcquireQueuedLock(Packet->Sender->Lock);
-
-                ASSERT(Packet->Sender->SendListSize >= Packet->Length);
-
-                IoSetIoObjectState(Packet->Sender->KernelSocket.IoState,
-                                   POLL_EVENT_OUT,
-                                   TRUE);
-
-                Packet->Sender->SendListSize -= Packet->Length;
-                KeReleaseQueuedLock(Packet->Sender->Lock);
-
-                //
-                // Destroy the sender's packet.
-                //
-
-                IopUnixSocketDestroyPacket(Packet);
+                IopUnixSocketReleasePacket(Packet);
             }
 
             //
@@ -2022,6 +2315,10 @@ Return Value:
         KeReleaseQueuedLock(UnixSocket->Lock);
     }
 
+    if (Receiver.IoBuffer != NULL) {
+        MmFreeIoBuffer(Receiver.IoBuffer);
+    }
+
     if ((Status == STATUS_END_OF_FILE) && (BytesReceived != 0)) {
         Status = STATUS_SUCCESS;
     }
@@ -2646,17 +2943,8 @@ Return Value:
                             ListEntry);
 
         LIST_REMOVE(&(Packet->ListEntry));
-        KeAcquireQueuedLock(Packet->Sender->Lock);
-
-        ASSERT(Packet->Sender->SendListSize >= Packet->Length);
-
-        IoSetIoObjectState(Packet->Sender->KernelSocket.IoState,
-                           POLL_EVENT_OUT,
-                           TRUE);
-
-        Packet->Sender->SendListSize -= Packet->Length;
-        KeReleaseQueuedLock(Packet->Sender->Lock);
-        IopUnixSocketDestroyPacket(Packet);
+        Packet->ListEntry.Next = NULL;
+        IopUnixSocketReleasePacket(Packet);
     }
 
     return;
@@ -2719,6 +3007,9 @@ Return Value:
     Packet->Credentials.GroupId = -1;
     Packet->Handles = NULL;
     Packet->HandleCount = 0;
+    Packet->PinnedBuffer = NULL;
+    Packet->PinnedOffset = 0;
+    Packet->CompletionEvent = NULL;
     if (DataSize != 0) {
         Status = MmCopyIoBufferData(IoBuffer,
                                     Packet->Data,
@@ -2776,11 +3067,314 @@ Return Value:
         MmFreePagedPool(IoHandleArray);
     }
 
+    if (Packet->CompletionEvent != NULL) {
+        KeDestroyEvent(Packet->CompletionEvent);
+    }
+
     IoSocketReleaseReference(&(Packet->Sender->KernelSocket));
     MmFreePagedPool(Packet);
     return;
 }
 
+VOID
+IopUnixSocketReleasePacket (
+    PUNIX_SOCKET_PACKET Packet
+    )
+
+/*++
+
+Routine Description:
+
+    This routine disposes of a packet that has been taken off a receive list.
+    Ordinary packets are uncharged from the sender and destroyed. Pinned
+    packets are handed back to the sender waiting on them.
+
+Arguments:
+
+    Packet - Supplies a pointer to the packet to release. The caller must not
+        touch the packet after this routine returns.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PUNIX_SOCKET Sender;
+
+    if (Packet->CompletionEvent != NULL) {
+
+        ASSERT(Packet->PinnedBuffer != NULL);
+
+        KeSignalEvent(Packet->CompletionEvent, SignalOptionSignalAll);
+        return;
+    }
+
+    Sender = Packet->Sender;
+    KeAcquireQueuedLock(Sender->Lock);
+
+    ASSERT(Sender->SendListSize >= Packet->Length);
+
+    IoSetIoObjectState(Sender->KernelSocket.IoState, POLL_EVENT_OUT, TRUE);
+    Sender->SendListSize -= Packet->Length;
+    KeReleaseQueuedLock(Sender->Lock);
+    IopUnixSocketDestroyPacket(Packet);
+    return;
+}
+
+KSTATUS
+IopUnixSocketSendDirect (
+    PUNIX_SOCKET Sender,
+    PUNIX_SOCKET Remote,
+    PIO_BUFFER IoBuffer,
+    UINTN Offset,
+    UINTN Size,
+    PUINTN BytesSent
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data straight into the buffer of a receiver blocked on
+    the remote socket, if there is one and nothing is queued ahead of it. This
+    routine assumes neither socket lock is held.
+
+Arguments:
+
+    Sender - Supplies a pointer to the sending socket.
+
+    Remote - Supplies a pointer to the socket being sent to.
+
+    IoBuffer - Supplies a pointer to the I/O buffer containing the data to
+        send.
+
+    Offset - Supplies the offset within the I/O buffer of the data to send.
+
+    Size - Supplies the number of bytes left to send.
+
+    BytesSent - Supplies a pointer where the number of bytes handed to the
+        receiver will be returned. This is zero if there was no receiver ready
+        to take the data, in which case it should be queued instead.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN ByteCount;
+    PUNIX_SOCKET_RECEIVER Receiver;
+    KSTATUS Status;
+
+    *BytesSent = 0;
+    Status = STATUS_SUCCESS;
+    KeAcquireQueuedLock(Remote->Lock);
+    Receiver = Remote->Receiver;
+    if ((Receiver == NULL) ||
+        (LIST_EMPTY(&(Remote->ReceiveList)) == FALSE)) {
+
+        goto UnixSocketSendDirectEnd;
+    }
+
+    //
+    // Credentials are passed as control data, which only packets carry.
+    //
+
+    if (((Sender->Flags | Remote->Flags) &
+         UNIX_SOCKET_FLAG_SEND_CREDENTIALS) != 0) {
+
+        goto UnixSocketSendDirectEnd;
+    }
+
+    if (Remote->KernelSocket.Type != Sender->KernelSocket.Type) {
+        Status = STATUS_UNEXPECTED_TYPE;
+        goto UnixSocketSendDirectEnd;
+    }
+
+    Status = IopUnixSocketEnsureConnected(Remote, FALSE);
+    if (!KSUCCESS(Status)) {
+        Status = STATUS_BROKEN_PIPE;
+        goto UnixSocketSendDirectEnd;
+    }
+
+    //
+    // Streams can hand over as much as fits. A message that doesn't fit is
+    // queued so that the receiver truncates it the usual way.
+    //
+
+    ByteCount = Size;
+    if (ByteCount > Receiver->Size) {
+        if (Sender->KernelSocket.Type != NetSocketStream) {
+            goto UnixSocketSendDirectEnd;
+        }
+
+        ByteCount = Receiver->Size;
+    }
+
+    Status = MmCopyIoBuffer(Receiver->IoBuffer,
+                            0,
+                            IoBuffer,
+                            Offset,
+                            ByteCount);
+
+    if (!KSUCCESS(Status)) {
+        goto UnixSocketSendDirectEnd;
+    }
+
+    Receiver->BytesReceived = ByteCount;
+    Remote->Receiver = NULL;
+    IoSetIoObjectState(Remote->KernelSocket.IoState, POLL_EVENT_IN, TRUE);
+    *BytesSent = ByteCount;
+
+UnixSocketSendDirectEnd:
+    KeReleaseQueuedLock(Remote->Lock);
+    return Status;
+}
+
+KSTATUS
+IopUnixSocketSendPinned (
+    PUNIX_SOCKET Sender,
+    PUNIX_SOCKET Remote,
+    PIO_BUFFER PinnedBuffer,
+    UINTN Offset,
+    UINTN Size,
+    ULONG TimeoutInMilliseconds,
+    PUINTN BytesSent
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues a packet on the remote socket that refers to the
+    sender's locked pages rather than a copy of the data, and waits for the
+    receiver to drain it. This routine assumes neither socket lock is held.
+
+Arguments:
+
+    Sender - Supplies a pointer to the sending socket.
+
+    Remote - Supplies a pointer to the socket being sent to.
+
+    PinnedBuffer - Supplies a pointer to the sender's locked I/O buffer.
+
+    Offset - Supplies the offset within the pinned buffer of the data to send.
+
+    Size - Supplies the number of bytes to send.
+
+    TimeoutInMilliseconds - Supplies the number of milliseconds to wait for
+        the receiver to drain the data.
+
+    BytesSent - Supplies a pointer where the number of bytes the receiver
+        consumed will be returned. This may be less than the size on failure.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PUNIX_SOCKET_PACKET Packet;
+    KSTATUS Status;
+
+    *BytesSent = 0;
+    Packet = NULL;
+    IoSocketAddReference(&(Remote->KernelSocket));
+    Status = IopUnixSocketCreatePacket(Sender, NULL, 0, 0, &Packet);
+    if (!KSUCCESS(Status)) {
+        Packet = NULL;
+        goto UnixSocketSendPinnedEnd;
+    }
+
+    Packet->Data = NULL;
+    Packet->Length = Size;
+    Packet->PinnedBuffer = PinnedBuffer;
+    Packet->PinnedOffset = Offset;
+    Packet->CompletionEvent = KeCreateEvent(NULL);
+    if (Packet->CompletionEvent == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto UnixSocketSendPinnedEnd;
+    }
+
+    KeAcquireQueuedLock(Remote->Lock);
+    if (Remote->KernelSocket.Type != Sender->KernelSocket.Type) {
+        KeReleaseQueuedLock(Remote->Lock);
+        Status = STATUS_UNEXPECTED_TYPE;
+        goto UnixSocketSendPinnedEnd;
+    }
+
+    Status = IopUnixSocketEnsureConnected(Remote, FALSE);
+    if (!KSUCCESS(Status)) {
+        KeReleaseQueuedLock(Remote->Lock);
+        Status = STATUS_BROKEN_PIPE;
+        goto UnixSocketSendPinnedEnd;
+    }
+
+    INSERT_BEFORE(&(Packet->ListEntry), &(Remote->ReceiveList));
+    if (Packet->ListEntry.Previous == &(Remote->ReceiveList)) {
+        IoSetIoObjectState(Remote->KernelSocket.IoState, POLL_EVENT_IN, TRUE);
+    }
+
+    KeReleaseQueuedLock(Remote->Lock);
+    Status = KeWaitForEvent(Packet->CompletionEvent,
+                            TRUE,
+                            TimeoutInMilliseconds);
+
+    //
+    // If the wait failed, pull the packet back off the list unless the
+    // receiver already took it, in which case the event is about to be
+    // signaled.
+    //
+
+    if (!KSUCCESS(Status)) {
+        KeAcquireQueuedLock(Remote->Lock);
+        if (Packet->ListEntry.Next != NULL) {
+            LIST_REMOVE(&(Packet->ListEntry));
+            Packet->ListEntry.Next = NULL;
+            if (LIST_EMPTY(&(Remote->ReceiveList)) != FALSE) {
+                IoSetIoObjectState(Remote->KernelSocket.IoState,
+                                   POLL_EVENT_IN,
+                                   FALSE);
+            }
+
+            KeReleaseQueuedLock(Remote->Lock);
+
+        } else {
+            KeReleaseQueuedLock(Remote->Lock);
+            KeWaitForEvent(Packet->CompletionEvent,
+                           FALSE,
+                           WAIT_TIME_INDEFINITE);
+
+            Status = STATUS_SUCCESS;
+        }
+    }
+
+    //
+    // A packet that came back before it was drained was flushed because the
+    // remote stopped reading.
+    //
+
+    *BytesSent = Packet->Offset;
+    if ((KSUCCESS(Status)) && (Packet->Offset < Packet->Length)) {
+        Status = STATUS_BROKEN_PIPE;
+    }
+
+UnixSocketSendPinnedEnd:
+    if (Packet != NULL) {
+        IopUnixSocketDestroyPacket(Packet);
+    }
+
+    IoSocketReleaseReference(&(Remote->KernelSocket));
+    return Status;
+}
+
 KSTATUS
 IopUnixSocketSendControlData (
     BOOL FromKernelMode,
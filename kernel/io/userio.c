@@ -50,7 +50,8 @@ Module Name:
            (SYS_OPEN_FLAG_NO_CONTROLLING_TERMINAL == \
             OPEN_FLAG_NO_CONTROLLING_TERMINAL) && \
            (SYS_OPEN_FLAG_NO_ACCESS_TIME == OPEN_FLAG_NO_ACCESS_TIME)  && \
-           (SYS_OPEN_FLAG_ASYNCHRONOUS == OPEN_FLAG_ASYNCHRONOUS))
+           (SYS_OPEN_FLAG_ASYNCHRONOUS == OPEN_FLAG_ASYNCHRONOUS) && \
+           (SYS_OPEN_FLAG_DIRECT == OPEN_FLAG_DIRECT))
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -509,6 +510,7 @@ Return Value:
     PKPROCESS CurrentProcess;
     PIO_HANDLE HandleValue;
     IO_BUFFER IoBuffer;
+    ULONG IoFlags;
     PSYSTEM_CALL_PERFORM_IO Parameters;
     INTN Result;
     INTN Size;
@@ -589,11 +591,16 @@ Return Value:
         }
 
     } else {
+        IoFlags = 0;
+        if ((Parameters->Flags & SYS_IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+            IoFlags |= IO_FLAG_DIRECTORY_PROPERTIES;
+        }
+
         Status = IoReadAtOffset(HandleValue,
                                 &IoBuffer,
                                 Parameters->Offset,
                                 Size,
-                                0,
+                                IoFlags,
                                 Timeout,
                                 &BytesCompleted,
                                 NULL);
@@ -2260,6 +2267,50 @@ Return Value:
 
         break;
 
+    case FileControlCommandGetPipeSize:
+        Status = IopGetSetPipeSize(IoHandle,
+                                   FALSE,
+                                   &(LocalParameters.PipeSize));
+
+        if (KSUCCESS(Status)) {
+            CopyOutSize = sizeof(ULONG);
+        }
+
+        break;
+
+    //
+    // Resize a pipe's buffer, returning the size actually chosen.
+    //
+
+    case FileControlCommandSetPipeSize:
+        if (FileControl->Parameters == NULL) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto SysFileControlEnd;
+        }
+
+        Status = MmCopyFromUserMode(&LocalParameters,
+                                    FileControl->Parameters,
+                                    sizeof(ULONG));
+
+        if (!KSUCCESS(Status)) {
+            goto SysFileControlEnd;
+        }
+
+        Status = IopGetSetPipeSize(IoHandle,
+                                   TRUE,
+                                   &(LocalParameters.PipeSize));
+
+        if (KSUCCESS(Status)) {
+            CopyOutSize = sizeof(ULONG);
+        }
+
+        break;
+
+    case FileControlCommandGetAsyncIoCount:
+        LocalParameters.AsyncIoCount = IoHandle->AsyncIoCount;
+        CopyOutSize = sizeof(ULONG);
+        break;
+
     default:
         Status = STATUS_INVALID_PARAMETER;
         break;
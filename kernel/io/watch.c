@@ -0,0 +1,1544 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    watch.c
+
+Abstract:
+
+    This module implements file watch objects. A file watch subscribes to
+    changes on a set of files and directories, and queues a record for each
+    change that is then read from the watch's handle. The handle polls
+    readable whenever records are queued, so a program can sleep until
+    something it cares about changes rather than repeatedly checking.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define FILE_WATCH_ALLOCATION_TAG 0x68637457 // 'hctW'
+
+//
+// Define the maximum number of event records a watch holds before it starts
+// dropping them.
+//
+
+#define FILE_WATCH_MAX_QUEUED_EVENTS 16384
+
+//
+// Define the events that watches on a directory see about its entries.
+//
+
+#define FILE_WATCH_DIRECTORY_EVENTS     \
+    (FILE_WATCH_EVENT_MODIFY |          \
+     FILE_WATCH_EVENT_ATTRIBUTES |      \
+     FILE_WATCH_EVENT_MOVED_FROM |      \
+     FILE_WATCH_EVENT_MOVED_TO |        \
+     FILE_WATCH_EVENT_CREATE |          \
+     FILE_WATCH_EVENT_DELETE)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines a file watch object.
+
+Members:
+
+    Header - Stores the standard object header.
+
+    Lock - Stores a pointer to the lock protecting the event queue.
+
+    IoState - Stores a pointer to the I/O object state of the watch's file
+        object. The in event is set whenever the event queue is not empty.
+
+    EventList - Stores the head of the list of queued event records.
+
+    EventCount - Stores the number of records in the event list.
+
+    EntryList - Stores the head of the list of files being watched. This is
+        protected by the global file watch lock.
+
+    NextDescriptor - Stores the descriptor to hand out to the next file added
+        to the watch. This is protected by the global file watch lock.
+
+--*/
+
+typedef struct _FILE_WATCH {
+    OBJECT_HEADER Header;
+    PQUEUED_LOCK Lock;
+    PIO_OBJECT_STATE IoState;
+    LIST_ENTRY EventList;
+    ULONG EventCount;
+    LIST_ENTRY EntryList;
+    LONG NextDescriptor;
+} FILE_WATCH, *PFILE_WATCH;
+
+/*++
+
+Structure Description:
+
+    This structure defines a single file being watched by a file watch. The
+    entry holds a reference on the file object. All members are protected by
+    the global file watch lock.
+
+Members:
+
+    FileListEntry - Stores pointers to the next and previous entries watching
+        the same file object.
+
+    WatchListEntry - Stores pointers to the next and previous entries in the
+        owning watch.
+
+    Watch - Stores a pointer to the owning watch.
+
+    FileObject - Stores a pointer to the file object being watched.
+
+    Descriptor - Stores the descriptor identifying this entry within the
+        watch.
+
+    Events - Stores the mask of events to report. See FILE_WATCH_EVENT_*
+        definitions.
+
+    Flags - Stores a bitfield of flags. See FILE_WATCH_FLAG_* definitions.
+
+--*/
+
+typedef struct _FILE_WATCH_ENTRY {
+    LIST_ENTRY FileListEntry;
+    LIST_ENTRY WatchListEntry;
+    PFILE_WATCH Watch;
+    PFILE_OBJECT FileObject;
+    LONG Descriptor;
+    ULONG Events;
+    ULONG Flags;
+} FILE_WATCH_ENTRY, *PFILE_WATCH_ENTRY;
+
+/*++
+
+Structure Description:
+
+    This structure defines an event record sitting in a watch's queue.
+
+Members:
+
+    ListEntry - Stores pointers to the next and previous records in the queue.
+
+    Record - Stores the record as it will be handed to the reader. The name
+        immediately follows.
+
+--*/
+
+typedef struct _FILE_WATCH_QUEUED_EVENT {
+    LIST_ENTRY ListEntry;
+    FILE_WATCH_EVENT Record;
+} FILE_WATCH_QUEUED_EVENT, *PFILE_WATCH_QUEUED_EVENT;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+KSTATUS
+IopAddFileWatchEntry (
+    PFILE_WATCH Watch,
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Flags,
+    PLONG Descriptor
+    );
+
+KSTATUS
+IopRemoveFileWatchEntry (
+    PFILE_WATCH Watch,
+    LONG Descriptor
+    );
+
+VOID
+IopReportFileWatchEvents (
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize,
+    PLIST_ENTRY RemovedList
+    );
+
+VOID
+IopUnlinkFileWatchEntry (
+    PFILE_WATCH_ENTRY Entry,
+    PLIST_ENTRY RemovedList
+    );
+
+VOID
+IopFreeFileWatchEntries (
+    PLIST_ENTRY RemovedList
+    );
+
+VOID
+IopQueueFileWatchEvent (
+    PFILE_WATCH Watch,
+    LONG Descriptor,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize
+    );
+
+VOID
+IopDestroyFileWatch (
+    PVOID Object
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the number of files being watched, the lock protecting every file
+// object's watch list, and the source of rename cookies.
+//
+
+volatile ULONG IoFileWatchCount;
+PQUEUED_LOCK IoFileWatchLock;
+volatile ULONG IoFileWatchNextCookie;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateFileWatch (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch object on behalf of user mode.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG HandleFlags;
+    PIO_HANDLE IoHandle;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_CREATE_FILE_WATCH Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_CREATE_FILE_WATCH)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    IoHandle = NULL;
+    Process = PsGetCurrentProcess();
+
+    ASSERT(Process != PsGetKernelProcess());
+
+    if ((Parameters->OpenFlags &
+         ~(SYS_OPEN_FLAG_NON_BLOCKING | SYS_OPEN_FLAG_CLOSE_ON_EXECUTE)) != 0) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateFileWatchEnd;
+    }
+
+    OpenFlags = OPEN_FLAG_CREATE;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_NON_BLOCKING) != 0) {
+        OpenFlags |= OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = IopOpen(FALSE,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ,
+                     OpenFlags,
+                     IoObjectFileWatch,
+                     NULL,
+                     FILE_PERMISSION_USER_READ,
+                     &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateFileWatchEnd;
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(Process->HandleTable,
+                            IoHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateFileWatchEnd;
+    }
+
+    IoHandle = NULL;
+
+SysCreateFileWatchEnd:
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysAddFileWatch (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a file or directory to a file watch, or updates the
+    events reported for one already being watched.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PIO_HANDLE Directory;
+    PIO_HANDLE IoHandle;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_ADD_FILE_WATCH Parameters;
+    PSTR PathCopy;
+    PKPROCESS Process;
+    KSTATUS Status;
+    PIO_HANDLE WatchHandle;
+
+    Directory = NULL;
+    IoHandle = NULL;
+    PathCopy = NULL;
+    Parameters = (PSYSTEM_CALL_ADD_FILE_WATCH)SystemCallParameter;
+    Parameters->Descriptor = -1;
+    Process = PsGetCurrentProcess();
+    WatchHandle = NULL;
+    if ((Parameters->Events == 0) ||
+        ((Parameters->Events & ~FILE_WATCH_EVENT_MASK) != 0) ||
+        ((Parameters->Flags & ~FILE_WATCH_FLAGS_MASK) != 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysAddFileWatchEnd;
+    }
+
+    WatchHandle = ObGetHandleValue(Process->HandleTable,
+                                   Parameters->Handle,
+                                   NULL);
+
+    if (WatchHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysAddFileWatchEnd;
+    }
+
+    if (WatchHandle->FileObject->Properties.Type != IoObjectFileWatch) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysAddFileWatchEnd;
+    }
+
+    Status = MmCreateCopyOfUserModeString(Parameters->Path,
+                                          Parameters->PathSize,
+                                          FILE_WATCH_ALLOCATION_TAG,
+                                          &PathCopy);
+
+    if (!KSUCCESS(Status)) {
+        goto SysAddFileWatchEnd;
+    }
+
+    if (Parameters->Directory != INVALID_HANDLE) {
+        Directory = ObGetHandleValue(Process->HandleTable,
+                                     Parameters->Directory,
+                                     NULL);
+
+        if (Directory == NULL) {
+            Status = STATUS_INVALID_HANDLE;
+            goto SysAddFileWatchEnd;
+        }
+    }
+
+    OpenFlags = 0;
+    if ((Parameters->Flags & FILE_WATCH_FLAG_NO_FOLLOW) != 0) {
+        OpenFlags |= OPEN_FLAG_SYMBOLIC_LINK;
+    }
+
+    if ((Parameters->Flags & FILE_WATCH_FLAG_DIRECTORY_ONLY) != 0) {
+        OpenFlags |= OPEN_FLAG_DIRECTORY;
+    }
+
+    //
+    // Open the file without asking for any access, as opening some objects
+    // for read has side effects. Being able to watch a file still requires
+    // being able to read it.
+    //
+
+    Status = IoOpen(FALSE,
+                    Directory,
+                    PathCopy,
+                    Parameters->PathSize,
+                    0,
+                    OpenFlags,
+                    FILE_PERMISSION_NONE,
+                    &IoHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto SysAddFileWatchEnd;
+    }
+
+    Status = IopCheckPermissions(FALSE, &(IoHandle->PathPoint), IO_ACCESS_READ);
+    if (!KSUCCESS(Status)) {
+        goto SysAddFileWatchEnd;
+    }
+
+    Status = IopAddFileWatchEntry(WatchHandle->FileObject->SpecialIo,
+                                  IoHandle->FileObject,
+                                  Parameters->Events,
+                                  Parameters->Flags,
+                                  &(Parameters->Descriptor));
+
+SysAddFileWatchEnd:
+    if (WatchHandle != NULL) {
+        IoIoHandleReleaseReference(WatchHandle);
+    }
+
+    if (Directory != NULL) {
+        IoIoHandleReleaseReference(Directory);
+    }
+
+    if (IoHandle != NULL) {
+        IoClose(IoHandle);
+    }
+
+    if (PathCopy != NULL) {
+        MmFreePagedPool(PathCopy);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysRemoveFileWatch (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a file or directory from a file watch.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PSYSTEM_CALL_REMOVE_FILE_WATCH Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+    PIO_HANDLE WatchHandle;
+
+    Parameters = (PSYSTEM_CALL_REMOVE_FILE_WATCH)SystemCallParameter;
+    Process = PsGetCurrentProcess();
+    WatchHandle = ObGetHandleValue(Process->HandleTable,
+                                   Parameters->Handle,
+                                   NULL);
+
+    if (WatchHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysRemoveFileWatchEnd;
+    }
+
+    if (WatchHandle->FileObject->Properties.Type != IoObjectFileWatch) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysRemoveFileWatchEnd;
+    }
+
+    Status = IopRemoveFileWatchEntry(WatchHandle->FileObject->SpecialIo,
+                                     Parameters->Descriptor);
+
+SysRemoveFileWatchEnd:
+    if (WatchHandle != NULL) {
+        IoIoHandleReleaseReference(WatchHandle);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopInitializeFileWatchSupport (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    file watch objects.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    IoFileWatchLock = KeCreateQueuedLock();
+    if (IoFileWatchLock == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCreateFileWatch (
+    FILE_PERMISSIONS Permissions,
+    PFILE_OBJECT *FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch object and its file object.
+
+Arguments:
+
+    Permissions - Supplies the permissions to give to the file object.
+
+    FileObject - Supplies a pointer where a pointer to the newly created file
+        object will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    BOOL Created;
+    FILE_PROPERTIES FileProperties;
+    PFILE_OBJECT NewFileObject;
+    KSTATUS Status;
+    PKTHREAD Thread;
+    PFILE_WATCH Watch;
+
+    ASSERT(*FileObject == NULL);
+
+    NewFileObject = NULL;
+
+    //
+    // Create the object. This reference is transferred to the file object's
+    // special I/O member on success.
+    //
+
+    Watch = ObCreateObject(ObjectFileWatch,
+                           NULL,
+                           NULL,
+                           0,
+                           sizeof(FILE_WATCH),
+                           IopDestroyFileWatch,
+                           0,
+                           FILE_WATCH_ALLOCATION_TAG);
+
+    if (Watch == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateFileWatchEnd;
+    }
+
+    INITIALIZE_LIST_HEAD(&(Watch->EventList));
+    INITIALIZE_LIST_HEAD(&(Watch->EntryList));
+    Watch->NextDescriptor = 1;
+    Watch->Lock = KeCreateQueuedLock();
+    if (Watch->Lock == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateFileWatchEnd;
+    }
+
+    Thread = KeGetCurrentThread();
+    IopFillOutFilePropertiesForObject(&FileProperties, &(Watch->Header));
+    FileProperties.Permissions = Permissions;
+    FileProperties.Type = IoObjectFileWatch;
+    FileProperties.UserId = Thread->Identity.EffectiveUserId;
+    FileProperties.GroupId = Thread->Identity.EffectiveGroupId;
+    Status = IopCreateOrLookupFileObject(&FileProperties,
+                                         ObGetRootObject(),
+                                         0,
+                                         &NewFileObject,
+                                         &Created);
+
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Release the reference added by filling out the file properties.
+        //
+
+        ObReleaseReference(Watch);
+        goto CreateFileWatchEnd;
+    }
+
+    ASSERT(Created != FALSE);
+    ASSERT(NewFileObject->IoState != NULL);
+
+    Watch->IoState = NewFileObject->IoState;
+    NewFileObject->SpecialIo = Watch;
+    Watch = NULL;
+    *FileObject = NewFileObject;
+    Status = STATUS_SUCCESS;
+
+CreateFileWatchEnd:
+
+    //
+    // On both success and failure, the file object's ready event needs to be
+    // signaled. Other threads may be waiting on the event.
+    //
+
+    if (NewFileObject != NULL) {
+        KeSignalEvent(NewFileObject->ReadyEvent, SignalOptionSignalAll);
+    }
+
+    if (Watch != NULL) {
+        ObReleaseReference(Watch);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopPerformFileWatchIoOperation (
+    PIO_HANDLE Handle,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads queued event records from a file watch. Writes are not
+    supported.
+
+Arguments:
+
+    Handle - Supplies a pointer to the file watch I/O handle.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    ULONGLONG CurrentTime;
+    ULONGLONG EndTime;
+    PFILE_WATCH_QUEUED_EVENT Event;
+    PFILE_OBJECT FileObject;
+    UINTN RecordSize;
+    ULONG ReturnedEvents;
+    KSTATUS Status;
+    ULONGLONG TimeCounterFrequency;
+    ULONG TimeoutInMilliseconds;
+    PFILE_WATCH Watch;
+
+    FileObject = Handle->FileObject;
+
+    ASSERT(IoContext->IoBuffer != NULL);
+    ASSERT(FileObject->Properties.Type == IoObjectFileWatch);
+
+    Watch = FileObject->SpecialIo;
+    IoContext->BytesCompleted = 0;
+    if (IoContext->Write != FALSE) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    //
+    // Wait for something to show up in the queue. Another reader can empty
+    // the queue between the wake and the lock, so each wait only gets the
+    // time remaining until the original deadline.
+    //
+
+    TimeoutInMilliseconds = IoContext->TimeoutInMilliseconds;
+    EndTime = 0;
+    if ((TimeoutInMilliseconds != 0) &&
+        (TimeoutInMilliseconds != WAIT_TIME_INDEFINITE)) {
+
+        EndTime = KeGetRecentTimeCounter();
+        EndTime += KeConvertMicrosecondsToTimeTicks(
+                                                  TimeoutInMilliseconds *
+                                                  MICROSECONDS_PER_MILLISECOND);
+    }
+
+    TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    while (TRUE) {
+        KeAcquireQueuedLock(Watch->Lock);
+        if (LIST_EMPTY(&(Watch->EventList)) == FALSE) {
+            break;
+        }
+
+        KeReleaseQueuedLock(Watch->Lock);
+        if (TimeoutInMilliseconds == 0) {
+            if (EndTime != 0) {
+                return STATUS_TIMEOUT;
+            }
+
+            return STATUS_TRY_AGAIN;
+        }
+
+        Status = IoWaitForIoObjectState(Watch->IoState,
+                                        POLL_EVENT_IN,
+                                        TRUE,
+                                        TimeoutInMilliseconds,
+                                        &ReturnedEvents);
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+
+        if (EndTime != 0) {
+            CurrentTime = KeGetRecentTimeCounter();
+            if (CurrentTime >= EndTime) {
+                TimeoutInMilliseconds = 0;
+
+            } else {
+                TimeoutInMilliseconds = ((EndTime - CurrentTime) *
+                                         MILLISECONDS_PER_SECOND) /
+                                        TimeCounterFrequency;
+            }
+        }
+    }
+
+    //
+    // Hand out as many whole records as fit in the caller's buffer.
+    //
+
+    Status = STATUS_SUCCESS;
+    CurrentEntry = Watch->EventList.Next;
+    while (CurrentEntry != &(Watch->EventList)) {
+        Event = LIST_VALUE(CurrentEntry, FILE_WATCH_QUEUED_EVENT, ListEntry);
+        RecordSize = FIELD_OFFSET(FILE_WATCH_EVENT, Name) +
+                     Event->Record.NameSize;
+
+        if (IoContext->BytesCompleted + RecordSize > IoContext->SizeInBytes) {
+            break;
+        }
+
+        Status = MmCopyIoBufferData(IoContext->IoBuffer,
+                                    &(Event->Record),
+                                    IoContext->BytesCompleted,
+                                    RecordSize,
+                                    TRUE);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        CurrentEntry = CurrentEntry->Next;
+        LIST_REMOVE(&(Event->ListEntry));
+        Watch->EventCount -= 1;
+        MmFreePagedPool(Event);
+        IoContext->BytesCompleted += RecordSize;
+    }
+
+    if (LIST_EMPTY(&(Watch->EventList)) != FALSE) {
+        IoSetIoObjectState(Watch->IoState, POLL_EVENT_IN, FALSE);
+    }
+
+    KeReleaseQueuedLock(Watch->Lock);
+
+    //
+    // A buffer too small for even the first record is an error, since
+    // returning zero bytes would look like the end of the file.
+    //
+
+    if ((KSUCCESS(Status)) && (IoContext->BytesCompleted == 0)) {
+        Status = STATUS_BUFFER_TOO_SMALL;
+    }
+
+    return Status;
+}
+
+VOID
+IopNotifyFileWatches (
+    PFILE_OBJECT Directory,
+    PCSTR Name,
+    ULONG NameSize,
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Cookie
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reports that something happened to an entry in a directory.
+    Watches on the directory receive the events along with the entry's name,
+    and watches on the entry's file object receive the corresponding events
+    about the file itself. Callers should check IoFileWatchCount before
+    calling this routine.
+
+Arguments:
+
+    Directory - Supplies an optional pointer to the file object of the
+        directory containing the entry. Supply NULL to only notify watches on
+        the file itself.
+
+    Name - Supplies a pointer to the name of the entry within the directory.
+
+    NameSize - Supplies the size of the name buffer in bytes, including the
+        null terminator.
+
+    FileObject - Supplies an optional pointer to the file object the entry
+        refers to.
+
+    Events - Supplies the events that occurred, from the directory's point of
+        view. See FILE_WATCH_EVENT_* definitions.
+
+    Cookie - Supplies the cookie pairing the two halves of a rename, or zero.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG DirectoryEvents;
+    LIST_ENTRY RemovedList;
+    ULONG SelfEvents;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+    ASSERT((Events & ~FILE_WATCH_DIRECTORY_EVENTS) == 0);
+
+    //
+    // Translate what happened to the entry into what happened to the file.
+    // Creating or moving a name onto a file does nothing to the file itself,
+    // removing a name changes its link count or deletes it, and moving a name
+    // away is the file moving.
+    //
+
+    SelfEvents = Events & (FILE_WATCH_EVENT_MODIFY |
+                           FILE_WATCH_EVENT_ATTRIBUTES);
+
+    DirectoryEvents = Events;
+    if (FileObject != NULL) {
+        if ((Events & FILE_WATCH_EVENT_DELETE) != 0) {
+            if (FileObject->Properties.HardLinkCount == 0) {
+                SelfEvents |= FILE_WATCH_EVENT_DELETE_SELF;
+
+            } else {
+                SelfEvents |= FILE_WATCH_EVENT_ATTRIBUTES;
+            }
+        }
+
+        if ((Events & FILE_WATCH_EVENT_MOVED_FROM) != 0) {
+            SelfEvents |= FILE_WATCH_EVENT_MOVE_SELF;
+        }
+
+        if ((FileObject->Properties.Type == IoObjectRegularDirectory) ||
+            (FileObject->Properties.Type == IoObjectObjectDirectory)) {
+
+            DirectoryEvents |= FILE_WATCH_EVENT_DIRECTORY;
+        }
+    }
+
+    INITIALIZE_LIST_HEAD(&RemovedList);
+    KeAcquireQueuedLock(IoFileWatchLock);
+    if ((Directory != NULL) && (Name != NULL)) {
+        IopReportFileWatchEvents(Directory,
+                                 DirectoryEvents,
+                                 Cookie,
+                                 Name,
+                                 NameSize,
+                                 &RemovedList);
+    }
+
+    if ((FileObject != NULL) && (SelfEvents != 0)) {
+        IopReportFileWatchEvents(FileObject,
+                                 SelfEvents,
+                                 0,
+                                 NULL,
+                                 0,
+                                 &RemovedList);
+    }
+
+    KeReleaseQueuedLock(IoFileWatchLock);
+    IopFreeFileWatchEntries(&RemovedList);
+    return;
+}
+
+VOID
+IopNotifyFileWatchesOfRename (
+    PFILE_OBJECT SourceDirectory,
+    PCSTR SourceName,
+    ULONG SourceNameSize,
+    PFILE_OBJECT DestinationDirectory,
+    PCSTR DestinationName,
+    ULONG DestinationNameSize,
+    PFILE_OBJECT FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reports a successful rename to any interested file watches.
+    Callers should check IoFileWatchCount before calling this routine.
+
+Arguments:
+
+    SourceDirectory - Supplies a pointer to the directory the file was moved
+        out of.
+
+    SourceName - Supplies a pointer to the old name of the file.
+
+    SourceNameSize - Supplies the size of the old name buffer in bytes,
+        including the null terminator.
+
+    DestinationDirectory - Supplies a pointer to the directory the file was
+        moved into.
+
+    DestinationName - Supplies a pointer to the new name of the file.
+
+    DestinationNameSize - Supplies the size of the new name buffer in bytes,
+        including the null terminator.
+
+    FileObject - Supplies a pointer to the file object that was renamed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Cookie;
+
+    //
+    // Zero means "no cookie", so skip it if the counter wraps.
+    //
+
+    Cookie = RtlAtomicAdd32(&IoFileWatchNextCookie, 1) + 1;
+    if (Cookie == 0) {
+        Cookie = RtlAtomicAdd32(&IoFileWatchNextCookie, 1) + 1;
+    }
+
+    IopNotifyFileWatches(SourceDirectory,
+                         SourceName,
+                         SourceNameSize,
+                         FileObject,
+                         FILE_WATCH_EVENT_MOVED_FROM,
+                         Cookie);
+
+    IopNotifyFileWatches(DestinationDirectory,
+                         DestinationName,
+                         DestinationNameSize,
+                         FileObject,
+                         FILE_WATCH_EVENT_MOVED_TO,
+                         Cookie);
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+KSTATUS
+IopAddFileWatchEntry (
+    PFILE_WATCH Watch,
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Flags,
+    PLONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts watching the given file object, or updates the events
+    reported if the watch is already watching it.
+
+Arguments:
+
+    Watch - Supplies a pointer to the file watch.
+
+    FileObject - Supplies a pointer to the file object to watch.
+
+    Events - Supplies the mask of events to report.
+
+    Flags - Supplies a bitfield of flags. See FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Supplies a pointer where the descriptor of the entry will be
+        returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PFILE_WATCH_ENTRY Entry;
+    PFILE_WATCH_ENTRY NewEntry;
+
+    NewEntry = MmAllocatePagedPool(sizeof(FILE_WATCH_ENTRY),
+                                   FILE_WATCH_ALLOCATION_TAG);
+
+    if (NewEntry == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(NewEntry, sizeof(FILE_WATCH_ENTRY));
+    KeAcquireQueuedLock(IoFileWatchLock);
+
+    //
+    // If this watch already covers the file, update the existing entry.
+    //
+
+    CurrentEntry = FileObject->WatchListHead.Next;
+    while (CurrentEntry != &(FileObject->WatchListHead)) {
+        Entry = LIST_VALUE(CurrentEntry, FILE_WATCH_ENTRY, FileListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if (Entry->Watch != Watch) {
+            continue;
+        }
+
+        if ((Flags & FILE_WATCH_FLAG_ADD) != 0) {
+            Entry->Events |= Events;
+
+        } else {
+            Entry->Events = Events;
+        }
+
+        Entry->Flags = Flags & ~FILE_WATCH_FLAG_ADD;
+        *Descriptor = Entry->Descriptor;
+        KeReleaseQueuedLock(IoFileWatchLock);
+        MmFreePagedPool(NewEntry);
+        return STATUS_SUCCESS;
+    }
+
+    if (Watch->NextDescriptor == MAX_LONG) {
+        KeReleaseQueuedLock(IoFileWatchLock);
+        MmFreePagedPool(NewEntry);
+        return STATUS_TOO_MANY_HANDLES;
+    }
+
+    NewEntry->Watch = Watch;
+    NewEntry->FileObject = FileObject;
+    NewEntry->Descriptor = Watch->NextDescriptor;
+    NewEntry->Events = Events;
+    NewEntry->Flags = Flags & ~FILE_WATCH_FLAG_ADD;
+    Watch->NextDescriptor += 1;
+    IopFileObjectAddReference(FileObject);
+    INSERT_BEFORE(&(NewEntry->FileListEntry), &(FileObject->WatchListHead));
+    INSERT_BEFORE(&(NewEntry->WatchListEntry), &(Watch->EntryList));
+    IoFileWatchCount += 1;
+    *Descriptor = NewEntry->Descriptor;
+    KeReleaseQueuedLock(IoFileWatchLock);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopRemoveFileWatchEntry (
+    PFILE_WATCH Watch,
+    LONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops watching the file with the given descriptor.
+
+Arguments:
+
+    Watch - Supplies a pointer to the file watch.
+
+    Descriptor - Supplies the descriptor returned when the file was added.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INVALID_PARAMETER if the watch has no such descriptor.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PFILE_WATCH_ENTRY Entry;
+    LIST_ENTRY RemovedList;
+    KSTATUS Status;
+
+    INITIALIZE_LIST_HEAD(&RemovedList);
+    Status = STATUS_INVALID_PARAMETER;
+    KeAcquireQueuedLock(IoFileWatchLock);
+    CurrentEntry = Watch->EntryList.Next;
+    while (CurrentEntry != &(Watch->EntryList)) {
+        Entry = LIST_VALUE(CurrentEntry, FILE_WATCH_ENTRY, WatchListEntry);
+        if (Entry->Descriptor == Descriptor) {
+            IopUnlinkFileWatchEntry(Entry, &RemovedList);
+            Status = STATUS_SUCCESS;
+            break;
+        }
+
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    KeReleaseQueuedLock(IoFileWatchLock);
+    IopFreeFileWatchEntries(&RemovedList);
+    return Status;
+}
+
+VOID
+IopReportFileWatchEvents (
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize,
+    PLIST_ENTRY RemovedList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues events to every watch on the given file object that
+    is interested in them. The caller must hold the global file watch lock.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object the events happened
+        to.
+
+    Events - Supplies the events that occurred.
+
+    Cookie - Supplies the cookie pairing the two halves of a rename, or zero.
+
+    Name - Supplies an optional pointer to the name of the directory entry
+        the events describe.
+
+    NameSize - Supplies the size of the name buffer in bytes, including the
+        null terminator.
+
+    RemovedList - Supplies a pointer to a list where any entries removed as a
+        result of these events are placed. The caller frees them after
+        releasing the global file watch lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PFILE_WATCH_ENTRY Entry;
+    ULONG Matched;
+
+    CurrentEntry = FileObject->WatchListHead.Next;
+    while (CurrentEntry != &(FileObject->WatchListHead)) {
+        Entry = LIST_VALUE(CurrentEntry, FILE_WATCH_ENTRY, FileListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        Matched = Events & Entry->Events;
+        if (Matched != 0) {
+            Matched |= Events & FILE_WATCH_EVENT_DIRECTORY;
+            IopQueueFileWatchEvent(Entry->Watch,
+                                   Entry->Descriptor,
+                                   Matched,
+                                   Cookie,
+                                   Name,
+                                   NameSize);
+
+            if ((Entry->Flags & FILE_WATCH_FLAG_ONE_SHOT) != 0) {
+                IopUnlinkFileWatchEntry(Entry, RemovedList);
+                continue;
+            }
+        }
+
+        //
+        // Once the file is gone there is nothing left to watch.
+        //
+
+        if ((Events & FILE_WATCH_EVENT_DELETE_SELF) != 0) {
+            IopUnlinkFileWatchEntry(Entry, RemovedList);
+        }
+    }
+
+    return;
+}
+
+VOID
+IopUnlinkFileWatchEntry (
+    PFILE_WATCH_ENTRY Entry,
+    PLIST_ENTRY RemovedList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch entry from its file object and watch, and
+    lets the watch's reader know that the descriptor is no longer in use. The
+    caller must hold the global file watch lock.
+
+Arguments:
+
+    Entry - Supplies a pointer to the entry to remove.
+
+    RemovedList - Supplies a pointer to the list the entry is moved to. The
+        caller frees the entries on it after releasing the global file watch
+        lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(IoFileWatchCount != 0);
+
+    IopQueueFileWatchEvent(Entry->Watch,
+                           Entry->Descriptor,
+                           FILE_WATCH_EVENT_IGNORED,
+                           0,
+                           NULL,
+                           0);
+
+    LIST_REMOVE(&(Entry->WatchListEntry));
+    LIST_REMOVE(&(Entry->FileListEntry));
+    INSERT_BEFORE(&(Entry->FileListEntry), RemovedList);
+    IoFileWatchCount -= 1;
+    return;
+}
+
+VOID
+IopFreeFileWatchEntries (
+    PLIST_ENTRY RemovedList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases the file object references held by a list of
+    removed watch entries and frees them. This must be called without the
+    global file watch lock held, as releasing a file object may need to talk
+    to its file system.
+
+Arguments:
+
+    RemovedList - Supplies a pointer to the head of the list of entries,
+        linked through their file list entries.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFILE_WATCH_ENTRY Entry;
+
+    while (LIST_EMPTY(RemovedList) == FALSE) {
+        Entry = LIST_VALUE(RemovedList->Next, FILE_WATCH_ENTRY, FileListEntry);
+        LIST_REMOVE(&(Entry->FileListEntry));
+        IopFileObjectReleaseReference(Entry->FileObject);
+        MmFreePagedPool(Entry);
+    }
+
+    return;
+}
+
+VOID
+IopQueueFileWatchEvent (
+    PFILE_WATCH Watch,
+    LONG Descriptor,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends an event record to a watch's queue. A record
+    identical to the one at the end of the queue is dropped, so that a stream
+    of writes to a file shows up once until the reader catches up. If the
+    queue is full, a single overflow record is queued instead.
+
+Arguments:
+
+    Watch - Supplies a pointer to the watch.
+
+    Descriptor - Supplies the descriptor of the entry that saw the event.
+
+    Events - Supplies the events to report.
+
+    Cookie - Supplies the rename cookie, or zero.
+
+    Name - Supplies an optional pointer to the name of the directory entry
+        the events describe.
+
+    NameSize - Supplies the size of the name buffer in bytes, including the
+        null terminator.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    PFILE_WATCH_QUEUED_EVENT Event;
+    PFILE_WATCH_QUEUED_EVENT LastEvent;
+    ULONG NameLength;
+    ULONG PaddedNameSize;
+
+    NameLength = 0;
+    PaddedNameSize = 0;
+    if (Name != NULL) {
+        NameLength = RtlStringLength(Name);
+        if (NameLength >= NameSize) {
+            NameLength = NameSize - 1;
+        }
+
+        PaddedNameSize = ALIGN_RANGE_UP(NameLength + 1, sizeof(ULONG));
+    }
+
+    AllocationSize = sizeof(FILE_WATCH_QUEUED_EVENT) -
+                     sizeof(FILE_WATCH_EVENT) +
+                     FIELD_OFFSET(FILE_WATCH_EVENT, Name) +
+                     PaddedNameSize;
+
+    Event = MmAllocatePagedPool(AllocationSize, FILE_WATCH_ALLOCATION_TAG);
+    KeAcquireQueuedLock(Watch->Lock);
+    if (LIST_EMPTY(&(Watch->EventList)) == FALSE) {
+        LastEvent = LIST_VALUE(Watch->EventList.Previous,
+                               FILE_WATCH_QUEUED_EVENT,
+                               ListEntry);
+
+        if ((LastEvent->Record.Events & FILE_WATCH_EVENT_OVERFLOW) != 0) {
+            goto QueueFileWatchEventEnd;
+        }
+
+        if ((LastEvent->Record.Descriptor == Descriptor) &&
+            (LastEvent->Record.Events == Events) &&
+            (LastEvent->Record.Cookie == Cookie) &&
+            (LastEvent->Record.NameSize == PaddedNameSize) &&
+            ((PaddedNameSize == 0) ||
+             (RtlAreStringsEqual(LastEvent->Record.Name,
+                                 Name,
+                                 NameLength + 1) != FALSE))) {
+
+            goto QueueFileWatchEventEnd;
+        }
+    }
+
+    if (Event == NULL) {
+        goto QueueFileWatchEventEnd;
+    }
+
+    RtlZeroMemory(&(Event->Record),
+                  FIELD_OFFSET(FILE_WATCH_EVENT, Name) + PaddedNameSize);
+
+    //
+    // The last slot is reserved for the overflow record.
+    //
+
+    if (Watch->EventCount >= FILE_WATCH_MAX_QUEUED_EVENTS - 1) {
+        Event->Record.Descriptor = -1;
+        Event->Record.Events = FILE_WATCH_EVENT_OVERFLOW;
+
+    } else {
+        Event->Record.Descriptor = Descriptor;
+        Event->Record.Events = Events;
+        Event->Record.Cookie = Cookie;
+        Event->Record.NameSize = PaddedNameSize;
+        if (PaddedNameSize != 0) {
+            RtlCopyMemory(Event->Record.Name, Name, NameLength);
+        }
+    }
+
+    INSERT_BEFORE(&(Event->ListEntry), &(Watch->EventList));
+    Watch->EventCount += 1;
+    Event = NULL;
+    IoSetIoObjectState(Watch->IoState, POLL_EVENT_IN, TRUE);
+
+QueueFileWatchEventEnd:
+    KeReleaseQueuedLock(Watch->Lock);
+    if (Event != NULL) {
+        MmFreePagedPool(Event);
+    }
+
+    return;
+}
+
+VOID
+IopDestroyFileWatch (
+    PVOID Object
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a file watch object, releasing every file it was
+    watching and any records that were never read.
+
+Arguments:
+
+    Object - Supplies a pointer to the file watch being destroyed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFILE_WATCH_ENTRY Entry;
+    PFILE_WATCH_QUEUED_EVENT Event;
+    LIST_ENTRY RemovedList;
+    PFILE_WATCH Watch;
+
+    Watch = Object;
+
+    //
+    // Pull the entries off of the file objects so that no more events get
+    // queued. The list heads are only initialized once the object was fully
+    // created.
+    //
+
+    INITIALIZE_LIST_HEAD(&RemovedList);
+    if (Watch->EntryList.Next != NULL) {
+        KeAcquireQueuedLock(IoFileWatchLock);
+        while (LIST_EMPTY(&(Watch->EntryList)) == FALSE) {
+            Entry = LIST_VALUE(Watch->EntryList.Next,
+                               FILE_WATCH_ENTRY,
+                               WatchListEntry);
+
+            LIST_REMOVE(&(Entry->WatchListEntry));
+            LIST_REMOVE(&(Entry->FileListEntry));
+            INSERT_BEFORE(&(Entry->FileListEntry), &RemovedList);
+
+            ASSERT(IoFileWatchCount != 0);
+
+            IoFileWatchCount -= 1;
+        }
+
+        KeReleaseQueuedLock(IoFileWatchLock);
+        IopFreeFileWatchEntries(&RemovedList);
+    }
+
+    if (Watch->EventList.Next != NULL) {
+        while (LIST_EMPTY(&(Watch->EventList)) == FALSE) {
+            Event = LIST_VALUE(Watch->EventList.Next,
+                               FILE_WATCH_QUEUED_EVENT,
+                               ListEntry);
+
+            LIST_REMOVE(&(Event->ListEntry));
+            MmFreePagedPool(Event);
+        }
+    }
+
+    if (Watch->Lock != NULL) {
+        KeDestroyQueuedLock(Watch->Lock);
+    }
+
+    return;
+}
+
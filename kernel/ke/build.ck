@@ -44,6 +44,7 @@ function build() {
         "syscall.c",
         "sysclock.c",
         "sysres.c",
+        "timeline.c",
         "timer.c",
         "timezone.c",
         "version.c",
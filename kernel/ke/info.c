@@ -568,6 +568,10 @@ Return Value:
         Status = KepGetKernelCommandLine(Data, DataSize, Set);
         break;
 
+    case KeInformationBootTimeline:
+        Status = KepGetBootTimeline(Data, DataSize, Set);
+        break;
+
     default:
         Status = STATUS_INVALID_PARAMETER;
         *DataSize = 0;
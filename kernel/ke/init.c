@@ -127,6 +127,7 @@ Return Value:
 
 {
 
+    ULONGLONG PhaseStart;
     PPROCESSOR_BLOCK ProcessorBlock;
     KSTATUS Status;
 
@@ -143,7 +144,18 @@ Return Value:
         INITIALIZE_LIST_HEAD(&(ProcessorBlock->DpcList));
         KeInitializeSpinLock(&(ProcessorBlock->DpcLock));
         ProcessorBlock->CyclePeriodAccount = CycleAccountKernel;
+        if (ProcessorBlock->ProcessorNumber == 0) {
+            KepInitializeBootTimeline(Parameters);
+        }
+
+        PhaseStart = KeGetBootTimelineTimestamp();
         KepInitializeScheduler(ProcessorBlock);
+        if (ProcessorBlock->ProcessorNumber == 0) {
+            KeRecordBootTimelineEvent(BootTimelineEventKernelPhase,
+                                      "KepInitializeScheduler",
+                                      PhaseStart,
+                                      KeGetBootTimelineTimestamp());
+        }
 
         ASSERT(ProcessorBlock->ProcessorNumber < KeProcessorBlockArraySize);
 
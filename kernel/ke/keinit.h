@@ -143,6 +143,28 @@ Return Value:
 
 --*/
 
+VOID
+KepInitializeBootTimeline (
+    PKERNEL_INITIALIZATION_BLOCK Parameters
+    );
+
+/*++
+
+Routine Description:
+
+    This routine seeds the boot timeline with the events recorded by the
+    loader. This must be called before loader memory is released.
+
+Arguments:
+
+    Parameters - Supplies a pointer to the kernel initialization block.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 KepInitializeBaseVideo (
     PKERNEL_INITIALIZATION_BLOCK Parameters
@@ -224,6 +224,52 @@ SYSTEM_CALL_TABLE_ENTRY KeSystemCallTable[SystemCallCount] = {
     {MmSysSetBreak,
         sizeof(SYSTEM_CALL_SET_BREAK),
         sizeof(SYSTEM_CALL_SET_BREAK)},
+    {IoSysCreateEventPoll,
+        sizeof(SYSTEM_CALL_CREATE_EVENT_POLL),
+        sizeof(SYSTEM_CALL_CREATE_EVENT_POLL)},
+    {IoSysEventPollControl, sizeof(SYSTEM_CALL_EVENT_POLL_CONTROL), 0},
+    {IoSysEventPollWait, sizeof(SYSTEM_CALL_EVENT_POLL_WAIT), 0},
+    {IoSysCreateEventCounter,
+        sizeof(SYSTEM_CALL_CREATE_EVENT_COUNTER),
+        sizeof(SYSTEM_CALL_CREATE_EVENT_COUNTER)},
+    {IoSysCreateIoTimer,
+        sizeof(SYSTEM_CALL_CREATE_IO_TIMER),
+        sizeof(SYSTEM_CALL_CREATE_IO_TIMER)},
+    {IoSysIoTimerControl,
+        sizeof(SYSTEM_CALL_IO_TIMER_CONTROL),
+        sizeof(SYSTEM_CALL_IO_TIMER_CONTROL)},
+    {IoSysSendFile,
+        sizeof(SYSTEM_CALL_SEND_FILE),
+        sizeof(SYSTEM_CALL_SEND_FILE)},
+    {IoSysCreateAsyncIoContext,
+        sizeof(SYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT),
+        sizeof(SYSTEM_CALL_CREATE_ASYNC_IO_CONTEXT)},
+    {IoSysSubmitAsyncIo, sizeof(SYSTEM_CALL_SUBMIT_ASYNC_IO), 0},
+    {IoSysWaitForAsyncIo,
+        sizeof(SYSTEM_CALL_WAIT_FOR_ASYNC_IO),
+        sizeof(SYSTEM_CALL_WAIT_FOR_ASYNC_IO)},
+    {IoSysCreateIoRing,
+        sizeof(SYSTEM_CALL_CREATE_IO_RING),
+        sizeof(SYSTEM_CALL_CREATE_IO_RING)},
+    {IoSysEnterIoRing, sizeof(SYSTEM_CALL_ENTER_IO_RING), 0},
+    {IoSysSplice, sizeof(SYSTEM_CALL_SPLICE), sizeof(SYSTEM_CALL_SPLICE)},
+    {IoSysSpliceMemory, sizeof(SYSTEM_CALL_SPLICE_MEMORY), 0},
+    {IoSysSocketPerformBatchIo,
+        sizeof(SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO),
+        0},
+    {PsSysSetIoPriority,
+        sizeof(SYSTEM_CALL_SET_IO_PRIORITY),
+        sizeof(SYSTEM_CALL_SET_IO_PRIORITY)},
+    {IoSysCopyFileRange,
+        sizeof(SYSTEM_CALL_COPY_FILE_RANGE),
+        sizeof(SYSTEM_CALL_COPY_FILE_RANGE)},
+    {IoSysCreateFileWatch,
+        sizeof(SYSTEM_CALL_CREATE_FILE_WATCH),
+        sizeof(SYSTEM_CALL_CREATE_FILE_WATCH)},
+    {IoSysAddFileWatch,
+        sizeof(SYSTEM_CALL_ADD_FILE_WATCH),
+        sizeof(SYSTEM_CALL_ADD_FILE_WATCH)},
+    {IoSysRemoveFileWatch, sizeof(SYSTEM_CALL_REMOVE_FILE_WATCH), 0},
 };
 
 //
@@ -0,0 +1,324 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    timeline.c
+
+Abstract:
+
+    This module implements the boot timeline, a record of how long the major
+    pieces of boot took from the loader up to the first user mode process.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "keinit.h"
+#include "kep.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the number of events the boot timeline can hold. The buffer is
+// static so that events can be recorded before pool is available.
+//
+
+#define KE_BOOT_TIMELINE_EVENT_COUNT 512
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the boot timeline. Slots are claimed by atomically incrementing the
+// next index, and the type is filled in last so that readers can skip slots
+// still being written.
+//
+
+BOOT_TIMELINE_EVENT KeBootTimeline[KE_BOOT_TIMELINE_EVENT_COUNT];
+volatile ULONG KeBootTimelineNextIndex;
+volatile ULONG KeBootTimelineDroppedCount;
+
+//
+// Once the first user mode process is running, the timeline stops accepting
+// new events.
+//
+
+volatile BOOL KeBootTimelineClosed;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+KERNEL_API
+ULONGLONG
+KeGetBootTimelineTimestamp (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns a timestamp suitable for recording on the boot
+    timeline. This routine can be called at any runlevel.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current processor counter value, or 0 if the processor counter
+    is not yet available.
+
+--*/
+
+{
+
+    RUNLEVEL OldRunLevel;
+    ULONGLONG Timestamp;
+
+    if ((KeBootTimelineClosed != FALSE) ||
+        (HlQueryProcessorCounterFrequency() == 0)) {
+
+        return 0;
+    }
+
+    //
+    // The processor counter must be read at dispatch or above.
+    //
+
+    if (KeGetRunLevel() < RunLevelDispatch) {
+        OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+        Timestamp = HlQueryProcessorCounter();
+        KeLowerRunLevel(OldRunLevel);
+
+    } else {
+        Timestamp = HlQueryProcessorCounter();
+    }
+
+    return Timestamp;
+}
+
+KERNEL_API
+VOID
+KeRecordBootTimelineEvent (
+    BOOT_TIMELINE_EVENT_TYPE Type,
+    PCSTR Name,
+    ULONGLONG Start,
+    ULONGLONG End
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records an event on the boot timeline. Events are only
+    recorded until the first user mode process starts; after that this routine
+    does nothing. This routine can be called at any runlevel.
+
+Arguments:
+
+    Type - Supplies the category of the event.
+
+    Name - Supplies a pointer to the name of the event. Names longer than the
+        event buffer are truncated.
+
+    Start - Supplies the timestamp when the event began, as returned by
+        KeGetBootTimelineTimestamp.
+
+    End - Supplies the timestamp when the event finished.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PBOOT_TIMELINE_EVENT Event;
+    ULONG Index;
+
+    ASSERT((Type > BootTimelineEventInvalid) &&
+           (Type <= BootTimelineEventUserMode));
+
+    if (KeBootTimelineClosed != FALSE) {
+        return;
+    }
+
+    Index = RtlAtomicAdd32(&KeBootTimelineNextIndex, 1);
+    if (Index >= KE_BOOT_TIMELINE_EVENT_COUNT) {
+        RtlAtomicAdd32(&KeBootTimelineDroppedCount, 1);
+        return;
+    }
+
+    Event = &(KeBootTimeline[Index]);
+    Event->Start = Start;
+    Event->End = End;
+    if (Name == NULL) {
+        Name = "";
+    }
+
+    RtlStringCopy(Event->Name, Name, BOOT_TIMELINE_NAME_SIZE);
+    RtlMemoryBarrier();
+    Event->Type = Type;
+
+    //
+    // Everything after the first user mode process is the business of user
+    // mode, so stop recording.
+    //
+
+    if (Type == BootTimelineEventUserMode) {
+        KeBootTimelineClosed = TRUE;
+    }
+
+    return;
+}
+
+VOID
+KepInitializeBootTimeline (
+    PKERNEL_INITIALIZATION_BLOCK Parameters
+    )
+
+/*++
+
+Routine Description:
+
+    This routine seeds the boot timeline with the events recorded by the
+    loader. This must be called before loader memory is released.
+
+Arguments:
+
+    Parameters - Supplies a pointer to the kernel initialization block.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PBOOT_TIMELINE_EVENT Event;
+    ULONG Index;
+
+    if (Parameters->BootTimeline == NULL) {
+        return;
+    }
+
+    for (Index = 0; Index < Parameters->BootTimelineCount; Index += 1) {
+        Event = &(Parameters->BootTimeline[Index]);
+        if ((Event->Type <= BootTimelineEventInvalid) ||
+            (Event->Type > BootTimelineEventUserMode)) {
+
+            continue;
+        }
+
+        KeRecordBootTimelineEvent(Event->Type,
+                                  Event->Name,
+                                  Event->Start,
+                                  Event->End);
+    }
+
+    return;
+}
+
+KSTATUS
+KepGetBootTimeline (
+    PVOID Data,
+    PUINTN DataSize,
+    BOOL Set
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets the boot timeline.
+
+Arguments:
+
+    Data - Supplies a pointer to the data buffer where the data is either
+        returned for a get operation or given for a set operation.
+
+    DataSize - Supplies a pointer that on input contains the size of the
+        data buffer. On output, contains the required size of the data buffer.
+
+    Set - Supplies a boolean indicating if this is a get operation (FALSE) or
+        a set operation (TRUE).
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG EventCount;
+    PBOOT_TIMELINE_INFORMATION Information;
+    UINTN RequiredSize;
+
+    if (Set != FALSE) {
+        return STATUS_ACCESS_DENIED;
+    }
+
+    EventCount = KeBootTimelineNextIndex;
+    if (EventCount > KE_BOOT_TIMELINE_EVENT_COUNT) {
+        EventCount = KE_BOOT_TIMELINE_EVENT_COUNT;
+    }
+
+    RequiredSize = FIELD_OFFSET(BOOT_TIMELINE_INFORMATION, Events) +
+                   (EventCount * sizeof(BOOT_TIMELINE_EVENT));
+
+    if (*DataSize < RequiredSize) {
+        *DataSize = RequiredSize;
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    Information = Data;
+    Information->Frequency = HlQueryProcessorCounterFrequency();
+    Information->EventCount = EventCount;
+    Information->DroppedCount = KeBootTimelineDroppedCount;
+    RtlCopyMemory(Information->Events,
+                  KeBootTimeline,
+                  EventCount * sizeof(BOOT_TIMELINE_EVENT));
+
+    *DataSize = RequiredSize;
+    return STATUS_SUCCESS;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -97,6 +97,16 @@ Structure Description:
     Name - Stores a pointer to a string containing the name of the worker
         threads.
 
+    FlushGeneration - Stores the number of times a flush has switched the
+        slot that newly started work items are counted in. The low bit is
+        the current slot.
+
+    ActiveCount - Stores the number of work items currently running that
+        were started in each slot.
+
+    FlushEvent - Stores a pointer to the event signaled when a slot's count
+        of running work items drops to zero.
+
 --*/
 
 struct _WORK_QUEUE {
@@ -112,6 +122,9 @@ struct _WORK_QUEUE {
     ULONG Flags;
     volatile ULONG CurrentThreadCount;
     PSTR Name;
+    ULONG FlushGeneration;
+    ULONG ActiveCount[2];
+    PKEVENT FlushEvent;
 };
 
 /*++
@@ -169,6 +182,92 @@ KepDestroyWorkQueue (
     PWORK_QUEUE Queue
     );
 
+RUNLEVEL
+KepAcquireWorkQueueLock (
+    PWORK_QUEUE Queue
+    );
+
+VOID
+KepReleaseWorkQueueLock (
+    PWORK_QUEUE Queue,
+    RUNLEVEL OldRunLevel
+    );
+
+RUNLEVEL
+KepAcquireWorkQueueLock (
+    PWORK_QUEUE Queue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine acquires a work queue's lock, raising to dispatch level first
+    if the queue supports work items queued at dispatch.
+
+Arguments:
+
+    Queue - Supplies a pointer to the work queue.
+
+Return Value:
+
+    Returns the original run level, to be passed when releasing the lock.
+
+--*/
+
+{
+
+    RUNLEVEL OldRunLevel;
+
+    OldRunLevel = RunLevelCount;
+    if ((Queue->Flags & WORK_QUEUE_FLAG_SUPPORT_DISPATCH_LEVEL) != 0) {
+        OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+        KeAcquireSpinLock(&(Queue->Lock.SpinLock));
+
+    } else {
+        KeAcquireQueuedLock(Queue->Lock.QueuedLock);
+    }
+
+    return OldRunLevel;
+}
+
+VOID
+KepReleaseWorkQueueLock (
+    PWORK_QUEUE Queue,
+    RUNLEVEL OldRunLevel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a work queue's lock.
+
+Arguments:
+
+    Queue - Supplies a pointer to the work queue.
+
+    OldRunLevel - Supplies the run level returned when the lock was acquired.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if ((Queue->Flags & WORK_QUEUE_FLAG_SUPPORT_DISPATCH_LEVEL) != 0) {
+        KeReleaseSpinLock(&(Queue->Lock.SpinLock));
+        KeLowerRunLevel(OldRunLevel);
+
+    } else {
+        KeReleaseQueuedLock(Queue->Lock.QueuedLock);
+    }
+
+    return;
+}
+
 VOID
 KepWorkItemAddReference (
     PWORK_ITEM WorkItem
@@ -291,6 +390,12 @@ Return Value:
         goto CreateWorkQueueEnd;
     }
 
+    Queue->FlushEvent = KeCreateEvent(NULL);
+    if (Queue->FlushEvent == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateWorkQueueEnd;
+    }
+
     Queue->Flags = Flags;
     Queue->State = WorkQueueStateOpen;
 
@@ -322,6 +427,10 @@ Return Value:
                 KeDestroyEvent(Queue->Event);
             }
 
+            if (Queue->FlushEvent != NULL) {
+                KeDestroyEvent(Queue->FlushEvent);
+            }
+
             if (NonPaged != FALSE) {
                 MmFreeNonPagedPool(Queue);
 
@@ -406,6 +515,56 @@ Return Value:
     return;
 }
 
+KERNEL_API
+KSTATUS
+KeAddWorkQueueThreads (
+    PWORK_QUEUE WorkQueue,
+    ULONG ThreadCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds worker threads to a work queue, allowing that many more
+    of its work items to run concurrently. Work items on a queue with more
+    than one thread may complete out of order.
+
+Arguments:
+
+    WorkQueue - Supplies a pointer to the work queue.
+
+    ThreadCount - Supplies the number of threads to add.
+
+Return Value:
+
+    Status code. Threads that were created before a failure remain on the
+    queue.
+
+--*/
+
+{
+
+    ULONG Index;
+    KSTATUS Status;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+    ASSERT(WorkQueue->State == WorkQueueStateOpen);
+
+    Status = STATUS_SUCCESS;
+    for (Index = 0; Index < ThreadCount; Index += 1) {
+        Status = PsCreateKernelThread(KepWorkerThread,
+                                      WorkQueue,
+                                      WorkQueue->Name);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+    }
+
+    return Status;
+}
+
 KERNEL_API
 VOID
 KeFlushWorkQueue (
@@ -417,7 +576,9 @@ KeFlushWorkQueue (
 Routine Description:
 
     This routine flushes a work queue. If there are items on the work queue,
-    they will be completed before this routine returns.
+    they will be completed before this routine returns. This includes items
+    still running on other worker threads of the queue, so this routine must
+    not be called from a work item running on the queue being flushed.
 
 Arguments:
 
@@ -432,8 +593,10 @@ Return Value:
 {
 
     BOOL DispatchLevel;
+    ULONG Generation;
     RUNLEVEL OldRunLevel;
     PWORK_ITEM Sentinal;
+    ULONG Slot;
 
     ASSERT(KeGetRunLevel() <= RunLevelDispatch);
 
@@ -507,6 +670,42 @@ Return Value:
         KeWaitForEvent(Sentinal->Event, FALSE, WAIT_TIME_INDEFINITE);
     }
 
+    //
+    // Every item queued before the flush has now started, and with a single
+    // worker thread they have also finished. With several worker threads some
+    // of them may still be running. Running items are counted in one of two
+    // slots. Wait for the slot of any earlier flush to drain, then switch new
+    // items over to that slot and wait for the current one to drain. Another
+    // flush can only switch slots again once this one's slot has drained.
+    //
+
+    if (WorkQueue->CurrentThreadCount <= 1) {
+        return;
+    }
+
+    OldRunLevel = KepAcquireWorkQueueLock(WorkQueue);
+    while (WorkQueue->ActiveCount[(WorkQueue->FlushGeneration & 0x1) ^ 0x1] !=
+           0) {
+
+        KeSignalEvent(WorkQueue->FlushEvent, SignalOptionUnsignal);
+        KepReleaseWorkQueueLock(WorkQueue, OldRunLevel);
+        KeWaitForEvent(WorkQueue->FlushEvent, FALSE, WAIT_TIME_INDEFINITE);
+        OldRunLevel = KepAcquireWorkQueueLock(WorkQueue);
+    }
+
+    Slot = WorkQueue->FlushGeneration & 0x1;
+    WorkQueue->FlushGeneration += 1;
+    Generation = WorkQueue->FlushGeneration;
+    while ((WorkQueue->ActiveCount[Slot] != 0) &&
+           (WorkQueue->FlushGeneration == Generation)) {
+
+        KeSignalEvent(WorkQueue->FlushEvent, SignalOptionUnsignal);
+        KepReleaseWorkQueueLock(WorkQueue, OldRunLevel);
+        KeWaitForEvent(WorkQueue->FlushEvent, FALSE, WAIT_TIME_INDEFINITE);
+        OldRunLevel = KepAcquireWorkQueueLock(WorkQueue);
+    }
+
+    KepReleaseWorkQueueLock(WorkQueue, OldRunLevel);
     return;
 }
 
@@ -1139,10 +1338,12 @@ Return Value:
     PWORK_QUEUE Queue;
     BOOL RaiseToDispatch;
     ULONG RemainingThreads;
+    ULONG Slot;
     PWORK_ITEM WorkItem;
 
     OldRunLevel = RunLevelCount;
     Queue = (PWORK_QUEUE)Parameter;
+    Slot = 0;
     RtlAtomicAdd32(&(Queue->CurrentThreadCount), 1);
     RaiseToDispatch = FALSE;
     if ((Queue->Flags & WORK_QUEUE_FLAG_SUPPORT_DISPATCH_LEVEL) != 0) {
@@ -1175,6 +1376,8 @@ Return Value:
                 WorkItem->ListEntry.Next = NULL;
                 Queue->WorkItemCount -= 1;
                 WorkItem->Flags &= ~WORK_ITEM_FLAG_QUEUED;
+                Slot = Queue->FlushGeneration & 0x1;
+                Queue->ActiveCount[Slot] += 1;
 
             } else {
                 KeSignalEvent(Queue->Event, SignalOptionUnsignal);
@@ -1196,6 +1399,16 @@ Return Value:
                 WorkItem->Routine(WorkItem->Parameter);
                 KeSignalEvent(WorkItem->Event, SignalOptionSignalAll);
                 KepWorkItemReleaseReference(WorkItem);
+                OldRunLevel = KepAcquireWorkQueueLock(Queue);
+
+                ASSERT(Queue->ActiveCount[Slot] != 0);
+
+                Queue->ActiveCount[Slot] -= 1;
+                if (Queue->ActiveCount[Slot] == 0) {
+                    KeSignalEvent(Queue->FlushEvent, SignalOptionSignalAll);
+                }
+
+                KepReleaseWorkQueueLock(Queue, OldRunLevel);
 
             //
             // If there was no work item, stop looking.
@@ -1288,6 +1501,10 @@ Return Value:
         KeDestroyEvent(Queue->Event);
     }
 
+    if (Queue->FlushEvent != NULL) {
+        KeDestroyEvent(Queue->FlushEvent);
+    }
+
     if (NonPaged != FALSE) {
         MmFreeNonPagedPool(Queue);
 
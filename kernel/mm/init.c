@@ -153,6 +153,7 @@ Return Value:
 
 {
 
+    ULONGLONG PhaseStart;
     PPROCESSOR_BLOCK ProcessorBlock;
     KSTATUS Status;
 
@@ -322,11 +323,17 @@ Return Value:
         // first paged pool allocation.
         //
 
+        PhaseStart = KeGetBootTimelineTimestamp();
         Status = MmpInitializePaging();
         if (!KSUCCESS(Status)) {
             goto InitializeEnd;
         }
 
+        KeRecordBootTimelineEvent(BootTimelineEventKernelPhase,
+                                  "MmpInitializePaging",
+                                  PhaseStart,
+                                  KeGetBootTimelineTimestamp());
+
         Status = MmpArchInitialize(Parameters, 2);
         if (!KSUCCESS(Status)) {
             goto InitializeEnd;
@@ -2618,6 +2618,39 @@ Return Value:
     return IoBuffer->Internal.CurrentOffset;
 }
 
+BOOL
+MmIsIoBufferUserMode (
+    PIO_BUFFER IoBuffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not the given I/O buffer describes a
+    region of user mode memory.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to an I/O buffer.
+
+Return Value:
+
+    TRUE if the I/O buffer describes user mode memory.
+
+    FALSE if the I/O buffer describes kernel mode memory.
+
+--*/
+
+{
+
+    if ((IoBuffer->Internal.Flags & IO_BUFFER_INTERNAL_FLAG_USER_MODE) != 0) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 KERNEL_API
 VOID
 MmSetIoBufferCurrentOffset (
@@ -430,6 +430,7 @@ Return Value:
     return MmPhysicalMemoryWarningLevel;
 }
 
+KERNEL_API
 UINTN
 MmGetTotalPhysicalPages (
     VOID
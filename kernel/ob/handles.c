@@ -38,20 +38,35 @@ Module Name:
 #define HANDLE_TABLE_ALLOCATION_TAG 0x646E6148 // 'dnaH'
 
 //
-// Define the initial size of the handle table, in entries.
+// Define the number of entries in each leaf of the handle table, as a shift.
+// Leaves are never moved or freed while the table exists, which is what lets
+// lookups find an entry without the table lock.
 //
 
-#define HANDLE_TABLE_INITIAL_SIZE 16
+#define HANDLE_TABLE_LEAF_SHIFT 8
+#define HANDLE_TABLE_LEAF_SIZE (1 << HANDLE_TABLE_LEAF_SHIFT)
+#define HANDLE_TABLE_LEAF_MASK (HANDLE_TABLE_LEAF_SIZE - 1)
 
 //
-// Define handle flags.
+// Define the number of leaves the initial directory has room for.
 //
 
+#define HANDLE_TABLE_INITIAL_LEAF_COUNT 4
+
+//
+// Define the number of bits in each word of the allocation bitmaps.
+//
+
+#define HANDLE_TABLE_BITMAP_BITS (sizeof(ULONG) * BITS_PER_BYTE)
+#define HANDLE_TABLE_LEAF_BITMAP_SIZE \
+    (HANDLE_TABLE_LEAF_SIZE / HANDLE_TABLE_BITMAP_BITS)
+
 //
-// This flag is set when a handle table entry is allocated.
+// This bit is set in an entry's handle value while the entry is held, either
+// by a lookup taking a reference on the value or by a writer changing it.
 //
 
-#define HANDLE_FLAG_ALLOCATED 0x80000000
+#define HANDLE_VALUE_HELD ((UINTN)0x1)
 
 //
 // --------------------------------------------------------------------- Macros
@@ -87,34 +102,85 @@ Structure Description:
         these flags are available for the user. A couple of the high ones are
         reserved.
 
-    HandleValue - Stores the actual value of the handle.
+    HandleValue - Stores the actual value of the handle, or NULL if the entry
+        is free. The low bit is set while the entry is held.
 
 --*/
 
 typedef struct _HANDLE_TABLE_ENTRY {
     ULONG Flags;
-    PVOID HandleValue;
+    volatile PVOID HandleValue;
 } HANDLE_TABLE_ENTRY, *PHANDLE_TABLE_ENTRY;
 
 /*++
 
 Structure Description:
 
-    This structure defines a handle table.
+    This structure defines a leaf of the handle table, which holds a fixed
+    number of consecutive entries.
 
 Members:
 
-    Process - Stores a pointer to the process that owns the handle table.
+    Bitmap - Stores a bitmap of the allocated entries in the leaf.
 
-    NextDescriptor - Stores the first free descriptor number.
+    Entries - Stores the handle table entries.
 
-    MaxDescriptor - Stores the maximum valid descriptor number.
+--*/
 
-    Entries - Stores the actual array of handles.
+typedef struct _HANDLE_TABLE_LEAF {
+    ULONG Bitmap[HANDLE_TABLE_LEAF_BITMAP_SIZE];
+    HANDLE_TABLE_ENTRY Entries[HANDLE_TABLE_LEAF_SIZE];
+} HANDLE_TABLE_LEAF, *PHANDLE_TABLE_LEAF;
 
-    ArraySize - Stores the number of elements in the array.
+typedef struct _HANDLE_TABLE_DIRECTORY
+    HANDLE_TABLE_DIRECTORY, *PHANDLE_TABLE_DIRECTORY;
 
-    Lock - Stores a pointer to a lock protecting access to the handle table.
+/*++
+
+Structure Description:
+
+    This structure defines the top level of a handle table, an array of
+    pointers to leaves. When the table outgrows a directory, a larger copy
+    replaces it. The old directory is kept until the table is destroyed, since
+    lookups may still be reading it.
+
+Members:
+
+    Previous - Stores a pointer to the directory this one replaced, if any.
+
+    LeafCount - Stores the number of leaves the directory has room for.
+
+    FullLeaves - Stores a pointer to a bitmap of the leaves that have no free
+        entries.
+
+    Leaves - Stores a pointer to the array of leaf pointers. Leaves that have
+        never been needed are NULL.
+
+--*/
+
+struct _HANDLE_TABLE_DIRECTORY {
+    PHANDLE_TABLE_DIRECTORY Previous;
+    ULONG LeafCount;
+    PULONG FullLeaves;
+    PHANDLE_TABLE_LEAF *Leaves;
+};
+
+/*++
+
+Structure Description:
+
+    This structure defines a handle table. Changes to the table are serialized
+    by the lock, but lookups go through the directory without it.
+
+Members:
+
+    Process - Stores a pointer to the process that owns the handle table.
+
+    MaxDescriptor - Stores the maximum valid descriptor number.
+
+    Directory - Stores a pointer to the current top level of the table.
+
+    Lock - Stores a pointer to a lock protecting changes to the handle table.
 
     LookupCallback - Stores an optional pointer to a routine that is called
         whenever a handle is looked up.
@@ -123,10 +189,8 @@ Structure Description:
 
 struct _HANDLE_TABLE {
     PKPROCESS Process;
-    ULONG NextDescriptor;
     ULONG MaxDescriptor;
-    PHANDLE_TABLE_ENTRY Entries;
-    ULONG ArraySize;
+    volatile PHANDLE_TABLE_DIRECTORY Directory;
     PQUEUED_LOCK Lock;
     PHANDLE_TABLE_LOOKUP_CALLBACK LookupCallback;
 };
@@ -135,12 +199,54 @@ struct _HANDLE_TABLE {
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+PHANDLE_TABLE_DIRECTORY
+ObpCreateHandleTableDirectory (
+    ULONG LeafCount,
+    PHANDLE_TABLE_DIRECTORY Previous
+    );
+
 KSTATUS
 ObpExpandHandleTable (
     PHANDLE_TABLE Table,
     ULONG Descriptor
     );
 
+PHANDLE_TABLE_ENTRY
+ObpGetHandleTableEntry (
+    PHANDLE_TABLE_DIRECTORY Directory,
+    ULONG Descriptor
+    );
+
+PVOID
+ObpAcquireHandleTableEntry (
+    PHANDLE_TABLE_ENTRY Entry
+    );
+
+VOID
+ObpReleaseHandleTableEntry (
+    PHANDLE_TABLE_ENTRY Entry,
+    PVOID HandleValue
+    );
+
+ULONG
+ObpFindFreeDescriptor (
+    PHANDLE_TABLE Table,
+    ULONG Minimum
+    );
+
+BOOL
+ObpIsDescriptorAllocated (
+    PHANDLE_TABLE_DIRECTORY Directory,
+    ULONG Descriptor
+    );
+
+VOID
+ObpSetDescriptorAllocated (
+    PHANDLE_TABLE_DIRECTORY Directory,
+    ULONG Descriptor,
+    BOOL Allocated
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -181,7 +287,6 @@ Return Value:
 
 {
 
-    UINTN AllocationSize;
     PHANDLE_TABLE HandleTable;
     KSTATUS Status;
 
@@ -201,27 +306,24 @@ Return Value:
 
     HandleTable->Process = Process;
     HandleTable->Lock = NULL;
-    HandleTable->NextDescriptor = 0;
     HandleTable->MaxDescriptor = 0;
     HandleTable->LookupCallback = LookupCallbackRoutine;
-    AllocationSize = HANDLE_TABLE_INITIAL_SIZE * sizeof(HANDLE_TABLE_ENTRY);
-    HandleTable->Entries = MmAllocatePagedPool(AllocationSize,
-                                               HANDLE_TABLE_ALLOCATION_TAG);
+    HandleTable->Directory = ObpCreateHandleTableDirectory(
+                                               HANDLE_TABLE_INITIAL_LEAF_COUNT,
+                                               NULL);
 
-    if (HandleTable->Entries == NULL) {
+    if (HandleTable->Directory == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto CreateHandleTableEnd;
     }
 
-    RtlZeroMemory(HandleTable->Entries, AllocationSize);
-    HandleTable->ArraySize = HANDLE_TABLE_INITIAL_SIZE;
     Status = STATUS_SUCCESS;
 
 CreateHandleTableEnd:
     if (!KSUCCESS(Status)) {
         if (HandleTable != NULL) {
-            if (HandleTable->Entries != NULL) {
-                MmFreePagedPool(HandleTable->Entries);
+            if (HandleTable->Process != NULL) {
+                ObReleaseReference(HandleTable->Process);
             }
 
             MmFreePagedPool(HandleTable);
@@ -256,14 +358,32 @@ Return Value:
 
 {
 
+    PHANDLE_TABLE_DIRECTORY Directory;
+    ULONG LeafIndex;
+    PHANDLE_TABLE_DIRECTORY Previous;
+
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
     if (HandleTable->Lock != NULL) {
         KeDestroyQueuedLock(HandleTable->Lock);
     }
 
-    if (HandleTable->Entries != NULL) {
-        MmFreePagedPool(HandleTable->Entries);
+    //
+    // The current directory points at every leaf, and the directories it
+    // replaced only point at a subset of the same leaves.
+    //
+
+    Directory = HandleTable->Directory;
+    for (LeafIndex = 0; LeafIndex < Directory->LeafCount; LeafIndex += 1) {
+        if (Directory->Leaves[LeafIndex] != NULL) {
+            MmFreePagedPool(Directory->Leaves[LeafIndex]);
+        }
+    }
+
+    while (Directory != NULL) {
+        Previous = Directory->Previous;
+        MmFreePagedPool(Directory);
+        Directory = Previous;
     }
 
     if (HandleTable->Process != NULL) {
@@ -351,6 +471,8 @@ Return Value:
 {
 
     ULONG Descriptor;
+    PHANDLE_TABLE_ENTRY Entry;
+    ULONG Minimum;
     KSTATUS Status;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
@@ -358,52 +480,45 @@ Return Value:
            (Table->Process->ThreadCount == 0) ||
            (Table->Process == PsGetCurrentProcess()));
 
+    ASSERT((HandleValue != NULL) &&
+           (((UINTN)HandleValue & HANDLE_VALUE_HELD) == 0));
+
     OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
 
     //
-    // Either use the next free slot, or try to use a descriptor at least as
+    // Either use the lowest free slot, or the lowest free slot at least as
     // high as the given handle.
     //
 
-    if (*NewHandle == INVALID_HANDLE) {
-        Descriptor = Table->NextDescriptor;
-
-    } else {
-        Descriptor = (ULONG)(*NewHandle);
+    Minimum = 0;
+    if (*NewHandle != INVALID_HANDLE) {
+        Minimum = (ULONG)(UINTN)(*NewHandle);
     }
 
+    Descriptor = ObpFindFreeDescriptor(Table, Minimum);
+
     //
-    // Loop until a free slot is found.
+    // Expand the table if needed.
     //
 
-    while ((Descriptor < Table->ArraySize) &&
-           ((Table->Entries[Descriptor].Flags & HANDLE_FLAG_ALLOCATED) != 0)) {
-
-        Descriptor += 1;
-    }
-
-    if (*NewHandle == INVALID_HANDLE) {
-        Table->NextDescriptor = Descriptor + 1;
+    Status = ObpExpandHandleTable(Table, Descriptor);
+    if (!KSUCCESS(Status)) {
+        goto CreateHandleEnd;
     }
 
     //
-    // Expand the table if needed.
+    // Fill in the flags before publishing the value, as lookups consider the
+    // entry valid as soon as the value is set.
     //
 
-    if (Descriptor >= Table->ArraySize) {
-        Status = ObpExpandHandleTable(Table, Descriptor);
-        if (!KSUCCESS(Status)) {
-            goto CreateHandleEnd;
-        }
-    }
+    Entry = ObpGetHandleTableEntry(Table->Directory, Descriptor);
 
-    ASSERT(HandleValue != NULL);
+    ASSERT(Entry->HandleValue == NULL);
 
-    Table->Entries[Descriptor].Flags = HANDLE_FLAG_ALLOCATED |
-                                       (Flags & HANDLE_FLAG_MASK);
-
-    Table->Entries[Descriptor].HandleValue = HandleValue;
-    *NewHandle = (HANDLE)Descriptor;
+    Entry->Flags = Flags & HANDLE_FLAG_MASK;
+    ObpReleaseHandleTableEntry(Entry, HandleValue);
+    ObpSetDescriptorAllocated(Table->Directory, Descriptor, TRUE);
+    *NewHandle = (HANDLE)(UINTN)Descriptor;
     if (Descriptor > Table->MaxDescriptor) {
         Table->MaxDescriptor = Descriptor;
     }
@@ -442,26 +557,33 @@ Return Value:
 {
 
     ULONG Descriptor;
+    PHANDLE_TABLE_ENTRY Entry;
+    PVOID OldValue;
 
     ASSERT((Table->Process == NULL) ||
            (Table->Process->ThreadCount == 0) ||
            (Table->Process == PsGetCurrentProcess()));
 
-    Descriptor = (ULONG)Handle;
+    Descriptor = (ULONG)(UINTN)Handle;
     OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
-    if (Descriptor >= Table->ArraySize) {
+    Entry = ObpGetHandleTableEntry(Table->Directory, Descriptor);
+    if (Entry == NULL) {
         goto DestroyHandleEnd;
     }
 
-    if ((Table->Entries[Descriptor].Flags & HANDLE_FLAG_ALLOCATED) == 0) {
+    //
+    // Wait for any lookup in progress to finish taking its reference, then
+    // free the entry.
+    //
+
+    OldValue = ObpAcquireHandleTableEntry(Entry);
+    if (OldValue == NULL) {
         goto DestroyHandleEnd;
     }
 
-    Table->Entries[Descriptor].HandleValue = NULL;
-    Table->Entries[Descriptor].Flags = 0;
-    if (Table->NextDescriptor > Descriptor) {
-        Table->NextDescriptor = Descriptor;
-    }
+    Entry->Flags = 0;
+    ObpReleaseHandleTableEntry(Entry, NULL);
+    ObpSetDescriptorAllocated(Table->Directory, Descriptor, FALSE);
 
 DestroyHandleEnd:
     OB_RELEASE_HANDLE_TABLE_LOCK(Table);
@@ -515,6 +637,8 @@ Return Value:
 {
 
     ULONG Descriptor;
+    PHANDLE_TABLE_ENTRY Entry;
+    PVOID OldValue;
     KSTATUS Status;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
@@ -522,32 +646,35 @@ Return Value:
            (Table->Process->ThreadCount == 0) ||
            (Table->Process == PsGetCurrentProcess()));
 
+    ASSERT((NewHandleValue != NULL) &&
+           (((UINTN)NewHandleValue & HANDLE_VALUE_HELD) == 0));
+
     OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
 
     ASSERT(Handle != INVALID_HANDLE);
 
-    Descriptor = (ULONG)Handle;
-    if (Descriptor >= Table->ArraySize) {
-        Status = ObpExpandHandleTable(Table, Descriptor);
-        if (!KSUCCESS(Status)) {
-            goto ReplaceHandleValueEnd;
-        }
+    Descriptor = (ULONG)(UINTN)Handle;
+    Status = ObpExpandHandleTable(Table, Descriptor);
+    if (!KSUCCESS(Status)) {
+        goto ReplaceHandleValueEnd;
     }
 
-    ASSERT(NewHandleValue != NULL);
-
+    Entry = ObpGetHandleTableEntry(Table->Directory, Descriptor);
+    OldValue = ObpAcquireHandleTableEntry(Entry);
     if (OldFlags != NULL) {
-        *OldFlags = Table->Entries[Descriptor].Flags & HANDLE_FLAG_MASK;
+        *OldFlags = Entry->Flags & HANDLE_FLAG_MASK;
     }
 
     if (OldHandleValue != NULL) {
-        *OldHandleValue = Table->Entries[Descriptor].HandleValue;
+        *OldHandleValue = OldValue;
     }
 
-    Table->Entries[Descriptor].Flags = HANDLE_FLAG_ALLOCATED |
-                                       (NewFlags & HANDLE_FLAG_MASK);
+    Entry->Flags = NewFlags & HANDLE_FLAG_MASK;
+    ObpReleaseHandleTableEntry(Entry, NewHandleValue);
+    if (OldValue == NULL) {
+        ObpSetDescriptorAllocated(Table->Directory, Descriptor, TRUE);
+    }
 
-    Table->Entries[Descriptor].HandleValue = NewHandleValue;
     if (Descriptor > Table->MaxDescriptor) {
         Table->MaxDescriptor = Descriptor;
     }
@@ -571,7 +698,9 @@ ObGetHandleValue (
 Routine Description:
 
     This routine looks up the given handle and returns the value associated
-    with that handle.
+    with that handle. The handle table lock is not acquired. The lookup
+    callback runs while the entry is held, so the value cannot be removed from
+    the table until the callback has taken whatever reference it needs.
 
 Arguments:
 
@@ -593,6 +722,7 @@ Return Value:
 {
 
     ULONG Descriptor;
+    PHANDLE_TABLE_ENTRY Entry;
     ULONG LocalFlags;
     PVOID Value;
 
@@ -600,27 +730,28 @@ Return Value:
            (Table->Process->ThreadCount == 0) ||
            (Table->Process == PsGetCurrentProcess()));
 
-    Descriptor = (ULONG)Handle;
-    LocalFlags = 0;
-    Value = NULL;
-    OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
-    if (Descriptor >= Table->ArraySize) {
-        goto GetHandleValueEnd;
+    Descriptor = (ULONG)(UINTN)Handle;
+    if ((UINTN)Handle != Descriptor) {
+        return NULL;
+    }
+
+    Entry = ObpGetHandleTableEntry(Table->Directory, Descriptor);
+    if (Entry == NULL) {
+        return NULL;
     }
 
-    LocalFlags = Table->Entries[Descriptor].Flags;
-    if ((LocalFlags & HANDLE_FLAG_ALLOCATED) == 0) {
-        goto GetHandleValueEnd;
+    Value = ObpAcquireHandleTableEntry(Entry);
+    if (Value == NULL) {
+        return NULL;
     }
 
-    Value = Table->Entries[Descriptor].HandleValue;
+    LocalFlags = Entry->Flags;
     if (Table->LookupCallback != NULL) {
-        Table->LookupCallback(Table, (HANDLE)Descriptor, Value);
+        Table->LookupCallback(Table, (HANDLE)(UINTN)Descriptor, Value);
     }
 
-GetHandleValueEnd:
-    OB_RELEASE_HANDLE_TABLE_LOCK(Table);
-    if ((Flags != NULL) && (Value != NULL)) {
+    ObpReleaseHandleTableEntry(Entry, Value);
+    if (Flags != NULL) {
         *Flags = LocalFlags & HANDLE_FLAG_MASK;
     }
 
@@ -669,34 +800,40 @@ Return Value:
 {
 
     ULONG Descriptor;
+    PHANDLE_TABLE_ENTRY Entry;
     ULONG NewValue;
     ULONG OriginalValue;
     KSTATUS Status;
+    PVOID Value;
 
     ASSERT((Table->Process == NULL) ||
            (Table->Process->ThreadCount == 0) ||
            (Table->Process == PsGetCurrentProcess()));
 
     Status = STATUS_INVALID_HANDLE;
-    Descriptor = (ULONG)Handle;
+    Descriptor = (ULONG)(UINTN)Handle;
     OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
-    if (Descriptor >= Table->ArraySize) {
+    Entry = ObpGetHandleTableEntry(Table->Directory, Descriptor);
+    if (Entry == NULL) {
         goto GetSetHandleFlagsEnd;
     }
 
-    if ((Table->Entries[Descriptor].Flags & HANDLE_FLAG_ALLOCATED) == 0) {
+    Value = ObpAcquireHandleTableEntry(Entry);
+    if (Value == NULL) {
         goto GetSetHandleFlagsEnd;
     }
 
     Status = STATUS_SUCCESS;
     NewValue = *Flags;
-    OriginalValue = Table->Entries[Descriptor].Flags;
+    OriginalValue = Entry->Flags;
     *Flags = OriginalValue & HANDLE_FLAG_MASK;
     if (Set != FALSE) {
-        Table->Entries[Descriptor].Flags = (NewValue & HANDLE_FLAG_MASK) |
-                                           (OriginalValue & ~HANDLE_FLAG_MASK);
+        Entry->Flags = (NewValue & HANDLE_FLAG_MASK) |
+                       (OriginalValue & ~HANDLE_FLAG_MASK);
     }
 
+    ObpReleaseHandleTableEntry(Entry, Value);
+
 GetSetHandleFlagsEnd:
     OB_RELEASE_HANDLE_TABLE_LOCK(Table);
     return Status;
@@ -737,10 +874,12 @@ Return Value:
     Handle = INVALID_HANDLE;
     OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
     Descriptor = Table->MaxDescriptor;
+    while (TRUE) {
+        if (ObpIsDescriptorAllocated(Table->Directory, Descriptor) != FALSE) {
+            Handle = (HANDLE)(UINTN)Descriptor;
+            break;
+        }
 
-    ASSERT(Descriptor < Table->ArraySize);
-
-    while ((Table->Entries[Descriptor].Flags & HANDLE_FLAG_ALLOCATED) == 0) {
         if (Descriptor == 0) {
             break;
         }
@@ -748,10 +887,6 @@ Return Value:
         Descriptor -= 1;
     }
 
-    if ((Table->Entries[Descriptor].Flags & HANDLE_FLAG_ALLOCATED) != 0) {
-        Handle = (HANDLE)Descriptor;
-    }
-
     Table->MaxDescriptor = Descriptor;
     OB_RELEASE_HANDLE_TABLE_LOCK(Table);
     return Handle;
@@ -792,22 +927,42 @@ Return Value:
 {
 
     ULONG Descriptor;
+    PHANDLE_TABLE_DIRECTORY Directory;
+    PHANDLE_TABLE_ENTRY Entry;
+    PHANDLE_TABLE_LEAF Leaf;
+    UINTN Value;
 
     ASSERT((Table->Process == NULL) ||
            (Table->Process->ThreadCount == 0) ||
            (Table->Process == PsGetCurrentProcess()));
 
     OB_ACQUIRE_HANDLE_TABLE_LOCK(Table);
-    for (Descriptor = 0; Descriptor <= Table->MaxDescriptor; Descriptor += 1) {
-        if ((Table->Entries[Descriptor].Flags & HANDLE_FLAG_ALLOCATED) == 0) {
+    Directory = Table->Directory;
+    Descriptor = 0;
+    while (Descriptor <= Table->MaxDescriptor) {
+        Leaf = Directory->Leaves[Descriptor >> HANDLE_TABLE_LEAF_SHIFT];
+        if (Leaf == NULL) {
+            Descriptor = ALIGN_RANGE_UP(Descriptor + 1, HANDLE_TABLE_LEAF_SIZE);
             continue;
         }
 
-        IterateRoutine(Table,
-                       (HANDLE)Descriptor,
-                       Table->Entries[Descriptor].Flags & HANDLE_FLAG_MASK,
-                       Table->Entries[Descriptor].HandleValue,
-                       IterateRoutineContext);
+        if (ObpIsDescriptorAllocated(Directory, Descriptor) != FALSE) {
+
+            //
+            // Lookups may be holding the entry, but with the table locked the
+            // value itself cannot change.
+            //
+
+            Entry = &(Leaf->Entries[Descriptor & HANDLE_TABLE_LEAF_MASK]);
+            Value = (UINTN)(Entry->HandleValue) & ~HANDLE_VALUE_HELD;
+            IterateRoutine(Table,
+                           (HANDLE)(UINTN)Descriptor,
+                           Entry->Flags & HANDLE_FLAG_MASK,
+                           (PVOID)Value,
+                           IterateRoutineContext);
+        }
+
+        Descriptor += 1;
     }
 
     OB_RELEASE_HANDLE_TABLE_LOCK(Table);
@@ -818,6 +973,78 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+PHANDLE_TABLE_DIRECTORY
+ObpCreateHandleTableDirectory (
+    ULONG LeafCount,
+    PHANDLE_TABLE_DIRECTORY Previous
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates a handle table directory, copying the leaves of the
+    directory it replaces.
+
+Arguments:
+
+    LeafCount - Supplies the number of leaves the directory should have room
+        for.
+
+    Previous - Supplies an optional pointer to the directory being replaced.
+
+Return Value:
+
+    Returns a pointer to the new directory on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    UINTN BitmapSize;
+    PHANDLE_TABLE_DIRECTORY Directory;
+
+    BitmapSize = ALIGN_RANGE_UP(LeafCount, HANDLE_TABLE_BITMAP_BITS) /
+                 HANDLE_TABLE_BITMAP_BITS;
+
+    BitmapSize *= sizeof(ULONG);
+    AllocationSize = sizeof(HANDLE_TABLE_DIRECTORY) +
+                     (LeafCount * sizeof(PHANDLE_TABLE_LEAF)) +
+                     BitmapSize;
+
+    Directory = MmAllocatePagedPool(AllocationSize,
+                                    HANDLE_TABLE_ALLOCATION_TAG);
+
+    if (Directory == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(Directory, AllocationSize);
+    Directory->Previous = Previous;
+    Directory->LeafCount = LeafCount;
+    Directory->Leaves = (PHANDLE_TABLE_LEAF *)(Directory + 1);
+    Directory->FullLeaves = (PULONG)(Directory->Leaves + LeafCount);
+    if (Previous != NULL) {
+
+        ASSERT(Previous->LeafCount < LeafCount);
+
+        RtlCopyMemory(Directory->Leaves,
+                      Previous->Leaves,
+                      Previous->LeafCount * sizeof(PHANDLE_TABLE_LEAF));
+
+        RtlCopyMemory(Directory->FullLeaves,
+                      Previous->FullLeaves,
+                      ALIGN_RANGE_UP(Previous->LeafCount,
+                                     HANDLE_TABLE_BITMAP_BITS) /
+                      BITS_PER_BYTE);
+    }
+
+    return Directory;
+}
+
 KSTATUS
 ObpExpandHandleTable (
     PHANDLE_TABLE Table,
@@ -829,7 +1056,8 @@ ObpExpandHandleTable (
 Routine Description:
 
     This routine expands the given handle table to support a given number of
-    descriptors.
+    descriptors, allocating the leaf that holds the given descriptor. This
+    routine assumes the handle table lock is held.
 
 Arguments:
 
@@ -846,9 +1074,10 @@ Return Value:
 
 {
 
-    UINTN AllocationSize;
-    PVOID NewBuffer;
-    UINTN NewCapacity;
+    PHANDLE_TABLE_DIRECTORY Directory;
+    PHANDLE_TABLE_LEAF Leaf;
+    ULONG LeafIndex;
+    ULONG NewLeafCount;
     KSTATUS Status;
 
     if (Descriptor >= OB_MAX_HANDLES) {
@@ -857,48 +1086,45 @@ Return Value:
     }
 
     //
-    // Expand the table if needed.
+    // Grow the directory if needed. Lookups may still be using the old one,
+    // so it stays around until the table is destroyed.
     //
 
-    if (Descriptor >= Table->ArraySize) {
-        NewCapacity = Table->ArraySize * 2;
-        while ((NewCapacity <= Descriptor) &&
-               (NewCapacity >= Table->ArraySize)) {
-
-            NewCapacity *= 2;
+    LeafIndex = Descriptor >> HANDLE_TABLE_LEAF_SHIFT;
+    Directory = Table->Directory;
+    if (LeafIndex >= Directory->LeafCount) {
+        NewLeafCount = Directory->LeafCount * 2;
+        while (NewLeafCount <= LeafIndex) {
+            NewLeafCount *= 2;
         }
 
-        AllocationSize = NewCapacity * sizeof(HANDLE_TABLE_ENTRY);
-        if ((NewCapacity <= Descriptor) ||
-            (NewCapacity < Table->ArraySize) ||
-            ((AllocationSize / sizeof(HANDLE_TABLE_ENTRY)) != NewCapacity)) {
-
-            Status = STATUS_TOO_MANY_HANDLES;
+        Directory = ObpCreateHandleTableDirectory(NewLeafCount, Directory);
+        if (Directory == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
             goto ExpandHandleTableEnd;
         }
 
-        ASSERT((NewCapacity > Table->ArraySize) &&
-               (NewCapacity > Table->NextDescriptor));
+        RtlMemoryBarrier();
+        Table->Directory = Directory;
+    }
 
-        NewBuffer = MmAllocatePagedPool(AllocationSize,
-                                        HANDLE_TABLE_ALLOCATION_TAG);
+    //
+    // Allocate the leaf if this is the first descriptor in it. It must be
+    // fully initialized before lookups can see it.
+    //
 
-        if (NewBuffer == NULL) {
+    if (Directory->Leaves[LeafIndex] == NULL) {
+        Leaf = MmAllocatePagedPool(sizeof(HANDLE_TABLE_LEAF),
+                                   HANDLE_TABLE_ALLOCATION_TAG);
+
+        if (Leaf == NULL) {
             Status = STATUS_INSUFFICIENT_RESOURCES;
             goto ExpandHandleTableEnd;
         }
 
-        RtlCopyMemory(NewBuffer,
-                      Table->Entries,
-                      Table->ArraySize * sizeof(HANDLE_TABLE_ENTRY));
-
-        RtlZeroMemory(
-                NewBuffer + (Table->ArraySize * sizeof(HANDLE_TABLE_ENTRY)),
-                (NewCapacity - Table->ArraySize) * sizeof(HANDLE_TABLE_ENTRY));
-
-        MmFreePagedPool(Table->Entries);
-        Table->Entries = NewBuffer;
-        Table->ArraySize = NewCapacity;
+        RtlZeroMemory(Leaf, sizeof(HANDLE_TABLE_LEAF));
+        RtlMemoryBarrier();
+        Directory->Leaves[LeafIndex] = Leaf;
     }
 
     Status = STATUS_SUCCESS;
@@ -907,3 +1133,347 @@ Return Value:
     return Status;
 }
 
+PHANDLE_TABLE_ENTRY
+ObpGetHandleTableEntry (
+    PHANDLE_TABLE_DIRECTORY Directory,
+    ULONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the entry for the given descriptor. It is safe to
+    call without the handle table lock.
+
+Arguments:
+
+    Directory - Supplies a pointer to the handle table directory to search.
+
+    Descriptor - Supplies the descriptor to look up.
+
+Return Value:
+
+    Returns a pointer to the entry on success.
+
+    NULL if the table has no room for the descriptor yet.
+
+--*/
+
+{
+
+    PHANDLE_TABLE_LEAF Leaf;
+    ULONG LeafIndex;
+
+    LeafIndex = Descriptor >> HANDLE_TABLE_LEAF_SHIFT;
+    if (LeafIndex >= Directory->LeafCount) {
+        return NULL;
+    }
+
+    Leaf = Directory->Leaves[LeafIndex];
+    if (Leaf == NULL) {
+        return NULL;
+    }
+
+    return &(Leaf->Entries[Descriptor & HANDLE_TABLE_LEAF_MASK]);
+}
+
+PVOID
+ObpAcquireHandleTableEntry (
+    PHANDLE_TABLE_ENTRY Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine holds a handle table entry so that its value and flags can be
+    used without changing underneath the caller. Holders only ever keep an
+    entry for a few instructions, so this routine spins (yielding) while
+    another thread holds it.
+
+Arguments:
+
+    Entry - Supplies a pointer to the entry to hold.
+
+Return Value:
+
+    Returns the value of the entry, which is now held by the caller. The caller
+    must release it with ObpReleaseHandleTableEntry.
+
+    NULL if the entry is free, in which case it is not held.
+
+--*/
+
+{
+
+    UINTN OldValue;
+    UINTN Value;
+
+    while (TRUE) {
+        Value = (UINTN)(Entry->HandleValue);
+        if (Value == (UINTN)NULL) {
+            return NULL;
+        }
+
+        if ((Value & HANDLE_VALUE_HELD) == 0) {
+            OldValue = RtlAtomicCompareExchange((PUINTN)&(Entry->HandleValue),
+                                                Value | HANDLE_VALUE_HELD,
+                                                Value);
+
+            if (OldValue == Value) {
+                break;
+            }
+
+            continue;
+        }
+
+        KeYield();
+    }
+
+    return (PVOID)Value;
+}
+
+VOID
+ObpReleaseHandleTableEntry (
+    PHANDLE_TABLE_ENTRY Entry,
+    PVOID HandleValue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a held handle table entry, or sets the value of a
+    free one, publishing all prior changes to the entry.
+
+Arguments:
+
+    Entry - Supplies a pointer to the entry to release.
+
+    HandleValue - Supplies the value to set in the entry. Supply NULL to free
+        the entry.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    RtlAtomicExchange((PUINTN)&(Entry->HandleValue), (UINTN)HandleValue);
+    return;
+}
+
+ULONG
+ObpFindFreeDescriptor (
+    PHANDLE_TABLE Table,
+    ULONG Minimum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the lowest free descriptor at or above the given
+    minimum, skipping over full leaves using the directory's bitmap. This
+    routine assumes the handle table lock is held.
+
+Arguments:
+
+    Table - Supplies a pointer to the handle table.
+
+    Minimum - Supplies the minimum descriptor to return.
+
+Return Value:
+
+    Returns the lowest free descriptor. This may be beyond the end of the
+    table, in which case the table needs to be expanded to hold it.
+
+--*/
+
+{
+
+    ULONG Bit;
+    ULONG Bits;
+    PHANDLE_TABLE_DIRECTORY Directory;
+    PHANDLE_TABLE_LEAF Leaf;
+    ULONG LeafIndex;
+    ULONG Start;
+    ULONG Word;
+
+    Directory = Table->Directory;
+    LeafIndex = Minimum >> HANDLE_TABLE_LEAF_SHIFT;
+    Start = Minimum & HANDLE_TABLE_LEAF_MASK;
+    while (LeafIndex < Directory->LeafCount) {
+
+        //
+        // Skip past full leaves, a whole bitmap word at a time if possible.
+        // The leaf containing the minimum is searched even if it is full, as
+        // the rest of the logic handles that case the same way.
+        //
+
+        if (Start == 0) {
+            Word = LeafIndex / HANDLE_TABLE_BITMAP_BITS;
+            Bit = LeafIndex % HANDLE_TABLE_BITMAP_BITS;
+            Bits = Directory->FullLeaves[Word];
+            if ((Bit == 0) && (Bits == MAX_ULONG)) {
+                LeafIndex += HANDLE_TABLE_BITMAP_BITS;
+                continue;
+            }
+
+            if ((Bits & ((ULONG)1 << Bit)) != 0) {
+                LeafIndex += 1;
+                continue;
+            }
+        }
+
+        Leaf = Directory->Leaves[LeafIndex];
+        if (Leaf == NULL) {
+            break;
+        }
+
+        for (Word = Start / HANDLE_TABLE_BITMAP_BITS;
+             Word < HANDLE_TABLE_LEAF_BITMAP_SIZE;
+             Word += 1) {
+
+            Bits = Leaf->Bitmap[Word];
+            if (Word == (Start / HANDLE_TABLE_BITMAP_BITS)) {
+                Bits |= ((ULONG)1 << (Start % HANDLE_TABLE_BITMAP_BITS)) - 1;
+            }
+
+            if (Bits != MAX_ULONG) {
+                Bit = RtlCountTrailingZeros32(~Bits);
+                return (LeafIndex << HANDLE_TABLE_LEAF_SHIFT) +
+                       (Word * HANDLE_TABLE_BITMAP_BITS) + Bit;
+            }
+        }
+
+        LeafIndex += 1;
+        Start = 0;
+    }
+
+    return (LeafIndex << HANDLE_TABLE_LEAF_SHIFT) + Start;
+}
+
+BOOL
+ObpIsDescriptorAllocated (
+    PHANDLE_TABLE_DIRECTORY Directory,
+    ULONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether the given descriptor is in use. This
+    routine assumes the handle table lock is held.
+
+Arguments:
+
+    Directory - Supplies a pointer to the current handle table directory.
+
+    Descriptor - Supplies the descriptor to check.
+
+Return Value:
+
+    TRUE if the descriptor is allocated.
+
+    FALSE if the descriptor is free.
+
+--*/
+
+{
+
+    ULONG Index;
+    PHANDLE_TABLE_LEAF Leaf;
+    ULONG LeafIndex;
+
+    LeafIndex = Descriptor >> HANDLE_TABLE_LEAF_SHIFT;
+    if (LeafIndex >= Directory->LeafCount) {
+        return FALSE;
+    }
+
+    Leaf = Directory->Leaves[LeafIndex];
+    if (Leaf == NULL) {
+        return FALSE;
+    }
+
+    Index = Descriptor & HANDLE_TABLE_LEAF_MASK;
+    if ((Leaf->Bitmap[Index / HANDLE_TABLE_BITMAP_BITS] &
+         ((ULONG)1 << (Index % HANDLE_TABLE_BITMAP_BITS))) != 0) {
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+VOID
+ObpSetDescriptorAllocated (
+    PHANDLE_TABLE_DIRECTORY Directory,
+    ULONG Descriptor,
+    BOOL Allocated
+    )
+
+/*++
+
+Routine Description:
+
+    This routine updates the allocation bitmaps for the given descriptor. This
+    routine assumes the handle table lock is held and that the descriptor's
+    leaf exists.
+
+Arguments:
+
+    Directory - Supplies a pointer to the current handle table directory.
+
+    Descriptor - Supplies the descriptor being allocated or freed.
+
+    Allocated - Supplies a boolean indicating whether the descriptor is now
+        allocated (TRUE) or free (FALSE).
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Index;
+    PHANDLE_TABLE_LEAF Leaf;
+    ULONG LeafIndex;
+    ULONG LeafMask;
+    PULONG LeafWord;
+    ULONG Mask;
+    ULONG Word;
+
+    LeafIndex = Descriptor >> HANDLE_TABLE_LEAF_SHIFT;
+    Leaf = Directory->Leaves[LeafIndex];
+    Index = Descriptor & HANDLE_TABLE_LEAF_MASK;
+    LeafWord = &(Directory->FullLeaves[LeafIndex / HANDLE_TABLE_BITMAP_BITS]);
+    LeafMask = (ULONG)1 << (LeafIndex % HANDLE_TABLE_BITMAP_BITS);
+    Mask = (ULONG)1 << (Index % HANDLE_TABLE_BITMAP_BITS);
+
+    ASSERT(Leaf != NULL);
+
+    if (Allocated == FALSE) {
+        Leaf->Bitmap[Index / HANDLE_TABLE_BITMAP_BITS] &= ~Mask;
+
+        *LeafWord &= ~LeafMask;
+        return;
+    }
+
+    Leaf->Bitmap[Index / HANDLE_TABLE_BITMAP_BITS] |= Mask;
+
+    for (Word = 0; Word < HANDLE_TABLE_LEAF_BITMAP_SIZE; Word += 1) {
+        if (Leaf->Bitmap[Word] != MAX_ULONG) {
+            return;
+        }
+    }
+
+    *LeafWord |= LeafMask;
+    return;
+}
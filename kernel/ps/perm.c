@@ -761,7 +761,8 @@ Return Value:
     KSTATUS Status;
 
     //
-    // Just copy the identity, permissions, and limits straight over.
+    // Just copy the identity, permissions, limits, and I/O priority straight
+    // over.
     //
 
     RtlCopyMemory(&(NewThread->Identity),
@@ -776,6 +777,8 @@ Return Value:
                   &(ThreadToCopy->Limits),
                   sizeof(NewThread->Limits));
 
+    NewThread->IoPriority = ThreadToCopy->IoPriority;
+
     //
     // Count up the old thread supplementary group count so it can be allocated
     // in a single block.
@@ -1150,6 +1150,144 @@ Return Value:
     return Status;
 }
 
+INTN
+PsSysSetIoPriority (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call that gets or sets the I/O
+    priority of a process or thread.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    ULONG Class;
+    PKPROCESS CurrentProcess;
+    ULONG Level;
+    ULONG NewPriority;
+    PSYSTEM_CALL_SET_IO_PRIORITY Parameters;
+    volatile ULONG *Priority;
+    PKPROCESS Process;
+    KSTATUS Status;
+    PKTHREAD Thread;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Parameters = (PSYSTEM_CALL_SET_IO_PRIORITY)SystemCallParameter;
+    CurrentProcess = PsGetCurrentProcess();
+    Process = NULL;
+    Thread = NULL;
+    if (Parameters->Request == IoPriorityRequestProcess) {
+        if ((Parameters->Id == -1ULL) ||
+            (Parameters->Id == CurrentProcess->Identifiers.ProcessId)) {
+
+            Process = CurrentProcess;
+            ObAddReference(Process);
+
+        } else {
+            Process = PspGetProcessById(Parameters->Id);
+        }
+
+        if (Process == NULL) {
+            Status = STATUS_NO_SUCH_PROCESS;
+            goto SysSetIoPriorityEnd;
+        }
+
+        Priority = &(Process->IoPriority);
+
+    } else if (Parameters->Request == IoPriorityRequestThread) {
+        if (Parameters->Id == -1ULL) {
+            Thread = KeGetCurrentThread();
+            ObAddReference(Thread);
+
+        } else {
+            Thread = PspGetThreadById(CurrentProcess, Parameters->Id);
+        }
+
+        if (Thread == NULL) {
+            Status = STATUS_NO_SUCH_THREAD;
+            goto SysSetIoPriorityEnd;
+        }
+
+        Priority = &(Thread->IoPriority);
+
+    } else {
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysSetIoPriorityEnd;
+    }
+
+    NewPriority = Parameters->Priority;
+    Parameters->Priority = *Priority;
+    if (Parameters->Set == FALSE) {
+        Status = STATUS_SUCCESS;
+        goto SysSetIoPriorityEnd;
+    }
+
+    Class = IO_PRIORITY_CLASS(NewPriority);
+    Level = IO_PRIORITY_LEVEL(NewPriority);
+    if ((Class > IO_PRIORITY_CLASS_IDLE) ||
+        (Level >= IO_PRIORITY_LEVEL_COUNT)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysSetIoPriorityEnd;
+    }
+
+    //
+    // Levels mean nothing outside the real time and best effort classes.
+    //
+
+    if ((Class == IO_PRIORITY_CLASS_NONE) ||
+        (Class == IO_PRIORITY_CLASS_IDLE)) {
+
+        NewPriority = IO_PRIORITY_VALUE(Class, 0);
+    }
+
+    //
+    // Real time I/O can starve everyone else, and other processes belong to
+    // someone else. Both need the scheduling permission.
+    //
+
+    if ((Class == IO_PRIORITY_CLASS_REAL_TIME) ||
+        ((Process != NULL) && (Process != CurrentProcess))) {
+
+        Status = PsCheckPermission(PERMISSION_SCHEDULING);
+        if (!KSUCCESS(Status)) {
+            goto SysSetIoPriorityEnd;
+        }
+    }
+
+    *Priority = NewPriority;
+    Status = STATUS_SUCCESS;
+
+SysSetIoPriorityEnd:
+    if (Process != NULL) {
+        ObReleaseReference(Process);
+    }
+
+    if (Thread != NULL) {
+        ObReleaseReference(Thread);
+    }
+
+    return Status;
+}
+
 INTN
 PsSysSetUmask (
     PVOID SystemCallParameter
@@ -1790,6 +1928,7 @@ Return Value:
     NewProcess->HandledSignals = Process->HandledSignals;
     NewProcess->IgnoredSignals = Process->IgnoredSignals;
     NewProcess->Umask = Process->Umask;
+    NewProcess->IoPriority = Process->IoPriority;
     INSERT_BEFORE(&(NewProcess->SiblingListEntry), &(Process->ChildListHead));
     KeReleaseQueuedLock(Process->QueuedLock);
     PspAddProcessToParentProcessGroup(NewProcess);
@@ -3343,12 +3482,14 @@ Return Value:
 
 {
 
+    ULONGLONG LoadStart;
     PKPROCESS Process;
     PROCESS_START_DATA StartData;
     KSTATUS Status;
     PKTHREAD Thread;
     THREAD_CREATION_PARAMETERS ThreadParameters;
 
+    LoadStart = KeGetBootTimelineTimestamp();
     Thread = KeGetCurrentThread();
     Process = Thread->OwningProcess;
 
@@ -3401,6 +3542,15 @@ Return Value:
         goto LoaderThreadEnd;
     }
 
+    //
+    // The first process to make it this far closes out the boot timeline.
+    //
+
+    KeRecordBootTimelineEvent(BootTimelineEventUserMode,
+                              Process->Environment->ImageName,
+                              LoadStart,
+                              KeGetBootTimelineTimestamp());
+
     Status = STATUS_SUCCESS;
 
 LoaderThreadEnd:
@@ -3553,8 +3703,8 @@ PspHandleTableLookupCallback (
 
 Routine Description:
 
-    This routine is called whenever a handle is looked up. It is called with
-    the handle table lock still held.
+    This routine is called whenever a handle is looked up. The handle cannot
+    be destroyed or replaced until this routine returns.
 
 Arguments:
 
@@ -38,17 +38,6 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
-//
-// Define the default file permissions for FAT files, since they don't store
-// permissions on their own.
-//
-
-#define FAT_DEFAULT_FILE_PERMISSIONS                              \
-    (FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE |     \
-     FILE_PERMISSION_USER_EXECUTE |                               \
-     FILE_PERMISSION_GROUP_READ | FILE_PERMISSION_GROUP_EXECUTE | \
-     FILE_PERMISSION_OTHER_READ | FILE_PERMISSION_OTHER_EXECUTE)
-
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -1648,7 +1637,6 @@ Return Value:
     PFAT_FILE Directory;
     FAT_DIRECTORY_CONTEXT DirectoryContext;
     BOOL DirectoryContextInitialized;
-    FAT_ENCODED_PROPERTIES EncodedProperties;
     FAT_DIRECTORY_ENTRY Entry;
     ULONGLONG EntryOffset;
     PFAT_VOLUME FatVolume;
@@ -1751,75 +1739,10 @@ Return Value:
     // Convert the directory entry into file properties.
     //
 
-    Properties->FileId = Cluster;
-    Properties->Type = IoObjectRegularFile;
-    if ((Entry.FileAttributes & FAT_SUBDIRECTORY) != 0) {
-        Properties->Type = IoObjectRegularDirectory;
-    }
-
-    Properties->UserId = 0;
-    Properties->GroupId = 0;
-    Properties->Permissions = FAT_DEFAULT_FILE_PERMISSIONS;
-    if ((Entry.FileAttributes & FAT_READ_ONLY) != 0) {
-        Properties->Permissions &= ~(FILE_PERMISSION_USER_WRITE |
-                                     FILE_PERMISSION_GROUP_WRITE |
-                                     FILE_PERMISSION_OTHER_WRITE);
-    }
-
-    Properties->HardLinkCount = 1;
-    WRITE_INT64_SYNC(&(Properties->FileSize), Entry.FileSizeInBytes);
-    Properties->BlockSize = FatVolume->ClusterSize;
-
-    ASSERT(POWER_OF_2(Properties->BlockSize) != FALSE);
-
-    Properties->BlockCount =
-                ALIGN_RANGE_UP(Entry.FileSizeInBytes, Properties->BlockSize) /
-                Properties->BlockSize;
-
-    FatpConvertFatTimeToSystemTime(Entry.CreationDate,
-                                   Entry.CreationTime,
-                                   Entry.CreationTime10ms,
-                                   &(Properties->StatusChangeTime));
-
-    FatpConvertFatTimeToSystemTime(Entry.LastModifiedDate,
-                                   Entry.LastModifiedTime,
-                                   0,
-                                   &(Properties->ModifiedTime));
-
-    FatpConvertFatTimeToSystemTime(Entry.LastAccessDate,
-                                   0,
-                                   0,
-                                   &(Properties->AccessTime));
-
-    //
-    // Try to convert the entry to encoded properties. If it appears consistent,
-    // use it.
-    //
-
-    if (FatDisableEncodedProperties == FALSE) {
-        FatpReadEncodedProperties(&Entry, &EncodedProperties);
-        if (EncodedProperties.Cluster == Cluster) {
-            Properties->UserId = EncodedProperties.Owner;
-            Properties->GroupId = EncodedProperties.Group;
-            Properties->Permissions = EncodedProperties.Permissions &
-                                      FAT_ENCODED_PROPERTY_PERMISSION_MASK;
-
-            if ((EncodedProperties.Permissions &
-                 FAT_ENCODED_PROPERTY_SYMLINK) != 0) {
-
-                ASSERT(Properties->Type == IoObjectRegularFile);
-
-                Properties->Type = IoObjectSymbolicLink;
-            }
-
-            //
-            // Steal the least significant bit of the 10ms creation time to
-            // have second-level granularity on modification time.
-            //
-
-            Properties->ModifiedTime.Seconds |= Entry.CreationTime10ms & 0x1;
-        }
-    }
+    FatpConvertDirectoryEntryToProperties(FatVolume,
+                                          &Entry,
+                                          Cluster,
+                                          Properties);
 
     Status = STATUS_SUCCESS;
 
@@ -1904,6 +1827,7 @@ FatEnumerateDirectory (
     UINTN BytesToRead,
     BOOL ReadSingleEntry,
     BOOL IncludeDotDirectories,
+    ULONG IoFlags,
     PVOID Irp,
     PUINTN BytesRead,
     PULONG ElementsRead
@@ -1935,7 +1859,8 @@ Routine Description:
         dot directories should be returned as well.
 
     IoFlags - Supplies flags regarding the I/O operation. See IO_FLAG_*
-        definitions.
+        definitions. If IO_FLAG_DIRECTORY_PROPERTIES is set, each entry
+        carries its file properties.
 
     Irp - Supplies an optional pointer to an IRP to use for transfers.
 
@@ -1974,6 +1899,7 @@ Return Value:
     PSTR Name;
     ULONG NameBufferSize;
     ULONG NameSize;
+    FILE_PROPERTIES Properties;
     ULONGLONG ShortEntryOffset;
     UINTN SpaceLeft;
     KSTATUS Status;
@@ -2057,6 +1983,10 @@ Return Value:
         //
 
         EntrySize = ALIGN_RANGE_UP(sizeof(DIRECTORY_ENTRY) + NameSize, 8);
+        if ((IoFlags & IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+            EntrySize = DIRECTORY_ENTRY_SIZE_WITH_PROPERTIES(NameSize);
+        }
+
         if (EntrySize > SpaceLeft) {
             *ElementsRead -= EntriesRead;
             Status = STATUS_MORE_PROCESSING_REQUIRED;
@@ -2107,7 +2037,16 @@ Return Value:
         UserDirectoryEntry.FileId = Cluster;
         UserDirectoryEntry.NextOffset = EntryOffset;
         UserDirectoryEntry.Type = IoObjectRegularFile;
-        if ((FatDirectoryEntry.FileAttributes & FAT_SUBDIRECTORY) != 0) {
+        if ((IoFlags & IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+            FatpConvertDirectoryEntryToProperties(Volume,
+                                                  &FatDirectoryEntry,
+                                                  Cluster,
+                                                  &Properties);
+
+            UserDirectoryEntry.Type = Properties.Type |
+                                      DIRECTORY_ENTRY_TYPE_PROPERTIES;
+
+        } else if ((FatDirectoryEntry.FileAttributes & FAT_SUBDIRECTORY) != 0) {
             UserDirectoryEntry.Type = IoObjectRegularDirectory;
 
         } else if (FatDisableEncodedProperties == FALSE) {
@@ -2143,6 +2082,20 @@ Return Value:
             goto EnumerateDirectoryEnd;
         }
 
+        if ((IoFlags & IO_FLAG_DIRECTORY_PROPERTIES) != 0) {
+            Status = FatCopyIoBufferData(
+                              IoBuffer,
+                              &Properties,
+                              BytesWritten + EntrySize -
+                              DIRECTORY_ENTRY_PROPERTIES_SIZE,
+                              sizeof(FILE_PROPERTIES),
+                              TRUE);
+
+            if (!KSUCCESS(Status)) {
+                goto EnumerateDirectoryEnd;
+            }
+        }
+
         BytesWritten += EntrySize;
         SpaceLeft -= EntrySize;
         if (ReadSingleEntry != FALSE) {
@@ -29,6 +29,17 @@ Module Name:
 // --------------------------------------------------------------------- Macros
 //
 
+//
+// Define the default file permissions for FAT files, since they don't store
+// permissions on their own.
+//
+
+#define FAT_DEFAULT_FILE_PERMISSIONS                              \
+    (FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE |     \
+     FILE_PERMISSION_USER_EXECUTE |                               \
+     FILE_PERMISSION_GROUP_READ | FILE_PERMISSION_GROUP_EXECUTE | \
+     FILE_PERMISSION_OTHER_READ | FILE_PERMISSION_OTHER_EXECUTE)
+
 //
 // This macro converts a cluster number into a byte offset on the disk.
 //
@@ -1114,6 +1125,38 @@ Return Value:
 
 --*/
 
+VOID
+FatpConvertDirectoryEntryToProperties (
+    PFAT_VOLUME Volume,
+    PFAT_DIRECTORY_ENTRY Entry,
+    ULONG Cluster,
+    PFILE_PROPERTIES Properties
+    );
+
+/*++
+
+Routine Description:
+
+    This routine converts a FAT short directory entry into file properties.
+    The device ID is not filled in.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume the entry lives on.
+
+    Entry - Supplies a pointer to the short directory entry to convert.
+
+    Cluster - Supplies the starting cluster of the file, which serves as its
+        file ID.
+
+    Properties - Supplies a pointer where the file properties are returned.
+
+Return Value:
+
+    None.
+
+--*/
+
 VOID
 FatpReadEncodedProperties (
     PFAT_DIRECTORY_ENTRY Entry,
@@ -3325,6 +3325,115 @@ Return Value:
     return;
 }
 
+VOID
+FatpConvertDirectoryEntryToProperties (
+    PFAT_VOLUME Volume,
+    PFAT_DIRECTORY_ENTRY Entry,
+    ULONG Cluster,
+    PFILE_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a FAT short directory entry into file properties.
+    The device ID is not filled in.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume the entry lives on.
+
+    Entry - Supplies a pointer to the short directory entry to convert.
+
+    Cluster - Supplies the starting cluster of the file, which serves as its
+        file ID.
+
+    Properties - Supplies a pointer where the file properties are returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    FAT_ENCODED_PROPERTIES EncodedProperties;
+
+    Properties->FileId = Cluster;
+    Properties->Type = IoObjectRegularFile;
+    if ((Entry->FileAttributes & FAT_SUBDIRECTORY) != 0) {
+        Properties->Type = IoObjectRegularDirectory;
+    }
+
+    Properties->UserId = 0;
+    Properties->GroupId = 0;
+    Properties->Permissions = FAT_DEFAULT_FILE_PERMISSIONS;
+    if ((Entry->FileAttributes & FAT_READ_ONLY) != 0) {
+        Properties->Permissions &= ~(FILE_PERMISSION_USER_WRITE |
+                                     FILE_PERMISSION_GROUP_WRITE |
+                                     FILE_PERMISSION_OTHER_WRITE);
+    }
+
+    Properties->HardLinkCount = 1;
+    WRITE_INT64_SYNC(&(Properties->FileSize), Entry->FileSizeInBytes);
+    Properties->BlockSize = Volume->ClusterSize;
+
+    ASSERT(POWER_OF_2(Properties->BlockSize) != FALSE);
+
+    Properties->BlockCount =
+                ALIGN_RANGE_UP(Entry->FileSizeInBytes, Properties->BlockSize) /
+                Properties->BlockSize;
+
+    FatpConvertFatTimeToSystemTime(Entry->CreationDate,
+                                   Entry->CreationTime,
+                                   Entry->CreationTime10ms,
+                                   &(Properties->StatusChangeTime));
+
+    FatpConvertFatTimeToSystemTime(Entry->LastModifiedDate,
+                                   Entry->LastModifiedTime,
+                                   0,
+                                   &(Properties->ModifiedTime));
+
+    FatpConvertFatTimeToSystemTime(Entry->LastAccessDate,
+                                   0,
+                                   0,
+                                   &(Properties->AccessTime));
+
+    //
+    // Try to convert the entry to encoded properties. If it appears consistent,
+    // use it.
+    //
+
+    if (FatDisableEncodedProperties == FALSE) {
+        FatpReadEncodedProperties(Entry, &EncodedProperties);
+        if (EncodedProperties.Cluster == Cluster) {
+            Properties->UserId = EncodedProperties.Owner;
+            Properties->GroupId = EncodedProperties.Group;
+            Properties->Permissions = EncodedProperties.Permissions &
+                                      FAT_ENCODED_PROPERTY_PERMISSION_MASK;
+
+            if ((EncodedProperties.Permissions &
+                 FAT_ENCODED_PROPERTY_SYMLINK) != 0) {
+
+                ASSERT(Properties->Type == IoObjectRegularFile);
+
+                Properties->Type = IoObjectSymbolicLink;
+            }
+
+            //
+            // Steal the least significant bit of the 10ms creation time to
+            // have second-level granularity on modification time.
+            //
+
+            Properties->ModifiedTime.Seconds |= Entry->CreationTime10ms & 0x1;
+        }
+    }
+
+    return;
+}
+
 VOID
 FatpReadEncodedProperties (
     PFAT_DIRECTORY_ENTRY Entry,
@@ -28,6 +28,7 @@ Module Name:
 
 function build() {
     sources = [
+        "checksum.c",
         "crc32.c",
         "heap.c",
         "heapprof.c",
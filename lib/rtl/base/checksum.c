@@ -0,0 +1,368 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    checksum.c
+
+Abstract:
+
+    This module implements the Internet checksum (RFC 1071), the 16-bit one's
+    complement sum used by IP, TCP, and UDP.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Any
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "rtlp.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+ULONG
+RtlpFoldInternetChecksum64 (
+    ULONGLONG Sum
+    );
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+RTL_API
+ULONG
+RtlComputeInternetChecksum (
+    ULONG InitialSum,
+    PCVOID Buffer,
+    ULONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds the given buffer into a running Internet checksum. The
+    sum is computed in memory byte order, so the folded result can be stored
+    straight into a packet header.
+
+Arguments:
+
+    InitialSum - Supplies the running sum to add to. Supply 0 initially.
+
+    Buffer - Supplies a pointer to the data to add.
+
+    Size - Supplies the size of the buffer, in bytes. This must be even unless
+        this is the last piece of data being summed.
+
+Return Value:
+
+    Returns the new running sum. Use RtlFoldInternetChecksum to turn this into
+    the final checksum.
+
+--*/
+
+{
+
+    PUCHAR Bytes;
+    USHORT Last;
+    ULONGLONG Sum;
+    PULONG Words;
+
+    Bytes = (PUCHAR)Buffer;
+    Sum = InitialSum;
+
+    //
+    // Word loads need 16-bit alignment to keep each byte in its lane. Odd
+    // buffers are rare, so just put them together a byte at a time.
+    //
+
+    if (((UINTN)Bytes & 0x1) != 0) {
+        while (Size >= sizeof(USHORT)) {
+            ((PUCHAR)&Last)[0] = Bytes[0];
+            ((PUCHAR)&Last)[1] = Bytes[1];
+            Sum += Last;
+            Bytes += sizeof(USHORT);
+            Size -= sizeof(USHORT);
+        }
+
+    } else {
+        if ((Size >= sizeof(USHORT)) && (((UINTN)Bytes & 0x2) != 0)) {
+            Sum += *((PUSHORT)Bytes);
+            Bytes += sizeof(USHORT);
+            Size -= sizeof(USHORT);
+        }
+
+        //
+        // Add 32-bit words into a 64-bit accumulator, which lets the carries
+        // pile up in the high half instead of being checked on every add.
+        //
+
+        Words = (PULONG)Bytes;
+        while (Size >= (sizeof(ULONG) * 8)) {
+            Sum += Words[0];
+            Sum += Words[1];
+            Sum += Words[2];
+            Sum += Words[3];
+            Sum += Words[4];
+            Sum += Words[5];
+            Sum += Words[6];
+            Sum += Words[7];
+            Words += 8;
+            Size -= sizeof(ULONG) * 8;
+        }
+
+        while (Size >= sizeof(ULONG)) {
+            Sum += *Words;
+            Words += 1;
+            Size -= sizeof(ULONG);
+        }
+
+        Bytes = (PUCHAR)Words;
+        if (Size >= sizeof(USHORT)) {
+            Sum += *((PUSHORT)Bytes);
+            Bytes += sizeof(USHORT);
+            Size -= sizeof(USHORT);
+        }
+    }
+
+    //
+    // A trailing odd byte is padded with a zero after it.
+    //
+
+    if (Size != 0) {
+        Last = 0;
+        *((PUCHAR)&Last) = *Bytes;
+        Sum += Last;
+    }
+
+    return RtlpFoldInternetChecksum64(Sum);
+}
+
+RTL_API
+ULONG
+RtlCopyAndComputeInternetChecksum (
+    ULONG InitialSum,
+    PVOID Destination,
+    PCVOID Source,
+    ULONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies a buffer and adds it into a running Internet checksum
+    in the same pass over the data.
+
+Arguments:
+
+    InitialSum - Supplies the running sum to add to. Supply 0 initially.
+
+    Destination - Supplies a pointer where the data will be copied to.
+
+    Source - Supplies a pointer to the data to copy and add. The buffers must
+        not overlap.
+
+    Size - Supplies the number of bytes to copy. This must be even unless
+        this is the last piece of data being summed.
+
+Return Value:
+
+    Returns the new running sum. Use RtlFoldInternetChecksum to turn this into
+    the final checksum.
+
+--*/
+
+{
+
+    PUCHAR DestinationBytes;
+    PULONG DestinationWords;
+    USHORT Last;
+    PUCHAR SourceBytes;
+    PULONG SourceWords;
+    ULONGLONG Sum;
+    ULONG Word0;
+    ULONG Word1;
+    ULONG Word2;
+    ULONG Word3;
+
+    //
+    // Odd buffers go the long way around.
+    //
+
+    if ((((UINTN)Destination | (UINTN)Source) & 0x1) != 0) {
+        RtlCopyMemory(Destination, Source, Size);
+        return RtlComputeInternetChecksum(InitialSum, Destination, Size);
+    }
+
+    DestinationBytes = Destination;
+    SourceBytes = (PUCHAR)Source;
+    Sum = InitialSum;
+
+    //
+    // If the two buffers can never both be 32-bit aligned, copy 16 bits at a
+    // time.
+    //
+
+    if ((((UINTN)Destination ^ (UINTN)Source) & 0x2) != 0) {
+        while (Size >= sizeof(USHORT)) {
+            Last = *((PUSHORT)SourceBytes);
+            *((PUSHORT)DestinationBytes) = Last;
+            Sum += Last;
+            DestinationBytes += sizeof(USHORT);
+            SourceBytes += sizeof(USHORT);
+            Size -= sizeof(USHORT);
+        }
+
+    } else {
+        if ((Size >= sizeof(USHORT)) && (((UINTN)SourceBytes & 0x2) != 0)) {
+            Last = *((PUSHORT)SourceBytes);
+            *((PUSHORT)DestinationBytes) = Last;
+            Sum += Last;
+            DestinationBytes += sizeof(USHORT);
+            SourceBytes += sizeof(USHORT);
+            Size -= sizeof(USHORT);
+        }
+
+        DestinationWords = (PULONG)DestinationBytes;
+        SourceWords = (PULONG)SourceBytes;
+        while (Size >= (sizeof(ULONG) * 4)) {
+            Word0 = SourceWords[0];
+            Word1 = SourceWords[1];
+            Word2 = SourceWords[2];
+            Word3 = SourceWords[3];
+            DestinationWords[0] = Word0;
+            DestinationWords[1] = Word1;
+            DestinationWords[2] = Word2;
+            DestinationWords[3] = Word3;
+            Sum += Word0;
+            Sum += Word1;
+            Sum += Word2;
+            Sum += Word3;
+            DestinationWords += 4;
+            SourceWords += 4;
+            Size -= sizeof(ULONG) * 4;
+        }
+
+        while (Size >= sizeof(ULONG)) {
+            Word0 = *SourceWords;
+            *DestinationWords = Word0;
+            Sum += Word0;
+            DestinationWords += 1;
+            SourceWords += 1;
+            Size -= sizeof(ULONG);
+        }
+
+        DestinationBytes = (PUCHAR)DestinationWords;
+        SourceBytes = (PUCHAR)SourceWords;
+        if (Size >= sizeof(USHORT)) {
+            Last = *((PUSHORT)SourceBytes);
+            *((PUSHORT)DestinationBytes) = Last;
+            Sum += Last;
+            DestinationBytes += sizeof(USHORT);
+            SourceBytes += sizeof(USHORT);
+            Size -= sizeof(USHORT);
+        }
+    }
+
+    if (Size != 0) {
+        *DestinationBytes = *SourceBytes;
+        Last = 0;
+        *((PUCHAR)&Last) = *SourceBytes;
+        Sum += Last;
+    }
+
+    return RtlpFoldInternetChecksum64(Sum);
+}
+
+RTL_API
+USHORT
+RtlFoldInternetChecksum (
+    ULONG Sum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine turns a running Internet checksum into the final 16-bit
+    checksum.
+
+Arguments:
+
+    Sum - Supplies the running sum.
+
+Return Value:
+
+    Returns the one's complement of the folded sum, in memory byte order. A
+    buffer that already contains a valid checksum comes out as zero.
+
+--*/
+
+{
+
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+    return (USHORT)~Sum;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+ULONG
+RtlpFoldInternetChecksum64 (
+    ULONGLONG Sum
+    )
+
+/*++
+
+Routine Description:
+
+    This routine folds a 64-bit one's complement accumulator down to 32 bits.
+
+Arguments:
+
+    Sum - Supplies the accumulator.
+
+Return Value:
+
+    Returns the equivalent 32-bit running sum.
+
+--*/
+
+{
+
+    Sum = (Sum & MAX_ULONG) + (Sum >> 32);
+    Sum = (Sum & MAX_ULONG) + (Sum >> 32);
+    return (ULONG)Sum;
+}
+
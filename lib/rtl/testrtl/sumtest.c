@@ -0,0 +1,358 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    sumtest.c
+
+Abstract:
+
+    This module tests the Internet checksum routines in the runtime library
+    against a straightforward byte at a time implementation.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Test
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#define RTL_API
+
+#include <minoca/lib/types.h>
+#include <minoca/lib/status.h>
+#include <minoca/lib/rtl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define CHECKSUM_TEST_ITERATIONS 5000
+#define CHECKSUM_TEST_MAX_SIZE 2100
+#define CHECKSUM_TEST_MAX_OFFSET 8
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+USHORT
+TestComputeReferenceChecksum (
+    PUCHAR Buffer,
+    ULONG Size
+    );
+
+BOOL
+TestCompareChecksum (
+    USHORT Checksum,
+    USHORT Reference
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+UCHAR TestChecksumSource[CHECKSUM_TEST_MAX_SIZE + CHECKSUM_TEST_MAX_OFFSET];
+UCHAR TestChecksumDestination[CHECKSUM_TEST_MAX_SIZE +
+                              CHECKSUM_TEST_MAX_OFFSET];
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+ULONG
+TestInternetChecksum (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine tests the Internet checksum functions in the runtime library.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the number of test failures.
+
+--*/
+
+{
+
+    USHORT Checksum;
+    ULONG DestinationOffset;
+    ULONG Failures;
+    ULONG Index;
+    ULONG Iteration;
+    USHORT Reference;
+    ULONG Size;
+    PUCHAR Source;
+    ULONG SourceOffset;
+    ULONG Split;
+    ULONG Sum;
+
+    Failures = 0;
+    for (Iteration = 0; Iteration < CHECKSUM_TEST_ITERATIONS; Iteration += 1) {
+        for (Index = 0; Index < sizeof(TestChecksumSource); Index += 1) {
+            TestChecksumSource[Index] = (UCHAR)rand();
+        }
+
+        //
+        // Lean on buffers full of 0xFF now and then, which generate the most
+        // carries.
+        //
+
+        if ((Iteration % 7) == 0) {
+            memset(TestChecksumSource, 0xFF, sizeof(TestChecksumSource));
+        }
+
+        Size = rand() % CHECKSUM_TEST_MAX_SIZE;
+        SourceOffset = rand() % CHECKSUM_TEST_MAX_OFFSET;
+        DestinationOffset = rand() % CHECKSUM_TEST_MAX_OFFSET;
+        Source = TestChecksumSource + SourceOffset;
+        Reference = TestComputeReferenceChecksum(Source, Size);
+
+        //
+        // Check the plain checksum.
+        //
+
+        Sum = RtlComputeInternetChecksum(0, Source, Size);
+        Checksum = RtlFoldInternetChecksum(Sum);
+        if (TestCompareChecksum(Checksum, Reference) == FALSE) {
+            printf("Checksum of %d bytes at offset %d was 0x%04x, expected "
+                   "0x%04x.\n",
+                   Size,
+                   SourceOffset,
+                   Checksum,
+                   Reference);
+
+            Failures += 1;
+        }
+
+        //
+        // Check the sum done in two pieces, split on an even boundary.
+        //
+
+        Split = (rand() % (Size + 1)) & ~0x1;
+        Sum = RtlComputeInternetChecksum(0, Source, Split);
+        Sum = RtlComputeInternetChecksum(Sum, Source + Split, Size - Split);
+        Checksum = RtlFoldInternetChecksum(Sum);
+        if (TestCompareChecksum(Checksum, Reference) == FALSE) {
+            printf("Checksum of %d bytes split at %d was 0x%04x, expected "
+                   "0x%04x.\n",
+                   Size,
+                   Split,
+                   Checksum,
+                   Reference);
+
+            Failures += 1;
+        }
+
+        //
+        // Check the copying version, including that the copy came out right.
+        //
+
+        memset(TestChecksumDestination, 0, sizeof(TestChecksumDestination));
+        Sum = RtlCopyAndComputeInternetChecksum(
+                                 0,
+                                 TestChecksumDestination + DestinationOffset,
+                                 Source,
+                                 Size);
+
+        Checksum = RtlFoldInternetChecksum(Sum);
+        if (TestCompareChecksum(Checksum, Reference) == FALSE) {
+            printf("Copy checksum of %d bytes from offset %d to %d was "
+                   "0x%04x, expected 0x%04x.\n",
+                   Size,
+                   SourceOffset,
+                   DestinationOffset,
+                   Checksum,
+                   Reference);
+
+            Failures += 1;
+        }
+
+        if (memcmp(TestChecksumDestination + DestinationOffset,
+                   Source,
+                   Size) != 0) {
+
+            printf("Copy checksum of %d bytes from offset %d to %d did not "
+                   "copy correctly.\n",
+                   Size,
+                   SourceOffset,
+                   DestinationOffset);
+
+            Failures += 1;
+        }
+
+        for (Index = 0; Index < DestinationOffset; Index += 1) {
+            if (TestChecksumDestination[Index] != 0) {
+                printf("Copy checksum wrote before the destination.\n");
+                Failures += 1;
+                break;
+            }
+        }
+
+        Index = DestinationOffset + Size;
+        while (Index < sizeof(TestChecksumDestination)) {
+            if (TestChecksumDestination[Index] != 0) {
+                printf("Copy checksum of %d bytes wrote past the "
+                       "destination.\n",
+                       Size);
+
+                Failures += 1;
+                break;
+            }
+
+            Index += 1;
+        }
+
+        //
+        // A buffer with its checksum stored in it should sum to zero.
+        //
+
+        if ((Size >= sizeof(USHORT)) && ((Size & 0x1) == 0)) {
+            Source[0] = 0;
+            Source[1] = 0;
+            Sum = RtlComputeInternetChecksum(0, Source, Size);
+            Checksum = RtlFoldInternetChecksum(Sum);
+            memcpy(Source, &Checksum, sizeof(USHORT));
+            Sum = RtlComputeInternetChecksum(0, Source, Size);
+            if (RtlFoldInternetChecksum(Sum) != 0) {
+                printf("Checksum of %d bytes with its checksum stored did "
+                       "not verify.\n",
+                       Size);
+
+                Failures += 1;
+            }
+        }
+    }
+
+    if (Failures != 0) {
+        printf("%d Internet checksum failures.\n", Failures);
+    }
+
+    return Failures;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+USHORT
+TestComputeReferenceChecksum (
+    PUCHAR Buffer,
+    ULONG Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes the Internet checksum of a buffer the slow way, as
+    a sequence of big endian 16-bit words.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to checksum.
+
+    Size - Supplies the size of the buffer in bytes.
+
+Return Value:
+
+    Returns the checksum as a big endian value.
+
+--*/
+
+{
+
+    ULONG Index;
+    ULONG Sum;
+
+    Sum = 0;
+    for (Index = 0; Index + 1 < Size; Index += 2) {
+        Sum += (Buffer[Index] << 8) | Buffer[Index + 1];
+        if (Sum > 0xFFFF) {
+            Sum -= 0xFFFF;
+        }
+    }
+
+    if ((Size & 0x1) != 0) {
+        Sum += Buffer[Size - 1] << 8;
+        if (Sum > 0xFFFF) {
+            Sum -= 0xFFFF;
+        }
+    }
+
+    return (USHORT)~Sum;
+}
+
+BOOL
+TestCompareChecksum (
+    USHORT Checksum,
+    USHORT Reference
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares a checksum stored in memory byte order against a
+    big endian reference value. Positive and negative zero are the same.
+
+Arguments:
+
+    Checksum - Supplies the checksum to check, in memory byte order.
+
+    Reference - Supplies the expected checksum as a big endian value.
+
+Return Value:
+
+    TRUE if the checksums match.
+
+    FALSE if they differ.
+
+--*/
+
+{
+
+    PUCHAR Bytes;
+    USHORT Value;
+
+    Bytes = (PUCHAR)&Checksum;
+    Value = (Bytes[0] << 8) | Bytes[1];
+    if (Value == 0xFFFF) {
+        Value = 0;
+    }
+
+    if (Reference == 0xFFFF) {
+        Reference = 0;
+    }
+
+    return Value == Reference;
+}
+
@@ -428,6 +428,11 @@ TestTime (
     VOID
     );
 
+ULONG
+TestInternetChecksum (
+    VOID
+    );
+
 ULONG
 TestRedBlackTrees (
     BOOL Quiet
@@ -593,6 +598,7 @@ Return Value:
     TestsFailed += TestSoftFloat();
     TestsFailed += TestTime();
     TestsFailed += TestHeaps(TRUE);
+    TestsFailed += TestInternetChecksum();
 
     //
     // Test basic unsigned division.
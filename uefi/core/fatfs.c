@@ -1459,6 +1459,7 @@ Return Value:
                                EFI_FAT_DIRECTORY_ENTRY_SIZE,
                                TRUE,
                                TRUE,
+                               0,
                                NULL,
                                &BytesComplete,
                                &ElementsRead);